@@ -30,5 +30,6 @@ set -e
 ./lexilla/bootstrap.sh
 ./nlohmann/bootstrap.sh
 ./unordered_dense/bootstrap.sh
+./xxhash/bootstrap.sh
 ./Catch2/bootstrap.sh
 ./rapidjson/bootstrap.sh
@@ -0,0 +1,21 @@
+#!/bin/sh
+set -o pipefail
+set -o xtrace
+set -e
+
+CUR_DIR=$( cd "$( dirname "${BASH_SOURCE[0]}" )" >/dev/null 2>&1 && pwd )
+TMP_DIR=${CUR_DIR}/xxhash.tmp
+
+mkdir ${TMP_DIR}
+cd ${TMP_DIR} 
+
+git clone -b v0.8.2 --single-branch https://github.com/Cyan4973/xxHash.git
+
+cd ..
+
+rm -rf ./include/
+
+mkdir include
+cp ${TMP_DIR}/xxHash/xxhash.h ./include/
+
+rm -rf ${TMP_DIR}
@@ -1,4 +1,4 @@
-// Copyright (C) 2014-2019 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <vector>
@@ -21,6 +21,8 @@ public:
         SHA2_256,
         SHA2_384,
         SHA2_512,
+        XXH3_128, // non-cryptographic, very fast, suitable for integrity checks
+        BLAKE3,   // cryptographic, 256-bit output
     };
 
     Hash(Mode _mode);
@@ -32,7 +34,7 @@ public:
 
 private:
     Mode m_Mode;
-    uint8_t m_Stuff[1024];
+    alignas(64) uint8_t m_Stuff[2048];
 };
 
 } // namespace nc::base
@@ -1,10 +1,12 @@
-// Copyright (C) 2018-2019 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2018-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <utility>
 #include <unordered_map>
 #include <list>
 #include <assert.h>
+#include <cstddef>
+#include <stdexcept>
 
 namespace nc::base {
 
@@ -47,6 +49,26 @@ public:
      */
     _Value &operator[](const _Key &_key);
 
+    /**
+     * Checks whether there is a value corresponding to _key. If there is - makes it the most
+     * recent and returns a pointer to the value. Otherwise, returns nullptr.
+     * O(1).
+     */
+    _Value *find(const _Key &_key);
+
+    /**
+     * Removes a value associated with _key, if any. Returns the number of removed values.
+     * O(1).
+     */
+    size_t erase(const _Key &_key);
+
+    /**
+     * Removes all values for which _pred(key, value) returns true. Returns the number of removed values.
+     * O(N).
+     */
+    template <class _Pred>
+    size_t erase_if(_Pred _pred);
+
     LRUCache &operator=(const LRUCache &);
     LRUCache &operator=(LRUCache &&);
 
@@ -148,6 +170,44 @@ _Value &LRUCache<_Key, _Value, _Capacity, _Hash>::operator[](const _Key &_key)
     return m_LRU.front().second;
 }
 
+template <class _Key, class _Value, size_t _Capacity, class _Hash>
+_Value *LRUCache<_Key, _Value, _Capacity, _Hash>::find(const _Key &_key)
+{
+    const auto it = m_Map.find(_key);
+    if( it == std::end(m_Map) )
+        return nullptr;
+    make_front(it->second);
+    return &it->second->second;
+}
+
+template <class _Key, class _Value, size_t _Capacity, class _Hash>
+size_t LRUCache<_Key, _Value, _Capacity, _Hash>::erase(const _Key &_key)
+{
+    const auto it = m_Map.find(_key);
+    if( it == std::end(m_Map) )
+        return 0;
+    m_LRU.erase(it->second);
+    m_Map.erase(it);
+    return 1;
+}
+
+template <class _Key, class _Value, size_t _Capacity, class _Hash>
+template <class _Pred>
+size_t LRUCache<_Key, _Value, _Capacity, _Hash>::erase_if(_Pred _pred)
+{
+    size_t erased = 0;
+    for( auto it = std::begin(m_LRU); it != std::end(m_LRU); ) {
+        if( _pred(std::as_const(it->first), std::as_const(it->second)) ) {
+            m_Map.erase(it->first);
+            it = m_LRU.erase(it);
+            ++erased;
+        }
+        else
+            ++it;
+    }
+    return erased;
+}
+
 template <class _Key, class _Value, size_t _Capacity, class _Hash>
 LRUCache<_Key, _Value, _Capacity, _Hash> &LRUCache<_Key, _Value, _Capacity, _Hash>::operator=(const LRUCache &_rhs)
 {
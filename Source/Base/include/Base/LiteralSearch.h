@@ -0,0 +1,108 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nc::base {
+
+// Finds the leftmost occurrence of any of several needles in a buffer of raw bytes.
+// A needle is a sequence of characters and each character can be matched by any of its forms, e.g. by the lowercase
+// and the uppercase representations of a letter in some encoding. The forms of a character may differ in length.
+// Candidate positions are located by checking 16 bytes at once against the possible first bytes of the needles and,
+// for a single needle of a fixed length, against its possible last bytes as well. Then each candidate is verified.
+// The search doesn't allocate and can be performed concurrently from several threads.
+class LiteralSearch
+{
+public:
+    using Char = std::vector<std::string>; // the forms of a character, each is a non-empty sequence of bytes
+    using Needle = std::vector<Char>;
+
+    struct Match {
+        size_t offset = 0;
+        size_t length = 0;
+        size_t needle = 0; // index of the needle in the order they were provided
+    };
+
+    // Throws std::invalid_argument on empty needles or characters without forms.
+    // Having no needles at all is fine, such a search never finds anything.
+    explicit LiteralSearch(std::span<const Needle> _needles);
+
+    // A needle which is matched only by exactly these bytes.
+    static Needle Exact(std::string_view _bytes);
+
+    // Returns the match which starts at the lowest offset not less than _from.
+    // If several needles match at that offset, the one provided first is reported.
+    std::optional<Match> Find(std::span<const std::byte> _haystack, size_t _from = 0) const noexcept;
+
+    // The maximum amount of bytes a match can span.
+    size_t MaxLength() const noexcept;
+
+    size_t NeedlesCount() const noexcept;
+
+private:
+    static constexpr size_t MaxProbeBytes = 8;
+
+    struct Segment {
+        enum class Kind : uint8_t {
+            Literal, // 'count' bytes at m_Bytes['first']
+            Classes, // 'count' bytes, each matched by its set at m_Classes['first' + i]
+            Forms    // any of 'count' forms at m_Forms['first']
+        };
+        Kind kind = Kind::Literal;
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    struct Form {
+        uint32_t offset = 0; // in m_Bytes
+        uint32_t length = 0;
+    };
+
+    struct CompiledNeedle {
+        uint32_t first_segment = 0;
+        uint32_t segments_count = 0;
+        size_t min_length = 0;
+        size_t max_length = 0;
+        std::bitset<256> first_bytes;
+        std::bitset<256> last_bytes; // meaningful only when min_length == max_length
+    };
+
+    // A set of bytes which one of the candidate's bytes must belong to.
+    struct Probe {
+        size_t offset = 0; // from the candidate position
+        size_t count = 0;  // zero if there are too many bytes to check them at once
+        std::array<uint8_t, MaxProbeBytes> bytes = {};
+    };
+
+    void Compile(const Needle &_needle);
+    void AddLiteral(CompiledNeedle &_needle, std::string_view _bytes);
+    void AddClass(CompiledNeedle &_needle, const std::bitset<256> &_class);
+    void SetupProbes();
+    static Probe MakeProbe(const std::bitset<256> &_bytes, size_t _offset) noexcept;
+
+    std::optional<Match> MatchAt(const uint8_t *_data, size_t _size, size_t _pos) const noexcept;
+    const uint8_t *MatchSegments(const Segment *_segment,
+                                 const Segment *_segments_end,
+                                 const uint8_t *_pos,
+                                 const uint8_t *_end) const noexcept;
+
+    std::vector<CompiledNeedle> m_Needles;
+    std::vector<Segment> m_Segments;
+    std::vector<Form> m_Forms;
+    std::vector<std::bitset<256>> m_Classes;
+    std::string m_Bytes;
+    std::bitset<256> m_FirstBytes;
+    Probe m_FirstProbe;
+    Probe m_LastProbe; // used only if 'count' is non-zero
+    size_t m_MaxLength = 0;
+};
+
+} // namespace nc::base
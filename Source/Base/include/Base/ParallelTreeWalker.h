@@ -0,0 +1,205 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include "DispatchGroup.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace nc::base {
+
+// Walks directory trees with a bounded amount of workers.
+// Each worker keeps its own deque of pending directories: it takes the most recently discovered directory from the
+// back of its deque and, once it runs out of work, steals the oldest one from the front of another worker's deque.
+// The walker doesn't impose any order on the visits - a visitor is expected to store the listings in a tree which is
+// traversed afterwards in a deterministic order.
+// With a single worker everything is visited on the calling thread.
+template <class Directory>
+class ParallelTreeWalker
+{
+public:
+    // Reads _directory and appends the subdirectories to descend into to _subdirectories.
+    // Called concurrently from the workers.
+    using Visitor = std::function<void(Directory _directory, std::vector<Directory> &_subdirectories)>;
+
+    // Returns true if the walk should be abandoned. Called concurrently from the workers.
+    using CancelChecker = std::function<bool()>;
+
+    ParallelTreeWalker(int _max_workers, Visitor _visitor, CancelChecker _cancel_checker = nullptr);
+
+    // Visits the roots and everything below them.
+    // Returns once all the directories were visited or the walk was cancelled.
+    void Walk(std::vector<Directory> _roots);
+
+    // A reasonable amount of workers for local volumes.
+    static int DefaultConcurrency() noexcept;
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<Directory> pending;
+    };
+
+    void Work(size_t _worker_index);
+    bool Pop(size_t _worker_index, Directory &_directory);
+    void Push(size_t _worker_index, std::vector<Directory> &_directories);
+
+    const int m_MaxWorkers;
+    Visitor m_Visitor;
+    CancelChecker m_CancelChecker;
+    std::vector<std::unique_ptr<Worker>> m_Workers;
+
+    std::mutex m_StateLock;
+    std::condition_variable m_StateCV;
+    size_t m_Outstanding = 0; // directories discovered, but not yet visited
+    size_t m_Available = 0;   // directories sitting in the deques
+    bool m_Cancelled = false;
+};
+
+template <class Directory>
+ParallelTreeWalker<Directory>::ParallelTreeWalker(int _max_workers, Visitor _visitor, CancelChecker _cancel_checker)
+    : m_MaxWorkers(std::max(_max_workers, 1)), m_Visitor(std::move(_visitor)),
+      m_CancelChecker(std::move(_cancel_checker))
+{
+    if( !m_Visitor )
+        throw std::invalid_argument("ParallelTreeWalker: the visitor can't be empty");
+    for( int i = 0; i < m_MaxWorkers; ++i )
+        m_Workers.emplace_back(std::make_unique<Worker>());
+}
+
+template <class Directory>
+int ParallelTreeWalker<Directory>::DefaultConcurrency() noexcept
+{
+    return std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 8);
+}
+
+template <class Directory>
+void ParallelTreeWalker<Directory>::Walk(std::vector<Directory> _roots)
+{
+    if( _roots.empty() )
+        return;
+
+    {
+        const auto lock = std::lock_guard{m_StateLock};
+        m_Outstanding = 0;
+        m_Available = 0;
+        m_Cancelled = false;
+    }
+    for( auto &worker : m_Workers )
+        worker->pending.clear();
+
+    // spread the roots so that every worker has something to start with
+    for( size_t i = 0; i < _roots.size(); ++i ) {
+        std::vector<Directory> root{std::move(_roots[i])};
+        Push(i % m_Workers.size(), root);
+    }
+
+    if( m_Workers.size() == 1 ) {
+        Work(0);
+        return;
+    }
+
+    const base::DispatchGroup group;
+    for( size_t i = 0; i < m_Workers.size(); ++i )
+        group.Run([this, i] { Work(i); });
+    group.Wait();
+}
+
+template <class Directory>
+void ParallelTreeWalker<Directory>::Work(size_t _worker_index)
+{
+    std::vector<Directory> subdirectories;
+    while( true ) {
+        Directory directory{};
+        if( !Pop(_worker_index, directory) ) {
+            // nothing to do at the moment - wait until somebody discovers more or the walk is over
+            auto lock = std::unique_lock{m_StateLock};
+            m_StateCV.wait(lock, [this] { return m_Outstanding == 0 || m_Cancelled || m_Available != 0; });
+            if( m_Outstanding == 0 || m_Cancelled )
+                return;
+            continue;
+        }
+
+        if( m_CancelChecker && m_CancelChecker() ) {
+            {
+                const auto lock = std::lock_guard{m_StateLock};
+                m_Cancelled = true;
+            }
+            m_StateCV.notify_all();
+            return;
+        }
+
+        subdirectories.clear();
+        m_Visitor(std::move(directory), subdirectories);
+        Push(_worker_index, subdirectories);
+
+        bool finished = false;
+        {
+            const auto lock = std::lock_guard{m_StateLock};
+            finished = --m_Outstanding == 0;
+        }
+        if( finished )
+            m_StateCV.notify_all();
+    }
+}
+
+template <class Directory>
+bool ParallelTreeWalker<Directory>::Pop(size_t _worker_index, Directory &_directory)
+{
+    bool found = false;
+    {
+        auto &own = *m_Workers[_worker_index];
+        const auto lock = std::lock_guard{own.lock};
+        if( !own.pending.empty() ) {
+            _directory = std::move(own.pending.back());
+            own.pending.pop_back();
+            found = true;
+        }
+    }
+    for( size_t i = 1; !found && i < m_Workers.size(); ++i ) {
+        auto &victim = *m_Workers[(_worker_index + i) % m_Workers.size()];
+        const auto lock = std::lock_guard{victim.lock};
+        if( !victim.pending.empty() ) {
+            _directory = std::move(victim.pending.front());
+            victim.pending.pop_front();
+            found = true;
+        }
+    }
+    if( found ) {
+        const auto lock = std::lock_guard{m_StateLock};
+        --m_Available;
+    }
+    return found;
+}
+
+template <class Directory>
+void ParallelTreeWalker<Directory>::Push(size_t _worker_index, std::vector<Directory> &_directories)
+{
+    if( _directories.empty() )
+        return;
+    {
+        // account first, so that the counters never drop below the actual amount of pending directories
+        const auto lock = std::lock_guard{m_StateLock};
+        m_Outstanding += _directories.size();
+        m_Available += _directories.size();
+    }
+    {
+        auto &own = *m_Workers[_worker_index];
+        const auto lock = std::lock_guard{own.lock};
+        // reversed, so that the first subdirectory is the next one to be taken from the back
+        std::ranges::move(_directories.rbegin(), _directories.rend(), std::back_inserter(own.pending));
+    }
+    if( _directories.size() == 1 )
+        m_StateCV.notify_one();
+    else
+        m_StateCV.notify_all();
+}
+
+} // namespace nc::base
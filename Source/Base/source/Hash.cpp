@@ -1,11 +1,260 @@
-// Copyright (C) 2014-2021 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include <Base/Hash.h>
 #include <CommonCrypto/CommonDigest.h>
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstring>
 #include <zlib.h>
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 namespace nc::base {
 
+namespace {
+
+// A compact portable implementation of BLAKE3 hashing (default mode, 256-bit output).
+// https://github.com/BLAKE3-team/BLAKE3-specs
+struct Blake3 {
+    static constexpr size_t block_len = 64;
+    static constexpr size_t chunk_len = 1024;
+    static constexpr size_t out_len = 32;
+    static constexpr size_t max_depth = 54;
+
+    void Init() noexcept;
+    void Update(const uint8_t *_data, size_t _size) noexcept;
+    void Finalize(uint8_t *_out) const noexcept;
+
+private:
+    static constexpr uint32_t ChunkStart = 1 << 0;
+    static constexpr uint32_t ChunkEnd = 1 << 1;
+    static constexpr uint32_t Parent = 1 << 2;
+    static constexpr uint32_t Root = 1 << 3;
+
+    struct Output {
+        uint32_t input_cv[8];
+        uint32_t block_words[16];
+        uint64_t counter;
+        uint32_t block_len;
+        uint32_t flags;
+        void ChainingValue(uint32_t _cv[8]) const noexcept;
+        void RootBytes(uint8_t _out[out_len]) const noexcept;
+    };
+
+    static void Compress(const uint32_t _cv[8],
+                         const uint32_t _block[16],
+                         uint64_t _counter,
+                         uint32_t _block_len,
+                         uint32_t _flags,
+                         uint32_t _out[16]) noexcept;
+    static void LoadWords(const uint8_t *_bytes, uint32_t _words[16]) noexcept;
+    static Output ParentOutput(const uint32_t _left[8], const uint32_t _right[8]) noexcept;
+
+    size_t ChunkLength() const noexcept;
+    Output ChunkOutput() const noexcept;
+    void ResetChunk(uint64_t _counter) noexcept;
+    void PushChainingValue(const uint32_t _cv[8], uint64_t _total_chunks) noexcept;
+
+    static constexpr uint32_t g_IV[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+    uint32_t m_CVStack[max_depth][8];
+    uint32_t m_ChunkCV[8];
+    uint64_t m_ChunkCounter;
+    uint8_t m_Block[block_len];
+    uint8_t m_BlockLen;
+    uint8_t m_BlocksCompressed;
+    uint8_t m_CVStackLen;
+};
+
+static inline void Blake3G(uint32_t _s[16], int _a, int _b, int _c, int _d, uint32_t _x, uint32_t _y) noexcept
+{
+    _s[_a] = _s[_a] + _s[_b] + _x;
+    _s[_d] = std::rotr(_s[_d] ^ _s[_a], 16);
+    _s[_c] = _s[_c] + _s[_d];
+    _s[_b] = std::rotr(_s[_b] ^ _s[_c], 12);
+    _s[_a] = _s[_a] + _s[_b] + _y;
+    _s[_d] = std::rotr(_s[_d] ^ _s[_a], 8);
+    _s[_c] = _s[_c] + _s[_d];
+    _s[_b] = std::rotr(_s[_b] ^ _s[_c], 7);
+}
+
+void Blake3::Compress(const uint32_t _cv[8],
+                      const uint32_t _block[16],
+                      uint64_t _counter,
+                      uint32_t _block_len,
+                      uint32_t _flags,
+                      uint32_t _out[16]) noexcept
+{
+    static constexpr uint8_t permutation[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+    uint32_t s[16] = {_cv[0],
+                      _cv[1],
+                      _cv[2],
+                      _cv[3],
+                      _cv[4],
+                      _cv[5],
+                      _cv[6],
+                      _cv[7],
+                      g_IV[0],
+                      g_IV[1],
+                      g_IV[2],
+                      g_IV[3],
+                      static_cast<uint32_t>(_counter),
+                      static_cast<uint32_t>(_counter >> 32),
+                      _block_len,
+                      _flags};
+    uint32_t m[16];
+    std::memcpy(m, _block, sizeof(m));
+    for( int round = 0; round < 7; ++round ) {
+        Blake3G(s, 0, 4, 8, 12, m[0], m[1]);
+        Blake3G(s, 1, 5, 9, 13, m[2], m[3]);
+        Blake3G(s, 2, 6, 10, 14, m[4], m[5]);
+        Blake3G(s, 3, 7, 11, 15, m[6], m[7]);
+        Blake3G(s, 0, 5, 10, 15, m[8], m[9]);
+        Blake3G(s, 1, 6, 11, 12, m[10], m[11]);
+        Blake3G(s, 2, 7, 8, 13, m[12], m[13]);
+        Blake3G(s, 3, 4, 9, 14, m[14], m[15]);
+        if( round != 6 ) {
+            uint32_t permuted[16];
+            for( int i = 0; i < 16; ++i )
+                permuted[i] = m[permutation[i]];
+            std::memcpy(m, permuted, sizeof(m));
+        }
+    }
+    for( int i = 0; i < 8; ++i ) {
+        _out[i] = s[i] ^ s[i + 8];
+        _out[i + 8] = s[i + 8] ^ _cv[i];
+    }
+}
+
+void Blake3::LoadWords(const uint8_t *_bytes, uint32_t _words[16]) noexcept
+{
+    for( int i = 0; i < 16; ++i )
+        _words[i] = static_cast<uint32_t>(_bytes[i * 4]) | (static_cast<uint32_t>(_bytes[i * 4 + 1]) << 8) |
+                    (static_cast<uint32_t>(_bytes[i * 4 + 2]) << 16) | (static_cast<uint32_t>(_bytes[i * 4 + 3]) << 24);
+}
+
+void Blake3::Output::ChainingValue(uint32_t _cv[8]) const noexcept
+{
+    uint32_t out[16];
+    Compress(input_cv, block_words, counter, block_len, flags, out);
+    std::memcpy(_cv, out, 8 * sizeof(uint32_t));
+}
+
+void Blake3::Output::RootBytes(uint8_t _out[out_len]) const noexcept
+{
+    uint32_t words[16];
+    Compress(input_cv, block_words, 0, block_len, flags | Root, words);
+    for( size_t i = 0; i < out_len / 4; ++i ) {
+        _out[i * 4 + 0] = static_cast<uint8_t>(words[i]);
+        _out[i * 4 + 1] = static_cast<uint8_t>(words[i] >> 8);
+        _out[i * 4 + 2] = static_cast<uint8_t>(words[i] >> 16);
+        _out[i * 4 + 3] = static_cast<uint8_t>(words[i] >> 24);
+    }
+}
+
+Blake3::Output Blake3::ParentOutput(const uint32_t _left[8], const uint32_t _right[8]) noexcept
+{
+    Output output;
+    std::memcpy(output.input_cv, g_IV, sizeof(g_IV));
+    std::memcpy(output.block_words, _left, 8 * sizeof(uint32_t));
+    std::memcpy(output.block_words + 8, _right, 8 * sizeof(uint32_t));
+    output.counter = 0;
+    output.block_len = block_len;
+    output.flags = Parent;
+    return output;
+}
+
+void Blake3::Init() noexcept
+{
+    m_CVStackLen = 0;
+    ResetChunk(0);
+}
+
+void Blake3::ResetChunk(uint64_t _counter) noexcept
+{
+    std::memcpy(m_ChunkCV, g_IV, sizeof(g_IV));
+    m_ChunkCounter = _counter;
+    m_BlockLen = 0;
+    m_BlocksCompressed = 0;
+}
+
+size_t Blake3::ChunkLength() const noexcept
+{
+    return block_len * m_BlocksCompressed + m_BlockLen;
+}
+
+Blake3::Output Blake3::ChunkOutput() const noexcept
+{
+    Output output;
+    std::memcpy(output.input_cv, m_ChunkCV, sizeof(m_ChunkCV));
+    uint8_t block[block_len] = {};
+    std::memcpy(block, m_Block, m_BlockLen);
+    LoadWords(block, output.block_words);
+    output.counter = m_ChunkCounter;
+    output.block_len = m_BlockLen;
+    output.flags = (m_BlocksCompressed == 0 ? ChunkStart : 0u) | ChunkEnd;
+    return output;
+}
+
+void Blake3::PushChainingValue(const uint32_t _cv[8], uint64_t _total_chunks) noexcept
+{
+    // Merge the completed subtrees, the number of trailing zero bits in the chunks count tells how many.
+    uint32_t cv[8];
+    std::memcpy(cv, _cv, sizeof(cv));
+    while( (_total_chunks & 1) == 0 ) {
+        --m_CVStackLen;
+        ParentOutput(m_CVStack[m_CVStackLen], cv).ChainingValue(cv);
+        _total_chunks >>= 1;
+    }
+    std::memcpy(m_CVStack[m_CVStackLen], cv, sizeof(cv));
+    ++m_CVStackLen;
+}
+
+void Blake3::Update(const uint8_t *_data, size_t _size) noexcept
+{
+    while( _size > 0 ) {
+        if( ChunkLength() == chunk_len ) {
+            uint32_t cv[8];
+            ChunkOutput().ChainingValue(cv);
+            const uint64_t total_chunks = m_ChunkCounter + 1;
+            PushChainingValue(cv, total_chunks);
+            ResetChunk(total_chunks);
+        }
+
+        if( m_BlockLen == block_len ) {
+            uint32_t words[16];
+            LoadWords(m_Block, words);
+            uint32_t out[16];
+            Compress(m_ChunkCV, words, m_ChunkCounter, block_len, m_BlocksCompressed == 0 ? ChunkStart : 0u, out);
+            std::memcpy(m_ChunkCV, out, sizeof(m_ChunkCV));
+            ++m_BlocksCompressed;
+            m_BlockLen = 0;
+        }
+
+        const size_t want = std::min(block_len - m_BlockLen, chunk_len - ChunkLength());
+        const size_t take = std::min(want, _size);
+        std::memcpy(m_Block + m_BlockLen, _data, take);
+        m_BlockLen = static_cast<uint8_t>(m_BlockLen + take);
+        _data += take;
+        _size -= take;
+    }
+}
+
+void Blake3::Finalize(uint8_t *_out) const noexcept
+{
+    Output output = ChunkOutput();
+    for( size_t remaining = m_CVStackLen; remaining > 0; --remaining ) {
+        uint32_t cv[8];
+        output.ChainingValue(cv);
+        output = ParentOutput(m_CVStack[remaining - 1], cv);
+    }
+    output.RootBytes(_out);
+}
+
+} // namespace
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 
@@ -42,6 +291,15 @@ Hash::Hash(Mode _mode) : m_Mode(_mode)
         case CRC32:
             *reinterpret_cast<uint32_t *>(m_Stuff) = static_cast<uint32_t>(crc32(0, nullptr, 0));
             break;
+        case XXH3_128:
+            static_assert(sizeof(XXH3_state_t) <= sizeof(m_Stuff) && alignof(XXH3_state_t) <= 64);
+            XXH3_INITSTATE(reinterpret_cast<XXH3_state_t *>(m_Stuff));
+            XXH3_128bits_reset(reinterpret_cast<XXH3_state_t *>(m_Stuff));
+            break;
+        case BLAKE3:
+            static_assert(sizeof(Blake3) <= sizeof(m_Stuff));
+            reinterpret_cast<Blake3 *>(m_Stuff)->Init();
+            break;
         default:
             assert(0);
     }
@@ -83,6 +341,12 @@ Hash &Hash::Feed(const void *_data, size_t _size)
             *reinterpret_cast<uint32_t *>(m_Stuff) = static_cast<uint32_t>(
                 crc32(*reinterpret_cast<uint32_t *>(m_Stuff), reinterpret_cast<const unsigned char *>(_data), usize));
             break;
+        case XXH3_128:
+            XXH3_128bits_update(reinterpret_cast<XXH3_state_t *>(m_Stuff), _data, _size);
+            break;
+        case BLAKE3:
+            reinterpret_cast<Blake3 *>(m_Stuff)->Update(static_cast<const uint8_t *>(_data), _size);
+            break;
         default:
             assert(0);
     }
@@ -135,6 +399,16 @@ std::vector<uint8_t> Hash::Final()
         case Adler32:
         case CRC32:
             return std::vector<uint8_t>{m_Stuff[3], m_Stuff[2], m_Stuff[1], m_Stuff[0]};
+        case XXH3_128: {
+            XXH128_canonical_t canonical;
+            XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(reinterpret_cast<XXH3_state_t *>(m_Stuff)));
+            return std::vector<uint8_t>(std::begin(canonical.digest), std::end(canonical.digest));
+        }
+        case BLAKE3: {
+            std::vector<uint8_t> r(Blake3::out_len);
+            reinterpret_cast<Blake3 *>(m_Stuff)->Finalize(r.data());
+            return r;
+        }
         default:
             assert(0);
     }
@@ -0,0 +1,374 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include <Base/LiteralSearch.h>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace nc::base {
+
+#if defined(__SSE2__) || defined(__ARM_NEON)
+#define NC_LITERAL_SEARCH_VECTORIZED 1
+
+namespace {
+
+constexpr size_t g_BlockSize = 16;
+
+#if defined(__SSE2__)
+
+using Block = __m128i;
+
+// Each lane of a block is represented by this amount of bits in a mask.
+constexpr int g_BitsPerLane = 1;
+
+inline Block Load(const uint8_t *_p) noexcept
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(_p));
+}
+
+inline Block Splat(uint8_t _byte) noexcept
+{
+    return _mm_set1_epi8(static_cast<char>(_byte));
+}
+
+inline Block Equal(Block _lhs, Block _rhs) noexcept
+{
+    return _mm_cmpeq_epi8(_lhs, _rhs);
+}
+
+inline Block Or(Block _lhs, Block _rhs) noexcept
+{
+    return _mm_or_si128(_lhs, _rhs);
+}
+
+inline Block And(Block _lhs, Block _rhs) noexcept
+{
+    return _mm_and_si128(_lhs, _rhs);
+}
+
+inline uint64_t ToMask(Block _block) noexcept
+{
+    return static_cast<uint32_t>(_mm_movemask_epi8(_block));
+}
+
+#else
+
+using Block = uint8x16_t;
+
+constexpr int g_BitsPerLane = 4;
+
+inline Block Load(const uint8_t *_p) noexcept
+{
+    return vld1q_u8(_p);
+}
+
+inline Block Splat(uint8_t _byte) noexcept
+{
+    return vdupq_n_u8(_byte);
+}
+
+inline Block Equal(Block _lhs, Block _rhs) noexcept
+{
+    return vceqq_u8(_lhs, _rhs);
+}
+
+inline Block Or(Block _lhs, Block _rhs) noexcept
+{
+    return vorrq_u8(_lhs, _rhs);
+}
+
+inline Block And(Block _lhs, Block _rhs) noexcept
+{
+    return vandq_u8(_lhs, _rhs);
+}
+
+inline uint64_t ToMask(Block _block) noexcept
+{
+    // NEON has no movemask, narrowing leaves 4 bits per lane, only one of them is kept
+    const uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(_block), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+}
+
+#endif
+
+constexpr size_t g_MaxSplats = 8;
+
+struct Splats {
+    Block bytes[g_MaxSplats];
+    size_t count = 0;
+};
+
+template <size_t N>
+Splats MakeSplats(const std::array<uint8_t, N> &_bytes, size_t _count) noexcept
+{
+    static_assert(N <= g_MaxSplats);
+    Splats splats;
+    for( size_t i = 0; i < _count; ++i )
+        splats.bytes[i] = Splat(_bytes[i]);
+    splats.count = _count;
+    return splats;
+}
+
+inline Block AnyOf(Block _block, const Splats &_splats) noexcept
+{
+    Block result = Equal(_block, _splats.bytes[0]);
+    for( size_t i = 1; i < _splats.count; ++i )
+        result = Or(result, Equal(_block, _splats.bytes[i]));
+    return result;
+}
+
+} // namespace
+
+#endif
+
+LiteralSearch::LiteralSearch(std::span<const Needle> _needles)
+{
+    for( const auto &needle : _needles )
+        Compile(needle);
+    SetupProbes();
+}
+
+LiteralSearch::Needle LiteralSearch::Exact(std::string_view _bytes)
+{
+    Needle needle;
+    needle.reserve(_bytes.size());
+    for( const char c : _bytes )
+        needle.push_back(Char{std::string(1, c)});
+    return needle;
+}
+
+void LiteralSearch::Compile(const Needle &_needle)
+{
+    if( _needle.empty() )
+        throw std::invalid_argument("LiteralSearch: a needle can't be empty");
+
+    CompiledNeedle compiled;
+    compiled.first_segment = static_cast<uint32_t>(m_Segments.size());
+
+    for( size_t char_idx = 0; char_idx < _needle.size(); ++char_idx ) {
+        auto forms = _needle[char_idx];
+        if( forms.empty() )
+            throw std::invalid_argument("LiteralSearch: a character must have at least one form");
+        if( std::ranges::any_of(forms, [](const std::string &_form) { return _form.empty(); }) )
+            throw std::invalid_argument("LiteralSearch: a form of a character can't be empty");
+        std::ranges::sort(forms);
+        forms.erase(std::unique(forms.begin(), forms.end()), forms.end());
+
+        const auto [shortest, longest] =
+            std::ranges::minmax(forms, {}, [](const std::string &_form) { return _form.size(); });
+        compiled.min_length += shortest.size();
+        compiled.max_length += longest.size();
+        if( char_idx == 0 )
+            for( const auto &form : forms )
+                compiled.first_bytes.set(static_cast<uint8_t>(form.front()));
+        if( char_idx + 1 == _needle.size() )
+            for( const auto &form : forms )
+                compiled.last_bytes.set(static_cast<uint8_t>(form.back()));
+
+        if( forms.size() == 1 ) {
+            AddLiteral(compiled, forms.front());
+        }
+        else if( longest.size() == 1 ) {
+            std::bitset<256> byte_class;
+            for( const auto &form : forms )
+                byte_class.set(static_cast<uint8_t>(form.front()));
+            AddClass(compiled, byte_class);
+        }
+        else {
+            Segment segment;
+            segment.kind = Segment::Kind::Forms;
+            segment.first = static_cast<uint32_t>(m_Forms.size());
+            segment.count = static_cast<uint32_t>(forms.size());
+            for( const auto &form : forms ) {
+                m_Forms.push_back({.offset = static_cast<uint32_t>(m_Bytes.size()),
+                                   .length = static_cast<uint32_t>(form.size())});
+                m_Bytes += form;
+            }
+            m_Segments.push_back(segment);
+        }
+    }
+
+    compiled.segments_count = static_cast<uint32_t>(m_Segments.size()) - compiled.first_segment;
+    m_FirstBytes |= compiled.first_bytes;
+    m_MaxLength = std::max(m_MaxLength, compiled.max_length);
+    m_Needles.push_back(compiled);
+}
+
+void LiteralSearch::AddLiteral(CompiledNeedle &_needle, std::string_view _bytes)
+{
+    const bool can_extend = m_Segments.size() > _needle.first_segment &&
+                            m_Segments.back().kind == Segment::Kind::Literal &&
+                            m_Segments.back().first + m_Segments.back().count == m_Bytes.size();
+    if( !can_extend )
+        m_Segments.push_back(
+            {.kind = Segment::Kind::Literal, .first = static_cast<uint32_t>(m_Bytes.size()), .count = 0});
+    m_Bytes += _bytes;
+    m_Segments.back().count += static_cast<uint32_t>(_bytes.size());
+}
+
+void LiteralSearch::AddClass(CompiledNeedle &_needle, const std::bitset<256> &_class)
+{
+    const bool can_extend = m_Segments.size() > _needle.first_segment &&
+                            m_Segments.back().kind == Segment::Kind::Classes &&
+                            m_Segments.back().first + m_Segments.back().count == m_Classes.size();
+    if( !can_extend )
+        m_Segments.push_back(
+            {.kind = Segment::Kind::Classes, .first = static_cast<uint32_t>(m_Classes.size()), .count = 0});
+    m_Classes.push_back(_class);
+    m_Segments.back().count += 1;
+}
+
+LiteralSearch::Probe LiteralSearch::MakeProbe(const std::bitset<256> &_bytes, size_t _offset) noexcept
+{
+    Probe probe;
+    probe.offset = _offset;
+    if( _bytes.count() > MaxProbeBytes )
+        return probe;
+    for( size_t byte = 0; byte < 256; ++byte )
+        if( _bytes.test(byte) )
+            probe.bytes[probe.count++] = static_cast<uint8_t>(byte);
+    return probe;
+}
+
+void LiteralSearch::SetupProbes()
+{
+    m_FirstProbe = MakeProbe(m_FirstBytes, 0);
+    if( m_Needles.size() == 1 ) {
+        // a needle of a fixed length has a known set of bytes at its end, checking them too cuts most of the
+        // false candidates
+        const CompiledNeedle &needle = m_Needles.front();
+        if( needle.min_length == needle.max_length && needle.max_length > 1 )
+            m_LastProbe = MakeProbe(needle.last_bytes, needle.max_length - 1);
+    }
+}
+
+std::optional<LiteralSearch::Match>
+LiteralSearch::Find(std::span<const std::byte> _haystack, size_t _from) const noexcept
+{
+    const auto data = reinterpret_cast<const uint8_t *>(_haystack.data());
+    const size_t size = _haystack.size();
+    if( m_Needles.empty() || _from >= size )
+        return std::nullopt;
+
+    size_t pos = _from;
+
+#ifdef NC_LITERAL_SEARCH_VECTORIZED
+    if( m_FirstProbe.count != 0 ) {
+        const Splats first = MakeSplats(m_FirstProbe.bytes, m_FirstProbe.count);
+        if( m_LastProbe.count != 0 ) {
+            const Splats last = MakeSplats(m_LastProbe.bytes, m_LastProbe.count);
+            for( ; pos + m_LastProbe.offset + g_BlockSize <= size; pos += g_BlockSize ) {
+                const Block candidates =
+                    And(AnyOf(Load(data + pos), first), AnyOf(Load(data + pos + m_LastProbe.offset), last));
+                for( uint64_t mask = ToMask(candidates); mask != 0; mask &= mask - 1 )
+                    if( auto match = MatchAt(data, size, pos + (std::countr_zero(mask) / g_BitsPerLane)) )
+                        return match;
+            }
+        }
+        else {
+            for( ; pos + g_BlockSize <= size; pos += g_BlockSize ) {
+                const Block candidates = AnyOf(Load(data + pos), first);
+                for( uint64_t mask = ToMask(candidates); mask != 0; mask &= mask - 1 )
+                    if( auto match = MatchAt(data, size, pos + (std::countr_zero(mask) / g_BitsPerLane)) )
+                        return match;
+            }
+        }
+    }
+#endif
+
+    if( m_FirstProbe.count == 1 ) {
+        // memchr() is vectorized by the libc
+        while( pos < size ) {
+            const auto found = static_cast<const uint8_t *>(std::memchr(data + pos, m_FirstProbe.bytes[0], size - pos));
+            if( found == nullptr )
+                break;
+            pos = static_cast<size_t>(found - data);
+            if( auto match = MatchAt(data, size, pos) )
+                return match;
+            ++pos;
+        }
+        return std::nullopt;
+    }
+
+    for( ; pos < size; ++pos )
+        if( m_FirstBytes.test(data[pos]) )
+            if( auto match = MatchAt(data, size, pos) )
+                return match;
+
+    return std::nullopt;
+}
+
+std::optional<LiteralSearch::Match>
+LiteralSearch::MatchAt(const uint8_t *_data, size_t _size, size_t _pos) const noexcept
+{
+    const uint8_t *const begin = _data + _pos;
+    const uint8_t *const end = _data + _size;
+    for( size_t index = 0; index < m_Needles.size(); ++index ) {
+        const CompiledNeedle &needle = m_Needles[index];
+        if( !needle.first_bytes.test(*begin) || static_cast<size_t>(end - begin) < needle.min_length )
+            continue;
+        const Segment *const segments = m_Segments.data() + needle.first_segment;
+        if( const uint8_t *match_end = MatchSegments(segments, segments + needle.segments_count, begin, end) )
+            return Match{.offset = _pos, .length = static_cast<size_t>(match_end - begin), .needle = index};
+    }
+    return std::nullopt;
+}
+
+const uint8_t *LiteralSearch::MatchSegments(const Segment *_segment,
+                                            const Segment *_segments_end,
+                                            const uint8_t *_pos,
+                                            const uint8_t *_end) const noexcept
+{
+    for( ; _segment != _segments_end; ++_segment ) {
+        const size_t left = static_cast<size_t>(_end - _pos);
+        switch( _segment->kind ) {
+            case Segment::Kind::Literal:
+                if( left < _segment->count )
+                    return nullptr;
+                if( std::memcmp(_pos, m_Bytes.data() + _segment->first, _segment->count) != 0 )
+                    return nullptr;
+                _pos += _segment->count;
+                break;
+            case Segment::Kind::Classes:
+                if( left < _segment->count )
+                    return nullptr;
+                for( uint32_t i = 0; i < _segment->count; ++i )
+                    if( !m_Classes[_segment->first + i].test(_pos[i]) )
+                        return nullptr;
+                _pos += _segment->count;
+                break;
+            case Segment::Kind::Forms:
+                // the forms can have different lengths, so each of them has to be tried with the rest of the needle
+                for( uint32_t i = 0; i < _segment->count; ++i ) {
+                    const Form &form = m_Forms[_segment->first + i];
+                    if( left < form.length || std::memcmp(_pos, m_Bytes.data() + form.offset, form.length) != 0 )
+                        continue;
+                    const uint8_t *match_end = MatchSegments(_segment + 1, _segments_end, _pos + form.length, _end);
+                    if( match_end != nullptr )
+                        return match_end;
+                }
+                return nullptr;
+        }
+    }
+    return _pos;
+}
+
+size_t LiteralSearch::MaxLength() const noexcept
+{
+    return m_MaxLength;
+}
+
+size_t LiteralSearch::NeedlesCount() const noexcept
+{
+    return m_Needles.size();
+}
+
+} // namespace nc::base
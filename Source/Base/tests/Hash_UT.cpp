@@ -1,4 +1,4 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Hash.h"
 #include "UnitTests_main.h"
 
@@ -30,4 +30,26 @@ TEST_CASE(PREFIX "check the hash results")
     CHECK(Hash::Hex(Hash(Hash::MD5).Feed(d.c_str(), d.size()).Final()) == "189b20088062f608cc1c9ce6002e10e0");
     CHECK(Hash::Hex(Hash(Hash::Adler32).Feed(d.c_str(), d.size()).Final()) == "e3d9270a");
     CHECK(Hash::Hex(Hash(Hash::CRC32).Feed(d.c_str(), d.size()).Final()) == "d3ec3da8");
+    CHECK(Hash::Hex(Hash(Hash::XXH3_128).Feed(d.c_str(), d.size()).Final()) == "82dfbc1150308404c5300785c5fb371a");
+    CHECK(Hash::Hex(Hash(Hash::BLAKE3).Feed(d.c_str(), d.size()).Final()) ==
+          "83a5b839969295169b35488e9f7dfbf761d9cfc3c64daf1713f53d5d7aafecc4");
+}
+
+TEST_CASE(PREFIX "streaming input produces the same result as a single feed")
+{
+    // spans multiple BLAKE3 chunks and XXH3 stripes
+    std::string d(5000, '\0');
+    for( size_t i = 0; i < d.size(); ++i )
+        d[i] = static_cast<char>(i % 251);
+
+    for( auto mode : {Hash::MD5, Hash::XXH3_128, Hash::BLAKE3} ) {
+        const auto whole = Hash(mode).Feed(d.data(), d.size()).Final();
+        Hash pieces(mode);
+        for( size_t offset = 0; offset < d.size(); offset += 77 )
+            pieces.Feed(d.data() + offset, std::min<size_t>(77, d.size() - offset));
+        CHECK(pieces.Final() == whole);
+    }
+    CHECK(Hash::Hex(Hash(Hash::XXH3_128).Feed(d.data(), d.size()).Final()) == "b92ec02c39d33ce7b418500fc42320ee");
+    CHECK(Hash::Hex(Hash(Hash::BLAKE3).Feed(d.data(), d.size()).Final()) ==
+          "ee78d92070de3df1c57c37002abf0a6b1a6589acdeef4d8ffac7cf3d9e8f2836");
 }
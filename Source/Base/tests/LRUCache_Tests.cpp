@@ -1,4 +1,4 @@
-// Copyright (C) 2018-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2018-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include <Base/LRUCache.h>
 #include "UnitTests_main.h"
 #include <string>
@@ -71,6 +71,50 @@ TEST_CASE(PREFIX "eviction")
     CHECK(cache.count("c") == 0);
 }
 
+TEST_CASE(PREFIX "find")
+{
+    LRUCache<std::string, std::string, 2> cache;
+    cache["a"] = "A";
+    cache["b"] = "B";
+    CHECK(cache.find("c") == nullptr);
+    REQUIRE(cache.find("a") != nullptr);
+    CHECK(*cache.find("a") == "A");
+
+    cache["c"] = "C"; // "a" was made the most recent by find()
+    CHECK(cache.count("a") == 1);
+    CHECK(cache.count("b") == 0);
+}
+
+TEST_CASE(PREFIX "erase")
+{
+    LRUCache<std::string, std::string, 3> cache;
+    cache["a"] = "A";
+    cache["b"] = "B";
+    cache["c"] = "C";
+    CHECK(cache.erase("b") == 1);
+    CHECK(cache.erase("b") == 0);
+    CHECK(cache.size() == 2);
+    CHECK(cache.count("b") == 0);
+
+    cache["d"] = "D";
+    CHECK(cache.size() == 3);
+    CHECK(cache.count("a") == 1);
+    CHECK(cache.count("c") == 1);
+}
+
+TEST_CASE(PREFIX "erase_if")
+{
+    LRUCache<std::string, std::string, 5> cache;
+    cache["a"] = "A";
+    cache["ab"] = "AB";
+    cache["b"] = "B";
+    cache["abc"] = "ABC";
+    CHECK(cache.erase_if([](const std::string &_key, const std::string &) { return _key.starts_with("a"); }) == 3);
+    CHECK(cache.size() == 1);
+    CHECK(cache.count("b") == 1);
+    CHECK(cache.erase_if([](const std::string &, const std::string &_value) { return _value == "X"; }) == 0);
+}
+
 TEST_CASE(PREFIX "copy")
 {
     // NOLINTBEGIN(bugprone-use-after-move)
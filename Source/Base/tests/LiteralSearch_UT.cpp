@@ -0,0 +1,169 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "LiteralSearch.h"
+#include "UnitTests_main.h"
+#include <cctype>
+#include <string>
+#include <string_view>
+
+using nc::base::LiteralSearch;
+
+#define PREFIX "LiteralSearch "
+
+static std::span<const std::byte> Bytes(std::string_view _string)
+{
+    return std::as_bytes(std::span{_string.data(), _string.size()});
+}
+
+// Each ASCII letter of _text can be matched regardless of its case
+static LiteralSearch::Needle CaseInsensitive(std::string_view _text)
+{
+    LiteralSearch::Needle needle;
+    for( const char c : _text )
+        needle.push_back({std::string(1, static_cast<char>(std::tolower(c))),
+                          std::string(1, static_cast<char>(std::toupper(c)))});
+    return needle;
+}
+
+TEST_CASE(PREFIX "Finds a single needle")
+{
+    const std::vector<LiteralSearch::Needle> needles{LiteralSearch::Exact("hello")};
+    const LiteralSearch search(needles);
+    CHECK(search.NeedlesCount() == 1);
+    CHECK(search.MaxLength() == 5);
+
+    const auto m1 = search.Find(Bytes("0123456789hello56789hello"));
+    REQUIRE(m1);
+    CHECK(m1->offset == 10);
+    CHECK(m1->length == 5);
+    CHECK(m1->needle == 0);
+
+    const auto m2 = search.Find(Bytes("0123456789hello56789hello"), 11);
+    REQUIRE(m2);
+    CHECK(m2->offset == 20);
+
+    CHECK(!search.Find(Bytes("0123456789hello56789hello"), 21));
+    CHECK(!search.Find(Bytes("hell")));
+    CHECK(!search.Find(Bytes("")));
+    CHECK(!search.Find(Bytes("HELLO")));
+}
+
+TEST_CASE(PREFIX "Finds needles at every position of long haystacks")
+{
+    // exercises both the vectorized loop and the tail of the haystack
+    const std::vector<LiteralSearch::Needle> needles{LiteralSearch::Exact("xyz")};
+    const LiteralSearch search(needles);
+    for( size_t size = 3; size < 100; ++size ) {
+        for( size_t pos = 0; pos + 3 <= size; ++pos ) {
+            std::string haystack(size, 'x');
+            haystack.replace(pos, 3, "xyz");
+            const auto match = search.Find(Bytes(haystack));
+            REQUIRE(match);
+            CHECK(match->offset == pos);
+        }
+    }
+}
+
+TEST_CASE(PREFIX "Finds the leftmost of several needles")
+{
+    const std::vector<LiteralSearch::Needle> needles{
+        LiteralSearch::Exact("world"), LiteralSearch::Exact("hello"), LiteralSearch::Exact("hell")};
+    const LiteralSearch search(needles);
+    CHECK(search.NeedlesCount() == 3);
+    CHECK(search.MaxLength() == 5);
+
+    const auto m1 = search.Find(Bytes("say hello to the world"));
+    REQUIRE(m1);
+    CHECK(m1->offset == 4);
+    CHECK(m1->length == 5);
+    CHECK(m1->needle == 1);
+
+    const auto m2 = search.Find(Bytes("say hello to the world"), 5);
+    REQUIRE(m2);
+    CHECK(m2->offset == 17);
+    CHECK(m2->needle == 0);
+
+    const auto m3 = search.Find(Bytes("go to hell"));
+    REQUIRE(m3);
+    CHECK(m3->offset == 6);
+    CHECK(m3->length == 4);
+    CHECK(m3->needle == 2);
+}
+
+TEST_CASE(PREFIX "Matches characters by any of their forms")
+{
+    const std::vector<LiteralSearch::Needle> needles{CaseInsensitive("Needle")};
+    const LiteralSearch search(needles);
+    const std::string haystack = std::string(100, '.') + "a nEeDlE in a haystack";
+    const auto match = search.Find(Bytes(haystack));
+    REQUIRE(match);
+    CHECK(match->offset == 102);
+    CHECK(match->length == 6);
+}
+
+TEST_CASE(PREFIX "Forms of different lengths")
+{
+    // "ss" can be spelled as U+00DF or as "ss", the match length depends on the form
+    LiteralSearch::Needle needle = LiteralSearch::Exact("stra");
+    needle.push_back({"ss", "\xC3\x9F"});
+    needle.push_back({"e"});
+    const std::vector<LiteralSearch::Needle> needles{needle};
+    const LiteralSearch search(needles);
+    CHECK(search.MaxLength() == 7);
+
+    const auto m1 = search.Find(Bytes("die strasse"));
+    REQUIRE(m1);
+    CHECK(m1->offset == 4);
+    CHECK(m1->length == 7);
+
+    const auto m2 = search.Find(Bytes("die stra\xC3\x9F"
+                                      "e"));
+    REQUIRE(m2);
+    CHECK(m2->offset == 4);
+    CHECK(m2->length == 7);
+
+    CHECK(!search.Find(Bytes("die strase")));
+}
+
+TEST_CASE(PREFIX "Many possible first bytes")
+{
+    // too many first bytes to be checked at once, the search falls back to a byte-by-byte scan
+    std::vector<LiteralSearch::Needle> needles;
+    for( char c = 'a'; c <= 'z'; ++c )
+        needles.push_back(LiteralSearch::Exact(std::string(1, c) + "!"));
+    const LiteralSearch search(needles);
+    const auto match = search.Find(Bytes("ABCDEFGHIJKLMNOPQRSTUVWXYZ...q!..."));
+    REQUIRE(match);
+    CHECK(match->offset == 29);
+    CHECK(match->needle == 'q' - 'a');
+}
+
+TEST_CASE(PREFIX "Binary data")
+{
+    const std::string needle_bytes("\x00\xFF\x00", 3);
+    const std::vector<LiteralSearch::Needle> needles{LiteralSearch::Exact(needle_bytes)};
+    const LiteralSearch search(needles);
+    std::string haystack(64, '\0');
+    haystack[40] = '\xFF';
+    const auto match = search.Find(Bytes(haystack));
+    REQUIRE(match);
+    CHECK(match->offset == 39);
+}
+
+TEST_CASE(PREFIX "Without needles nothing is found")
+{
+    const LiteralSearch search({});
+    CHECK(search.NeedlesCount() == 0);
+    CHECK(!search.Find(Bytes("anything")));
+}
+
+TEST_CASE(PREFIX "Rejects malformed needles")
+{
+    const std::vector<LiteralSearch::Needle> empty_needle{LiteralSearch::Needle{}};
+    CHECK_THROWS_AS(LiteralSearch(empty_needle), std::invalid_argument);
+
+    const std::vector<LiteralSearch::Needle> empty_char{LiteralSearch::Needle{LiteralSearch::Char{}}};
+    CHECK_THROWS_AS(LiteralSearch(empty_char), std::invalid_argument);
+
+    const std::vector<LiteralSearch::Needle> empty_form{LiteralSearch::Needle{LiteralSearch::Char{"a", ""}}};
+    CHECK_THROWS_AS(LiteralSearch(empty_form), std::invalid_argument);
+}
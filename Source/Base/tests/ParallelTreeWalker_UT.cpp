@@ -0,0 +1,101 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "ParallelTreeWalker.h"
+#include "UnitTests_main.h"
+#include <atomic>
+#include <set>
+#include <string>
+
+using nc::base::ParallelTreeWalker;
+
+#define PREFIX "ParallelTreeWalker "
+
+namespace {
+
+struct Node {
+    std::string name;
+    std::vector<Node> children;
+    std::atomic_int visits = 0;
+};
+
+} // namespace
+
+// builds a tree where each directory has _fanout subdirectories down to _depth
+static void Grow(Node &_node, int _fanout, int _depth)
+{
+    if( _depth == 0 )
+        return;
+    _node.children = std::vector<Node>(_fanout);
+    for( int i = 0; i < _fanout; ++i ) {
+        _node.children[i].name = _node.name + "/" + std::to_string(i);
+        Grow(_node.children[i], _fanout, _depth - 1);
+    }
+}
+
+static void Collect(Node &_node, std::vector<Node *> &_all)
+{
+    _all.emplace_back(&_node);
+    for( auto &child : _node.children )
+        Collect(child, _all);
+}
+
+TEST_CASE(PREFIX "visits every directory exactly once")
+{
+    const int workers = GENERATE(1, 2, 8);
+    Node root;
+    Grow(root, 4, 6);
+    std::vector<Node *> all;
+    Collect(root, all);
+
+    ParallelTreeWalker<Node *> walker(workers, [](Node *_node, std::vector<Node *> &_subdirs) {
+        ++_node->visits;
+        for( auto &child : _node->children )
+            _subdirs.emplace_back(&child);
+    });
+    walker.Walk({&root});
+
+    CHECK(std::ranges::all_of(all, [](Node *_node) { return _node->visits == 1; }));
+}
+
+TEST_CASE(PREFIX "accepts multiple roots")
+{
+    Node a, b, c;
+    Grow(a, 3, 3);
+    Grow(b, 2, 5);
+    std::vector<Node *> all;
+    Collect(a, all);
+    Collect(b, all);
+    Collect(c, all);
+
+    ParallelTreeWalker<Node *> walker(4, [](Node *_node, std::vector<Node *> &_subdirs) {
+        ++_node->visits;
+        for( auto &child : _node->children )
+            _subdirs.emplace_back(&child);
+    });
+    walker.Walk({&a, &b, &c});
+
+    CHECK(std::ranges::all_of(all, [](Node *_node) { return _node->visits == 1; }));
+}
+
+TEST_CASE(PREFIX "stops visiting once cancelled")
+{
+    Node root;
+    Grow(root, 4, 6);
+    std::atomic_int visited = 0;
+    ParallelTreeWalker<Node *> walker(
+        4,
+        [&](Node *_node, std::vector<Node *> &_subdirs) {
+            ++visited;
+            for( auto &child : _node->children )
+                _subdirs.emplace_back(&child);
+        },
+        [&] { return visited >= 100; });
+    walker.Walk({&root});
+
+    CHECK(visited >= 100);
+    CHECK(visited < 100 + 8); // only the visits which were already in flight can overshoot
+}
+
+TEST_CASE(PREFIX "doesn't accept an empty visitor")
+{
+    CHECK_THROWS_AS(ParallelTreeWalker<int>(2, nullptr), std::invalid_argument);
+}
@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "VFSInit.h"
 #include <VFS/Native.h>
 #include <VFS/ArcLA.h>
@@ -10,6 +10,7 @@
 #include <VFS/NetDropbox.h>
 #include <VFS/NetWebDAV.h>
 #include <NimbleCommander/Bootstrap/AppDelegate.h>
+#include <Base/CommonPaths.h>
 
 namespace nc::bootstrap {
 
@@ -29,6 +30,18 @@ void RegisterAvailableVFS()
     VFSFactory::Instance().RegisterVFS(vfs::ArchiveRawHost::Meta());
     VFSFactory::Instance().RegisterVFS(vfs::XAttrHost::Meta());
     VFSFactory::Instance().RegisterVFS(vfs::WebDAVHost::Meta());
+
+    // let large archives be re-opened without scanning their headers again
+    vfs::ArchiveHost::SetListingIndexDirectory(std::filesystem::path(base::CommonPaths::AppTemporaryDirectory()) /
+                                               "ArchiveListingIndices");
+
+    // let WebDAV listings fetched during the previous connections be revalidated instead of being fetched again
+    vfs::WebDAVHost::SetListingCacheDirectory(std::filesystem::path(base::CommonPaths::AppTemporaryDirectory()) /
+                                              "WebDAVListingCache");
+
+    // let FTP listings be shown right away upon a reconnect while being fetched again in background
+    vfs::FTPHost::SetListingCacheDirectory(std::filesystem::path(base::CommonPaths::AppTemporaryDirectory()) /
+                                           "FTPListingCache");
 }
 
 } // namespace nc::bootstrap
@@ -7,6 +7,7 @@
 #include <Utility/ObjCpp.h>
 #include <Utility/StringExtras.h>
 #include <Utility/NativeFSManager.h>
+#include <VFS/Caching.h>
 #include <VFS/NetFTP.h>
 #include <VFS/NetSFTP.h>
 #include <VFS/NetDropbox.h>
@@ -441,29 +442,35 @@ bool ConfigBackedNetworkConnectionsManager::AskForPassword(const Connection &_co
 std::optional<NetworkConnectionsManager::Connection>
 ConfigBackedNetworkConnectionsManager::ConnectionForVFS(const VFSHost &_vfs) const
 {
+    const VFSHost &host = [&]() -> const VFSHost & {
+        if( auto caching = dynamic_cast<const vfs::CachingHost *>(&_vfs) )
+            return *caching->Wrapped();
+        return _vfs;
+    }();
+
     std::function<bool(const Connection &)> pred;
 
-    if( auto ftp = dynamic_cast<const vfs::FTPHost *>(&_vfs) )
+    if( auto ftp = dynamic_cast<const vfs::FTPHost *>(&host) )
         pred = [ftp](const Connection &i) {
             if( auto p = i.Cast<FTP>() )
                 return p->host == ftp->ServerUrl() && p->user == ftp->User() && p->port == ftp->Port() &&
                        p->active == ftp->Active();
             return false;
         };
-    else if( auto sftp = dynamic_cast<const vfs::SFTPHost *>(&_vfs) )
+    else if( auto sftp = dynamic_cast<const vfs::SFTPHost *>(&host) )
         pred = [sftp](const Connection &i) {
             if( auto p = i.Cast<SFTP>() )
                 return p->host == sftp->ServerUrl() && p->user == sftp->User() && p->keypath == sftp->Keypath() &&
                        p->port == sftp->Port();
             return false;
         };
-    else if( auto dropbox = dynamic_cast<const vfs::DropboxHost *>(&_vfs) )
+    else if( auto dropbox = dynamic_cast<const vfs::DropboxHost *>(&host) )
         pred = [dropbox](const Connection &i) {
             if( auto p = i.Cast<Dropbox>() )
                 return p->account == dropbox->Account();
             return false;
         };
-    else if( auto webdav = dynamic_cast<const vfs::WebDAVHost *>(&_vfs) )
+    else if( auto webdav = dynamic_cast<const vfs::WebDAVHost *>(&host) )
         pred = [webdav](const Connection &i) {
             if( auto p = i.Cast<WebDAV>() )
                 return p->host == webdav->Host() && p->path == webdav->Path() && p->user == webdav->Username();
@@ -492,11 +499,14 @@ VFSHostPtr ConfigBackedNetworkConnectionsManager::SpawnHostFromConnection(const
         shoud_save_passwd = true;
     }
 
+    // the hosts of the remote servers are decorated with a stat cache
     VFSHostPtr host;
     if( auto ftp = _connection.Cast<FTP>() )
-        host = std::make_shared<vfs::FTPHost>(ftp->host, ftp->user, passwd, ftp->path, ftp->port, ftp->active);
+        host = std::make_shared<vfs::CachingHost>(
+            std::make_shared<vfs::FTPHost>(ftp->host, ftp->user, passwd, ftp->path, ftp->port, ftp->active));
     else if( auto sftp = _connection.Cast<SFTP>() )
-        host = std::make_shared<vfs::SFTPHost>(sftp->host, sftp->user, passwd, sftp->keypath, sftp->port);
+        host = std::make_shared<vfs::CachingHost>(
+            std::make_shared<vfs::SFTPHost>(sftp->host, sftp->user, passwd, sftp->keypath, sftp->port));
     else if( auto dropbox = _connection.Cast<Dropbox>() ) {
         vfs::DropboxHost::Params params;
         params.account = dropbox->account;
@@ -506,7 +516,8 @@ VFSHostPtr ConfigBackedNetworkConnectionsManager::SpawnHostFromConnection(const
         host = std::make_shared<vfs::DropboxHost>(params);
     }
     else if( auto w = _connection.Cast<WebDAV>() )
-        host = std::make_shared<vfs::WebDAVHost>(w->host, w->user, passwd, w->path, w->https, w->port);
+        host = std::make_shared<vfs::CachingHost>(
+            std::make_shared<vfs::WebDAVHost>(w->host, w->user, passwd, w->path, w->https, w->port));
 
     if( host ) {
         ReportUsage(_connection);
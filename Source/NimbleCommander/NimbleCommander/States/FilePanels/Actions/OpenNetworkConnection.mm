@@ -8,6 +8,7 @@
 #include "../Views/DropboxAccountSheetController.h"
 #include "../Views/WebDAVConnectionSheetController.h"
 #include <VFS/Native.h>
+#include <VFS/Caching.h>
 #include <VFS/NetFTP.h>
 #include <VFS/NetSFTP.h>
 #include <VFS/NetDropbox.h>
@@ -35,7 +36,8 @@ static bool GoToFTP(PanelController *_target,
     dispatch_assert_background_queue();
     auto &info = _connection.Get<NetworkConnectionsManager::FTP>();
     try {
-        auto host = std::make_shared<vfs::FTPHost>(info.host, info.user, _passwd, info.path, info.port, info.active);
+        auto host = std::make_shared<vfs::CachingHost>(
+            std::make_shared<vfs::FTPHost>(info.host, info.user, _passwd, info.path, info.port, info.active));
         dispatch_to_main_queue([=] {
             auto request = std::make_shared<DirectoryChangeRequest>();
             request->RequestedDirectory = info.path;
@@ -70,10 +72,11 @@ static bool GoToSFTP(PanelController *_target,
     dispatch_assert_background_queue();
     auto &info = _connection.Get<NetworkConnectionsManager::SFTP>();
     try {
-        auto host = std::make_shared<vfs::SFTPHost>(info.host, info.user, _passwd, info.keypath, info.port);
+        auto sftp = std::make_shared<vfs::SFTPHost>(info.host, info.user, _passwd, info.keypath, info.port);
+        auto host = std::make_shared<vfs::CachingHost>(sftp);
         dispatch_to_main_queue([=] {
             auto request = std::make_shared<DirectoryChangeRequest>();
-            request->RequestedDirectory = host->HomeDir();
+            request->RequestedDirectory = sftp->HomeDir();
             request->VFS = host;
             request->PerformAsynchronous = true;
             request->InitiatedByUser = true;
@@ -105,7 +108,8 @@ static bool GoToWebDAV(PanelController *_target,
     dispatch_assert_background_queue();
     auto &info = _connection.Get<NetworkConnectionsManager::WebDAV>();
     try {
-        auto host = std::make_shared<vfs::WebDAVHost>(info.host, info.user, _passwd, info.path, info.https, info.port);
+        auto host = std::make_shared<vfs::CachingHost>(
+            std::make_shared<vfs::WebDAVHost>(info.host, info.user, _passwd, info.path, info.https, info.port));
         dispatch_to_main_queue([=] {
             auto request = std::make_shared<DirectoryChangeRequest>();
             request->RequestedDirectory = "/";
@@ -399,7 +399,7 @@ private:
 
 - (int)searchOptionsFromUI
 {
-    int search_options = 0;
+    int search_options = SearchForFiles::Options::Parallel;
     if( self.SearchInSubDirsButton.intValue )
         search_options |= SearchForFiles::Options::GoIntoSubDirs;
     switch( self.searchForPopup.selectedTag ) {
@@ -15,6 +15,7 @@
 #include <Operations/Copying.h>
 #include <Base/dispatch_cpp.h>
 #include <Utility/StringExtras.h>
+#include <algorithm>
 
 // TODO: remove this, DI stuff instead
 #include <NimbleCommander/Bootstrap/AppDelegate.h>
@@ -26,6 +27,7 @@ namespace nc::panel {
 static const auto g_ConfigArchivesExtensionsWhiteList = "filePanel.general.archivesExtensionsWhitelist";
 static const auto g_ConfigExecutableExtensionsWhitelist = "filePanel.general.executableExtensionsWhitelist";
 static const auto g_ConfigDefaultVerificationSetting = "filePanel.operations.defaultChecksumVerification";
+static const auto g_ConfigCopyingParallelLanes = "filePanel.operations.copyingParallelLanes";
 static const auto g_CheckDelay = "filePanel.operations.vfsShadowUploadChangesCheckDelay";
 static const auto g_DropDelay = "filePanel.operations.vfsShadowUploadObservationDropDelay";
 static const auto g_QLPanel = "filePanel.presentation.showQuickLookAsFloatingPanel";
@@ -309,11 +311,19 @@ static ops::CopyingOptions::ChecksumVerification DefaultChecksumVerificationSett
         return ops::CopyingOptions::ChecksumVerification::Never;
 }
 
+static int DefaultCopyingParallelLanes()
+{
+    if( !GlobalConfig().Has(g_ConfigCopyingParallelLanes) )
+        return 4;
+    return std::clamp(GlobalConfig().GetInt(g_ConfigCopyingParallelLanes), 1, 16);
+}
+
 ops::CopyingOptions MakeDefaultFileCopyOptions()
 {
     ops::CopyingOptions options;
     options.docopy = true;
     options.verification = DefaultChecksumVerificationSetting();
+    options.parallel_lanes = DefaultCopyingParallelLanes();
 
     return options;
 }
@@ -323,6 +333,7 @@ ops::CopyingOptions MakeDefaultFileMoveOptions()
     ops::CopyingOptions options;
     options.docopy = false;
     options.verification = DefaultChecksumVerificationSetting();
+    options.parallel_lanes = DefaultCopyingParallelLanes();
 
     return options;
 }
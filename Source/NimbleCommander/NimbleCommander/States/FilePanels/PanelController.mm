@@ -15,6 +15,7 @@
 #include "PanelDataOptionsPersistence.h"
 #include <Base/CommonPaths.h>
 #include <VFS/Native.h>
+#include <VFS/DirectorySizeCalculator.h>
 #include "PanelHistory.h"
 #include <Base/SerialQueue.h>
 #include <Panel/PanelData.h>
@@ -115,6 +116,13 @@ MAKE_AUTO_UPDATING_BOOL_CONFIG_VALUE(ConfigShowDotDotEntry, g_ConfigShowDotDotEn
 MAKE_AUTO_UPDATING_BOOL_CONFIG_VALUE(ConfigShowLocalizedFilenames, g_ConfigShowLocalizedFilenames);
 MAKE_AUTO_UPDATING_BOOL_CONFIG_VALUE(ConfigEnableFinderTags, g_ConfigEnableFinderTags);
 
+// Shared by all panels, so that the directories calculated in one of them are reused by the others
+static vfs::DirectorySizeCalculator &SizeCalculator()
+{
+    [[clang::no_destroy]] static vfs::DirectorySizeCalculator calculator;
+    return calculator;
+}
+
 static void HeatUpConfigValues()
 {
     ConfigShowDotDotEntry();
@@ -519,72 +527,78 @@ static void HeatUpConfigValues()
     dispatch_assert_background_queue();
     assert(!_items.empty());
 
-    // divide all items into maximum of g_MaxSizeCalculationCommitBatches batches as equally as
-    // possible
-    const size_t items_count = _items.size();
-    const size_t batches = std::min(g_MaxSizeCalculationCommitBatches, items_count);
-    const size_t items_per_batch = items_count / batches;
-    const size_t items_leftover = items_count - (items_per_batch * batches);
-
-    for( size_t batch = 0, items_first = 0, items_last = 0; batch != batches; ++batch ) {
-        items_first = items_last;
-        items_last += items_per_batch + (batch < items_leftover ? 1 : 0);
-
-        panel::CalculatedSizesBatch calculated;
-        calculated.items.reserve(items_last - items_first);
-        calculated.sizes.reserve(items_last - items_first);
-
-        for( size_t item_index = items_first; item_index != items_last; ++item_index ) {
-            if( m_DirectorySizeCountingQ.IsStopped() )
-                return;
-
-            auto &i = _items[item_index];
-            if( !i.IsDir() )
-                continue;
-
-            const std::expected<uint64_t, Error> result = i.Host()->CalculateDirectorySize(
-                !i.IsDotDot() ? i.Path() : i.Directory(), [=] { return m_DirectorySizeCountingQ.IsStopped(); });
+    std::vector<VFSListingItem> dirs;
+    std::ranges::copy_if(_items, std::back_inserter(dirs), [](auto &i) { return i.IsDir(); });
+    if( dirs.empty() )
+        return;
 
-            if( !result )
-                continue; // silently skip items that caused erros while calculating size
+    // the sizes are committed as soon as they are calculated, but in no more than g_MaxSizeCalculationCommitBatches
+    // batches
+    const size_t items_per_batch =
+        (dirs.size() + g_MaxSizeCalculationCommitBatches - 1) / g_MaxSizeCalculationCommitBatches;
+    panel::CalculatedSizesBatch calculated;
+    auto commit = [&] {
+        if( calculated.items.empty() )
+            return;
+        dispatch_to_main_queue([=, calculated = std::move(calculated)] { [self commitCalculatedSizes:calculated]; });
+        calculated = {};
+    };
+
+    const auto is_stopped = [=] { return m_DirectorySizeCountingQ.IsStopped(); };
+    for( auto first = dirs.begin(); first != dirs.end(); ) {
+        // all directories of the same host are calculated together
+        const auto last = std::find_if(first, dirs.end(), [&](auto &i) { return i.Host() != first->Host(); });
+        std::vector<std::string> paths;
+        std::transform(first, last, std::back_inserter(paths), [](auto &i) {
+            return !i.IsDotDot() ? i.Path() : i.Directory();
+        });
 
-            calculated.items.emplace_back(i);
-            calculated.sizes.emplace_back(*result);
-        }
+        auto on_calculated = [&](size_t _index, std::expected<uint64_t, Error> _size) {
+            if( !_size )
+                return; // silently skip items that caused erros while calculating size
+            calculated.items.emplace_back(first[_index]);
+            calculated.sizes.emplace_back(*_size);
+            if( calculated.items.size() >= items_per_batch )
+                commit();
+        };
+        SizeCalculator().Calculate(first->Host(), paths, on_calculated, is_stopped);
 
-        if( calculated.items.empty() )
-            continue;
+        if( m_DirectorySizeCountingQ.IsStopped() )
+            return;
+        first = last;
+    }
+    commit();
+}
 
-        auto commit_batch = [=, calculated = std::move(calculated)] {
-            assert(!calculated.items.empty());
+- (void)commitCalculatedSizes:(const panel::CalculatedSizesBatch &)_calculated
+{
+    dispatch_assert_main_queue();
+    assert(!_calculated.items.empty());
 
-            // may cause re-sorting if current sorting is by size so save the cursor
-            const auto pers = CursorBackup{m_View.curpos, m_Data};
+    // may cause re-sorting if current sorting is by size so save the cursor
+    const auto pers = CursorBackup{m_View.curpos, m_Data};
 
-            size_t num_set = 0;
-            if( &m_Data.Listing() == calculated.items.front().Listing().get() ) {
-                // the listing is the same, can use indices directly
-                std::vector<unsigned> raw_indices(calculated.items.size());
-                std::ranges::transform(calculated.items, raw_indices.begin(), [](auto &i) { return i.Index(); });
-                num_set = m_Data.SetCalculatedSizesForDirectories(raw_indices, calculated.sizes);
-            }
-            else {
-                // the listing has changed, need to use indirects: filename and directory
-                std::vector<std::string_view> filenames(calculated.items.size());
-                std::vector<std::string_view> directories(calculated.items.size());
-                std::ranges::transform(
-                    calculated.items, filenames.begin(), [](auto &i) { return std::string_view{i.Filename()}; });
-                std::ranges::transform(
-                    calculated.items, directories.begin(), [](auto &i) { return std::string_view{i.Directory()}; });
-                num_set = m_Data.SetCalculatedSizesForDirectories(filenames, directories, calculated.sizes);
-            }
-            if( num_set != 0 ) {
-                [m_View dataUpdated];
-                [m_View volatileDataChanged];
-                m_View.curpos = pers.RestoredCursorPosition();
-            }
-        };
-        dispatch_to_main_queue(std::move(commit_batch));
+    size_t num_set = 0;
+    if( &m_Data.Listing() == _calculated.items.front().Listing().get() ) {
+        // the listing is the same, can use indices directly
+        std::vector<unsigned> raw_indices(_calculated.items.size());
+        std::ranges::transform(_calculated.items, raw_indices.begin(), [](auto &i) { return i.Index(); });
+        num_set = m_Data.SetCalculatedSizesForDirectories(raw_indices, _calculated.sizes);
+    }
+    else {
+        // the listing has changed, need to use indirects: filename and directory
+        std::vector<std::string_view> filenames(_calculated.items.size());
+        std::vector<std::string_view> directories(_calculated.items.size());
+        std::ranges::transform(
+            _calculated.items, filenames.begin(), [](auto &i) { return std::string_view{i.Filename()}; });
+        std::ranges::transform(
+            _calculated.items, directories.begin(), [](auto &i) { return std::string_view{i.Directory()}; });
+        num_set = m_Data.SetCalculatedSizesForDirectories(filenames, directories, _calculated.sizes);
+    }
+    if( num_set != 0 ) {
+        [m_View dataUpdated];
+        [m_View volatileDataChanged];
+        m_View.curpos = pers.RestoredCursorPosition();
     }
 }
 
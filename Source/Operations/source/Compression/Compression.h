@@ -2,6 +2,7 @@
 #pragma once
 
 #include "../Operation.h"
+#include "CompressionFormat.h"
 #include <VFS/VFS.h>
 
 /*
@@ -19,7 +20,8 @@ public:
     Compression(std::vector<VFSListingItem> _src_files,
                 std::string _dst_root,
                 VFSHostPtr _dst_vfs,
-                std::string _passphrase = "");
+                std::string _passphrase = "",
+                CompressionFormat _format = CompressionFormat::Zip);
     virtual ~Compression();
 
     std::string ArchivePath() const;
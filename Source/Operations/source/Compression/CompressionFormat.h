@@ -0,0 +1,12 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+namespace nc::ops {
+
+enum class CompressionFormat {
+    Zip,     // .zip, deflated on multiple threads unless encrypted
+    TarZstd, // .tar.zst, compressed by the multi-threaded zstd filter of libarchive
+    TarXz    // .tar.xz, compressed by the multi-threaded xz filter of libarchive
+};
+
+} // namespace nc::ops
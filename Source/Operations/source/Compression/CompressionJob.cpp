@@ -1,12 +1,17 @@
 // Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "CompressionJob.h"
+#include "ParallelZipWriter.h"
 #include <Base/algo.h>
 #include <libarchive/archive.h>
 #include <libarchive/archive_entry.h>
 #include <Utility/PathManip.h>
 #include <VFS/AppleDoubleEA.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 #include <fmt/format.h>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 
 namespace nc::ops {
 
@@ -54,16 +59,20 @@ struct CompressionJob::Source {
 };
 
 static void WriteEmptyArchiveEntry(struct ::archive *_archive);
-static bool WriteEAsIfAny(VFSFile &_src, struct archive *_a, std::string_view _source_fn);
+static bool WriteEAs(struct archive *_a, std::span<const std::byte> _md, const std::string &_metadata_path);
+static std::string ComposeEAsPath(std::string_view _source_fn);
 static void archive_entry_copy_stat(struct archive_entry *_ae, const VFSStat &_vfs_stat);
 
 CompressionJob::CompressionJob(std::vector<VFSListingItem> _src_files,
                                std::string _dst_root,
                                VFSHostPtr _dst_vfs,
-                               std::string _password)
+                               std::string _password,
+                               CompressionFormat _format)
     : m_InitialListingItems{std::move(_src_files)}, m_DstRoot{std::move(_dst_root)}, m_DstVFS{std::move(_dst_vfs)},
-      m_Password{std::move(_password)}
+      m_Password{std::move(_password)}, m_Format{_format}
 {
+    if( !m_Password.empty() && m_Format != CompressionFormat::Zip )
+        throw std::invalid_argument("CompressionJob: only Zip archives can be encrypted");
     if( m_DstRoot.empty() || m_DstRoot.back() != '/' )
         m_DstRoot += '/';
 }
@@ -102,48 +111,112 @@ bool CompressionJob::BuildArchive()
 
     m_TargetFile = *exp_file;
     const auto open_rc = m_TargetFile->Open(flags);
-    if( open_rc == VFSError::Ok ) {
-        m_Archive = archive_write_new();
-        archive_write_set_format_zip(m_Archive);
-        archive_write_add_filter_none(m_Archive);
-        if( !m_Password.empty() ) {
-            if( archive_write_set_options(m_Archive, "zip:encryption=aes256") != ARCHIVE_OK ) {
-                Stop();
-                return false;
-            }
-            if( archive_write_set_options(m_Archive, "zip:experimental") != ARCHIVE_OK ) {
-                Stop();
-                return false;
-            }
-            if( archive_write_set_passphrase(m_Archive, m_Password.c_str()) != ARCHIVE_OK ) {
-                Stop();
-                return false;
-            }
-        }
+    if( open_rc != VFSError::Ok ) {
+        m_TargetWriteError(VFSError::ToError(open_rc), m_TargetArchivePath, *m_DstVFS);
+        Stop();
+        return false;
+    }
 
-        archive_write_open(m_Archive, this, nullptr, WriteCallback, nullptr);
-        archive_write_set_bytes_in_last_block(m_Archive, 1);
+    // libarchive can't write deflated zip entries in parallel, so unless the archive is encrypted the entries are
+    // compressed by ParallelZipWriter. An empty archive still goes through libarchive to get the placeholder entry.
+    const bool use_zip_writer = m_Format == CompressionFormat::Zip && !IsEncrypted() && CompressionThreads() > 1 &&
+                                !m_Source->filenames.empty();
+    const bool built = use_zip_writer ? BuildArchiveWithParallelZipWriter() : BuildArchiveWithLibarchive();
 
-        ProcessItems();
+    m_TargetFile->Close();
 
-        if( m_Source->filenames.empty() )
-            WriteEmptyArchiveEntry(m_Archive);
+    if( IsStopped() ) {
+        std::ignore = m_DstVFS->Unlink(m_TargetArchivePath);
+    }
 
-        archive_write_close(m_Archive);
-        archive_write_free(m_Archive);
+    return built;
+}
 
-        m_TargetFile->Close();
+bool CompressionJob::BuildArchiveWithLibarchive()
+{
+    m_Archive = archive_write_new();
+    const auto free_archive = at_scope_end([&] {
+        archive_write_free(m_Archive);
+        m_Archive = nullptr;
+    });
 
-        if( IsStopped() ) {
-            std::ignore = m_DstVFS->Unlink(m_TargetArchivePath);
-        }
+    if( !SetupLibarchiveFormat() ) {
+        Stop();
+        return false;
     }
-    else {
-        m_TargetWriteError(VFSError::ToError(open_rc), m_TargetArchivePath, *m_DstVFS);
+
+    archive_write_open(m_Archive, this, nullptr, WriteCallback, nullptr);
+    archive_write_set_bytes_in_last_block(m_Archive, 1);
+
+    ProcessItems();
+
+    if( m_Source->filenames.empty() && m_Format == CompressionFormat::Zip )
+        WriteEmptyArchiveEntry(m_Archive);
+
+    if( archive_write_close(m_Archive) < ARCHIVE_WARN && !IsStopped() ) {
+        ReportTargetWriteError();
         Stop();
         return false;
     }
+    return true;
+}
 
+bool CompressionJob::SetupLibarchiveFormat()
+{
+    const std::string threads = std::to_string(CompressionThreads());
+    switch( m_Format ) {
+        case CompressionFormat::Zip:
+            archive_write_set_format_zip(m_Archive);
+            archive_write_add_filter_none(m_Archive);
+            if( !m_Password.empty() ) {
+                if( archive_write_set_options(m_Archive, "zip:encryption=aes256") != ARCHIVE_OK )
+                    return false;
+                if( archive_write_set_options(m_Archive, "zip:experimental") != ARCHIVE_OK )
+                    return false;
+                if( archive_write_set_passphrase(m_Archive, m_Password.c_str()) != ARCHIVE_OK )
+                    return false;
+            }
+            return true;
+        case CompressionFormat::TarZstd:
+            if( archive_write_set_format_pax_restricted(m_Archive) != ARCHIVE_OK ||
+                archive_write_add_filter_zstd(m_Archive) != ARCHIVE_OK )
+                return false;
+            // the multi-threading is an optional feature of libzstd, carry on without it if it's not available
+            archive_write_set_filter_option(m_Archive, "zstd", "threads", threads.c_str());
+            return true;
+        case CompressionFormat::TarXz:
+            if( archive_write_set_format_pax_restricted(m_Archive) != ARCHIVE_OK ||
+                archive_write_add_filter_xz(m_Archive) != ARCHIVE_OK )
+                return false;
+            archive_write_set_filter_option(m_Archive, "xz", "threads", threads.c_str());
+            return true;
+    }
+    return false;
+}
+
+bool CompressionJob::BuildArchiveWithParallelZipWriter()
+{
+    const auto sink = [this](const void *_data, size_t _size) {
+        const auto *bytes = static_cast<const std::byte *>(_data);
+        while( _size > 0 ) {
+            const ssize_t rc = m_TargetFile->Write(bytes, _size);
+            if( rc <= 0 )
+                return false;
+            bytes += rc;
+            _size -= static_cast<size_t>(rc);
+        }
+        return true;
+    };
+    m_ZipWriter = std::make_unique<compression::ParallelZipWriter>(sink, CompressionThreads());
+    const auto free_writer = at_scope_end([&] { m_ZipWriter.reset(); });
+
+    ProcessItems();
+
+    if( !m_ZipWriter->Finish() && !IsStopped() ) {
+        ReportTargetWriteError();
+        Stop();
+        return false;
+    }
     return true;
 }
 
@@ -226,12 +299,7 @@ CompressionJob::ProcessSymlinkItem(int _index, const std::string &_relative_path
         }
     }
 
-    const auto entry = archive_entry_new();
-    const auto entry_cleanup = at_scope_end([&] { archive_entry_free(entry); });
-    archive_entry_set_pathname(entry, _relative_path.c_str());
-    archive_entry_copy_stat(entry, stat);
-    archive_entry_set_symlink(entry, symlink.c_str());
-    archive_write_header(m_Archive, entry);
+    WriteHeader(_relative_path, stat, symlink, {});
 
     return StepResult::Done;
 }
@@ -260,26 +328,23 @@ CompressionJob::ProcessDirectoryItem(int _index, const std::string &_relative_pa
         }
     }
 
-    auto entry = archive_entry_new();
-    auto entry_cleanup = at_scope_end([&] { archive_entry_free(entry); });
-    archive_entry_set_pathname(entry, _relative_path.c_str());
-    archive_entry_copy_stat(entry, vfs_stat);
-    const auto head_write_rc = archive_write_header(m_Archive, entry);
-    if( head_write_rc < 0 ) {
-        m_TargetWriteError(
-            m_TargetFile->LastError().value_or(Error{Error::POSIX, EINVAL}), m_TargetArchivePath, *m_DstVFS);
-        Stop();
-    }
-
+    std::vector<std::byte> metadata;
     if( !IsEncrypted() ) {
         // we can't support encrypted EAs due to lack of read support in LA
         const std::expected<std::shared_ptr<VFSFile>, Error> src_file = vfs.CreateFile(_full_path);
-        if( src_file && (*src_file)->Open(VFSFlags::OF_Read) == VFSError::Ok ) {
-            const std::string name_wo_slash = {std::begin(_relative_path), std::end(_relative_path) - 1};
-            WriteEAsIfAny(**src_file, m_Archive, name_wo_slash);
-        }
+        if( src_file && (*src_file)->Open(VFSFlags::OF_Read) == VFSError::Ok )
+            metadata = vfs::BuildAppleDoubleFromEA(**src_file); // will quit almost immediately if there's no EAs
+    }
+
+    if( !WriteHeader(_relative_path, vfs_stat, {}, metadata) ) {
+        ReportTargetWriteError();
+        Stop();
+        return StepResult::Stopped;
     }
 
+    const std::string name_wo_slash = {std::begin(_relative_path), std::end(_relative_path) - 1};
+    WriteMetadata(name_wo_slash, vfs_stat, metadata);
+
     return StepResult::Done;
 }
 
@@ -331,38 +396,25 @@ CompressionJob::ProcessRegularItem(int _index, const std::string &_relative_path
         }
     }
 
-    const auto entry = archive_entry_new();
-    const auto entry_cleanup = at_scope_end([&] { archive_entry_free(entry); });
+    // we can't support encrypted EAs due to lack of read support in LA
+    const std::vector<std::byte> metadata =
+        IsEncrypted() ? std::vector<std::byte>{} : vfs::BuildAppleDoubleFromEA(src_file);
 
-    archive_entry_set_pathname(entry, _relative_path.c_str());
-    archive_entry_copy_stat(entry, stat);
-    const auto head_write_rc = archive_write_header(m_Archive, entry);
-    if( head_write_rc < 0 ) {
-        m_TargetWriteError(
-            m_TargetFile->LastError().value_or(Error{Error::POSIX, EINVAL}), m_TargetArchivePath, *m_DstVFS);
+    if( !WriteHeader(_relative_path, stat, {}, metadata) ) {
+        ReportTargetWriteError();
         Stop();
+        return StepResult::Stopped;
     }
 
     constexpr int buf_sz = 256 * 1024; // Why 256Kb?
-    const std::unique_ptr<char[]> buf = std::make_unique<char[]>(buf_sz);
+    const std::unique_ptr<std::byte[]> buf = std::make_unique<std::byte[]>(buf_sz);
     ssize_t source_read_rc;
     while( (source_read_rc = src_file.Read(buf.get(), buf_sz)) > 0 ) { // reading and compressing itself
         if( BlockIfPaused(); IsStopped() )
             return StepResult::Stopped;
 
-        ssize_t to_write = source_read_rc;
-        ssize_t la_rc = 0;
-        do {
-            la_rc = archive_write_data(m_Archive, buf.get(), to_write);
-            if( la_rc >= 0 )
-                to_write -= la_rc;
-            else
-                break;
-        } while( to_write > 0 );
-
-        if( la_rc < 0 ) {
-            m_TargetWriteError(
-                m_TargetFile->LastError().value_or(Error{Error::POSIX, EINVAL}), m_TargetArchivePath, *m_DstVFS);
+        if( !WriteData({buf.get(), static_cast<size_t>(source_read_rc)}) ) {
+            ReportTargetWriteError();
             Stop();
             return StepResult::Stopped;
         }
@@ -370,6 +422,12 @@ CompressionJob::ProcessRegularItem(int _index, const std::string &_relative_path
         Statistics().CommitProcessed(Statistics::SourceType::Bytes, source_read_rc);
     }
 
+    if( !FinishData() ) {
+        ReportTargetWriteError();
+        Stop();
+        return StepResult::Stopped;
+    }
+
     if( source_read_rc < 0 )
         switch( m_SourceReadError(static_cast<int>(source_read_rc), _full_path, vfs) ) {
             case SourceReadErrorResolution::Stop:
@@ -379,22 +437,101 @@ CompressionJob::ProcessRegularItem(int _index, const std::string &_relative_path
                 return StepResult::Skipped;
         }
 
-    if( !IsEncrypted() ) {
-        // we can't support encrypted EAs due to lack of read support in LA
-        WriteEAsIfAny(src_file, m_Archive, _relative_path);
-    }
+    WriteMetadata(_relative_path, stat, metadata);
 
     return StepResult::Done;
 }
 
+// Writes the header of an archive entry. The EAs in the AppleDouble format are embedded into Tar archives by libarchive
+// as "._" entries, while Zip archives get them separately via WriteMetadata().
+bool CompressionJob::WriteHeader(const std::string &_relative_path,
+                                 const VFSStat &_stat,
+                                 std::string_view _symlink,
+                                 std::span<const std::byte> _metadata)
+{
+    if( m_ZipWriter ) {
+        const compression::ParallelZipWriter::Entry entry{.path = _relative_path,
+                                                          .mode = _stat.mode,
+                                                          .mtime = _stat.mtime.tv_sec,
+                                                          .uid = _stat.uid,
+                                                          .gid = _stat.gid,
+                                                          .size = _stat.size};
+        if( S_ISDIR(_stat.mode) )
+            return m_ZipWriter->AddDirectory(entry);
+        if( S_ISLNK(_stat.mode) )
+            return m_ZipWriter->AddSymlink(entry, _symlink);
+        return m_ZipWriter->BeginFile(entry);
+    }
+
+    const auto entry = archive_entry_new();
+    const auto entry_cleanup = at_scope_end([&] { archive_entry_free(entry); });
+    archive_entry_set_pathname(entry, _relative_path.c_str());
+    archive_entry_copy_stat(entry, _stat);
+    if( S_ISLNK(_stat.mode) )
+        archive_entry_set_symlink(entry, std::string(_symlink).c_str());
+    if( IsTar() && !_metadata.empty() )
+        archive_entry_copy_mac_metadata(entry, _metadata.data(), _metadata.size());
+    return archive_write_header(m_Archive, entry) >= ARCHIVE_WARN;
+}
+
+bool CompressionJob::WriteData(std::span<const std::byte> _data)
+{
+    if( m_ZipWriter )
+        return m_ZipWriter->WriteFile(_data);
+
+    while( !_data.empty() ) {
+        const ssize_t la_rc = archive_write_data(m_Archive, _data.data(), _data.size());
+        if( la_rc < 0 )
+            return false;
+        _data = _data.subspan(static_cast<size_t>(la_rc));
+    }
+    return true;
+}
+
+bool CompressionJob::FinishData()
+{
+    if( m_ZipWriter )
+        return m_ZipWriter->EndFile();
+    return true;
+}
+
+bool CompressionJob::WriteMetadata(const std::string &_relative_path,
+                                   const VFSStat &_stat,
+                                   std::span<const std::byte> _metadata)
+{
+    if( _metadata.empty() || IsTar() )
+        return true;
+
+    const std::string metadata_path = ComposeEAsPath(_relative_path);
+    if( metadata_path.empty() )
+        return false;
+
+    if( m_ZipWriter ) {
+        const compression::ParallelZipWriter::Entry entry{
+            .path = metadata_path, .mode = S_IFREG | 0644, .mtime = _stat.mtime.tv_sec, .size = _metadata.size()};
+        return m_ZipWriter->AddFile(entry, _metadata);
+    }
+
+    return WriteEAs(m_Archive, _metadata, metadata_path);
+}
+
+void CompressionJob::ReportTargetWriteError()
+{
+    m_TargetWriteError(
+        m_TargetFile->LastError().value_or(Error{Error::POSIX, EINVAL}), m_TargetArchivePath, *m_DstVFS);
+}
+
 std::string CompressionJob::FindSuitableFilename(const std::string &_proposed_arcname) const
 {
-    std::string fn = fmt::format("{}{}.zip", m_DstRoot, _proposed_arcname);
+    const std::string_view extension = m_Format == CompressionFormat::TarZstd ? "tar.zst"
+                                       : m_Format == CompressionFormat::TarXz ? "tar.xz"
+                                                                              : "zip";
+    std::string fn = fmt::format("{}{}.{}", m_DstRoot, _proposed_arcname, extension);
     if( !m_DstVFS->Stat(fn, VFSFlags::F_NoFollow) )
         return fn;
 
     for( int i = 2; i < 100; ++i ) {
-        fn = fmt::format("{}{} {}.zip", m_DstRoot, _proposed_arcname, i);
+        fn = fmt::format("{}{} {}.{}", m_DstRoot, _proposed_arcname, i, extension);
         if( !m_DstVFS->Stat(fn, VFSFlags::F_NoFollow) )
             return fn;
     }
@@ -577,6 +714,16 @@ bool CompressionJob::IsEncrypted() const noexcept
     return !m_Password.empty();
 }
 
+bool CompressionJob::IsTar() const noexcept
+{
+    return m_Format == CompressionFormat::TarZstd || m_Format == CompressionFormat::TarXz;
+}
+
+int CompressionJob::CompressionThreads() noexcept
+{
+    return std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, 16);
+}
+
 static void archive_entry_copy_stat(struct archive_entry *_ae, const VFSStat &_vfs_stat)
 {
     struct stat sys_stat;
@@ -596,11 +743,10 @@ static void WriteEmptyArchiveEntry(struct ::archive *_archive)
     archive_entry_free(entry);
 }
 
-static bool WriteEAs(struct archive *_a, std::span<const std::byte> _md, std::string_view _path, std::string_view _name)
+static bool WriteEAs(struct archive *_a, std::span<const std::byte> _md, const std::string &_metadata_path)
 {
-    const std::string metadata_path = fmt::format("__MACOSX/{}._{}", _path, _name);
     struct archive_entry *entry = archive_entry_new();
-    archive_entry_set_pathname(entry, metadata_path.c_str());
+    archive_entry_set_pathname(entry, _metadata_path.c_str());
     archive_entry_set_size(entry, _md.size());
     archive_entry_set_filetype(entry, AE_IFREG);
     archive_entry_set_perm(entry, 0644);
@@ -611,23 +757,19 @@ static bool WriteEAs(struct archive *_a, std::span<const std::byte> _md, std::st
     return ret == static_cast<ssize_t>(_md.size());
 }
 
-static bool WriteEAsIfAny(VFSFile &_src, struct archive *_a, std::string_view _source_fn)
+// Returns a path of the AppleDouble entry which keeps the EAs of the specified item, e.g. "__MACOSX/dir/._file".
+static std::string ComposeEAsPath(std::string_view _source_fn)
 {
     assert(!utility::PathManip::HasTrailingSlash(_source_fn));
 
-    // will quit almost immediately if there's no EAs
-    const std::vector<std::byte> metadata = vfs::BuildAppleDoubleFromEA(_src);
-    if( metadata.empty() )
-        return true;
-
     const std::string_view item_name = utility::PathManip::Filename(_source_fn);
     if( item_name.empty() )
-        return false;
+        return {};
 
     const std::string_view parent_path = utility::PathManip::Parent(_source_fn);
     // NB! an empty parent path is ok here
 
-    return WriteEAs(_a, metadata, parent_path, item_name);
+    return fmt::format("__MACOSX/{}._{}", parent_path, item_name);
 }
 
 } // namespace nc::ops
@@ -2,13 +2,19 @@
 #pragma once
 
 #include "../Job.h"
+#include "CompressionFormat.h"
 #include <VFS/VFS.h>
 #include <Base/chained_strings.h>
+#include <span>
 
 struct archive;
 
 namespace nc::ops {
 
+namespace compression {
+class ParallelZipWriter;
+}
+
 struct CompressionJobCallbacks {
     std::function<void()> m_TargetPathDefined = [] {};
 
@@ -42,10 +48,12 @@ struct CompressionJobCallbacks {
 class CompressionJob final : public Job, public CompressionJobCallbacks
 {
 public:
+    // Throws std::invalid_argument if a password is specified for a format which doesn't support encryption.
     CompressionJob(std::vector<VFSListingItem> _src_files,
                    std::string _dst_root,
                    VFSHostPtr _dst_vfs,
-                   std::string _password);
+                   std::string _password,
+                   CompressionFormat _format = CompressionFormat::Zip);
     ~CompressionJob();
 
     const std::string &TargetArchivePath() const;
@@ -68,6 +76,17 @@ private:
                   const base::chained_strings::node *_prefix,
                   Source &_ctx);
     bool BuildArchive();
+    bool BuildArchiveWithLibarchive();
+    bool BuildArchiveWithParallelZipWriter();
+    bool SetupLibarchiveFormat();
+    bool WriteHeader(const std::string &_relative_path,
+                     const VFSStat &_stat,
+                     std::string_view _symlink,
+                     std::span<const std::byte> _metadata);
+    bool WriteData(std::span<const std::byte> _data);
+    bool FinishData();
+    bool WriteMetadata(const std::string &_relative_path, const VFSStat &_stat, std::span<const std::byte> _metadata);
+    void ReportTargetWriteError();
     void ProcessItems();
     void ProcessItem(const base::chained_strings::node &_node, int _index);
     StepResult ProcessDirectoryItem(int _index, const std::string &_relative_path, const std::string &_full_path);
@@ -76,6 +95,8 @@ private:
 
     std::string FindSuitableFilename(const std::string &_proposed_arcname) const;
     bool IsEncrypted() const noexcept;
+    bool IsTar() const noexcept;
+    static int CompressionThreads() noexcept;
 
     static ssize_t WriteCallback(struct archive *_archive, void *_client_data, const void *_buffer, size_t _length);
 
@@ -84,9 +105,11 @@ private:
     VFSHostPtr m_DstVFS;
     std::string m_TargetArchivePath;
     std::string m_Password;
+    CompressionFormat m_Format;
 
     struct ::archive *m_Archive = nullptr;
     std::shared_ptr<VFSFile> m_TargetFile;
+    std::unique_ptr<compression::ParallelZipWriter> m_ZipWriter;
 
     std::unique_ptr<const Source> m_Source;
 };
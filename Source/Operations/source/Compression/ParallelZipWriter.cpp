@@ -0,0 +1,506 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "ParallelZipWriter.h"
+#include <Base/algo.h>
+#include <algorithm>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <zlib.h>
+
+namespace nc::ops::compression {
+
+static constexpr uint32_t g_LocalHeaderSignature = 0x04034b50;
+static constexpr uint32_t g_DataDescriptorSignature = 0x08074b50;
+static constexpr uint32_t g_CentralHeaderSignature = 0x02014b50;
+static constexpr uint32_t g_Zip64EndOfCentralSignature = 0x06064b50;
+static constexpr uint32_t g_Zip64EndOfCentralLocatorSignature = 0x07064b50;
+static constexpr uint32_t g_EndOfCentralSignature = 0x06054b50;
+static constexpr uint16_t g_Zip64ExtraId = 0x0001;
+static constexpr uint16_t g_ExtendedTimestampExtraId = 0x5455;
+static constexpr uint16_t g_InfoZipUnixExtraId = 0x7875;
+static constexpr uint16_t g_MethodStore = 0;
+static constexpr uint16_t g_MethodDeflate = 8;
+static constexpr uint16_t g_FlagDataDescriptor = 1 << 3;
+static constexpr uint16_t g_FlagUTF8 = 1 << 11;
+static constexpr uint16_t g_VersionDefault = 20;
+static constexpr uint16_t g_VersionZip64 = 45;
+static constexpr uint16_t g_MadeByUnix = 3 << 8;
+static constexpr uint32_t g_MSDOSDirectoryAttribute = 0x10;
+static constexpr uint32_t g_Max32 = std::numeric_limits<uint32_t>::max();
+static constexpr uint16_t g_Max16 = std::numeric_limits<uint16_t>::max();
+static constexpr size_t g_DictionarySize = 32 * 1024;
+
+// Files of this size or larger get Zip64 local headers, leaving a margin for the deflate overhead
+static constexpr uint64_t g_Zip64Threshold = g_Max32 - (g_Max32 / 64);
+
+static void Put16(std::vector<std::byte> &_to, uint16_t _v)
+{
+    _to.push_back(std::byte(_v & 0xFF));
+    _to.push_back(std::byte(_v >> 8));
+}
+
+static void Put32(std::vector<std::byte> &_to, uint32_t _v)
+{
+    Put16(_to, static_cast<uint16_t>(_v & 0xFFFF));
+    Put16(_to, static_cast<uint16_t>(_v >> 16));
+}
+
+static void Put64(std::vector<std::byte> &_to, uint64_t _v)
+{
+    Put32(_to, static_cast<uint32_t>(_v & 0xFFFFFFFF));
+    Put32(_to, static_cast<uint32_t>(_v >> 32));
+}
+
+static void PutBytes(std::vector<std::byte> &_to, std::string_view _bytes)
+{
+    const auto p = reinterpret_cast<const std::byte *>(_bytes.data());
+    _to.insert(_to.end(), p, p + _bytes.size());
+}
+
+static uint32_t Clamp32(uint64_t _v) noexcept
+{
+    return static_cast<uint32_t>(std::min<uint64_t>(_v, g_Max32));
+}
+
+static std::pair<uint16_t, uint16_t> ToDOSTimeAndDate(time_t _time) noexcept
+{
+    struct tm tm;
+    if( localtime_r(&_time, &tm) == nullptr || tm.tm_year < 80 )
+        return {0, (1 << 5) | 1}; // 1980-01-01 00:00:00
+    const auto time = (tm.tm_hour << 11) | (tm.tm_min << 5) | (tm.tm_sec / 2);
+    const auto date = ((std::min(tm.tm_year, 207) - 80) << 9) | ((tm.tm_mon + 1) << 5) | tm.tm_mday;
+    return {static_cast<uint16_t>(time), static_cast<uint16_t>(date)};
+}
+
+static uint32_t CRC32(uint32_t _crc, std::span<const std::byte> _bytes) noexcept
+{
+    return static_cast<uint32_t>(
+        crc32_z(_crc, reinterpret_cast<const Bytef *>(_bytes.data()), static_cast<z_size_t>(_bytes.size())));
+}
+
+// Extended timestamp with the modification time + Info-ZIP Unix uid/gid, the same in local and central headers
+static void PutUnixExtras(std::vector<std::byte> &_to, uint32_t _mtime, uint32_t _uid, uint32_t _gid)
+{
+    Put16(_to, g_ExtendedTimestampExtraId);
+    Put16(_to, 5);
+    _to.push_back(std::byte{1}); // mtime is present
+    Put32(_to, _mtime);
+
+    Put16(_to, g_InfoZipUnixExtraId);
+    Put16(_to, 11);
+    _to.push_back(std::byte{1}); // version
+    _to.push_back(std::byte{4}); // uid size
+    Put32(_to, _uid);
+    _to.push_back(std::byte{4}); // gid size
+    Put32(_to, _gid);
+}
+
+static constexpr uint16_t g_UnixExtrasSize = (4 + 5) + (4 + 11);
+
+ParallelZipWriter::ParallelZipWriter(Sink _sink, int _threads, size_t _chunk_size)
+    : m_Sink(std::move(_sink)), m_Threads(std::max(_threads, 1)), m_ChunkSize(std::max(_chunk_size, g_DictionarySize)),
+      m_MaxPendingChunks(static_cast<size_t>(m_Threads) * 2)
+{
+    if( !m_Sink )
+        throw std::invalid_argument("ParallelZipWriter: the sink can't be empty");
+}
+
+ParallelZipWriter::~ParallelZipWriter()
+{
+    m_Workers.Wait();
+}
+
+bool ParallelZipWriter::Failed() const noexcept
+{
+    return m_Failed;
+}
+
+int ParallelZipWriter::AddCentralEntry(const Entry &_entry, uint16_t _method, uint16_t _flags)
+{
+    CentralEntry ce;
+    ce.path = _entry.path;
+    ce.method = _method;
+    ce.flags = static_cast<uint16_t>(_flags | g_FlagUTF8);
+    ce.external_attributes = (uint32_t(_entry.mode) << 16) | (S_ISDIR(_entry.mode) ? g_MSDOSDirectoryAttribute : 0);
+    ce.mtime = static_cast<uint32_t>(std::max(_entry.mtime, time_t(0)));
+    ce.uid = _entry.uid;
+    ce.gid = _entry.gid;
+    std::tie(ce.dos_time, ce.dos_date) = ToDOSTimeAndDate(_entry.mtime);
+    m_Central.emplace_back(std::move(ce));
+    return static_cast<int>(m_Central.size() - 1);
+}
+
+std::vector<std::byte> ParallelZipWriter::BuildLocalHeader(const CentralEntry &_entry, bool _zip64) const
+{
+    const bool descriptor = _entry.flags & g_FlagDataDescriptor;
+    std::vector<std::byte> header;
+    header.reserve(30 + _entry.path.size() + g_UnixExtrasSize + 20);
+    Put32(header, g_LocalHeaderSignature);
+    Put16(header, _zip64 ? g_VersionZip64 : g_VersionDefault);
+    Put16(header, _entry.flags);
+    Put16(header, _entry.method);
+    Put16(header, _entry.dos_time);
+    Put16(header, _entry.dos_date);
+    Put32(header, descriptor ? 0 : _entry.crc);
+    Put32(header, descriptor ? (_zip64 ? g_Max32 : 0) : Clamp32(_entry.compressed_size));
+    Put32(header, descriptor ? (_zip64 ? g_Max32 : 0) : Clamp32(_entry.uncompressed_size));
+    Put16(header, static_cast<uint16_t>(_entry.path.size()));
+    Put16(header, g_UnixExtrasSize + (_zip64 ? 20 : 0));
+    PutBytes(header, _entry.path);
+    if( _zip64 ) {
+        // the actual sizes are in the data descriptor
+        Put16(header, g_Zip64ExtraId);
+        Put16(header, 16);
+        Put64(header, 0);
+        Put64(header, 0);
+    }
+    PutUnixExtras(header, _entry.mtime, _entry.uid, _entry.gid);
+    return header;
+}
+
+bool ParallelZipWriter::AddStored(const Entry &_entry, std::span<const std::byte> _content)
+{
+    if( m_Failed || m_Finished || m_InFile || _entry.path.size() > g_Max16 )
+        return false;
+
+    const int index = AddCentralEntry(_entry, g_MethodStore, 0);
+    auto &ce = m_Central[index];
+    ce.crc = CRC32(0, _content);
+    ce.compressed_size = ce.uncompressed_size = _content.size();
+
+    Record record;
+    record.kind = Record::Kind::Bytes;
+    record.central_index = index;
+    record.bytes = BuildLocalHeader(ce, false);
+    record.bytes.insert(record.bytes.end(), _content.begin(), _content.end());
+    m_Records.emplace_back(std::move(record));
+
+    Drain(m_MaxPendingChunks);
+    return !m_Failed;
+}
+
+bool ParallelZipWriter::AddDirectory(const Entry &_entry)
+{
+    return AddStored(_entry, {});
+}
+
+bool ParallelZipWriter::AddSymlink(const Entry &_entry, std::string_view _target)
+{
+    return AddStored(_entry, {reinterpret_cast<const std::byte *>(_target.data()), _target.size()});
+}
+
+bool ParallelZipWriter::AddFile(const Entry &_entry, std::span<const std::byte> _content)
+{
+    return AddStored(_entry, _content);
+}
+
+bool ParallelZipWriter::BeginFile(const Entry &_entry)
+{
+    if( m_Failed || m_Finished || m_InFile || _entry.path.size() > g_Max16 )
+        return false;
+
+    const int index = AddCentralEntry(_entry, g_MethodDeflate, g_FlagDataDescriptor);
+    auto &ce = m_Central[index];
+    ce.zip64_descriptor = _entry.size >= g_Zip64Threshold;
+
+    Record record;
+    record.kind = Record::Kind::Bytes;
+    record.central_index = index;
+    record.bytes = BuildLocalHeader(ce, ce.zip64_descriptor);
+    m_Records.emplace_back(std::move(record));
+
+    m_InFile = true;
+    m_Filling = std::make_unique<Chunk>();
+    m_Filling->input.reserve(m_ChunkSize);
+    m_NextDictionary.clear();
+    return true;
+}
+
+bool ParallelZipWriter::WriteFile(std::span<const std::byte> _data)
+{
+    if( m_Failed || !m_InFile )
+        return false;
+
+    while( !_data.empty() ) {
+        const size_t portion = std::min(_data.size(), m_ChunkSize - m_Filling->input.size());
+        m_Filling->input.insert(m_Filling->input.end(), _data.begin(), _data.begin() + portion);
+        _data = _data.subspan(portion);
+        if( m_Filling->input.size() == m_ChunkSize ) {
+            SubmitChunk(false);
+            m_Filling = std::make_unique<Chunk>();
+            m_Filling->input.reserve(m_ChunkSize);
+        }
+    }
+    return !m_Failed;
+}
+
+bool ParallelZipWriter::EndFile()
+{
+    if( !m_InFile )
+        return false;
+    m_InFile = false;
+
+    SubmitChunk(true);
+    m_Filling.reset();
+
+    Record record;
+    record.kind = Record::Kind::FileEnd;
+    record.central_index = static_cast<int>(m_Central.size() - 1);
+    m_Records.emplace_back(std::move(record));
+
+    Drain(m_MaxPendingChunks);
+    return !m_Failed;
+}
+
+void ParallelZipWriter::SubmitChunk(bool _last)
+{
+    auto chunk = std::move(m_Filling);
+    chunk->last = _last;
+    chunk->dictionary = std::move(m_NextDictionary);
+    m_NextDictionary.clear();
+    if( !_last ) {
+        const size_t dict_size = std::min(chunk->input.size(), g_DictionarySize);
+        m_NextDictionary.assign(chunk->input.end() - dict_size, chunk->input.end());
+    }
+
+    Chunk *const raw = chunk.get();
+    Record record;
+    record.kind = Record::Kind::Chunk;
+    record.chunk = std::move(chunk);
+    m_Records.emplace_back(std::move(record));
+    ++m_PendingChunks;
+
+    if( m_Threads == 1 ) {
+        Compress(*raw);
+    }
+    else {
+        m_Workers.Run([this, raw] { Compress(*raw); });
+    }
+
+    // don't let the amount of chunks in flight grow beyond what the workers can chew
+    Drain(m_MaxPendingChunks);
+}
+
+void ParallelZipWriter::Compress(Chunk &_chunk)
+{
+    const auto report = [&](bool _failed) {
+        {
+            const auto lock = std::lock_guard{m_Lock};
+            _chunk.done = true;
+            _chunk.failed = _failed;
+        }
+        m_ChunkDone.notify_all();
+    };
+
+    _chunk.crc = CRC32(0, _chunk.input);
+    _chunk.input_size = _chunk.input.size();
+
+    z_stream zs = {};
+    if( deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK ) {
+        report(true);
+        return;
+    }
+    const auto cleanup = at_scope_end([&] { deflateEnd(&zs); });
+
+    if( !_chunk.dictionary.empty() &&
+        deflateSetDictionary(&zs,
+                             reinterpret_cast<const Bytef *>(_chunk.dictionary.data()),
+                             static_cast<uInt>(_chunk.dictionary.size())) != Z_OK ) {
+        report(true);
+        return;
+    }
+
+    // a sync flush adds an empty stored block on top of what deflateBound() accounts for
+    _chunk.output.resize(deflateBound(&zs, static_cast<uLong>(_chunk.input.size())) + 16);
+    zs.next_in = reinterpret_cast<Bytef *>(_chunk.input.data());
+    zs.avail_in = static_cast<uInt>(_chunk.input.size());
+    while( true ) {
+        zs.next_out = reinterpret_cast<Bytef *>(_chunk.output.data()) + zs.total_out;
+        zs.avail_out = static_cast<uInt>(_chunk.output.size() - zs.total_out);
+        const int rc = deflate(&zs, _chunk.last ? Z_FINISH : Z_SYNC_FLUSH);
+        if( rc == Z_STREAM_ERROR ) {
+            report(true);
+            return;
+        }
+        if( _chunk.last ? rc == Z_STREAM_END : (zs.avail_in == 0 && zs.avail_out != 0) )
+            break;
+        if( zs.avail_out == 0 )
+            _chunk.output.resize(_chunk.output.size() * 2);
+    }
+    _chunk.output.resize(zs.total_out);
+    _chunk.input = {};
+    _chunk.dictionary = {};
+    report(false);
+}
+
+void ParallelZipWriter::Drain(size_t _max_pending_chunks)
+{
+    while( !m_Records.empty() ) {
+        auto &front = m_Records.front();
+        if( front.kind == Record::Kind::Chunk ) {
+            auto lock = std::unique_lock{m_Lock};
+            if( !front.chunk->done ) {
+                if( m_PendingChunks <= _max_pending_chunks )
+                    return;
+                m_ChunkDone.wait(lock, [&] { return front.chunk->done; });
+            }
+        }
+        Emit(front);
+        m_Records.pop_front();
+    }
+}
+
+void ParallelZipWriter::Emit(Record &_record)
+{
+    switch( _record.kind ) {
+        case Record::Kind::Bytes:
+            if( _record.central_index >= 0 )
+                m_Central[_record.central_index].offset = m_Offset;
+            Write(_record.bytes);
+            if( _record.central_index >= 0 && m_Central[_record.central_index].method == g_MethodDeflate )
+                m_Current = {.central_index = _record.central_index};
+            break;
+        case Record::Kind::Chunk:
+            --m_PendingChunks;
+            if( _record.chunk->failed ) {
+                m_Failed = true;
+                break;
+            }
+            Write(_record.chunk->output);
+            m_Current.crc = static_cast<uint32_t>(crc32_combine(
+                m_Current.crc, _record.chunk->crc, static_cast<z_off_t>(_record.chunk->input_size)));
+            m_Current.compressed_size += _record.chunk->output.size();
+            m_Current.uncompressed_size += _record.chunk->input_size;
+            break;
+        case Record::Kind::FileEnd: {
+            auto &ce = m_Central[_record.central_index];
+            ce.crc = m_Current.crc;
+            ce.compressed_size = m_Current.compressed_size;
+            ce.uncompressed_size = m_Current.uncompressed_size;
+            if( !ce.zip64_descriptor && (ce.compressed_size >= g_Max32 || ce.uncompressed_size >= g_Max32) ) {
+                m_Failed = true; // the file has grown beyond what the local header has promised
+                break;
+            }
+            std::vector<std::byte> descriptor;
+            Put32(descriptor, g_DataDescriptorSignature);
+            Put32(descriptor, ce.crc);
+            if( ce.zip64_descriptor ) {
+                Put64(descriptor, ce.compressed_size);
+                Put64(descriptor, ce.uncompressed_size);
+            }
+            else {
+                Put32(descriptor, static_cast<uint32_t>(ce.compressed_size));
+                Put32(descriptor, static_cast<uint32_t>(ce.uncompressed_size));
+            }
+            Write(descriptor);
+            m_Current = {};
+            break;
+        }
+    }
+}
+
+bool ParallelZipWriter::Write(std::span<const std::byte> _bytes)
+{
+    if( m_Failed )
+        return false;
+    if( !_bytes.empty() && !m_Sink(_bytes.data(), _bytes.size()) ) {
+        m_Failed = true;
+        return false;
+    }
+    m_Offset += _bytes.size();
+    return true;
+}
+
+bool ParallelZipWriter::Finish()
+{
+    if( m_Finished )
+        return !m_Failed;
+    if( m_InFile )
+        EndFile();
+    m_Finished = true;
+    Drain(0);
+    m_Workers.Wait();
+    if( !m_Failed )
+        WriteCentralDirectory();
+    return !m_Failed;
+}
+
+void ParallelZipWriter::WriteCentralDirectory()
+{
+    const uint64_t central_offset = m_Offset;
+    std::vector<std::byte> buffer;
+    for( const auto &ce : m_Central ) {
+        buffer.clear();
+        const bool zip64_usize = ce.uncompressed_size >= g_Max32;
+        const bool zip64_csize = ce.compressed_size >= g_Max32;
+        const bool zip64_offset = ce.offset >= g_Max32;
+        const uint16_t zip64_size = 8 * (zip64_usize + zip64_csize + zip64_offset);
+        const bool zip64 = zip64_size != 0 || ce.zip64_descriptor;
+
+        Put32(buffer, g_CentralHeaderSignature);
+        Put16(buffer, g_MadeByUnix | (zip64 ? g_VersionZip64 : g_VersionDefault));
+        Put16(buffer, zip64 ? g_VersionZip64 : g_VersionDefault);
+        Put16(buffer, ce.flags);
+        Put16(buffer, ce.method);
+        Put16(buffer, ce.dos_time);
+        Put16(buffer, ce.dos_date);
+        Put32(buffer, ce.crc);
+        Put32(buffer, Clamp32(ce.compressed_size));
+        Put32(buffer, Clamp32(ce.uncompressed_size));
+        Put16(buffer, static_cast<uint16_t>(ce.path.size()));
+        Put16(buffer, g_UnixExtrasSize + (zip64_size ? 4 + zip64_size : 0));
+        Put16(buffer, 0); // comment length
+        Put16(buffer, 0); // disk number start
+        Put16(buffer, 0); // internal attributes
+        Put32(buffer, ce.external_attributes);
+        Put32(buffer, Clamp32(ce.offset));
+        PutBytes(buffer, ce.path);
+        if( zip64_size ) {
+            Put16(buffer, g_Zip64ExtraId);
+            Put16(buffer, zip64_size);
+            if( zip64_usize )
+                Put64(buffer, ce.uncompressed_size);
+            if( zip64_csize )
+                Put64(buffer, ce.compressed_size);
+            if( zip64_offset )
+                Put64(buffer, ce.offset);
+        }
+        PutUnixExtras(buffer, ce.mtime, ce.uid, ce.gid);
+        if( !Write(buffer) )
+            return;
+    }
+
+    const uint64_t central_size = m_Offset - central_offset;
+    const uint64_t entries = m_Central.size();
+    buffer.clear();
+    if( entries >= g_Max16 || central_offset >= g_Max32 || central_size >= g_Max32 ) {
+        const uint64_t zip64_end_offset = m_Offset;
+        Put32(buffer, g_Zip64EndOfCentralSignature);
+        Put64(buffer, 44); // the size of the rest of this record
+        Put16(buffer, g_MadeByUnix | g_VersionZip64);
+        Put16(buffer, g_VersionZip64);
+        Put32(buffer, 0); // this disk
+        Put32(buffer, 0); // disk with the central directory
+        Put64(buffer, entries);
+        Put64(buffer, entries);
+        Put64(buffer, central_size);
+        Put64(buffer, central_offset);
+
+        Put32(buffer, g_Zip64EndOfCentralLocatorSignature);
+        Put32(buffer, 0); // disk with the zip64 end of central directory
+        Put64(buffer, zip64_end_offset);
+        Put32(buffer, 1); // total disks
+    }
+    Put32(buffer, g_EndOfCentralSignature);
+    Put16(buffer, 0); // this disk
+    Put16(buffer, 0); // disk with the central directory
+    Put16(buffer, static_cast<uint16_t>(std::min<uint64_t>(entries, g_Max16)));
+    Put16(buffer, static_cast<uint16_t>(std::min<uint64_t>(entries, g_Max16)));
+    Put32(buffer, Clamp32(central_size));
+    Put32(buffer, Clamp32(central_offset));
+    Put16(buffer, 0); // comment length
+    Write(buffer);
+}
+
+} // namespace nc::ops::compression
@@ -0,0 +1,144 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <Base/DispatchGroup.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace nc::ops::compression {
+
+// Writes a Zip archive while deflating the content of the files on multiple threads.
+// The data of a file is cut into chunks which are compressed independently - each chunk is primed with the tail of the
+// previous one - and the results are written out strictly in the original order, pretty much like pigz does.
+// The archive is written sequentially without seeking back, hence the checksums and the sizes of the deflated files
+// follow their data in data descriptors. Zip64 extensions are used only when necessary.
+// Not thread-safe, all calls are expected to be made from the same thread.
+class ParallelZipWriter
+{
+public:
+    // Receives the bytes of the archive in order. Returns false on failure.
+    using Sink = std::function<bool(const void *_data, size_t _size)>;
+
+    struct Entry {
+        std::string path; // relative path inside the archive, directories end with a slash
+        mode_t mode = 0;
+        time_t mtime = 0;
+        uid_t uid = 0;
+        gid_t gid = 0;
+        uint64_t size = 0; // an expected size of a file, used to decide whether Zip64 is needed
+    };
+
+    static constexpr size_t g_DefaultChunkSize = size_t(1) * 1024 * 1024;
+
+    // _threads == 1 makes the writer compress synchronously on the calling thread.
+    ParallelZipWriter(Sink _sink, int _threads, size_t _chunk_size = g_DefaultChunkSize);
+    ParallelZipWriter(const ParallelZipWriter &) = delete;
+    ~ParallelZipWriter();
+    ParallelZipWriter &operator=(const ParallelZipWriter &) = delete;
+
+    bool AddDirectory(const Entry &_entry);
+    bool AddSymlink(const Entry &_entry, std::string_view _target);
+
+    // Stores a small file whose content is already in memory, e.g. AppleDouble metadata.
+    bool AddFile(const Entry &_entry, std::span<const std::byte> _content);
+
+    // Streams a file which gets deflated: BeginFile(), any amount of WriteFile(), EndFile().
+    bool BeginFile(const Entry &_entry);
+    bool WriteFile(std::span<const std::byte> _data);
+    bool EndFile();
+
+    // Waits for the pending chunks and writes out the central directory. Nothing can be added afterwards.
+    bool Finish();
+
+    bool Failed() const noexcept;
+
+private:
+    struct Chunk {
+        std::vector<std::byte> input;
+        std::vector<std::byte> dictionary;
+        std::vector<std::byte> output;
+        uint64_t input_size = 0;
+        uint32_t crc = 0;
+        bool last = false;
+        bool done = false;   // guarded by m_Lock
+        bool failed = false; // guarded by m_Lock
+    };
+
+    struct Record {
+        enum class Kind : uint8_t {
+            Bytes,  // ready to be written as is
+            Chunk,  // deflated data of the current file
+            FileEnd // the data descriptor of the current file
+        };
+        Kind kind = Kind::Bytes;
+        int central_index = -1; // for Bytes: set the offset of this central entry before writing
+        std::vector<std::byte> bytes;
+        std::unique_ptr<Chunk> chunk;
+    };
+
+    struct CentralEntry {
+        std::string path;
+        uint64_t offset = 0;
+        uint64_t compressed_size = 0;
+        uint64_t uncompressed_size = 0;
+        uint32_t crc = 0;
+        uint32_t external_attributes = 0;
+        uint32_t mtime = 0;
+        uint32_t uid = 0;
+        uint32_t gid = 0;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint16_t dos_time = 0;
+        uint16_t dos_date = 0;
+        bool zip64_descriptor = false;
+    };
+
+    struct CurrentFile {
+        int central_index = -1;
+        uint32_t crc = 0;
+        uint64_t compressed_size = 0;
+        uint64_t uncompressed_size = 0;
+    };
+
+    bool AddStored(const Entry &_entry, std::span<const std::byte> _content);
+    int AddCentralEntry(const Entry &_entry, uint16_t _method, uint16_t _flags);
+    std::vector<std::byte> BuildLocalHeader(const CentralEntry &_entry, bool _zip64) const;
+    void SubmitChunk(bool _last);
+    void Compress(Chunk &_chunk);
+    void Drain(size_t _max_pending_chunks);
+    void Emit(Record &_record);
+    bool Write(std::span<const std::byte> _bytes);
+    void WriteCentralDirectory();
+
+    Sink m_Sink;
+    const int m_Threads;
+    const size_t m_ChunkSize;
+    const size_t m_MaxPendingChunks;
+    uint64_t m_Offset = 0;
+    bool m_Failed = false;
+    bool m_Finished = false;
+    bool m_InFile = false;
+
+    std::vector<CentralEntry> m_Central;
+    std::deque<Record> m_Records;
+    size_t m_PendingChunks = 0;
+    std::unique_ptr<Chunk> m_Filling;
+    std::vector<std::byte> m_NextDictionary;
+    CurrentFile m_Current;
+
+    std::mutex m_Lock;
+    std::condition_variable m_ChunkDone;
+    base::DispatchGroup m_Workers;
+};
+
+} // namespace nc::ops::compression
@@ -1,21 +1,26 @@
-// Copyright (C) 2017-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "ChecksumExpectation.h"
 
 #include <algorithm>
+#include <span>
+#include <stdexcept>
 
 namespace nc::ops::copying {
 
-ChecksumExpectation::ChecksumExpectation(int _source_ind, std::string _destination, const std::vector<uint8_t> &_md5)
-    : destination_path(std::move(_destination)), original_item(_source_ind)
+ChecksumExpectation::ChecksumExpectation(int _source_ind,
+                                         std::string _destination,
+                                         const std::vector<uint8_t> &_checksum)
+    : destination_path(std::move(_destination)), original_item(_source_ind),
+      checksum_size(static_cast<uint8_t>(_checksum.size())), checksum{}
 {
-    if( _md5.size() != 16 )
-        throw std::invalid_argument("ChecksumExpectation: _md5 should be 16 bytes long!");
-    std::ranges::copy(_md5, std::begin(md5.buf));
+    if( _checksum.empty() || _checksum.size() > max_checksum_size )
+        throw std::invalid_argument("ChecksumExpectation: _checksum should be 1 to 32 bytes long!");
+    std::ranges::copy(_checksum, checksum.begin());
 }
 
 bool operator==(const ChecksumExpectation &_lhs, const std::vector<uint8_t> &_rhs) noexcept
 {
-    return _rhs.size() == 16 && std::equal(std::begin(_rhs), std::end(_rhs), std::begin(_lhs.md5.buf));
+    return _rhs.size() == _lhs.checksum_size && std::ranges::equal(_rhs, std::span{_lhs.checksum.data(), _rhs.size()});
 }
 
 bool operator==(const std::vector<uint8_t> &_rhs, const ChecksumExpectation &_lhs) noexcept
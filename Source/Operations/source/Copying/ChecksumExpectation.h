@@ -1,6 +1,7 @@
-// Copyright (C) 2017-2018 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -8,12 +9,13 @@
 namespace nc::ops::copying {
 
 struct ChecksumExpectation {
-    ChecksumExpectation(int _source_ind, std::string _destination, const std::vector<uint8_t> &_md5);
+    static constexpr size_t max_checksum_size = 32;
+
+    ChecksumExpectation(int _source_ind, std::string _destination, const std::vector<uint8_t> &_checksum);
     std::string destination_path;
     int original_item;
-    struct {
-        uint8_t buf[16];
-    } md5;
+    uint8_t checksum_size;
+    std::array<uint8_t, max_checksum_size> checksum;
 };
 
 bool operator==(const ChecksumExpectation &_lhs, const std::vector<uint8_t> &_rhs) noexcept;
@@ -3,6 +3,7 @@
 #include "../Statistics.h"
 #include "Helpers.h"
 #include "NativeFSHelpers.h"
+#include <Base/ParallelTreeWalker.h>
 #include <Base/Hash.h>
 #include <Base/algo.h>
 #include <RoutedIO/RoutedIO.h>
@@ -10,9 +11,11 @@
 #include <Utility/StringExtras.h>
 #include <VFS/Native.h>
 #include <algorithm>
+#include <array>
 #include <fmt/format.h>
 #include <iostream>
 #include <ranges>
+#include <sys/clonefile.h>
 #include <sys/mount.h>
 #include <sys/param.h>
 #include <sys/stat.h>
@@ -31,6 +34,12 @@ static constexpr mode_t g_NewDirectoryMode = S_IRUSR | S_IXUSR | S_IWUSR | // Us
 // A bitmask of flags that have a meaning when passed to chmod()
 static constexpr mode_t g_ChModMask = S_IRWXU | S_IRWXG | S_IRWXO | S_ISUID | S_ISGID | S_ISVTX;
 
+// A hash used to verify the copied files, the verification only detects corruption and doesn't need a crypto hash
+static constexpr base::Hash::Mode g_VerificationHashMode = base::Hash::XXH3_128;
+
+// Guards temporary changes of the process's umask
+[[clang::no_destroy]] static std::mutex g_UmaskLock;
+
 // return true if _1st is older than _2nd
 static bool EntryIsOlder(const struct stat &_1st, const struct stat &_2nd);
 static bool EntryIsOlder(const VFSStat &_1st, const VFSStat &_2nd);
@@ -138,17 +147,31 @@ void CopyingJob::ProcessItems()
 
     Statistics().CommitEstimated(Statistics::SourceType::Bytes, m_SourceItems.TotalRegBytes());
 
-    for( int index = 0, index_end = m_SourceItems.ItemsAmount(); index != index_end; ++index ) {
-        const auto step_result = ProcessItemNo(index);
+    const int lanes = LanesAmount();
+    if( lanes > 1 || IsVerificationRequired() )
+        SerializeCallbacks();
+    if( IsVerificationRequired() )
+        m_VerificationBuffer = std::make_unique<uint8_t[]>(m_BufferSize);
 
-        // check current item result
-        if( step_result == StepResult::Stop ) {
-            Stop();
-            return;
-        }
-        if( BlockIfPaused(); IsStopped() )
-            return;
+    // make sure that no verification outlives this function regardless of how we leave it
+    const auto wait_for_verification = at_scope_end([&] { m_VerificationQueue.Wait(); });
+
+    const auto step_result = lanes > 1 ? ProcessItemsInLanes() : ProcessItemsSequentially();
+    if( step_result == StepResult::Stop ) {
+        Stop();
+        return;
     }
+    if( BlockIfPaused(); IsStopped() )
+        return;
+
+    // Let the verification catch up with the files copied last
+    if( !m_VerificationQueue.Empty() ) {
+        SetStage(Stage::Verify);
+        m_VerificationQueue.Wait();
+    }
+
+    if( BlockIfPaused(); IsStopped() )
+        return;
 
     // Do a permissions fixup if required afterwards
     ApplyPermissionFixups();
@@ -160,32 +183,150 @@ void CopyingJob::ProcessItems()
     if( BlockIfPaused(); IsStopped() )
         return;
 
-    bool all_matched = true;
-    if( !m_Checksums.empty() ) {
-        SetStage(Stage::Verify);
-        for( auto &item : m_Checksums ) {
-            bool matched = false;
-            auto step_result = VerifyCopiedFile(item, matched);
-            if( step_result != StepResult::Ok || !matched ) {
-                m_OnFileVerificationFailed(item.destination_path, *m_DestinationHost);
-                all_matched = false;
-            }
+    // be sure to all it only if ALL previous steps wre OK.
+    if( m_AllVerified ) {
+        SetStage(Stage::Cleaning);
+        ClearSourceItems();
+    }
+}
+
+// Parallel lanes drive the source and the destination hosts from several threads, which only the native filesystem
+// and the hosts advertising concurrent access can withstand. Otherwise the items are processed one by one.
+int CopyingJob::LanesAmount() const noexcept
+{
+    if( m_Options.parallel_lanes <= 1 )
+        return 1;
+    if( !m_DestinationHost->CanServeConcurrently() )
+        return 1;
+    for( uint16_t i = 0, e = m_SourceItems.HostsAmount(); i != e; ++i )
+        if( !m_SourceItems.Host(i).CanServeConcurrently() )
+            return 1;
+    return m_Options.parallel_lanes;
+}
+
+CopyingJob::StepResult CopyingJob::ProcessItemsSequentially()
+{
+    for( int index = 0, index_end = m_SourceItems.ItemsAmount(); index != index_end; ++index ) {
+        const auto step_result = ProcessItemNo(index, m_MainLane);
+
+        // check current item result
+        if( step_result == StepResult::Stop )
+            return StepResult::Stop;
+        if( BlockIfPaused(); IsStopped() )
+            return StepResult::Stop;
+    }
+    return StepResult::Ok;
+}
+
+// Regular files are handed over to the worker lanes, while everything else is processed in the original order
+// on the job's thread. Since a directory is always placed before its content in the source items DB, it gets
+// created before any of its files are dispatched.
+CopyingJob::StepResult CopyingJob::ProcessItemsInLanes()
+{
+    for( int i = 0, lanes = LanesAmount(); i < lanes; ++i ) {
+        m_WorkerLanes.emplace_back(std::make_unique<IOLane>());
+        m_FreeWorkerLanes.emplace_back(m_WorkerLanes.back().get());
+    }
+
+    // make sure that no lane outlives this function regardless of how we leave it
+    const auto wait_for_lanes = at_scope_end([&] { m_LanesGroup.Wait(); });
+
+    for( int index = 0, index_end = m_SourceItems.ItemsAmount(); index != index_end; ++index ) {
+        if( S_ISREG(m_SourceItems.ItemMode(index)) ) {
+            IOLane *const lane = &AcquireWorkerLane();
+            m_LanesGroup.Run([this, index, lane] {
+                if( ProcessItemNo(index, *lane) == StepResult::Stop )
+                    Stop();
+                ReleaseWorkerLane(*lane);
+            });
         }
+        else if( ProcessItemNo(index, m_MainLane) == StepResult::Stop ) {
+            return StepResult::Stop;
+        }
+
+        if( BlockIfPaused(); IsStopped() )
+            return StepResult::Stop;
     }
 
-    if( BlockIfPaused(); IsStopped() )
-        return;
+    m_LanesGroup.Wait();
+    if( IsStopped() )
+        return StepResult::Stop;
 
-    // be sure to all it only if ALL previous steps wre OK.
-    if( all_matched ) {
-        SetStage(Stage::Cleaning);
-        ClearSourceItems();
+    // bring the results into the same order the sequential processing would produce
+    std::ranges::sort(m_SourceItemsToDelete);
+    return StepResult::Ok;
+}
+
+uint8_t *CopyingJob::IOLane::Buffer(int _index)
+{
+    assert(_index >= 0 && _index < m_MaxIODepth);
+    if( !buffers[_index] )
+        buffers[_index] = std::make_unique<uint8_t[]>(m_BufferSize);
+    return buffers[_index].get();
+}
+
+IOTuner &CopyingJob::IOLane::Tuner(const void *_source, const void *_destination, size_t _initial_block_size)
+{
+    if( tuned_for[0] != _source || tuned_for[1] != _destination ) {
+        tuner.Reset(_initial_block_size);
+        tuned_for[0] = _source;
+        tuned_for[1] = _destination;
+    }
+    return tuner;
+}
+
+CopyingJob::IOLane &CopyingJob::AcquireWorkerLane()
+{
+    auto lock = std::unique_lock{m_FreeWorkerLanesLock};
+    m_FreeWorkerLanesCV.wait(lock, [this] { return !m_FreeWorkerLanes.empty(); });
+    IOLane *const lane = m_FreeWorkerLanes.back();
+    m_FreeWorkerLanes.pop_back();
+    return *lane;
+}
+
+void CopyingJob::ReleaseWorkerLane(IOLane &_lane)
+{
+    {
+        const auto lock = std::lock_guard{m_FreeWorkerLanesLock};
+        m_FreeWorkerLanes.emplace_back(&_lane);
     }
+    m_FreeWorkerLanesCV.notify_one();
+}
+
+template <class R, class... Args>
+static void SerializeCallback(std::function<R(Args...)> &_callback, std::mutex &_lock)
+{
+    _callback = [callback = std::move(_callback), &_lock](Args... _args) -> R {
+        const auto lock = std::lock_guard{_lock};
+        return callback(std::forward<Args>(_args)...);
+    };
 }
 
-CopyingJob::StepResult CopyingJob::ProcessItemNo(int _item_number)
+// Makes sure that at most one callback is in flight at any moment, so the user is asked one question at a time
+// even when several lanes or the background verification run into problems simultaneously.
+void CopyingJob::SerializeCallbacks()
+{
+    SerializeCallback(m_OnCantAccessSourceItem, m_CallbacksLock);
+    SerializeCallback(m_OnCopyDestinationAlreadyExists, m_CallbacksLock);
+    SerializeCallback(m_OnRenameDestinationAlreadyExists, m_CallbacksLock);
+    SerializeCallback(m_OnCantOpenDestinationFile, m_CallbacksLock);
+    SerializeCallback(m_OnSourceFileReadError, m_CallbacksLock);
+    SerializeCallback(m_OnDestinationFileReadError, m_CallbacksLock);
+    SerializeCallback(m_OnDestinationFileWriteError, m_CallbacksLock);
+    SerializeCallback(m_OnCantCreateDestinationRootDir, m_CallbacksLock);
+    SerializeCallback(m_OnCantCreateDestinationDir, m_CallbacksLock);
+    SerializeCallback(m_OnCantDeleteDestinationFile, m_CallbacksLock);
+    SerializeCallback(m_OnCantDeleteSourceItem, m_CallbacksLock);
+    SerializeCallback(m_OnNotADirectory, m_CallbacksLock);
+    SerializeCallback(m_OnCantRenameLockedItem, m_CallbacksLock);
+    SerializeCallback(m_OnCantDeleteLockedItem, m_CallbacksLock);
+    SerializeCallback(m_OnCantOpenLockedItem, m_CallbacksLock);
+    SerializeCallback(m_OnUnlockError, m_CallbacksLock);
+    SerializeCallback(m_OnFileVerificationFailed, m_CallbacksLock);
+}
+
+CopyingJob::StepResult CopyingJob::ProcessItemNo(int _item_number, IOLane &_lane)
 {
-    m_CurrentlyProcessingSourceItemIndex = _item_number;
     auto source_mode = m_SourceItems.ItemMode(_item_number);
     auto &source_host = m_SourceItems.ItemHost(_item_number);
     auto source_size = m_SourceItems.ItemSize(_item_number);
@@ -213,20 +354,19 @@ CopyingJob::StepResult CopyingJob::ProcessItemNo(int _item_number)
         std::optional<base::Hash> hash; // this optional will be filled with the first call of hash_feedback
         auto hash_feedback = [&](const void *_data, unsigned _sz) {
             if( !hash )
-                hash.emplace(base::Hash::MD5);
+                hash.emplace(g_VerificationHashMode);
             hash->Feed(_data, _sz);
         };
 
         std::function<void(const void *_data, unsigned _sz)> data_feedback = nullptr;
-        if( m_Options.verification == ChecksumVerification::Always ||
-            (!m_Options.docopy && m_Options.verification >= ChecksumVerification::WhenMoves) ) {
+        if( IsVerificationRequired() )
             data_feedback = hash_feedback;
-        }
 
         if( source_host.IsNativeFS() && m_IsDestinationHostNative ) { // native -> native ///////////////////////
             // native fs processing
             if( m_Options.docopy ) { // copy
-                step_result = CopyNativeFileToNativeFile(dynamic_cast<vfs::NativeHost &>(source_host),
+                step_result = CopyNativeFileToNativeFile(_lane,
+                                                         dynamic_cast<vfs::NativeHost &>(source_host),
                                                          source_path,
                                                          destination_path,
                                                          data_feedback,
@@ -242,19 +382,21 @@ CopyingJob::StepResult CopyingJob::ProcessItemNo(int _item_number)
                         Statistics().CommitProcessed(Statistics::SourceType::Bytes, source_size);
                 }
                 else { // move
-                    step_result = CopyNativeFileToNativeFile(dynamic_cast<vfs::NativeHost &>(source_host),
+                    step_result = CopyNativeFileToNativeFile(_lane,
+                                                             dynamic_cast<vfs::NativeHost &>(source_host),
                                                              source_path,
                                                              destination_path,
                                                              data_feedback,
                                                              nonexistent_dst_req_handler);
                     if( step_result == StepResult::Ok )
-                        m_SourceItemsToDelete.emplace_back(_item_number); // mark source file for deletion
+                        MarkSourceItemForDeletion(_item_number);
                 }
             }
         }
         else if( m_IsDestinationHostNative ) { // vfs -> native
                                                // ///////////////////////////////////////////////
-            step_result = CopyVFSFileToNativeFile(source_host,
+            step_result = CopyVFSFileToNativeFile(_lane,
+                                                  source_host,
                                                   source_path,
                                                   dynamic_cast<vfs::NativeHost &>(*m_DestinationHost),
                                                   destination_path,
@@ -262,14 +404,14 @@ CopyingJob::StepResult CopyingJob::ProcessItemNo(int _item_number)
                                                   nonexistent_dst_req_handler);
             if( !m_Options.docopy ) { // move
                 if( step_result == StepResult::Ok )
-                    m_SourceItemsToDelete.emplace_back(_item_number); // mark source file for deletion
+                    MarkSourceItemForDeletion(_item_number);
             }
         }
         else {                       // vfs -> vfs
                                      // /////////////////////////////////////////////////////////////////////////////
             if( m_Options.docopy ) { // copy
                 step_result = CopyVFSFileToVFSFile(
-                    source_host, source_path, destination_path, data_feedback, nonexistent_dst_req_handler);
+                    _lane, source_host, source_path, destination_path, data_feedback, nonexistent_dst_req_handler);
             }
             else {                                              // move
                 if( &source_host == m_DestinationHost.get() ) { // rename
@@ -281,25 +423,26 @@ CopyingJob::StepResult CopyingJob::ProcessItemNo(int _item_number)
                 }
                 else { // move
                     step_result = CopyVFSFileToVFSFile(
-                        source_host, source_path, destination_path, data_feedback, nonexistent_dst_req_handler);
+                        _lane, source_host, source_path, destination_path, data_feedback, nonexistent_dst_req_handler);
                     if( step_result == StepResult::Ok )
-                        m_SourceItemsToDelete.emplace_back(_item_number); // mark source file for deletion
+                        MarkSourceItemForDeletion(_item_number);
                 }
             }
         }
 
-        // check step result?
-        if( hash )
-            m_Checksums.emplace_back(_item_number, destination_path, hash->Final());
+        if( hash && step_result == StepResult::Ok )
+            ScheduleVerification(ChecksumExpectation(_item_number, destination_path, hash->Final()));
     }
     else if( S_ISDIR(source_mode) )
         step_result = ProcessDirectoryItem(source_host, source_path, _item_number, destination_path);
     else if( S_ISLNK(source_mode) )
-        step_result = ProcessSymlinkItem(source_host, source_path, destination_path, nonexistent_dst_req_handler);
+        step_result = ProcessSymlinkItem(
+            source_host, source_path, _item_number, destination_path, nonexistent_dst_req_handler);
 
     if( step_result == StepResult::Ok || step_result == StepResult::Skipped ) {
         const ItemStatus status = step_result == StepResult::Ok ? ItemStatus::Processed : ItemStatus::Skipped;
         const ItemStateReport report{.host = source_host, .path = std::string_view(source_path), .status = status};
+        const auto lock = std::lock_guard{m_ItemsAftermathLock};
         TellItemReport(report);
     }
 
@@ -326,14 +469,14 @@ CopyingJob::StepResult CopyingJob::ProcessDirectoryItem(VFSHost &_source_host,
                 result = rename_result.first;
                 if( result == StepResult::Ok && rename_result.second == SourceItemAftermath::NeedsToBeDeleted ) {
                     // in some complicated case rename can fall back into "copy + delete source"
-                    m_SourceItemsToDelete.emplace_back(_source_index);
+                    MarkSourceItemForDeletion(_source_index);
                 }
             }
             else { // move
                 result = CopyNativeDirectoryToNativeDirectory(
                     dynamic_cast<vfs::NativeHost &>(*m_DestinationHost), _source_path, _destination_path);
                 if( result == StepResult::Ok ) {
-                    m_SourceItemsToDelete.emplace_back(_source_index);
+                    MarkSourceItemForDeletion(_source_index);
                 }
             }
         }
@@ -342,7 +485,7 @@ CopyingJob::StepResult CopyingJob::ProcessDirectoryItem(VFSHost &_source_host,
         result = CopyVFSDirectoryToNativeDirectory(
             _source_host, _source_path, dynamic_cast<vfs::NativeHost &>(*m_DestinationHost), _destination_path);
         if( !m_Options.docopy && result == StepResult::Ok ) {
-            m_SourceItemsToDelete.emplace_back(_source_index);
+            MarkSourceItemForDeletion(_source_index);
         }
     }
     else {                       // vfs -> vfs
@@ -356,14 +499,14 @@ CopyingJob::StepResult CopyingJob::ProcessDirectoryItem(VFSHost &_source_host,
                 result = rename_result.first;
                 if( result == StepResult::Ok && rename_result.second == SourceItemAftermath::NeedsToBeDeleted ) {
                     // in some complicated case rename can fall back into "copy + delete source"
-                    m_SourceItemsToDelete.emplace_back(_source_index);
+                    MarkSourceItemForDeletion(_source_index);
                 }
             }
             else {
                 result = CopyVFSDirectoryToVFSDirectory(_source_host, _source_path, _destination_path);
                 if( !m_Options.docopy && result == StepResult::Ok ) {
                     // mark source file for deletion
-                    m_SourceItemsToDelete.emplace_back(_source_index);
+                    MarkSourceItemForDeletion(_source_index);
                 }
             }
         }
@@ -373,6 +516,7 @@ CopyingJob::StepResult CopyingJob::ProcessDirectoryItem(VFSHost &_source_host,
 
 CopyingJob::StepResult CopyingJob::ProcessSymlinkItem(VFSHost &_source_host,
                                                       const std::string &_source_path,
+                                                      int _source_index,
                                                       const std::string &_destination_path,
                                                       const RequestNonexistentDst &_new_dst_callback)
 {
@@ -398,7 +542,7 @@ CopyingJob::StepResult CopyingJob::ProcessSymlinkItem(VFSHost &_source_host,
                                                               _destination_path,
                                                               _new_dst_callback);
                 if( result == StepResult::Ok ) // mark source file for deletion
-                    m_SourceItemsToDelete.emplace_back(m_CurrentlyProcessingSourceItemIndex);
+                    MarkSourceItemForDeletion(_source_index);
                 return result;
             }
         }
@@ -410,39 +554,38 @@ CopyingJob::StepResult CopyingJob::ProcessSymlinkItem(VFSHost &_source_host,
                                                    _destination_path,
                                                    _new_dst_callback);
         if( !m_Options.docopy && result == StepResult::Ok )
-            m_SourceItemsToDelete.emplace_back(m_CurrentlyProcessingSourceItemIndex);
+            MarkSourceItemForDeletion(_source_index);
         return result;
     }
     else { // vfs -> vfs
         const auto result = CopyVFSSymlinkToVFS(_source_host, _source_path, _destination_path, _new_dst_callback);
         if( !m_Options.docopy && result == StepResult::Ok )
-            m_SourceItemsToDelete.emplace_back(m_CurrentlyProcessingSourceItemIndex);
+            MarkSourceItemForDeletion(_source_index);
         return result;
     }
     return StepResult::Stop;
 }
 
-std::string CopyingJob::ComposeDestinationNameForItemInDB(int _src_item_index, const copying::SourceItems &_db) const
+std::string CopyingJob::ComposeDestinationNameForRelativePath(const std::string &_relative_src_path) const
 {
-    const auto relative_src_path = _db.ComposeRelativePath(_src_item_index);
     if( m_PathCompositionType == PathCompositionType::PathPreffix ) {
         // PathPreffix, path = dest_path + source_rel_path
-        return m_DestinationPath + relative_src_path;
+        return m_DestinationPath + _relative_src_path;
     }
     else {
         // FixedPath, path = dest_path + [source_rel_path without heading]
         // for top level we need to just leave path without changes: skip top level's entry name.
         // for nested entries we need to cut the first part of a path.
         auto result = m_DestinationPath;
-        if( const auto slash = relative_src_path.find('/'); slash != std::string::npos )
-            result.append(relative_src_path, slash);
+        if( const auto slash = _relative_src_path.find('/'); slash != std::string::npos )
+            result.append(_relative_src_path, slash);
         return result;
     }
 }
 
 std::string CopyingJob::ComposeDestinationNameForItem(int _src_item_index) const
 {
-    return ComposeDestinationNameForItemInDB(_src_item_index, m_SourceItems);
+    return ComposeDestinationNameForRelativePath(m_SourceItems.ComposeRelativePath(_src_item_index));
 }
 
 static bool IsSingleDirectoryCaseRenaming(const CopyingOptions &_options,
@@ -571,119 +714,178 @@ CopyingJob::StepResult CopyingJob::BuildDestinationDirectory() const
     return StepResult::Ok;
 }
 
+namespace {
+
+// A source item gathered by the scanning, the items are put into SourceItems once the whole tree is scanned.
+struct ScannedItem {
+    std::string name;
+    VFSStat stat;
+    std::vector<ScannedItem> children;
+};
+
+// A directory to be listed by the scanning.
+struct ScannedDirectory {
+    ScannedItem *item = nullptr;
+    std::string relative_path;
+};
+
+} // namespace
+
+// Places the items in the same order a depth-first scanning would produce, i.e. any directory precedes its content.
+// The scanned items are released along the way, so that the names don't stay in memory twice.
+static void InsertScannedItems(SourceItems &_db, uint16_t _host, unsigned _base_dir, int _parent, ScannedItem &_item)
+{
+    const int index = _db.InsertItem(_host, _base_dir, _parent, _item.name, _item.stat);
+    _item.name = {};
+    for( auto &child : _item.children )
+        InsertScannedItems(_db, _host, _base_dir, index, child);
+    _item.children = {};
+}
+
+bool CopyingJob::ShouldScanDirectory(VFSHost &_host,
+                                     const std::string &_path,
+                                     const std::string &_relative_path) const
+{
+    if( m_Options.docopy )
+        return true;
+
+    // if we're not copying - need to check if vfs is the same.
+    // comparing hosts by their addresses, which is NOT GREAT at all
+    if( &_host != &*m_DestinationHost )
+        return true;
+
+    // check if we're on the same native volume
+    if( m_IsDestinationHostNative && m_DestinationNativeFSInfo != m_NativeFSManager->VolumeFromPath(_path) )
+        return true;
+
+    // if we're renaming, and there's a destination file already
+    if( !m_IsSingleDirectoryCaseRenaming ) {
+        const auto dest_path = ComposeDestinationNameForRelativePath(_relative_path);
+        if( !LowercaseEqual(_path, dest_path) && m_DestinationHost->Exists(dest_path) )
+            return true;
+    }
+
+    return false;
+}
+
 std::tuple<CopyingJob::StepResult, SourceItems> CopyingJob::ScanSourceItems()
 {
     class SourceItems db;
-    auto stat_flags = m_Options.preserve_symlinks ? VFSFlags::F_NoFollow : 0;
+    const auto stat_flags = m_Options.preserve_symlinks ? VFSFlags::F_NoFollow : 0;
+    std::mutex callbacks_lock; // the user is asked one question at a time
+
+    // gathers stat() information regarding an entry, asks the user what to do if that fails
+    const auto stat_item = [&](VFSHost &_host, const std::string &_path, VFSStat &_st) -> StepResult {
+        while( true ) {
+            const std::expected<VFSStat, Error> exp_st = _host.Stat(_path, stat_flags);
+            if( exp_st ) {
+                _st = *exp_st;
+                return StepResult::Ok;
+            }
+            const auto lock = std::lock_guard{callbacks_lock};
+            switch( m_OnCantAccessSourceItem(exp_st.error(), _path, _host) ) {
+                case CantAccessSourceItemResolution::Skip:
+                    return StepResult::Skipped;
+                case CantAccessSourceItemResolution::Stop:
+                    return StepResult::Stop;
+                case CantAccessSourceItemResolution::Retry:
+                    continue;
+            }
+        }
+    };
 
     for( auto &i : m_VFSListingItems ) {
         if( BlockIfPaused(); IsStopped() )
             return {StepResult::Stop, {}};
 
-        auto host_indx = db.InsertOrFindHost(i.Host());
+        const auto host_indx = db.InsertOrFindHost(i.Host());
         auto &host = db.Host(host_indx);
-        auto base_dir_indx = db.InsertOrFindBaseDir(i.Directory());
-        std::function<StepResult(int _parent_ind,
-                                 const std::string &_full_relative_path,
-                                 const std::string &_item_name)> // need function holder for recursion to work
-            scan_item = [this, &db, stat_flags, host_indx, &host, base_dir_indx, &scan_item](
-                            int _parent_ind,
-                            const std::string &_full_relative_path,
-                            const std::string &_item_name) -> StepResult {
-            // compose a full path for current entry
-            const std::string path = db.BaseDir(base_dir_indx) + _full_relative_path;
-
-            // gather stat() information regarding current entry
-            VFSStat st;
-            while( true ) {
-                const std::expected<VFSStat, Error> exp_st = host.Stat(path, stat_flags);
-                if( exp_st ) {
-                    st = *exp_st;
-                    break;
-                }
-                switch( m_OnCantAccessSourceItem(exp_st.error(), path, host) ) {
-                    case CantAccessSourceItemResolution::Skip:
-                        return StepResult::Skipped;
-                    case CantAccessSourceItemResolution::Stop:
-                        return StepResult::Stop;
-                    case CantAccessSourceItemResolution::Retry:
-                        continue;
-                }
-            }
-
-            if( S_ISREG(st.mode) ) {
-                // check if file is an external EA
-                if( IsAnExternalExtenedAttributesStorage(host, path, _item_name, st, m_NativeFSManager) )
-                    // we're skipping "._xxx" files as they are processed by OS itself
-                    // when we copy xattrs
-                    return StepResult::Ok;
-
-                db.InsertItem(host_indx, base_dir_indx, _parent_ind, _item_name, st);
-            }
-            else if( S_ISLNK(st.mode) ) {
-                db.InsertItem(host_indx, base_dir_indx, _parent_ind, _item_name, st);
-            }
-            else if( S_ISDIR(st.mode) ) {
-                const int my_indx = db.InsertItem(host_indx, base_dir_indx, _parent_ind, _item_name, st);
-
-                bool should_go_inside = m_Options.docopy;
-                if( !should_go_inside ) {
-                    // if we're not copying - need to check if vfs is the same.
-                    // comparing hosts by their addresses, which is NOT GREAT at all
-                    if( &host != &*m_DestinationHost )
-                        should_go_inside = true;
-                }
-                if( !should_go_inside ) {
-                    // check if we're on the same native volume
-                    if( m_IsDestinationHostNative &&
-                        m_DestinationNativeFSInfo != m_NativeFSManager->VolumeFromPath(path) )
-                        should_go_inside = true;
-                }
-                if( !should_go_inside ) {
-                    // if we're renaming, and there's a destination file already
-                    if( !m_IsSingleDirectoryCaseRenaming ) {
-                        const auto dest_path = ComposeDestinationNameForItemInDB(my_indx, db);
-                        if( !LowercaseEqual(path, dest_path) && m_DestinationHost->Exists(dest_path) )
-                            should_go_inside = true;
+        const auto base_dir_indx = db.InsertOrFindBaseDir(i.Directory());
+        const std::string &base_dir = db.BaseDir(base_dir_indx);
+
+        ScannedItem root;
+        root.name = i.Filename();
+        const std::string root_path = base_dir + root.name;
+        if( const auto rc = stat_item(host, root_path, root.stat); rc != StepResult::Ok )
+            return {rc, {}};
+
+        if( S_ISREG(root.stat.mode) &&
+            IsAnExternalExtenedAttributesStorage(host, root_path, root.name, root.stat, m_NativeFSManager) )
+            continue; // we're skipping "._xxx" files as they are processed by OS itself when we copy xattrs
+
+        if( !S_ISREG(root.stat.mode) && !S_ISLNK(root.stat.mode) && !S_ISDIR(root.stat.mode) )
+            continue;
+
+        if( S_ISDIR(root.stat.mode) && ShouldScanDirectory(host, root_path, root.name) ) {
+            const auto visit = [&](ScannedDirectory _dir, std::vector<ScannedDirectory> &_subdirs) {
+                const std::string path = base_dir + _dir.relative_path;
+                std::vector<std::string> dir_ents;
+                while( true ) {
+                    const auto callback = [&](auto &_) {
+                        dir_ents.emplace_back(_.name);
+                        return true;
+                    };
+                    const std::expected<void, Error> rc = host.IterateDirectoryListing(path, callback);
+                    if( rc )
+                        break;
+                    dir_ents.clear();
+                    const auto lock = std::lock_guard{callbacks_lock};
+                    switch( m_OnCantAccessSourceItem(rc.error(), path, host) ) {
+                        case CantAccessSourceItemResolution::Skip:
+                            return;
+                        case CantAccessSourceItemResolution::Stop:
+                            Stop();
+                            return;
+                        case CantAccessSourceItemResolution::Retry:
+                            continue;
                     }
                 }
 
-                if( should_go_inside ) {
-                    std::vector<std::string> dir_ents;
-                    while( true ) {
-                        const auto callback = [&](auto &_) {
-                            dir_ents.emplace_back(_.name);
-                            return true;
-                        };
-                        const std::expected<void, Error> rc = host.IterateDirectoryListing(path, callback);
-                        if( rc )
-                            break;
-                        switch( m_OnCantAccessSourceItem(rc.error(), path, host) ) {
-                            case CantAccessSourceItemResolution::Skip:
-                                return StepResult::Skipped;
-                            case CantAccessSourceItemResolution::Stop:
-                                return StepResult::Stop;
-                            case CantAccessSourceItemResolution::Retry:
-                                continue;
-                        }
-                    }
-
-                    for( auto &entry : dir_ents ) {
-                        if( BlockIfPaused(); IsStopped() )
-                            return StepResult::Stop;
+                auto &children = _dir.item->children;
+                children.reserve(dir_ents.size());
+                for( auto &entry : dir_ents ) {
+                    if( BlockIfPaused(); IsStopped() )
+                        return;
 
-                        // go into recursion
-                        scan_item(my_indx, fmt::format("{}/{}", _full_relative_path, entry), entry);
+                    ScannedItem child;
+                    const std::string child_path = fmt::format("{}/{}", path, entry);
+                    if( const auto rc = stat_item(host, child_path, child.stat); rc != StepResult::Ok ) {
+                        if( rc == StepResult::Stop ) {
+                            Stop();
+                            return;
+                        }
+                        continue;
                     }
+                    if( S_ISREG(child.stat.mode) &&
+                        IsAnExternalExtenedAttributesStorage(host, child_path, entry, child.stat, m_NativeFSManager) )
+                        continue;
+                    if( !S_ISREG(child.stat.mode) && !S_ISLNK(child.stat.mode) && !S_ISDIR(child.stat.mode) )
+                        continue;
+                    child.name = std::move(entry);
+                    children.emplace_back(std::move(child));
                 }
-            }
 
-            return StepResult::Ok;
-        };
+                // the children vector won't be touched anymore, so it's safe to hand out the pointers
+                for( auto &child : children ) {
+                    if( !S_ISDIR(child.stat.mode) )
+                        continue;
+                    auto relative_path = fmt::format("{}/{}", _dir.relative_path, child.name);
+                    if( ShouldScanDirectory(host, base_dir + relative_path, relative_path) )
+                        _subdirs.emplace_back(ScannedDirectory{&child, std::move(relative_path)});
+                }
+            };
+            const int workers =
+                host.CanServeConcurrently() ? base::ParallelTreeWalker<ScannedDirectory>::DefaultConcurrency() : 1;
+            base::ParallelTreeWalker<ScannedDirectory> walker(workers, visit, [this] {
+                BlockIfPaused();
+                return IsStopped();
+            });
+            walker.Walk({ScannedDirectory{&root, root.name}});
+            if( IsStopped() )
+                return {StepResult::Stop, {}};
+        }
 
-        auto result = scan_item(-1, i.Filename(), i.Filename());
-        if( result != StepResult::Ok )
-            return {result, {}};
+        InsertScannedItems(db, host_indx, base_dir_indx, -1, root);
     }
 
     return {StepResult::Ok, std::move(db)};
@@ -710,7 +912,8 @@ static void TurnIntoBlockingOrThrow(const int _fd)
     }
 }
 
-CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_native_host,
+CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(IOLane &_lane,
+                                                              vfs::NativeHost &_native_host,
                                                               const std::string &_src_path,
                                                               const std::string &_dst_path,
                                                               const SourceDataFeedback &_source_data_feedback,
@@ -742,8 +945,9 @@ CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_
             close(source_fd);
     });
 
-    // do not waste OS file cache with one-way data
+    // do not waste OS file cache with one-way data, but let the kernel read ahead since the access is sequential
     fcntl(source_fd, F_NOCACHE, 1);
+    fcntl(source_fd, F_RDAHEAD, 1);
 
     TurnIntoBlockingOrThrow(source_fd);
 
@@ -843,15 +1047,29 @@ CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_
         setup_new();
     }
 
+    // a new file on the same volume can be produced as a clone which shares the data blocks with the source
+    if( (dst_open_flags & O_EXCL) && !io.isrouted() && src_fs_info.interfaces.clone &&
+        src_fs_info_holder == m_DestinationNativeFSInfo ) {
+        const auto clone_result = CloneNativeFileToNativeFile(
+            _lane, _native_host, source_fd, src_stat_buffer, _src_path, _dst_path, _source_data_feedback);
+        if( clone_result )
+            return *clone_result;
+    }
+
     // open a file descriptor for the destination
     // we want to copy src permissions if options say so or just to put default ones
     int destination_fd = -1;
     while( true ) {
         const mode_t open_mode = m_Options.copy_unix_flags ? src_stat_buffer.st_mode : S_IRUSR | S_IWUSR | S_IRGRP;
-        const mode_t old_umask = umask(0);
-        destination_fd = io.open(_dst_path.c_str(), dst_open_flags, open_mode);
-        const auto open_err = VFSError::FromErrno();
-        umask(old_umask);
+        int open_err = VFSError::Ok;
+        {
+            // umask is process-wide, so the lanes must not interleave while it's temporarily reset
+            const auto lock = std::lock_guard{g_UmaskLock};
+            const mode_t old_umask = umask(0);
+            destination_fd = io.open(_dst_path.c_str(), dst_open_flags, open_mode);
+            open_err = VFSError::FromErrno();
+            umask(old_umask);
+        }
 
         if( destination_fd >= 0 )
             break;
@@ -936,66 +1154,71 @@ CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_
         }
     }
 
-    auto read_buffer = m_Buffers[0].get();
-    auto write_buffer = m_Buffers[1].get();
-    const uint32_t src_preferred_io_size =
-        src_fs_info.basic.io_size < m_BufferSize ? src_fs_info.basic.io_size : m_BufferSize;
     const uint32_t dst_preferred_io_size =
         dst_fs_info.basic.io_size < m_BufferSize ? dst_fs_info.basic.io_size : m_BufferSize;
+    IOTuner &tuner =
+        _lane.Tuner(&src_fs_info, &dst_fs_info, std::max(src_fs_info.basic.io_size, dst_fs_info.basic.io_size));
     constexpr int max_io_loops = 5; // looked in Apple's copyfile() - treat 5 zero-resulting reads/writes as an error
-    uint32_t bytes_to_write = 0;
+    const uint64_t source_size = src_stat_buffer.st_size;
     uint64_t source_bytes_read = 0;
-    uint64_t destination_bytes_written = 0;
 
-    // read from source within current thread and write to destination within secondary queue
-    while( static_cast<uint64_t>(src_stat_buffer.st_size) != destination_bytes_written ) {
+    // The data flows through a ring of up to tuner.Depth() buffers: the current thread reads the source into a free
+    // buffer while the previously filled ones are written in order into the destination by the lane's write queue.
+    std::mutex writing_lock;
+    std::condition_variable writing_cv;
+    std::array<bool, m_MaxIODepth> buffer_busy{};
+    std::optional<StepResult> write_return; // optional storage for error returning, guarded by writing_lock
+    const auto acquire_buffer = [&](int _depth) -> int {
+        auto lock = std::unique_lock{writing_lock};
+        int index = -1;
+        writing_cv.wait(lock, [&] {
+            for( int i = 0; i < _depth && !write_return; ++i )
+                if( !buffer_busy[i] ) {
+                    index = i;
+                    break;
+                }
+            return index >= 0 || write_return;
+        });
+        if( index >= 0 )
+            buffer_busy[index] = true;
+        return index;
+    };
+    const auto release_buffer = [&](int _index, std::optional<StepResult> _result) {
+        {
+            const auto lock = std::lock_guard{writing_lock};
+            buffer_busy[_index] = false;
+            if( _result && !write_return )
+                write_return = _result;
+        }
+        writing_cv.notify_all();
+    };
+
+    // make sure that no write is in flight when leaving this function, before the descriptors are closed
+    const auto wait_for_writes = at_scope_end([&] { _lane.write_queue.Wait(); });
+
+    auto block_start = std::chrono::steady_clock::now();
+    while( source_bytes_read != source_size ) {
 
         // check user decided to pause operation or discard it
         if( BlockIfPaused(); IsStopped() )
             return StepResult::Stop;
 
-        // <<<--- writing in secondary thread --->>>
-        std::optional<StepResult> write_return; // optional storage for error returning
-        m_IOGroup.Run([this,
-                       bytes_to_write,
-                       destination_fd,
-                       write_buffer,
-                       dst_preferred_io_size,
-                       &destination_bytes_written,
-                       &write_return,
-                       &_dst_path,
-                       &_native_host] {
-            uint32_t left_to_write = bytes_to_write;
-            uint32_t has_written = 0; // amount of bytes written into destination this time
-            int write_loops = 0;
-            while( left_to_write > 0 ) {
-                const int64_t n_written =
-                    write(destination_fd, write_buffer + has_written, std::min(left_to_write, dst_preferred_io_size));
-                if( n_written > 0 ) {
-                    has_written += n_written;
-                    left_to_write -= n_written;
-                    destination_bytes_written += n_written;
-                }
-                else if( n_written < 0 || (++write_loops > max_io_loops) ) {
-                    switch( m_OnDestinationFileWriteError(Error{Error::POSIX, errno}, _dst_path, _native_host) ) {
-                        case DestinationFileWriteErrorResolution::Skip:
-                            write_return = StepResult::Skipped;
-                            return;
-                        case DestinationFileWriteErrorResolution::Stop:
-                            write_return = StepResult::Stop;
-                            return;
-                        case DestinationFileWriteErrorResolution::Retry:
-                            continue;
-                    }
-                }
-            }
-        });
+        const int buffer_index = acquire_buffer(tuner.Depth());
+        if( buffer_index < 0 )
+            break; // writing has failed, the reason is in write_return
+        uint8_t *const read_buffer = _lane.Buffer(buffer_index);
 
         // <<<--- reading in current thread --->>>
-        // here we handle the case in which source io size is much smaller than dest's io size
-        uint32_t to_read = std::max(src_preferred_io_size, dst_preferred_io_size);
-        if( src_stat_buffer.st_size - source_bytes_read < to_read )
-            to_read = uint32_t(src_stat_buffer.st_size - source_bytes_read);
+        uint32_t to_read =
+            static_cast<uint32_t>(std::min<uint64_t>(tuner.BlockSize(), source_size - source_bytes_read));
+        if( !src_fs_info.mount_flags.local && source_bytes_read + to_read < source_size ) {
+            // ask a network volume to fetch the next block while this one is being read
+            const uint64_t next_offset = source_bytes_read + to_read;
+            radvisory advice;
+            advice.ra_offset = static_cast<off_t>(next_offset);
+            advice.ra_count = static_cast<int>(std::min<uint64_t>(tuner.BlockSize(), source_size - next_offset));
+            fcntl(source_fd, F_RDADVISE, &advice);
+        }
         uint32_t has_read = 0;                 // amount of bytes read into buffer this time
         int read_loops = 0;                    // amount of zero-resulting reads
         std::optional<StepResult> read_return; // optional storage for error returning
@@ -1023,22 +1246,54 @@ CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_
                 break;
             }
         }
-
-        m_IOGroup.Wait();
-
-        // if something bad happened in reading or writing - return from this routine
-        if( write_return )
-            return *write_return;
-        if( read_return )
+        if( read_return ) {
+            release_buffer(buffer_index, std::nullopt);
             return *read_return;
+        }
 
-        Statistics().CommitProcessed(Statistics::SourceType::Bytes, bytes_to_write);
+        // <<<--- writing in secondary thread --->>>
+        _lane.write_queue.Run([&, buffer_index, read_buffer, has_read] {
+            if( const auto lock = std::lock_guard{writing_lock}; write_return ) {
+                buffer_busy[buffer_index] = false; // a previous write has failed, don't touch the file anymore
+                return;
+            }
+            std::optional<StepResult> result;
+            uint32_t left_to_write = has_read;
+            uint32_t has_written = 0; // amount of bytes written into destination this time
+            int write_loops = 0;
+            while( left_to_write > 0 && !result ) {
+                const int64_t n_written =
+                    write(destination_fd, read_buffer + has_written, std::min(left_to_write, dst_preferred_io_size));
+                if( n_written > 0 ) {
+                    has_written += n_written;
+                    left_to_write -= n_written;
+                }
+                else if( n_written < 0 || (++write_loops > max_io_loops) ) {
+                    switch( m_OnDestinationFileWriteError(Error{Error::POSIX, errno}, _dst_path, _native_host) ) {
+                        case DestinationFileWriteErrorResolution::Skip:
+                            result = StepResult::Skipped;
+                            break;
+                        case DestinationFileWriteErrorResolution::Stop:
+                            result = StepResult::Stop;
+                            break;
+                        case DestinationFileWriteErrorResolution::Retry:
+                            continue;
+                    }
+                }
+            }
+            Statistics().CommitProcessed(Statistics::SourceType::Bytes, has_written);
+            release_buffer(buffer_index, result);
+        });
 
-        // swap buffers ang go again
-        bytes_to_write = has_read;
-        std::swap(read_buffer, write_buffer);
+        const auto block_end = std::chrono::steady_clock::now();
+        tuner.Commit(has_read, block_end - block_start);
+        block_start = block_end;
     }
 
+    _lane.write_queue.Wait();
+    if( write_return )
+        return *write_return;
+
     // we're ok, turn off destination cleaning
     clean_destination.disengage();
 
@@ -1046,10 +1301,10 @@ CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_
     // crazy OSX stuff: setting some xattrs like FinderInfo may actually change file's BSD flags
     if( m_Options.copy_xattrs ) {
         if( do_erase_xattrs ) // erase destination's xattrs
-            EraseXattrsFromNativeFD(destination_fd);
+            EraseXattrsFromNativeFD(_lane, destination_fd);
 
         if( do_copy_xattrs ) // copy xattrs from src to dest
-            CopyXattrsFromNativeFDToNativeFD(source_fd, destination_fd);
+            CopyXattrsFromNativeFDToNativeFD(_lane, source_fd, destination_fd);
     }
 
     // do flags things
@@ -1088,10 +1343,105 @@ CopyingJob::StepResult CopyingJob::CopyNativeFileToNativeFile(vfs::NativeHost &_
     return StepResult::Ok;
 }
 
+// Tries to create the destination file as a clone of the source file, so that no data is actually copied.
+// Returns nullopt if the clone can't be made and the regular copying should take place instead.
+std::optional<CopyingJob::StepResult>
+CopyingJob::CloneNativeFileToNativeFile(IOLane &_lane,
+                                        vfs::NativeHost &_native_host,
+                                        int _source_fd,
+                                        struct stat &_src_stat,
+                                        const std::string &_src_path,
+                                        const std::string &_dst_path,
+                                        const SourceDataFeedback &_source_data_feedback)
+{
+    // only the superuser can alter the system flags, a clone inheriting them couldn't be even removed
+    if( _src_stat.st_flags & SF_SETTABLE )
+        return std::nullopt;
+
+    if( fclonefileat(_source_fd, AT_FDCWD, _dst_path.c_str(), CLONE_NOFOLLOW | CLONE_NOOWNERCOPY) != 0 )
+        return std::nullopt;
+
+    // the clone inherits the mode and the flags of the source, which might forbid writing or removing it.
+    // relax them while the metadata is being set up, they are brought back at the end.
+    if( _src_stat.st_flags != 0 )
+        chflags(_dst_path.c_str(), 0);
+    if( (_src_stat.st_mode & S_IWUSR) == 0 )
+        chmod(_dst_path.c_str(), (_src_stat.st_mode & ALLPERMS) | S_IRUSR | S_IWUSR);
+
+    const int destination_fd = open(_dst_path.c_str(), O_WRONLY | O_NOFOLLOW);
+    if( destination_fd < 0 ) {
+        unlink(_dst_path.c_str());
+        return std::nullopt;
+    }
+    const auto close_destination = at_scope_end([&] { close(destination_fd); });
+    auto clean_destination = at_scope_end([&] { unlink(_dst_path.c_str()); });
+
+    if( _source_data_feedback ) {
+        // the data never goes through the user space now, but the verification still needs to see the bytes
+        constexpr int max_io_loops = 5;
+        const auto buffer = _lane.buffers[0].get();
+        const uint64_t source_size = _src_stat.st_size;
+        uint64_t source_bytes_read = 0;
+        int read_loops = 0;
+        while( source_bytes_read < source_size ) {
+            if( BlockIfPaused(); IsStopped() )
+                return StepResult::Stop;
+
+            const size_t to_read = std::min(source_size - source_bytes_read, static_cast<uint64_t>(m_BufferSize));
+            const ssize_t read_result = pread(_source_fd, buffer, to_read, source_bytes_read);
+            if( read_result > 0 ) {
+                _source_data_feedback(buffer, static_cast<unsigned>(read_result));
+                source_bytes_read += read_result;
+                Statistics().CommitProcessed(Statistics::SourceType::Bytes, read_result);
+            }
+            else if( (read_result < 0) || (++read_loops > max_io_loops) ) {
+                switch( m_OnSourceFileReadError(VFSError::FromErrno(), _src_path, _native_host) ) {
+                    case SourceFileReadErrorResolution::Skip:
+                        return StepResult::Skipped;
+                    case SourceFileReadErrorResolution::Stop:
+                        return StepResult::Stop;
+                    case SourceFileReadErrorResolution::Retry:
+                        continue;
+                }
+            }
+        }
+    }
+    else {
+        Statistics().CommitProcessed(Statistics::SourceType::Bytes, _src_stat.st_size);
+    }
+
+    // we're ok, turn off destination cleaning
+    clean_destination.disengage();
+
+    // a clone inherits the permissions, the flags and the xattrs of the source, revert them if needed
+    if( m_Options.copy_xattrs == false )
+        EraseXattrsFromNativeFD(_lane, destination_fd);
+
+    if( m_Options.copy_unix_owners )
+        fchown(destination_fd, _src_stat.st_uid, _src_stat.st_gid);
+
+    if( m_Options.copy_file_times )
+        AdjustFileTimesForNativeFD(destination_fd, _src_stat);
+    else
+        futimes(destination_fd, nullptr);
+
+    // the flags go last, since the immutable ones would block any other change
+    if( m_Options.copy_unix_flags ) {
+        fchmod(destination_fd, _src_stat.st_mode & ALLPERMS);
+        if( _src_stat.st_flags != 0 )
+            fchflags(destination_fd, _src_stat.st_flags);
+    }
+    else
+        fchmod(destination_fd, S_IRUSR | S_IWUSR | S_IRGRP);
+
+    return StepResult::Ok;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // vfs file -> native file copying routine
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
+CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(IOLane &_lane,
+                                                           VFSHost &_src_vfs,
                                                            const std::string &_src_path,
                                                            vfs::NativeHost &_dst_host,
                                                            const std::string &_dst_path,
@@ -1228,10 +1578,15 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
     while( true ) {
         // we want to copy src permissions if options say so or just to put default ones
         const mode_t open_mode = m_Options.copy_unix_flags ? src_stat_buffer.mode : S_IRUSR | S_IWUSR | S_IRGRP;
-        const mode_t old_umask = umask(0);
-        destination_fd = io.open(_dst_path.c_str(), dst_open_flags, open_mode);
-        const auto open_err = VFSError::FromErrno();
-        umask(old_umask);
+        int open_err = VFSError::Ok;
+        {
+            // umask is process-wide, so the lanes must not interleave while it's temporarily reset
+            const auto lock = std::lock_guard{g_UmaskLock};
+            const mode_t old_umask = umask(0);
+            destination_fd = io.open(_dst_path.c_str(), dst_open_flags, open_mode);
+            open_err = VFSError::FromErrno();
+            umask(old_umask);
+        }
 
         if( destination_fd >= 0 )
             break;
@@ -1317,19 +1672,21 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
         }
     }
 
-    auto read_buffer = m_Buffers[0].get();
-    auto write_buffer = m_Buffers[1].get();
+    auto read_buffer = _lane.buffers[0].get();
+    auto write_buffer = _lane.buffers[1].get();
     const uint32_t dst_preffered_io_size =
         dst_fs_info.basic.io_size < m_BufferSize ? dst_fs_info.basic.io_size : m_BufferSize;
     const uint32_t src_preffered_io_size =
         src_file->PreferredIOSize() > 0 ? src_file->PreferredIOSize() : // use custom IO size for this vfs
             dst_preffered_io_size;  // not sure if this is a good idea, but seems to be ok
+    IOTuner &tuner = _lane.Tuner(&_src_vfs, &dst_fs_info, std::max(src_preffered_io_size, dst_preffered_io_size));
     constexpr int max_io_loops = 5; // looked in Apple's copyfile() - treat 5 zero-resulting reads/writes as an error
     uint32_t bytes_to_write = 0;
     uint64_t source_bytes_read = 0;
     uint64_t destination_bytes_written = 0;
 
     // read from source within current thread and write to destination within secondary queue
+    auto block_start = std::chrono::steady_clock::now();
     while( src_stat_buffer.size != destination_bytes_written ) {
 
         // check user decided to pause operation or discard it
@@ -1338,7 +1695,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
 
         // <<<--- writing in secondary thread --->>>
         std::optional<StepResult> write_return; // optional storage for error returning
-        m_IOGroup.Run([this,
+        _lane.io_group.Run([this,
                        bytes_to_write,
                        destination_fd,
                        write_buffer,
@@ -1374,8 +1731,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
         });
 
         // <<<--- reading in current thread --->>>
-        // here we handle the case in which source io size is much smaller than dest's io size
-        uint32_t to_read = std::max(src_preffered_io_size, dst_preffered_io_size);
+        uint32_t to_read = static_cast<uint32_t>(tuner.BlockSize());
         if( src_stat_buffer.size - source_bytes_read < to_read )
             to_read = uint32_t(src_stat_buffer.size - source_bytes_read);
         uint32_t has_read = 0;                 // amount of bytes read into buffer this time
@@ -1407,7 +1763,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
             }
         }
 
-        m_IOGroup.Wait();
+        _lane.io_group.Wait();
 
         // if something bad happened in reading or writing - return from this routine
         if( write_return )
@@ -1417,6 +1773,10 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
 
         Statistics().CommitProcessed(Statistics::SourceType::Bytes, bytes_to_write);
 
+        const auto block_end = std::chrono::steady_clock::now();
+        tuner.Commit(has_read, block_end - block_start);
+        block_start = block_end;
+
         // swap buffers ang go again
         bytes_to_write = has_read;
         std::swap(read_buffer, write_buffer);
@@ -1427,11 +1787,11 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
 
     // erase destination's xattrs
     if( m_Options.copy_xattrs && do_erase_xattrs )
-        EraseXattrsFromNativeFD(destination_fd);
+        EraseXattrsFromNativeFD(_lane, destination_fd);
 
     // copy xattrs from src to dst
     if( m_Options.copy_xattrs && src_file->XAttrCount() > 0 )
-        CopyXattrsFromVFSFileToNativeFD(*src_file, destination_fd);
+        CopyXattrsFromVFSFileToNativeFD(_lane, *src_file, destination_fd);
 
     // change flags
     if( m_Options.copy_unix_flags && src_stat_buffer.meaning.flags ) {
@@ -1467,7 +1827,8 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToNativeFile(VFSHost &_src_vfs,
     return StepResult::Ok;
 }
 
-CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
+CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(IOLane &_lane,
+                                                        VFSHost &_src_vfs,
                                                         const std::string &_src_path,
                                                         const std::string &_dst_path,
                                                         const SourceDataFeedback &_source_data_feedback,
@@ -1663,16 +2024,18 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
         }
     }
 
-    auto read_buffer = m_Buffers[0].get();
-    auto write_buffer = m_Buffers[1].get();
+    auto read_buffer = _lane.buffers[0].get();
+    auto write_buffer = _lane.buffers[1].get();
     const uint32_t dst_preffered_io_size = m_BufferSize;
     const uint32_t src_preffered_io_size = m_BufferSize;
+    IOTuner &tuner = _lane.Tuner(&_src_vfs, m_DestinationHost.get(), m_BufferSize);
     constexpr int max_io_loops = 5; // looked in Apple's copyfile() - treat 5 zero-resulting reads/writes as an error
     uint32_t bytes_to_write = 0;
     uint64_t source_bytes_read = 0;
     uint64_t destination_bytes_written = 0;
 
     // read from source within current thread and write to destination within secondary queue
+    auto block_start = std::chrono::steady_clock::now();
     while( src_stat_buffer.size != destination_bytes_written ) {
 
         // check user decided to pause operation or discard it
@@ -1681,7 +2044,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
 
         // <<<--- writing in secondary thread --->>>
         std::optional<StepResult> write_return; // optional storage for error returning
-        m_IOGroup.Run([this,
+        _lane.io_group.Run([this,
                        bytes_to_write,
                        &dst_file,
                        write_buffer,
@@ -1719,8 +2082,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
         });
 
         // <<<--- reading in current thread --->>>
-        // here we handle the case in which source io size is much smaller than dest's io size
-        uint32_t to_read = std::max(src_preffered_io_size, dst_preffered_io_size);
+        uint32_t to_read = static_cast<uint32_t>(tuner.BlockSize());
         if( src_stat_buffer.size - source_bytes_read < to_read )
             to_read = uint32_t(src_stat_buffer.size - source_bytes_read);
         uint32_t has_read = 0;                 // amount of bytes read into buffer this time
@@ -1751,7 +2113,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
             }
         }
 
-        m_IOGroup.Wait();
+        _lane.io_group.Wait();
 
         // if something bad happened in reading or writing - return from this routine
         if( write_return )
@@ -1761,11 +2123,30 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
 
         Statistics().CommitProcessed(Statistics::SourceType::Bytes, bytes_to_write);
 
+        const auto block_end = std::chrono::steady_clock::now();
+        tuner.Commit(has_read, block_end - block_start);
+        block_start = block_end;
+
         // swap buffers ang go again
         bytes_to_write = has_read;
         std::swap(read_buffer, write_buffer);
     }
 
+    // the destination might still hold some of the data in its buffers, so the failures to write it show up only now
+    while( true ) {
+        const int rc = dst_file->Flush();
+        if( rc == VFSError::Ok )
+            break;
+        switch( m_OnDestinationFileWriteError(VFSError::ToError(rc), _dst_path, *m_DestinationHost) ) {
+            case DestinationFileWriteErrorResolution::Skip:
+                return StepResult::Skipped;
+            case DestinationFileWriteErrorResolution::Stop:
+                return StepResult::Stop;
+            case DestinationFileWriteErrorResolution::Retry:
+                continue;
+        }
+    }
+
     // we're ok, turn off destination cleaning
     clean_destination.disengage();
 
@@ -1790,22 +2171,22 @@ CopyingJob::StepResult CopyingJob::CopyVFSFileToVFSFile(VFSHost &_src_vfs,
     return StepResult::Ok;
 }
 
-// uses m_Buffer[0] to reduce mallocs
+// uses _lane.buffers[0] to reduce mallocs
 // currently there's no error handling or reporting here. may need this in the future. maybe.
-void CopyingJob::EraseXattrsFromNativeFD(int _fd_in) const
+void CopyingJob::EraseXattrsFromNativeFD(const IOLane &_lane, int _fd_in)
 {
-    auto xnames = reinterpret_cast<char *>(m_Buffers[0].get());
+    auto xnames = reinterpret_cast<char *>(_lane.buffers[0].get());
     auto xnamesizes = flistxattr(_fd_in, xnames, m_BufferSize, 0);
     for( auto s = xnames, e = xnames + xnamesizes; s < e; s += strlen(s) + 1 ) // iterate thru xattr names..
         fremovexattr(_fd_in, s, 0);                                            // ..and remove everyone
 }
 
-// uses m_Buffer[0] and m_Buffer[1] to reduce mallocs
+// uses _lane.buffers[0] and _lane.buffers[1] to reduce mallocs
 // currently there's no error handling or reporting here. may need this in the future. maybe.
-void CopyingJob::CopyXattrsFromNativeFDToNativeFD(int _fd_from, int _fd_to) const
+void CopyingJob::CopyXattrsFromNativeFDToNativeFD(const IOLane &_lane, int _fd_from, int _fd_to)
 {
-    auto xnames = reinterpret_cast<char *>(m_Buffers[0].get());
-    auto xdata = m_Buffers[1].get();
+    auto xnames = reinterpret_cast<char *>(_lane.buffers[0].get());
+    auto xdata = _lane.buffers[1].get();
     auto xnamesizes = flistxattr(_fd_from, xnames, m_BufferSize, 0);
     for( auto s = xnames, e = xnames + xnamesizes; s < e; s += strlen(s) + 1 ) { // iterate thru xattr names..
         auto xattrsize = fgetxattr(_fd_from, s, xdata, m_BufferSize, 0, 0);      // and read all these xattrs
@@ -1814,9 +2195,9 @@ void CopyingJob::CopyXattrsFromNativeFDToNativeFD(int _fd_from, int _fd_to) cons
     }
 }
 
-void CopyingJob::CopyXattrsFromVFSFileToNativeFD(VFSFile &_source, int _fd_to) const
+void CopyingJob::CopyXattrsFromVFSFileToNativeFD(const IOLane &_lane, VFSFile &_source, int _fd_to)
 {
-    auto buf = m_Buffers[0].get();
+    auto buf = _lane.buffers[0].get();
     size_t buf_sz = m_BufferSize;
     _source.XAttrIterateNames([&](const char *name) {
         const ssize_t res = _source.XAttrGet(name, buf, buf_sz);
@@ -1826,9 +2207,9 @@ void CopyingJob::CopyXattrsFromVFSFileToNativeFD(VFSFile &_source, int _fd_to) c
     });
 }
 
-void CopyingJob::CopyXattrsFromVFSFileToPath(VFSFile &_file, const char *_fn_to) const
+void CopyingJob::CopyXattrsFromVFSFileToPath(const IOLane &_lane, VFSFile &_file, const char *_fn_to)
 {
-    auto buf = m_Buffers[0].get();
+    auto buf = _lane.buffers[0].get();
     size_t buf_sz = m_BufferSize;
 
     _file.XAttrIterateNames([&](const char *name) {
@@ -1902,7 +2283,7 @@ CopyingJob::StepResult CopyingJob::CopyNativeDirectoryToNativeDirectory(vfs::Nat
         io.chown(_dst_path.c_str(), src_stat.st_uid, src_stat.st_gid);
 
     if( m_Options.copy_xattrs ) // copy xattrs
-        CopyXattrsFromNativeFDToNativeFD(src_fd, dst_fd);
+        CopyXattrsFromNativeFDToNativeFD(m_MainLane, src_fd, dst_fd);
 
     if( m_Options.copy_file_times ) {
         // adjust destination times
@@ -1978,7 +2359,7 @@ CopyingJob::StepResult CopyingJob::CopyVFSDirectoryToNativeDirectory(VFSHost &_s
             const auto src_flags = VFSFlags::OF_Read | VFSFlags::OF_Directory | VFSFlags::OF_ShLock;
             if( auto &src_file = **exp_src_file; src_file.Open(src_flags) >= 0 ) {
                 if( src_file.XAttrCount() > 0 )
-                    CopyXattrsFromVFSFileToPath(src_file, _dst_path.c_str());
+                    CopyXattrsFromVFSFileToPath(m_MainLane, src_file, _dst_path.c_str());
             }
         }
     }
@@ -2171,7 +2552,7 @@ CopyingJob::RenameNativeDirectory(vfs::NativeHost &_native_host,
                 io.chown(_dst_path.c_str(), src_stat.st_uid, src_stat.st_gid);
 
             if( m_Options.copy_xattrs )
-                CopyXattrsFromNativeFDToNativeFD(src_fd, dst_fd);
+                CopyXattrsFromNativeFDToNativeFD(m_MainLane, src_fd, dst_fd);
 
             if( m_Options.copy_file_times )
                 AdjustFileTimesForNativeFD(dst_fd, src_stat);
@@ -2508,12 +2889,19 @@ CopyingJob::StepResult CopyingJob::RenameVFSFile(VFSHost &_common_host,
     return StepResult::Ok;
 }
 
+void CopyingJob::MarkSourceItemForDeletion(int _item_number)
+{
+    const auto lock = std::lock_guard{m_ItemsAftermathLock};
+    m_SourceItemsToDelete.emplace_back(_item_number);
+}
+
 void CopyingJob::ClearSourceItems()
 {
+    std::string source_path;
     for( const unsigned int index : std::ranges::reverse_view(m_SourceItemsToDelete) ) {
         auto mode = m_SourceItems.ItemMode(index);
         auto &host = m_SourceItems.ItemHost(index);
-        auto source_path = m_SourceItems.ComposeFullPath(index);
+        m_SourceItems.ComposeFullPath(index, source_path);
 
         ClearSourceItem(source_path, mode, host);
 
@@ -2610,6 +2998,33 @@ void CopyingJob::ApplyTimestampsFixups()
     }
 }
 
+bool CopyingJob::IsVerificationRequired() const noexcept
+{
+    return m_Options.verification == ChecksumVerification::Always ||
+           (!m_Options.docopy && m_Options.verification >= ChecksumVerification::WhenMoves);
+}
+
+// Verification re-reads the destination file, which is done on a separate queue so the copying can proceed with
+// the next items meanwhile. The queue is serial, thus only one file is being re-read at any moment.
+void CopyingJob::ScheduleVerification(ChecksumExpectation _exp)
+{
+    m_VerificationQueue.Run([this, exp = std::move(_exp)] {
+        if( IsStopped() )
+            return;
+        bool matched = false;
+        const auto verify_result = VerifyCopiedFile(exp, matched);
+        if( verify_result == StepResult::Stop ) {
+            m_AllVerified = false;
+            Stop();
+            return;
+        }
+        if( verify_result != StepResult::Ok || !matched ) {
+            m_OnFileVerificationFailed(exp.destination_path, *m_DestinationHost);
+            m_AllVerified = false;
+        }
+    });
+}
+
 CopyingJob::StepResult CopyingJob::VerifyCopiedFile(const ChecksumExpectation &_exp, bool &_matched)
 {
     _matched = false;
@@ -2634,11 +3049,11 @@ CopyingJob::StepResult CopyingJob::VerifyCopiedFile(const ChecksumExpectation &_
                 return StepResult::Stop;
         }
 
-    base::Hash hash(base::Hash::MD5);
+    base::Hash hash(g_VerificationHashMode);
 
     const uint64_t sz = file->Size();
     uint64_t szleft = sz;
-    void *buf = m_Buffers[0].get();
+    void *buf = m_VerificationBuffer.get();
     const uint64_t buf_sz = m_BufferSize;
 
     while( szleft > 0 ) {
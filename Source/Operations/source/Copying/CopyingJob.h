@@ -7,10 +7,14 @@
 #include <Utility/NativeFSManager.h>
 #include <VFS/VFS.h>
 #include <VFS/Native.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include "Options.h"
 #include "../Job.h"
 #include "SourceItems.h"
 #include "ChecksumExpectation.h"
+#include "IOTuner.h"
 #include "CopyingJobCallbacks.h"
 
 namespace nc::ops {
@@ -79,11 +83,34 @@ private:
         timespec btime = {0, 0};
     };
 
+    // A set of buffers and a secondary queue used to move bytes of one file at a time.
+    // Each lane can be used only by a single routine at the moment.
+    static constexpr int m_MaxIODepth = 4; // maximum amount of buffers in flight when copying a file
+
+    struct IOLane {
+        // returns a buffer at _index, the buffers beyond the first two are allocated on demand
+        uint8_t *Buffer(int _index);
+
+        // returns the tuner which is reset when the pair of source and destination changes
+        copying::IOTuner &Tuner(const void *_source, const void *_destination, size_t _initial_block_size);
+
+        std::unique_ptr<uint8_t[]> buffers[m_MaxIODepth] = {std::make_unique<uint8_t[]>(m_BufferSize),
+                                                            std::make_unique<uint8_t[]>(m_BufferSize)};
+        const base::DispatchGroup io_group;
+        base::SerialQueue write_queue;
+        copying::IOTuner tuner{m_BufferSize, {.max_block_size = m_BufferSize, .max_depth = m_MaxIODepth}};
+        const void *tuned_for[2] = {nullptr, nullptr};
+    };
+
     void Perform() override;
     void ProcessItems();
-    StepResult ProcessItemNo(int _item_number);
+    StepResult ProcessItemsSequentially();
+    StepResult ProcessItemsInLanes();
+    int LanesAmount() const noexcept;
+    StepResult ProcessItemNo(int _item_number, IOLane &_lane);
     StepResult ProcessSymlinkItem(VFSHost &_source_host,
                                   const std::string &_source_path,
+                                  int _source_index,
                                   const std::string &_destination_path,
                                   const RequestNonexistentDst &_new_dst_callback);
     StepResult ProcessDirectoryItem(VFSHost &_source_host,
@@ -94,24 +121,35 @@ private:
     PathCompositionType AnalyzeInitialDestination(std::string &_result_destination, bool &_need_to_build);
     StepResult BuildDestinationDirectory() const;
     std::tuple<StepResult, copying::SourceItems> ScanSourceItems();
+    bool ShouldScanDirectory(VFSHost &_host, const std::string &_path, const std::string &_relative_path) const;
     std::string ComposeDestinationNameForItem(int _src_item_index) const;
-    std::string ComposeDestinationNameForItemInDB(int _src_item_index, const copying::SourceItems &_db) const;
+    std::string ComposeDestinationNameForRelativePath(const std::string &_relative_src_path) const;
 
     // will be used for checksum calculation when copying verifiyng is enabled
     using SourceDataFeedback = std::function<void(const void *_data, unsigned _sz)>;
 
-    StepResult CopyNativeFileToNativeFile(vfs::NativeHost &_native_host,
+    StepResult CopyNativeFileToNativeFile(IOLane &_lane,
+                                          vfs::NativeHost &_native_host,
                                           const std::string &_src_path,
                                           const std::string &_dst_path,
                                           const SourceDataFeedback &_source_data_feedback,
                                           const RequestNonexistentDst &_new_dst_callback);
-    StepResult CopyVFSFileToNativeFile(VFSHost &_src_vfs,
+    std::optional<StepResult> CloneNativeFileToNativeFile(IOLane &_lane,
+                                                          vfs::NativeHost &_native_host,
+                                                          int _source_fd,
+                                                          struct stat &_src_stat,
+                                                          const std::string &_src_path,
+                                                          const std::string &_dst_path,
+                                                          const SourceDataFeedback &_source_data_feedback);
+    StepResult CopyVFSFileToNativeFile(IOLane &_lane,
+                                       VFSHost &_src_vfs,
                                        const std::string &_src_path,
                                        vfs::NativeHost &_dst_host,
                                        const std::string &_dst_path,
                                        const SourceDataFeedback &_source_data_feedback,
                                        const RequestNonexistentDst &_new_dst_callback);
-    StepResult CopyVFSFileToVFSFile(VFSHost &_src_vfs,
+    StepResult CopyVFSFileToVFSFile(IOLane &_lane,
+                                    VFSHost &_src_vfs,
                                     const std::string &_src_path,
                                     const std::string &_dst_path,
                                     const SourceDataFeedback &_source_data_feedback,
@@ -157,6 +195,9 @@ private:
                              const std::string &_dst_path,
                              const RequestNonexistentDst &_new_dst_callback) const;
     StepResult VerifyCopiedFile(const copying::ChecksumExpectation &_exp, bool &_matched);
+    void ScheduleVerification(copying::ChecksumExpectation _exp);
+    bool IsVerificationRequired() const noexcept;
+    void MarkSourceItemForDeletion(int _item_number);
     void ClearSourceItems();
     void ClearSourceItem(const std::string &_path, mode_t _mode, VFSHost &_host);
     void ApplyPermissionFixups();
@@ -164,10 +205,14 @@ private:
 
     void SetStage(enum Stage _stage);
 
-    void EraseXattrsFromNativeFD(int _fd_in) const;
-    void CopyXattrsFromNativeFDToNativeFD(int _fd_from, int _fd_to) const;
-    void CopyXattrsFromVFSFileToNativeFD(VFSFile &_source, int _fd_to) const;
-    void CopyXattrsFromVFSFileToPath(VFSFile &_file, const char *_fn_to) const;
+    IOLane &AcquireWorkerLane();
+    void ReleaseWorkerLane(IOLane &_lane);
+    void SerializeCallbacks();
+
+    static void EraseXattrsFromNativeFD(const IOLane &_lane, int _fd_in);
+    static void CopyXattrsFromNativeFDToNativeFD(const IOLane &_lane, int _fd_from, int _fd_to);
+    static void CopyXattrsFromVFSFileToNativeFD(const IOLane &_lane, VFSFile &_source, int _fd_to);
+    static void CopyXattrsFromVFSFileToPath(const IOLane &_lane, VFSFile &_file, const char *_fn_to);
 
     static bool IsNativeLockedItemNoFollow(const Error &_error, const std::string &_path);
     StepResult UnlockNativeItemNoFollow(const std::string &_path, vfs::NativeHost &_native_host) const;
@@ -176,9 +221,8 @@ private:
 
     const std::vector<VFSListingItem> m_VFSListingItems;
     copying::SourceItems m_SourceItems;
-    int m_CurrentlyProcessingSourceItemIndex = -1;
-    std::vector<copying::ChecksumExpectation> m_Checksums;
     std::vector<unsigned> m_SourceItemsToDelete;
+    std::mutex m_ItemsAftermathLock; // guards m_SourceItemsToDelete and item reports
     mutable std::vector<PermissionFixup> m_TargetPermissionsFixupEpilogue;
     mutable std::vector<TimestampFixup> m_TargetTimestampFixupEpilogue;
     const VFSHostPtr m_DestinationHost;
@@ -189,13 +233,25 @@ private:
     PathCompositionType m_PathCompositionType;
     nc::utility::NativeFSManager *const m_NativeFSManager;
 
-    // buffers are allocated once in job init and are used to manupulate files' bytes.
-    // thus no parallel routines should run using these buffers
+    // buffers are allocated once in job init and are used to manupulate files' bytes, a lane can lazily grow
+    // more of them when its tuner decides to keep more blocks in flight.
+    // the main lane is used by the job's thread, the worker lanes are created only when regular files are
+    // copied in parallel, i.e. when CopyingOptions::parallel_lanes is greater than 1 and all the hosts allow it.
     static const int m_BufferSize = 2 * 1024 * 1024;
-    const std::unique_ptr<uint8_t[]> m_Buffers[2] = {std::make_unique<uint8_t[]>(m_BufferSize),
-                                                     std::make_unique<uint8_t[]>(m_BufferSize)};
+    IOLane m_MainLane;
+    std::vector<std::unique_ptr<IOLane>> m_WorkerLanes;
+    std::vector<IOLane *> m_FreeWorkerLanes;
+    std::mutex m_FreeWorkerLanesLock;
+    std::condition_variable m_FreeWorkerLanesCV;
+    const base::DispatchGroup m_LanesGroup;
+    std::mutex m_CallbacksLock; // serializes the callbacks when items are processed in parallel
+
+    // copied files are verified in the background while the next ones are still being copied.
+    // the verification buffer is allocated only when the verification is required.
+    base::SerialQueue m_VerificationQueue;
+    std::unique_ptr<uint8_t[]> m_VerificationBuffer;
+    std::atomic_bool m_AllVerified = true;
 
-    const base::DispatchGroup m_IOGroup;
     bool m_IsSingleInitialItemProcessing = false;
     bool m_IsSingleScannedItemProcessing = false;
     bool m_IsSingleDirectoryCaseRenaming = false;
@@ -0,0 +1,107 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "IOTuner.h"
+#include <algorithm>
+#include <cmath>
+
+namespace nc::ops::copying {
+
+// relative changes of the bandwidth smaller than this are considered to be noise
+static constexpr double g_BandwidthTolerance = 0.05;
+
+// coefficients of variation of the per-byte latency which make the queue deeper or shallower
+static constexpr double g_JitteryLatency = 0.5;
+static constexpr double g_StableLatency = 0.2;
+
+IOTuner::IOTuner(size_t _initial_block_size, const Limits &_limits) noexcept
+    : m_Limits(_limits), m_BlockSize(0), m_Depth(_limits.min_depth)
+{
+    Reset(_initial_block_size);
+}
+
+size_t IOTuner::BlockSize() const noexcept
+{
+    return m_BlockSize;
+}
+
+int IOTuner::Depth() const noexcept
+{
+    return m_Depth;
+}
+
+void IOTuner::Reset(size_t _initial_block_size) noexcept
+{
+    m_BlockSize = std::clamp(_initial_block_size, m_Limits.min_block_size, m_Limits.max_block_size);
+    m_Depth = m_Limits.min_depth;
+    m_Direction = 1;
+    m_PrevBandwidth = 0.;
+    m_WindowBytes = 0;
+    m_WindowTime = std::chrono::nanoseconds{0};
+    m_WindowBlocks = 0;
+    m_WindowRateSum = 0.;
+    m_WindowRateSqSum = 0.;
+}
+
+void IOTuner::Commit(size_t _bytes, std::chrono::nanoseconds _latency) noexcept
+{
+    if( _bytes == 0 || _latency.count() <= 0 )
+        return;
+
+    const double rate = static_cast<double>(_latency.count()) / static_cast<double>(_bytes);
+    m_WindowBytes += _bytes;
+    m_WindowTime += _latency;
+    m_WindowBlocks += 1;
+    m_WindowRateSum += rate;
+    m_WindowRateSqSum += rate * rate;
+
+    if( m_WindowBlocks >= window_blocks && m_WindowTime >= window_duration )
+        Adjust();
+}
+
+void IOTuner::Adjust() noexcept
+{
+    const double bandwidth = static_cast<double>(m_WindowBytes) / static_cast<double>(m_WindowTime.count());
+    const double mean_rate = m_WindowRateSum / m_WindowBlocks;
+    const double variance = std::max(0., (m_WindowRateSqSum / m_WindowBlocks) - (mean_rate * mean_rate));
+    const double variation = std::sqrt(variance) / mean_rate;
+
+    if( variation > g_JitteryLatency )
+        m_Depth = std::min(m_Depth + 1, m_Limits.max_depth);
+    else if( variation < g_StableLatency )
+        m_Depth = std::max(m_Depth - 1, m_Limits.min_depth);
+
+    if( m_PrevBandwidth == 0. ) {
+        // the very first measurement - just probe the current direction
+        m_PrevBandwidth = bandwidth;
+        Step();
+    }
+    else if( bandwidth > m_PrevBandwidth * (1. + g_BandwidthTolerance) ) {
+        // got better - keep going
+        m_PrevBandwidth = bandwidth;
+        Step();
+    }
+    else if( bandwidth < m_PrevBandwidth * (1. - g_BandwidthTolerance) ) {
+        // got worse - turn around
+        m_PrevBandwidth = bandwidth;
+        m_Direction = -m_Direction;
+        Step();
+    }
+    else {
+        // no significant difference - stay with the current block size
+        m_PrevBandwidth = (m_PrevBandwidth + bandwidth) / 2.;
+    }
+
+    m_WindowBytes = 0;
+    m_WindowTime = std::chrono::nanoseconds{0};
+    m_WindowBlocks = 0;
+    m_WindowRateSum = 0.;
+    m_WindowRateSqSum = 0.;
+}
+
+void IOTuner::Step() noexcept
+{
+    const size_t next = m_Direction > 0 ? m_BlockSize * 2 : m_BlockSize / 2;
+    // stays at a limit until the bandwidth degrades and the direction turns around
+    m_BlockSize = std::clamp(next, m_Limits.min_block_size, m_Limits.max_block_size);
+}
+
+} // namespace nc::ops::copying
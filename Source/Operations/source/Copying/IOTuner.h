@@ -0,0 +1,58 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace nc::ops::copying {
+
+// Picks the size of I/O blocks and the number of blocks in flight based on the throughput observed so far.
+// The block size is tuned by a simple hill climbing: it keeps changing in the same direction while the bandwidth
+// improves and turns around once the bandwidth degrades. The queue depth grows when the latencies of individual
+// blocks are jittery, which is typical for network volumes, and shrinks back once they become stable.
+// Not thread-safe.
+class IOTuner
+{
+public:
+    struct Limits {
+        size_t min_block_size = 64 * 1024;
+        size_t max_block_size = 2 * 1024 * 1024;
+        int min_depth = 2;
+        int max_depth = 4;
+    };
+
+    IOTuner(size_t _initial_block_size, const Limits &_limits) noexcept;
+
+    // The size of the next block to read.
+    size_t BlockSize() const noexcept;
+
+    // The number of blocks which can be in flight simultaneously.
+    int Depth() const noexcept;
+
+    // Starts from scratch with the new initial block size, e.g. when the volumes being copied between change.
+    void Reset(size_t _initial_block_size) noexcept;
+
+    // Accounts a block of _bytes which took _latency to go through.
+    void Commit(size_t _bytes, std::chrono::nanoseconds _latency) noexcept;
+
+    // The minimal amount of blocks and time required to make a decision.
+    static constexpr int window_blocks = 4;
+    static constexpr std::chrono::milliseconds window_duration{50};
+
+private:
+    void Adjust() noexcept;
+    void Step() noexcept;
+
+    Limits m_Limits;
+    size_t m_BlockSize;
+    int m_Depth;
+    int m_Direction = 1;          // +1 - grow the blocks, -1 - shrink them
+    double m_PrevBandwidth = 0.;  // bytes per nanosecond observed in the previous window
+    size_t m_WindowBytes = 0;
+    std::chrono::nanoseconds m_WindowTime{0};
+    int m_WindowBlocks = 0;
+    double m_WindowRateSum = 0.;   // sum of per-block nanoseconds per byte
+    double m_WindowRateSqSum = 0.; // sum of squares of the same
+};
+
+} // namespace nc::ops::copying
@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2021 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 namespace nc::ops {
@@ -36,6 +36,11 @@ struct CopyingOptions {
     ChecksumVerification verification = ChecksumVerification::Never;
     ExistBehavior exist_behavior = ExistBehavior::Ask;
     LockedItemBehavior locked_items_behaviour = LockedItemBehavior::Ask;
+
+    // amount of regular files that can be copied simultaneously, each one with its own set of buffers.
+    // 1 means that all items are processed one by one. The job falls back to 1 unless both the source and the
+    // destination hosts can serve concurrent requests, see vfs::Host::CanServeConcurrently().
+    int parallel_lanes = 1;
 };
 
 } // namespace nc::ops
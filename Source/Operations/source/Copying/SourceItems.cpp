@@ -1,66 +1,203 @@
-// Copyright (C) 2017-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "SourceItems.h"
 #include <sys/stat.h>
 #include <Base/algo.h>
-#include <Utility/PathManip.h>
+#include <Base/UnorderedUtil.h>
+#include <cstring>
+#include <stdexcept>
 
 namespace nc::ops::copying {
 
+// Stores each distinct name only once.
+// The names are placed into fixed-size chunks which are never reallocated, each name is prefixed with its length.
+// A name is referred to by a 32-bit offset: chunk_index * g_ChunkSize + offset_in_chunk.
+class SourceItems::NamesPool
+{
+public:
+    NamesPool();
+    uint32_t Intern(std::string_view _name);
+    std::string_view Get(uint32_t _offset) const noexcept;
+
+private:
+    static constexpr size_t g_ChunkSize = 256 * 1024;
+    static constexpr size_t g_MaxChunks = (size_t(1) << 32) / g_ChunkSize;
+    using Length = uint16_t;
+
+    struct Hash {
+        using is_transparent = void;
+        using is_avalanching = void;
+        const NamesPool *pool;
+        size_t operator()(std::string_view _name) const noexcept;
+        size_t operator()(uint32_t _offset) const noexcept;
+    };
+
+    struct Equal {
+        using is_transparent = void;
+        const NamesPool *pool;
+        bool operator()(uint32_t _lhs, uint32_t _rhs) const noexcept;
+        bool operator()(std::string_view _lhs, uint32_t _rhs) const noexcept;
+        bool operator()(uint32_t _lhs, std::string_view _rhs) const noexcept;
+    };
+
+    std::vector<std::unique_ptr<char[]>> m_Chunks;
+    size_t m_ChunkFill = g_ChunkSize;
+    ankerl::unordered_dense::set<uint32_t, Hash, Equal> m_Index;
+};
+
+SourceItems::NamesPool::NamesPool() : m_Index(0, Hash{this}, Equal{this})
+{
+}
+
+uint32_t SourceItems::NamesPool::Intern(std::string_view _name)
+{
+    if( auto it = m_Index.find(_name); it != m_Index.end() )
+        return *it;
+
+    const size_t required = sizeof(Length) + _name.size();
+    if( required > g_ChunkSize )
+        throw std::invalid_argument("SourceItems::NamesPool::Intern: the name is too long");
+
+    if( g_ChunkSize - m_ChunkFill < required ) {
+        if( m_Chunks.size() == g_MaxChunks )
+            throw std::length_error("SourceItems::NamesPool::Intern: out of space");
+        m_Chunks.emplace_back(std::make_unique_for_overwrite<char[]>(g_ChunkSize));
+        m_ChunkFill = 0;
+    }
+
+    char *const place = m_Chunks.back().get() + m_ChunkFill;
+    const Length length = static_cast<Length>(_name.size());
+    std::memcpy(place, &length, sizeof(length));
+    std::memcpy(place + sizeof(length), _name.data(), _name.size());
+
+    const uint32_t offset = static_cast<uint32_t>(((m_Chunks.size() - 1) * g_ChunkSize) + m_ChunkFill);
+    m_ChunkFill += required;
+    m_Index.insert(offset);
+    return offset;
+}
+
+std::string_view SourceItems::NamesPool::Get(uint32_t _offset) const noexcept
+{
+    const char *const place = m_Chunks[_offset / g_ChunkSize].get() + (_offset % g_ChunkSize);
+    Length length;
+    std::memcpy(&length, place, sizeof(length));
+    return {place + sizeof(length), length};
+}
+
+size_t SourceItems::NamesPool::Hash::operator()(std::string_view _name) const noexcept
+{
+    return UnorderedStringHashEqual{}(_name);
+}
+
+size_t SourceItems::NamesPool::Hash::operator()(uint32_t _offset) const noexcept
+{
+    return UnorderedStringHashEqual{}(pool->Get(_offset));
+}
+
+bool SourceItems::NamesPool::Equal::operator()(uint32_t _lhs, uint32_t _rhs) const noexcept
+{
+    return _lhs == _rhs;
+}
+
+bool SourceItems::NamesPool::Equal::operator()(std::string_view _lhs, uint32_t _rhs) const noexcept
+{
+    return _lhs == pool->Get(_rhs);
+}
+
+bool SourceItems::NamesPool::Equal::operator()(uint32_t _lhs, std::string_view _rhs) const noexcept
+{
+    return pool->Get(_lhs) == _rhs;
+}
+
+SourceItems::SourceItems() : m_Names(std::make_unique<NamesPool>())
+{
+}
+
+SourceItems::SourceItems(SourceItems &&) noexcept = default;
+
+SourceItems::~SourceItems() = default;
+
+SourceItems &SourceItems::operator=(SourceItems &&) noexcept = default;
+
 int SourceItems::InsertItem(uint16_t _host_index,
                             unsigned _base_dir_index,
                             int _parent_index,
-                            std::string _item_name,
+                            std::string_view _item_name,
                             const VFSStat &_stat)
 {
     if( _host_index >= m_SourceItemsHosts.size() || _base_dir_index >= m_SourceItemsBaseDirectories.size() ||
         (_parent_index >= 0 && _parent_index >= static_cast<int>(m_Items.size())) )
         throw std::invalid_argument("SourceItems::InsertItem: invalid index");
 
+    if( !m_Names ) // a moved-from object
+        m_Names = std::make_unique<NamesPool>();
+
+    if( !_item_name.empty() && _item_name.back() == '/' )
+        _item_name.remove_suffix(1);
+
     if( S_ISREG(_stat.mode) )
         m_TotalRegBytes += _stat.size;
 
     SourceItem it;
-    it.item_name = S_ISDIR(_stat.mode) ? EnsureTrailingSlash(std::move(_item_name)) : std::move(_item_name);
+    it.name = m_Names->Intern(_item_name);
     it.parent_index = _parent_index;
     it.base_dir_index = _base_dir_index;
     it.host_index = _host_index;
     it.mode = _stat.mode;
     it.item_size = _stat.size;
 
-    m_Items.emplace_back(std::move(it));
+    m_Items.emplace_back(it);
 
     return int(m_Items.size() - 1);
 }
 
 std::string SourceItems::ComposeFullPath(int _item_no) const
 {
-    auto rel_path = ComposeRelativePath(_item_no);
-    rel_path.insert(0, m_SourceItemsBaseDirectories[m_Items[_item_no].base_dir_index]);
-    return rel_path;
+    std::string path;
+    ComposeFullPath(_item_no, path);
+    return path;
 }
 
 std::string SourceItems::ComposeRelativePath(int _item_no) const
 {
-    auto &meta = m_Items.at(_item_no);
-    std::array<int, 128> parents;
-    int parents_num = 0;
+    std::string path;
+    ComposeRelativePath(_item_no, path);
+    return path;
+}
+
+void SourceItems::ComposeFullPath(int _item_no, std::string &_buffer) const
+{
+    const auto &item = m_Items.at(_item_no);
+    const auto &base_dir = m_SourceItemsBaseDirectories[item.base_dir_index];
+    ComposeRelativePath(item, _buffer, base_dir.length());
+    std::memcpy(_buffer.data(), base_dir.data(), base_dir.length());
+}
 
-    int parent = meta.parent_index;
-    while( parent >= 0 ) {
-        parents[parents_num++] = parent;
-        parent = m_Items[parent].parent_index;
-    }
+void SourceItems::ComposeRelativePath(int _item_no, std::string &_buffer) const
+{
+    ComposeRelativePath(m_Items.at(_item_no), _buffer, 0);
+}
 
-    std::string path;
-    for( int i = parents_num - 1; i >= 0; i-- )
-        path += m_Items[parents[i]].item_name;
+// Composes the relative path from the end without any intermediate storage: the first pass gathers the length, the
+// second one writes the names right-to-left. Leaves _prefix_length bytes in front of the path for the caller to fill.
+void SourceItems::ComposeRelativePath(const SourceItem &_item, std::string &_buffer, size_t _prefix_length) const
+{
+    size_t length = m_Names->Get(_item.name).length();
+    for( int parent = _item.parent_index; parent >= 0; parent = m_Items[parent].parent_index )
+        length += m_Names->Get(m_Items[parent].name).length() + 1;
 
-    path += meta.item_name;
+    _buffer.resize(_prefix_length + length);
+    char *cursor = _buffer.data() + _buffer.length();
 
-    if( !path.empty() && path.back() == '/' )
-        path.pop_back();
+    const auto prepend = [&](std::string_view _name) {
+        cursor -= _name.length();
+        std::memcpy(cursor, _name.data(), _name.length());
+    };
 
-    return path;
+    prepend(m_Names->Get(_item.name));
+    for( int parent = _item.parent_index; parent >= 0; parent = m_Items[parent].parent_index ) {
+        *--cursor = '/';
+        prepend(m_Names->Get(m_Items[parent].name));
+    }
 }
 
 int SourceItems::ItemsAmount() const noexcept
@@ -83,9 +220,9 @@ uint64_t SourceItems::ItemSize(int _item_no) const
     return m_Items.at(_item_no).item_size;
 }
 
-const std::string &SourceItems::ItemName(int _item_no) const
+std::string_view SourceItems::ItemName(int _item_no) const
 {
-    return m_Items.at(_item_no).item_name;
+    return m_Names->Get(m_Items.at(_item_no).name);
 }
 
 VFSHost &SourceItems::ItemHost(int _item_no) const
@@ -113,4 +250,9 @@ VFSHost &SourceItems::Host(uint16_t _ind) const
     return *m_SourceItemsHosts.at(_ind);
 }
 
+uint16_t SourceItems::HostsAmount() const noexcept
+{
+    return static_cast<uint16_t>(m_SourceItemsHosts.size());
+}
+
 } // namespace nc::ops::copying
@@ -1,17 +1,24 @@
-// Copyright (C) 2017-2020 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <VFS/VFS.h>
+#include <memory>
+#include <string_view>
 
 namespace nc::ops::copying {
 
 class SourceItems
 {
 public:
+    SourceItems();
+    SourceItems(SourceItems &&) noexcept;
+    ~SourceItems();
+    SourceItems &operator=(SourceItems &&) noexcept;
+
     int InsertItem(uint16_t _host_index,
                    unsigned _base_dir_index,
                    int _parent_index,
-                   std::string _item_name,
+                   std::string_view _item_name,
                    const VFSStat &_stat);
 
     uint64_t TotalRegBytes() const noexcept;
@@ -19,32 +26,44 @@ public:
 
     std::string ComposeFullPath(int _item_no) const;
     std::string ComposeRelativePath(int _item_no) const;
-    const std::string &ItemName(int _item_no) const;
+
+    // Same as above, but the path is written into _buffer, which is reused without allocations if it's large enough.
+    void ComposeFullPath(int _item_no, std::string &_buffer) const;
+    void ComposeRelativePath(int _item_no, std::string &_buffer) const;
+
+    // Returns the name of the item without a trailing slash, the view is valid while the object is alive.
+    std::string_view ItemName(int _item_no) const;
     mode_t ItemMode(int _item_no) const;
     uint64_t ItemSize(int _item_no) const;
     VFSHost &ItemHost(int _item_no) const;
 
     VFSHost &Host(uint16_t _host_ind) const;
+    uint16_t HostsAmount() const noexcept;
     uint16_t InsertOrFindHost(const VFSHostPtr &_host);
 
     const std::string &BaseDir(unsigned _base_dir_ind) const;
     unsigned InsertOrFindBaseDir(const std::string &_dir);
 
 private:
+    class NamesPool;
+
     struct SourceItem {
         // full path = m_SourceItemsBaseDirectories[base_dir_index] + ... +
-        //             m_Items[m_Items[parent_index].parent_index].item_name +
-        //             m_Items[parent_index].item_name +
-        //             item_name;
-        std::string item_name;
+        //             name(m_Items[m_Items[parent_index].parent_index]) + '/' +
+        //             name(m_Items[parent_index]) + '/' +
+        //             name(this);
         uint64_t item_size;
+        uint32_t name; // an offset of the interned name in m_Names
         int parent_index;
         unsigned base_dir_index;
         uint16_t host_index;
         uint16_t mode;
     };
 
+    void ComposeRelativePath(const SourceItem &_item, std::string &_buffer, size_t _prefix_length) const;
+
     std::vector<SourceItem> m_Items;
+    std::unique_ptr<NamesPool> m_Names;
     std::vector<VFSHostPtr> m_SourceItemsHosts;
     std::vector<std::string> m_SourceItemsBaseDirectories;
     uint64_t m_TotalRegBytes = 0;
@@ -1,5 +1,6 @@
 // Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "DeletionJob.h"
+#include <Base/ParallelTreeWalker.h>
 #include <Utility/PathManip.h>
 #include <Utility/NativeFSManager.h>
 #include <dirent.h>
@@ -68,61 +69,93 @@ void DeletionJob::DoScan()
     }
 }
 
+struct DeletionJob::ScannedEntry {
+    std::string name;
+    bool is_dir = false;
+    std::vector<ScannedEntry> children;
+};
+
 void DeletionJob::ScanDirectory(const std::string &_path,
                                 int _listing_item_index,
                                 const base::chained_strings::node *_prefix)
 {
     auto &vfs = *m_SourceItems[_listing_item_index].Host();
 
-    std::vector<VFSDirEnt> dir_entries;
-    const auto it_callback = [&](const VFSDirEnt &_entry) {
-        dir_entries.emplace_back(_entry);
-        return true;
+    struct Directory {
+        ScannedEntry *entry = nullptr;
+        std::string path;
     };
-    while( true ) {
-        if( BlockIfPaused(); IsStopped() )
-            return;
 
-        if( const std::expected<void, Error> rc = vfs.IterateDirectoryListing(_path, it_callback); rc )
-            break;
-        else
-            switch( m_OnReadDirError(rc.error(), _path, vfs) ) {
-                case ReadDirErrorResolution::Retry:
-                    continue;
-                case ReadDirErrorResolution::Stop:
-                    Stop();
-                    [[fallthrough]];
-                case ReadDirErrorResolution::Skip:
-                    return;
+    std::mutex callbacks_lock; // the user is asked one question at a time
+    const auto visit = [&](Directory _directory, std::vector<Directory> &_subdirectories) {
+        std::vector<VFSDirEnt> dir_entries;
+        const auto it_callback = [&](const VFSDirEnt &_entry) {
+            dir_entries.emplace_back(_entry);
+            return true;
+        };
+        while( true ) {
+            if( const std::expected<void, Error> rc = vfs.IterateDirectoryListing(_directory.path, it_callback); rc )
+                break;
+            else {
+                dir_entries.clear();
+                const auto lock = std::lock_guard{callbacks_lock};
+                switch( m_OnReadDirError(rc.error(), _directory.path, vfs) ) {
+                    case ReadDirErrorResolution::Retry:
+                        continue;
+                    case ReadDirErrorResolution::Stop:
+                        Stop();
+                        [[fallthrough]];
+                    case ReadDirErrorResolution::Skip:
+                        return;
+                }
             }
-    }
+        }
 
-    for( const auto &e : dir_entries ) {
-        if( BlockIfPaused(); IsStopped() )
-            return;
+        auto &children = _directory.entry->children;
+        children.reserve(dir_entries.size());
+        for( const auto &e : dir_entries ) {
+            Statistics().CommitEstimated(Statistics::SourceType::Items, 1);
+            if( e.type == DT_DIR )
+                children.emplace_back(ScannedEntry{.name = e.name, .is_dir = true, .children = {}});
+            else if( !IsEAStorage(vfs, _directory.path, e.name, static_cast<uint8_t>(e.type)) )
+                children.emplace_back(ScannedEntry{.name = e.name, .is_dir = false, .children = {}});
+        }
 
-        Statistics().CommitEstimated(Statistics::SourceType::Items, 1);
-        if( e.type == DT_DIR ) {
-            m_Paths.push_back(EnsureTrailingSlash(e.name), _prefix);
-            SourceItem si;
-            si.listing_item_index = _listing_item_index;
-            si.filename = &m_Paths.back();
-            si.type = DeletionType::Permanent;
-            m_Script.emplace(si);
+        // the children vector won't be touched anymore, so it's safe to hand out the pointers
+        for( auto &child : children )
+            if( child.is_dir )
+                _subdirectories.emplace_back(Directory{&child, EnsureTrailingSlash(_directory.path) + child.name});
+    };
 
-            ScanDirectory(EnsureTrailingSlash(_path) + e.name, _listing_item_index, si.filename);
-        }
-        else {
-            const auto is_ea_storage = IsEAStorage(vfs, _path, e.name, static_cast<uint8_t>(e.type));
-            if( !is_ea_storage ) {
-                m_Paths.push_back(e.name, _prefix);
-                SourceItem si;
-                si.listing_item_index = _listing_item_index;
-                si.filename = &m_Paths.back();
-                si.type = DeletionType::Permanent;
-                m_Script.emplace(si);
-            }
-        }
+    const int workers = vfs.CanServeConcurrently() ? base::ParallelTreeWalker<Directory>::DefaultConcurrency() : 1;
+    base::ParallelTreeWalker<Directory> walker(workers, visit, [this] {
+        BlockIfPaused();
+        return IsStopped();
+    });
+    ScannedEntry root;
+    walker.Walk({Directory{&root, _path}});
+
+    if( BlockIfPaused(); IsStopped() )
+        return;
+
+    InsertScannedEntries(root.children, _listing_item_index, _prefix);
+}
+
+// Puts the entries into the script in the same order a depth-first scanning would produce.
+void DeletionJob::InsertScannedEntries(std::vector<ScannedEntry> &_entries,
+                                       int _listing_item_index,
+                                       const base::chained_strings::node *_prefix)
+{
+    for( auto &e : _entries ) {
+        m_Paths.push_back(e.is_dir ? EnsureTrailingSlash(std::move(e.name)) : e.name, _prefix);
+        SourceItem si;
+        si.listing_item_index = _listing_item_index;
+        si.filename = &m_Paths.back();
+        si.type = DeletionType::Permanent;
+        m_Script.emplace(si);
+
+        if( e.is_dir )
+            InsertScannedEntries(e.children, _listing_item_index, si.filename);
     }
 }
 
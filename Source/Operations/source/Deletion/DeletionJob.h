@@ -24,6 +24,7 @@ private:
         DeletionType type;
         const base::chained_strings::node *filename;
     };
+    struct ScannedEntry;
 
     virtual void Perform() override;
     void DoScan();
@@ -33,6 +34,9 @@ private:
     void DoTrash(const std::string &_path, VFSHost &_vfs, SourceItem _src);
     bool DoUnlock(const std::string &_path, VFSHost &_vfs);
     void ScanDirectory(const std::string &_path, int _listing_item_index, const base::chained_strings::node *_prefix);
+    void InsertScannedEntries(std::vector<ScannedEntry> &_entries,
+                              int _listing_item_index,
+                              const base::chained_strings::node *_prefix);
     static bool IsNativeLockedItem(const nc::Error &_err, const std::string &_path, VFSHost &_vfs);
     static std::expected<void, Error> UnlockItem(std::string_view _path, VFSHost &_vfs);
 
@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Progress.h"
 #include <iostream>
 #include <Base/mach_time.h>
@@ -32,11 +32,13 @@ void Progress::CommitSkipped(uint64_t _delta)
 void Progress::CommitProcessed(uint64_t _delta)
 {
     const auto current_time = base::machtime();
-    m_TimepointsLock.lock();
+    // the lock is held for the whole update since the commits can come from several threads simultaneously
+    auto lock = std::lock_guard{m_TimepointsLock};
     const auto delta_time = current_time - m_LastCommitTimePoint;
     m_LastCommitTimePoint = current_time;
     m_Processed += _delta;
-    m_TimepointsLock.unlock();
+    if( delta_time.count() <= 0 )
+        return;
 
     const auto fp_bytes = double(_delta);
     const auto fp_delta_time = static_cast<double>(delta_time.count()) / 1000000000.;
@@ -353,6 +353,113 @@ TEST_CASE(PREFIX "Item reporting")
     CHECK(processed == expected);
 }
 
+TEST_CASE(PREFIX "Compressing /bin into tar.zst")
+{
+    const TempTestDir tmp_dir;
+    const auto native_host = TestEnv().vfs_native;
+
+    Compression operation{FetchItems("/", {"bin"}, *native_host), tmp_dir.directory, native_host, "",
+                          CompressionFormat::TarZstd};
+    operation.Start();
+    operation.Wait();
+
+    REQUIRE(operation.State() == OperationState::Completed);
+    CHECK(operation.ArchivePath().ends_with("/bin.tar.zst"));
+    REQUIRE(native_host->Exists(operation.ArchivePath()));
+
+    std::shared_ptr<vfs::ArchiveHost> arc_host;
+    REQUIRE_NOTHROW(arc_host = std::make_shared<vfs::ArchiveHost>(operation.ArchivePath().c_str(), native_host));
+    CHECK(VFSCompareEntries("/bin/", native_host, "/bin/", arc_host).value() == 0);
+}
+
+TEST_CASE(PREFIX "Compressing Chess.app into tar.xz")
+{
+    const TempTestDir tmp_dir;
+    const auto native_host = TestEnv().vfs_native;
+
+    Compression operation{FetchItems("/System/Applications/", {"Chess.app"}, *native_host),
+                          tmp_dir.directory,
+                          native_host,
+                          "",
+                          CompressionFormat::TarXz};
+    operation.Start();
+    operation.Wait();
+
+    REQUIRE(operation.State() == OperationState::Completed);
+    CHECK(operation.ArchivePath().ends_with("/Chess.app.tar.xz"));
+    REQUIRE(native_host->Exists(operation.ArchivePath()));
+
+    std::shared_ptr<vfs::ArchiveHost> arc_host;
+    REQUIRE_NOTHROW(arc_host = std::make_shared<vfs::ArchiveHost>(operation.ArchivePath().c_str(), native_host));
+    CHECK(VFSCompareEntries("/System/Applications/Chess.app", native_host, "/Chess.app", arc_host).value() == 0);
+}
+
+TEST_CASE(PREFIX "Tar archives keep xattrs")
+{
+    const TempTestDir tmp_dir;
+    const auto native_host = TestEnv().vfs_native;
+    const std::filesystem::path filepath = tmp_dir.directory / "a";
+    REQUIRE(touch(filepath));
+    REQUIRE(setxattr(filepath.c_str(), "hello", "privet", 6, 0, 0) == 0);
+
+    Compression operation{FetchItems(tmp_dir.directory, {"a"}, *native_host),
+                          tmp_dir.directory,
+                          native_host,
+                          "",
+                          CompressionFormat::TarZstd};
+    operation.Start();
+    operation.Wait();
+    REQUIRE(operation.State() == OperationState::Completed);
+
+    std::shared_ptr<vfs::ArchiveHost> arc_host;
+    REQUIRE_NOTHROW(arc_host = std::make_shared<vfs::ArchiveHost>(operation.ArchivePath().c_str(), native_host));
+    CHECK(arc_host->StatTotalFiles() == 1);
+    const std::shared_ptr<VFSFile> file = arc_host->CreateFile("/a").value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == VFSError::Ok);
+    REQUIRE(file->XAttrCount() == 1);
+    char buf[16] = {};
+    REQUIRE(file->XAttrGet("hello", buf, sizeof(buf)) == 6);
+    CHECK(std::string_view(buf, 6) == "privet");
+}
+
+TEST_CASE(PREFIX "Large files are deflated in multiple chunks")
+{
+    const TempTestDir tmp_dir;
+    const auto native_host = TestEnv().vfs_native;
+    const std::filesystem::path filepath = tmp_dir.directory / "large.bin";
+    {
+        // 20MB of moderately compressible data, i.e. many chunks
+        std::vector<uint8_t> data(20 * 1024 * 1024);
+        for( size_t i = 0; i < data.size(); ++i )
+            data[i] = static_cast<uint8_t>((i * 7919) % 251 ^ (i >> 13));
+        const int fd = open(filepath.c_str(), O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
+        REQUIRE(fd >= 0);
+        REQUIRE(write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+        close(fd);
+    }
+
+    Compression operation{FetchItems(tmp_dir.directory, {"large.bin"}, *native_host), tmp_dir.directory, native_host};
+    operation.Start();
+    operation.Wait();
+    REQUIRE(operation.State() == OperationState::Completed);
+
+    std::shared_ptr<vfs::ArchiveHost> arc_host;
+    REQUIRE_NOTHROW(arc_host = std::make_shared<vfs::ArchiveHost>(operation.ArchivePath().c_str(), native_host));
+    CHECK(VFSEasyCompareFiles(filepath.c_str(), native_host, "/large.bin", arc_host) == 0);
+}
+
+TEST_CASE(PREFIX "Only Zip archives can be encrypted")
+{
+    const TempTestDir tmp_dir;
+    const auto native_host = TestEnv().vfs_native;
+    CHECK_THROWS_AS(Compression(std::vector<VFSListingItem>{},
+                                tmp_dir.directory,
+                                native_host,
+                                "password",
+                                CompressionFormat::TarXz),
+                    std::invalid_argument);
+}
+
 static std::expected<int, Error> VFSCompareEntries(const std::filesystem::path &_file1_full_path,
                                                    const VFSHostPtr &_file1_host,
                                                    const std::filesystem::path &_file2_full_path,
@@ -0,0 +1,65 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "../source/Copying/IOTuner.h"
+
+using nc::ops::copying::IOTuner;
+using namespace std::chrono_literals;
+
+#define PREFIX "nc::ops::copying::IOTuner "
+
+static constexpr size_t KB = 1024;
+static constexpr size_t MB = 1024 * 1024;
+
+TEST_CASE(PREFIX "clamps the initial block size")
+{
+    const IOTuner::Limits limits{.min_block_size = 64 * KB, .max_block_size = 2 * MB, .min_depth = 2, .max_depth = 4};
+    CHECK(IOTuner(4 * KB, limits).BlockSize() == 64 * KB);
+    CHECK(IOTuner(1 * MB, limits).BlockSize() == 1 * MB);
+    CHECK(IOTuner(16 * MB, limits).BlockSize() == 2 * MB);
+    CHECK(IOTuner(1 * MB, limits).Depth() == 2);
+}
+
+TEST_CASE(PREFIX "grows the blocks when a per-block overhead dominates")
+{
+    // e.g. a network volume with a round-trip for each request
+    IOTuner tuner(128 * KB, {});
+    for( int i = 0; i < 200; ++i ) {
+        const size_t bytes = tuner.BlockSize();
+        tuner.Commit(bytes, std::chrono::nanoseconds(bytes) + 5ms);
+    }
+    CHECK(tuner.BlockSize() == 2 * MB);
+}
+
+TEST_CASE(PREFIX "shrinks the blocks when large blocks are slower")
+{
+    IOTuner tuner(1 * MB, {});
+    for( int i = 0; i < 400; ++i ) {
+        const size_t bytes = tuner.BlockSize();
+        const auto per_byte = static_cast<int64_t>(bytes / KB); // the larger the block - the slower each byte is
+        tuner.Commit(bytes, std::chrono::nanoseconds(static_cast<int64_t>(bytes) * per_byte));
+    }
+    CHECK(tuner.BlockSize() == 64 * KB);
+}
+
+TEST_CASE(PREFIX "adjusts the queue depth according to the latency jitter")
+{
+    IOTuner tuner(1 * MB, {});
+    for( int i = 0; i < 100; ++i )
+        tuner.Commit(tuner.BlockSize(), (i % 4 == 0 ? 200ms : 5ms));
+    CHECK(tuner.Depth() == 4);
+
+    for( int i = 0; i < 100; ++i )
+        tuner.Commit(tuner.BlockSize(), 20ms);
+    CHECK(tuner.Depth() == 2);
+}
+
+TEST_CASE(PREFIX "ignores empty measurements")
+{
+    IOTuner tuner(1 * MB, {});
+    for( int i = 0; i < 100; ++i ) {
+        tuner.Commit(0, 100ms);
+        tuner.Commit(1 * MB, 0ns);
+    }
+    CHECK(tuner.BlockSize() == 1 * MB);
+    CHECK(tuner.Depth() == 2);
+}
@@ -0,0 +1,147 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "Tests.h"
+#include "TestEnv.h"
+#include "../source/Copying/SourceItems.h"
+#include <fmt/format.h>
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#include <sys/stat.h>
+
+using nc::ops::copying::SourceItems;
+
+#define PREFIX "nc::ops::copying::SourceItems performance "
+
+// 1000 directories * 50 subdirectories * 100 files = 5'051'000 items.
+// Half of the files have unique names, the other half repeat the same names in every subdirectory.
+static constexpr int g_Dirs = 1000;
+static constexpr int g_Subdirs = 50;
+static constexpr int g_Files = 100;
+
+// The layout which SourceItems used to have: a separate std::string per item.
+struct LegacySourceItem {
+    std::string item_name;
+    uint64_t item_size;
+    int parent_index;
+    unsigned base_dir_index;
+    uint16_t host_index;
+    uint16_t mode;
+};
+
+static size_t ResidentSize()
+{
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if( task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) !=
+        KERN_SUCCESS )
+        return 0;
+    return info.resident_size;
+}
+
+static size_t HeapInUse()
+{
+    malloc_statistics_t stats;
+    malloc_zone_statistics(nullptr, &stats);
+    return stats.size_in_use;
+}
+
+// Calls _emit(parent, name, is_dir) for each item of the synthetic tree, _emit returns the index of the new item
+template <class Emit>
+static void GenerateTree(Emit _emit)
+{
+    int counter = 0;
+    for( int d = 0; d < g_Dirs; ++d ) {
+        const int dir = _emit(-1, fmt::format("dir{}", d), true);
+        for( int s = 0; s < g_Subdirs; ++s ) {
+            const int subdir = _emit(dir, fmt::format("subdirectory{}", s), true);
+            for( int f = 0; f < g_Files; ++f ) {
+                if( f % 2 )
+                    _emit(subdir, fmt::format("photo_{:07}_thumbnail.jpeg", counter++), false);
+                else
+                    _emit(subdir, fmt::format("part{}.bin", f), false);
+            }
+        }
+    }
+}
+
+static VFSStat MakeStat(bool _is_dir)
+{
+    VFSStat st;
+    st.mode = _is_dir ? (S_IFDIR | S_IRWXU) : (S_IFREG | S_IRUSR | S_IWUSR);
+    st.size = _is_dir ? 0 : 4096;
+    return st;
+}
+
+TEST_CASE(PREFIX "memory consumption of 5M items")
+{
+    // both DBs are kept alive until the end, so that the second one doesn't reuse the memory freed by the first one
+    const size_t rss0 = ResidentSize();
+    const size_t heap0 = HeapInUse();
+
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/Volumes/Storage/");
+    GenerateTree([&](int _parent, std::string _name, bool _is_dir) {
+        return db.InsertItem(host, base, _parent, _name, MakeStat(_is_dir));
+    });
+    const size_t rss1 = ResidentSize();
+    const size_t heap1 = HeapInUse();
+
+    std::vector<LegacySourceItem> legacy;
+    GenerateTree([&](int _parent, std::string _name, bool _is_dir) {
+        const VFSStat st = MakeStat(_is_dir);
+        legacy.emplace_back(LegacySourceItem{.item_name = _is_dir ? _name + "/" : std::move(_name),
+                                             .item_size = st.size,
+                                             .parent_index = _parent,
+                                             .base_dir_index = 0,
+                                             .host_index = 0,
+                                             .mode = st.mode});
+        return static_cast<int>(legacy.size() - 1);
+    });
+    const size_t rss2 = ResidentSize();
+    const size_t heap2 = HeapInUse();
+
+    REQUIRE(db.ItemsAmount() == static_cast<int>(legacy.size()));
+    const auto mb = [](size_t _before, size_t _after) { return double(_after - std::min(_before, _after)) / 1048576.; };
+    WARN(fmt::format("{} items. SourceItems: {:.1f}MB RSS, {:.1f}MB heap. Legacy layout: {:.1f}MB RSS, {:.1f}MB heap.",
+                     legacy.size(),
+                     mb(rss0, rss1),
+                     mb(heap0, heap1),
+                     mb(rss1, rss2),
+                     mb(heap1, heap2)));
+    CHECK(heap1 - heap0 < heap2 - heap1);
+}
+
+TEST_CASE(PREFIX "composing paths")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/Volumes/Storage/");
+    int counter = 0;
+    for( int d = 0; d < 10; ++d ) {
+        const int dir = db.InsertItem(host, base, -1, fmt::format("dir{}", d), MakeStat(true));
+        for( int s = 0; s < 10; ++s ) {
+            const int subdir = db.InsertItem(host, base, dir, fmt::format("subdirectory{}", s), MakeStat(true));
+            for( int f = 0; f < 100; ++f )
+                db.InsertItem(host, base, subdir, fmt::format("photo_{:07}.jpeg", counter++), MakeStat(false));
+        }
+    }
+
+    BENCHMARK("ComposeFullPath() returning a string")
+    {
+        size_t total = 0;
+        for( int i = 0, e = db.ItemsAmount(); i != e; ++i )
+            total += db.ComposeFullPath(i).length();
+        return total;
+    };
+    BENCHMARK("ComposeFullPath() into a buffer")
+    {
+        size_t total = 0;
+        std::string buffer;
+        for( int i = 0, e = db.ItemsAmount(); i != e; ++i ) {
+            db.ComposeFullPath(i, buffer);
+            total += buffer.length();
+        }
+        return total;
+    };
+}
@@ -0,0 +1,120 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "TestEnv.h"
+#include "../source/Copying/SourceItems.h"
+#include <sys/stat.h>
+
+using nc::ops::copying::SourceItems;
+
+#define PREFIX "nc::ops::copying::SourceItems "
+
+static VFSStat Dir()
+{
+    VFSStat st;
+    st.mode = S_IFDIR | S_IRWXU;
+    return st;
+}
+
+static VFSStat Reg(uint64_t _size)
+{
+    VFSStat st;
+    st.mode = S_IFREG | S_IRUSR | S_IWUSR;
+    st.size = _size;
+    return st;
+}
+
+TEST_CASE(PREFIX "composes paths")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/Users/Foo/");
+    const int a = db.InsertItem(host, base, -1, "a", Dir());
+    const int b = db.InsertItem(host, base, a, "b/", Dir());
+    const int c = db.InsertItem(host, base, b, "c.txt", Reg(10));
+    const int d = db.InsertItem(host, base, -1, "d.txt", Reg(32));
+
+    CHECK(db.ItemsAmount() == 4);
+    CHECK(db.TotalRegBytes() == 42);
+    CHECK(db.ComposeRelativePath(a) == "a");
+    CHECK(db.ComposeRelativePath(b) == "a/b");
+    CHECK(db.ComposeRelativePath(c) == "a/b/c.txt");
+    CHECK(db.ComposeRelativePath(d) == "d.txt");
+    CHECK(db.ComposeFullPath(a) == "/Users/Foo/a");
+    CHECK(db.ComposeFullPath(c) == "/Users/Foo/a/b/c.txt");
+    CHECK(db.ItemName(b) == "b");
+    CHECK(db.ItemName(c) == "c.txt");
+    CHECK(db.ItemSize(c) == 10);
+    CHECK(S_ISDIR(db.ItemMode(b)));
+    CHECK(&db.ItemHost(c) == TestEnv().vfs_native.get());
+}
+
+TEST_CASE(PREFIX "reuses the provided buffer")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/tmp/");
+    const int a = db.InsertItem(host, base, -1, "directory", Dir());
+    const int b = db.InsertItem(host, base, a, "file", Reg(1));
+
+    std::string buffer;
+    buffer.reserve(256);
+    const char *const data = buffer.data();
+    db.ComposeFullPath(b, buffer);
+    CHECK(buffer == "/tmp/directory/file");
+    db.ComposeRelativePath(a, buffer);
+    CHECK(buffer == "directory");
+    db.ComposeFullPath(a, buffer);
+    CHECK(buffer == "/tmp/directory");
+    CHECK(buffer.data() == data);
+}
+
+TEST_CASE(PREFIX "interns the names")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/");
+    std::vector<int> dirs;
+    for( int i = 0; i < 100; ++i )
+        dirs.emplace_back(db.InsertItem(host, base, -1, "dir" + std::to_string(i), Dir()));
+    std::vector<int> files;
+    for( int dir : dirs )
+        files.emplace_back(db.InsertItem(host, base, dir, ".DS_Store", Reg(6)));
+
+    CHECK(db.ItemName(files.front()).data() == db.ItemName(files.back()).data());
+    CHECK(db.ComposeFullPath(files[42]) == "/dir42/.DS_Store");
+}
+
+TEST_CASE(PREFIX "handles deep hierarchies")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/");
+    int parent = -1;
+    std::string expected;
+    for( int i = 0; i < 1000; ++i ) {
+        parent = db.InsertItem(host, base, parent, "d", Dir());
+        expected += i == 0 ? "d" : "/d";
+    }
+    CHECK(db.ComposeRelativePath(parent) == expected);
+}
+
+TEST_CASE(PREFIX "stays valid after being moved")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/");
+    const int a = db.InsertItem(host, base, -1, "a", Dir());
+    SourceItems moved = std::move(db);
+    const int b = moved.InsertItem(host, base, a, "a", Reg(1));
+    CHECK(moved.ComposeFullPath(b) == "/a/a");
+}
+
+TEST_CASE(PREFIX "rejects invalid indices")
+{
+    SourceItems db;
+    const auto host = db.InsertOrFindHost(TestEnv().vfs_native);
+    const auto base = db.InsertOrFindBaseDir("/");
+    CHECK_THROWS_AS(db.InsertItem(host, base, 0, "a", Dir()), std::invalid_argument);
+    CHECK_THROWS_AS(db.InsertItem(host + 1, base, -1, "a", Dir()), std::invalid_argument);
+    CHECK_THROWS_AS(db.InsertItem(host, base + 1, -1, "a", Dir()), std::invalid_argument);
+}
@@ -2,6 +2,7 @@
 #include "Tests.h"
 #include "TestEnv.h"
 #include <Operations/Copying.h>
+#include <Operations/Statistics.h>
 #include <Utility/NativeFSManager.h>
 #include <VFS/Native.h>
 #include <VFS/XAttr.h>
@@ -10,7 +11,10 @@
 #include <VFS/ArcLA.h>
 #include <Base/algo.h>
 #include <Base/WriteAtomically.h>
+#include <fmt/format.h>
 #include <set>
+#include <sys/xattr.h>
+#include <sys/attr.h>
 #include <span>
 #include <fstream>
 #include <compare>
@@ -382,6 +386,46 @@ TEST_CASE(PREFIX "Modes - CopyToPrefix")
                               TestEnv().vfs_native) == 0);
 }
 
+TEST_CASE(PREFIX "Modes - CopyToPrefix, parallel lanes")
+{
+    const TempTestDir tmp_dir;
+    const auto host = TestEnv().vfs_native;
+    CopyingOptions opts;
+    opts.parallel_lanes = 4;
+    Copying op(FetchItems("/System/Applications/", {"Mail.app"}, *TestEnv().vfs_native), tmp_dir.directory, host, opts);
+    RunOperationAndCheckSuccess(op);
+
+    REQUIRE(VFSCompareEntries(std::filesystem::path("/System/Applications") / "Mail.app",
+                              TestEnv().vfs_native,
+                              tmp_dir.directory / "Mail.app",
+                              TestEnv().vfs_native) == 0);
+}
+
+TEST_CASE(PREFIX "Moving with parallel lanes deletes the source items afterwards")
+{
+    const TempTestDir tmp_dir;
+    const auto host = TestEnv().vfs_native;
+    const auto src_dir = tmp_dir.directory / "src";
+    const auto dst_dir = tmp_dir.directory / "dst";
+    REQUIRE(std::filesystem::create_directories(src_dir / "a" / "b"));
+    for( int i = 0; i < 100; ++i ) {
+        const auto noise = MakeNoise(static_cast<size_t>(i) * 1000);
+        REQUIRE(Save(src_dir / "a" / fmt::format("{}.bin", i), noise));
+        REQUIRE(Save(src_dir / "a" / "b" / fmt::format("{}.bin", i), noise));
+    }
+
+    CopyingOptions opts;
+    opts.docopy = false;
+    opts.parallel_lanes = 8;
+    opts.verification = CopyingOptions::ChecksumVerification::Always;
+    REQUIRE(VFSEasyCopyNode(src_dir.c_str(), host, (tmp_dir.directory / "etalon").c_str(), host) == 0);
+    Copying op(FetchItems(src_dir.native(), {"a"}, *host), dst_dir.native() + "/", host, opts);
+    RunOperationAndCheckSuccess(op);
+
+    CHECK(!std::filesystem::exists(src_dir / "a"));
+    CHECK(VFSCompareEntries(tmp_dir.directory / "etalon" / "a", host, dst_dir / "a", host) == 0);
+}
+
 TEST_CASE(PREFIX "Modes - CopyToPrefix, with absent directories in path")
 {
     const TempTestDir tmp_dir;
@@ -1412,6 +1456,117 @@ TEST_CASE(PREFIX "Setting directory permissions in an epilogue - (vfs -> vfs)")
     std::ignore = VFSEasyDelete(target_dir.c_str(), host);
 }
 
+TEST_CASE(PREFIX "Copying files within an SFTP host with parallel lanes")
+{
+    const TempTestDir tmp_dir;
+    const auto src_dir = tmp_dir.directory / "src";
+    REQUIRE(std::filesystem::create_directory(src_dir));
+    for( int i = 0; i < 16; ++i )
+        REQUIRE(Save(src_dir / fmt::format("{}.bin", i), MakeNoise(static_cast<size_t>(i) * 10'000)));
+
+    auto host = TestEnvironment::SpawnSFTPHost();
+    REQUIRE(host);
+    const std::filesystem::path target_dir = std::filesystem::path(host->HomeDir()) / "__nc_operations_test";
+    std::ignore = VFSEasyDelete(target_dir.c_str(), host);
+    auto cleanup = at_scope_end([&] { std::ignore = VFSEasyDelete(target_dir.c_str(), host); });
+    REQUIRE(VFSEasyCopyNode(src_dir.c_str(), TestEnv().vfs_native, (target_dir / "src").c_str(), host) == 0);
+
+    // each lane holds two files open at once, which must not make the others wait for sessions, which would take 10s
+    CopyingOptions opts;
+    opts.parallel_lanes = 4;
+    Copying op(FetchItems(target_dir.native(), {"src"}, *host), target_dir / "dst", host, opts);
+    const auto started = std::chrono::steady_clock::now();
+    RunOperationAndCheckSuccess(op);
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(10));
+    CHECK(VFSCompareEntries(src_dir, TestEnv().vfs_native, target_dir / "dst", host) == 0);
+}
+
+TEST_CASE(PREFIX "Copying a native file within the same volume (cloning)")
+{
+    const TempTestDir dir;
+    const auto host = TestEnv().vfs_native;
+    const auto noise = MakeNoise(5'000'000);
+    REQUIRE(Save(dir.directory / "a", noise));
+    REQUIRE(chmod((dir.directory / "a").c_str(), S_IRUSR | S_IWUSR | S_IXUSR) == 0);
+    REQUIRE(setxattr((dir.directory / "a").c_str(), "nc.test", "hello", 5, 0, 0) == 0);
+
+    CopyingOptions opts;
+    SECTION("Default options")
+    {
+        opts.verification = CopyingOptions::ChecksumVerification::Always;
+        Copying op(FetchItems(dir.directory, {"a"}, *host), dir.directory / "b", host, opts);
+        RunOperationAndCheckSuccess(op);
+        CHECK(op.Statistics().VolumeProcessed(nc::ops::Statistics::SourceType::Bytes) == noise.size());
+        CHECK(host->Stat((dir.directory / "b").c_str(), 0).value().mode == (S_IFREG | S_IRUSR | S_IWUSR | S_IXUSR));
+        CHECK(getxattr((dir.directory / "b").c_str(), "nc.test", nullptr, 0, 0, 0) == 5);
+    }
+    SECTION("No flags, no xattrs")
+    {
+        opts.copy_unix_flags = false;
+        opts.copy_xattrs = false;
+        Copying op(FetchItems(dir.directory, {"a"}, *host), dir.directory / "b", host, opts);
+        RunOperationAndCheckSuccess(op);
+        CHECK(host->Stat((dir.directory / "b").c_str(), 0).value().mode == (S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP));
+        CHECK(getxattr((dir.directory / "b").c_str(), "nc.test", nullptr, 0, 0, 0) == -1);
+    }
+    std::ifstream in(dir.directory / "b", std::ios::binary);
+    const std::vector<char> copied{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    REQUIRE(copied.size() == noise.size());
+    CHECK(std::memcmp(copied.data(), noise.data(), noise.size()) == 0);
+}
+
+// Tells whether the file was cloned, i.e. all its data blocks are shared with another file.
+static bool SharesAllBlocks(const std::filesystem::path &_path)
+{
+    attrlist attrs = {};
+    attrs.bitmapcount = ATTR_BIT_MAP_COUNT;
+    attrs.forkattr = ATTR_CMNEXT_EXT_FLAGS;
+    struct {
+        uint32_t length;
+        uint64_t ext_flags;
+    } __attribute__((aligned(4), packed)) buf = {};
+    if( getattrlist(_path.c_str(), &attrs, &buf, sizeof(buf), FSOPT_ATTR_CMN_EXTENDED) != 0 )
+        return false;
+    return buf.ext_flags & EF_SHARES_ALL_BLOCKS;
+}
+
+TEST_CASE(PREFIX "Cloning a read-only native file")
+{
+    const TempTestDir dir;
+    const auto host = TestEnv().vfs_native;
+    const auto noise = MakeNoise(1'000'000);
+    const auto src = dir.directory / "a";
+    const auto dst = dir.directory / "b";
+    REQUIRE(Save(src, noise));
+    REQUIRE(chmod(src.c_str(), S_IRUSR | S_IRGRP | S_IROTH) == 0);
+
+    uint32_t flags = 0;
+    SECTION("Read-only")
+    {
+        flags = 0;
+    }
+    SECTION("Read-only and immutable")
+    {
+        flags = UF_IMMUTABLE;
+    }
+    REQUIRE(chflags(src.c_str(), flags) == 0);
+    const auto unlock = at_scope_end([&] {
+        chflags(src.c_str(), 0);
+        chflags(dst.c_str(), 0);
+    });
+
+    Copying op(FetchItems(dir.directory, {"a"}, *host), dst, host, {});
+    RunOperationAndCheckSuccess(op);
+    CHECK(SharesAllBlocks(dst));
+    CHECK(host->Stat(dst.c_str(), 0).value().mode == (S_IFREG | S_IRUSR | S_IRGRP | S_IROTH));
+    CHECK(FileFlags(dst.c_str()) == flags);
+
+    std::ifstream in(dst, std::ios::binary);
+    const std::vector<char> copied{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    REQUIRE(copied.size() == noise.size());
+    CHECK(std::memcmp(copied.data(), noise.data(), noise.size()) == 0);
+}
+
 TEST_CASE(PREFIX "Copying a native file that is being written to")
 {
     const TempTestDir dir;
@@ -1511,3 +1666,42 @@ static std::expected<int, Error> VFSCompareEntries(const std::filesystem::path &
     }
     return 0;
 }
+
+TEST_CASE(PREFIX "Verification runs alongside copying of the next files")
+{
+    const TempTestDir dir;
+    const auto host = TestEnv().vfs_native;
+    REQUIRE(std::filesystem::create_directory(dir.directory / "src"));
+    for( int i = 0; i < 20; ++i )
+        REQUIRE(Save(dir.directory / "src" / fmt::format("{}.bin", i), MakeNoise(static_cast<size_t>(i) * 100'000)));
+
+    CopyingOptions opts;
+    opts.verification = CopyingOptions::ChecksumVerification::Always;
+    SECTION("Sequentially")
+    {
+    }
+    SECTION("In parallel lanes")
+    {
+        opts.parallel_lanes = 4;
+    }
+    Copying op(FetchItems(dir.directory, {"src"}, *host), dir.directory / "dst", host, opts);
+    RunOperationAndCheckSuccess(op);
+    CHECK(VFSCompareEntries(dir.directory / "src", host, dir.directory / "dst", host) == 0);
+}
+
+TEST_CASE(PREFIX "Overwriting a large native file streams it through multiple buffers")
+{
+    const TempTestDir dir;
+    const auto host = TestEnv().vfs_native;
+    const auto noise = MakeNoise(50'000'000);
+    REQUIRE(Save(dir.directory / "a", noise));
+    REQUIRE(Save(dir.directory / "b", MakeNoise(1'000)));
+
+    CopyingOptions opts;
+    opts.exist_behavior = CopyingOptions::ExistBehavior::OverwriteAll; // overwriting rules out cloning
+    opts.verification = CopyingOptions::ChecksumVerification::Always;
+    Copying op(FetchItems(dir.directory, {"a"}, *host), dir.directory / "b", host, opts);
+    RunOperationAndCheckSuccess(op);
+    CHECK(op.Statistics().VolumeProcessed(nc::ops::Statistics::SourceType::Bytes) == noise.size());
+    CHECK(VFSEasyCompareFiles((dir.directory / "a").c_str(), host, (dir.directory / "b").c_str(), host) == 0);
+}
@@ -0,0 +1,113 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "TestEnv.h"
+#include "../source/Compression/ParallelZipWriter.h"
+#include <VFS/VFS.h>
+#include <VFS/ArcLA.h>
+#include <cstring>
+#include <sys/stat.h>
+#include <fstream>
+
+using nc::ops::compression::ParallelZipWriter;
+using Entry = ParallelZipWriter::Entry;
+
+#define PREFIX "nc::ops::compression::ParallelZipWriter "
+
+static std::vector<std::byte> MakeContent(size_t _size)
+{
+    std::vector<std::byte> data(_size);
+    for( size_t i = 0; i < _size; ++i )
+        data[i] = static_cast<std::byte>(((i * 7919) % 251) ^ (i >> 11));
+    return data;
+}
+
+static Entry MakeEntry(std::string _path, mode_t _mode, uint64_t _size = 0)
+{
+    Entry entry;
+    entry.path = std::move(_path);
+    entry.mode = _mode;
+    entry.mtime = 1700000000;
+    entry.uid = 501;
+    entry.gid = 20;
+    entry.size = _size;
+    return entry;
+}
+
+// Builds a small tree: a directory, a file spanning several chunks fed in uneven pieces, an empty file, a symlink and
+// a stored file.
+static std::vector<std::byte> BuildArchive(int _threads, size_t _chunk_size, const std::vector<std::byte> &_content)
+{
+    std::vector<std::byte> archive;
+    ParallelZipWriter writer(
+        [&](const void *_data, size_t _size) {
+            const auto *const bytes = static_cast<const std::byte *>(_data);
+            archive.insert(archive.end(), bytes, bytes + _size);
+            return true;
+        },
+        _threads,
+        _chunk_size);
+
+    REQUIRE(writer.AddDirectory(MakeEntry("dir/", S_IFDIR | 0755)));
+    REQUIRE(writer.BeginFile(MakeEntry("dir/big.bin", S_IFREG | 0644, _content.size())));
+    for( size_t offset = 0; offset < _content.size(); ) {
+        const size_t piece = std::min(_content.size() - offset, size_t(12345));
+        REQUIRE(writer.WriteFile(std::span{_content}.subspan(offset, piece)));
+        offset += piece;
+    }
+    REQUIRE(writer.EndFile());
+    REQUIRE(writer.BeginFile(MakeEntry("dir/empty.txt", S_IFREG | 0644)));
+    REQUIRE(writer.EndFile());
+    REQUIRE(writer.AddSymlink(MakeEntry("dir/link", S_IFLNK | 0755), "big.bin"));
+    const std::string_view small = "Hello, World!";
+    REQUIRE(writer.AddFile(MakeEntry("small.txt", S_IFREG | 0600, small.size()), std::as_bytes(std::span{small})));
+    REQUIRE(writer.Finish());
+    CHECK(!writer.Failed());
+    return archive;
+}
+
+TEST_CASE(PREFIX "produces the same archive regardless of the amount of threads")
+{
+    const auto content = MakeContent(1000000);
+    const auto single = BuildArchive(1, 64 * 1024, content);
+    const auto multi = BuildArchive(4, 64 * 1024, content);
+    CHECK(single == multi);
+}
+
+TEST_CASE(PREFIX "archive can be read back")
+{
+    const TempTestDir tmp_dir;
+    const auto content = MakeContent(1000000);
+    const auto archive = BuildArchive(4, 64 * 1024, content);
+    const auto path = tmp_dir.directory / "test.zip";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char *>(archive.data()), archive.size());
+
+    std::shared_ptr<nc::vfs::ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<nc::vfs::ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+
+    const auto read_all = [&](const char *_path) {
+        const auto file = host->CreateFile(_path).value();
+        REQUIRE(file->Open(VFSFlags::OF_Read) == VFSError::Ok);
+        return file->ReadFile().value();
+    };
+    const auto big = read_all("/dir/big.bin");
+    REQUIRE(big.size() == content.size());
+    CHECK(std::memcmp(big.data(), content.data(), content.size()) == 0);
+    CHECK(read_all("/dir/empty.txt").empty());
+    const auto small = read_all("/small.txt");
+    CHECK(std::string_view(reinterpret_cast<const char *>(small.data()), small.size()) == "Hello, World!");
+
+    const auto dir_stat = host->Stat("/dir", 0).value();
+    CHECK(S_ISDIR(dir_stat.mode));
+    const auto link_stat = host->Stat("/dir/link", VFSFlags::F_NoFollow).value();
+    CHECK(S_ISLNK(link_stat.mode));
+    CHECK(host->ReadSymlink("/dir/link").value() == "big.bin");
+    CHECK(host->Stat("/small.txt", 0).value().mtime.tv_sec == 1700000000);
+}
+
+TEST_CASE(PREFIX "reports failures of the sink")
+{
+    ParallelZipWriter writer([](const void *, size_t) { return false; }, 2);
+    CHECK(!writer.AddDirectory(MakeEntry("dir/", S_IFDIR | 0755)));
+    CHECK(writer.Failed());
+    CHECK(!writer.Finish());
+}
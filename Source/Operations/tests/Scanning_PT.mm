@@ -0,0 +1,72 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "Tests.h"
+#include "TestEnv.h"
+#include "../source/ParallelTreeWalker.h"
+#include <VFS/Native.h>
+#include <fmt/format.h>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+
+using nc::ops::ParallelTreeWalker;
+
+#define PREFIX "Scanning performance "
+
+// Builds a synthetic tree: _fanout directories on each of _depth levels, with _files empty files in each directory
+static void MakeSyntheticTree(const std::filesystem::path &_root, int _fanout, int _depth, int _files)
+{
+    for( int i = 0; i < _files; ++i )
+        close(open((_root / fmt::format("file{}.txt", i)).c_str(), O_WRONLY | O_CREAT, S_IWUSR | S_IRUSR));
+    if( _depth == 0 )
+        return;
+    for( int i = 0; i < _fanout; ++i ) {
+        const auto dir = _root / fmt::format("dir{}", i);
+        std::filesystem::create_directory(dir);
+        MakeSyntheticTree(dir, _fanout, _depth - 1, _files);
+    }
+}
+
+// Mimics what the scanning of the source items does: lists each directory and stats each entry
+static size_t Scan(const std::filesystem::path &_root, VFSHost &_host, int _workers)
+{
+    std::atomic_size_t items = 0;
+    const auto visit = [&](std::string _dir, std::vector<std::string> &_subdirs) {
+        std::ignore = _host.IterateDirectoryListing(_dir, [&](const VFSDirEnt &_entry) {
+            const auto path = fmt::format("{}/{}", _dir, _entry.name);
+            if( const auto st = _host.Stat(path, nc::vfs::Flags::F_NoFollow) ) {
+                ++items;
+                if( S_ISDIR(st->mode) )
+                    _subdirs.emplace_back(path);
+            }
+            return true;
+        });
+    };
+    ParallelTreeWalker<std::string> walker(_workers, visit);
+    walker.Walk({_root.native()});
+    return items;
+}
+
+TEST_CASE(PREFIX "synthetic tree")
+{
+    const TempTestDir dir;
+    MakeSyntheticTree(dir.directory, 6, 4, 20); // 1555 directories, 31100 files
+    auto &host = *TestEnv().vfs_native;
+
+    const size_t expected = Scan(dir.directory, host, 1);
+    REQUIRE(expected == 1554 + 31100);
+    REQUIRE(Scan(dir.directory, host, ParallelTreeWalker<std::string>::DefaultConcurrency()) == expected);
+
+    BENCHMARK("Single worker")
+    {
+        return Scan(dir.directory, host, 1);
+    };
+    BENCHMARK("2 workers")
+    {
+        return Scan(dir.directory, host, 2);
+    };
+    BENCHMARK("Default concurrency")
+    {
+        return Scan(dir.directory, host, ParallelTreeWalker<std::string>::DefaultConcurrency());
+    };
+}
@@ -1,4 +1,4 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <stdint.h>
@@ -20,6 +20,13 @@ public:
     // Any other values represent observation tickets.
     virtual uint64_t AddWatchPath(std::string_view _path, std::function<void()> _handler) = 0;
 
+    // Registers _handler as a watch callback for any changes in the whole tree under the directory '_path'.
+    // _handler receives a path of the changed directory spelled as a continuation of '_path', the subdirectories of
+    // that directory might have changed as well. It's called from the main queue for every change, without coalescing.
+    // Zero will be returned to indicate an error, the trees are never polled.
+    virtual uint64_t AddTreeWatchPath(std::string_view _path,
+                                      std::function<void(std::string_view _directory)> _handler) = 0;
+
     // Deregisters the watcher identified by _ticket.
     virtual void RemoveWatchPathWithTicket(uint64_t _ticket) = 0;
 
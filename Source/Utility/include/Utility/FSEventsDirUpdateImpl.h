@@ -1,19 +1,30 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 #include "FSEventsDirUpdate.h"
 #include <DiskArbitration/DiskArbitration.h>
 #include <CoreServices/CoreServices.h>
 #include <Base/spinlock.h>
+#include <chrono>
 #include <filesystem>
+#include <mutex>
 #include <Base/UnorderedUtil.h>
 
 namespace nc::utility {
 
+// Watches each directory with its own FSEvents stream. Once too many streams exist or a stream can't be created, the
+// directories are polled instead by a single background loop that compares their modification times.
+// Bursts of changes are coalesced: a change after a quiet period is reported immediately, while the following changes
+// are reported once the directory calms down, but not later than a couple of seconds.
 class FSEventsDirUpdateImpl : public FSEventsDirUpdate
 {
 public:
+    static constexpr size_t DefaultMaxStreams = 256;
+
     uint64_t AddWatchPath(std::string_view _path, std::function<void()> _handler) override;
 
+    uint64_t AddTreeWatchPath(std::string_view _path,
+                              std::function<void(std::string_view _directory)> _handler) override;
+
     void RemoveWatchPathWithTicket(uint64_t _ticket) override;
 
     // Implementation detail exposed for testability
@@ -22,15 +33,40 @@ public:
                            const char *_event_paths[],
                            const FSEventStreamEventFlags _event_flags[]) noexcept;
 
+    // Translates a path of an event received by a tree watch of '_watched_path', which canonically is '_real_path',
+    // into the changed directory to be reported. Both watched paths should include a trailing slash.
+    // Implementation detail exposed for testability
+    static std::string TreeEventDirectory(std::string_view _watched_path,
+                                          std::string_view _real_path,
+                                          std::string_view _event_path,
+                                          FSEventStreamEventFlags _event_flags);
+
+    // Sets the maximum amount of FSEvents streams, affects only the directories watched afterwards.
+    // Exposed for testability.
+    void SetMaxStreams(size_t _max_streams) noexcept;
+
 private:
     struct WatchData {
-        std::string path; // canonical fs representation, should include a trailing slash
-        FSEventStreamRef stream = nullptr;
+        FSEventsDirUpdateImpl *owner = nullptr;
+        std::string path;                  // canonical fs representation, should include a trailing slash
+        FSEventStreamRef stream = nullptr; // nullptr means that the directory is polled
+        timespec polled_mtime = {0, 0};
         std::vector<std::pair<uint64_t, std::function<void()>>> handlers;
+        std::chrono::nanoseconds last_change{0};
+        std::chrono::nanoseconds burst_start{0};
+        bool fire_scheduled = false;
+    };
+
+    struct TreeWatchData {
+        std::string path;                  // as requested, should include a trailing slash
+        std::string real_path;             // canonical fs representation, should include a trailing slash
+        FSEventStreamRef stream = nullptr; // never nullptr, the trees are not polled
+        std::function<void(std::string_view _directory)> handler;
     };
 
     using WatchesT = ankerl::unordered_dense::
         map<std::string, std::unique_ptr<WatchData>, UnorderedStringHashEqual, UnorderedStringHashEqual>;
+    using TreeWatchesT = ankerl::unordered_dense::map<uint64_t, std::unique_ptr<TreeWatchData>>;
 
     void OnVolumeDidUnmount(const std::string &_on_path) override;
 
@@ -41,11 +77,29 @@ private:
                                           void *_paths,
                                           const FSEventStreamEventFlags _flags[],
                                           const FSEventStreamEventId _ids[]);
-    static FSEventStreamRef CreateEventStream(const std::string &path, void *context);
+    static void FSEventsTreeUpdateCallback(ConstFSEventStreamRef _stream_ref,
+                                           void *_user_data,
+                                           size_t _num,
+                                           void *_paths,
+                                           const FSEventStreamEventFlags _flags[],
+                                           const FSEventStreamEventId _ids[]);
+    static FSEventStreamRef CreateEventStream(const std::string &path, void *context, FSEventStreamCallback callback);
+
+    // Reports a change of the directory to the handlers, coalescing the bursts. Main queue only.
+    void OnChange(const std::string &_path);
+    void FireWhenCalm(const std::string &_path);
+    void Fire(WatchData &_watch, std::unique_lock<spinlock> &_lock);
+
+    void SchedulePolling();
+    void Poll();
 
     spinlock m_Lock;
     WatchesT m_Watches;                // path -> watch data;
+    TreeWatchesT m_TreeWatches;        // ticket -> tree watch data;
     std::atomic_ulong m_LastTicket{1}; // no #0 ticket, it's an error code
+    size_t m_MaxStreams = DefaultMaxStreams;
+    size_t m_StreamsCount = 0;
+    bool m_PollingScheduled = false;
 };
 
 } // namespace nc::utility
@@ -1,4 +1,4 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "FSEventsDirUpdateImpl.h"
 #include <sys/param.h>
 #include <vector>
@@ -6,15 +6,25 @@
 #include <Utility/StringExtras.h>
 #include <Utility/Log.h>
 #include <Base/dispatch_cpp.h>
+#include <Base/mach_time.h>
 #include <Base/spinlock.h>
 #include <Base/StackAllocator.h>
 #include <fmt/ranges.h>
 #include <span>
+#include <sys/stat.h>
 
 namespace nc::utility {
 
 static const CFAbsoluteTime g_FSEventsLatency = 0.05; // 50ms
 
+// A change is reported right away only if the directory wasn't changing for this long
+static constexpr std::chrono::nanoseconds g_QuietPeriod = std::chrono::milliseconds{200};
+
+// A burst of changes, e.g. a checkout of thousands of files, is reported not later than this since its beginning
+static constexpr std::chrono::nanoseconds g_MaxCoalescingDelay = std::chrono::seconds{2};
+
+static constexpr std::chrono::nanoseconds g_PollingInterval = std::chrono::seconds{1};
+
 // ask FS about real file path - case sensitive etc
 // also we're getting rid of symlinks - it will be a real file
 // return path with trailing slash
@@ -86,20 +96,169 @@ void FSEventsDirUpdateImpl::FSEventsDirUpdateCallback([[maybe_unused]] ConstFSEv
                                                       const FSEventStreamEventFlags _flags[],
                                                       [[maybe_unused]] const FSEventStreamEventId _ids[])
 {
-    // WTF this data access is not locked????
-
     Log::Trace("FSEventsDirUpdate::Impl::FSEventsDirUpdateCallback for {} path(s): {}",
                _num,
                fmt::join(std::span<const char *>{reinterpret_cast<const char **>(_paths), _num}, ", "));
 
+    // the stream is stopped on the main queue before its watch data is destroyed, and the path is never changed
     const WatchData &watch = *static_cast<const WatchData *>(_user_data);
-    if( ShouldFire(watch.path, _num, reinterpret_cast<const char **>(_paths), _flags) ) {
-        for( auto &h : watch.handlers )
-            h.second();
+    if( ShouldFire(watch.path, _num, reinterpret_cast<const char **>(_paths), _flags) )
+        watch.owner->OnChange(watch.path);
+}
+
+std::string FSEventsDirUpdateImpl::TreeEventDirectory(std::string_view _watched_path,
+                                                      std::string_view _real_path,
+                                                      std::string_view _event_path,
+                                                      FSEventStreamEventFlags _event_flags)
+{
+    assert(!_watched_path.empty() && _watched_path.back() == '/');
+    assert(!_real_path.empty() && _real_path.back() == '/');
+
+    std::string event_path(_event_path);
+    if( event_path.empty() || event_path.back() != '/' )
+        event_path += '/'; // the input paths may or may not contain trailing slashes
+
+    // the whole tree is considered changed when the watched directory itself was moved or deleted, or when the events
+    // were dropped
+    const auto whole_tree = kFSEventStreamEventFlagRootChanged | kFSEventStreamEventFlagUserDropped |
+                            kFSEventStreamEventFlagKernelDropped;
+    std::string directory(_watched_path);
+    if( !(_event_flags & whole_tree) && event_path.starts_with(_real_path) )
+        directory += std::string_view(event_path).substr(_real_path.length());
+
+    while( directory.length() > 1 && directory.back() == '/' )
+        directory.pop_back();
+    return directory;
+}
+
+void FSEventsDirUpdateImpl::FSEventsTreeUpdateCallback([[maybe_unused]] ConstFSEventStreamRef _stream_ref,
+                                                       void *_user_data,
+                                                       size_t _num,
+                                                       void *_paths,
+                                                       const FSEventStreamEventFlags _flags[],
+                                                       [[maybe_unused]] const FSEventStreamEventId _ids[])
+{
+    // the stream is stopped on the main queue before its watch data is destroyed, and the data is never changed
+    const TreeWatchData &watch = *static_cast<const TreeWatchData *>(_user_data);
+    const auto paths = reinterpret_cast<const char **>(_paths);
+    for( size_t i = 0; i < _num; ++i )
+        watch.handler(TreeEventDirectory(watch.path, watch.real_path, paths[i], _flags[i]));
+}
+
+void FSEventsDirUpdateImpl::OnChange(const std::string &_path)
+{
+    dispatch_assert_main_queue();
+    const auto now = base::machtime();
+    auto lock = std::unique_lock{m_Lock};
+    const auto it = m_Watches.find(_path);
+    if( it == m_Watches.end() )
+        return;
+
+    WatchData &watch = *it->second;
+    const bool calm = !watch.fire_scheduled && now - watch.last_change >= g_QuietPeriod;
+    watch.last_change = now;
+    if( calm ) {
+        Fire(watch, lock);
+        return;
+    }
+
+    if( !watch.fire_scheduled ) {
+        Log::Trace("Coalescing the changes of '{}'", _path);
+        watch.fire_scheduled = true;
+        watch.burst_start = now;
+        dispatch_to_main_queue_after(g_QuietPeriod, [this, path = _path] { FireWhenCalm(path); });
+    }
+}
+
+void FSEventsDirUpdateImpl::FireWhenCalm(const std::string &_path)
+{
+    dispatch_assert_main_queue();
+    const auto now = base::machtime();
+    auto lock = std::unique_lock{m_Lock};
+    const auto it = m_Watches.find(_path);
+    if( it == m_Watches.end() )
+        return;
+
+    WatchData &watch = *it->second;
+    const auto since_change = now - watch.last_change;
+    const auto since_start = now - watch.burst_start;
+    if( since_change < g_QuietPeriod && since_start < g_MaxCoalescingDelay ) {
+        // still changing - check again later
+        const auto delay = std::min(g_QuietPeriod - since_change, g_MaxCoalescingDelay - since_start);
+        lock.unlock();
+        dispatch_to_main_queue_after(delay, [this, path = _path] { FireWhenCalm(path); });
+        return;
     }
+
+    watch.fire_scheduled = false;
+    Fire(watch, lock);
+}
+
+void FSEventsDirUpdateImpl::Fire(WatchData &_watch, std::unique_lock<spinlock> &_lock)
+{
+    // the handlers are free to add or remove watches, so they are called without the lock
+    std::vector<std::function<void()>> handlers;
+    handlers.reserve(_watch.handlers.size());
+    for( auto &h : _watch.handlers )
+        handlers.emplace_back(h.second);
+    _lock.unlock();
+
+    for( auto &handler : handlers )
+        handler();
 }
 
-FSEventStreamRef FSEventsDirUpdateImpl::CreateEventStream(const std::string &path, void *context_ptr)
+void FSEventsDirUpdateImpl::SchedulePolling()
+{
+    // m_Lock must be held here
+    if( m_PollingScheduled )
+        return;
+    m_PollingScheduled = true;
+    dispatch_to_background_after(g_PollingInterval, [this] { Poll(); });
+}
+
+void FSEventsDirUpdateImpl::Poll()
+{
+    std::vector<std::pair<std::string, timespec>> polled;
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        for( auto &watch : m_Watches )
+            if( watch.second->stream == nullptr )
+                polled.emplace_back(watch.first, watch.second->polled_mtime);
+        if( polled.empty() ) {
+            m_PollingScheduled = false;
+            return;
+        }
+    }
+
+    std::vector<std::pair<std::string, timespec>> changed;
+    for( auto &[path, mtime] : polled ) {
+        struct stat st;
+        const timespec current = stat(path.c_str(), &st) == 0 ? st.st_mtimespec : timespec{0, 0};
+        if( current.tv_sec != mtime.tv_sec || current.tv_nsec != mtime.tv_nsec )
+            changed.emplace_back(std::move(path), current);
+    }
+
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        for( auto &[path, mtime] : changed )
+            if( auto it = m_Watches.find(path); it != m_Watches.end() )
+                it->second->polled_mtime = mtime;
+        m_PollingScheduled = false;
+        SchedulePolling();
+    }
+
+    for( auto &change : changed )
+        dispatch_to_main_queue([this, path = std::move(change.first)] { OnChange(path); });
+}
+
+void FSEventsDirUpdateImpl::SetMaxStreams(size_t _max_streams) noexcept
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_MaxStreams = _max_streams;
+}
+
+FSEventStreamRef
+FSEventsDirUpdateImpl::CreateEventStream(const std::string &path, void *context_ptr, FSEventStreamCallback callback)
 {
     Log::Debug("CreateEventStream called for '{}'", path);
     auto cf_path = base::CFStringCreateWithUTF8StdString(path);
@@ -114,7 +273,7 @@ FSEventStreamRef FSEventsDirUpdateImpl::CreateEventStream(const std::string &pat
         const auto flags = kFSEventStreamCreateFlagNoDefer | kFSEventStreamCreateFlagWatchRoot;
         auto context = FSEventStreamContext{0, context_ptr, nullptr, nullptr, nullptr};
         stream = FSEventStreamCreate(nullptr,
-                                     &FSEventsDirUpdateImpl::FSEventsDirUpdateCallback,
+                                     callback,
                                      &context,
                                      pathsToWatch,
                                      kFSEventStreamEventIdSinceNow,
@@ -136,7 +295,8 @@ FSEventStreamRef FSEventsDirUpdateImpl::CreateEventStream(const std::string &pat
     return stream;
 }
 
-static void StartStream(FSEventStreamRef _stream)
+// Starts the _stream on the main queue, waits for that if _wait is true.
+static void StartStream(FSEventStreamRef _stream, bool _wait = false)
 {
     assert(_stream != nullptr);
 
@@ -150,6 +310,8 @@ static void StartStream(FSEventStreamRef _stream)
 
     if( dispatch_is_main_queue() )
         schedule_and_run();
+    else if( _wait )
+        dispatch_sync(dispatch_get_main_queue(), schedule_and_run);
     else
         dispatch_to_main_queue(schedule_and_run);
 }
@@ -200,19 +362,81 @@ uint64_t FSEventsDirUpdateImpl::AddWatchPath(std::string_view _path, std::functi
     auto ep = m_Watches.emplace(dir_path, std::make_unique<WatchData>());
     assert(ep.second == true);
     WatchData &w = *ep.first->second;
-    w.stream = CreateEventStream(dir_path, &w);
-    if( w.stream == nullptr ) {
-        // failed to creat the event stream, roll back the changes and return a failure indication
+    w.owner = this;
+    w.path = ep.first->first;
+    w.handlers.emplace_back(ticket, std::move(_handler));
+    if( m_StreamsCount < m_MaxStreams ) {
+        w.stream = CreateEventStream(dir_path, &w, &FSEventsDirUpdateImpl::FSEventsDirUpdateCallback);
+        if( w.stream == nullptr )
+            Log::Warn("Failed to create an event stream for '{}', will poll it instead", dir_path);
+    }
+    else {
+        Log::Debug("Too many event streams already, will poll '{}' instead", dir_path);
+    }
+
+    if( w.stream != nullptr ) {
+        ++m_StreamsCount;
+        StartStream(w.stream);
+        return ticket;
+    }
+
+    struct stat st;
+    if( stat(dir_path.c_str(), &st) != 0 ) {
+        // can't watch the directory either way, roll back the changes and return a failure indication
         m_Watches.erase(ep.first);
         return no_ticket;
     }
-    w.path = ep.first->first;
-    w.handlers.emplace_back(ticket, std::move(_handler));
-    StartStream(w.stream);
+    w.polled_mtime = st.st_mtimespec;
+    SchedulePolling();
 
     return ticket;
 }
 
+uint64_t FSEventsDirUpdateImpl::AddTreeWatchPath(std::string_view _path,
+                                                 std::function<void(std::string_view _directory)> _handler)
+{
+    if( _path.empty() || !_handler )
+        return no_ticket;
+
+    Log::Debug("FSEventsDirUpdate::Impl::AddTreeWatchPath called for '{}'", _path);
+
+    const auto real_path = GetRealPath(_path);
+    if( real_path.empty() ) {
+        Log::Debug("Failed to get a real path of '{}'", _path);
+        return no_ticket;
+    }
+
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        if( m_StreamsCount >= m_MaxStreams ) {
+            Log::Debug("Too many event streams already, won't watch the tree of '{}'", real_path);
+            return no_ticket;
+        }
+        ++m_StreamsCount; // reserved while the stream is created without the lock
+    }
+
+    auto w = std::make_unique<TreeWatchData>();
+    w->path = _path;
+    if( w->path.back() != '/' )
+        w->path += '/';
+    w->real_path = real_path;
+    w->handler = std::move(_handler);
+    w->stream = CreateEventStream(real_path, w.get(), &FSEventsDirUpdateImpl::FSEventsTreeUpdateCallback);
+    if( w->stream == nullptr ) {
+        const auto lock = std::lock_guard{m_Lock};
+        --m_StreamsCount;
+        return no_ticket;
+    }
+
+    // started synchronously so that no change made after this call is missed
+    StartStream(w->stream, true);
+
+    const auto ticket = m_LastTicket++;
+    const auto lock = std::lock_guard{m_Lock};
+    m_TreeWatches.emplace(ticket, std::move(w));
+    return ticket;
+}
+
 // Erases an element at '_i' from containers '_c' by swapping it with the last element and then removing the last
 // element. That's to cause less data movements
 template <class Container, class Iterator>
@@ -239,13 +463,23 @@ void FSEventsDirUpdateImpl::RemoveWatchPathWithTicket(uint64_t _ticket)
 
     auto lock = std::lock_guard{m_Lock};
 
+    if( auto tree = m_TreeWatches.find(_ticket); tree != m_TreeWatches.end() ) {
+        StopStream(tree->second->stream);
+        --m_StreamsCount;
+        m_TreeWatches.erase(tree);
+        return;
+    }
+
     for( auto i = m_Watches.begin(), e = m_Watches.end(); i != e; ++i ) {
         auto &watch = *i->second;
         for( auto h = watch.handlers.begin(), he = watch.handlers.end(); h != he; ++h )
             if( h->first == _ticket ) {
                 unordered_erase(watch.handlers, h);
                 if( watch.handlers.empty() ) {
-                    StopStream(watch.stream);
+                    if( watch.stream != nullptr ) {
+                        StopStream(watch.stream);
+                        --m_StreamsCount;
+                    }
                     m_Watches.erase(i);
                 }
                 return;
@@ -257,13 +491,22 @@ void FSEventsDirUpdateImpl::OnVolumeDidUnmount(const std::string &_on_path)
 {
     // when a volume is removed from the system we force every relevant panel to reload its data
     dispatch_assert_main_queue();
-    // locking??
-    for( auto &i : m_Watches ) {
-        if( i.second->path.starts_with(_on_path) ) {
-            for( auto &h : i.second->handlers )
-                h.second();
-        }
+    std::vector<std::function<void()>> handlers;
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        for( auto &i : m_Watches )
+            if( i.second->path.starts_with(_on_path) )
+                for( auto &h : i.second->handlers )
+                    handlers.emplace_back(h.second);
+        for( auto &i : m_TreeWatches )
+            if( i.second->real_path.starts_with(_on_path) )
+                handlers.emplace_back([handler = i.second->handler,
+                                       path = TreeEventDirectory(i.second->path, i.second->real_path, {}, 0)] {
+                    handler(path);
+                });
     }
+    for( auto &handler : handlers )
+        handler();
 }
 
 } // namespace nc::utility
@@ -1,10 +1,13 @@
-// Copyright (C) 2019-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2019-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "FSEventsDirUpdate.h"
 #include "FSEventsDirUpdateImpl.h"
 #include "UnitTests_main.h"
+#include <Base/algo.h>
 #include <Base/dispatch_cpp.h>
 #include <CoreFoundation/CoreFoundation.h>
 #include <fcntl.h>
+#include <algorithm>
+#include <filesystem>
 
 using nc::utility::FSEventsDirUpdate;
 using nc::utility::FSEventsDirUpdateImpl;
@@ -75,6 +78,99 @@ TEST_CASE(PREFIX "Removes event listeners")
     inst.RemoveWatchPathWithTicket(ticket2);
 }
 
+TEST_CASE(PREFIX "Coalesces bursts of changes")
+{
+    const TempTestDir tmp_dir;
+    auto &inst = FSEventsDirUpdate::Instance();
+    int call_count = 0;
+
+    const auto ticket = inst.AddWatchPath(tmp_dir.directory.c_str(), [&] { ++call_count; });
+    for( int i = 0; i < 1000; ++i ) {
+        touch(tmp_dir.directory / ("file" + std::to_string(i) + ".txt"));
+        if( i % 100 == 0 )
+            CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.01, false);
+    }
+
+    // the first change is reported right away, the rest - once the directory calms down
+    runMainLoopUntilExpectationOrTimeout(3s, [] { return false; });
+    CHECK(call_count >= 1);
+    CHECK(call_count <= 3);
+
+    inst.RemoveWatchPathWithTicket(ticket);
+}
+
+TEST_CASE(PREFIX "Polls directories when no more streams can be created")
+{
+    const TempTestDir tmp_dir;
+    auto &inst = static_cast<FSEventsDirUpdateImpl &>(FSEventsDirUpdate::Instance());
+    inst.SetMaxStreams(0);
+    auto restore = at_scope_end([&] { inst.SetMaxStreams(FSEventsDirUpdateImpl::DefaultMaxStreams); });
+    int call_count = 0;
+
+    const auto ticket = inst.AddWatchPath(tmp_dir.directory.c_str(), [&] { ++call_count; });
+    REQUIRE(ticket != FSEventsDirUpdate::no_ticket);
+
+    touch(tmp_dir.directory / "something.txt");
+    REQUIRE(runMainLoopUntilExpectationOrTimeout(5s, [&] { return call_count == 1; }));
+
+    inst.RemoveWatchPathWithTicket(ticket);
+}
+
+TEST_CASE(PREFIX "Reports changes anywhere in a watched tree")
+{
+    const TempTestDir tmp_dir;
+    const auto root = tmp_dir.directory / "root";
+    std::filesystem::create_directories(root / "a" / "b");
+    auto &inst = FSEventsDirUpdate::Instance();
+    std::vector<std::string> changed;
+
+    const auto ticket =
+        inst.AddTreeWatchPath(root.native(), [&](std::string_view _dir) { changed.emplace_back(_dir); });
+    REQUIRE(ticket != FSEventsDirUpdate::no_ticket);
+
+    touch(root / "a" / "b" / "something.txt");
+    const auto b = (root / "a" / "b").native();
+    REQUIRE(runMainLoopUntilExpectationOrTimeout(5s, [&] { return std::ranges::find(changed, b) != changed.end(); }));
+
+    inst.RemoveWatchPathWithTicket(ticket);
+    changed.clear();
+    touch(root / "something.txt");
+    runMainLoopUntilExpectationOrTimeout(500ms, [] { return false; });
+    CHECK(changed.empty());
+}
+
+TEST_CASE(PREFIX "Tree event translation")
+{
+    using I = FSEventsDirUpdateImpl;
+    struct TC {
+        std::string_view watched_path;
+        std::string_view real_path;
+        std::string_view event_path;
+        FSEventStreamEventFlags event_flags;
+        std::string_view exp;
+    } tcs[] = {
+        {"/dir/", "/dir/", "/dir", 0, "/dir"},
+        {"/dir/", "/dir/", "/dir/", 0, "/dir"},
+        {"/dir/", "/dir/", "/dir/sub", 0, "/dir/sub"},
+        {"/dir/", "/dir/", "/dir/sub/", 0, "/dir/sub"},
+        {"/dir/", "/dir/", "/dir/sub/subsub", 0, "/dir/sub/subsub"},
+        {"/dir/", "/dir/", "/dirr/sub", 0, "/dir"},
+        {"/dir/", "/dir/", "/else", 0, "/dir"},
+        {"/dir/", "/dir/", "", 0, "/dir"},
+        {"/dir/", "/dir/", "/dir/sub", kFSEventStreamEventFlagRootChanged, "/dir"},
+        {"/dir/", "/dir/", "/dir/sub", kFSEventStreamEventFlagUserDropped, "/dir"},
+        {"/var/dir/", "/private/var/dir/", "/private/var/dir/sub/", 0, "/var/dir/sub"},
+        {"/DIR/", "/dir/", "/dir/Sub", 0, "/DIR/Sub"},
+        {"/", "/", "/", 0, "/"},
+        {"/", "/", "/dir/", 0, "/dir"},
+    };
+
+    for( auto &tc : tcs ) {
+        INFO(tc.event_path);
+        CHECK(I::TreeEventDirectory(tc.watched_path, tc.real_path, tc.event_path, tc.event_flags) == tc.exp);
+    }
+}
+
 TEST_CASE(PREFIX "Firing logic")
 {
     using I = FSEventsDirUpdateImpl;
@@ -0,0 +1,4 @@
+#pragma once
+
+#include "VFS.h"
+#include "../../source/Caching/Host.h"
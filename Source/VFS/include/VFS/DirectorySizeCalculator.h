@@ -0,0 +1,67 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <VFS/VFS.h>
+
+#include <expected>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace nc::vfs {
+
+// Calculates the sizes of directories recursively, walking several trees at once with a bounded amount of workers.
+// When the host can observe the changes of a whole tree, the calculated directories are observed and the size of every
+// directory inside is remembered until anything below it changes, so an unchanged subtree is never walked twice.
+// Otherwise nothing is remembered and the directories are listed on each calculation.
+// Symlinks are not followed. Can be used concurrently from several threads.
+class DirectorySizeCalculator
+{
+public:
+    // Receives the size of the directory at _index of the requested paths once its whole subtree is calculated.
+    // Invoked from the workers, but never simultaneously.
+    using Callback = std::function<void(size_t _index, std::expected<uint64_t, Error> _size)>;
+
+    DirectorySizeCalculator();
+    ~DirectorySizeCalculator();
+
+    // Sets the maximum amount of workers used for native hosts. Defaults to the amount of CPU cores, up to 8.
+    void SetMaxWorkers(int _workers);
+
+    // Calculates the sizes of all _paths and reports each of them as soon as it's done.
+    // Returns once every directory has been reported. The errors below the requested directories are ignored.
+    // Directories which were not finished due to cancellation are reported with ECANCELED.
+    void Calculate(const VFSHostPtr &_host,
+                   std::span<const std::string> _paths,
+                   const Callback &_callback,
+                   const VFSCancelChecker &_cancel_checker = {});
+
+    // Calculates the size of a single directory.
+    std::expected<uint64_t, Error>
+    Calculate(const VFSHostPtr &_host, std::string_view _path, const VFSCancelChecker &_cancel_checker = {});
+
+    // Forgets what was known about the directory at _path, the directories above and below it.
+    void Invalidate(const VFSHost &_host, std::string_view _path);
+
+    // Forgets everything and stops observing.
+    void Clear();
+
+    // Amount of directories currently remembered.
+    size_t CachedCount() const;
+
+private:
+    struct Cache;
+    struct Tree;
+    struct Walk;
+    struct Node;
+
+    std::shared_ptr<Tree> Observe(const VFSHostPtr &_host, const std::string &_path);
+    void Visit(Walk &_walk, Node *_node, std::vector<Node *> &_subdirectories) const;
+
+    std::shared_ptr<Cache> m_Cache;
+    int m_MaxWorkers;
+};
+
+} // namespace nc::vfs
@@ -49,6 +49,7 @@ public:
     // Moves the window position in the file and immediately reload its content.
     // Will move only inside valid boundaries. In case of invalid boundaries returns InvalidCall.
     // Behaves depending on the VFS file - when it supports Random access, it will just move indices.
+    // With Random access a failed movement leaves the window where it was.
     // For Seek paradigm it will call Seek().
     // For Sequential paradigm it will read until meets the requested position.
     // In the Sequential case any calls to move _offset lower than the current position fill fail with EINVAL.
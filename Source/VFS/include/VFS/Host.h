@@ -62,7 +62,8 @@ struct HostFeatures {
         SetFlags = 1 << 3,
         SetOwnership = 1 << 4,
         SetTimes = 1 << 5,
-        NonEmptyRmDir = 1 << 6
+        NonEmptyRmDir = 1 << 6,
+        ConcurrentListing = 1 << 7 // the host can serve listing requests from several threads in parallel
     };
 };
 
@@ -126,6 +127,12 @@ public:
      */
     uint64_t Features() const noexcept;
 
+    /**
+     * Returns true if the host can serve requests from several threads in parallel, i.e. it's either the native
+     * filesystem or advertises HostFeatures::ConcurrentListing.
+     */
+    bool CanServeConcurrently() const noexcept;
+
     /**
      * _callback will be exectuded in VFSHost dectructor, just before this instance will die.
      * Do not access VFSHost via pointer parameter, it should be used only for identification.
@@ -349,6 +356,15 @@ public:
      */
     virtual HostDirObservationTicket ObserveDirectoryChanges(std::string_view _path, std::function<void()> _handler);
 
+    /**
+     * Will fire _handler with a path of a directory whenever its entries change anywhere in the tree under '_path'.
+     * The subdirectories of the reported directory might have changed as well.
+     * _handler can be called from any thread.
+     * Default implementation doesn't provide any observation functionality and returns an empty ticket.
+     */
+    virtual HostDirObservationTicket
+    ObserveDirectoryTreeChanges(std::string_view _path, std::function<void(std::string_view _directory)> _handler);
+
     /**
      * Will fire _handler whenever a file identified by '_path' is changed.
      * Can return an empty token if observation is unavailable.
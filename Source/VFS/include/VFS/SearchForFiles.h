@@ -1,4 +1,4 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <Base/SerialQueue.h>
@@ -7,8 +7,10 @@
 #include <VFS/VFS.h>
 
 #include <functional>
+#include <mutex>
 #include <string>
 #include <queue>
+#include <vector>
 #include <stdint.h>
 
 namespace nc::vfs {
@@ -22,6 +24,9 @@ public:
             SearchForDirs = 0x0002,
             SearchForFiles = 0x0004,
             LookInArchives = 0x0008,
+            // Lists directories and checks contents of files with several workers on native volumes.
+            // Found entries are reported in no particular order, callbacks are never invoked simultaneously.
+            Parallel = 0x0010,
         };
     };
 
@@ -42,6 +47,7 @@ public:
     using FoundCallback =
         std::function<void(const char *_filename, const char *_in_path, VFSHost &_in_host, CFRange _content_found)>;
 
+    // Can be called concurrently from several threads in the Parallel mode
     using SpawnArchiveCallback = std::function<VFSHostPtr(const char *_for_path, VFSHost &_in_host)>;
 
     using LookingInCallback = std::function<void(const char *, VFSHost &)>;
@@ -71,6 +77,12 @@ public:
      */
     void ClearFilters();
 
+    /**
+     * Sets the maximum amount of workers used by the Parallel mode. Should not be called with background search
+     * going on. Defaults to the amount of CPU cores, up to 8.
+     */
+    void SetMaxWorkers(int _workers);
+
     /**
      * Returns immediately, run in background thread. Options is a bitfield with bits from Options:: enum.
      */
@@ -103,15 +115,26 @@ public:
     bool IsRunning() const noexcept;
 
 private:
+    struct Job;
+
     void AsyncProc(const char *_from_path, VFSHost &_in_host);
-    void ProcessDirent(const char *_full_path, const char *_dir_path, const VFSDirEnt &_dirent, VFSHost &_in_host);
+    void AsyncProcParallel(const char *_from_path, VFSHost &_in_host);
+    void LookInDirectory(const VFSPath &_path, std::vector<Job> *_jobs);
+    void ProcessDirent(const char *_full_path,
+                       const char *_dir_path,
+                       const VFSDirEnt &_dirent,
+                       VFSHost &_in_host,
+                       std::vector<Job> *_jobs);
+    void ProcessContentJob(const Job &_job);
+    void LookInArchiveSequentially(const VFSHostPtr &_archive_host);
     void ProcessValidEntry(const char *_full_path,
                            const char *_dir_path,
-                           const VFSDirEnt &_dirent,
+                           const char *_filename,
                            VFSHost &_in_host,
                            CFRange _cont_range);
+    VFSHostPtr SpawnArchive(const char *_for_path, VFSHost &_in_host);
 
-    void NotifyLookingIn(const char *_path, VFSHost &_in_host) const;
+    void NotifyLookingIn(const char *_path, VFSHost &_in_host);
     bool FilterByContent(const char *_full_path, VFSHost &_in_host, CFRange &_r);
     bool FilterByFilename(const char *_filename) const;
 
@@ -125,7 +148,9 @@ private:
     std::function<void()> m_FinishCallback;
     LookingInCallback m_LookingInCallback;
     int m_SearchOptions;
+    int m_MaxWorkers;
     std::queue<VFSPath> m_DirsFIFO;
+    std::mutex m_CallbacksLock; // serializes the client's found and looking-in callbacks in the Parallel mode
 };
 
 } // namespace nc::vfs
@@ -1,4 +1,4 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <CoreFoundation/CoreFoundation.h>
@@ -6,14 +6,24 @@
 #include <memory>
 #include <functional>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Base/CFPtr.h>
+#include <Base/LiteralSearch.h>
 #include <VFS/FileWindow.h>
 #include <Utility/Encodings.h>
 
+namespace re2 {
+class RE2;
+}
+
 namespace nc::vfs {
 
 /**
- * Provides a *stateful* searching facilty to find text in VFS file accessible through
- * a FileWindow object.
+ * Provides a *stateful* searching facilty to find text, regular expressions or exact bytes in VFS file accessible
+ * through a FileWindow object.
  * Is thread agnostic.
  */
 class SearchInFile
@@ -46,9 +56,31 @@ public:
     bool IsEOF() const;
 
     void ToggleTextSearch(CFStringRef _string, utility::Encoding _encoding);
+
+    // Searches for any of the strings, the leftmost occurrence is reported.
+    void ToggleTextSearch(std::span<const CFStringRef> _strings, utility::Encoding _encoding);
+
     CFStringRef TextSearchString();         // may be NULL. don't alter it. don't release it
     utility::Encoding TextSearchEncoding(); // may be ENCODING_INVALID
 
+    // Searches for the exact sequence of bytes, the encoding and the search options are ignored.
+    void ToggleBytesSearch(std::span<const std::byte> _bytes);
+    std::span<const std::byte> BytesSearch() const noexcept;
+
+    // Parses pairs of hexadecimal digits, optionally separated by whitespaces, e.g. "DE AD be ef".
+    // Returns nothing on malformed or empty input.
+    static std::optional<std::vector<std::byte>> ParseHexBytes(std::string_view _hex);
+
+    // Searches for a regular expression in RE2 syntax, _pattern is utf8-encoded.
+    // '^' and '$' match at the line boundaries, '.' doesn't match the line breaks.
+    // Supported are UTF-8 and single-byte encodings, other ones make the search Invalid, as does a malformed pattern.
+    // A match can't span more than MaxRegExMatchLength bytes, otherwise it may be truncated or missed.
+    // The case sensitivity option is respected, the whole phrase one is not - use '\b' instead.
+    void ToggleRegExSearch(std::string_view _pattern, utility::Encoding _encoding);
+    const std::string &RegExSearch() const noexcept;
+
+    static constexpr size_t MaxRegExMatchLength = 4096;
+
     using CancelChecker = std::function<bool()>;
     Result Search(const CancelChecker &_checker = {});
 
@@ -56,12 +88,29 @@ private:
     SearchInFile(const SearchInFile &);   // forbid
     void operator=(const SearchInFile &); // forbid
 
-    Response SearchText(uint64_t *_offset, uint64_t *_bytes_len, CancelChecker _checker);
+    Response SearchText(uint64_t *_offset, uint64_t *_bytes_len, const CancelChecker &_checker);
+    Response SearchBytes(uint64_t *_offset, uint64_t *_bytes_len, const CancelChecker &_checker);
+    Response SearchRegEx(uint64_t *_offset, uint64_t *_bytes_len, const CancelChecker &_checker);
+
+    // Moves the window through the file starting from the current position until _find reports a match in it which
+    // _accept agrees with. Any match up to _max_length bytes long is found even if it's cut between two windows.
+    template <class Find, class Accept>
+    Response SearchInWindows(size_t _max_length,
+                             Find _find,
+                             Accept _accept,
+                             uint64_t *_offset,
+                             uint64_t *_bytes_len,
+                             const CancelChecker &_checker);
+
+    void BuildTextSearcher();
+    void BuildRegEx();
+    bool IsWholePhrase(std::span<const std::byte> _window, size_t _offset, size_t _length) const;
 
     enum class WorkMode {
         NotSet,
-        Text
-        /* binary(hex) and regexp(tempates) later */
+        Text,
+        Bytes,
+        RegEx
     };
 
     nc::vfs::FileWindow &m_File;
@@ -80,14 +129,24 @@ private:
     };
 
     // text search related stuff
-    CFStringRef m_RequestedTextSearch = nullptr;
+    std::vector<base::CFPtr<CFStringRef>> m_RequestedTextSearch;
     utility::Encoding m_TextSearchEncoding;
 
-    std::unique_ptr<uint16_t[]> m_DecodedBuffer;
-    std::unique_ptr<uint32_t[]> m_DecodedBufferIndx;
-
-    size_t m_DecodedBufferSize = 0;
-    CFStringRef m_DecodedBufferString = nullptr;
+    // the requested strings converted into byte sequences of m_TextSearchEncoding, built lazily since it depends on
+    // the case sensitivity
+    std::optional<base::LiteralSearch> m_TextSearcher;
+    bool m_TextSearcherIsCaseSensitive = false;
+
+    // bytes search related stuff
+    std::vector<std::byte> m_RequestedBytes;
+    std::optional<base::LiteralSearch> m_BytesSearcher;
+
+    // regex search related stuff
+    std::string m_RequestedRegEx;
+    utility::Encoding m_RegExEncoding = utility::Encoding::ENCODING_INVALID;
+    std::unique_ptr<re2::RE2> m_RegEx; // built lazily, nullptr if the pattern is malformed
+    bool m_RegExIsBuilt = false;
+    bool m_RegExIsCaseSensitive = false;
 
     WorkMode m_WorkMode = WorkMode::NotSet;
 };
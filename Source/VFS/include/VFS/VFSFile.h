@@ -114,6 +114,11 @@ public:
     // Returnes the amount of bytes written or negative value for errors.
     virtual ssize_t Write(const void *_buf, size_t _size);
 
+    // Blocks until the data passed to Write() and possibly buffered by the file object is accepted by the destination.
+    // Returns the failure of any preceding write which wasn't reported by Write() itself.
+    // Default implementation returns Ok.
+    virtual int Flush();
+
     // Reads and discards _size bytes.
     virtual std::expected<void, nc::Error> Skip(size_t _size);
 
@@ -177,7 +182,7 @@ public:
     NSData *ReadFileToNSData();
 #endif
 
-    // Will call Write until data ends or an error occurs.
+    // Will call Write until data ends or an error occurs, then calls Flush.
     // Returns an error on failure.
     // Helper function, non-virtual.
     std::expected<void, nc::Error> WriteFile(const void *_d, size_t _sz);
@@ -2,18 +2,42 @@
 #pragma once
 
 #import "VFSFile.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
+// Provides random access to a file which can only be read sequentially, e.g. a file inside a compressed archive.
+// The contents are fetched into a memory buffer when the file is small enough, or into a temporary file otherwise.
 class VFSSeqToRandomROWrapperFile : public VFSFile
 {
 public:
+    using ProgressCallback = std::function<void(uint64_t _bytes_proc, uint64_t _bytes_total)>;
+
     VFSSeqToRandomROWrapperFile(const VFSFilePtr &_file_to_wrap);
     ~VFSSeqToRandomROWrapperFile();
 
     int Open(unsigned long _flags, const VFSCancelChecker &_cancel_checker) override;
 
-    int Open(unsigned long _flags,
-             const VFSCancelChecker &_cancel_checker,
-             std::function<void(uint64_t _bytes_proc, uint64_t _bytes_total)> _progress);
+    // Fetches the whole wrapped file before returning.
+    int Open(unsigned long _flags, const VFSCancelChecker &_cancel_checker, ProgressCallback _progress);
+
+    // Returns as soon as the wrapped file is opened, its contents are then fetched by a background thread which runs
+    // until the whole file is fetched or the last instance sharing the backing goes away.
+    // Reads of the already fetched ranges are served immediately, reads beyond the frontier wait for the data.
+    // While waiting, _progress is called with the amount of fetched bytes and _cancel_checker is polled, a
+    // cancellation fails only the read of this instance. Both callbacks are used until ResetCallbacks() is called.
+    int OpenStreaming(unsigned long _flags,
+                      const VFSCancelChecker &_cancel_checker = {},
+                      ProgressCallback _progress = {});
+
+    // Stops using the callbacks given to OpenStreaming() or Share(). Once this returns, neither of them is being
+    // called.
+    void ResetCallbacks();
+
+    // Makes the reads of this instance beyond the fetched range fail right away with EAGAIN instead of waiting, so
+    // that they can be issued from a thread which must not block.
+    void SetNonBlocking(bool _non_blocking) noexcept;
 
     int Close() override;
 
@@ -37,24 +61,45 @@ public:
 
     ReadParadigm GetReadParadigm() const override;
 
-    std::shared_ptr<VFSSeqToRandomROWrapperFile> Share();
+    // Amount of bytes fetched from the wrapped file so far.
+    uint64_t Fetched() const noexcept;
+
+    // Creates another instance reading from the same backing, including the one which is still being filled.
+    // The new instance waits for the data on its own, polling _cancel_checker.
+    std::shared_ptr<VFSSeqToRandomROWrapperFile> Share(const VFSCancelChecker &_cancel_checker = {});
 
 private:
     struct Backend {
         ~Backend();
+        int Fill(VFSFile &_seq_file, const VFSCancelChecker &_cancel_checker, const ProgressCallback &_progress);
+
         int m_FD = -1;
         ssize_t m_Size = 0;
         std::unique_ptr<uint8_t[]> m_DataBuf; // used only when filesize <= MaxCachedInMem
+
+        // [0, m_Fetched) is readable, the bytes are published before the frontier moves
+        std::atomic_uint64_t m_Fetched = 0;
+        std::mutex m_Lock;
+        std::condition_variable m_Arrived;
+        bool m_Done = false; // guarded by m_Lock
+        int m_Result = 0;    // guarded by m_Lock
+        std::atomic_bool m_Stop = false;
+        std::thread m_Filler;
     };
 
     VFSSeqToRandomROWrapperFile(const char *_relative_path, const VFSHostPtr &_host, std::shared_ptr<Backend> _backend);
-    int OpenBackend(unsigned long _flags,
-                    VFSCancelChecker _cancel_checker,
-                    std::function<void(uint64_t _bytes_proc, uint64_t _bytes_total)> _progress);
+    std::expected<std::shared_ptr<Backend>, int> OpenBackend(unsigned long _flags);
+    int WaitFor(uint64_t _bytes);
+    bool IsCancelled();
+    void ReportProgress(uint64_t _fetched);
 
     std::shared_ptr<Backend> m_Backend;
     ssize_t m_Pos = 0;
     VFSFilePtr m_SeqFile;
+    std::mutex m_CallbacksLock;       // held while the callbacks are called
+    VFSCancelChecker m_CancelChecker; // streaming mode only, guarded by m_CallbacksLock
+    ProgressCallback m_Progress;      // streaming mode only, guarded by m_CallbacksLock
+    std::atomic_bool m_NonBlocking = false;
 };
 
 using VFSSeqToRandomROWrapperFilePtr = std::shared_ptr<VFSSeqToRandomROWrapperFile>;
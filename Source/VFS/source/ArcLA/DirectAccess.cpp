@@ -0,0 +1,363 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "DirectAccess.h"
+#include <VFS/VFSError.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <sys/stat.h>
+
+namespace nc::vfs::arc {
+
+static constexpr uint32_t g_ZipLocalHeaderSignature = 0x04034b50;
+static constexpr uint32_t g_ZipCentralHeaderSignature = 0x02014b50;
+static constexpr uint32_t g_ZipEndOfCentralDirectorySignature = 0x06054b50;
+static constexpr uint32_t g_Zip64EndOfCentralDirectorySignature = 0x06064b50;
+static constexpr uint32_t g_Zip64EndOfCentralDirectoryLocatorSignature = 0x07064b50;
+static constexpr size_t g_ZipLocalHeaderSize = 30;
+static constexpr size_t g_ZipCentralHeaderSize = 46;
+static constexpr size_t g_ZipEndOfCentralDirectorySize = 22;
+static constexpr size_t g_Zip64EndOfCentralDirectorySize = 56;
+static constexpr size_t g_Zip64EndOfCentralDirectoryLocatorSize = 20;
+static constexpr uint64_t g_MaxCentralDirectorySize = 1024ull * 1024ull * 1024ull;
+static constexpr uint16_t g_ZipMethodStore = 0;
+static constexpr uint16_t g_ZipMethodDeflate = 8;
+static constexpr uint16_t g_ZipFlagEncrypted = 1 << 0;
+static constexpr uint16_t g_ZipExtraZip64 = 0x0001;
+static constexpr size_t g_InputBufferSize = 256 * 1024;
+
+static uint16_t Get16(const void *_p) noexcept
+{
+    const auto *const p = static_cast<const uint8_t *>(_p);
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t Get32(const void *_p) noexcept
+{
+    const auto *const p = static_cast<const uint8_t *>(_p);
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint64_t Get64(const void *_p) noexcept
+{
+    const auto *const p = static_cast<const uint8_t *>(_p);
+    return uint64_t(Get32(p)) | (uint64_t(Get32(p + 4)) << 32);
+}
+
+static bool ReadExactly(VFSFile &_file, uint64_t _offset, void *_buf, size_t _size)
+{
+    if( _file.Seek(static_cast<off_t>(_offset), VFSFile::Seek_Set) != static_cast<off_t>(_offset) )
+        return false;
+    auto *buf = static_cast<std::byte *>(_buf);
+    while( _size != 0 ) {
+        const ssize_t read = _file.Read(buf, _size);
+        if( read <= 0 )
+            return false;
+        buf += read;
+        _size -= read;
+    }
+    return true;
+}
+
+std::unique_ptr<DirectAccessLocator> DirectAccessLocator::Make(struct archive *_archive, VFSFile &_file)
+{
+    const int format = archive_format(_archive) & ARCHIVE_FORMAT_BASE_MASK;
+    if( format == ARCHIVE_FORMAT_TAR ) {
+        // only the raw tar stream has its offsets matching the file
+        if( archive_filter_count(_archive) != 1 || archive_filter_code(_archive, 0) != ARCHIVE_FILTER_NONE )
+            return nullptr;
+        auto locator = std::unique_ptr<DirectAccessLocator>(new DirectAccessLocator);
+        locator->m_Tar = true;
+        return locator;
+    }
+    if( format == ARCHIVE_FORMAT_ZIP ) {
+        auto locator = std::unique_ptr<DirectAccessLocator>(new DirectAccessLocator);
+        if( !locator->ReadZipCentralDirectory(_file) )
+            return nullptr;
+        return locator;
+    }
+    return nullptr;
+}
+
+bool DirectAccessLocator::ReadZipCentralDirectory(VFSFile &_file)
+{
+    const ssize_t file_size = _file.Size();
+    if( file_size < static_cast<ssize_t>(g_ZipEndOfCentralDirectorySize) )
+        return false;
+
+    // the end of central directory record is followed by a comment of up to 64K
+    const uint64_t tail_size = std::min<uint64_t>(file_size, g_ZipEndOfCentralDirectorySize + 0xFFFF);
+    const uint64_t tail_offset = file_size - tail_size;
+    std::vector<uint8_t> tail(tail_size);
+    if( !ReadExactly(_file, tail_offset, tail.data(), tail.size()) )
+        return false;
+
+    std::optional<size_t> eocd;
+    for( size_t i = tail.size() - g_ZipEndOfCentralDirectorySize + 1; i-- > 0; )
+        if( Get32(&tail[i]) == g_ZipEndOfCentralDirectorySignature ) {
+            eocd = i;
+            break;
+        }
+    if( !eocd )
+        return false;
+
+    const uint8_t *const record = &tail[*eocd];
+    if( Get16(record + 4) != 0 || Get16(record + 6) != 0 )
+        return false; // multi-volume archives are not supported
+    uint64_t entries = Get16(record + 10);
+    uint64_t cd_size = Get32(record + 12);
+    uint64_t cd_offset = Get32(record + 16);
+
+    if( entries == 0xFFFF || cd_size == 0xFFFFFFFF || cd_offset == 0xFFFFFFFF ) {
+        const uint64_t eocd_offset = tail_offset + *eocd;
+        if( eocd_offset < g_Zip64EndOfCentralDirectoryLocatorSize )
+            return false;
+        uint8_t locator[g_Zip64EndOfCentralDirectoryLocatorSize];
+        if( !ReadExactly(_file, eocd_offset - sizeof(locator), locator, sizeof(locator)) ||
+            Get32(locator) != g_Zip64EndOfCentralDirectoryLocatorSignature )
+            return false;
+        uint8_t record64[g_Zip64EndOfCentralDirectorySize];
+        if( !ReadExactly(_file, Get64(locator + 8), record64, sizeof(record64)) ||
+            Get32(record64) != g_Zip64EndOfCentralDirectorySignature )
+            return false;
+        entries = Get64(record64 + 32);
+        cd_size = Get64(record64 + 40);
+        cd_offset = Get64(record64 + 48);
+    }
+
+    if( cd_size > g_MaxCentralDirectorySize || cd_offset + cd_size > static_cast<uint64_t>(file_size) )
+        return false;
+
+    m_CentralDirectory.resize(cd_size);
+    if( !ReadExactly(_file, cd_offset, m_CentralDirectory.data(), m_CentralDirectory.size()) )
+        return false;
+
+    m_ZipEntries.reserve(entries);
+    const char *p = m_CentralDirectory.data();
+    const char *const end = p + m_CentralDirectory.size();
+    for( uint64_t i = 0; i < entries; ++i ) {
+        if( end - p < static_cast<ptrdiff_t>(g_ZipCentralHeaderSize) || Get32(p) != g_ZipCentralHeaderSignature )
+            return false;
+        const size_t name_len = Get16(p + 28);
+        const size_t extra_len = Get16(p + 30);
+        const size_t comment_len = Get16(p + 32);
+        if( static_cast<size_t>(end - p) < g_ZipCentralHeaderSize + name_len + extra_len + comment_len )
+            return false;
+
+        ZipEntry entry;
+        entry.flags = Get16(p + 8);
+        entry.method = Get16(p + 10);
+        entry.crc = Get32(p + 16);
+        entry.compressed_size = Get32(p + 20);
+        entry.uncompressed_size = Get32(p + 24);
+        entry.local_header_offset = Get32(p + 42);
+
+        // the Zip64 extra field contains only the values which didn't fit, in this order
+        const char *extra = p + g_ZipCentralHeaderSize + name_len;
+        const char *const extra_end = extra + extra_len;
+        while( extra_end - extra >= 4 ) {
+            const uint16_t id = Get16(extra);
+            const uint16_t size = Get16(extra + 2);
+            const char *data = extra + 4;
+            if( extra_end - data < size )
+                break;
+            if( id == g_ZipExtraZip64 ) {
+                const char *const data_end = data + size;
+                for( uint64_t *value : {&entry.uncompressed_size, &entry.compressed_size, &entry.local_header_offset} )
+                    if( *value == 0xFFFFFFFF && data_end - data >= 8 ) {
+                        *value = Get64(data);
+                        data += 8;
+                    }
+            }
+            extra = extra + 4 + size;
+        }
+
+        const std::string_view name(p + g_ZipCentralHeaderSize, name_len);
+        if( auto it = m_ZipEntries.find(name); it != m_ZipEntries.end() )
+            it->second.ambiguous = true;
+        else
+            m_ZipEntries.emplace(name, entry);
+
+        p += g_ZipCentralHeaderSize + name_len + extra_len + comment_len;
+    }
+    return true;
+}
+
+DirectEntry DirectAccessLocator::Locate(struct archive *_archive, struct archive_entry *_entry) const
+{
+    if( !S_ISREG(archive_entry_filetype(_entry)) || !archive_entry_size_is_set(_entry) ||
+        archive_entry_is_encrypted(_entry) || archive_entry_hardlink(_entry) != nullptr )
+        return {};
+
+    // the extended attributes are provided only by libarchive
+    size_t mac_metadata_size = 0;
+    if( archive_entry_mac_metadata(_entry, &mac_metadata_size) != nullptr && mac_metadata_size != 0 )
+        return {};
+
+    if( m_Tar ) {
+        if( archive_entry_sparse_count(_entry) != 0 )
+            return {};
+        // the header has just been consumed, so the current position is where the data starts
+        const int64_t position = archive_filter_bytes(_archive, -1);
+        if( position < 0 )
+            return {};
+        return {.offset = static_cast<uint64_t>(position), .kind = DirectEntry::Kind::Raw};
+    }
+
+    const char *const pathname = archive_entry_pathname(_entry);
+    if( pathname == nullptr )
+        return {};
+    const auto it = m_ZipEntries.find(std::string_view{pathname});
+    if( it == m_ZipEntries.end() )
+        return {};
+    const ZipEntry &zip = it->second;
+    if( zip.ambiguous || (zip.flags & g_ZipFlagEncrypted) ||
+        zip.uncompressed_size != static_cast<uint64_t>(archive_entry_size(_entry)) )
+        return {};
+    if( zip.method != g_ZipMethodStore && zip.method != g_ZipMethodDeflate )
+        return {};
+    if( zip.method == g_ZipMethodStore && zip.compressed_size != zip.uncompressed_size )
+        return {};
+
+    return {.offset = zip.local_header_offset,
+            .compressed_size = zip.compressed_size,
+            .crc = zip.crc,
+            .kind = zip.method == g_ZipMethodStore ? DirectEntry::Kind::ZipStored : DirectEntry::Kind::ZipDeflated};
+}
+
+std::unique_ptr<DirectReader> DirectReader::Open(VFSFilePtr _file, const DirectEntry &_entry, uint64_t _size)
+{
+    if( !_file || _entry.kind == DirectEntry::Kind::None )
+        return nullptr;
+
+    auto reader = std::unique_ptr<DirectReader>(new DirectReader);
+    reader->m_Kind = _entry.kind;
+    reader->m_Size = _size;
+
+    if( _entry.kind == DirectEntry::Kind::Raw ) {
+        reader->m_DataOffset = _entry.offset;
+        reader->m_CompressedSize = _size;
+    }
+    else {
+        uint8_t header[g_ZipLocalHeaderSize];
+        if( !ReadExactly(*_file, _entry.offset, header, sizeof(header)) || Get32(header) != g_ZipLocalHeaderSignature )
+            return nullptr;
+        const uint16_t method = Get16(header + 8);
+        if( method != (_entry.kind == DirectEntry::Kind::ZipStored ? g_ZipMethodStore : g_ZipMethodDeflate) )
+            return nullptr;
+        reader->m_DataOffset = _entry.offset + g_ZipLocalHeaderSize + Get16(header + 26) + Get16(header + 28);
+        reader->m_CompressedSize = _entry.compressed_size;
+        reader->m_ExpectedCRC = _entry.crc;
+        reader->m_VerifyCRC = true;
+    }
+
+    const ssize_t file_size = _file->Size();
+    if( file_size < 0 || reader->m_DataOffset + reader->m_CompressedSize > static_cast<uint64_t>(file_size) )
+        return nullptr;
+    if( _file->Seek(static_cast<off_t>(reader->m_DataOffset), VFSFile::Seek_Set) < 0 )
+        return nullptr;
+
+    if( _entry.kind == DirectEntry::Kind::ZipDeflated ) {
+        if( inflateInit2(&reader->m_Inflate, -MAX_WBITS) != Z_OK )
+            return nullptr;
+        reader->m_InflateInitialized = true;
+        reader->m_Input.resize(std::min<uint64_t>(g_InputBufferSize, std::max<uint64_t>(reader->m_CompressedSize, 1)));
+    }
+
+    reader->m_File = std::move(_file);
+    return reader;
+}
+
+DirectReader::~DirectReader()
+{
+    if( m_InflateInitialized )
+        inflateEnd(&m_Inflate);
+}
+
+bool DirectReader::IsSeekable() const noexcept
+{
+    return m_Kind != DirectEntry::Kind::ZipDeflated;
+}
+
+uint64_t DirectReader::Position() const noexcept
+{
+    return m_Position;
+}
+
+uint64_t DirectReader::Size() const noexcept
+{
+    return m_Size;
+}
+
+off_t DirectReader::Seek(uint64_t _position)
+{
+    if( !IsSeekable() )
+        return VFSError::NotSupported;
+    _position = std::min(_position, m_Size);
+    const off_t offset = static_cast<off_t>(m_DataOffset + _position);
+    if( m_File->Seek(offset, VFSFile::Seek_Set) != offset )
+        return VFSError::GenericError;
+    m_Position = _position;
+    m_VerifyCRC = false; // the checksum can't be verified after jumping around
+    return static_cast<off_t>(m_Position);
+}
+
+ssize_t DirectReader::Read(void *_buf, size_t _size)
+{
+    _size = static_cast<size_t>(std::min<uint64_t>(_size, m_Size - m_Position));
+    if( _size == 0 )
+        return 0;
+
+    const ssize_t read = m_Kind == DirectEntry::Kind::ZipDeflated ? ReadDeflated(_buf, _size) : ReadStored(_buf, _size);
+    if( read <= 0 )
+        return read;
+
+    m_Position += read;
+    if( m_VerifyCRC ) {
+        m_CRC = static_cast<uint32_t>(crc32(m_CRC, static_cast<const Bytef *>(_buf), static_cast<uInt>(read)));
+        if( m_Position == m_Size && m_CRC != m_ExpectedCRC )
+            return VFSError::ArclibFileFormat;
+    }
+    return read;
+}
+
+ssize_t DirectReader::ReadStored(void *_buf, size_t _size)
+{
+    const ssize_t read = m_File->Read(_buf, _size);
+    if( read == 0 )
+        return VFSError::UnexpectedEOF;
+    return read;
+}
+
+ssize_t DirectReader::ReadDeflated(void *_buf, size_t _size)
+{
+    m_Inflate.next_out = static_cast<Bytef *>(_buf);
+    m_Inflate.avail_out = static_cast<uInt>(std::min<size_t>(_size, std::numeric_limits<uInt>::max()));
+    while( m_Inflate.avail_out != 0 ) {
+        if( m_Inflate.avail_in == 0 ) {
+            const uint64_t left = m_CompressedSize - m_CompressedPosition;
+            if( left == 0 )
+                break;
+            const ssize_t read = m_File->Read(m_Input.data(), std::min<uint64_t>(left, m_Input.size()));
+            if( read < 0 )
+                return read;
+            if( read == 0 )
+                return VFSError::UnexpectedEOF;
+            m_CompressedPosition += read;
+            m_Inflate.next_in = reinterpret_cast<Bytef *>(m_Input.data());
+            m_Inflate.avail_in = static_cast<uInt>(read);
+        }
+        const int rc = inflate(&m_Inflate, Z_NO_FLUSH);
+        if( rc == Z_STREAM_END )
+            break;
+        if( rc != Z_OK && rc != Z_BUF_ERROR )
+            return VFSError::ArclibFileFormat;
+    }
+
+    const size_t produced = _size - m_Inflate.avail_out;
+    if( produced == 0 )
+        return VFSError::UnexpectedEOF;
+    return static_cast<ssize_t>(produced);
+}
+
+} // namespace nc::vfs::arc
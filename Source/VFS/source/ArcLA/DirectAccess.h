@@ -0,0 +1,92 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include "Internal.h"
+#include <Base/UnorderedUtil.h>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+
+namespace nc::vfs::arc {
+
+// Finds out where the data of archive entries is located while the archive is being scanned, so that the entries can
+// be read later without going through all the preceding headers.
+// Supported are Zip archives, which have a central directory, and uncompressed Tar archives.
+class DirectAccessLocator
+{
+public:
+    // Must be called once the first header was read, i.e. the format is already known.
+    // _file is a separate copy of the archive file, it's used only during this call.
+    // Returns nullptr if the archive doesn't allow a direct access.
+    static std::unique_ptr<DirectAccessLocator> Make(struct archive *_archive, VFSFile &_file);
+
+    // Must be called right after _entry was read by archive_read_next_header().
+    // Returns an empty location if the entry has to be read via libarchive.
+    DirectEntry Locate(struct archive *_archive, struct archive_entry *_entry) const;
+
+private:
+    struct ZipEntry {
+        uint64_t local_header_offset = 0;
+        uint64_t compressed_size = 0;
+        uint64_t uncompressed_size = 0;
+        uint32_t crc = 0;
+        uint16_t method = 0;
+        uint16_t flags = 0;
+        bool ambiguous = false; // there are several entries with the same name
+    };
+
+    DirectAccessLocator() = default;
+    bool ReadZipCentralDirectory(VFSFile &_file);
+
+    bool m_Tar = false;
+    std::vector<char> m_CentralDirectory;
+    ankerl::unordered_dense::map<std::string_view, ZipEntry> m_ZipEntries; // names point into m_CentralDirectory
+};
+
+// Reads the data of a single entry straight from the archive file, inflating it if needed.
+// The stored entries can also be read at arbitrary offsets.
+class DirectReader
+{
+public:
+    // Takes ownership of _file, which should be an opened seekable copy of the archive file.
+    // _size is the size of the entry's uncompressed data.
+    // Returns nullptr if the entry can't be read directly after all, e.g. the local header doesn't look right.
+    static std::unique_ptr<DirectReader> Open(VFSFilePtr _file, const DirectEntry &_entry, uint64_t _size);
+
+    DirectReader(const DirectReader &) = delete;
+    ~DirectReader();
+    DirectReader &operator=(const DirectReader &) = delete;
+
+    // Returns the amount of bytes read or a negative VFSError.
+    ssize_t Read(void *_buf, size_t _size);
+
+    bool IsSeekable() const noexcept;
+
+    // Returns the new position or a negative VFSError.
+    off_t Seek(uint64_t _position);
+
+    uint64_t Position() const noexcept;
+    uint64_t Size() const noexcept;
+
+private:
+    DirectReader() = default;
+    ssize_t ReadStored(void *_buf, size_t _size);
+    ssize_t ReadDeflated(void *_buf, size_t _size);
+
+    VFSFilePtr m_File;
+    DirectEntry::Kind m_Kind = DirectEntry::Kind::None;
+    uint64_t m_DataOffset = 0;
+    uint64_t m_Size = 0;
+    uint64_t m_CompressedSize = 0;
+    uint64_t m_Position = 0;
+    uint64_t m_CompressedPosition = 0;
+    uint32_t m_ExpectedCRC = 0;
+    uint32_t m_CRC = 0;
+    bool m_VerifyCRC = false;
+    bool m_InflateInitialized = false;
+    z_stream m_Inflate = {};
+    std::vector<std::byte> m_Input;
+};
+
+} // namespace nc::vfs::arc
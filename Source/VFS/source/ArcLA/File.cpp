@@ -1,8 +1,9 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include <libarchive/archive.h>
 #include <libarchive/archive_entry.h>
 
 #include "File.h"
+#include "DirectAccess.h"
 #include "Internal.h"
 #include <VFS/AppleDoubleEA.h>
 #include <Base/StackAllocator.h>
@@ -40,6 +41,16 @@ int File::Open(unsigned long _open_flags, const VFSCancelChecker &_cancel_checke
     if( host->IsDirectory(file_path, _open_flags, _cancel_checker) && !(_open_flags & VFSFlags::OF_Directory) )
         return VFSError::FromErrno(EISDIR);
 
+    if( const uint32_t uid = host->ItemUID(file_path.c_str()); uid != 0 ) {
+        if( auto direct = host->DirectReaderForItem(uid) ) {
+            m_EA.clear(); // entries with metadata are never read directly
+            m_Position = 0;
+            m_Size = static_cast<ssize_t>(direct->Size());
+            m_Direct = std::move(direct);
+            return VFSError::Ok;
+        }
+    }
+
     std::unique_ptr<State> state;
     res = host->ArchiveStateForItem(file_path.c_str(), state);
     if( res < 0 )
@@ -61,21 +72,52 @@ int File::Open(unsigned long _open_flags, const VFSCancelChecker &_cancel_checke
 
 bool File::IsOpened() const
 {
-    return m_State != nullptr;
+    return m_State != nullptr || m_Direct != nullptr;
 }
 
 int File::Close()
 {
-    std::dynamic_pointer_cast<ArchiveHost>(Host())->CommitState(std::move(m_State));
+    m_Direct.reset();
+    if( m_State )
+        std::dynamic_pointer_cast<ArchiveHost>(Host())->CommitState(std::move(m_State));
     m_State.reset();
     return VFSError::Ok;
 }
 
 VFSFile::ReadParadigm File::GetReadParadigm() const
 {
+    if( m_Direct && m_Direct->IsSeekable() )
+        return VFSFile::ReadParadigm::Seek;
     return VFSFile::ReadParadigm::Sequential;
 }
 
+off_t File::Seek(off_t _off, int _basis)
+{
+    if( !IsOpened() )
+        return SetLastError(VFSError::InvalidCall);
+    if( !m_Direct || !m_Direct->IsSeekable() )
+        return SetLastError(VFSError::NotSupported);
+
+    off_t req_pos = 0;
+    if( _basis == VFSFile::Seek_Set )
+        req_pos = _off;
+    else if( _basis == VFSFile::Seek_End )
+        req_pos = m_Size + _off;
+    else if( _basis == VFSFile::Seek_Cur )
+        req_pos = m_Position + _off;
+    else
+        return SetLastError(VFSError::InvalidCall);
+
+    if( req_pos < 0 )
+        return SetLastError(VFSError::InvalidCall);
+
+    const off_t pos = m_Direct->Seek(static_cast<uint64_t>(req_pos));
+    if( pos < 0 )
+        return SetLastError(static_cast<int>(pos));
+    m_Position = pos;
+    return pos;
+}
+
 ssize_t File::Pos() const
 {
     if( !IsOpened() )
@@ -106,6 +148,14 @@ ssize_t File::Read(void *_buf, size_t _size)
 
     assert(_buf != nullptr);
 
+    if( m_Direct ) {
+        const ssize_t size = m_Direct->Read(_buf, _size);
+        if( size < 0 )
+            return SetLastError(static_cast<int>(size));
+        m_Position += size;
+        return size;
+    }
+
     m_State->ConsumeEntry();
     const ssize_t size = archive_read_data(m_State->Archive(), _buf, _size);
     if( size < 0 ) {
@@ -1,4 +1,4 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include "Host.h"
@@ -9,6 +9,8 @@ struct AppleDoubleEA;
 
 namespace nc::vfs::arc {
 
+class DirectReader;
+
 class File final : public VFSFile
 {
 public:
@@ -20,6 +22,7 @@ public:
     virtual int Close() override;
     virtual ssize_t Read(void *_buf, size_t _size) override;
     virtual ReadParadigm GetReadParadigm() const override;
+    virtual off_t Seek(off_t _off, int _basis) override;
     virtual ssize_t Pos() const override;
     virtual ssize_t Size() const override;
     virtual bool Eof() const override;
@@ -29,6 +32,7 @@ public:
 
 private:
     std::unique_ptr<State> m_State;
+    std::unique_ptr<DirectReader> m_Direct; // used instead of m_State when the data can be read directly
     std::vector<AppleDoubleEA> m_EA;
     ssize_t m_Position;
     ssize_t m_Size;
@@ -4,9 +4,11 @@
 
 #include "Host.h"
 #include "../ListingInput.h"
+#include "DirectAccess.h"
 #include "EncodingDetection.h"
 #include "File.h"
 #include "Internal.h"
+#include "ListingIndex.h"
 #include <Base/CFStackAllocator.h>
 #include <Base/UnorderedUtil.h>
 #include <Base/algo.h>
@@ -49,8 +51,15 @@ struct ArchiveHost::Impl {
     SymlinksT m_Symlinks;
     std::recursive_mutex m_SymlinksResolveLock;
 
-    // TODO: this leaves 4 bytes of gaps, i.e. for 500K# archive = 2MB of waste(!)
-    std::vector<std::pair<arc::Dir *, uint32_t>> m_EntryByUID; // points to directory and entry No inside it
+    struct EntryLocation {
+        uint32_t dir = std::numeric_limits<uint32_t>::max(); // index of the directory
+        uint32_t entry = 0;                                  // index of the entry inside that directory
+    };
+    std::vector<EntryLocation> m_EntryByUID;
+    arc::NamesPool m_Names;
+
+    // locations of the entries' data indexed by their UIDs, empty if the archive doesn't allow a direct access
+    std::vector<arc::DirectEntry> m_DirectEntries;
 
     std::vector<std::unique_ptr<arc::State>> m_States;
     std::mutex m_StatesLock;
@@ -58,6 +67,24 @@ struct ArchiveHost::Impl {
     struct stat m_SrcFileStat;
 };
 
+namespace {
+
+struct ListingIndexSettings {
+    std::shared_ptr<const ListingIndexStorage> storage;
+    uint32_t min_entries = 0;
+};
+
+} // namespace
+
+[[clang::no_destroy]] static std::mutex g_ListingIndexLock;
+[[clang::no_destroy]] static ListingIndexSettings g_ListingIndex;
+
+static ListingIndexSettings CurrentListingIndexSettings()
+{
+    const auto lock = std::lock_guard{g_ListingIndexLock};
+    return g_ListingIndex;
+}
+
 class VFSArchiveHostConfiguration
 {
 public:
@@ -191,15 +218,22 @@ std::expected<void, Error> ArchiveHost::DoInit(const VFSCancelChecker &_cancel_c
         return std::unexpected(VFSError::ToError(
             VFSError::ArclibFileFormat)); // libarchive thinks that zero-bytes archives are OK, but I don't think so.
 
+    // libarchive starts parsing while the rest is still being fetched. the cancel checker might not outlive the
+    // opening, so the wrapper stops using it afterwards - the fetching stops anyway once the wrapper is released.
+    std::shared_ptr<VFSSeqToRandomROWrapperFile> streaming;
+    const auto reset_streaming_callbacks = at_scope_end([&] {
+        if( streaming )
+            streaming->ResetCallbacks();
+    });
     if( Parent()->IsNativeFS() ) {
         I->m_ArFile = source_file;
     }
     else {
-        auto wrapping = std::make_shared<VFSSeqToRandomROWrapperFile>(source_file);
-        res = wrapping->Open(VFSFlags::OF_Read, _cancel_checker);
+        streaming = std::make_shared<VFSSeqToRandomROWrapperFile>(source_file);
+        res = streaming->OpenStreaming(VFSFlags::OF_Read, _cancel_checker);
         if( res != VFSError::Ok )
             return std::unexpected(VFSError::ToError(res));
-        I->m_ArFile = wrapping;
+        I->m_ArFile = streaming;
     }
 
     if( I->m_ArFile->GetReadParadigm() < VFSFile::ReadParadigm::Sequential ) {
@@ -207,6 +241,23 @@ std::expected<void, Error> ArchiveHost::DoInit(const VFSCancelChecker &_cancel_c
         return std::unexpected(VFSError::ToError(VFSError::InvalidCall));
     }
 
+    const ListingIndexSettings index_settings = CurrentListingIndexSettings();
+    std::optional<ListingIndexKey> index_key;
+    if( index_settings.storage && Parent()->IsNativeFS() ) {
+        index_key.emplace();
+        index_key->path = std::string_view{path};
+        index_key->size = I->m_SrcFileStat.st_size;
+        index_key->mtime = I->m_SrcFileStat.st_mtimespec;
+        index_key->inode = I->m_SrcFileStat.st_ino;
+        if( std::optional<ListingIndex> index = index_settings.storage->Load(*index_key) ) {
+            if( index->summary.has_encrypted_entries && !Config().password )
+                return std::unexpected(VFSError::ToError(VFSError::ArclibPasswordRequired));
+            RestoreArchiveListing(std::move(*index));
+            I->m_ArchiveFileSize = I->m_ArFile->Size();
+            return {};
+        }
+    }
+
     I->m_Mediator = std::make_shared<Mediator>();
     I->m_Mediator->file = I->m_ArFile;
 
@@ -236,9 +287,82 @@ std::expected<void, Error> ArchiveHost::DoInit(const VFSCancelChecker &_cancel_c
     if( res != VFSError::Ok )
         return std::unexpected(VFSError::ToError(res));
 
+    if( index_key && I->m_TotalFiles >= index_settings.min_entries )
+        StoreArchiveListing(*index_settings.storage, *index_key, archive_read_has_encrypted_entries(I->m_Arc) > 0);
+
     return {};
 }
 
+void ArchiveHost::SetListingIndexDirectory(const std::filesystem::path &_directory, uint32_t _min_entries)
+{
+    const auto lock = std::lock_guard{g_ListingIndexLock};
+    g_ListingIndex.storage = _directory.empty() ? nullptr : std::make_shared<const ListingIndexStorage>(_directory);
+    g_ListingIndex.min_entries = _min_entries;
+}
+
+void ArchiveHost::RestoreArchiveListing(ListingIndex &&_index)
+{
+    assert(I->m_PathToDir.empty());
+    I->m_TotalFiles = _index.summary.total_files;
+    I->m_TotalDirs = _index.summary.total_dirs;
+    I->m_TotalRegs = _index.summary.total_regs;
+    I->m_LastItemUID = _index.summary.last_item_uid;
+    I->m_ArchivedFilesTotalSize = _index.summary.archived_files_total_size;
+
+    I->m_Names = std::move(_index.names);
+    for( Dir &dir : _index.directories ) {
+        const Dir &placed = RegisterDir(std::move(dir));
+        for( size_t i = 0, e = placed.entries.size(); i < e; ++i ) {
+            const uint32_t aruid = placed.entries[i].aruid;
+            if( aruid == SyntheticArUID )
+                continue;
+            if( I->m_EntryByUID.size() <= aruid )
+                I->m_EntryByUID.resize(aruid + 1);
+            I->m_EntryByUID[aruid] = {.dir = placed.index, .entry = static_cast<uint32_t>(i)};
+        }
+    }
+
+    for( ListingIndexSymlink &indexed : _index.symlinks ) {
+        Symlink symlink;
+        symlink.uid = indexed.uid;
+        if( indexed.value.empty() )
+            symlink.state = SymlinkState::Invalid;
+        else
+            symlink.value = std::move(indexed.value);
+        I->m_Symlinks.emplace(indexed.uid, std::move(symlink));
+    }
+    I->m_NeedsPathResolving = !I->m_Symlinks.empty();
+    I->m_DirectEntries = std::move(_index.direct_entries);
+}
+
+void ArchiveHost::StoreArchiveListing(const ListingIndexStorage &_storage,
+                                      const ListingIndexKey &_key,
+                                      bool _has_encrypted_entries) const
+{
+    std::vector<const Dir *> directories;
+    directories.reserve(I->m_PathToDir.size());
+    for( const auto &path_and_dir : I->m_PathToDir )
+        directories.push_back(&path_and_dir.second);
+
+    std::vector<ListingIndexSymlink> symlinks;
+    symlinks.reserve(I->m_Symlinks.size());
+    for( const auto &[uid, symlink] : I->m_Symlinks )
+        symlinks.push_back({.uid = uid, .value = symlink.state == SymlinkState::Invalid ? "" : symlink.value.native()});
+
+    ListingIndexSummary summary;
+    summary.total_files = I->m_TotalFiles;
+    summary.total_dirs = I->m_TotalDirs;
+    summary.total_regs = I->m_TotalRegs;
+    summary.last_item_uid = I->m_LastItemUID;
+    summary.archived_files_total_size = I->m_ArchivedFilesTotalSize;
+    summary.has_encrypted_entries = _has_encrypted_entries;
+
+    const std::vector<std::byte> image =
+        ComposeListingIndex(_key, summary, directories, I->m_Names, symlinks, I->m_DirectEntries);
+    if( image.empty() || !_storage.Store(_key, image) )
+        Log::Warn("Failed to store the listing index of {}", _key.path);
+}
+
 static bool SplitIntoFilenameAndParentPath(const char *_path,
                                            char *_filename,
                                            int _filename_sz,
@@ -296,16 +420,30 @@ int ArchiveHost::ReadArchiveListing()
         Dir root_dir;
         root_dir.full_path = "/";
         root_dir.name_in_parent = "";
-        const auto ret = I->m_PathToDir.emplace("/", std::move(root_dir));
-        parent_dir = &ret.first->second;
+        parent_dir = &RegisterDir(std::move(root_dir));
     }
 
     std::optional<CFStringEncoding> detected_encoding;
+    std::unique_ptr<DirectAccessLocator> direct_locator;
 
     struct archive_entry *aentry;
     int ret;
     while( (ret = archive_read_next_header(I->m_Arc, &aentry)) == ARCHIVE_OK ) {
         aruid++;
+        if( aruid == 1 ) {
+            // the format is known only after the first header was read
+            if( const std::expected<VFSFilePtr, int> file = SpawnArchiveFile() )
+                direct_locator = DirectAccessLocator::Make(I->m_Arc, **file);
+        }
+        if( direct_locator ) {
+            const DirectEntry direct = direct_locator->Locate(I->m_Arc, aentry);
+            if( direct.kind != DirectEntry::Kind::None ) {
+                if( I->m_DirectEntries.size() <= aruid )
+                    I->m_DirectEntries.resize(aruid + 1);
+                I->m_DirectEntries[aruid] = direct;
+            }
+        }
+
         const struct stat *stat = archive_entry_stat(aentry);
         if( stat == nullptr )
             continue; // check for broken archives
@@ -380,7 +518,7 @@ int ArchiveHost::ReadArchiveListing()
         if( isdir ) // check if it wasn't added before via FindOrBuildDir
             for( size_t i = 0, e = parent_dir->entries.size(); i < e; ++i ) {
                 auto &it = parent_dir->entries[i];
-                if( (it.st.st_mode & S_IFMT) == S_IFDIR && it.name == short_name ) {
+                if( (it.mode & S_IFMT) == S_IFDIR && I->m_Names.Get(it) == short_name ) {
                     assert(it.aruid == SyntheticArUID);
                     entry = &it;
                     entry_index_in_dir = static_cast<unsigned>(i);
@@ -389,19 +527,20 @@ int ArchiveHost::ReadArchiveListing()
             }
 
         if( entry == nullptr ) {
-            parent_dir->entries.emplace_back();
-            entry_index_in_dir = static_cast<unsigned>(parent_dir->entries.size() - 1);
-            entry = &parent_dir->entries.back();
-            entry->name = short_name;
+            DirEntry new_entry;
+            if( !I->m_Names.Add(short_name, new_entry) )
+                return VFSError::FromErrno(EFBIG);
+            entry_index_in_dir = static_cast<unsigned>(parent_dir->entries.size());
+            entry = &parent_dir->entries.emplace_back(new_entry);
         }
 
         entry->aruid = aruid;
-        entry->st = *stat;
+        entry->SetStat(*stat);
         I->m_ArchivedFilesTotalSize += stat->st_size;
 
         if( I->m_EntryByUID.size() <= entry->aruid )
-            I->m_EntryByUID.resize(entry->aruid + 1, std::make_pair(nullptr, 0));
-        I->m_EntryByUID[entry->aruid] = std::make_pair(parent_dir, entry_index_in_dir);
+            I->m_EntryByUID.resize(entry->aruid + 1);
+        I->m_EntryByUID[entry->aruid] = {.dir = parent_dir->index, .entry = entry_index_in_dir};
 
         if( issymlink ) { // read any symlink values at archive opening time
             const char *link = archive_entry_symlink(aentry);
@@ -429,7 +568,7 @@ int ArchiveHost::ReadArchiveListing()
                 Dir dir;
                 dir.full_path = path; // full_path is with trailing slash
                 dir.name_in_parent = strrchr(tmp, '/') + 1;
-                I->m_PathToDir.emplace(path, std::move(dir));
+                RegisterDir(std::move(dir));
             }
         }
 
@@ -444,6 +583,12 @@ int ArchiveHost::ReadArchiveListing()
 
     UpdateDirectorySize(I->m_PathToDir["/"], "/");
 
+    // the listing is immutable from now on, give back the spare capacity
+    for( auto &path_and_dir : I->m_PathToDir )
+        path_and_dir.second.entries.shrink_to_fit();
+    I->m_EntryByUID.shrink_to_fit();
+    I->m_Names.ShrinkToFit();
+
     if( ret == ARCHIVE_EOF )
         return VFSError::Ok;
 
@@ -459,17 +604,17 @@ uint64_t ArchiveHost::UpdateDirectorySize(Dir &_directory, const std::string &_p
 {
     uint64_t size = 0;
     for( auto &e : _directory.entries )
-        if( S_ISDIR(e.st.st_mode) ) {
-            const auto subdir_path = _path + e.name + "/";
+        if( S_ISDIR(e.mode) ) {
+            const auto subdir_path = fmt::format("{}{}/", _path, I->m_Names.Get(e));
             const auto it = I->m_PathToDir.find(subdir_path);
             if( it != std::end(I->m_PathToDir) ) {
                 const auto subdir_sz = UpdateDirectorySize(it->second, subdir_path);
-                e.st.st_size = subdir_sz;
+                e.size = static_cast<int64_t>(subdir_sz);
                 size += subdir_sz;
             }
         }
-        else if( S_ISREG(e.st.st_mode) )
-            size += e.st.st_size;
+        else if( S_ISREG(e.mode) )
+            size += e.size;
 
     _directory.content_size = size;
 
@@ -499,33 +644,44 @@ Dir *ArchiveHost::FindOrBuildDir(const std::string_view _path_with_tr_sl)
 
     // TODO: need to check presense of entry_name in parent_dir
 
-    InsertDummyDirInto(parent_dir, entry_name);
+    if( !InsertDummyDirInto(parent_dir, entry_name) )
+        return nullptr;
     Dir entry;
     entry.full_path = _path_with_tr_sl;
     entry.name_in_parent = entry_name;
-    const auto it = I->m_PathToDir.emplace(_path_with_tr_sl, std::move(entry));
-    return &(*it.first).second;
+    return &RegisterDir(std::move(entry));
 }
 
-void ArchiveHost::InsertDummyDirInto(Dir *_parent, const std::string_view _dir_name)
+Dir &ArchiveHost::RegisterDir(Dir &&_directory)
+{
+    // the segmented map appends new values, so the index of a directory stays the same
+    _directory.index = static_cast<uint32_t>(I->m_PathToDir.size());
+    std::string path = _directory.full_path;
+    const auto it = I->m_PathToDir.emplace(std::move(path), std::move(_directory));
+    assert(it.second);
+    return it.first->second;
+}
+
+bool ArchiveHost::InsertDummyDirInto(Dir *_parent, const std::string_view _dir_name)
 {
     constexpr mode_t synthetic_mode = S_IFDIR |                     //
                                       S_IRUSR | S_IXUSR | S_IWUSR | //
                                       S_IRGRP | S_IXGRP |           //
                                       S_IROTH | S_IXOTH;
 
-    _parent->entries.emplace_back();
-    auto &entry = _parent->entries.back();
-    entry.name = _dir_name;
-    memset(&entry.st, 0, sizeof(entry.st));
-    entry.st.st_mode = synthetic_mode;
-    entry.st.st_atimespec = I->m_SrcFileStat.st_atimespec;
-    entry.st.st_mtimespec = I->m_SrcFileStat.st_mtimespec;
-    entry.st.st_ctimespec = I->m_SrcFileStat.st_ctimespec;
-    entry.st.st_birthtimespec = I->m_SrcFileStat.st_birthtimespec;
-    entry.st.st_uid = I->m_SrcFileStat.st_uid;
-    entry.st.st_gid = I->m_SrcFileStat.st_gid;
+    DirEntry entry;
+    if( !I->m_Names.Add(_dir_name, entry) )
+        return false;
+    entry.mode = synthetic_mode;
+    entry.atime = ToNanoseconds(I->m_SrcFileStat.st_atimespec);
+    entry.mtime = ToNanoseconds(I->m_SrcFileStat.st_mtimespec);
+    entry.ctime = ToNanoseconds(I->m_SrcFileStat.st_ctimespec);
+    entry.btime = ToNanoseconds(I->m_SrcFileStat.st_birthtimespec);
+    entry.uid = I->m_SrcFileStat.st_uid;
+    entry.gid = I->m_SrcFileStat.st_gid;
     entry.aruid = SyntheticArUID;
+    _parent->entries.emplace_back(entry);
+    return true;
 }
 
 std::expected<std::shared_ptr<VFSFile>, Error> ArchiveHost::CreateFile(std::string_view _path,
@@ -587,31 +743,28 @@ std::expected<VFSListingPtr, Error> ArchiveHost::FetchDirectoryListing(std::stri
     }
 
     for( auto &entry : directory.entries ) {
-        listing_source.filenames.emplace_back(entry.name);
-        listing_source.unix_types.emplace_back(IFTODT(entry.st.st_mode));
+        listing_source.filenames.emplace_back(I->m_Names.Get(entry));
+        listing_source.unix_types.emplace_back(IFTODT(entry.mode));
 
         const int index = int(listing_source.filenames.size() - 1);
-        auto stat = entry.st;
-        if( S_ISLNK(entry.st.st_mode) )
+        const DirEntry *stat = &entry;
+        if( S_ISLNK(entry.mode) )
             if( auto symlink = ResolvedSymlink(entry.aruid) ) {
                 listing_source.symlinks.insert(index, symlink->value);
                 if( symlink->state == SymlinkState::Resolved )
                     if( auto target_entry = FindEntry(symlink->target_uid) )
-                        stat = target_entry->st;
+                        stat = target_entry;
             }
 
-        listing_source.unix_modes.emplace_back(stat.st_mode);
-        listing_source.sizes.insert(index,
-                                    //                                    S_ISDIR(stat.st_mode) ?
-                                    //                                        VFSListingInput::unknown_size :
-                                    stat.st_size);
-        listing_source.atimes.insert(index, stat.st_atime);
-        listing_source.ctimes.insert(index, stat.st_ctime);
-        listing_source.mtimes.insert(index, stat.st_mtime);
-        listing_source.btimes.insert(index, stat.st_birthtime);
-        listing_source.uids.insert(index, stat.st_uid);
-        listing_source.gids.insert(index, stat.st_gid);
-        listing_source.unix_flags.insert(index, stat.st_flags);
+        listing_source.unix_modes.emplace_back(stat->mode);
+        listing_source.sizes.insert(index, stat->size);
+        listing_source.atimes.insert(index, ToSeconds(stat->atime));
+        listing_source.ctimes.insert(index, ToSeconds(stat->ctime));
+        listing_source.mtimes.insert(index, ToSeconds(stat->mtime));
+        listing_source.btimes.insert(index, ToSeconds(stat->btime));
+        listing_source.uids.insert(index, stat->uid);
+        listing_source.gids.insert(index, stat->gid);
+        listing_source.unix_flags.insert(index, stat->flags);
     }
 
     return VFSListing::Build(std::move(listing_source));
@@ -653,7 +806,7 @@ ArchiveHost::Stat(std::string_view _path, unsigned long _flags, const VFSCancelC
 
     if( auto it = FindEntry(resolve_buf) ) {
         VFSStat st;
-        VFSStat::FromSysStat(it->st, st);
+        VFSStat::FromSysStat(it->Stat(), st);
         return st;
     }
     return std::unexpected(Error{Error::POSIX, ENOENT});
@@ -698,14 +851,18 @@ ArchiveHost::IterateDirectoryListing(std::string_view _path,
     VFSDirEnt dir;
 
     for( const auto &it : i->second.entries ) {
-        strcpy(dir.name, it.name.c_str());
-        dir.name_len = uint16_t(it.name.length());
+        const std::string_view name = I->m_Names.Get(it);
+        if( name.length() >= sizeof(dir.name) )
+            continue;
+        std::memcpy(dir.name, name.data(), name.length());
+        dir.name[name.length()] = 0;
+        dir.name_len = uint16_t(name.length());
 
-        if( S_ISDIR(it.st.st_mode) )
+        if( S_ISDIR(it.mode) )
             dir.type = VFSDirEnt::Dir;
-        else if( S_ISREG(it.st.st_mode) )
+        else if( S_ISREG(it.mode) )
             dir.type = VFSDirEnt::Reg;
-        else if( S_ISLNK(it.st.st_mode) )
+        else if( S_ISLNK(it.mode) )
             dir.type = VFSDirEnt::Link;
         else
             dir.type = VFSDirEnt::Unknown; // other stuff is not supported currently
@@ -764,9 +921,9 @@ const DirEntry *ArchiveHost::FindEntry(std::string_view _path)
         return nullptr;
 
     // ok, found dir, now let's find item
-    const size_t short_name_len = strlen(short_name);
+    const std::string_view name = short_name;
     for( const auto &it : i->second.entries )
-        if( it.name.length() == short_name_len && it.name == short_name )
+        if( it.name_length == name.length() && I->m_Names.Get(it) == name )
             return &it;
 
     return nullptr;
@@ -777,11 +934,13 @@ const DirEntry *ArchiveHost::FindEntry(uint32_t _uid)
     if( !_uid || _uid >= I->m_EntryByUID.size() )
         return nullptr;
 
-    auto dir = I->m_EntryByUID[_uid].first;
-    auto ind = I->m_EntryByUID[_uid].second;
+    const Impl::EntryLocation location = I->m_EntryByUID[_uid];
+    if( location.dir >= I->m_PathToDir.size() )
+        return nullptr;
 
-    assert(ind < dir->entries.size());
-    return &dir->entries[ind];
+    const Dir &dir = I->m_PathToDir.values()[location.dir].second;
+    assert(location.entry < dir.entries.size());
+    return &dir.entries[location.entry];
 }
 
 int ArchiveHost::ResolvePath(std::string_view _path, std::pmr::string &_resolved_path)
@@ -800,7 +959,7 @@ int ArchiveHost::ResolvePath(std::string_view _path, std::pmr::string &_resolved
         if( !entry )
             return VFSError::NotFound;
 
-        if( (entry->st.st_mode & S_IFMT) == S_IFLNK ) {
+        if( (entry->mode & S_IFMT) == S_IFLNK ) {
             const auto symlink_it = I->m_Symlinks.find(entry->aruid);
             if( symlink_it == I->m_Symlinks.end() )
                 return VFSError::NotFound;
@@ -897,24 +1056,13 @@ int ArchiveHost::ArchiveStateForItem(const char *_filename, std::unique_ptr<Stat
     auto state = ClosestState(requested_item);
 
     if( !state ) {
-        VFSFilePtr file;
-
-        // bad-bad design decision, need to refactor this later
-        if( auto wrapping = std::dynamic_pointer_cast<VFSSeqToRandomROWrapperFile>(I->m_ArFile) )
-            file = wrapping->Share();
-        else
-            file = I->m_ArFile->Clone();
-
+        const std::expected<VFSFilePtr, int> file = SpawnArchiveFile();
         if( !file )
-            return VFSError::NotSupported;
-
-        int res = file->IsOpened() ? VFSError::Ok : file->Open(VFSFlags::OF_Read);
-        if( res < 0 )
-            return res;
+            return file.error();
 
-        auto new_state = std::make_unique<State>(file, SpawnLibarchive());
+        auto new_state = std::make_unique<State>(*file, SpawnLibarchive());
 
-        res = new_state->Open();
+        const int res = new_state->Open();
         if( res < 0 ) {
             const int rc = VFSError::FromLibarchive(new_state->Errno());
             return rc;
@@ -952,6 +1100,42 @@ int ArchiveHost::ArchiveStateForItem(const char *_filename, std::unique_ptr<Stat
     return VFSError::Ok;
 }
 
+std::expected<VFSFilePtr, int> ArchiveHost::SpawnArchiveFile()
+{
+    VFSFilePtr file;
+
+    // bad-bad design decision, need to refactor this later
+    if( auto wrapping = std::dynamic_pointer_cast<VFSSeqToRandomROWrapperFile>(I->m_ArFile) )
+        file = wrapping->Share();
+    else
+        file = I->m_ArFile->Clone();
+
+    if( !file )
+        return std::unexpected(VFSError::NotSupported);
+
+    const int res = file->IsOpened() ? VFSError::Ok : file->Open(VFSFlags::OF_Read);
+    if( res < 0 )
+        return std::unexpected(res);
+
+    return file;
+}
+
+std::unique_ptr<DirectReader> ArchiveHost::DirectReaderForItem(uint32_t _uid)
+{
+    if( _uid >= I->m_DirectEntries.size() || I->m_DirectEntries[_uid].kind == DirectEntry::Kind::None )
+        return nullptr;
+
+    const DirEntry *const entry = FindEntry(_uid);
+    if( entry == nullptr )
+        return nullptr;
+
+    std::expected<VFSFilePtr, int> file = SpawnArchiveFile();
+    if( !file || (*file)->GetReadParadigm() < VFSFile::ReadParadigm::Seek )
+        return nullptr;
+
+    return DirectReader::Open(std::move(*file), I->m_DirectEntries[_uid], entry->size);
+}
+
 struct archive *ArchiveHost::SpawnLibarchive()
 {
     archive *arc = archive_read_new();
@@ -1015,7 +1199,10 @@ void ArchiveHost::ResolveSymlink(uint32_t _uid)
     const std::filesystem::path &symlink_path = symlink.value;
     std::filesystem::path result_path;
     if( symlink_path.is_relative() ) {
-        result_path = I->m_EntryByUID[_uid].first->full_path;
+        const uint32_t dir_index = I->m_EntryByUID[_uid].dir;
+        if( dir_index >= I->m_PathToDir.size() )
+            return;
+        result_path = I->m_PathToDir.values()[dir_index].second.full_path;
 
         for( const auto &i : symlink_path ) {
             if( i != "" && i != "." ) {
@@ -1097,7 +1284,7 @@ std::expected<std::string, Error> ArchiveHost::ReadSymlink(std::string_view _sym
     if( !entry )
         return std::unexpected(Error{Error::POSIX, ENOENT});
 
-    if( (entry->st.st_mode & S_IFMT) != S_IFLNK )
+    if( (entry->mode & S_IFMT) != S_IFLNK )
         return std::unexpected(Error{Error::POSIX, EINVAL});
 
     const auto symlink_it = I->m_Symlinks.find(entry->aruid);
@@ -13,6 +13,10 @@ struct Mediator;
 struct Dir;
 struct DirEntry;
 struct State;
+struct ListingIndex;
+struct ListingIndexKey;
+class ListingIndexStorage;
+class DirectReader;
 } // namespace arc
 
 class ArchiveHost final : public Host
@@ -65,6 +69,11 @@ public:
 
     bool ShouldProduceThumbnails() const override;
 
+    // Enables a persistent index of archive listings kept in _directory, which allows re-opening an unchanged archive
+    // without scanning all its headers. Only archives located on native volumes with at least _min_entries entries
+    // are indexed. An empty _directory disables the index. Affects the hosts created afterwards.
+    static void SetListingIndexDirectory(const std::filesystem::path &_directory, uint32_t _min_entries = 4096);
+
     uint32_t StatTotalFiles() const;
     uint32_t StatTotalDirs() const;
     uint32_t StatTotalRegs() const;
@@ -80,6 +89,10 @@ public:
     // use SeekCache or open a new file and seeks to requested item
     int ArchiveStateForItem(const char *_filename, std::unique_ptr<arc::State> &_target);
 
+    // returns a reader which accesses the item's data directly in the archive file without going through libarchive,
+    // or nullptr if that's not possible for this item
+    std::unique_ptr<arc::DirectReader> DirectReaderForItem(uint32_t _uid);
+
     std::shared_ptr<const ArchiveHost> SharedPtr() const;
 
     std::shared_ptr<ArchiveHost> SharedPtr();
@@ -124,12 +137,20 @@ private:
     const class VFSArchiveHostConfiguration &Config() const;
 
     int ReadArchiveListing();
+    void RestoreArchiveListing(arc::ListingIndex &&_index);
+    void StoreArchiveListing(const arc::ListingIndexStorage &_storage,
+                             const arc::ListingIndexKey &_key,
+                             bool _has_encrypted_entries) const;
     uint64_t UpdateDirectorySize(arc::Dir &_directory, const std::string &_path);
     arc::Dir *FindOrBuildDir(std::string_view _path_with_tr_sl);
+    arc::Dir &RegisterDir(arc::Dir &&_directory);
 
-    void InsertDummyDirInto(arc::Dir *_parent, std::string_view _dir_name);
+    bool InsertDummyDirInto(arc::Dir *_parent, std::string_view _dir_name);
     struct archive *SpawnLibarchive();
 
+    // Returns an opened independent copy of the archive file or a VFSError
+    std::expected<VFSFilePtr, int> SpawnArchiveFile();
+
     // Returns a VFSError
     int ResolvePath(std::string_view _path, std::pmr::string &_resolved_path);
 
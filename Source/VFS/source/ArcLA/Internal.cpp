@@ -1,6 +1,9 @@
-// Copyright (C) 2013-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Internal.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <limits>
 
 namespace nc::vfs::arc {
 
@@ -93,4 +96,92 @@ int State::Errno()
     return archive_errno(m_Archive);
 }
 
+static constexpr int64_t g_NanosecondsPerSecond = 1'000'000'000;
+
+int64_t ToNanoseconds(const timespec &_ts) noexcept
+{
+    // the times out of +-292 years from the epoch are clamped
+    constexpr int64_t max_sec = (std::numeric_limits<int64_t>::max() / g_NanosecondsPerSecond) - 1;
+    constexpr int64_t min_sec = (std::numeric_limits<int64_t>::min() / g_NanosecondsPerSecond) + 1;
+    const int64_t sec = std::clamp<int64_t>(_ts.tv_sec, min_sec, max_sec);
+    return (sec * g_NanosecondsPerSecond) + _ts.tv_nsec;
+}
+
+timespec ToTimespec(int64_t _ns) noexcept
+{
+    int64_t sec = _ns / g_NanosecondsPerSecond;
+    int64_t nsec = _ns % g_NanosecondsPerSecond;
+    if( nsec < 0 ) {
+        sec -= 1;
+        nsec += g_NanosecondsPerSecond;
+    }
+    return {.tv_sec = static_cast<time_t>(sec), .tv_nsec = static_cast<long>(nsec)};
+}
+
+time_t ToSeconds(int64_t _ns) noexcept
+{
+    return ToTimespec(_ns).tv_sec;
+}
+
+void DirEntry::SetStat(const struct stat &_st) noexcept
+{
+    mode = _st.st_mode;
+    uid = _st.st_uid;
+    gid = _st.st_gid;
+    flags = _st.st_flags;
+    size = _st.st_size;
+    atime = ToNanoseconds(_st.st_atimespec);
+    mtime = ToNanoseconds(_st.st_mtimespec);
+    ctime = ToNanoseconds(_st.st_ctimespec);
+    btime = ToNanoseconds(_st.st_birthtimespec);
+}
+
+struct stat DirEntry::Stat() const noexcept
+{
+    struct stat st;
+    std::memset(&st, 0, sizeof(st));
+    st.st_mode = mode;
+    st.st_uid = uid;
+    st.st_gid = gid;
+    st.st_flags = flags;
+    st.st_size = size;
+    st.st_atimespec = ToTimespec(atime);
+    st.st_mtimespec = ToTimespec(mtime);
+    st.st_ctimespec = ToTimespec(ctime);
+    st.st_birthtimespec = ToTimespec(btime);
+    return st;
+}
+
+bool NamesPool::Add(std::string_view _name, DirEntry &_entry)
+{
+    if( _name.length() > std::numeric_limits<uint16_t>::max() ||
+        m_Bytes.size() + _name.length() > std::numeric_limits<uint32_t>::max() )
+        return false;
+    _entry.name_offset = static_cast<uint32_t>(m_Bytes.size());
+    _entry.name_length = static_cast<uint16_t>(_name.length());
+    m_Bytes.insert(m_Bytes.end(), _name.begin(), _name.end());
+    return true;
+}
+
+std::string_view NamesPool::Get(const DirEntry &_entry) const noexcept
+{
+    assert(size_t(_entry.name_offset) + _entry.name_length <= m_Bytes.size());
+    return {m_Bytes.data() + _entry.name_offset, _entry.name_length};
+}
+
+std::span<const char> NamesPool::Bytes() const noexcept
+{
+    return m_Bytes;
+}
+
+void NamesPool::Assign(std::vector<char> _bytes) noexcept
+{
+    m_Bytes = std::move(_bytes);
+}
+
+void NamesPool::ShrinkToFit()
+{
+    m_Bytes.shrink_to_fit();
+}
+
 } // namespace nc::vfs::arc
@@ -1,10 +1,12 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <libarchive/archive.h>
 #include <libarchive/archive_entry.h>
 #include <VFS/VFSFile.h>
 #include <deque>
+#include <span>
+#include <string_view>
 
 namespace nc::vfs::arc {
 
@@ -59,17 +61,74 @@ private:
     char m_Buf[BufferSize];
 };
 
+// Only the stat fields used by VFS are kept, the times are nanoseconds since the epoch.
+// The name is stored in the NamesPool of the host.
 struct DirEntry {
-    std::string name;
-    struct stat st;
+    uint32_t name_offset = 0;
+    uint16_t name_length = 0;
+    mode_t mode = 0;
     uint32_t aruid = 0; // unique number inside archive in same order as appearance in archive
+    uid_t uid = 0;
+    gid_t gid = 0;
+    uint32_t flags = 0;
+    int64_t size = 0;
+    int64_t atime = 0;
+    int64_t mtime = 0;
+    int64_t ctime = 0;
+    int64_t btime = 0;
+
+    // Takes the kept fields from _st, the name is left intact
+    void SetStat(const struct stat &_st) noexcept;
+
+    // Builds a full stat, the fields which are not kept are zeroed
+    struct stat Stat() const noexcept;
 };
+static_assert(sizeof(DirEntry) == 64);
 
 struct Dir {
     std::string full_path;      // should alway be with trailing slash
     std::string name_in_parent; // can be "" only for root directory, full_path will be "/"
     uint64_t content_size = 0;
+    uint32_t index = 0; // position among the directories of the host, assigned when the directory is registered
     std::vector<DirEntry> entries;
 };
 
+// Names of all the entries of an archive stored back-to-back in a single buffer.
+class NamesPool
+{
+public:
+    // Sets the name of _entry, returns false if the pool can't address any more names
+    bool Add(std::string_view _name, DirEntry &_entry);
+
+    std::string_view Get(const DirEntry &_entry) const noexcept;
+
+    std::span<const char> Bytes() const noexcept;
+
+    // Replaces the pool with the bytes to which the entries already refer
+    void Assign(std::vector<char> _bytes) noexcept;
+
+    void ShrinkToFit();
+
+private:
+    std::vector<char> m_Bytes;
+};
+
+int64_t ToNanoseconds(const timespec &_ts) noexcept;
+timespec ToTimespec(int64_t _ns) noexcept;
+time_t ToSeconds(int64_t _ns) noexcept;
+
+// The location of an entry's data inside the archive file which allows reading it without libarchive.
+struct DirectEntry {
+    enum class Kind : uint8_t {
+        None = 0,        // has to be read via libarchive
+        Raw = 1,         // the data is stored as is at 'offset'
+        ZipStored = 2,   // 'offset' points to a Zip local header followed by the stored data
+        ZipDeflated = 3, // 'offset' points to a Zip local header followed by the deflated data
+    };
+    uint64_t offset = 0;
+    uint64_t compressed_size = 0; // meaningful only for Zip entries
+    uint32_t crc = 0;             // meaningful only for Zip entries
+    Kind kind = Kind::None;
+};
+
 } // namespace nc::vfs::arc
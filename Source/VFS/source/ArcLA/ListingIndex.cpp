@@ -0,0 +1,431 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "ListingIndex.h"
+#include <Base/Hash.h>
+#include <Base/algo.h>
+#include <Base/WriteAtomically.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace nc::vfs::arc {
+
+namespace {
+
+constexpr char g_Magic[8] = {'N', 'C', 'A', 'R', 'C', 'I', 'D', 'X'};
+constexpr uint32_t g_Version = 3;
+constexpr uint32_t g_FlagHasEncryptedEntries = 1;
+constexpr std::string_view g_Extension = ".ncarcidx";
+
+// All records are plain-old-data with sizes which are multiples of 8, so every table in the image stays aligned.
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t archive_size;
+    int64_t archive_mtime_sec;
+    int64_t archive_mtime_nsec;
+    uint64_t archive_inode;
+    uint32_t archive_path_offset;
+    uint32_t archive_path_length;
+    uint32_t total_files;
+    uint32_t total_dirs;
+    uint32_t total_regs;
+    uint32_t last_item_uid;
+    uint64_t archived_files_total_size;
+    uint32_t dirs_count;
+    uint32_t entries_count;
+    uint32_t symlinks_count;
+    uint32_t strings_size;
+    uint32_t direct_entries_count;
+    uint32_t reserved;
+};
+static_assert(sizeof(Header) == 104);
+
+struct DirRecord {
+    uint32_t full_path_offset;
+    uint32_t full_path_length;
+    uint32_t name_offset; // usually points into full_path
+    uint32_t name_length;
+    uint64_t content_size;
+    uint32_t first_entry;
+    uint32_t entries_count;
+};
+static_assert(sizeof(DirRecord) == 32);
+
+struct EntryRecord {
+    uint32_t name_offset;
+    uint32_t name_length;
+    uint32_t aruid;
+    uint32_t mode;
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t flags;
+    uint32_t reserved;
+    int64_t size;
+    int64_t atime;
+    int64_t mtime;
+    int64_t ctime;
+    int64_t btime;
+};
+static_assert(sizeof(EntryRecord) == 72);
+
+struct SymlinkRecord {
+    uint32_t uid;
+    uint32_t value_offset;
+    uint32_t value_length;
+    uint32_t invalid;
+};
+static_assert(sizeof(SymlinkRecord) == 16);
+
+struct DirectEntryRecord {
+    uint32_t uid;
+    uint32_t crc;
+    uint64_t offset;
+    uint64_t compressed_size;
+    uint8_t kind;
+    uint8_t reserved[7];
+};
+static_assert(sizeof(DirectEntryRecord) == 32);
+
+class StringsPool
+{
+public:
+    StringsPool(std::span<const char> _prefix) : m_Bytes(_prefix.begin(), _prefix.end()) {}
+    uint32_t Add(std::string_view _string)
+    {
+        const auto offset = static_cast<uint32_t>(m_Bytes.size());
+        m_Bytes.insert(m_Bytes.end(), _string.begin(), _string.end());
+        return offset;
+    }
+    const std::vector<char> &Bytes() const noexcept { return m_Bytes; }
+
+private:
+    std::vector<char> m_Bytes;
+};
+
+template <class T>
+void Append(std::vector<std::byte> &_image, const T &_record)
+{
+    const auto *const bytes = reinterpret_cast<const std::byte *>(&_record);
+    _image.insert(_image.end(), bytes, bytes + sizeof(T));
+}
+
+template <class T>
+void AppendAll(std::vector<std::byte> &_image, const std::vector<T> &_records)
+{
+    const auto *const bytes = reinterpret_cast<const std::byte *>(_records.data());
+    _image.insert(_image.end(), bytes, bytes + (_records.size() * sizeof(T)));
+}
+
+template <class T>
+T Read(const std::byte *_place) noexcept
+{
+    T record;
+    std::memcpy(&record, _place, sizeof(T));
+    return record;
+}
+
+EntryRecord ToRecord(const DirEntry &_entry) noexcept
+{
+    EntryRecord r = {};
+    r.name_offset = _entry.name_offset;
+    r.name_length = _entry.name_length;
+    r.aruid = _entry.aruid;
+    r.mode = _entry.mode;
+    r.uid = _entry.uid;
+    r.gid = _entry.gid;
+    r.flags = _entry.flags;
+    r.size = _entry.size;
+    r.atime = _entry.atime;
+    r.mtime = _entry.mtime;
+    r.ctime = _entry.ctime;
+    r.btime = _entry.btime;
+    return r;
+}
+
+DirEntry FromRecord(const EntryRecord &_record) noexcept
+{
+    DirEntry entry;
+    entry.name_offset = _record.name_offset;
+    entry.name_length = static_cast<uint16_t>(_record.name_length);
+    entry.aruid = _record.aruid;
+    entry.mode = static_cast<mode_t>(_record.mode);
+    entry.uid = _record.uid;
+    entry.gid = _record.gid;
+    entry.flags = _record.flags;
+    entry.size = _record.size;
+    entry.atime = _record.atime;
+    entry.mtime = _record.mtime;
+    entry.ctime = _record.ctime;
+    entry.btime = _record.btime;
+    return entry;
+}
+
+bool Matches(const Header &_header, const ListingIndexKey &_key, std::string_view _stored_path) noexcept
+{
+    return _header.archive_size == _key.size &&             //
+           _header.archive_mtime_sec == _key.mtime.tv_sec &&   //
+           _header.archive_mtime_nsec == _key.mtime.tv_nsec && //
+           _header.archive_inode == _key.inode &&              //
+           _stored_path == _key.path;
+}
+
+} // namespace
+
+std::vector<std::byte> ComposeListingIndex(const ListingIndexKey &_key,
+                                           const ListingIndexSummary &_summary,
+                                           std::span<const Dir *const> _directories,
+                                           const NamesPool &_names,
+                                           std::span<const ListingIndexSymlink> _symlinks,
+                                           std::span<const DirectEntry> _direct_entries)
+{
+    StringsPool strings(_names.Bytes());
+    std::vector<DirRecord> dirs;
+    std::vector<EntryRecord> entries;
+    std::vector<SymlinkRecord> symlinks;
+    std::vector<DirectEntryRecord> direct_entries;
+    dirs.reserve(_directories.size());
+    symlinks.reserve(_symlinks.size());
+
+    const uint32_t archive_path_offset = strings.Add(_key.path);
+
+    for( const Dir *const dir : _directories ) {
+        DirRecord r = {};
+        r.full_path_offset = strings.Add(dir->full_path);
+        r.full_path_length = static_cast<uint32_t>(dir->full_path.length());
+        r.name_length = static_cast<uint32_t>(dir->name_in_parent.length());
+        if( std::string_view{dir->full_path}.substr(0, dir->full_path.length() - 1).ends_with(dir->name_in_parent) )
+            r.name_offset = r.full_path_offset + r.full_path_length - r.name_length - 1; // "/a/b/" -> "b"
+        else
+            r.name_offset = strings.Add(dir->name_in_parent);
+        r.content_size = dir->content_size;
+        r.first_entry = static_cast<uint32_t>(entries.size());
+        r.entries_count = static_cast<uint32_t>(dir->entries.size());
+        dirs.emplace_back(r);
+        for( const DirEntry &entry : dir->entries )
+            entries.emplace_back(ToRecord(entry));
+    }
+
+    for( const ListingIndexSymlink &symlink : _symlinks ) {
+        SymlinkRecord r = {};
+        r.uid = symlink.uid;
+        r.value_offset = strings.Add(symlink.value);
+        r.value_length = static_cast<uint32_t>(symlink.value.length());
+        r.invalid = symlink.value.empty();
+        symlinks.emplace_back(r);
+    }
+
+    for( size_t uid = 0; uid < _direct_entries.size(); ++uid ) {
+        const DirectEntry &direct = _direct_entries[uid];
+        if( direct.kind == DirectEntry::Kind::None )
+            continue;
+        DirectEntryRecord r = {};
+        r.uid = static_cast<uint32_t>(uid);
+        r.crc = direct.crc;
+        r.offset = direct.offset;
+        r.compressed_size = direct.compressed_size;
+        r.kind = static_cast<uint8_t>(direct.kind);
+        direct_entries.emplace_back(r);
+    }
+
+    if( strings.Bytes().size() > std::numeric_limits<uint32_t>::max() )
+        return {};
+
+    Header header = {};
+    std::memcpy(header.magic, g_Magic, sizeof(g_Magic));
+    header.version = g_Version;
+    header.flags = _summary.has_encrypted_entries ? g_FlagHasEncryptedEntries : 0;
+    header.archive_size = _key.size;
+    header.archive_mtime_sec = _key.mtime.tv_sec;
+    header.archive_mtime_nsec = _key.mtime.tv_nsec;
+    header.archive_inode = _key.inode;
+    header.archive_path_offset = archive_path_offset;
+    header.archive_path_length = static_cast<uint32_t>(_key.path.length());
+    header.total_files = _summary.total_files;
+    header.total_dirs = _summary.total_dirs;
+    header.total_regs = _summary.total_regs;
+    header.last_item_uid = _summary.last_item_uid;
+    header.archived_files_total_size = _summary.archived_files_total_size;
+    header.dirs_count = static_cast<uint32_t>(dirs.size());
+    header.entries_count = static_cast<uint32_t>(entries.size());
+    header.symlinks_count = static_cast<uint32_t>(symlinks.size());
+    header.strings_size = static_cast<uint32_t>(strings.Bytes().size());
+    header.direct_entries_count = static_cast<uint32_t>(direct_entries.size());
+
+    std::vector<std::byte> image;
+    image.reserve(sizeof(Header) + (dirs.size() * sizeof(DirRecord)) + (entries.size() * sizeof(EntryRecord)) +
+                  (symlinks.size() * sizeof(SymlinkRecord)) + (direct_entries.size() * sizeof(DirectEntryRecord)) +
+                  strings.Bytes().size());
+    Append(image, header);
+    AppendAll(image, dirs);
+    AppendAll(image, entries);
+    AppendAll(image, symlinks);
+    AppendAll(image, direct_entries);
+    AppendAll(image, strings.Bytes());
+    return image;
+}
+
+std::optional<ListingIndex> ParseListingIndex(std::span<const std::byte> _image, const ListingIndexKey &_key)
+{
+    if( _image.size() < sizeof(Header) )
+        return std::nullopt;
+
+    const auto header = Read<Header>(_image.data());
+    if( std::memcmp(header.magic, g_Magic, sizeof(g_Magic)) != 0 || header.version != g_Version )
+        return std::nullopt;
+
+    const uint64_t dirs_offset = sizeof(Header);
+    const uint64_t entries_offset = dirs_offset + (uint64_t(header.dirs_count) * sizeof(DirRecord));
+    const uint64_t symlinks_offset = entries_offset + (uint64_t(header.entries_count) * sizeof(EntryRecord));
+    const uint64_t directs_offset = symlinks_offset + (uint64_t(header.symlinks_count) * sizeof(SymlinkRecord));
+    const uint64_t strings_offset =
+        directs_offset + (uint64_t(header.direct_entries_count) * sizeof(DirectEntryRecord));
+    if( strings_offset + header.strings_size != _image.size() )
+        return std::nullopt;
+
+    const char *const strings = reinterpret_cast<const char *>(_image.data() + strings_offset);
+    const auto string_at = [&](uint32_t _offset, uint32_t _length) -> std::optional<std::string_view> {
+        if( uint64_t(_offset) + _length > header.strings_size )
+            return std::nullopt;
+        return std::string_view{strings + _offset, _length};
+    };
+
+    const auto archive_path = string_at(header.archive_path_offset, header.archive_path_length);
+    if( !archive_path || !Matches(header, _key, *archive_path) )
+        return std::nullopt;
+
+    ListingIndex index;
+    index.summary.total_files = header.total_files;
+    index.summary.total_dirs = header.total_dirs;
+    index.summary.total_regs = header.total_regs;
+    index.summary.last_item_uid = header.last_item_uid;
+    index.summary.archived_files_total_size = header.archived_files_total_size;
+    index.summary.has_encrypted_entries = header.flags & g_FlagHasEncryptedEntries;
+
+    index.directories.reserve(header.dirs_count);
+    for( uint32_t i = 0; i < header.dirs_count; ++i ) {
+        const auto r = Read<DirRecord>(_image.data() + dirs_offset + (uint64_t(i) * sizeof(DirRecord)));
+        const auto full_path = string_at(r.full_path_offset, r.full_path_length);
+        const auto name = string_at(r.name_offset, r.name_length);
+        if( !full_path || !name || !full_path->starts_with('/') || !full_path->ends_with('/') ||
+            uint64_t(r.first_entry) + r.entries_count > header.entries_count )
+            return std::nullopt;
+
+        Dir &dir = index.directories.emplace_back();
+        dir.full_path = *full_path;
+        dir.name_in_parent = *name;
+        dir.content_size = r.content_size;
+        dir.entries.resize(r.entries_count);
+        for( uint32_t j = 0; j < r.entries_count; ++j ) {
+            const auto er = Read<EntryRecord>(_image.data() + entries_offset +
+                                              (uint64_t(r.first_entry + j) * sizeof(EntryRecord)));
+            const auto entry_name = string_at(er.name_offset, er.name_length);
+            if( !entry_name || entry_name->empty() || er.name_length > std::numeric_limits<uint16_t>::max() ||
+                (er.aruid != SyntheticArUID && uint64_t(er.aruid) > uint64_t(header.last_item_uid) + 1) )
+                return std::nullopt;
+            dir.entries[j] = FromRecord(er);
+        }
+    }
+
+    if( index.directories.empty() || index.directories.front().full_path != "/" )
+        return std::nullopt;
+
+    index.symlinks.reserve(header.symlinks_count);
+    for( uint32_t i = 0; i < header.symlinks_count; ++i ) {
+        const auto r = Read<SymlinkRecord>(_image.data() + symlinks_offset + (uint64_t(i) * sizeof(SymlinkRecord)));
+        const auto value = string_at(r.value_offset, r.value_length);
+        if( !value )
+            return std::nullopt;
+        index.symlinks.push_back({.uid = r.uid, .value = r.invalid ? std::string{} : std::string{*value}});
+    }
+
+    for( uint32_t i = 0; i < header.direct_entries_count; ++i ) {
+        const auto r =
+            Read<DirectEntryRecord>(_image.data() + directs_offset + (uint64_t(i) * sizeof(DirectEntryRecord)));
+        if( uint64_t(r.uid) > uint64_t(header.last_item_uid) + 1 || r.kind == 0 ||
+            r.kind > static_cast<uint8_t>(DirectEntry::Kind::ZipDeflated) )
+            return std::nullopt;
+        if( index.direct_entries.size() <= r.uid )
+            index.direct_entries.resize(r.uid + 1);
+        index.direct_entries[r.uid] = {.offset = r.offset,
+                                       .compressed_size = r.compressed_size,
+                                       .crc = r.crc,
+                                       .kind = static_cast<DirectEntry::Kind>(r.kind)};
+    }
+
+    // the entries refer to their names by offsets in the strings pool, so the pool is taken as it is
+    index.names.Assign(std::vector<char>(strings, strings + header.strings_size));
+
+    return index;
+}
+
+ListingIndexStorage::ListingIndexStorage(std::filesystem::path _directory, size_t _max_indices)
+    : m_Directory(std::move(_directory)), m_MaxIndices(std::max(_max_indices, size_t(1)))
+{
+}
+
+std::filesystem::path ListingIndexStorage::IndexPath(std::string_view _archive_path) const
+{
+    auto digest = base::Hash(base::Hash::XXH3_128).Feed(_archive_path.data(), _archive_path.size()).Final();
+    return m_Directory / (base::Hash::Hex(digest) + std::string(g_Extension));
+}
+
+std::optional<ListingIndex> ListingIndexStorage::Load(const ListingIndexKey &_key) const
+{
+    const int fd = open(IndexPath(_key.path).c_str(), O_RDONLY | O_CLOEXEC);
+    if( fd < 0 )
+        return std::nullopt;
+    const auto close_fd = at_scope_end([fd] { close(fd); });
+
+    struct stat st;
+    if( fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header)) )
+        return std::nullopt;
+
+    const size_t length = static_cast<size_t>(st.st_size);
+    void *const mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if( mapped == MAP_FAILED )
+        return std::nullopt;
+    const auto unmap = at_scope_end([mapped, length] { munmap(mapped, length); });
+
+    auto index = ParseListingIndex({static_cast<const std::byte *>(mapped), length}, _key);
+    if( index )
+        futimes(fd, nullptr); // mark as recently used for the eviction
+    return index;
+}
+
+bool ListingIndexStorage::Store(const ListingIndexKey &_key, std::span<const std::byte> _image) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_Directory, ec);
+    if( ec )
+        return false;
+
+    if( !base::WriteAtomically(IndexPath(_key.path), _image) )
+        return false;
+
+    Evict();
+    return true;
+}
+
+void ListingIndexStorage::Evict() const
+{
+    std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> indices;
+    std::error_code ec;
+    for( const auto &entry : std::filesystem::directory_iterator(m_Directory, ec) )
+        if( entry.path().extension() == g_Extension )
+            indices.emplace_back(entry.last_write_time(ec), entry.path());
+
+    if( indices.size() <= m_MaxIndices )
+        return;
+
+    std::ranges::sort(indices, [](auto &_lhs, auto &_rhs) { return _lhs.first < _rhs.first; });
+    for( size_t i = 0; i < indices.size() - m_MaxIndices; ++i )
+        std::filesystem::remove(indices[i].second, ec);
+}
+
+} // namespace nc::vfs::arc
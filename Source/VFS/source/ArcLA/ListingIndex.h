@@ -0,0 +1,81 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include "Internal.h"
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nc::vfs::arc {
+
+// Identifies a particular state of an archive file, an index is valid only while all of these are the same.
+struct ListingIndexKey {
+    std::string path;
+    uint64_t size = 0;
+    timespec mtime = {0, 0};
+    uint64_t inode = 0;
+};
+
+struct ListingIndexSummary {
+    uint32_t total_files = 0;
+    uint32_t total_dirs = 0;
+    uint32_t total_regs = 0;
+    uint32_t last_item_uid = 0;
+    uint64_t archived_files_total_size = 0;
+    bool has_encrypted_entries = false;
+};
+
+struct ListingIndexSymlink {
+    uint32_t uid = 0;
+    std::string value; // empty for invalid symlinks
+};
+
+// The listing of an archive restored from an index.
+struct ListingIndex {
+    ListingIndexSummary summary;
+    NamesPool names; // contains the names of the entries and possibly some other strings
+    std::vector<Dir> directories;
+    std::vector<ListingIndexSymlink> symlinks;
+    std::vector<DirectEntry> direct_entries; // indexed by uid, empty if the archive isn't directly accessible
+};
+
+// Serializes the listing into a flat binary image: a header followed by the tables of directories, entries,
+// symlinks and direct entries with fixed-size records and a pool of strings they refer to by offsets.
+// The pool starts with _names, so the entries' names keep their offsets.
+// Returns an empty vector if the listing is too large to be represented.
+std::vector<std::byte> ComposeListingIndex(const ListingIndexKey &_key,
+                                           const ListingIndexSummary &_summary,
+                                           std::span<const Dir *const> _directories,
+                                           const NamesPool &_names,
+                                           std::span<const ListingIndexSymlink> _symlinks,
+                                           std::span<const DirectEntry> _direct_entries = {});
+
+// Restores the listing from a binary image. Returns nothing if the image is malformed or doesn't match _key.
+std::optional<ListingIndex> ParseListingIndex(std::span<const std::byte> _image, const ListingIndexKey &_key);
+
+// Keeps the indices as files in a directory, one per archive path.
+// The least recently used ones are evicted once there are more than _max_indices of them.
+class ListingIndexStorage
+{
+public:
+    ListingIndexStorage(std::filesystem::path _directory, size_t _max_indices = 64);
+
+    // Maps the index file into memory and parses it. Returns nothing if there's no valid index for _key.
+    std::optional<ListingIndex> Load(const ListingIndexKey &_key) const;
+
+    bool Store(const ListingIndexKey &_key, std::span<const std::byte> _image) const;
+
+    std::filesystem::path IndexPath(std::string_view _archive_path) const;
+
+private:
+    void Evict() const;
+
+    std::filesystem::path m_Directory;
+    size_t m_MaxIndices;
+};
+
+} // namespace nc::vfs::arc
@@ -0,0 +1,84 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace nc::vfs {
+
+// A minimalistic host-endian binary format used to persist the directory listings between sessions.
+class BinaryWriter
+{
+public:
+    template <class T>
+    void Put(const T &_value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto bytes = reinterpret_cast<const std::byte *>(&_value);
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + sizeof(T));
+    }
+
+    void PutString(std::string_view _string)
+    {
+        Put(static_cast<uint32_t>(_string.size()));
+        const auto bytes = reinterpret_cast<const std::byte *>(_string.data());
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + _string.size());
+    }
+
+    const std::vector<std::byte> &Bytes() const noexcept { return m_Bytes; }
+
+private:
+    std::vector<std::byte> m_Bytes;
+};
+
+// Reads the values written by BinaryWriter, any read beyond the end turns it into the failed state.
+class BinaryReader
+{
+public:
+    BinaryReader(std::span<const std::byte> _bytes) : m_Bytes(_bytes) {}
+
+    template <class T>
+    T Get() noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if( !Ensure(sizeof(T)) )
+            return value;
+        std::memcpy(&value, m_Bytes.data() + m_Pos, sizeof(T));
+        m_Pos += sizeof(T);
+        return value;
+    }
+
+    std::string GetString()
+    {
+        const auto size = Get<uint32_t>();
+        if( !Ensure(size) )
+            return {};
+        std::string string(reinterpret_cast<const char *>(m_Bytes.data() + m_Pos), size);
+        m_Pos += size;
+        return string;
+    }
+
+    bool Ensure(size_t _size) noexcept
+    {
+        if( m_Failed || m_Bytes.size() - m_Pos < _size )
+            m_Failed = true;
+        return !m_Failed;
+    }
+
+    bool Failed() const noexcept { return m_Failed; }
+
+private:
+    std::span<const std::byte> m_Bytes;
+    size_t m_Pos = 0;
+    bool m_Failed = false;
+};
+
+
+} // namespace nc::vfs
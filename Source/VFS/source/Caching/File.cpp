@@ -0,0 +1,154 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "File.h"
+#include "Host.h"
+#include <type_traits>
+
+namespace nc::vfs::caching {
+
+File::File(std::string_view _relative_path, const std::shared_ptr<CachingHost> &_host, std::shared_ptr<VFSFile> _file)
+    : VFSFile(_relative_path, _host), m_File(std::move(_file))
+{
+}
+
+File::~File()
+{
+    if( m_OpenedForWriting && m_File->IsOpened() )
+        m_File->Close();
+    InvalidateIfWritten();
+}
+
+// Copies the last error of the wrapped file when the result signals a failure.
+template <class T>
+T File::Propagate(T _result) const
+{
+    bool failed = false;
+    if constexpr( std::is_arithmetic_v<T> )
+        failed = _result < 0;
+    else
+        failed = !_result.has_value();
+    if( failed )
+        if( const std::optional<nc::Error> error = m_File->LastError() )
+            SetLastError(*error);
+    return _result;
+}
+
+void File::InvalidateIfWritten()
+{
+    if( !m_OpenedForWriting )
+        return;
+    m_OpenedForWriting = false;
+    static_cast<CachingHost &>(*Host()).Invalidate(Path());
+}
+
+std::shared_ptr<VFSFile> File::Clone() const
+{
+    std::shared_ptr<VFSFile> clone = m_File->Clone();
+    if( !clone )
+        return nullptr;
+    return std::make_shared<File>(Path(), std::static_pointer_cast<CachingHost>(Host()), std::move(clone));
+}
+
+int File::Open(unsigned long _open_flags, const VFSCancelChecker &_cancel_checker)
+{
+    const int result = Propagate(m_File->Open(_open_flags, _cancel_checker));
+    if( _open_flags & VFSFlags::OF_Write ) {
+        // the item is likely to be created or truncated even if the opening has failed
+        m_OpenedForWriting = true;
+        static_cast<CachingHost &>(*Host()).Invalidate(Path());
+    }
+    return result;
+}
+
+bool File::IsOpened() const
+{
+    return m_File->IsOpened();
+}
+
+int File::Close()
+{
+    const int result = Propagate(m_File->Close());
+    InvalidateIfWritten();
+    return result;
+}
+
+int File::PreferredIOSize() const
+{
+    return m_File->PreferredIOSize();
+}
+
+VFSFile::ReadParadigm File::GetReadParadigm() const
+{
+    return m_File->GetReadParadigm();
+}
+
+VFSFile::WriteParadigm File::GetWriteParadigm() const
+{
+    return m_File->GetWriteParadigm();
+}
+
+ssize_t File::Read(void *_buf, size_t _size)
+{
+    return Propagate(m_File->Read(_buf, _size));
+}
+
+int File::SetUploadSize(size_t _size)
+{
+    return Propagate(m_File->SetUploadSize(_size));
+}
+
+ssize_t File::Write(const void *_buf, size_t _size)
+{
+    return Propagate(m_File->Write(_buf, _size));
+}
+
+int File::Flush()
+{
+    return Propagate(m_File->Flush());
+}
+
+std::expected<void, nc::Error> File::Skip(size_t _size)
+{
+    return Propagate(m_File->Skip(_size));
+}
+
+std::expected<size_t, nc::Error> File::ReadAt(off_t _pos, void *_buf, size_t _size)
+{
+    return Propagate(m_File->ReadAt(_pos, _buf, _size));
+}
+
+off_t File::Seek(off_t _off, int _basis)
+{
+    return Propagate(m_File->Seek(_off, _basis));
+}
+
+ssize_t File::Pos() const
+{
+    return m_File->Pos();
+}
+
+ssize_t File::Size() const
+{
+    return m_File->Size();
+}
+
+bool File::Eof() const
+{
+    return m_File->Eof();
+}
+
+unsigned File::XAttrCount() const
+{
+    return m_File->XAttrCount();
+}
+
+void File::XAttrIterateNames(const XAttrIterateNamesCallback &_handler) const
+{
+    m_File->XAttrIterateNames(_handler);
+}
+
+ssize_t File::XAttrGet(const char *_xattr_name, void *_buffer, size_t _buf_size) const
+{
+    return Propagate(m_File->XAttrGet(_xattr_name, _buffer, _buf_size));
+}
+
+} // namespace nc::vfs::caching
@@ -0,0 +1,52 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <VFS/VFSFile.h>
+
+namespace nc::vfs {
+
+class CachingHost;
+
+namespace caching {
+
+// Forwards everything to a file of the wrapped host while reporting the caching host as its own.
+// Closing a file opened for writing drops the cached entries of the file and of its directory.
+class File final : public VFSFile
+{
+public:
+    File(std::string_view _relative_path, const std::shared_ptr<CachingHost> &_host, std::shared_ptr<VFSFile> _file);
+    ~File();
+
+    std::shared_ptr<VFSFile> Clone() const override;
+    int Open(unsigned long _open_flags, const VFSCancelChecker &_cancel_checker = {}) override;
+    bool IsOpened() const override;
+    int Close() override;
+    int PreferredIOSize() const override;
+    ReadParadigm GetReadParadigm() const override;
+    WriteParadigm GetWriteParadigm() const override;
+    ssize_t Read(void *_buf, size_t _size) override;
+    int SetUploadSize(size_t _size) override;
+    ssize_t Write(const void *_buf, size_t _size) override;
+    int Flush() override;
+    std::expected<void, nc::Error> Skip(size_t _size) override;
+    std::expected<size_t, nc::Error> ReadAt(off_t _pos, void *_buf, size_t _size) override;
+    off_t Seek(off_t _off, int _basis) override;
+    ssize_t Pos() const override;
+    ssize_t Size() const override;
+    bool Eof() const override;
+    unsigned XAttrCount() const override;
+    void XAttrIterateNames(const XAttrIterateNamesCallback &_handler) const override;
+    ssize_t XAttrGet(const char *_xattr_name, void *_buffer, size_t _buf_size) const override;
+
+private:
+    template <class T>
+    T Propagate(T _result) const;
+    void InvalidateIfWritten();
+
+    const std::shared_ptr<VFSFile> m_File;
+    bool m_OpenedForWriting = false;
+};
+
+} // namespace caching
+
+} // namespace nc::vfs
@@ -0,0 +1,296 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Host.h"
+#include "File.h"
+#include "../ListingInput.h"
+#include <Utility/PathManip.h>
+
+namespace nc::vfs {
+
+CachingHost::CachingHost(const std::shared_ptr<Host> &_wrapped, std::chrono::nanoseconds _ttl)
+    : Host(_wrapped->JunctionPath(), _wrapped->Parent(), _wrapped->Tag()), m_Wrapped(_wrapped), m_Cache(_ttl)
+{
+    SetFeatures(_wrapped->Features());
+}
+
+CachingHost::~CachingHost() = default;
+
+const std::shared_ptr<Host> &CachingHost::Wrapped() const noexcept
+{
+    return m_Wrapped;
+}
+
+CachingHost::Statistics CachingHost::CacheStatistics() const noexcept
+{
+    return m_Cache.Stats();
+}
+
+void CachingHost::InvalidateCache()
+{
+    m_Cache.Clear();
+}
+
+void CachingHost::Invalidate(std::string_view _path)
+{
+    const std::string_view path = utility::PathManip::WithoutTrailingSlashes(_path);
+    m_Cache.Invalidate(path);
+    if( path != "/" )
+        m_Cache.Invalidate(utility::PathManip::Parent(path));
+}
+
+void CachingHost::InvalidateTree(std::string_view _path)
+{
+    const std::string_view path = utility::PathManip::WithoutTrailingSlashes(_path);
+    m_Cache.InvalidateTree(path);
+    if( path != "/" )
+        m_Cache.Invalidate(utility::PathManip::Parent(path));
+}
+
+// The items of the wrapped host's listings are moved over to this host.
+VFSListingPtr CachingHost::Rehosted(const VFSListingPtr &_listing)
+{
+    using nc::base::variable_container;
+    ListingInput input = Listing::Compose({_listing});
+    input.title = _listing->Title();
+    input.hosts.reset(variable_container<>::type::common);
+    input.hosts[0] = shared_from_this();
+    if( _listing->HasCommonDirectory() ) {
+        input.directories.reset(variable_container<>::type::common);
+        input.directories[0] = _listing->Directory();
+    }
+    return Listing::Build(std::move(input));
+}
+
+VFSConfiguration CachingHost::Configuration() const
+{
+    return m_Wrapped->Configuration();
+}
+
+bool CachingHost::IsNativeFS() const noexcept
+{
+    return m_Wrapped->IsNativeFS();
+}
+
+bool CachingHost::IsImmutableFS() const noexcept
+{
+    return m_Wrapped->IsImmutableFS();
+}
+
+bool CachingHost::IsWritable() const
+{
+    return m_Wrapped->IsWritable();
+}
+
+bool CachingHost::IsWritableAtPath(std::string_view _dir) const
+{
+    return m_Wrapped->IsWritableAtPath(_dir);
+}
+
+bool CachingHost::IsCaseSensitiveAtPath(std::string_view _dir) const
+{
+    return m_Wrapped->IsCaseSensitiveAtPath(_dir);
+}
+
+std::expected<VFSStat, Error>
+CachingHost::Stat(std::string_view _path, unsigned long _flags, const VFSCancelChecker &_cancel_checker)
+{
+    const bool follow = !(_flags & VFSFlags::F_NoFollow);
+    if( !(_flags & VFSFlags::F_ForceRefresh) )
+        if( std::optional<std::expected<VFSStat, Error>> cached = m_Cache.Find(_path, follow) )
+            return *std::move(cached);
+
+    std::expected<VFSStat, Error> st = m_Wrapped->Stat(_path, _flags, _cancel_checker);
+    m_Cache.Insert(_path, follow, st);
+    return st;
+}
+
+std::expected<VFSStatFS, Error> CachingHost::StatFS(std::string_view _path, const VFSCancelChecker &_cancel_checker)
+{
+    return m_Wrapped->StatFS(_path, _cancel_checker);
+}
+
+std::expected<std::string, Error> CachingHost::ReadSymlink(std::string_view _symlink_path,
+                                                           const VFSCancelChecker &_cancel_checker)
+{
+    return m_Wrapped->ReadSymlink(_symlink_path, _cancel_checker);
+}
+
+bool CachingHost::ValidateFilename(std::string_view _filename) const
+{
+    return m_Wrapped->ValidateFilename(_filename);
+}
+
+std::expected<uint64_t, Error> CachingHost::CalculateDirectorySize(std::string_view _path,
+                                                                   const VFSCancelChecker &_cancel_checker)
+{
+    return m_Wrapped->CalculateDirectorySize(_path, _cancel_checker);
+}
+
+bool CachingHost::ShouldProduceThumbnails() const
+{
+    return m_Wrapped->ShouldProduceThumbnails();
+}
+
+std::expected<std::vector<VFSUser>, Error> CachingHost::FetchUsers(const VFSCancelChecker &_cancel_checker)
+{
+    return m_Wrapped->FetchUsers(_cancel_checker);
+}
+
+std::expected<std::vector<VFSGroup>, Error> CachingHost::FetchGroups(const VFSCancelChecker &_cancel_checker)
+{
+    return m_Wrapped->FetchGroups(_cancel_checker);
+}
+
+std::expected<VFSListingPtr, Error> CachingHost::FetchDirectoryListing(std::string_view _path,
+                                                                       unsigned long _flags,
+                                                                       const VFSCancelChecker &_cancel_checker)
+{
+    if( _flags & VFSFlags::F_ForceRefresh )
+        m_Cache.InvalidateTree(_path);
+    const std::expected<VFSListingPtr, Error> listing =
+        m_Wrapped->FetchDirectoryListing(_path, _flags, _cancel_checker);
+    if( !listing )
+        return listing;
+    return Rehosted(*listing);
+}
+
+std::expected<VFSListingPtr, Error> CachingHost::FetchSingleItemListing(std::string_view _path_to_item,
+                                                                        unsigned long _flags,
+                                                                        const VFSCancelChecker &_cancel_checker)
+{
+    if( _flags & VFSFlags::F_ForceRefresh )
+        m_Cache.Invalidate(_path_to_item);
+    const std::expected<VFSListingPtr, Error> listing =
+        m_Wrapped->FetchSingleItemListing(_path_to_item, _flags, _cancel_checker);
+    if( !listing )
+        return listing;
+    return Rehosted(*listing);
+}
+
+std::expected<void, Error>
+CachingHost::IterateDirectoryListing(std::string_view _path,
+                                     const std::function<bool(const VFSDirEnt &_dirent)> &_handler)
+{
+    return m_Wrapped->IterateDirectoryListing(_path, _handler);
+}
+
+std::expected<std::shared_ptr<VFSFile>, Error> CachingHost::CreateFile(std::string_view _path,
+                                                                       const VFSCancelChecker &_cancel_checker)
+{
+    const std::expected<std::shared_ptr<VFSFile>, Error> file = m_Wrapped->CreateFile(_path, _cancel_checker);
+    if( !file )
+        return file;
+    return std::make_shared<caching::File>(
+        (*file)->Path(), std::static_pointer_cast<CachingHost>(shared_from_this()), *file);
+}
+
+std::expected<void, Error>
+CachingHost::CreateDirectory(std::string_view _path, int _mode, const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->CreateDirectory(_path, _mode, _cancel_checker);
+    Invalidate(_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::CreateSymlink(std::string_view _symlink_path,
+                                                      std::string_view _symlink_value,
+                                                      const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->CreateSymlink(_symlink_path, _symlink_value, _cancel_checker);
+    Invalidate(_symlink_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::Unlink(std::string_view _path, const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->Unlink(_path, _cancel_checker);
+    Invalidate(_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::RemoveDirectory(std::string_view _path,
+                                                        const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->RemoveDirectory(_path, _cancel_checker);
+    InvalidateTree(_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::Trash(std::string_view _path, const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->Trash(_path, _cancel_checker);
+    InvalidateTree(_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::Rename(std::string_view _old_path,
+                                               std::string_view _new_path,
+                                               const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->Rename(_old_path, _new_path, _cancel_checker);
+    InvalidateTree(_old_path);
+    InvalidateTree(_new_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::SetTimes(std::string_view _path,
+                                                 std::optional<time_t> _birth_time,
+                                                 std::optional<time_t> _mod_time,
+                                                 std::optional<time_t> _chg_time,
+                                                 std::optional<time_t> _acc_time,
+                                                 const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->SetTimes(_path, _birth_time, _mod_time, _chg_time, _acc_time, _cancel_checker);
+    m_Cache.Invalidate(_path);
+    return result;
+}
+
+std::expected<void, Error>
+CachingHost::SetPermissions(std::string_view _path, uint16_t _mode, const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->SetPermissions(_path, _mode, _cancel_checker);
+    m_Cache.Invalidate(_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::SetFlags(std::string_view _path,
+                                                 uint32_t _flags,
+                                                 uint64_t _vfs_options,
+                                                 const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->SetFlags(_path, _flags, _vfs_options, _cancel_checker);
+    m_Cache.Invalidate(_path);
+    return result;
+}
+
+std::expected<void, Error> CachingHost::SetOwnership(std::string_view _path,
+                                                     unsigned _uid,
+                                                     unsigned _gid,
+                                                     const VFSCancelChecker &_cancel_checker)
+{
+    auto result = m_Wrapped->SetOwnership(_path, _uid, _gid, _cancel_checker);
+    m_Cache.Invalidate(_path);
+    return result;
+}
+
+bool CachingHost::IsDirectoryChangeObservationAvailable(std::string_view _path)
+{
+    return m_Wrapped->IsDirectoryChangeObservationAvailable(_path);
+}
+
+HostDirObservationTicket CachingHost::ObserveDirectoryChanges(std::string_view _path, std::function<void()> _handler)
+{
+    // the ticket refers to the wrapped host, which stops the observation on its own
+    auto handler = [weak_this = weak_from_this(), path = std::string(_path), handler = std::move(_handler)] {
+        if( auto me = std::static_pointer_cast<CachingHost>(weak_this.lock()) )
+            me->m_Cache.InvalidateTree(path);
+        handler();
+    };
+    return m_Wrapped->ObserveDirectoryChanges(_path, std::move(handler));
+}
+
+FileObservationToken CachingHost::ObserveFileChanges(std::string_view _path, std::function<void()> _handler)
+{
+    return m_Wrapped->ObserveFileChanges(_path, std::move(_handler));
+}
+
+} // namespace nc::vfs
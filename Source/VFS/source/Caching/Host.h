@@ -0,0 +1,135 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <VFS/Host.h>
+#include "StatCache.h"
+
+namespace nc::vfs {
+
+// Decorates another host with a cache of Stat() results, so repeated Stat(), Exists(), IsDirectory() and IsSymlink()
+// calls for the same paths don't reach a slow backend, e.g. a network or an archive one.
+// Mutating operations performed through this host, including writes via the files it produced, invalidate the affected
+// entries, while changes made by other means are picked up once the entries expire.
+// The decorator mimics the tag, the junction path, the parent and the configuration of the wrapped host. The listings
+// and the files it produces refer to the decorator, so the operations performed on them go through the cache as well.
+class CachingHost final : public Host
+{
+public:
+    using Statistics = caching::StatCache::Statistics;
+    static constexpr std::chrono::seconds DefaultTTL{5};
+
+    CachingHost(const std::shared_ptr<Host> &_wrapped, std::chrono::nanoseconds _ttl = DefaultTTL);
+    ~CachingHost();
+
+    const std::shared_ptr<Host> &Wrapped() const noexcept;
+
+    Statistics CacheStatistics() const noexcept;
+
+    // Drops all cached entries.
+    void InvalidateCache();
+
+    // Drops the entries of the item and of its parent directory, which is affected by any change inside it.
+    void Invalidate(std::string_view _path);
+
+    VFSConfiguration Configuration() const override;
+
+    bool IsNativeFS() const noexcept override;
+
+    bool IsImmutableFS() const noexcept override;
+
+    bool IsWritable() const override;
+
+    bool IsWritableAtPath(std::string_view _dir) const override;
+
+    bool IsCaseSensitiveAtPath(std::string_view _dir = "/") const override;
+
+    // VFSFlags::F_ForceRefresh bypasses the cache and refreshes the entry.
+    std::expected<VFSStat, Error>
+    Stat(std::string_view _path, unsigned long _flags, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<VFSStatFS, Error> StatFS(std::string_view _path,
+                                           const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<std::string, Error> ReadSymlink(std::string_view _symlink_path,
+                                                  const VFSCancelChecker &_cancel_checker = {}) override;
+
+    bool ValidateFilename(std::string_view _filename) const override;
+
+    std::expected<uint64_t, Error> CalculateDirectorySize(std::string_view _path,
+                                                          const VFSCancelChecker &_cancel_checker = {}) override;
+
+    bool ShouldProduceThumbnails() const override;
+
+    std::expected<std::vector<VFSUser>, Error> FetchUsers(const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<std::vector<VFSGroup>, Error> FetchGroups(const VFSCancelChecker &_cancel_checker = {}) override;
+
+    // VFSFlags::F_ForceRefresh also drops the cached entries of the directory's contents.
+    std::expected<VFSListingPtr, Error> FetchDirectoryListing(std::string_view _path,
+                                                              unsigned long _flags,
+                                                              const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<VFSListingPtr, Error> FetchSingleItemListing(std::string_view _path_to_item,
+                                                               unsigned long _flags,
+                                                               const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error>
+    IterateDirectoryListing(std::string_view _path,
+                            const std::function<bool(const VFSDirEnt &_dirent)> &_handler) override;
+
+    std::expected<std::shared_ptr<VFSFile>, Error> CreateFile(std::string_view _path,
+                                                              const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error>
+    CreateDirectory(std::string_view _path, int _mode, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> CreateSymlink(std::string_view _symlink_path,
+                                             std::string_view _symlink_value,
+                                             const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> Unlink(std::string_view _path, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> RemoveDirectory(std::string_view _path,
+                                               const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> Trash(std::string_view _path, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> Rename(std::string_view _old_path,
+                                      std::string_view _new_path,
+                                      const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> SetTimes(std::string_view _path,
+                                        std::optional<time_t> _birth_time,
+                                        std::optional<time_t> _mod_time,
+                                        std::optional<time_t> _chg_time,
+                                        std::optional<time_t> _acc_time,
+                                        const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error>
+    SetPermissions(std::string_view _path, uint16_t _mode, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> SetFlags(std::string_view _path,
+                                        uint32_t _flags,
+                                        uint64_t _vfs_options,
+                                        const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> SetOwnership(std::string_view _path,
+                                            unsigned _uid,
+                                            unsigned _gid,
+                                            const VFSCancelChecker &_cancel_checker = {}) override;
+
+    bool IsDirectoryChangeObservationAvailable(std::string_view _path) override;
+
+    HostDirObservationTicket ObserveDirectoryChanges(std::string_view _path, std::function<void()> _handler) override;
+
+    FileObservationToken ObserveFileChanges(std::string_view _path, std::function<void()> _handler) override;
+
+private:
+    void InvalidateTree(std::string_view _path);
+    VFSListingPtr Rehosted(const VFSListingPtr &_listing);
+
+    const std::shared_ptr<Host> m_Wrapped;
+    caching::StatCache m_Cache;
+};
+
+} // namespace nc::vfs
@@ -0,0 +1,116 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "StatCache.h"
+#include <VFS/VFSError.h>
+#include <Base/mach_time.h>
+#include <Utility/PathManip.h>
+#include <cerrno>
+
+namespace nc::vfs::caching {
+
+StatCache::StatCache(std::chrono::nanoseconds _ttl) noexcept : m_TTL(_ttl)
+{
+}
+
+std::string_view StatCache::Normalize(std::string_view _path) noexcept
+{
+    // "/dir/" and "/dir" refer to the same item
+    return utility::PathManip::WithoutTrailingSlashes(_path);
+}
+
+StatCache::Shard &StatCache::ShardFor(std::string_view _normalized_path) noexcept
+{
+    return m_Shards[std::hash<std::string_view>{}(_normalized_path) % ShardsNumber];
+}
+
+std::optional<std::expected<VFSStat, Error>> StatCache::Find(std::string_view _path, bool _follow_symlinks)
+{
+    const std::string path{Normalize(_path)};
+    Shard &shard = ShardFor(path);
+    {
+        const std::lock_guard lock{shard.lock};
+        if( Entry *const entry = shard.entries.find(path) ) {
+            std::optional<Slot> &slot = _follow_symlinks ? entry->followed : entry->not_followed;
+            if( slot && slot->expires > base::machtime() ) {
+                ++m_Hits;
+                if( !slot->stat )
+                    ++m_NegativeHits;
+                return slot->stat;
+            }
+            slot.reset();
+            if( !entry->followed && !entry->not_followed )
+                shard.entries.erase(path);
+        }
+    }
+    ++m_Misses;
+    return std::nullopt;
+}
+
+void StatCache::Insert(std::string_view _path, bool _follow_symlinks, const std::expected<VFSStat, Error> &_stat)
+{
+    if( !_stat && !IsNotFound(_stat.error()) )
+        return;
+
+    const std::string path{Normalize(_path)};
+    Shard &shard = ShardFor(path);
+    const std::lock_guard lock{shard.lock};
+    Entry &entry = shard.entries[path];
+    (_follow_symlinks ? entry.followed : entry.not_followed) = Slot{base::machtime() + m_TTL, _stat};
+}
+
+void StatCache::Invalidate(std::string_view _path)
+{
+    const std::string path{Normalize(_path)};
+    Shard &shard = ShardFor(path);
+    const std::lock_guard lock{shard.lock};
+    m_Invalidations += shard.entries.erase(path);
+}
+
+void StatCache::InvalidateTree(std::string_view _path)
+{
+    const std::string_view root = Normalize(_path);
+    if( root == "/" ) {
+        Clear();
+        return;
+    }
+
+    const auto inside = [root](const std::string &_path, const Entry &) {
+        return _path.starts_with(root) && (_path.size() == root.size() || _path[root.size()] == '/');
+    };
+    // the descendants can reside in any shard
+    for( Shard &shard : m_Shards ) {
+        const std::lock_guard lock{shard.lock};
+        m_Invalidations += shard.entries.erase_if(inside);
+    }
+}
+
+void StatCache::Clear()
+{
+    for( Shard &shard : m_Shards ) {
+        const std::lock_guard lock{shard.lock};
+        m_Invalidations += shard.entries.size();
+        shard.entries.clear();
+    }
+}
+
+StatCache::Statistics StatCache::Stats() const noexcept
+{
+    Statistics stats;
+    stats.hits = m_Hits;
+    stats.negative_hits = m_NegativeHits;
+    stats.misses = m_Misses;
+    stats.invalidations = m_Invalidations;
+    return stats;
+}
+
+bool StatCache::IsNotFound(const Error &_error) noexcept
+{
+    const std::string domain = _error.Domain();
+    const int64_t code = _error.Code();
+    if( domain == Error::POSIX )
+        return code == ENOENT || code == ENOTDIR;
+    if( domain == VFSError::ErrorDomain )
+        return code == VFSError::NotFound || code == VFSError::NetSFTPNoSuchFile || code == VFSError::NetSFTPNoSuchPath;
+    return false;
+}
+
+} // namespace nc::vfs::caching
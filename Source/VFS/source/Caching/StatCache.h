@@ -0,0 +1,81 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <VFS/VFSDeclarations.h>
+#include <Base/Error.h>
+#include <Base/LRUCache.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <expected>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace nc::vfs::caching {
+
+// A bounded LRU cache of Stat() results, including the ones saying that there's no such item.
+// The entries are spread over independently locked shards and expire after a fixed time-to-live.
+// All methods are thread-safe.
+class StatCache
+{
+public:
+    static constexpr size_t ShardsNumber = 16;
+    static constexpr size_t ShardCapacity = 1024;
+
+    struct Statistics {
+        uint64_t hits = 0;
+        uint64_t negative_hits = 0; // a subset of hits
+        uint64_t misses = 0;
+        uint64_t invalidations = 0;
+    };
+
+    explicit StatCache(std::chrono::nanoseconds _ttl) noexcept;
+
+    // Returns a cached result which hasn't expired yet, if any.
+    std::optional<std::expected<VFSStat, Error>> Find(std::string_view _path, bool _follow_symlinks);
+
+    // Stores a successful result or an error saying that there's no such item, other errors aren't cached.
+    void Insert(std::string_view _path, bool _follow_symlinks, const std::expected<VFSStat, Error> &_stat);
+
+    // Removes the entries of the item.
+    void Invalidate(std::string_view _path);
+
+    // Removes the entries of the item and of everything inside it.
+    void InvalidateTree(std::string_view _path);
+
+    // Removes everything.
+    void Clear();
+
+    Statistics Stats() const noexcept;
+
+    // Tells if the error means that there's no item at the path.
+    static bool IsNotFound(const Error &_error) noexcept;
+
+private:
+    struct Slot {
+        std::chrono::nanoseconds expires;
+        std::expected<VFSStat, Error> stat;
+    };
+    struct Entry {
+        std::optional<Slot> followed;
+        std::optional<Slot> not_followed;
+    };
+    struct alignas(64) Shard {
+        std::mutex lock;
+        base::LRUCache<std::string, Entry, ShardCapacity> entries;
+    };
+
+    static std::string_view Normalize(std::string_view _path) noexcept;
+    Shard &ShardFor(std::string_view _normalized_path) noexcept;
+
+    const std::chrono::nanoseconds m_TTL;
+    std::array<Shard, ShardsNumber> m_Shards;
+    std::atomic_uint64_t m_Hits = 0;
+    std::atomic_uint64_t m_NegativeHits = 0;
+    std::atomic_uint64_t m_Misses = 0;
+    std::atomic_uint64_t m_Invalidations = 0;
+};
+
+} // namespace nc::vfs::caching
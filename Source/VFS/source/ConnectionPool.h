@@ -0,0 +1,461 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace nc::vfs {
+
+// Counters describing how a ConnectionPool has served its clients.
+struct ConnectionPoolMetrics {
+    static constexpr std::array<std::chrono::microseconds, 5> LatencyBounds = {
+        std::chrono::microseconds{100},
+        std::chrono::milliseconds{1},
+        std::chrono::milliseconds{10},
+        std::chrono::milliseconds{100},
+        std::chrono::seconds{1}};
+
+    uint64_t acquires = 0;   // connections handed out
+    uint64_t reuses = 0;     // ...out of which were idle connections
+    uint64_t connects = 0;   // connections spawned
+    uint64_t reconnects = 0; // ...out of which replaced the stale ones
+    uint64_t waits = 0;      // acquisitions which had to wait for a connection to be returned
+    uint64_t evictions = 0;  // idle connections closed after being unused for too long or due to the capacity
+    uint64_t pings = 0;      // keep-alive pings of the idle connections
+    uint64_t stale = 0;      // connections found dead by a health check, a ping or a failed request
+
+    // acquire_latency[i] counts the acquisitions which took less than LatencyBounds[i] but not less than the previous
+    // bound, the last element counts the slower ones.
+    std::array<uint64_t, LatencyBounds.size() + 1> acquire_latency = {};
+};
+
+// Keeps the idle connections to a server for reuse and spawns new ones when needed. Limits the number of connections
+// serving short requests, closes the ones left unused for too long, can check them before reuse and ping them to keep
+// them alive on the server side. Can be used from several threads at once.
+template <typename T>
+class ConnectionPool
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        // Limit of the leased connections and idle ones together, acquisitions beyond it wait for a connection to
+        // return. The connections released from leases for long transfers don't count, so they never hold up short
+        // requests.
+        size_t max_connections = 8;
+
+        // Once waited for this long, an acquisition spawns a connection over the limit, which rules out deadlocks.
+        std::chrono::milliseconds max_wait = std::chrono::seconds{5};
+
+        // Idle connections unused for this long are closed.
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds{60};
+
+        // Idle connections without any activity for this long are probed before being handed out, 0 disables.
+        std::chrono::milliseconds check_after = std::chrono::milliseconds{0};
+
+        // Idle connections are probed this often in background to keep them alive, 0 disables.
+        std::chrono::milliseconds ping_interval = std::chrono::milliseconds{0};
+    };
+
+    // Adapts the pool to a particular kind of connections.
+    struct Traits {
+        std::function<std::unique_ptr<T>()> spawn; // must return a valid connection or throw
+        std::function<void(T &)> recycle;          // optional, resets a returned connection to a pristine state
+        std::function<bool(T &)> probe;            // optional, tells whether a connection is still alive
+    };
+
+    // Hands a connection back to the pool upon destruction.
+    class Lease
+    {
+    public:
+        Lease() noexcept = default;
+        Lease(Lease &&_rhs) noexcept;
+        Lease &operator=(Lease &&_rhs) noexcept;
+        ~Lease();
+
+        T &operator*() const noexcept { return *m_Connection; }
+        T *operator->() const noexcept { return m_Connection.get(); }
+        explicit operator bool() const noexcept { return m_Connection != nullptr; }
+
+        // Tells whether the connection was idle in the pool before, as opposed to being freshly spawned.
+        bool Reused() const noexcept { return m_Reused; }
+
+        // Takes the connection out of the pool and of its limit, it must be given back via ConnectionPool::Return() or
+        // Discard() later.
+        std::unique_ptr<T> Release() noexcept;
+
+        // Closes the connection instead of returning it, e.g. after a failure.
+        void Discard() noexcept;
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *_pool, std::unique_ptr<T> _connection, bool _reused) noexcept;
+        ConnectionPool *m_Pool = nullptr;
+        std::unique_ptr<T> m_Connection;
+        bool m_Reused = false;
+    };
+
+    ConnectionPool(Options _options, Traits _traits);
+    ~ConnectionPool();
+
+    // Hands out an idle connection, preferring the most recently used one which satisfies _preferred if provided, or
+    // spawns a new one.
+    Lease Acquire(const std::function<bool(const T &)> &_preferred = {});
+
+    // Takes back a connection released from a lease, closes it instead if the pool is at its limit.
+    void Return(std::unique_ptr<T> _connection);
+
+    // Closes a connection released from a lease.
+    void Discard(std::unique_ptr<T> _connection) noexcept;
+
+    // Performs _request over a pooled connection. If the connection was reused and _is_stale recognizes the result as
+    // a failure caused by a connection which silently died, performs the request once more over a fresh connection.
+    // Only suitable for idempotent requests.
+    template <typename Request, typename IsStale>
+    std::invoke_result_t<Request &, T &> Run(Request &&_request, IsStale &&_is_stale);
+
+    ConnectionPoolMetrics Metrics() const;
+
+    size_t IdleCount() const;
+
+private:
+    struct Idle {
+        std::unique_ptr<T> connection;
+        Clock::time_point returned;  // when it was returned to the pool
+        Clock::time_point contacted; // when it communicated with the server last time
+    };
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    void operator=(const ConnectionPool &) = delete;
+    Lease Spawn(std::unique_lock<std::mutex> &_lock, bool _replacing, Clock::time_point _started);
+    void Put(std::unique_ptr<T> _connection, bool _counted);
+    void Detach() noexcept;
+    void Drop(std::unique_ptr<T> _connection, bool _stale) noexcept;
+    void RecordLatency(Clock::time_point _started) noexcept;
+    std::vector<std::unique_ptr<T>> TakeExpired(Clock::time_point _now);
+    void KeepAlive();
+
+    const Options m_Options;
+    const Traits m_Traits;
+    mutable std::mutex m_Lock;
+    std::condition_variable m_Returned;
+    std::condition_variable m_Stopped;
+    std::vector<Idle> m_Idle; // the most recently returned ones are at the back
+    size_t m_Total = 0;       // connections leased and idle together, the released ones are not counted
+    ConnectionPoolMetrics m_Metrics;
+    bool m_Stop = false;
+    std::thread m_Pinger;
+};
+
+template <typename T>
+ConnectionPool<T>::Lease::Lease(ConnectionPool *_pool, std::unique_ptr<T> _connection, bool _reused) noexcept
+    : m_Pool(_pool), m_Connection(std::move(_connection)), m_Reused(_reused)
+{
+}
+
+template <typename T>
+ConnectionPool<T>::Lease::Lease(Lease &&_rhs) noexcept
+    : m_Pool(_rhs.m_Pool), m_Connection(std::move(_rhs.m_Connection)), m_Reused(_rhs.m_Reused)
+{
+}
+
+template <typename T>
+typename ConnectionPool<T>::Lease &ConnectionPool<T>::Lease::operator=(Lease &&_rhs) noexcept
+{
+    if( this != &_rhs ) {
+        if( m_Connection )
+            m_Pool->Put(std::move(m_Connection), true);
+        m_Pool = _rhs.m_Pool;
+        m_Connection = std::move(_rhs.m_Connection);
+        m_Reused = _rhs.m_Reused;
+    }
+    return *this;
+}
+
+template <typename T>
+ConnectionPool<T>::Lease::~Lease()
+{
+    if( m_Connection )
+        m_Pool->Put(std::move(m_Connection), true);
+}
+
+template <typename T>
+std::unique_ptr<T> ConnectionPool<T>::Lease::Release() noexcept
+{
+    if( m_Connection )
+        m_Pool->Detach();
+    return std::move(m_Connection);
+}
+
+template <typename T>
+void ConnectionPool<T>::Lease::Discard() noexcept
+{
+    if( m_Connection )
+        m_Pool->Drop(std::move(m_Connection), false);
+}
+
+template <typename T>
+ConnectionPool<T>::ConnectionPool(Options _options, Traits _traits)
+    : m_Options(_options), m_Traits(std::move(_traits))
+{
+    if( m_Options.ping_interval.count() > 0 && m_Traits.probe )
+        m_Pinger = std::thread([this] { KeepAlive(); });
+}
+
+template <typename T>
+ConnectionPool<T>::~ConnectionPool()
+{
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        m_Stop = true;
+    }
+    m_Stopped.notify_all();
+    if( m_Pinger.joinable() )
+        m_Pinger.join();
+}
+
+template <typename T>
+typename ConnectionPool<T>::Lease ConnectionPool<T>::Acquire(const std::function<bool(const T &)> &_preferred)
+{
+    const auto started = Clock::now();
+    auto lock = std::unique_lock{m_Lock};
+    ++m_Metrics.acquires;
+
+    if( auto expired = TakeExpired(started); !expired.empty() ) {
+        lock.unlock();
+        expired.clear();
+        lock.lock();
+    }
+
+    bool replacing = false;
+    bool waiting = false;
+    bool waited = false;
+    while( true ) {
+        if( !m_Idle.empty() ) {
+            auto it = std::prev(m_Idle.end());
+            if( _preferred ) {
+                const auto preferred = std::find_if(
+                    m_Idle.rbegin(), m_Idle.rend(), [&](const Idle &_idle) { return _preferred(*_idle.connection); });
+                if( preferred != m_Idle.rend() )
+                    it = std::prev(preferred.base());
+            }
+            Idle idle = std::move(*it);
+            m_Idle.erase(it);
+
+            const bool check = m_Traits.probe && m_Options.check_after.count() > 0 &&
+                               Clock::now() - idle.contacted >= m_Options.check_after;
+            if( check ) {
+                lock.unlock();
+                const bool alive = m_Traits.probe(*idle.connection);
+                if( !alive )
+                    idle.connection.reset();
+                lock.lock();
+                if( !alive ) {
+                    --m_Total;
+                    ++m_Metrics.stale;
+                    replacing = true;
+                    continue;
+                }
+            }
+            ++m_Metrics.reuses;
+            lock.unlock();
+            RecordLatency(started);
+            return Lease{this, std::move(idle.connection), true};
+        }
+
+        if( m_Total < m_Options.max_connections || waited )
+            return Spawn(lock, replacing, started);
+
+        if( !std::exchange(waiting, true) )
+            ++m_Metrics.waits;
+        waited = m_Returned.wait_until(lock, started + m_Options.max_wait) == std::cv_status::timeout;
+    }
+}
+
+template <typename T>
+typename ConnectionPool<T>::Lease
+ConnectionPool<T>::Spawn(std::unique_lock<std::mutex> &_lock, bool _replacing, Clock::time_point _started)
+{
+    ++m_Total;
+    ++m_Metrics.connects;
+    if( _replacing )
+        ++m_Metrics.reconnects;
+    _lock.unlock();
+
+    std::unique_ptr<T> connection;
+    try {
+        connection = m_Traits.spawn();
+    } catch( ... ) {
+        Drop(nullptr, false);
+        throw;
+    }
+    RecordLatency(_started);
+    return Lease{this, std::move(connection), false};
+}
+
+template <typename T>
+void ConnectionPool<T>::Return(std::unique_ptr<T> _connection)
+{
+    if( _connection )
+        Put(std::move(_connection), false);
+}
+
+template <typename T>
+void ConnectionPool<T>::Put(std::unique_ptr<T> _connection, bool _counted)
+{
+    if( m_Traits.recycle )
+        m_Traits.recycle(*_connection);
+
+    const auto now = Clock::now();
+    auto lock = std::unique_lock{m_Lock};
+    if( !_counted )
+        ++m_Total; // a released connection rejoins the limit
+    if( m_Total > m_Options.max_connections ) {
+        // this one was spawned over the limit or released while the others filled the pool
+        --m_Total;
+        ++m_Metrics.evictions;
+        lock.unlock();
+        m_Returned.notify_one();
+        return;
+    }
+    m_Idle.push_back(Idle{std::move(_connection), now, now});
+    lock.unlock();
+    m_Returned.notify_one();
+}
+
+template <typename T>
+void ConnectionPool<T>::Discard(std::unique_ptr<T> _connection) noexcept
+{
+    _connection.reset(); // a released connection is not counted anymore
+}
+
+template <typename T>
+void ConnectionPool<T>::Detach() noexcept
+{
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        --m_Total;
+    }
+    m_Returned.notify_one();
+}
+
+template <typename T>
+void ConnectionPool<T>::Drop(std::unique_ptr<T> _connection, bool _stale) noexcept
+{
+    _connection.reset();
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        --m_Total;
+        if( _stale )
+            ++m_Metrics.stale;
+    }
+    m_Returned.notify_one();
+}
+
+template <typename T>
+template <typename Request, typename IsStale>
+std::invoke_result_t<Request &, T &> ConnectionPool<T>::Run(Request &&_request, IsStale &&_is_stale)
+{
+    const auto started = Clock::now();
+    Lease lease = Acquire();
+    auto result = _request(*lease);
+    if( !lease.Reused() || !_is_stale(result) )
+        return result;
+
+    Drop(std::move(lease.m_Connection), true);
+    auto lock = std::unique_lock{m_Lock};
+    ++m_Metrics.acquires;
+    lease = Spawn(lock, true, started);
+    return _request(*lease);
+}
+
+template <typename T>
+void ConnectionPool<T>::RecordLatency(Clock::time_point _started) noexcept
+{
+    const auto latency = Clock::now() - _started;
+    const auto bound = std::ranges::find_if(ConnectionPoolMetrics::LatencyBounds,
+                                            [&](std::chrono::microseconds _bound) { return latency < _bound; });
+    const auto lock = std::lock_guard{m_Lock};
+    ++m_Metrics.acquire_latency[std::distance(ConnectionPoolMetrics::LatencyBounds.begin(), bound)];
+}
+
+template <typename T>
+std::vector<std::unique_ptr<T>> ConnectionPool<T>::TakeExpired(Clock::time_point _now)
+{
+    std::vector<std::unique_ptr<T>> expired;
+    std::erase_if(m_Idle, [&](Idle &_idle) {
+        if( _now - _idle.returned < m_Options.idle_timeout )
+            return false;
+        expired.emplace_back(std::move(_idle.connection));
+        return true;
+    });
+    m_Total -= expired.size();
+    m_Metrics.evictions += expired.size();
+    return expired;
+}
+
+template <typename T>
+void ConnectionPool<T>::KeepAlive()
+{
+    auto lock = std::unique_lock{m_Lock};
+    while( !m_Stopped.wait_for(lock, m_Options.ping_interval, [this] { return m_Stop; }) ) {
+        const auto now = Clock::now();
+        auto expired = TakeExpired(now);
+
+        // the connections being pinged are out of the pool meanwhile, so nobody else can use them
+        std::vector<Idle> due;
+        std::erase_if(m_Idle, [&](Idle &_idle) {
+            if( now - _idle.contacted < m_Options.ping_interval )
+                return false;
+            due.emplace_back(std::move(_idle));
+            return true;
+        });
+
+        lock.unlock();
+        expired.clear();
+        for( Idle &idle : due )
+            if( !m_Traits.probe(*idle.connection) )
+                idle.connection.reset();
+        lock.lock();
+
+        for( Idle &idle : due ) {
+            ++m_Metrics.pings;
+            if( idle.connection ) {
+                idle.contacted = Clock::now();
+                m_Idle.insert(m_Idle.begin(), std::move(idle)); // pinged ones are not the recently used ones
+            }
+            else {
+                --m_Total;
+                ++m_Metrics.stale;
+            }
+        }
+        if( !due.empty() )
+            m_Returned.notify_all();
+    }
+}
+
+template <typename T>
+ConnectionPoolMetrics ConnectionPool<T>::Metrics() const
+{
+    const auto lock = std::lock_guard{m_Lock};
+    return m_Metrics;
+}
+
+template <typename T>
+size_t ConnectionPool<T>::IdleCount() const
+{
+    const auto lock = std::lock_guard{m_Lock};
+    return m_Idle.size();
+}
+
+} // namespace nc::vfs
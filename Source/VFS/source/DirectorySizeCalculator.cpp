@@ -0,0 +1,401 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "DirectorySizeCalculator.h"
+#include <Base/ParallelTreeWalker.h>
+#include <Utility/PathManip.h>
+#include <sys/dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+
+namespace nc::vfs {
+
+// Remembering more than this amount of directories in a tree is pointless, so its sizes are dropped altogether once
+// it's full.
+static constexpr size_t g_MaxCachedDirectories = 256 * 1024;
+
+// Each observation has a cost, e.g. an FSEvents stream for the native host.
+static constexpr size_t g_MaxObservedTrees = 64;
+
+// An observed tree along with the sizes of its directories which haven't changed since they were calculated.
+struct DirectorySizeCalculator::Tree {
+    const VFSHost *host = nullptr;
+    std::weak_ptr<VFSHost> weak_host; // tells whether the host is still the same one
+    std::string root;                 // without a trailing slash
+    HostDirObservationTicket ticket;
+    uint64_t generation = 0;                            // bumped upon every change, guarded by the cache lock
+    std::map<std::string, uint64_t, std::less<>> sizes; // path -> size of the whole subtree, guarded by the cache lock
+};
+
+struct DirectorySizeCalculator::Cache {
+    // Forgets the sizes of the directory, of the ones below since they could have been replaced, and of the ones
+    // above since they include it. _tree is only compared against the observed ones, it can be gone already.
+    void Forget(const Tree *_tree, std::string_view _directory);
+
+    std::optional<uint64_t> Recall(const Tree &_tree, std::string_view _directory);
+
+    // Remembers the size unless the tree has changed since _generation, as the change might not be accounted.
+    void Remember(Tree &_tree, uint64_t _generation, const std::string &_directory, uint64_t _size);
+
+    mutable std::mutex lock;
+    std::vector<std::shared_ptr<Tree>> trees; // the most recently used ones are at the back
+};
+
+// A directory being calculated. It's finished once its own files and all its subdirectories are accounted.
+struct DirectorySizeCalculator::Node {
+    Node *parent = nullptr;
+    size_t index = 0; // in the requested paths, roots only
+    std::string path;
+    Tree *tree = nullptr; // the observed tree it's in, if any
+    uint64_t generation = 0;
+    std::atomic_uint64_t size = 0;
+    std::atomic_size_t pending = 1;   // the node itself plus its unfinished subdirectories
+    std::atomic_bool partial = false; // some of its subdirectories couldn't be read
+    std::optional<Error> error;       // roots only
+};
+
+struct DirectorySizeCalculator::Walk {
+    Node *NewNode(Node *_parent, size_t _index, std::string _path)
+    {
+        const auto guard = std::lock_guard{nodes_lock};
+        Node &node = nodes.emplace_back();
+        node.parent = _parent;
+        node.index = _index;
+        node.path = std::move(_path);
+        if( _parent ) {
+            node.tree = _parent->tree;
+            node.generation = _parent->generation;
+        }
+        return &node;
+    }
+
+    // Propagates the size of a finished node up to its parents, reports the roots.
+    void Complete(Node *_node)
+    {
+        while( _node != nullptr ) {
+            if( --_node->pending != 0 )
+                return;
+            const bool cancelled = cancel_checker && cancel_checker();
+            if( _node->tree && !_node->partial && !cancelled )
+                cache->Remember(*_node->tree, _node->generation, _node->path, _node->size);
+            if( _node->parent == nullptr ) {
+                if( cancelled )
+                    Report(_node->index, std::unexpected(Error{Error::POSIX, ECANCELED}));
+                else if( _node->error )
+                    Report(_node->index, std::unexpected(*_node->error));
+                else
+                    Report(_node->index, _node->size.load());
+                return;
+            }
+            _node->parent->size += _node->size.load();
+            if( _node->partial )
+                _node->parent->partial = true;
+            _node = _node->parent;
+        }
+    }
+
+    void Report(size_t _index, std::expected<uint64_t, Error> _size)
+    {
+        const auto guard = std::lock_guard{callback_lock};
+        if( reported[_index] )
+            return;
+        reported[_index] = true;
+        callback(_index, std::move(_size));
+    }
+
+    VFSHostPtr host;
+    const Callback &callback;
+    const VFSCancelChecker &cancel_checker;
+    std::shared_ptr<Cache> cache;
+    std::vector<std::shared_ptr<Tree>> trees; // kept alive while walking
+
+    std::mutex nodes_lock;
+    std::deque<Node> nodes;
+
+    std::mutex callback_lock;
+    std::vector<bool> reported;
+};
+
+static std::string Normalized(std::string_view _path)
+{
+    return std::string(utility::PathManip::WithoutTrailingSlashes(_path));
+}
+
+static std::string Join(const std::string &_directory, std::string_view _filename)
+{
+    std::string path;
+    path.reserve(_directory.size() + 1 + _filename.size());
+    path += _directory;
+    if( path.back() != '/' )
+        path += '/';
+    path += _filename;
+    return path;
+}
+
+// Both paths are without trailing slashes.
+static bool IsWithin(std::string_view _path, std::string_view _directory) noexcept
+{
+    if( _directory == "/" )
+        return _path.starts_with('/');
+    return _path.starts_with(_directory) &&
+           (_path.length() == _directory.length() || _path[_directory.length()] == '/');
+}
+
+// Lists the directory and sums the sizes of everything inside which isn't a directory, as lstat() reports them.
+static std::expected<uint64_t, Error> ReadDirectory(VFSHost &_host,
+                                                    const std::string &_path,
+                                                    std::vector<std::string> &_subdirectories,
+                                                    const VFSCancelChecker &_cancel_checker)
+{
+    const std::expected<VFSListingPtr, Error> listing =
+        _host.FetchDirectoryListing(_path, VFSFlags::F_NoDotDot, _cancel_checker);
+    if( !listing )
+        return std::unexpected(listing.error());
+
+    uint64_t size = 0;
+    const Listing &entries = **listing;
+    for( unsigned i = 0, e = entries.Count(); i != e; ++i ) {
+        uint8_t type = entries.UnixType(i);
+        if( type == DT_UNKNOWN )
+            type = IFTODT(entries.UnixMode(i));
+        if( type == DT_DIR )
+            _subdirectories.emplace_back(entries.Filename(i));
+        else if( type == DT_LNK && entries.HasSymlink(i) )
+            size += entries.Symlink(i).size(); // the same as lstat() reports
+        else if( type != DT_LNK && entries.HasSize(i) )
+            size += entries.Size(i);
+        else if( const auto st = _host.Stat(Join(_path, entries.Filename(i)), VFSFlags::F_NoFollow, _cancel_checker) )
+            size += st->size;
+    }
+    return size;
+}
+
+void DirectorySizeCalculator::Cache::Forget(const Tree *_tree, std::string_view _directory)
+{
+    const auto guard = std::lock_guard{lock};
+    const auto it = std::ranges::find_if(trees, [&](auto &_t) { return _t.get() == _tree; });
+    if( it == trees.end() )
+        return;
+
+    Tree &tree = **it;
+    ++tree.generation;
+    if( !IsWithin(_directory, tree.root) ) {
+        tree.sizes.clear();
+        return;
+    }
+
+    const std::string prefix = _directory == "/" ? std::string("/") : std::string(_directory) + "/";
+    for( auto below = tree.sizes.lower_bound(prefix); below != tree.sizes.end() && below->first.starts_with(prefix); )
+        below = tree.sizes.erase(below);
+
+    std::string_view directory = _directory;
+    while( true ) {
+        if( const auto entry = tree.sizes.find(directory); entry != tree.sizes.end() )
+            tree.sizes.erase(entry);
+        if( directory == tree.root )
+            break;
+        directory = utility::PathManip::WithoutTrailingSlashes(utility::PathManip::Parent(directory));
+    }
+}
+
+std::optional<uint64_t> DirectorySizeCalculator::Cache::Recall(const Tree &_tree, std::string_view _directory)
+{
+    const auto guard = std::lock_guard{lock};
+    if( const auto entry = _tree.sizes.find(_directory); entry != _tree.sizes.end() )
+        return entry->second;
+    return std::nullopt;
+}
+
+void DirectorySizeCalculator::Cache::Remember(Tree &_tree,
+                                              uint64_t _generation,
+                                              const std::string &_directory,
+                                              uint64_t _size)
+{
+    const auto guard = std::lock_guard{lock};
+    if( _tree.generation != _generation )
+        return;
+    if( _tree.sizes.size() >= g_MaxCachedDirectories )
+        _tree.sizes.clear();
+    _tree.sizes.insert_or_assign(_directory, _size);
+}
+
+DirectorySizeCalculator::DirectorySizeCalculator()
+    : m_Cache(std::make_shared<Cache>()), m_MaxWorkers(base::ParallelTreeWalker<Node *>::DefaultConcurrency())
+{
+}
+
+DirectorySizeCalculator::~DirectorySizeCalculator()
+{
+    Clear();
+}
+
+void DirectorySizeCalculator::SetMaxWorkers(int _workers)
+{
+    m_MaxWorkers = std::max(_workers, 1);
+}
+
+std::shared_ptr<DirectorySizeCalculator::Tree> DirectorySizeCalculator::Observe(const VFSHostPtr &_host,
+                                                                                const std::string &_path)
+{
+    {
+        const auto guard = std::lock_guard{m_Cache->lock};
+        auto &trees = m_Cache->trees;
+        const auto it = std::ranges::find_if(trees, [&](auto &_t) {
+            return _t->host == _host.get() && !_t->weak_host.expired() && IsWithin(_path, _t->root);
+        });
+        if( it != trees.end() ) {
+            std::rotate(it, std::next(it), trees.end());
+            return trees.back();
+        }
+    }
+
+    // the observation is started without the lock since the handler acquires it
+    auto tree = std::make_shared<Tree>();
+    tree->host = _host.get();
+    tree->weak_host = _host;
+    tree->root = _path;
+    auto handler = [weak_cache = std::weak_ptr<Cache>(m_Cache), tree = tree.get()](std::string_view _directory) {
+        if( auto cache = weak_cache.lock() )
+            cache->Forget(tree, _directory);
+    };
+    tree->ticket = _host->ObserveDirectoryTreeChanges(_path, std::move(handler));
+    if( !tree->ticket )
+        return nullptr;
+
+    std::shared_ptr<Tree> expired; // released outside of the lock since the handlers acquire it
+    const auto guard = std::lock_guard{m_Cache->lock};
+    m_Cache->trees.push_back(tree);
+    if( m_Cache->trees.size() > g_MaxObservedTrees ) {
+        expired = std::move(m_Cache->trees.front());
+        m_Cache->trees.erase(m_Cache->trees.begin());
+    }
+    return tree;
+}
+
+void DirectorySizeCalculator::Calculate(const VFSHostPtr &_host,
+                                        std::span<const std::string> _paths,
+                                        const Callback &_callback,
+                                        const VFSCancelChecker &_cancel_checker)
+{
+    if( !_host || !_callback || _paths.empty() )
+        return;
+
+    Walk walk{.host = _host, .callback = _callback, .cancel_checker = _cancel_checker, .cache = m_Cache};
+    walk.reported.resize(_paths.size());
+
+    std::vector<Node *> roots;
+    for( size_t i = 0; i < _paths.size(); ++i ) {
+        if( !_paths[i].starts_with("/") ) {
+            walk.Report(i, std::unexpected(Error{Error::POSIX, EINVAL}));
+            continue;
+        }
+        Node *root = walk.NewNode(nullptr, i, Normalized(_paths[i]));
+        if( auto tree = Observe(_host, root->path) ) {
+            const auto guard = std::lock_guard{m_Cache->lock};
+            root->tree = tree.get();
+            root->generation = tree->generation;
+            walk.trees.push_back(std::move(tree));
+        }
+        roots.push_back(root);
+    }
+
+    const int workers = _host->CanServeConcurrently() ? m_MaxWorkers : 1;
+    auto visit = [&](Node *_node, std::vector<Node *> &_subdirectories) { Visit(walk, _node, _subdirectories); };
+    base::ParallelTreeWalker<Node *>::CancelChecker cancel;
+    if( _cancel_checker )
+        cancel = [&] { return _cancel_checker(); };
+    base::ParallelTreeWalker<Node *> walker(workers, visit, cancel);
+    walker.Walk(std::move(roots));
+
+    // whatever wasn't reported was interrupted
+    for( size_t i = 0; i < _paths.size(); ++i )
+        walk.Report(i, std::unexpected(Error{Error::POSIX, ECANCELED}));
+}
+
+std::expected<uint64_t, Error> DirectorySizeCalculator::Calculate(const VFSHostPtr &_host,
+                                                                  std::string_view _path,
+                                                                  const VFSCancelChecker &_cancel_checker)
+{
+    const std::string paths[] = {std::string(_path)};
+    std::expected<uint64_t, Error> result = std::unexpected(Error{Error::POSIX, EINVAL});
+    const auto callback = [&](size_t, std::expected<uint64_t, Error> _size) { result = std::move(_size); };
+    Calculate(_host, paths, callback, _cancel_checker);
+    return result;
+}
+
+void DirectorySizeCalculator::Visit(Walk &_walk, Node *_node, std::vector<Node *> &_subdirectories) const
+{
+    if( _node->tree ) {
+        if( const std::optional<uint64_t> size = _walk.cache->Recall(*_node->tree, _node->path) ) {
+            _node->size = *size;
+            _walk.Complete(_node);
+            return;
+        }
+    }
+
+    std::vector<std::string> subdirectories;
+    std::expected<uint64_t, Error> size = std::unexpected(Error{Error::POSIX, ENOTDIR});
+    if( _node->parent == nullptr ) {
+        // the requested paths are not known to be directories, unlike the ones found in the listings
+        const std::expected<VFSStat, Error> st = _walk.host->Stat(_node->path, 0, _walk.cancel_checker);
+        if( !st )
+            size = std::unexpected(st.error());
+        else if( (st->mode & S_IFMT) == S_IFDIR )
+            size = ReadDirectory(*_walk.host, _node->path, subdirectories, _walk.cancel_checker);
+    }
+    else {
+        size = ReadDirectory(*_walk.host, _node->path, subdirectories, _walk.cancel_checker);
+    }
+
+    if( !size ) {
+        // the errors below the requested directories are deliberately ignored
+        if( _node->parent == nullptr )
+            _node->error = size.error();
+        _node->partial = true;
+        _walk.Complete(_node);
+        return;
+    }
+
+    _node->size += *size;
+    _node->pending += subdirectories.size();
+    for( const std::string &subdirectory : subdirectories )
+        _subdirectories.push_back(_walk.NewNode(_node, 0, Join(_node->path, subdirectory)));
+    _walk.Complete(_node);
+}
+
+void DirectorySizeCalculator::Invalidate(const VFSHost &_host, std::string_view _path)
+{
+    const std::string path = Normalized(_path);
+    std::vector<const Tree *> affected;
+    {
+        const auto guard = std::lock_guard{m_Cache->lock};
+        for( const auto &tree : m_Cache->trees )
+            if( tree->host == &_host && (IsWithin(path, tree->root) || IsWithin(tree->root, path)) )
+                affected.push_back(tree.get());
+    }
+    for( const Tree *tree : affected )
+        m_Cache->Forget(tree, path);
+}
+
+void DirectorySizeCalculator::Clear()
+{
+    std::vector<std::shared_ptr<Tree>> trees; // released outside of the lock since the handlers acquire it
+    {
+        const auto guard = std::lock_guard{m_Cache->lock};
+        trees.swap(m_Cache->trees);
+    }
+}
+
+size_t DirectorySizeCalculator::CachedCount() const
+{
+    const auto guard = std::lock_guard{m_Cache->lock};
+    size_t count = 0;
+    for( const auto &tree : m_Cache->trees )
+        count += tree->sizes.size();
+    return count;
+}
+
+} // namespace nc::vfs
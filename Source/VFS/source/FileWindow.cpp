@@ -1,6 +1,7 @@
 // Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include <VFS/FileWindow.h>
 #include <cassert>
+#include <tuple>
 
 namespace nc::vfs {
 
@@ -103,8 +104,16 @@ std::expected<void, Error> FileWindow::MoveWindow(size_t _offset)
         return std::unexpected(Error{Error::POSIX, EINVAL});
 
     switch( m_File->GetReadParadigm() ) {
-        case VFSFile::ReadParadigm::Random:
-            return DoMoveWindowRandom(_offset);
+        case VFSFile::ReadParadigm::Random: {
+            const size_t prev_pos = m_WindowPos;
+            const std::expected<void, Error> ret = DoMoveWindowRandom(_offset);
+            if( !ret ) {
+                // put back the previous contents, e.g. when the requested range is yet to be fetched
+                m_WindowPos = prev_pos;
+                std::ignore = ReadFileWindowRandomPart(0, m_WindowSize);
+            }
+            return ret;
+        }
         case VFSFile::ReadParadigm::Seek:
             return DoMoveWindowSeek(_offset);
         case VFSFile::ReadParadigm::Sequential:
@@ -224,6 +224,13 @@ HostDirObservationTicket Host::ObserveDirectoryChanges([[maybe_unused]] std::str
     return {};
 }
 
+HostDirObservationTicket
+Host::ObserveDirectoryTreeChanges([[maybe_unused]] std::string_view _path,
+                                  [[maybe_unused]] std::function<void(std::string_view _directory)> _handler)
+{
+    return {};
+}
+
 void Host::StopDirChangeObserving([[maybe_unused]] unsigned long _ticket)
 {
 }
@@ -523,6 +530,11 @@ uint64_t Host::Features() const noexcept
     return m_Features;
 }
 
+bool Host::CanServeConcurrently() const noexcept
+{
+    return IsNativeFS() || (Features() & HostFeatures::ConcurrentListing);
+}
+
 uint64_t Host::FullHashForPath(std::string_view _path) const noexcept
 {
     const auto max_hosts = 8;
@@ -0,0 +1,177 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "File.h"
+#include "Internal.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nc::vfs::mem {
+
+File::File(std::string_view _relative_path, const std::shared_ptr<MemHost> &_host) : VFSFile(_relative_path, _host)
+{
+}
+
+File::~File()
+{
+    Close();
+}
+
+Tree &File::Storage() const noexcept
+{
+    return static_cast<MemHost &>(*VFSFile::Host()).Storage();
+}
+
+int File::Open(unsigned long _open_flags, [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    if( IsOpened() )
+        Close();
+
+    if( !(_open_flags & (VFSFlags::OF_Read | VFSFlags::OF_Write)) )
+        return VFSError::InvalidCall;
+
+    std::expected<Tree::Chain, Error> chain = Storage().Open(Path(), _open_flags);
+    if( !chain )
+        return VFSError::FromErrno(static_cast<int>(chain.error().Code()));
+
+    m_Entry = chain->back();
+    m_Directory = chain->size() > 1 ? (*chain)[chain->size() - 2] : m_Entry;
+    m_Snapshot = Storage().Read(*m_Entry);
+    m_OpenFlags = _open_flags;
+    m_Position = 0;
+    return VFSError::Ok;
+}
+
+bool File::IsOpened() const
+{
+    return m_OpenFlags != 0;
+}
+
+int File::Close()
+{
+    if( m_Draft ) {
+        // the draft is never modified after being published
+        Storage().Write(*m_Entry, std::move(m_Draft), *m_Directory);
+        m_Draft.reset();
+    }
+    m_Directory.reset();
+    m_Entry.reset();
+    m_Snapshot.reset();
+    m_OpenFlags = 0;
+    m_Position = 0;
+    return VFSError::Ok;
+}
+
+std::shared_ptr<VFSFile> File::Clone() const
+{
+    return std::make_shared<File>(Path(), std::static_pointer_cast<MemHost>(VFSFile::Host()));
+}
+
+VFSFile::ReadParadigm File::GetReadParadigm() const
+{
+    return VFSFile::ReadParadigm::Random;
+}
+
+VFSFile::WriteParadigm File::GetWriteParadigm() const
+{
+    return VFSFile::WriteParadigm::Seek;
+}
+
+const std::string &File::Contents() const noexcept
+{
+    return m_Draft ? *m_Draft : *m_Snapshot;
+}
+
+ssize_t File::Read(void *_buf, size_t _size)
+{
+    if( !IsOpened() || !(m_OpenFlags & VFSFlags::OF_Read) )
+        return SetLastError(VFSError::InvalidCall);
+
+    const std::string &contents = Contents();
+    if( m_Position >= static_cast<off_t>(contents.size()) )
+        return 0;
+
+    const size_t to_read = std::min(contents.size() - m_Position, _size);
+    std::memcpy(_buf, contents.data() + m_Position, to_read);
+    m_Position += to_read;
+    return to_read;
+}
+
+std::expected<size_t, Error> File::ReadAt(off_t _pos, void *_buf, size_t _size)
+{
+    if( !IsOpened() || !(m_OpenFlags & VFSFlags::OF_Read) )
+        return SetLastError(Error{Error::POSIX, EINVAL});
+
+    const std::string &contents = Contents();
+    if( _pos < 0 || _pos > static_cast<off_t>(contents.size()) )
+        return SetLastError(Error{Error::POSIX, EINVAL});
+
+    const size_t to_read = std::min(contents.size() - _pos, _size);
+    std::memcpy(_buf, contents.data() + _pos, to_read);
+    return to_read;
+}
+
+ssize_t File::Write(const void *_buf, size_t _size)
+{
+    if( !IsOpened() || !(m_OpenFlags & VFSFlags::OF_Write) )
+        return SetLastError(VFSError::InvalidCall);
+
+    if( !m_Draft )
+        m_Draft = std::make_shared<std::string>(*m_Snapshot);
+
+    if( m_OpenFlags & VFSFlags::OF_Append )
+        m_Position = m_Draft->size();
+
+    const size_t end = m_Position + _size;
+    if( end > m_Draft->size() )
+        m_Draft->resize(end);
+    std::memcpy(m_Draft->data() + m_Position, _buf, _size);
+    m_Position = end;
+    return _size;
+}
+
+off_t File::Seek(off_t _off, int _basis)
+{
+    if( !IsOpened() )
+        return SetLastError(VFSError::InvalidCall);
+
+    off_t req_pos = 0;
+    if( _basis == VFSFile::Seek_Set )
+        req_pos = _off;
+    else if( _basis == VFSFile::Seek_End )
+        req_pos = static_cast<off_t>(Contents().size()) + _off;
+    else if( _basis == VFSFile::Seek_Cur )
+        req_pos = m_Position + _off;
+    else
+        return SetLastError(VFSError::InvalidCall);
+
+    if( req_pos < 0 )
+        return SetLastError(VFSError::InvalidCall);
+
+    // seeking beyond the end is allowed only for writing, the gap is filled with zeros upon the next write
+    if( !(m_OpenFlags & VFSFlags::OF_Write) )
+        req_pos = std::min(req_pos, static_cast<off_t>(Contents().size()));
+    m_Position = req_pos;
+    return m_Position;
+}
+
+ssize_t File::Pos() const
+{
+    if( !IsOpened() )
+        return SetLastError(VFSError::InvalidCall);
+    return m_Position;
+}
+
+ssize_t File::Size() const
+{
+    if( !IsOpened() )
+        return SetLastError(VFSError::InvalidCall);
+    return Contents().size();
+}
+
+bool File::Eof() const
+{
+    if( !IsOpened() )
+        return true;
+    return m_Position >= static_cast<off_t>(Contents().size());
+}
+
+} // namespace nc::vfs::mem
@@ -0,0 +1,45 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <VFS/VFSFile.h>
+#include "Host.h"
+
+namespace nc::vfs::mem {
+
+// A file of MemHost. Reading works with a snapshot of the contents taken upon opening, so it's never affected by the
+// concurrent writers. Writing goes into a private copy of the contents which replaces the file's contents on Close().
+class File final : public VFSFile
+{
+public:
+    File(std::string_view _relative_path, const std::shared_ptr<MemHost> &_host);
+    ~File();
+
+    int Open(unsigned long _open_flags, const VFSCancelChecker &_cancel_checker = {}) override;
+    bool IsOpened() const override;
+    int Close() override;
+    std::shared_ptr<VFSFile> Clone() const override;
+
+    ReadParadigm GetReadParadigm() const override;
+    WriteParadigm GetWriteParadigm() const override;
+
+    ssize_t Read(void *_buf, size_t _size) override;
+    std::expected<size_t, Error> ReadAt(off_t _pos, void *_buf, size_t _size) override;
+    ssize_t Write(const void *_buf, size_t _size) override;
+    off_t Seek(off_t _off, int _basis) override;
+    ssize_t Pos() const override;
+    ssize_t Size() const override;
+    bool Eof() const override;
+
+private:
+    const std::string &Contents() const noexcept;
+    Tree &Storage() const noexcept;
+
+    std::shared_ptr<DirectoryEntry> m_Directory;
+    std::shared_ptr<DirectoryEntry> m_Entry;
+    std::shared_ptr<const std::string> m_Snapshot;
+    std::shared_ptr<std::string> m_Draft; // the private copy being written, created upon the first write
+    unsigned long m_OpenFlags = 0;
+    off_t m_Position = 0;
+};
+
+} // namespace nc::vfs::mem
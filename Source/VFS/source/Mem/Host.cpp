@@ -1,5 +1,14 @@
-// Copyright (C) 2020 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2020-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Host.h"
+#include "File.h"
+#include "Internal.h"
+#include "../ListingInput.h"
+#include <Utility/PathManip.h>
+#include <sys/dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+
 namespace nc::vfs {
 
 const char *MemHost::UniqueTag = "memfs";
@@ -16,9 +25,18 @@ public:
     [[nodiscard]] static const char *VerboseJunction() { return "[memfs]:"; }
 };
 
-MemHost::MemHost() : Host("", std::shared_ptr<Host>(nullptr), UniqueTag)
+static timespec ToTimespec(time_t _time) noexcept
+{
+    return {.tv_sec = _time, .tv_nsec = 0};
+}
+
+MemHost::MemHost() : Host("", std::shared_ptr<Host>(nullptr), UniqueTag), m_Tree(std::make_unique<mem::Tree>())
 {
+    m_Tree->SetChangeCallback([this](const mem::DirectoryEntry &_directory) { OnDirectoryChanged(_directory); });
+    AddFeatures(HostFeatures::SetOwnership | HostFeatures::SetFlags | HostFeatures::SetPermissions |
+                HostFeatures::SetTimes);
 }
+
 MemHost::~MemHost() = default;
 
 VFSConfiguration MemHost::Configuration() const
@@ -37,4 +55,262 @@ VFSMeta MemHost::Meta()
     return m;
 }
 
+mem::Tree &MemHost::Storage() noexcept
+{
+    return *m_Tree;
+}
+
+bool MemHost::IsWritable() const
+{
+    return true;
+}
+
+std::expected<VFSStat, Error>
+MemHost::Stat(std::string_view _path, unsigned long _flags, [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->Stat(_path, !(_flags & VFSFlags::F_NoFollow));
+}
+
+std::expected<VFSListingPtr, Error> MemHost::FetchDirectoryListing(std::string_view _path,
+                                                                   unsigned long _flags,
+                                                                   const VFSCancelChecker &_cancel_checker)
+{
+    const std::expected<std::vector<mem::Tree::Child>, Error> children = m_Tree->List(_path);
+    if( !children )
+        return std::unexpected(children.error());
+
+    using nc::base::variable_container;
+    const std::string directory = EnsureTrailingSlash(std::string(_path));
+    ListingInput listing_source;
+    listing_source.hosts[0] = shared_from_this();
+    listing_source.directories[0] = directory;
+    listing_source.inodes.reset(variable_container<>::type::dense);
+    listing_source.atimes.reset(variable_container<>::type::dense);
+    listing_source.mtimes.reset(variable_container<>::type::dense);
+    listing_source.ctimes.reset(variable_container<>::type::dense);
+    listing_source.btimes.reset(variable_container<>::type::dense);
+    listing_source.unix_flags.reset(variable_container<>::type::dense);
+    listing_source.uids.reset(variable_container<>::type::dense);
+    listing_source.gids.reset(variable_container<>::type::dense);
+    listing_source.sizes.reset(variable_container<>::type::dense);
+    listing_source.symlinks.reset(variable_container<>::type::sparse);
+
+    listing_source.filenames.reserve(children->size() + 1);
+    listing_source.unix_modes.reserve(children->size() + 1);
+    listing_source.unix_types.reserve(children->size() + 1);
+
+    auto push = [&](std::string _filename, const VFSStat &_st) {
+        const size_t n = listing_source.filenames.size();
+        const bool is_dir = (_st.mode & S_IFMT) == S_IFDIR;
+        listing_source.filenames.emplace_back(std::move(_filename));
+        listing_source.unix_modes.emplace_back(_st.mode);
+        listing_source.unix_types.emplace_back(IFTODT(_st.mode));
+        listing_source.inodes.insert(n, _st.inode);
+        listing_source.atimes.insert(n, _st.atime.tv_sec);
+        listing_source.mtimes.insert(n, _st.mtime.tv_sec);
+        listing_source.ctimes.insert(n, _st.ctime.tv_sec);
+        listing_source.btimes.insert(n, _st.btime.tv_sec);
+        listing_source.unix_flags.insert(n, _st.flags);
+        listing_source.uids.insert(n, _st.uid);
+        listing_source.gids.insert(n, _st.gid);
+        listing_source.sizes.insert(n, is_dir ? ListingInput::unknown_size : _st.size);
+        return n;
+    };
+
+    if( !(_flags & VFSFlags::F_NoDotDot) && directory != "/" ) {
+        if( const std::expected<VFSStat, Error> st = m_Tree->Stat(directory + "..", true) )
+            push("..", *st);
+    }
+
+    for( const mem::Tree::Child &child : *children ) {
+        if( _cancel_checker && _cancel_checker() )
+            return std::unexpected(Error{Error::POSIX, ECANCELED});
+
+        const VFSStat st = m_Tree->Stat(*child.entry);
+        const size_t n = push(child.name, st);
+        if( const auto symlink = std::get_if<mem::Symlink>(&child.entry->body) ) {
+            // the value of a symlink never changes, the listing shows the mode of its target
+            listing_source.symlinks.insert(n, symlink->value);
+            if( const std::expected<VFSStat, Error> target = m_Tree->Stat(directory + child.name, true) )
+                listing_source.unix_modes[n] = target->mode;
+        }
+    }
+
+    return VFSListing::Build(std::move(listing_source));
+}
+
+std::expected<void, Error>
+MemHost::IterateDirectoryListing(std::string_view _path, const std::function<bool(const VFSDirEnt &_dirent)> &_handler)
+{
+    const std::expected<std::vector<mem::Tree::Child>, Error> children = m_Tree->List(_path);
+    if( !children )
+        return std::unexpected(children.error());
+
+    VFSDirEnt dirent;
+    for( const mem::Tree::Child &child : *children ) {
+        const size_t len = std::min(child.name.size(), sizeof(dirent.name) - 1);
+        std::memcpy(dirent.name, child.name.data(), len);
+        dirent.name[len] = 0;
+        dirent.name_len = static_cast<uint16_t>(len);
+        if( std::holds_alternative<mem::Directory>(child.entry->body) )
+            dirent.type = VFSDirEnt::Dir;
+        else if( std::holds_alternative<mem::Symlink>(child.entry->body) )
+            dirent.type = VFSDirEnt::Link;
+        else
+            dirent.type = VFSDirEnt::Reg;
+        if( !_handler(dirent) )
+            break;
+    }
+    return {};
+}
+
+std::expected<std::string, Error> MemHost::ReadSymlink(std::string_view _symlink_path,
+                                                       [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->ReadSymlink(_symlink_path);
+}
+
+std::expected<std::shared_ptr<VFSFile>, Error>
+MemHost::CreateFile(std::string_view _path, [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return std::make_shared<mem::File>(_path, std::static_pointer_cast<MemHost>(shared_from_this()));
+}
+
+std::expected<void, Error>
+MemHost::CreateDirectory(std::string_view _path, int _mode, [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->CreateDirectory(_path, static_cast<uint16_t>(_mode));
+}
+
+std::expected<void, Error> MemHost::CreateSymlink(std::string_view _symlink_path,
+                                                  std::string_view _symlink_value,
+                                                  [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->CreateSymlink(_symlink_path, _symlink_value);
+}
+
+std::expected<void, Error> MemHost::Unlink(std::string_view _path,
+                                           [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->Unlink(_path);
+}
+
+std::expected<void, Error> MemHost::RemoveDirectory(std::string_view _path,
+                                                    [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->RemoveDirectory(_path);
+}
+
+std::expected<void, Error> MemHost::Rename(std::string_view _old_path,
+                                           std::string_view _new_path,
+                                           [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->Rename(_old_path, _new_path);
+}
+
+std::expected<void, Error> MemHost::SetTimes(std::string_view _path,
+                                             std::optional<time_t> _birth_time,
+                                             std::optional<time_t> _mod_time,
+                                             std::optional<time_t> _chg_time,
+                                             std::optional<time_t> _acc_time,
+                                             [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    if( !_birth_time && !_mod_time && !_chg_time && !_acc_time )
+        return {};
+
+    return m_Tree->Change(_path, true, [&](mem::DirectoryEntry &_entry) {
+        if( _birth_time )
+            _entry.btime = ToTimespec(*_birth_time);
+        if( _mod_time )
+            _entry.mtime = ToTimespec(*_mod_time);
+        if( _chg_time )
+            _entry.ctime = ToTimespec(*_chg_time);
+        if( _acc_time )
+            _entry.atime = ToTimespec(*_acc_time);
+    });
+}
+
+std::expected<void, Error> MemHost::SetPermissions(std::string_view _path,
+                                                   uint16_t _mode,
+                                                   [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->Change(_path, true, [&](mem::DirectoryEntry &_entry) {
+        _entry.mode = static_cast<uint16_t>((_entry.mode & S_IFMT) | (_mode & ~S_IFMT));
+    });
+}
+
+std::expected<void, Error> MemHost::SetFlags(std::string_view _path,
+                                             uint32_t _flags,
+                                             uint64_t _vfs_options,
+                                             [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->Change(
+        _path, !(_vfs_options & VFSFlags::F_NoFollow), [&](mem::DirectoryEntry &_entry) { _entry.flags = _flags; });
+}
+
+std::expected<void, Error> MemHost::SetOwnership(std::string_view _path,
+                                                 unsigned _uid,
+                                                 unsigned _gid,
+                                                 [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
+{
+    return m_Tree->Change(_path, true, [&](mem::DirectoryEntry &_entry) {
+        _entry.uid = _uid;
+        _entry.gid = _gid;
+    });
+}
+
+std::expected<void, Error>
+MemHost::WriteFile(std::string_view _path, std::shared_ptr<const std::string> _contents, uint16_t _mode)
+{
+    return m_Tree->CreateFile(_path, _mode, std::move(_contents));
+}
+
+std::expected<void, Error> MemHost::WriteFile(std::string_view _path, std::string_view _contents, uint16_t _mode)
+{
+    return WriteFile(_path, std::make_shared<const std::string>(_contents), _mode);
+}
+
+bool MemHost::IsDirectoryChangeObservationAvailable(std::string_view _path)
+{
+    const std::expected<mem::Tree::Chain, Error> chain = m_Tree->Resolve(_path, true);
+    return chain && std::holds_alternative<mem::Directory>(chain->back()->body);
+}
+
+HostDirObservationTicket MemHost::ObserveDirectoryChanges(std::string_view _path, std::function<void()> _handler)
+{
+    const std::expected<mem::Tree::Chain, Error> chain = m_Tree->Resolve(_path, true);
+    if( !chain || !std::holds_alternative<mem::Directory>(chain->back()->body) || !_handler )
+        return {};
+
+    const std::lock_guard<std::mutex> lock(m_ObserversLock);
+    const unsigned long ticket = m_LastTicket++;
+    m_Observers.push_back({.ticket = ticket, .directory = chain->back(), .handler = std::move(_handler)});
+    m_ObserversCount = m_Observers.size();
+    return {ticket, shared_from_this()};
+}
+
+void MemHost::StopDirChangeObserving(unsigned long _ticket)
+{
+    const std::lock_guard<std::mutex> lock(m_ObserversLock);
+    std::erase_if(m_Observers, [=](const Observer &_o) { return _o.ticket == _ticket; });
+    m_ObserversCount = m_Observers.size();
+}
+
+void MemHost::OnDirectoryChanged(const mem::DirectoryEntry &_directory)
+{
+    if( m_ObserversCount == 0 )
+        return;
+
+    // the handlers are called outside of the lock so that they can stop observing right away
+    std::vector<std::function<void()>> handlers;
+    {
+        const std::lock_guard<std::mutex> lock(m_ObserversLock);
+        for( const Observer &observer : m_Observers )
+            if( observer.directory.get() == &_directory )
+                handlers.push_back(observer.handler);
+    }
+    for( const auto &handler : handlers )
+        handler();
+}
+
 } // namespace nc::vfs
@@ -1,14 +1,23 @@
-// Copyright (C) 2020 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2020-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <VFS/Host.h>
 #include <VFS/VFSFile.h>
+#include <atomic>
+#include <mutex>
 
 namespace nc::vfs {
 
-// This is a stub for something I need to write
+namespace mem {
+class Tree;
+struct DirectoryEntry;
+} // namespace mem
 
-class MemHost : public Host
+// A filesystem which resides entirely in memory.
+// Operations in different directories run concurrently and files share the copy-on-write blobs of their contents, so
+// millions of synthetic entries can be held cheaply. Primarily meant for tests and benchmarks which shouldn't depend
+// on the state of a real disk.
+class MemHost final : public Host
 {
 public:
     MemHost();
@@ -17,6 +26,93 @@ public:
     static const char *UniqueTag;
     virtual VFSConfiguration Configuration() const override;
     static VFSMeta Meta();
+
+    bool IsWritable() const override;
+
+    std::expected<VFSStat, Error>
+    Stat(std::string_view _path, unsigned long _flags, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<VFSListingPtr, Error> FetchDirectoryListing(std::string_view _path,
+                                                              unsigned long _flags,
+                                                              const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error>
+    IterateDirectoryListing(std::string_view _path,
+                            const std::function<bool(const VFSDirEnt &_dirent)> &_handler) override;
+
+    std::expected<std::string, Error> ReadSymlink(std::string_view _symlink_path,
+                                                  const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<std::shared_ptr<VFSFile>, Error> CreateFile(std::string_view _path,
+                                                              const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error>
+    CreateDirectory(std::string_view _path, int _mode, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> CreateSymlink(std::string_view _symlink_path,
+                                             std::string_view _symlink_value,
+                                             const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> Unlink(std::string_view _path, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> RemoveDirectory(std::string_view _path,
+                                               const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> Rename(std::string_view _old_path,
+                                      std::string_view _new_path,
+                                      const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> SetTimes(std::string_view _path,
+                                        std::optional<time_t> _birth_time,
+                                        std::optional<time_t> _mod_time,
+                                        std::optional<time_t> _chg_time,
+                                        std::optional<time_t> _acc_time,
+                                        const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error>
+    SetPermissions(std::string_view _path, uint16_t _mode, const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> SetFlags(std::string_view _path,
+                                        uint32_t _flags,
+                                        uint64_t _vfs_options,
+                                        const VFSCancelChecker &_cancel_checker = {}) override;
+
+    std::expected<void, Error> SetOwnership(std::string_view _path,
+                                            unsigned _uid,
+                                            unsigned _gid,
+                                            const VFSCancelChecker &_cancel_checker = {}) override;
+
+    bool IsDirectoryChangeObservationAvailable(std::string_view _path) override;
+
+    // Observes the directory itself rather than its path, i.e. the observation follows the directory when it's moved.
+    HostDirObservationTicket ObserveDirectoryChanges(std::string_view _path, std::function<void()> _handler) override;
+
+    // Creates a regular file with the specified contents in an existing directory, an existing file is replaced.
+    // The same blob can be shared by any amount of files without copying.
+    std::expected<void, Error>
+    WriteFile(std::string_view _path, std::shared_ptr<const std::string> _contents, uint16_t _mode = 0644);
+    std::expected<void, Error> WriteFile(std::string_view _path, std::string_view _contents, uint16_t _mode = 0644);
+
+    // The underlying tree, used by the files.
+    mem::Tree &Storage() noexcept;
+
+protected:
+    void StopDirChangeObserving(unsigned long _ticket) override;
+
+private:
+    struct Observer {
+        unsigned long ticket;
+        std::shared_ptr<const mem::DirectoryEntry> directory;
+        std::function<void()> handler;
+    };
+
+    void OnDirectoryChanged(const mem::DirectoryEntry &_directory);
+
+    std::unique_ptr<mem::Tree> m_Tree;
+    std::mutex m_ObserversLock;
+    std::vector<Observer> m_Observers;
+    std::atomic_size_t m_ObserversCount = 0; // allows to skip the lock when nobody is watching
+    unsigned long m_LastTicket = 1;
 };
 
 } // namespace nc::vfs
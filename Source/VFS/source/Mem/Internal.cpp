@@ -1,2 +1,537 @@
-// Copyright (C) 2020 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2020-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Internal.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <deque>
+#include <ctime>
+#include <unistd.h>
+
+namespace nc::vfs::mem {
+
+static constexpr size_t g_MaxSymlinksToFollow = 32;
+
+static timespec Now() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts;
+}
+
+static const std::shared_ptr<const std::string> &EmptyBlob()
+{
+    static const auto blob = std::make_shared<const std::string>();
+    return blob;
+}
+
+static bool IsDirectory(const DirectoryEntry &_entry) noexcept
+{
+    return std::holds_alternative<Directory>(_entry.body);
+}
+
+static bool IsSymlink(const DirectoryEntry &_entry) noexcept
+{
+    return std::holds_alternative<Symlink>(_entry.body);
+}
+
+// Appends the non-empty components of _path to _stack so that the first one ends up on top.
+static void PushComponents(std::string_view _path, std::vector<std::string_view> &_stack)
+{
+    const size_t base = _stack.size();
+    size_t pos = 0;
+    while( pos < _path.size() ) {
+        const size_t end = std::min(_path.find('/', pos), _path.size());
+        if( end != pos )
+            _stack.push_back(_path.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    std::reverse(_stack.begin() + base, _stack.end());
+}
+
+// Exclusively locks up to three shards in the order of their addresses, each shard is locked only once.
+class Tree::ExclusiveLocks
+{
+public:
+    ExclusiveLocks(std::initializer_list<std::shared_mutex *> _locks)
+    {
+        for( std::shared_mutex *lock : _locks ) {
+            const auto end = m_Locks.begin() + m_Count;
+            if( lock != nullptr && std::find(m_Locks.begin(), end, lock) == end )
+                m_Locks[m_Count++] = lock;
+        }
+        std::sort(m_Locks.begin(), m_Locks.begin() + m_Count, std::less<>{});
+        for( size_t i = 0; i < m_Count; ++i )
+            m_Locks[i]->lock();
+    }
+
+    ~ExclusiveLocks()
+    {
+        for( size_t i = m_Count; i > 0; --i )
+            m_Locks[i - 1]->unlock();
+    }
+
+private:
+    std::array<std::shared_mutex *, 3> m_Locks = {};
+    size_t m_Count = 0;
+};
+
+Tree::Tree()
+{
+    m_Root = NewEntry(S_IFDIR | 0755);
+}
+
+void Tree::SetChangeCallback(ChangeCallback _callback)
+{
+    m_OnChange = std::move(_callback);
+}
+
+std::shared_mutex &Tree::ShardOf(const DirectoryEntry &_entry) const noexcept
+{
+    return m_Shards[_entry.inode % ShardsCount].lock;
+}
+
+std::shared_ptr<DirectoryEntry> Tree::NewEntry(uint16_t _mode)
+{
+    auto entry = std::make_shared<DirectoryEntry>();
+    entry->inode = ++m_LastInode;
+    entry->mode = _mode;
+    entry->uid = geteuid();
+    entry->gid = getegid();
+    entry->atime = entry->mtime = entry->ctime = entry->btime = Now();
+    if( (_mode & S_IFMT) == S_IFDIR )
+        entry->body = Directory{};
+    else if( (_mode & S_IFMT) == S_IFLNK )
+        entry->body = Symlink{};
+    else
+        entry->body = Reg{EmptyBlob()};
+    return entry;
+}
+
+void Tree::Changed(const DirectoryEntry &_directory) const
+{
+    if( m_OnChange )
+        m_OnChange(_directory);
+}
+
+std::expected<Tree::Chain, Error> Tree::Resolve(std::string_view _path, bool _follow_last) const
+{
+    if( _path.empty() || _path.front() != '/' )
+        return std::unexpected(Error{Error::POSIX, EINVAL});
+
+    Chain chain{m_Root};
+    std::vector<std::string_view> pending;
+    std::deque<std::string> targets; // the symlink values referred to by 'pending'
+    PushComponents(_path, pending);
+    while( !pending.empty() ) {
+        const std::string_view name = pending.back();
+        pending.pop_back();
+        if( name == "." )
+            continue;
+        if( name == ".." ) {
+            if( chain.size() > 1 )
+                chain.pop_back();
+            continue;
+        }
+
+        std::shared_ptr<DirectoryEntry> child;
+        {
+            const DirectoryEntry &parent = *chain.back();
+            const auto lock = std::shared_lock{ShardOf(parent)};
+            const Directory *directory = std::get_if<Directory>(&parent.body);
+            if( directory == nullptr )
+                return std::unexpected(Error{Error::POSIX, ENOTDIR});
+            const auto it = directory->entries.find(name);
+            if( it == directory->entries.end() )
+                return std::unexpected(Error{Error::POSIX, ENOENT});
+            child = it->second;
+        }
+
+        if( IsSymlink(*child) && (_follow_last || !pending.empty()) ) {
+            if( targets.size() == g_MaxSymlinksToFollow )
+                return std::unexpected(Error{Error::POSIX, ELOOP});
+            const std::string &target = targets.emplace_back(std::get<Symlink>(child->body).value);
+            if( target.starts_with("/") )
+                chain.resize(1);
+            PushComponents(target, pending);
+            continue;
+        }
+        chain.push_back(std::move(child));
+    }
+    return chain;
+}
+
+std::expected<Tree::Location, Error> Tree::Locate(std::string_view _path, int _root_error) const
+{
+    if( _path.empty() || _path.front() != '/' )
+        return std::unexpected(Error{Error::POSIX, EINVAL});
+    while( _path.size() > 1 && _path.back() == '/' )
+        _path.remove_suffix(1);
+    if( _path == "/" )
+        return std::unexpected(Error{Error::POSIX, _root_error});
+
+    const size_t slash = _path.rfind('/');
+    const std::string_view name = _path.substr(slash + 1);
+    if( name == "." || name == ".." )
+        return std::unexpected(Error{Error::POSIX, EINVAL});
+
+    std::expected<Chain, Error> parents = Resolve(_path.substr(0, slash + 1), true);
+    if( !parents )
+        return std::unexpected(parents.error());
+    if( !IsDirectory(*parents->back()) )
+        return std::unexpected(Error{Error::POSIX, ENOTDIR});
+    return Location{.parents = std::move(*parents), .name = name};
+}
+
+VFSStat Tree::Stat(const DirectoryEntry &_entry) const
+{
+    VFSStat st;
+    st.meaning = VFSStat::AllMeaning();
+    st.blksize = 4096;
+    st.inode = _entry.inode; // never changes
+
+    const auto lock = std::shared_lock{ShardOf(_entry)};
+    st.mode = _entry.mode;
+    st.uid = _entry.uid;
+    st.gid = _entry.gid;
+    st.flags = _entry.flags;
+    st.atime = _entry.atime;
+    st.mtime = _entry.mtime;
+    st.ctime = _entry.ctime;
+    st.btime = _entry.btime;
+    if( const Reg *reg = std::get_if<Reg>(&_entry.body) ) {
+        st.size = reg->data->size();
+        st.nlink = 1;
+    }
+    else if( const Symlink *symlink = std::get_if<Symlink>(&_entry.body) ) {
+        st.size = symlink->value.size();
+        st.nlink = 1;
+    }
+    else {
+        st.nlink = 2;
+    }
+    st.blocks = (st.size + 511) / 512;
+    return st;
+}
+
+std::expected<VFSStat, Error> Tree::Stat(std::string_view _path, bool _follow_last) const
+{
+    const std::expected<Chain, Error> chain = Resolve(_path, _follow_last);
+    if( !chain )
+        return std::unexpected(chain.error());
+    return Stat(*chain->back());
+}
+
+std::expected<std::vector<Tree::Child>, Error> Tree::List(std::string_view _path) const
+{
+    const std::expected<Chain, Error> chain = Resolve(_path, true);
+    if( !chain )
+        return std::unexpected(chain.error());
+
+    const DirectoryEntry &entry = *chain->back();
+    const auto lock = std::shared_lock{ShardOf(entry)};
+    const Directory *directory = std::get_if<Directory>(&entry.body);
+    if( directory == nullptr )
+        return std::unexpected(Error{Error::POSIX, ENOTDIR});
+
+    std::vector<Child> children;
+    children.reserve(directory->entries.size());
+    for( const auto &[name, child] : directory->entries )
+        children.push_back({.name = name, .entry = child});
+    return children;
+}
+
+std::expected<std::string, Error> Tree::ReadSymlink(std::string_view _path) const
+{
+    const std::expected<Chain, Error> chain = Resolve(_path, false);
+    if( !chain )
+        return std::unexpected(chain.error());
+    if( const Symlink *symlink = std::get_if<Symlink>(&chain->back()->body) )
+        return symlink->value;
+    return std::unexpected(Error{Error::POSIX, EINVAL});
+}
+
+std::expected<void, Error> Tree::Link(const Location &_location, std::shared_ptr<DirectoryEntry> _entry)
+{
+    DirectoryEntry &parent = *_location.parents.back();
+    {
+        const auto lock = std::lock_guard{ShardOf(parent)};
+        Directory &directory = std::get<Directory>(parent.body);
+        if( directory.removed )
+            return std::unexpected(Error{Error::POSIX, ENOENT});
+        if( !directory.entries.try_emplace(std::string(_location.name), std::move(_entry)).second )
+            return std::unexpected(Error{Error::POSIX, EEXIST});
+        parent.mtime = parent.ctime = Now();
+    }
+    Changed(parent);
+    return {};
+}
+
+std::expected<void, Error> Tree::CreateDirectory(std::string_view _path, uint16_t _mode)
+{
+    const std::expected<Location, Error> location = Locate(_path, EEXIST);
+    if( !location )
+        return std::unexpected(location.error());
+    return Link(*location, NewEntry(S_IFDIR | (_mode & ~S_IFMT)));
+}
+
+std::expected<void, Error> Tree::CreateSymlink(std::string_view _path, std::string_view _value)
+{
+    const std::expected<Location, Error> location = Locate(_path, EEXIST);
+    if( !location )
+        return std::unexpected(location.error());
+    auto entry = NewEntry(S_IFLNK | 0755);
+    std::get<Symlink>(entry->body).value = _value;
+    return Link(*location, std::move(entry));
+}
+
+std::expected<void, Error>
+Tree::CreateFile(std::string_view _path, uint16_t _mode, std::shared_ptr<const std::string> _data)
+{
+    const std::expected<Location, Error> location = Locate(_path, EISDIR);
+    if( !location )
+        return std::unexpected(location.error());
+
+    auto entry = NewEntry(S_IFREG | (_mode & ~S_IFMT));
+    std::get<Reg>(entry->body).data = _data ? std::move(_data) : EmptyBlob();
+
+    DirectoryEntry &parent = *location->parents.back();
+    {
+        const auto lock = std::lock_guard{ShardOf(parent)};
+        Directory &directory = std::get<Directory>(parent.body);
+        if( directory.removed )
+            return std::unexpected(Error{Error::POSIX, ENOENT});
+        auto [it, inserted] = directory.entries.try_emplace(std::string(location->name), entry);
+        if( !inserted ) {
+            if( IsDirectory(*it->second) )
+                return std::unexpected(Error{Error::POSIX, EISDIR});
+            it->second = std::move(entry);
+        }
+        parent.mtime = parent.ctime = Now();
+    }
+    Changed(parent);
+    return {};
+}
+
+std::expected<Tree::Chain, Error> Tree::Open(std::string_view _path, unsigned long _open_flags)
+{
+    std::expected<Chain, Error> chain = std::unexpected(Error{Error::POSIX, ENOENT});
+    if( _open_flags & VFSFlags::OF_Create ) {
+        std::expected<Location, Error> location = Locate(_path, EISDIR);
+        if( !location )
+            return std::unexpected(location.error());
+
+        DirectoryEntry &parent = *location->parents.back();
+        std::shared_ptr<DirectoryEntry> entry;
+        bool created = false;
+        {
+            const auto lock = std::lock_guard{ShardOf(parent)};
+            Directory &directory = std::get<Directory>(parent.body);
+            if( const auto it = directory.entries.find(location->name); it != directory.entries.end() ) {
+                if( _open_flags & VFSFlags::OF_NoExist )
+                    return std::unexpected(Error{Error::POSIX, EEXIST});
+                entry = it->second;
+            }
+            else {
+                if( directory.removed )
+                    return std::unexpected(Error{Error::POSIX, ENOENT});
+                entry = NewEntry(S_IFREG | (_open_flags & (S_IRWXU | S_IRWXG | S_IRWXO)));
+                directory.entries.emplace(std::string(location->name), entry);
+                parent.mtime = parent.ctime = Now();
+                created = true;
+            }
+        }
+        if( created )
+            Changed(parent);
+
+        if( IsSymlink(*entry) ) {
+            // existing symlinks are followed, but nothing is created at their targets
+            chain = Resolve(_path, true);
+        }
+        else {
+            chain = std::move(location->parents);
+            chain->push_back(std::move(entry));
+        }
+    }
+    else {
+        chain = Resolve(_path, true);
+    }
+
+    if( !chain )
+        return std::unexpected(chain.error());
+    DirectoryEntry &file = *chain->back();
+    if( IsDirectory(file) )
+        return std::unexpected(Error{Error::POSIX, EISDIR});
+
+    if( (_open_flags & VFSFlags::OF_Truncate) && (_open_flags & VFSFlags::OF_Write) ) {
+        const DirectoryEntry &parent = chain->size() > 1 ? *(*chain)[chain->size() - 2] : *m_Root;
+        Write(file, EmptyBlob(), parent);
+    }
+    return chain;
+}
+
+std::shared_ptr<const std::string> Tree::Read(const DirectoryEntry &_file) const
+{
+    const auto lock = std::shared_lock{ShardOf(_file)};
+    return std::get<Reg>(_file.body).data;
+}
+
+void Tree::Write(DirectoryEntry &_file, std::shared_ptr<const std::string> _data, const DirectoryEntry &_directory)
+{
+    {
+        const auto lock = std::lock_guard{ShardOf(_file)};
+        std::get<Reg>(_file.body).data = std::move(_data);
+        _file.mtime = _file.ctime = Now();
+    }
+    Changed(_directory);
+}
+
+std::expected<void, Error> Tree::Unlink(std::string_view _path)
+{
+    const std::expected<Location, Error> location = Locate(_path, EBUSY);
+    if( !location )
+        return std::unexpected(location.error());
+
+    DirectoryEntry &parent = *location->parents.back();
+    {
+        const auto lock = std::lock_guard{ShardOf(parent)};
+        Directory &directory = std::get<Directory>(parent.body);
+        const auto it = directory.entries.find(location->name);
+        if( it == directory.entries.end() )
+            return std::unexpected(Error{Error::POSIX, ENOENT});
+        if( IsDirectory(*it->second) )
+            return std::unexpected(Error{Error::POSIX, EPERM});
+        directory.entries.erase(it);
+        parent.mtime = parent.ctime = Now();
+    }
+    Changed(parent);
+    return {};
+}
+
+std::expected<void, Error> Tree::RemoveDirectory(std::string_view _path)
+{
+    const std::expected<Location, Error> location = Locate(_path, EBUSY);
+    if( !location )
+        return std::unexpected(location.error());
+
+    DirectoryEntry &parent = *location->parents.back();
+    while( true ) {
+        std::shared_ptr<DirectoryEntry> victim;
+        {
+            const auto lock = std::shared_lock{ShardOf(parent)};
+            const Directory &directory = std::get<Directory>(parent.body);
+            const auto it = directory.entries.find(location->name);
+            if( it == directory.entries.end() )
+                return std::unexpected(Error{Error::POSIX, ENOENT});
+            victim = it->second;
+        }
+        if( !IsDirectory(*victim) )
+            return std::unexpected(Error{Error::POSIX, ENOTDIR});
+
+        {
+            const ExclusiveLocks locks{&ShardOf(parent), &ShardOf(*victim)};
+            Directory &directory = std::get<Directory>(parent.body);
+            const auto it = directory.entries.find(location->name);
+            if( it == directory.entries.end() || it->second != victim )
+                continue; // has been changed in the meantime
+            Directory &victim_directory = std::get<Directory>(victim->body);
+            if( !victim_directory.entries.empty() )
+                return std::unexpected(Error{Error::POSIX, ENOTEMPTY});
+            victim_directory.removed = true;
+            directory.entries.erase(it);
+            parent.mtime = parent.ctime = Now();
+        }
+        Changed(parent);
+        return {};
+    }
+}
+
+std::expected<void, Error> Tree::Rename(std::string_view _old_path, std::string_view _new_path)
+{
+    const auto rename_lock = std::lock_guard{m_RenameLock};
+    const std::expected<Location, Error> from = Locate(_old_path, EBUSY);
+    if( !from )
+        return std::unexpected(from.error());
+    const std::expected<Location, Error> to = Locate(_new_path, EBUSY);
+    if( !to )
+        return std::unexpected(to.error());
+
+    DirectoryEntry &from_parent = *from->parents.back();
+    DirectoryEntry &to_parent = *to->parents.back();
+    while( true ) {
+        std::shared_ptr<DirectoryEntry> source;
+        {
+            const auto lock = std::shared_lock{ShardOf(from_parent)};
+            const Directory &directory = std::get<Directory>(from_parent.body);
+            const auto it = directory.entries.find(from->name);
+            if( it == directory.entries.end() )
+                return std::unexpected(Error{Error::POSIX, ENOENT});
+            source = it->second;
+        }
+        std::shared_ptr<DirectoryEntry> victim;
+        {
+            const auto lock = std::shared_lock{ShardOf(to_parent)};
+            const Directory &directory = std::get<Directory>(to_parent.body);
+            if( const auto it = directory.entries.find(to->name); it != directory.entries.end() )
+                victim = it->second;
+        }
+
+        if( victim == source )
+            return {};
+        if( IsDirectory(*source) ) {
+            if( std::ranges::find(to->parents, source) != to->parents.end() )
+                return std::unexpected(Error{Error::POSIX, EINVAL});
+            if( victim && !IsDirectory(*victim) )
+                return std::unexpected(Error{Error::POSIX, ENOTDIR});
+        }
+        else if( victim && IsDirectory(*victim) ) {
+            return std::unexpected(Error{Error::POSIX, EISDIR});
+        }
+
+        {
+            const bool victim_is_directory = victim && IsDirectory(*victim);
+            const ExclusiveLocks locks{
+                &ShardOf(from_parent), &ShardOf(to_parent), victim_is_directory ? &ShardOf(*victim) : nullptr};
+            Directory &from_directory = std::get<Directory>(from_parent.body);
+            Directory &to_directory = std::get<Directory>(to_parent.body);
+            const auto source_it = from_directory.entries.find(from->name);
+            if( source_it == from_directory.entries.end() || source_it->second != source )
+                continue; // has been changed in the meantime
+            const auto victim_it = to_directory.entries.find(to->name);
+            if( (victim_it == to_directory.entries.end() ? nullptr : victim_it->second) != victim )
+                continue; // has been changed in the meantime
+            if( to_directory.removed )
+                return std::unexpected(Error{Error::POSIX, ENOENT});
+            if( victim_is_directory ) {
+                Directory &victim_directory = std::get<Directory>(victim->body);
+                if( !victim_directory.entries.empty() )
+                    return std::unexpected(Error{Error::POSIX, ENOTEMPTY});
+                victim_directory.removed = true;
+            }
+            from_directory.entries.erase(source_it);
+            to_directory.entries.insert_or_assign(std::string(to->name), source);
+            from_parent.mtime = from_parent.ctime = to_parent.mtime = to_parent.ctime = Now();
+        }
+        Changed(from_parent);
+        if( &to_parent != &from_parent )
+            Changed(to_parent);
+        return {};
+    }
+}
+
+std::expected<void, Error>
+Tree::Change(std::string_view _path, bool _follow_last, const std::function<void(DirectoryEntry &_entry)> &_change)
+{
+    const std::expected<Chain, Error> chain = Resolve(_path, _follow_last);
+    if( !chain )
+        return std::unexpected(chain.error());
+
+    DirectoryEntry &entry = *chain->back();
+    {
+        const auto lock = std::lock_guard{ShardOf(entry)};
+        entry.ctime = Now();
+        _change(entry);
+    }
+    Changed(chain->size() > 1 ? *(*chain)[chain->size() - 2] : entry);
+    return {};
+}
+
+} // namespace nc::vfs::mem
@@ -1,27 +1,146 @@
-// Copyright (C) 2020-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2020-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
-#include <unordered_map>
-#include <variant>
-#include <string>
+#include <VFS/VFSDeclarations.h>
+#include <Base/Error.h>
+#include <Base/UnorderedUtil.h>
+#include <ankerl/unordered_dense.h>
+#include <array>
+#include <atomic>
+#include <expected>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 namespace nc::vfs::mem {
 
 struct DirectoryEntry;
 
 struct Directory {
-    std::unordered_map<std::string, std::shared_ptr<DirectoryEntry>> entries;
+    ankerl::unordered_dense::map<std::string,
+                                 std::shared_ptr<DirectoryEntry>,
+                                 UnorderedStringHashEqual,
+                                 UnorderedStringHashEqual>
+        entries;
+    bool removed = false; // nothing can be created inside once the directory was deleted
 };
 
 struct Reg {
+    // A published blob is never modified - writers build a new one and swap it in, so readers can keep a snapshot
+    // without copying and identical files can share the same blob.
+    std::shared_ptr<const std::string> data;
 };
 
 struct Symlink {
+    std::string value;
 };
 
+// The inode, the kind of the body and the value of a symlink never change once an entry is created.
 struct DirectoryEntry {
+    uint64_t inode = 0;
+    uint16_t mode = 0; // including the S_IFMT bits
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    uint32_t flags = 0;
+    timespec atime = {0, 0};
+    timespec mtime = {0, 0};
+    timespec ctime = {0, 0};
+    timespec btime = {0, 0};
     std::variant<Directory, Reg, Symlink> body;
 };
 
+// The filesystem tree. Every entry is guarded by the shard its inode maps to - that covers its attributes, its contents
+// and, for directories, the set of its children. Sequential inodes spread neighbouring entries across the shards, so
+// independent operations rarely contend. At most one shard is held at a time, except for the operations which have
+// to change two directories at once - these acquire their shards in the order of addresses.
+// All paths must be absolute, symlinks are followed in the middle of the paths.
+class Tree
+{
+public:
+    // Invoked after the contents or the attributes of the items in a directory were changed, outside of any locks.
+    using ChangeCallback = std::function<void(const DirectoryEntry &_directory)>;
+
+    // An entry along with its parents, the root goes first.
+    using Chain = std::vector<std::shared_ptr<DirectoryEntry>>;
+
+    struct Child {
+        std::string name;
+        std::shared_ptr<DirectoryEntry> entry;
+    };
+
+    Tree();
+
+    void SetChangeCallback(ChangeCallback _callback);
+
+    std::expected<Chain, Error> Resolve(std::string_view _path, bool _follow_last) const;
+
+    std::expected<VFSStat, Error> Stat(std::string_view _path, bool _follow_last) const;
+
+    VFSStat Stat(const DirectoryEntry &_entry) const;
+
+    // A snapshot of the directory's children in no particular order.
+    std::expected<std::vector<Child>, Error> List(std::string_view _path) const;
+
+    std::expected<std::string, Error> ReadSymlink(std::string_view _path) const;
+
+    std::expected<void, Error> CreateDirectory(std::string_view _path, uint16_t _mode);
+
+    std::expected<void, Error> CreateSymlink(std::string_view _path, std::string_view _value);
+
+    // Creates a regular file with the given contents, replacing an existing regular file if there's one.
+    // The blob is shared as is, so any amount of files can refer to the same data.
+    std::expected<void, Error>
+    CreateFile(std::string_view _path, uint16_t _mode, std::shared_ptr<const std::string> _data);
+
+    // Opens a regular file akin to open(), returns the file along with its parents.
+    std::expected<Chain, Error> Open(std::string_view _path, unsigned long _open_flags);
+
+    // Returns the current contents of a regular file.
+    std::shared_ptr<const std::string> Read(const DirectoryEntry &_file) const;
+
+    // Replaces the contents of a regular file which resides in _directory.
+    void Write(DirectoryEntry &_file, std::shared_ptr<const std::string> _data, const DirectoryEntry &_directory);
+
+    std::expected<void, Error> Unlink(std::string_view _path);
+
+    std::expected<void, Error> RemoveDirectory(std::string_view _path);
+
+    std::expected<void, Error> Rename(std::string_view _old_path, std::string_view _new_path);
+
+    // Applies _change to the attributes of an entry, symlinks are followed if _follow_last is true.
+    std::expected<void, Error>
+    Change(std::string_view _path, bool _follow_last, const std::function<void(DirectoryEntry &_entry)> &_change);
+
+private:
+    struct alignas(64) Shard {
+        std::shared_mutex lock;
+    };
+    static constexpr size_t ShardsCount = 64;
+
+    // The parents of an item and its name.
+    struct Location {
+        Chain parents;
+        std::string_view name;
+    };
+
+    class ExclusiveLocks;
+
+    std::shared_mutex &ShardOf(const DirectoryEntry &_entry) const noexcept;
+    std::expected<Location, Error> Locate(std::string_view _path, int _root_error) const;
+    std::shared_ptr<DirectoryEntry> NewEntry(uint16_t _mode);
+    std::expected<void, Error> Link(const Location &_location, std::shared_ptr<DirectoryEntry> _entry);
+    void Changed(const DirectoryEntry &_directory) const;
+
+    std::shared_ptr<DirectoryEntry> m_Root;
+    mutable std::array<Shard, ShardsCount> m_Shards;
+    std::atomic_uint64_t m_LastInode{0};
+    std::mutex m_RenameLock; // tree shape changes are serialized to reliably detect moving a directory into itself
+    ChangeCallback m_OnChange;
+};
+
 } // namespace nc::vfs::mem
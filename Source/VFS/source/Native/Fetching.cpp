@@ -1,4 +1,4 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Fetching.h"
 #include <sys/attr.h>
 #include <sys/errno.h>
@@ -8,6 +8,7 @@
 #include <RoutedIO/RoutedIO.h>
 #include <Utility/PathManip.h>
 #include <VFS/VFSError.h>
+#include <VFS/VFSListingInput.h>
 #include <sys/stat.h>
 #include <vector>
 
@@ -262,9 +263,25 @@ int Fetching::ReadDirAttributesStat(const int _dir_fd,
     return 0;
 }
 
-int Fetching::ReadDirAttributesBulk(const int _dir_fd,
-                                    const std::function<void(size_t _fetched_now)> &_cb_fetch,
-                                    const Callback &_cb_param)
+static void ResizeBulkColumns(ListingInput &_listing, Fetching::BulkExtras &_extras, size_t _size)
+{
+    _listing.filenames.resize(_size);
+    _listing.inodes.resize(_size);
+    _listing.unix_types.resize(_size);
+    _listing.atimes.resize(_size);
+    _listing.mtimes.resize(_size);
+    _listing.ctimes.resize(_size);
+    _listing.btimes.resize(_size);
+    _listing.unix_modes.resize(_size);
+    _listing.unix_flags.resize(_size);
+    _listing.uids.resize(_size);
+    _listing.gids.resize(_size);
+    _listing.sizes.resize(_size);
+    _extras.devs.resize(_size);
+    _extras.ext_flags.resize(_size);
+}
+
+int Fetching::ReadDirAttributesBulk(const int _dir_fd, ListingInput &_listing, BulkExtras &_extras)
 {
     attrlist attr_list;
     memset(&attr_list, 0, sizeof(attr_list));
@@ -279,10 +296,14 @@ int Fetching::ReadDirAttributesBulk(const int _dir_fd,
     // TODO: handle ENOTSUP
     //    getattrlist() will return ENOTSUP if it is not supported on a particular volume.
 
+    // A larger buffer means less syscalls on huge directories, ~1.5K entries fit into 256KB.
+    // The buffer is not zeroed since getattrlistbulk() overwrites the used part anyway.
     constexpr uint64_t options = FSOPT_ATTR_CMN_EXTENDED;
-    constexpr size_t attr_buf_size = 65536;
-    const std::unique_ptr<char[]> attr_buf = std::make_unique<char[]>(attr_buf_size);
-    CallbackParams params;
+    constexpr size_t attr_buf_size = 256 * 1024;
+    const std::unique_ptr<char[]> attr_buf = std::make_unique_for_overwrite<char[]>(attr_buf_size);
+
+    size_t next = _listing.filenames.size();
+    auto trim = at_scope_end([&] { ResizeBulkColumns(_listing, _extras, next); });
     while( true ) {
         const int retcount = getattrlistbulk(_dir_fd, &attr_list, &attr_buf[0], attr_buf_size, options);
         if( retcount < 0 )
@@ -291,7 +312,8 @@ int Fetching::ReadDirAttributesBulk(const int _dir_fd,
         if( retcount == 0 )
             return 0;
 
-        _cb_fetch(retcount);
+        if( next + retcount > _listing.filenames.size() )
+            ResizeBulkColumns(_listing, _extras, next + retcount);
 
         const char *entry_start = &attr_buf[0];
         for( int index = 0; index < retcount; index++ ) {
@@ -309,117 +331,122 @@ int Fetching::ReadDirAttributesBulk(const int _dir_fd,
             }
 
             if( returned.commonattr & ATTR_CMN_NAME ) {
-                params.filename = field + reinterpret_cast<const attrreference_t *>(field)->attr_dataoffset;
+                const auto name_ref = reinterpret_cast<const attrreference_t *>(field);
+                // attr_length includes the null terminator
+                _listing.filenames[next].assign(field + name_ref->attr_dataoffset,
+                                                name_ref->attr_length > 0 ? name_ref->attr_length - 1 : 0);
                 field += sizeof(attrreference_t);
             }
             else
                 continue; // can't work without filename
 
             if( returned.commonattr & ATTR_CMN_DEVID ) {
-                params.dev = *reinterpret_cast<const dev_t *>(field);
+                _extras.devs[next] = *reinterpret_cast<const dev_t *>(field);
                 field += sizeof(dev_t);
             }
+            else {
+                _extras.devs[next] = 0;
+            }
 
-            params.mode = 0;
+            mode_t mode = 0;
             if( returned.commonattr & ATTR_CMN_OBJTYPE ) {
-                params.mode = VNodeToUnixMode(*reinterpret_cast<const fsobj_type_t *>(field));
+                mode = VNodeToUnixMode(*reinterpret_cast<const fsobj_type_t *>(field));
                 field += sizeof(fsobj_type_t);
             }
 
             if( returned.commonattr & ATTR_CMN_CRTIME ) {
-                params.crt_time = reinterpret_cast<const struct timespec *>(field)->tv_sec;
+                _listing.btimes[next] = reinterpret_cast<const struct timespec *>(field)->tv_sec;
                 field += sizeof(timespec);
             }
             else {
-                params.crt_time = 0;
+                _listing.btimes[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_MODTIME ) {
-                params.mod_time = reinterpret_cast<const struct timespec *>(field)->tv_sec;
+                _listing.mtimes[next] = reinterpret_cast<const struct timespec *>(field)->tv_sec;
                 field += sizeof(timespec);
             }
             else {
-                params.mod_time = 0;
+                _listing.mtimes[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_CHGTIME ) {
-                params.chg_time = reinterpret_cast<const struct timespec *>(field)->tv_sec;
+                _listing.ctimes[next] = reinterpret_cast<const struct timespec *>(field)->tv_sec;
                 field += sizeof(timespec);
             }
             else {
-                params.chg_time = 0;
+                _listing.ctimes[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_ACCTIME ) {
-                params.acc_time = reinterpret_cast<const struct timespec *>(field)->tv_sec;
+                _listing.atimes[next] = reinterpret_cast<const struct timespec *>(field)->tv_sec;
                 field += sizeof(timespec);
             }
             else {
-                params.acc_time = 0;
+                _listing.atimes[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_OWNERID ) {
-                params.uid = *reinterpret_cast<const uid_t *>(field);
+                _listing.uids[next] = *reinterpret_cast<const uid_t *>(field);
                 field += sizeof(uid_t);
             }
             else {
-                params.uid = 0;
+                _listing.uids[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_GRPID ) {
-                params.gid = *reinterpret_cast<const gid_t *>(field);
+                _listing.gids[next] = *reinterpret_cast<const gid_t *>(field);
                 field += sizeof(gid_t);
             }
             else {
-                params.gid = 0;
+                _listing.gids[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_ACCESSMASK ) {
-                params.mode |= *reinterpret_cast<const u_int32_t *>(field) & (~S_IFMT);
+                mode |= *reinterpret_cast<const u_int32_t *>(field) & (~S_IFMT);
                 field += sizeof(u_int32_t);
             }
+            _listing.unix_modes[next] = mode;
+            _listing.unix_types[next] = IFTODT(mode);
 
             if( returned.commonattr & ATTR_CMN_FLAGS ) {
-                params.flags = *reinterpret_cast<const u_int32_t *>(field);
+                _listing.unix_flags[next] = *reinterpret_cast<const u_int32_t *>(field);
                 field += sizeof(u_int32_t);
             }
             else {
-                params.flags = 0;
+                _listing.unix_flags[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_FILEID ) {
-                params.inode = *reinterpret_cast<const u_int64_t *>(field);
+                _listing.inodes[next] = *reinterpret_cast<const u_int64_t *>(field);
                 field += sizeof(uint64_t);
             }
             else {
-                params.inode = 0;
+                _listing.inodes[next] = 0;
             }
 
             if( returned.commonattr & ATTR_CMN_ADDEDTIME ) {
-                params.add_time = reinterpret_cast<const struct timespec *>(field)->tv_sec;
+                _listing.add_times.insert(next, reinterpret_cast<const struct timespec *>(field)->tv_sec);
                 field += sizeof(timespec);
             }
-            else {
-                params.add_time = -1;
-            }
 
             if( returned.fileattr & ATTR_FILE_DATALENGTH ) {
-                params.size = *reinterpret_cast<const off_t *>(field);
+                _listing.sizes[next] = *reinterpret_cast<const off_t *>(field);
                 field += sizeof(off_t);
             }
             else {
-                params.size = -1;
+                _listing.sizes[next] = ListingInput::unknown_size;
             }
 
             if( returned.forkattr & ATTR_CMNEXT_EXT_FLAGS ) {
-                params.ext_flags = *reinterpret_cast<const uint64_t *>(field);
+                _extras.ext_flags[next] = *reinterpret_cast<const uint64_t *>(field);
                 field += sizeof(uint64_t);
             }
             else {
-                params.ext_flags = 0;
+                _extras.ext_flags[next] = 0;
             }
 
-            _cb_param(params);
+            ++next;
         }
     }
 }
@@ -1,14 +1,19 @@
-// Copyright (C) 2013-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2013-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <functional>
 #include <string_view>
+#include <vector>
 #include <sys/types.h>
 
 namespace nc::routedio {
 class PosixIOInterface;
 }
 
+namespace nc::vfs {
+struct ListingInput;
+}
+
 namespace nc::vfs::native {
 
 class Fetching
@@ -51,12 +56,23 @@ public:
                                      const Callback &_cb_param);
 
     /**
-     * the most performant way to fetch data
+     * Per-entry data which is fetched along with a listing but has no place in ListingInput.
+     */
+    struct BulkExtras {
+        std::vector<dev_t> devs;
+        std::vector<uint64_t> ext_flags; // EF_xxx
+    };
+
+    /**
+     * the most performant way to fetch data.
+     * Appends the directory entries right into the columns of _listing and _extras, starting from the current
+     * _listing.filenames.size(), without any per-entry callbacks.
+     * The columns are grown by getattrlistbulk() batches and are trimmed to the actual amount of entries at the end.
+     * Requires these columns to be dense: inodes, atimes, mtimes, ctimes, btimes, unix_flags, uids, gids, sizes.
+     * add_times can be either dense or sparse.
      * returns 0 on success or errno value on error
      */
-    static int ReadDirAttributesBulk(const int _dir_fd,
-                                     const std::function<void(size_t _fetched_now)> &_cb_fetch,
-                                     const Callback &_cb_param);
+    static int ReadDirAttributesBulk(int _dir_fd, ListingInput &_listing, BulkExtras &_extras);
 };
 
 } // namespace nc::vfs::native
@@ -52,6 +52,10 @@ public:
     bool IsDirectoryChangeObservationAvailable(std::string_view _path) override;
     HostDirObservationTicket ObserveDirectoryChanges(std::string_view _path, std::function<void()> _handler) override;
 
+    HostDirObservationTicket
+    ObserveDirectoryTreeChanges(std::string_view _path,
+                                std::function<void(std::string_view _directory)> _handler) override;
+
     void StopDirChangeObserving(unsigned long _ticket) override;
 
     FileObservationToken ObserveFileChanges(std::string_view _path, std::function<void()> _handler) override;
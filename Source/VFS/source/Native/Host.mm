@@ -109,7 +109,8 @@ std::expected<VFSListingPtr, Error> NativeHost::FetchDirectoryListing(std::strin
     listing_source.symlinks.reset(variable_container<>::type::sparse);
     listing_source.display_filenames.reset(variable_container<>::type::sparse);
 
-    std::vector<uint64_t> ext_flags; // store EF_xxx here
+    Fetching::BulkExtras extras; // devs and EF_xxx are stored here
+    auto &ext_flags = extras.ext_flags;
     constexpr size_t initial_prealloc_size = 64;
     size_t allocated_size = 0;
     auto resize_dense = [&](size_t _sz) {
@@ -125,13 +126,11 @@ std::expected<VFSListingPtr, Error> NativeHost::FetchDirectoryListing(std::strin
         listing_source.uids.resize(_sz);
         listing_source.gids.resize(_sz);
         listing_source.sizes.resize(_sz);
+        extras.devs.resize(_sz);
         ext_flags.resize(_sz);
         allocated_size = _sz;
     };
 
-    // allocate space for up to 64 items upfront
-    resize_dense(initial_prealloc_size);
-
     auto fill = [&](size_t _n, const Fetching::CallbackParams &_params) {
         assert(_n < listing_source.filenames.size());
         listing_source.filenames[_n] = _params.filename;
@@ -148,16 +147,7 @@ std::expected<VFSListingPtr, Error> NativeHost::FetchDirectoryListing(std::strin
         listing_source.sizes[_n] = _params.size;
         if( _params.add_time >= 0 )
             listing_source.add_times.insert(_n, _params.add_time);
-
-        if( _flags & VFSFlags::F_LoadDisplayNames )
-            if( S_ISDIR(listing_source.unix_modes[_n]) && !listing_source.filenames[_n].empty() &&
-                listing_source.filenames[_n] != ".." ) {
-                static auto &dnc = DisplayNamesCache::Instance();
-                if( auto display_name = dnc.DisplayName(
-                        _params.inode, _params.dev, listing_source.directories[0] + listing_source.filenames[_n]) )
-                    listing_source.display_filenames.insert(_n, std::string(*display_name));
-            }
-
+        extras.devs[_n] = _params.dev;
         ext_flags[_n] = _params.ext_flags;
     };
 
@@ -165,6 +155,7 @@ std::expected<VFSListingPtr, Error> NativeHost::FetchDirectoryListing(std::strin
     auto cb_param = [&](const Fetching::CallbackParams &_params) { fill(next_entry_index++, _params); };
 
     if( need_to_add_dot_dot ) {
+        resize_dense(1);
         Fetching::ReadSingleEntryAttributesByPath(io, path, cb_param);
         listing_source.filenames[0] = "..";
     }
@@ -176,11 +167,23 @@ std::expected<VFSListingPtr, Error> NativeHost::FetchDirectoryListing(std::strin
     };
 
     // when Admin Mode is on - we use different fetch route
-    const int ret =
-        is_native_io ? Fetching::ReadDirAttributesBulk(fd, cb_fetch, cb_param)
-                     : Fetching::ReadDirAttributesStat(fd, listing_source.directories[0].c_str(), cb_fetch, cb_param);
-    if( ret != 0 )
-        return std::unexpected(Error{Error::POSIX, ret});
+    if( is_native_io ) {
+        // the bulk route fills the columns by itself, without going through the callbacks
+        resize_dense(next_entry_index);
+        const int ret = Fetching::ReadDirAttributesBulk(fd, listing_source, extras);
+        if( ret != 0 )
+            return std::unexpected(Error{Error::POSIX, ret});
+        next_entry_index = allocated_size = listing_source.filenames.size();
+    }
+    else {
+        // allocate space for up to 64 items upfront
+        if( allocated_size < initial_prealloc_size )
+            resize_dense(initial_prealloc_size);
+        const int ret =
+            Fetching::ReadDirAttributesStat(fd, listing_source.directories[0].c_str(), cb_fetch, cb_param);
+        if( ret != 0 )
+            return std::unexpected(Error{Error::POSIX, ret});
+    }
 
     if( _cancel_checker && _cancel_checker() )
         return std::unexpected(Error{Error::POSIX, ECANCELED});
@@ -189,6 +192,18 @@ std::expected<VFSListingPtr, Error> NativeHost::FetchDirectoryListing(std::strin
     if( next_entry_index < allocated_size )
         resize_dense(next_entry_index);
 
+    if( _flags & VFSFlags::F_LoadDisplayNames ) {
+        static auto &dnc = DisplayNamesCache::Instance();
+        for( size_t n = 0; n < next_entry_index; ++n )
+            if( S_ISDIR(listing_source.unix_modes[n]) && !listing_source.filenames[n].empty() &&
+                listing_source.filenames[n] != ".." ) {
+                if( auto display_name = dnc.DisplayName(listing_source.inodes[n],
+                                                        extras.devs[n],
+                                                        listing_source.directories[0] + listing_source.filenames[n]) )
+                    listing_source.display_filenames.insert(n, std::string(*display_name));
+            }
+    }
+
     // a little more work with symlinks, if there are any
     for( size_t n = 0; n < next_entry_index; ++n )
         if( listing_source.unix_types[n] == DT_LNK ) {
@@ -491,6 +506,15 @@ HostDirObservationTicket NativeHost::ObserveDirectoryChanges(std::string_view _p
     return t ? HostDirObservationTicket(t, shared_from_this()) : HostDirObservationTicket();
 }
 
+HostDirObservationTicket
+NativeHost::ObserveDirectoryTreeChanges(std::string_view _path,
+                                        std::function<void(std::string_view _directory)> _handler)
+{
+    auto &inst = nc::utility::FSEventsDirUpdate::Instance();
+    const uint64_t t = inst.AddTreeWatchPath(_path, std::move(_handler));
+    return t ? HostDirObservationTicket(t, shared_from_this()) : HostDirObservationTicket();
+}
+
 void NativeHost::StopDirChangeObserving(unsigned long _ticket)
 {
     auto &inst = nc::utility::FSEventsDirUpdate::Instance();
@@ -1,11 +1,30 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Cache.h"
+#include "../BinarySerialization.h"
 #include <VFS/Log.h>
+#include <Base/mach_time.h>
+#include <Base/WriteAtomically.h>
 #include <algorithm>
+#include <array>
 #include <filesystem>
+#include <fstream>
+#include <iterator>
 
 namespace nc::vfs::ftp {
 
+// The listings older than this are served from the cache while being refreshed in background.
+static constexpr auto g_ListingRevalidationAge = std::chrono::seconds{60};
+
+namespace {
+
+constexpr char g_Magic[8] = {'N', 'C', 'F', 'T', 'P', 'L', 'S', 'T'};
+constexpr uint32_t g_Version = 1;
+
+// The restored listings older than this are not worth showing.
+constexpr auto g_PersistedListingLifetime = std::chrono::days{7};
+
+} // namespace
+
 Entry::Entry(const std::string &_name) : name(_name)
 {
 }
@@ -25,6 +44,11 @@ void Entry::ToStat(VFSStat &_stat) const
     _stat.meaning.mtime = _stat.meaning.ctime = _stat.meaning.btime = _stat.meaning.atime = 1;
 }
 
+bool Directory::IsStale() const noexcept
+{
+    return restored || base::machtime() - fetch_time > g_ListingRevalidationAge;
+}
+
 const Entry *Directory::EntryByName(const std::string &_name) const
 {
     auto i = std::ranges::find_if(entries, [&](auto &_e) { return _e.name == _name; });
@@ -75,6 +99,8 @@ void Cache::InsertLISTDirectory(const char *_path, std::shared_ptr<Directory> _d
         dir.push_back('/');
 
     _directory->path = dir;
+    _directory->fetch_time = base::machtime();
+    _directory->fetch_wall_time = std::time(nullptr);
 
     const std::lock_guard<std::mutex> lock(m_CacheLock);
 
@@ -208,6 +234,9 @@ void Cache::CommitRename(const std::string &_old_path, const std::string &_new_p
         copy->path = dir->path;
         copy->dirty_structure = dir->dirty_structure;
         copy->has_dirty_items = dir->has_dirty_items;
+        copy->restored = dir->restored;
+        copy->fetch_time = dir->fetch_time;
+        copy->fetch_wall_time = dir->fetch_wall_time;
 
         for( auto &i : dir->entries )
             if( i.name != old_path.filename() ) {
@@ -274,6 +303,9 @@ void Cache::EraseEntryInt(std::string_view _path)
         copy->path = dir->path;
         copy->dirty_structure = dir->dirty_structure;
         copy->has_dirty_items = dir->has_dirty_items;
+        copy->restored = dir->restored;
+        copy->fetch_time = dir->fetch_time;
+        copy->fetch_wall_time = dir->fetch_wall_time;
 
         for( auto &i : dir->entries )
             if( i.name != p.filename() )
@@ -283,6 +315,93 @@ void Cache::EraseEntryInt(std::string_view _path)
     m_Callback(dir_path.native());
 }
 
+bool Cache::Save(const std::filesystem::path &_path) const
+{
+    BinaryWriter writer;
+    writer.Put(g_Magic);
+    writer.Put(g_Version);
+    {
+        const std::lock_guard<std::mutex> lock(m_CacheLock);
+        const auto is_clean = [](const Directory &_dir) { return !_dir.dirty_structure && !_dir.has_dirty_items; };
+        const auto clean = std::ranges::count_if(m_Directories, [&](auto &_dir) { return is_clean(*_dir.second); });
+        writer.Put(static_cast<uint32_t>(clean));
+        for( const auto &[path, dir] : m_Directories ) {
+            if( !is_clean(*dir) )
+                continue;
+            writer.PutString(path);
+            writer.Put(static_cast<int64_t>(dir->fetch_wall_time));
+            writer.Put(static_cast<uint32_t>(dir->entries.size()));
+            for( const auto &entry : dir->entries ) {
+                writer.PutString(entry.name);
+                writer.Put(static_cast<uint64_t>(entry.size));
+                writer.Put(static_cast<int64_t>(entry.time));
+                writer.Put(static_cast<uint32_t>(entry.mode));
+            }
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(_path.parent_path(), ec);
+    return base::WriteAtomically(_path, writer.Bytes());
+}
+
+bool Cache::Load(const std::filesystem::path &_path)
+{
+    std::ifstream in(_path, std::ios::binary);
+    if( !in )
+        return false;
+    const std::vector<char> contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    BinaryReader reader({reinterpret_cast<const std::byte *>(contents.data()), contents.size()});
+
+    const auto magic = reader.Get<std::array<char, sizeof(g_Magic)>>();
+    if( !std::equal(magic.begin(), magic.end(), std::begin(g_Magic)) || reader.Get<uint32_t>() != g_Version )
+        return false;
+
+    const time_t oldest = std::time(nullptr) - std::chrono::seconds(g_PersistedListingLifetime).count();
+    std::vector<std::shared_ptr<Directory>> restored;
+    const uint32_t directories = reader.Get<uint32_t>();
+    for( uint32_t i = 0; i < directories && !reader.Failed(); ++i ) {
+        auto dir = std::make_shared<Directory>();
+        dir->path = reader.GetString();
+        dir->fetch_wall_time = reader.Get<int64_t>();
+        dir->restored = true;
+        const uint32_t entries = reader.Get<uint32_t>();
+        for( uint32_t j = 0; j < entries && !reader.Failed(); ++j ) {
+            Entry entry(reader.GetString());
+            entry.size = reader.Get<uint64_t>();
+            entry.time = static_cast<time_t>(reader.Get<int64_t>());
+            entry.mode = static_cast<mode_t>(reader.Get<uint32_t>());
+            if( entry.name.empty() || entry.name.find('/') != std::string::npos )
+                return false;
+            dir->entries.emplace_back(std::move(entry));
+        }
+        if( dir->path.empty() || dir->path.front() != '/' || dir->path.back() != '/' )
+            return false;
+        if( dir->fetch_wall_time < oldest )
+            continue;
+        restored.emplace_back(std::move(dir));
+    }
+    if( reader.Failed() )
+        return false;
+
+    const std::lock_guard<std::mutex> lock(m_CacheLock);
+    for( auto &dir : restored )
+        m_Directories.try_emplace(dir->path, dir); // the listings fetched meanwhile are fresher
+    return true;
+}
+
+bool Cache::BeginRevalidation(std::string_view _path)
+{
+    const std::lock_guard<std::mutex> lock(m_CacheLock);
+    return m_Revalidating.emplace(std::string(_path)).second;
+}
+
+void Cache::EndRevalidation(std::string_view _path)
+{
+    const std::lock_guard<std::mutex> lock(m_CacheLock);
+    m_Revalidating.erase(_path);
+}
+
 void Cache::SetChangesCallback(std::function<void(const std::string &_at_dir)> _handler)
 {
     m_Callback = std::move(_handler);
@@ -1,4 +1,4 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <curl/curl.h>
@@ -9,6 +9,8 @@
 #include <Base/CFPtr.h>
 #include <string_view>
 #include <functional>
+#include <chrono>
+#include <filesystem>
 
 namespace nc::vfs::ftp {
 
@@ -33,12 +35,19 @@ struct Directory {
 
     bool dirty_structure = false; // true when there're mismatching between this cache and ftp server
     bool has_dirty_items = false;
+    bool restored = false; // loaded from a file and not yet refreshed
+
+    std::chrono::nanoseconds fetch_time = std::chrono::nanoseconds{0}; // machtime
+    time_t fetch_wall_time = 0;
 
     inline bool IsOutdated() const
     {
         return dirty_structure; // || (GetTimeInNanoseconds() > snapshot_time + g_ListingOutdateLimit);
     }
 
+    // Tells whether the listing can still be shown but is worth refreshing in background.
+    bool IsStale() const noexcept;
+
     const Entry *EntryByName(const std::string &_name) const;
 };
 
@@ -93,14 +102,34 @@ public:
      */
     void CommitRename(const std::string &_old_path, const std::string &_new_path);
 
+    /**
+     * Persists the clean listings into a file, which allows a subsequent connection to show them right away.
+     */
+    bool Save(const std::filesystem::path &_path) const;
+
+    /**
+     * Restores the listings saved by Save() as stale ones. A missing or malformed file is ignored.
+     */
+    bool Load(const std::filesystem::path &_path);
+
+    /**
+     * Registers a background refresh of the directory at _path.
+     * Returns false if there's one already running.
+     */
+    bool BeginRevalidation(std::string_view _path);
+
+    void EndRevalidation(std::string_view _path);
+
 private:
     using DirectoriesT = ankerl::unordered_dense::
         map<std::string, std::shared_ptr<Directory>, UnorderedStringHashEqual, UnorderedStringHashEqual>;
+    using PathsT = ankerl::unordered_dense::set<std::string, UnorderedStringHashEqual, UnorderedStringHashEqual>;
 
     std::shared_ptr<Directory> FindDirectoryInt(std::string_view _path) const noexcept;
     void EraseEntryInt(std::string_view _path);
 
     DirectoriesT m_Directories; // "/Abra/Cadabra/" -> Directory
+    PathsT m_Revalidating;      // the directories being refreshed in background
 
     mutable std::mutex m_CacheLock;
     std::function<void(const std::string &_at_dir)> m_Callback;
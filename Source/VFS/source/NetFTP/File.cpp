@@ -8,9 +8,122 @@
 #include <VFS/Log.h>
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <thread>
 
 namespace nc::vfs::ftp {
 
+// A pause before connecting again after the server refused a connection.
+static constexpr auto g_RefusalPause = std::chrono::milliseconds{100};
+
+namespace {
+
+// Fetches ranges of a file with retrievals starting at REST offsets, over a connection taken from the host's pool.
+// Fails with VFSError::FromErrno(ECONNREFUSED) if the server turns the connection down.
+class RangeFetcher final : public SegmentedDownload::Fetcher
+{
+public:
+    RangeFetcher(std::shared_ptr<FTPHost> _host, std::filesystem::path _dir, std::string _url);
+    ~RangeFetcher() override;
+    int Fetch(uint64_t _offset, uint64_t _length, const Sink &_sink) override;
+
+private:
+    int Retrieve(uint64_t _offset, uint64_t _length, const Sink &_sink);
+    static size_t Write(const void *_src, size_t _size, size_t _nmemb, void *_this);
+
+    std::shared_ptr<FTPHost> m_Host;
+    std::filesystem::path m_Dir;
+    std::string m_URL;
+    std::unique_ptr<CURLInstance> m_CURL;
+    const Sink *m_Sink = nullptr;
+    uint64_t m_Left = 0;
+    bool m_Cancelled = false;
+};
+
+// Tells whether the server didn't let a connection in. The servers capping the number of connections per client
+// greet the ones beyond the limit with a 421 reply, which curl reports as a timeout, some of them deny the login
+// instead.
+bool IsRefusal(CURLcode _rc, long _reply_code) noexcept
+{
+    return _reply_code == 421 || _rc == CURLE_COULDNT_CONNECT || _rc == CURLE_FTP_WEIRD_SERVER_REPLY ||
+           _rc == CURLE_LOGIN_DENIED;
+}
+
+} // namespace
+
+RangeFetcher::RangeFetcher(std::shared_ptr<FTPHost> _host, std::filesystem::path _dir, std::string _url)
+    : m_Host(std::move(_host)), m_Dir(std::move(_dir)), m_URL(std::move(_url)),
+      m_CURL(m_Host->InstanceForIOAtDir(m_Dir))
+{
+}
+
+RangeFetcher::~RangeFetcher()
+{
+    m_Host->CommitIOInstanceAtDir(m_Dir, std::move(m_CURL));
+}
+
+int RangeFetcher::Fetch(uint64_t _offset, uint64_t _length, const Sink &_sink)
+{
+    Log::Trace("RangeFetcher::Fetch({}, {}) called", _offset, _length);
+
+    // curl closes the connection after retrieving a range and the server might keep counting it for a moment, so a
+    // refusal is taken for granted only once it repeats
+    const int rc = Retrieve(_offset, _length, _sink);
+    if( rc != VFSError::FromErrno(ECONNREFUSED) )
+        return rc;
+    std::this_thread::sleep_for(g_RefusalPause);
+    return Retrieve(_offset, _length, _sink);
+}
+
+int RangeFetcher::Retrieve(uint64_t _offset, uint64_t _length, const Sink &_sink)
+{
+    if( m_CURL->IsAttached() )
+        m_CURL->Detach();
+
+    char range[64];
+    *fmt::format_to(range, "{}-{}", _offset, _offset + _length - 1) = 0;
+    m_CURL->EasySetOpt(CURLOPT_URL, m_URL.c_str());
+    m_CURL->EasySetOpt(CURLOPT_WRITEFUNCTION, Write);
+    m_CURL->EasySetOpt(CURLOPT_WRITEDATA, this);
+    m_CURL->EasySetOpt(CURLOPT_UPLOAD, 0l);
+    m_CURL->EasySetOpt(CURLOPT_LOW_SPEED_LIMIT, 1l);
+    m_CURL->EasySetOpt(CURLOPT_LOW_SPEED_TIME, 60l);
+    m_CURL->EasySetOpt(CURLOPT_RANGE, range); // REST _offset, the transfer is cut once the range was received
+
+    m_Sink = &_sink;
+    m_Left = _length;
+    m_Cancelled = false;
+    m_CURL->Attach(); // performing via the instance's multi handle reuses the connection pooled along with it
+    const CURLcode rc = m_CURL->PerformMulti();
+    m_CURL->EasySetOpt(CURLOPT_RANGE, nullptr);
+    long reply_code = 0;
+    curl_easy_getinfo(m_CURL->curl, CURLINFO_RESPONSE_CODE, &reply_code);
+
+    if( m_Cancelled )
+        return VFSError::Cancelled;
+    if( rc != CURLE_OK ) {
+        Log::Warn("Failed to fetch a range of '{}', curl code {}", m_URL, std::to_underlying(rc));
+        if( m_Left == _length && IsRefusal(rc, reply_code) )
+            return VFSError::FromErrno(ECONNREFUSED);
+        return CURLErrorToVFSError(rc);
+    }
+    return m_Left == 0 ? VFSError::Ok : VFSError::UnexpectedEOF;
+}
+
+size_t RangeFetcher::Write(const void *_src, size_t _size, size_t _nmemb, void *_this)
+{
+    auto &me = *static_cast<RangeFetcher *>(_this);
+    const size_t size = _size * _nmemb;
+    const size_t useful = static_cast<size_t>(std::min<uint64_t>(size, me.m_Left));
+    if( useful > 0 && !(*me.m_Sink)(_src, useful) ) {
+        me.m_Cancelled = true;
+        return 0; // makes curl abort the transfer
+    }
+    me.m_Left -= useful;
+    return size;
+}
+
 File::File(std::string_view _relative_path, std::shared_ptr<FTPHost> _host) : VFSFile(_relative_path, _host)
 {
     Log::Trace("File::File({}, {}) called", _relative_path, static_cast<void *>(_host.get()));
@@ -36,6 +149,7 @@ int File::Close()
         FinishWriting();
         std::dynamic_pointer_cast<FTPHost>(Host())->Cache().CommitNewFile(Path());
     }
+    m_Download.reset();
     if( m_CURL && m_Mode == Mode::Read ) {
         // if we're still reading something - cancel it and wait
         FinishReading();
@@ -81,6 +195,8 @@ int File::Open(unsigned long _open_flags, const VFSCancelChecker &_cancel_checke
 
         if( ReadChunk(nullptr, 1, 0, _cancel_checker) == 1 ) {
             m_Mode = Mode::Read;
+            if( const unsigned workers = SegmentedDownload::WorkersFor(m_FileSize); workers != 0 )
+                StartSegmentedDownload(workers);
             return 0;
         }
 
@@ -227,12 +343,44 @@ ssize_t File::ReadChunk(void *_read_to, uint64_t _read_size, uint64_t _file_offs
     return size;
 }
 
+void File::StartSegmentedDownload(unsigned _workers)
+{
+    Log::Trace("File::StartSegmentedDownload({}) called", _workers);
+
+    // the probing retrieval is not needed anymore, its connection can serve one of the workers instead
+    FinishReading();
+    auto host = std::dynamic_pointer_cast<FTPHost>(Host());
+    host->CommitIOInstanceAtDir(DirName(), std::move(m_CURL));
+    m_ReadBuf.Clear();
+    m_BufFileOffset = 0;
+
+    m_Download = std::make_unique<SegmentedDownload>(
+        m_FileSize, _workers, [host, dir = DirName(), url = m_URLRequest] {
+            return std::make_unique<RangeFetcher>(host, dir, url);
+        });
+}
+
 ssize_t File::Read(void *_buf, size_t _size)
 {
     Log::Trace("File::Read({}, {}) called", _buf, _size);
     if( Eof() )
         return 0;
 
+    if( m_Download ) {
+        const ssize_t ret = m_Download->Read(m_FilePos, _buf, _size);
+        if( ret == VFSError::FromErrno(ECONNREFUSED) ) {
+            // the server doesn't allow even one extra connection, so read the rest of this file over a single stream
+            m_Download.reset();
+            m_CURL = std::dynamic_pointer_cast<FTPHost>(Host())->InstanceForIOAtDir(DirName());
+        }
+        else {
+            if( ret < 0 )
+                return ret;
+            m_FilePos += ret;
+            return ret;
+        }
+    }
+
     const ssize_t ret = ReadChunk(_buf, _size, m_FilePos, nullptr);
     if( ret < 0 )
         return ret;
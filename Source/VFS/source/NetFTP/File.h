@@ -1,9 +1,10 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <VFS/VFSFile.h>
 #include "InternalsForward.h"
 #include "Internals.h"
+#include "../SegmentedDownload.h"
 #include <filesystem>
 
 namespace nc::vfs::ftp {
@@ -35,12 +36,14 @@ private:
     };
 
     ssize_t ReadChunk(void *_read_to, uint64_t _read_size, uint64_t _file_offset, VFSCancelChecker _cancel_checker);
+    void StartSegmentedDownload(unsigned _workers);
 
     std::filesystem::path DirName() const;
     void FinishWriting();
     void FinishReading();
 
     std::unique_ptr<CURLInstance> m_CURL;
+    std::unique_ptr<SegmentedDownload> m_Download; // used instead of m_CURL to read large files, unless refused
     ReadBuffer m_ReadBuf;
     uint64_t m_BufFileOffset = 0; // offset of ReadBuf within the file
     WriteBuffer m_WriteBuf;
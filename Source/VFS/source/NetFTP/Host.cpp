@@ -5,6 +5,9 @@
 #include "Internals.h"
 #include "Cache.h"
 #include "File.h"
+#include "MLSDParser.h"
+#include <Base/dispatch_cpp.h>
+#include <Base/Hash.h>
 #include <sys/dirent.h>
 #include <sys/stat.h>
 #include <fmt/format.h>
@@ -19,6 +22,18 @@ using namespace std::literals;
 
 const char *FTPHost::UniqueTag = "net_ftp";
 
+static ConnectionPool<CURLInstance>::Options IOInstancesOptions() noexcept
+{
+    ConnectionPool<CURLInstance>::Options options;
+    // the instances are released from the pool for the whole operations, so this caps only the idle ones
+    options.max_connections = 8;
+    options.max_wait = std::chrono::seconds{10};
+    options.idle_timeout = std::chrono::minutes{5};
+    // FTP servers usually drop the control connections idle for a few minutes
+    options.ping_interval = std::chrono::seconds{60};
+    return options;
+}
+
 class VFSNetFTPHostConfiguration
 {
 public:
@@ -43,7 +58,35 @@ public:
     [[nodiscard]] const char *VerboseJunction() const { return verbose.c_str(); }
 };
 
-FTPHost::~FTPHost() = default;
+[[clang::no_destroy]] static std::mutex g_ListingCacheDirectoryLock;
+[[clang::no_destroy]] static std::filesystem::path g_ListingCacheDirectory;
+
+static std::filesystem::path ListingCachePath(const VFSNetFTPHostConfiguration &_config)
+{
+    std::filesystem::path directory;
+    {
+        const auto lock = std::lock_guard{g_ListingCacheDirectoryLock};
+        directory = g_ListingCacheDirectory;
+    }
+    if( directory.empty() )
+        return {};
+
+    const std::string key = fmt::format("{}@{}:{}", _config.user, _config.server_url, _config.port);
+    auto digest = base::Hash(base::Hash::XXH3_128).Feed(key.data(), key.size()).Final();
+    return directory / (base::Hash::Hex(digest) + ".ncftpcache");
+}
+
+FTPHost::~FTPHost()
+{
+    if( !m_CachePath.empty() )
+        m_Cache->Save(m_CachePath);
+}
+
+void FTPHost::SetListingCacheDirectory(const std::filesystem::path &_directory)
+{
+    const auto lock = std::lock_guard{g_ListingCacheDirectoryLock};
+    g_ListingCacheDirectory = _directory;
+}
 
 static VFSConfiguration ComposeConfiguration(const std::string &_serv_url,
                                              const std::string &_user,
@@ -70,7 +113,8 @@ FTPHost::FTPHost(const std::string &_serv_url,
                  long _port,
                  bool _active)
     : Host(_serv_url, nullptr, UniqueTag), m_Cache(std::make_unique<ftp::Cache>()),
-      m_Configuration(ComposeConfiguration(_serv_url, _user, _passwd, _start_dir, _port, _active))
+      m_Configuration(ComposeConfiguration(_serv_url, _user, _passwd, _start_dir, _port, _active)),
+      m_IOInstances(IOInstancesOptions(), IOInstancesTraits())
 {
     const int rc = DoInit();
     if( rc < 0 )
@@ -79,7 +123,8 @@ FTPHost::FTPHost(const std::string &_serv_url,
 
 FTPHost::FTPHost(const VFSConfiguration &_config)
     : Host(_config.Get<VFSNetFTPHostConfiguration>().server_url, nullptr, UniqueTag),
-      m_Cache(std::make_unique<ftp::Cache>()), m_Configuration(_config)
+      m_Cache(std::make_unique<ftp::Cache>()), m_Configuration(_config),
+      m_IOInstances(IOInstancesOptions(), IOInstancesTraits())
 {
     const int rc = DoInit();
     if( rc < 0 )
@@ -114,6 +159,11 @@ int FTPHost::DoInit()
         InformDirectoryChanged(_at_dir.back() == '/' ? _at_dir : _at_dir + "/");
     });
 
+    m_CachePath = ListingCachePath(Config());
+    if( !m_CachePath.empty() )
+        m_Cache->Load(m_CachePath);
+
+    // the starting directory is always fetched synchronously, which also validates the credentials
     auto instance = SpawnCURL();
 
     const int result = DownloadAndCacheListing(instance.get(), Config().start_dir.c_str(), nullptr, nullptr);
@@ -125,6 +175,14 @@ int FTPHost::DoInit()
     return result;
 }
 
+// Tells whether a refreshed listing brings no news, i.e. the observers don't need to reload it.
+static bool SameEntries(const Directory &_lhs, const Directory &_rhs) noexcept
+{
+    return std::ranges::equal(_lhs.entries, _rhs.entries, [](const Entry &_1st, const Entry &_2nd) {
+        return _1st.name == _2nd.name && _1st.size == _2nd.size && _1st.time == _2nd.time && _1st.mode == _2nd.mode;
+    });
+}
+
 int FTPHost::DownloadAndCacheListing(CURLInstance *_inst,
                                      const char *_path,
                                      std::shared_ptr<Directory> *_cached_dir,
@@ -135,14 +193,28 @@ int FTPHost::DownloadAndCacheListing(CURLInstance *_inst,
         return VFSError::InvalidCall;
 
     std::string listing_data;
-    const int result = DownloadListing(_inst, _path, listing_data, _cancel_checker);
-    if( result != 0 )
-        return result;
+    std::shared_ptr<Directory> dir;
+    if( !m_MLSDUnsupported ) {
+        if( DownloadListing(_inst, _path, "MLSD", listing_data, _cancel_checker) == 0 )
+            dir = ParseMLSDListing(listing_data);
+        if( _cancel_checker && _cancel_checker() )
+            return VFSError::Cancelled;
+    }
+
+    if( !dir ) {
+        const int result = DownloadListing(_inst, _path, nullptr, listing_data, _cancel_checker);
+        if( result != 0 )
+            return result;
+        if( !m_MLSDUnsupported.exchange(true) )
+            Log::Info("The server didn't provide an MLSD listing, falling back to LIST");
+        dir = ParseListing(listing_data.c_str());
+    }
 
-    auto dir = ParseListing(listing_data.c_str());
+    const std::string path = EnsureTrailingSlash(std::string(_path));
+    const auto previous = m_Cache->FindDirectory(path);
     m_Cache->InsertLISTDirectory(_path, dir);
-    std::string path = _path;
-    InformDirectoryChanged(path.back() == '/' ? path : path + "/");
+    if( !previous || previous->IsOutdated() || previous->has_dirty_items || !SameEntries(*previous, *dir) )
+        InformDirectoryChanged(path);
 
     if( _cached_dir )
         *_cached_dir = dir;
@@ -152,10 +224,14 @@ int FTPHost::DownloadAndCacheListing(CURLInstance *_inst,
 
 int FTPHost::DownloadListing(CURLInstance *_inst,
                              const char *_path,
+                             const char *_command,
                              std::string &_buffer,
                              const VFSCancelChecker &_cancel_checker) const
 {
-    Log::Trace("FTPHost::DownloadListing({}, {}) called", static_cast<void *>(_inst), _path);
+    Log::Trace("FTPHost::DownloadListing({}, {}, {}) called",
+               static_cast<void *>(_inst),
+               _path,
+               _command ? _command : "LIST");
     if( _path == nullptr || _path[0] != '/' )
         return VFSError::InvalidCall;
 
@@ -171,6 +247,7 @@ int FTPHost::DownloadListing(CURLInstance *_inst,
     _inst->EasySetOpt(CURLOPT_URL, request.c_str());
     _inst->EasySetOpt(CURLOPT_WRITEFUNCTION, CURLWriteDataIntoString);
     _inst->EasySetOpt(CURLOPT_WRITEDATA, &response);
+    _inst->EasySetOpt(CURLOPT_CUSTOMREQUEST, _command);
     _inst->EasySetupProgFunc();
     _inst->prog_func = ^(curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
       if( _cancel_checker == nil )
@@ -180,6 +257,7 @@ int FTPHost::DownloadListing(CURLInstance *_inst,
 
     const CURLcode result = _inst->PerformEasy();
     _inst->EasyClearProgFunc();
+    _inst->EasySetOpt(CURLOPT_CUSTOMREQUEST, static_cast<const char *>(nullptr));
     _inst->call_lock.unlock();
 
     Log::Trace("CURLcode = {}", std::to_underlying(result));
@@ -255,7 +333,11 @@ FTPHost::Stat(std::string_view _path, unsigned long _flags, const VFSCancelCheck
             auto entry = dir->EntryByName(filename);
             if( entry ) {
                 Log::Trace("found an entry for '{}', outdated={}", filename, entry->dirty);
-                if( !entry->dirty ) { // if entry is here and it's not outdated - return it
+                // if entry is here and it's not outdated - return it, unless it was restored from disk: a restored
+                // listing is fine to show, but not to take e.g. the size of a file being opened from it
+                if( !entry->dirty && !dir->restored ) {
+                    if( dir->IsStale() )
+                        RevalidateInBackground(parent_dir.native());
                     VFSStat st;
                     entry->ToStat(st);
                     return st;
@@ -264,7 +346,8 @@ FTPHost::Stat(std::string_view _path, unsigned long _flags, const VFSCancelCheck
             }
             else {
                 Log::Trace("didn't find an entry for '{}'", filename);
-                if( !dir->IsOutdated() ) { // if we can't find entry and dir is not outdated - return NotFound.
+                // if we can't find entry and dir is neither outdated nor restored from disk - return NotFound.
+                if( !dir->IsOutdated() && !dir->restored ) {
                     return std::unexpected(VFSError::ToError(VFSError::NotFound));
                 }
             }
@@ -351,6 +434,9 @@ int FTPHost::GetListingForFetching(CURLInstance *_inst,
 
     auto dir = m_Cache->FindDirectory(path.native());
     if( dir && !dir->IsOutdated() && !dir->has_dirty_items ) {
+        // show the cached listing right away, observers are informed once a refresh brings any news
+        if( dir->IsStale() )
+            RevalidateInBackground(path.native());
         _cached_dir = dir;
         return 0;
     }
@@ -625,43 +711,88 @@ FTPHost::IterateDirectoryListing(std::string_view _path, const std::function<boo
     return {};
 }
 
+void FTPHost::RevalidateInBackground(const std::string &_path)
+{
+    if( !m_Cache->BeginRevalidation(_path) )
+        return;
+
+    Log::Trace("FTPHost::RevalidateInBackground({}) called", _path);
+    dispatch_to_default([weak_host = std::weak_ptr<FTPHost>(SharedPtr()), path = _path] {
+        const auto host = weak_host.lock();
+        if( !host )
+            return;
+
+        auto curl = host->InstanceForIOAtDir(path);
+        if( curl->IsAttached() )
+            curl->Detach();
+        const int result = host->DownloadAndCacheListing(curl.get(), path.c_str(), nullptr, nullptr);
+        if( result != 0 )
+            Log::Warn("Failed to refresh the listing of '{}', error {}", path, result);
+        curl->Attach();
+        host->CommitIOInstanceAtDir(path, std::move(curl));
+        host->m_Cache->EndRevalidation(path);
+    });
+}
+
 std::unique_ptr<CURLInstance> FTPHost::InstanceForIOAtDir(const std::filesystem::path &_dir)
 {
     assert(!_dir.empty() && _dir.native().back() == '/');
-    const std::lock_guard<std::mutex> lock(m_IOIntancesLock);
-
-    // try to find cached inst in exact this directory
-    auto i = m_IOIntances.find(_dir);
-    if( i != end(m_IOIntances) ) {
-        auto r = std::move(i->second);
-        m_IOIntances.erase(i);
-        return r;
-    }
+    // prefer an instance which worked in exactly this directory, its connection might not need to CWD again
+    return m_IOInstances.Acquire([&](const CURLInstance &_inst) { return _inst.io_dir == _dir; }).Release();
+}
 
-    // if can't find - return any cached
-    if( !m_IOIntances.empty() ) {
-        i = m_IOIntances.begin();
-        auto r = std::move(i->second);
-        m_IOIntances.erase(i);
-        return r;
-    }
+void FTPHost::CommitIOInstanceAtDir(const std::filesystem::path &_dir, std::unique_ptr<CURLInstance> _i)
+{
+    assert(!_dir.empty() && _dir.native().back() == '/');
+    _i->io_dir = _dir;
+    m_IOInstances.Return(std::move(_i));
+}
 
-    // if we're empty - just create and return new inst
+ConnectionPoolMetrics FTPHost::ConnectionsMetrics() const
+{
+    return m_IOInstances.Metrics();
+}
+
+ConnectionPool<CURLInstance>::Traits FTPHost::IOInstancesTraits()
+{
+    return {.spawn = [this] { return SpawnIOInstance(); },
+            .recycle =
+                [this](CURLInstance &_inst) {
+                    _inst.EasyReset();
+                    BasicOptsSetup(&_inst);
+                },
+            .probe = [this](CURLInstance &_inst) { return PingIOInstance(_inst); }};
+}
+
+std::unique_ptr<CURLInstance> FTPHost::SpawnIOInstance()
+{
     auto inst = SpawnCURL();
     inst->curlm = curl_multi_init();
     inst->Attach();
-
     return inst;
 }
 
-void FTPHost::CommitIOInstanceAtDir(const std::filesystem::path &_dir, std::unique_ptr<CURLInstance> _i)
+bool FTPHost::PingIOInstance(CURLInstance &_inst)
 {
-    assert(!_dir.empty() && _dir.native().back() == '/');
-    const std::lock_guard<std::mutex> lock(m_IOIntancesLock);
+    if( _inst.IsAttached() )
+        _inst.Detach();
+
+    // a NOOP over the connection cached by the instance, without any transfer
+    const std::string url = BuildFullURLString("/");
+    struct curl_slist *header = curl_slist_append(nullptr, "NOOP");
+    _inst.EasySetOpt(CURLOPT_QUOTE, header);
+    _inst.EasySetOpt(CURLOPT_URL, url.c_str());
+    _inst.EasySetOpt(CURLOPT_NOBODY, 1);
+
+    _inst.Attach();
+    const CURLcode curl_res = _inst.PerformMulti();
+    curl_slist_free_all(header);
+    _inst.EasyReset();
+    BasicOptsSetup(&_inst);
 
-    _i->EasyReset();
-    BasicOptsSetup(_i.get());
-    m_IOIntances[_dir] = std::move(_i);
+    if( curl_res != CURLE_OK )
+        Log::Info("Dropping an FTP connection which failed a NOOP, curl code {}", std::to_underlying(curl_res));
+    return curl_res == CURLE_OK;
 }
 
 void FTPHost::BasicOptsSetup(CURLInstance *_inst)
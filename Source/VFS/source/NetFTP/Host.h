@@ -2,9 +2,10 @@
 #pragma once
 #include <VFS/Host.h>
 #include "InternalsForward.h"
+#include "../ConnectionPool.h"
+#include <atomic>
 #include <filesystem>
 #include <string_view>
-#include <map>
 #include <mutex>
 
 // RTFM: http://www.ietf.org/rfc/rfc959.txt
@@ -32,6 +33,11 @@ public:
     long Port() const noexcept;
     bool Active() const noexcept;
 
+    // Enables persisting the listings cache in _directory, one file per server and user, so that the listings of a
+    // subsequent connection are shown right away and refreshed in background. An empty _directory disables it.
+    // Affects the hosts created afterwards.
+    static void SetListingCacheDirectory(const std::filesystem::path &_directory);
+
     // core VFSHost methods
     std::expected<VFSListingPtr, Error> FetchDirectoryListing(std::string_view _path,
                                                               unsigned long _flags,
@@ -75,6 +81,7 @@ public:
 
     std::unique_ptr<ftp::CURLInstance> InstanceForIOAtDir(const std::filesystem::path &_dir);
     void CommitIOInstanceAtDir(const std::filesystem::path &_dir, std::unique_ptr<ftp::CURLInstance> _i);
+    ConnectionPoolMetrics ConnectionsMetrics() const;
 
     ftp::Cache &Cache() const { return *m_Cache.get(); };
 
@@ -96,10 +103,18 @@ private:
                               std::shared_ptr<ftp::Directory> &_cached_dir,
                               const VFSCancelChecker &_cancel_checker);
 
+    // Downloads the listing at _path via an IO instance and updates the cache, unless such refresh is already running.
+    void RevalidateInBackground(const std::string &_path);
+
     std::unique_ptr<ftp::CURLInstance> SpawnCURL();
+    ConnectionPool<ftp::CURLInstance>::Traits IOInstancesTraits();
+    std::unique_ptr<ftp::CURLInstance> SpawnIOInstance();
+    bool PingIOInstance(ftp::CURLInstance &_inst);
 
+    // _command is a listing command to issue instead of LIST, e.g. MLSD.
     int DownloadListing(ftp::CURLInstance *_inst,
                         const char *_path,
+                        const char *_command,
                         std::string &_buffer,
                         const VFSCancelChecker &_cancel_checker) const;
 
@@ -111,9 +126,6 @@ private:
     std::unique_ptr<ftp::Cache> m_Cache;
     std::unique_ptr<ftp::CURLInstance> m_ListingInstance;
 
-    std::map<std::filesystem::path, std::unique_ptr<ftp::CURLInstance>> m_IOIntances;
-    std::mutex m_IOIntancesLock;
-
     struct UpdateHandler {
         unsigned long ticket;
         std::function<void()> handler;
@@ -124,6 +136,11 @@ private:
     std::mutex m_UpdateHandlersLock;
     unsigned long m_LastUpdateTicket = 1;
     VFSConfiguration m_Configuration;
+    std::filesystem::path m_CachePath;          // empty if the cache is not persisted
+    std::atomic_bool m_MLSDUnsupported = false; // set once the server failed to provide an MLSD listing
+
+    // declared last since its pinging thread uses the configuration
+    ConnectionPool<ftp::CURLInstance> m_IOInstances;
 };
 
 } // namespace nc::vfs
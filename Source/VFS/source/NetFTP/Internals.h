@@ -5,6 +5,7 @@
 #include <VFS/Host.h>
 #include <vector>
 #include <cstddef>
+#include <filesystem>
 #include "Cache.h"
 
 namespace nc::vfs::ftp {
@@ -44,6 +45,7 @@ struct CURLInstance {
     CURL *curl = nullptr;
     CURLM *curlm = nullptr;
     bool attached = false;
+    std::filesystem::path io_dir; // the directory this instance was used in last time, if it's pooled for IO
     int (^prog_func)(curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow) = nil;
     std::mutex call_lock;
 
@@ -0,0 +1,127 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "MLSDParser.h"
+#include "Cache.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <sys/stat.h>
+
+namespace nc::vfs::ftp {
+
+static bool EqualsIgnoreCase(std::string_view _lhs, std::string_view _rhs) noexcept
+{
+    return std::ranges::equal(_lhs, _rhs, [](char _1, char _2) {
+        return (_1 >= 'A' && _1 <= 'Z' ? _1 + 'a' - 'A' : _1) == (_2 >= 'A' && _2 <= 'Z' ? _2 + 'a' - 'A' : _2);
+    });
+}
+
+template <class T>
+static bool ParseNumber(std::string_view _string, T &_value, int _base = 10) noexcept
+{
+    const auto last = _string.data() + _string.size();
+    const auto [ptr, ec] = std::from_chars(_string.data(), last, _value, _base);
+    return ec == std::errc{} && ptr == last;
+}
+
+// "YYYYMMDDHHMMSS[.sss]", always in UTC
+static bool ParseTimeVal(std::string_view _string, time_t &_time) noexcept
+{
+    if( _string.size() < 14 )
+        return false;
+    int year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    int hours = 0;
+    int minutes = 0;
+    int seconds = 0;
+    if( !ParseNumber(_string.substr(0, 4), year) || !ParseNumber(_string.substr(4, 2), month) ||
+        !ParseNumber(_string.substr(6, 2), day) || !ParseNumber(_string.substr(8, 2), hours) ||
+        !ParseNumber(_string.substr(10, 2), minutes) || !ParseNumber(_string.substr(12, 2), seconds) )
+        return false;
+
+    const std::chrono::year_month_day date{std::chrono::year{year}, std::chrono::month{month}, std::chrono::day{day}};
+    if( !date.ok() )
+        return false;
+    const auto time = std::chrono::sys_days{date} + std::chrono::hours{hours} + std::chrono::minutes{minutes} +
+                      std::chrono::seconds{seconds};
+    _time = static_cast<time_t>(time.time_since_epoch().count());
+    return true;
+}
+
+std::shared_ptr<Directory> ParseMLSDListing(std::string_view _listing)
+{
+    auto directory = std::make_shared<Directory>();
+    auto &entries = directory->entries;
+
+    while( !_listing.empty() ) {
+        const auto eol = _listing.find('\n');
+        std::string_view line = _listing.substr(0, eol);
+        _listing.remove_prefix(eol == std::string_view::npos ? _listing.size() : eol + 1);
+        if( !line.empty() && line.back() == '\r' )
+            line.remove_suffix(1);
+        if( line.empty() )
+            continue;
+
+        // the facts are separated from the filename by exactly one space and each of them ends with a semicolon
+        const auto space = line.find(' ');
+        if( space == std::string_view::npos || (space != 0 && line[space - 1] != ';') )
+            return nullptr;
+        std::string_view facts = line.substr(0, space);
+        const std::string_view filename = line.substr(space + 1);
+        if( filename.empty() )
+            return nullptr;
+
+        Entry entry;
+        bool has_type = false;
+        bool has_mode = false;
+        bool skip = false;
+        while( !facts.empty() ) {
+            const auto semicolon = facts.find(';');
+            const std::string_view fact = facts.substr(0, semicolon);
+            facts.remove_prefix(semicolon == std::string_view::npos ? facts.size() : semicolon + 1);
+            const auto equals = fact.find('=');
+            if( equals == std::string_view::npos )
+                return nullptr;
+            const std::string_view name = fact.substr(0, equals);
+            const std::string_view value = fact.substr(equals + 1);
+
+            if( EqualsIgnoreCase(name, "type") ) {
+                has_type = true;
+                if( EqualsIgnoreCase(value, "dir") )
+                    entry.mode = (entry.mode & ~S_IFMT) | S_IFDIR;
+                else if( EqualsIgnoreCase(value, "cdir") || EqualsIgnoreCase(value, "pdir") )
+                    skip = true;
+                else if( EqualsIgnoreCase(value, "OS.unix=slink") || EqualsIgnoreCase(value, "OS.unix=symlink") ||
+                         EqualsIgnoreCase(value.substr(0, 14), "OS.unix=slink:") )
+                    entry.mode = (entry.mode & ~S_IFMT) | S_IFLNK;
+                else
+                    entry.mode = (entry.mode & ~S_IFMT) | S_IFREG;
+            }
+            else if( EqualsIgnoreCase(name, "size") ) {
+                ParseNumber(value, entry.size);
+            }
+            else if( EqualsIgnoreCase(name, "modify") ) {
+                ParseTimeVal(value, entry.time);
+            }
+            else if( EqualsIgnoreCase(name, "UNIX.mode") ) {
+                mode_t mode = 0;
+                if( ParseNumber(value, mode, 8) ) {
+                    entry.mode = (entry.mode & S_IFMT) | (mode & ~S_IFMT);
+                    has_mode = true;
+                }
+            }
+        }
+        if( !has_type )
+            return nullptr;
+        if( skip )
+            continue;
+        if( !has_mode )
+            entry.mode |= S_ISDIR(entry.mode) ? 0755 : 0644;
+        entry.name = filename;
+        entries.emplace_back(std::move(entry));
+    }
+
+    return directory;
+}
+
+} // namespace nc::vfs::ftp
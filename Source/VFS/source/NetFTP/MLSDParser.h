@@ -0,0 +1,17 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+namespace nc::vfs::ftp {
+
+struct Directory;
+
+// Parses a machine-readable listing produced by the MLSD command (RFC 3659), where each line is a set of
+// "fact=value;" pairs followed by a space and a filename. The entries of the current and of the parent directories
+// are skipped. Returns nullptr if _listing doesn't look like an MLSD response, e.g. when a server answered with a
+// LIST-style output instead.
+std::shared_ptr<Directory> ParseMLSDListing(std::string_view _listing);
+
+} // namespace nc::vfs::ftp
@@ -1,13 +1,20 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "File.h"
 #include <libssh2.h>
 #include <libssh2_sftp.h>
 
 #include "SFTPHost.h"
 #include <algorithm>
+#include <cstring>
 
 namespace nc::vfs::sftp {
 
+// libssh2 splits the reads and writes into requests of up to this size.
+static constexpr size_t g_RequestSize = 30000;
+
+// libssh2 keeps sending read requests ahead up to four times the size of a read.
+static constexpr size_t g_ReadAheadFactor = 4;
+
 File::File(std::string_view _relative_path, std::shared_ptr<SFTPHost> _host) : VFSFile(_relative_path, _host)
 {
 }
@@ -55,13 +62,19 @@ int File::Open(unsigned long _open_flags, [[maybe_unused]] const VFSCancelChecke
     const int fstat_rc = libssh2_sftp_fstat_ex(handle, &attrs, 0);
     if( fstat_rc < 0 ) {
         const int conn_err = SFTPHost::VFSErrorForConnection(*conn);
+        libssh2_sftp_close(handle);
+        sftp_host->ReturnConnection(std::move(conn));
         return conn_err;
     }
 
+    // the session stays with the file until it's closed, so it shouldn't keep others from getting theirs
+    sftp_host->DetachConnection();
     m_Connection = std::move(conn);
     m_Handle = handle;
     m_Position = 0;
     m_Size = attrs.filesize;
+    m_Window = SFTPHost::TransferWindow() * g_RequestSize;
+    m_ReadAheadCapacity = std::max(m_Window / g_ReadAheadFactor, g_RequestSize);
 
     return 0;
 }
@@ -73,17 +86,25 @@ bool File::IsOpened() const
 
 int File::Close()
 {
+    int rc = VFSError::Ok;
     if( m_Handle ) {
+        rc = FlushWrites();
         libssh2_sftp_close(m_Handle);
         m_Handle = nullptr;
     }
 
     if( m_Connection )
-        std::dynamic_pointer_cast<SFTPHost>(Host())->ReturnConnection(std::move(m_Connection));
+        std::dynamic_pointer_cast<SFTPHost>(Host())->ReturnDetachedConnection(std::move(m_Connection));
 
     m_Position = 0;
     m_Size = 0;
-    return 0;
+    m_ReadAhead.reset();
+    m_ReadAheadOffset = m_ReadAheadLength = 0;
+    m_Reading = false;
+    m_WriteBuffer = {};
+    m_WriteAcked = 0;
+    m_WriteError = VFSError::Ok;
+    return rc;
 }
 
 VFSFile::ReadParadigm File::GetReadParadigm() const
@@ -106,7 +127,12 @@ off_t File::Seek(off_t _off, int _basis)
     else if( _basis == VFSFile::Seek_End )
         req = m_Size + _off;
 
-    libssh2_sftp_seek64(m_Handle, req);
+    if( const int rc = FlushWrites(); rc != VFSError::Ok )
+        return SetLastError(rc);
+    m_ReadAheadOffset = m_ReadAheadLength = 0;
+    m_Reading = false;
+
+    libssh2_sftp_seek64(m_Handle, req); // also discards the read requests in flight
     const libssh2_uint64_t pos = libssh2_sftp_tell64(m_Handle);
     m_Position = pos;
 
@@ -118,14 +144,35 @@ ssize_t File::Read(void *_buf, size_t _size)
     if( !IsOpened() )
         return SetLastError(VFSError::InvalidCall);
 
-    const ssize_t rc = libssh2_sftp_read(m_Handle, static_cast<char *>(_buf), _size);
-
-    if( rc >= 0 ) {
-        m_Position += rc;
-        return rc;
+    if( const int rc = FlushWrites(); rc != VFSError::Ok )
+        return SetLastError(rc);
+
+    m_Reading = true;
+    if( m_ReadAheadOffset == m_ReadAheadLength ) {
+        // small reads would let only a few requests be in flight, so the data is read in larger portions
+        if( _size >= m_ReadAheadCapacity ) {
+            const ssize_t rc = libssh2_sftp_read(m_Handle, static_cast<char *>(_buf), _size);
+            if( rc < 0 )
+                return SetLastError(SFTPHost::VFSErrorForConnection(*m_Connection));
+            m_Position += rc;
+            return rc;
+        }
+
+        if( !m_ReadAhead )
+            m_ReadAhead = std::make_unique<std::byte[]>(m_ReadAheadCapacity);
+        const ssize_t rc =
+            libssh2_sftp_read(m_Handle, reinterpret_cast<char *>(m_ReadAhead.get()), m_ReadAheadCapacity);
+        if( rc < 0 )
+            return SetLastError(SFTPHost::VFSErrorForConnection(*m_Connection));
+        m_ReadAheadOffset = 0;
+        m_ReadAheadLength = rc;
     }
-    else
-        return SetLastError(SFTPHost::VFSErrorForConnection(*m_Connection));
+
+    const size_t size = std::min(_size, m_ReadAheadLength - m_ReadAheadOffset);
+    std::memcpy(_buf, m_ReadAhead.get() + m_ReadAheadOffset, size);
+    m_ReadAheadOffset += size;
+    m_Position += size;
+    return size;
 }
 
 ssize_t File::Write(const void *_buf, size_t _size)
@@ -133,15 +180,78 @@ ssize_t File::Write(const void *_buf, size_t _size)
     if( !IsOpened() )
         return SetLastError(VFSError::InvalidCall);
 
-    const ssize_t rc = libssh2_sftp_write(m_Handle, static_cast<const char *>(_buf), _size);
+    if( m_WriteError != VFSError::Ok )
+        return SetLastError(m_WriteError);
 
-    if( rc >= 0 ) {
-        m_Size = std::max(m_Position + rc, m_Size);
-        m_Position += rc;
-        return rc;
+    DiscardReadAhead();
+
+    // the data is sent once enough of it was accumulated to fill the window, which is then kept full while the
+    // server acknowledges the requests
+    const auto bytes = static_cast<const std::byte *>(_buf);
+    m_WriteBuffer.insert(m_WriteBuffer.end(), bytes, bytes + _size);
+    m_Size = std::max(m_Position + static_cast<ssize_t>(_size), m_Size);
+    m_Position += _size;
+
+    while( m_WriteBuffer.size() - m_WriteAcked >= m_Window )
+        if( const int rc = PushWrites(); rc != VFSError::Ok )
+            return SetLastError(rc);
+
+    return _size;
+}
+
+int File::PushWrites()
+{
+    // libssh2 sends the requests for the data not sent yet and returns once some of them were acknowledged.
+    // The unacknowledged data has to be passed again in the subsequent calls.
+    const size_t pending = std::min(m_WriteBuffer.size() - m_WriteAcked, m_Window);
+    const ssize_t rc =
+        libssh2_sftp_write(m_Handle, reinterpret_cast<const char *>(m_WriteBuffer.data() + m_WriteAcked), pending);
+    if( rc < 0 ) {
+        m_WriteBuffer.clear();
+        m_WriteAcked = 0;
+        m_WriteError = SFTPHost::VFSErrorForConnection(*m_Connection);
+        return m_WriteError;
     }
-    else
-        return SetLastError(SFTPHost::VFSErrorForConnection(*m_Connection));
+
+    m_WriteAcked += rc;
+    if( m_WriteAcked == m_WriteBuffer.size() ) {
+        m_WriteBuffer.clear();
+        m_WriteAcked = 0;
+    }
+    else if( m_WriteAcked >= m_Window ) {
+        m_WriteBuffer.erase(m_WriteBuffer.begin(), m_WriteBuffer.begin() + m_WriteAcked);
+        m_WriteAcked = 0;
+    }
+    return VFSError::Ok;
+}
+
+int File::Flush()
+{
+    if( !IsOpened() )
+        return SetLastError(VFSError::InvalidCall);
+
+    if( const int rc = FlushWrites(); rc != VFSError::Ok )
+        return SetLastError(rc);
+    return VFSError::Ok;
+}
+
+int File::FlushWrites()
+{
+    if( m_WriteError != VFSError::Ok )
+        return m_WriteError;
+    while( !m_WriteBuffer.empty() )
+        if( const int rc = PushWrites(); rc != VFSError::Ok )
+            return rc;
+    return VFSError::Ok;
+}
+
+void File::DiscardReadAhead()
+{
+    if( !m_Reading )
+        return;
+    m_ReadAheadOffset = m_ReadAheadLength = 0;
+    m_Reading = false;
+    libssh2_sftp_seek64(m_Handle, m_Position);
 }
 
 ssize_t File::Pos() const
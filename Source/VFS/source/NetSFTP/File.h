@@ -1,8 +1,9 @@
-// Copyright (C) 2014-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <VFS/VFSFile.h>
 #include <libssh2_sftp.h>
+#include <vector>
 #include "SFTPHost.h"
 
 namespace nc::vfs::sftp {
@@ -21,15 +22,32 @@ public:
     virtual off_t Seek(off_t _off, int _basis) override;
     virtual ssize_t Read(void *_buf, size_t _size) override;
     virtual ssize_t Write(const void *_buf, size_t _size) override;
+    virtual int Flush() override;
     virtual ssize_t Pos() const override;
     virtual ssize_t Size() const override;
     virtual bool Eof() const override;
 
 private:
+    int PushWrites();
+    int FlushWrites();
+    void DiscardReadAhead();
+
     std::unique_ptr<SFTPHost::Connection> m_Connection;
     LIBSSH2_SFTP_HANDLE *m_Handle = nullptr;
-    ssize_t m_Position = 0;
+    ssize_t m_Position = 0; // as seen by the client, the handle's offset is ahead of it when reading or behind it
+                            // when writing
     ssize_t m_Size = 0;
+    size_t m_Window = 0; // bytes of the read or write requests kept in flight
+
+    std::unique_ptr<std::byte[]> m_ReadAhead; // data received past m_Position
+    size_t m_ReadAheadCapacity = 0;
+    size_t m_ReadAheadOffset = 0;
+    size_t m_ReadAheadLength = 0;
+    bool m_Reading = false; // the read requests sent ahead might be in flight
+
+    std::vector<std::byte> m_WriteBuffer; // data written by the client but not yet acknowledged by the server
+    size_t m_WriteAcked = 0;              // bytes at the front of m_WriteBuffer which were acknowledged already
+    int m_WriteError = VFSError::Ok;      // a failed write loses the buffered data, so the file stays failed
 };
 
 } // namespace nc::vfs::sftp
@@ -12,6 +12,8 @@
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <netdb.h>
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <Base/spinlock.h>
 #include <sys/dirent.h>
@@ -76,6 +78,14 @@ struct SFTPHost::AutoConnectionReturn // classic RAII stuff to prevent connectio
 
 const char *SFTPHost::UniqueTag = "net_sftp";
 
+static std::atomic_uint g_TransferWindow = 64;
+
+// Each session is an SSH connection of its own, servers tend to throttle or refuse many of them from the same client.
+static constexpr size_t g_MaxSessions = 4;
+
+// Once waited for this long, an operation spawns a session over the limit, which rules out deadlocks.
+static constexpr auto g_MaxSessionWait = 10s;
+
 class SFTPHostConfiguration
 {
 public:
@@ -226,9 +236,12 @@ int SFTPHost::DoInit()
         }
     }
 
+    ++m_Sessions;
     ReturnConnection(std::move(conn));
 
-    AddFeatures(HostFeatures::SetOwnership | HostFeatures::SetPermissions | HostFeatures::SetTimes);
+    // each operation takes a session of its own, waiting for one to be returned if all of the few allowed are busy
+    AddFeatures(HostFeatures::SetOwnership | HostFeatures::SetPermissions | HostFeatures::SetTimes |
+                HostFeatures::ConcurrentListing);
     if( m_OSType != sftp::OSType::Unknown )
         AddFeatures(HostFeatures::FetchUsers | HostFeatures::FetchGroups);
 
@@ -343,38 +356,86 @@ int SFTPHost::SpawnSFTP(std::unique_ptr<Connection> &_t)
     return 0;
 }
 
+void SFTPHost::SetTransferWindow(unsigned _requests) noexcept
+{
+    g_TransferWindow = std::max(_requests, 1u);
+}
+
+unsigned SFTPHost::TransferWindow() noexcept
+{
+    return g_TransferWindow;
+}
+
 int SFTPHost::GetConnection(std::unique_ptr<Connection> &_t)
 {
     {
-        const auto lock = std::lock_guard{m_ConnectionsLock};
-        while( !m_Connections.empty() ) {
-            auto connection = std::move(m_Connections.front());
-            m_Connections.erase(begin(m_Connections));
-
-            // if front connection is fine - return it
-            if( connection->Alive() ) {
-                _t = std::move(connection);
-                return 0;
+        auto lock = std::unique_lock{m_ConnectionsLock};
+        const auto deadline = std::chrono::steady_clock::now() + g_MaxSessionWait;
+        bool waited = false;
+        while( true ) {
+            while( !m_Connections.empty() ) {
+                auto connection = std::move(m_Connections.front());
+                m_Connections.erase(begin(m_Connections));
+
+                // if front connection is fine - return it
+                if( connection->Alive() ) {
+                    _t = std::move(connection);
+                    return 0;
+                }
+                // otherwise this connection object will be destroyed.
+                --m_Sessions;
             }
-            // otherwise this connection object will be destroyed.
+            if( m_Sessions < g_MaxSessions || waited )
+                break;
+            waited = m_ConnectionReturned.wait_until(lock, deadline) == std::cv_status::timeout;
         }
+        ++m_Sessions;
     }
 
-    const int rc = SpawnSSH2(_t);
-    if( rc < 0 )
-        return rc;
-
-    return SpawnSFTP(_t);
+    int rc = SpawnSSH2(_t);
+    if( rc == 0 )
+        rc = SpawnSFTP(_t);
+    if( rc < 0 ) {
+        {
+            const auto lock = std::lock_guard{m_ConnectionsLock};
+            --m_Sessions;
+        }
+        m_ConnectionReturned.notify_one();
+    }
+    return rc;
 }
 
 void SFTPHost::ReturnConnection(std::unique_ptr<Connection> _t)
 {
-    if( !_t->Alive() )
-        return;
+    {
+        const std::lock_guard<std::mutex> lock(m_ConnectionsLock);
+        if( _t->Alive() && m_Sessions <= g_MaxSessions )
+            m_Connections.emplace_back(std::move(_t));
+        else
+            --m_Sessions; // a dead one or spawned over the limit
+    }
+    m_ConnectionReturned.notify_one();
+}
 
-    const std::lock_guard<std::mutex> lock(m_ConnectionsLock);
+void SFTPHost::DetachConnection()
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_ConnectionsLock);
+        --m_Sessions;
+    }
+    m_ConnectionReturned.notify_one();
+}
 
-    m_Connections.emplace_back(std::move(_t));
+void SFTPHost::ReturnDetachedConnection(std::unique_ptr<Connection> _t)
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_ConnectionsLock);
+        if( !_t->Alive() || m_Sessions >= g_MaxSessions )
+            return; // the session gets closed outside of the lock
+        m_Connections.emplace_back(std::move(_t));
+        ++m_Sessions;
+    }
+    m_ConnectionReturned.notify_one();
 }
 
 in_addr_t SFTPHost::InetAddr() const
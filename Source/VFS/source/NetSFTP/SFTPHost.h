@@ -2,6 +2,7 @@
 #pragma once
 
 #include <VFS/Host.h>
+#include <condition_variable>
 #include <mutex>
 
 typedef struct _LIBSSH2_SFTP LIBSSH2_SFTP;
@@ -44,6 +45,11 @@ public:
 
     long Port() const noexcept;
 
+    // Sets how many read or write requests a file transfer keeps in flight, 64 by default as OpenSSH's sftp does.
+    // Affects the files opened afterwards.
+    static void SetTransferWindow(unsigned _requests) noexcept;
+    static unsigned TransferWindow() noexcept;
+
     // core VFSHost methods
     bool IsWritable() const override;
 
@@ -114,10 +120,19 @@ public:
     static int VFSErrorForConnection(Connection &_conn);
     static std::optional<Error> ErrorForConnection(Connection &_conn);
 
+    // Hands out an idle session or spawns a new one. Waits for a session to be returned while there are too many of
+    // them already, but spawns one over the limit after a while, since a client can hold several sessions at once.
     int GetConnection(std::unique_ptr<Connection> &_t);
 
     void ReturnConnection(std::unique_ptr<Connection> _t);
 
+    // Takes a session handed out by GetConnection() out of the limit, so that an open file can hold it for as long as
+    // it likes without stalling the others. It must be given back via ReturnDetachedConnection() later.
+    void DetachConnection();
+
+    // Takes back a detached session, closes it instead if the host already has as many sessions as allowed.
+    void ReturnDetachedConnection(std::unique_ptr<Connection> _t);
+
     std::shared_ptr<const SFTPHost> SharedPtr() const
     {
         return std::static_pointer_cast<const SFTPHost>(Host::SharedPtr());
@@ -144,7 +159,9 @@ private:
     const class SFTPHostConfiguration &Config() const;
 
     std::vector<std::unique_ptr<Connection>> m_Connections;
+    size_t m_Sessions = 0; // idle and busy ones together without the detached ones, guarded by m_ConnectionsLock
     std::mutex m_ConnectionsLock;
+    std::condition_variable m_ConnectionReturned;
     VFSConfiguration m_Config;
     std::string m_HomeDir;
     in_addr_t m_HostAddr = 0;
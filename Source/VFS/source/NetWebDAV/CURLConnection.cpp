@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "CURLConnection.h"
 #include "Internal.h"
 #include <Base/StackAllocator.h>
@@ -216,6 +216,11 @@ std::string_view CURLConnection::ResponseHeader()
     return m_ResponseHeader;
 }
 
+int CURLConnection::ResponseCode()
+{
+    return curl_easy_get_response_code(m_EasyHandle);
+}
+
 Connection::BlockRequestResult CURLConnection::PerformBlockingRequest()
 {
     const auto curl_rc = curl_easy_perform(m_EasyHandle);
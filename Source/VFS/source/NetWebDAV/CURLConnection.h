@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2023 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include "Connection.h"
@@ -41,6 +41,8 @@ public:
 
     std::string_view ResponseHeader() override;
 
+    int ResponseCode() override;
+
     int ReadBodyUpToSize(size_t _target) override;
 
     int WriteBodyUpToSize(size_t _target) override;
@@ -1,11 +1,17 @@
-// Copyright (C) 2017-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Cache.h"
 #include <Utility/PathManip.h>
 #include "Internal.h"
 #include "PathRoutines.h"
+#include "../BinarySerialization.h"
 #include <Base/mach_time.h>
 #include <Base/spinlock.h>
+#include <Base/WriteAtomically.h>
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 
 namespace nc::vfs::webdav {
 
@@ -13,6 +19,16 @@ using namespace std::literals;
 
 static const auto g_ListingTimeout = 60s;
 
+namespace {
+
+constexpr char g_Magic[8] = {'N', 'C', 'D', 'A', 'V', 'L', 'S', 'T'};
+constexpr uint32_t g_Version = 1;
+
+// The restored listings older than this are not worth revalidating.
+constexpr auto g_PersistedListingLifetime = std::chrono::days{7};
+
+} // namespace
+
 Cache::Cache() = default;
 
 Cache::~Cache() = default;
@@ -28,7 +44,9 @@ void Cache::CommitListing(const std::string &_at_path, std::vector<PropFindRespo
         const auto lock = std::lock_guard{m_Lock};
         auto &directory = m_Dirs[path];
         directory.fetch_time = time;
+        directory.fetch_wall_time = std::time(nullptr);
         directory.has_dirty_items = false;
+        directory.restored = false;
         directory.items = std::move(_items);
         directory.dirty_marks.resize(directory.items.size());
         std::ranges::fill(directory.dirty_marks, false);
@@ -96,7 +114,142 @@ void Cache::DiscardListing(const std::string &_at_path)
 
 bool Cache::IsOutdated(const Directory &_listing)
 {
-    return _listing.fetch_time + g_ListingTimeout < base::machtime();
+    return _listing.restored || _listing.fetch_time + g_ListingTimeout < base::machtime();
+}
+
+const PropFindResponse *Cache::Self(const Directory &_listing)
+{
+    // NOLINTBEGIN
+    const auto it = std::lower_bound(std::begin(_listing.items),
+                                     std::end(_listing.items),
+                                     std::string_view(".."),
+                                     [](auto &_1, auto &_2) { return _1.filename < _2; });
+    // NOLINTEND
+    if( it == std::end(_listing.items) || it->filename != ".." )
+        return nullptr;
+    return &*it;
+}
+
+bool Cache::CanRevalidate(const std::string &_at_path) const
+{
+    const auto path = EnsureTrailingSlash(_at_path);
+
+    const auto lock = std::lock_guard{m_Lock};
+
+    const auto it = m_Dirs.find(path);
+    if( it == end(m_Dirs) || it->second.has_dirty_items || !IsOutdated(it->second) )
+        return false;
+    const PropFindResponse *const self = Self(it->second);
+    return self != nullptr && (!self->etag.empty() || (it->second.restored && self->modification_date >= 0));
+}
+
+bool Cache::Revalidate(const std::string &_at_path, const PropFindResponse &_current_properties)
+{
+    const auto path = EnsureTrailingSlash(_at_path);
+
+    const auto lock = std::lock_guard{m_Lock};
+
+    const auto it = m_Dirs.find(path);
+    if( it == end(m_Dirs) || it->second.has_dirty_items )
+        return false;
+    auto &listing = it->second;
+    const PropFindResponse *const self = Self(listing);
+    if( self == nullptr )
+        return false;
+
+    // A modification date has a one-second granularity and many servers don't bump it for the changes inside the
+    // directory, so it's trusted only to skip re-reading the restored listings right after a reconnect.
+    const bool same = !self->etag.empty()
+                          ? self->etag == _current_properties.etag
+                          : listing.restored && self->modification_date >= 0 &&
+                                self->modification_date == _current_properties.modification_date;
+    if( !same )
+        return false;
+
+    listing.fetch_time = base::machtime();
+    listing.fetch_wall_time = std::time(nullptr);
+    listing.restored = false;
+    return true;
+}
+
+bool Cache::Save(const std::filesystem::path &_path) const
+{
+    BinaryWriter writer;
+    writer.Put(g_Magic);
+    writer.Put(g_Version);
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        const auto clean = std::ranges::count_if(m_Dirs, [](auto &_dir) { return !_dir.second.has_dirty_items; });
+        writer.Put(static_cast<uint32_t>(clean));
+        for( const auto &[path, listing] : m_Dirs ) {
+            if( listing.has_dirty_items )
+                continue;
+            writer.PutString(path);
+            writer.Put(static_cast<int64_t>(listing.fetch_wall_time));
+            writer.Put(static_cast<uint32_t>(listing.items.size()));
+            for( const auto &item : listing.items ) {
+                writer.PutString(item.filename);
+                writer.Put(static_cast<int64_t>(item.size));
+                writer.Put(static_cast<int64_t>(item.creation_date));
+                writer.Put(static_cast<int64_t>(item.modification_date));
+                writer.Put(static_cast<uint8_t>(item.is_directory));
+                writer.PutString(item.etag);
+            }
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(_path.parent_path(), ec);
+    return base::WriteAtomically(_path, writer.Bytes());
+}
+
+bool Cache::Load(const std::filesystem::path &_path)
+{
+    std::ifstream in(_path, std::ios::binary);
+    if( !in )
+        return false;
+    const std::vector<char> contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    BinaryReader reader({reinterpret_cast<const std::byte *>(contents.data()), contents.size()});
+
+    const auto magic = reader.Get<std::array<char, sizeof(g_Magic)>>();
+    if( !std::equal(magic.begin(), magic.end(), std::begin(g_Magic)) || reader.Get<uint32_t>() != g_Version )
+        return false;
+
+    const time_t oldest = std::time(nullptr) - std::chrono::seconds(g_PersistedListingLifetime).count();
+    std::vector<std::pair<std::string, Directory>> restored;
+    const uint32_t directories = reader.Get<uint32_t>();
+    for( uint32_t i = 0; i < directories && !reader.Failed(); ++i ) {
+        std::string path = reader.GetString();
+        Directory listing;
+        listing.fetch_wall_time = reader.Get<int64_t>();
+        listing.restored = true;
+        const uint32_t items = reader.Get<uint32_t>();
+        for( uint32_t j = 0; j < items && !reader.Failed(); ++j ) {
+            PropFindResponse item;
+            item.filename = reader.GetString();
+            item.size = static_cast<long>(reader.Get<int64_t>());
+            item.creation_date = static_cast<time_t>(reader.Get<int64_t>());
+            item.modification_date = static_cast<time_t>(reader.Get<int64_t>());
+            item.is_directory = reader.Get<uint8_t>() != 0;
+            item.etag = reader.GetString();
+            listing.items.emplace_back(std::move(item));
+        }
+        const bool sorted =
+            std::ranges::is_sorted(listing.items, [](auto &_1st, auto &_2nd) { return _1st.filename < _2nd.filename; });
+        if( !sorted || path.empty() || path.back() != '/' )
+            return false;
+        if( listing.fetch_wall_time < oldest )
+            continue;
+        listing.dirty_marks.resize(listing.items.size());
+        restored.emplace_back(std::move(path), std::move(listing));
+    }
+    if( reader.Failed() )
+        return false;
+
+    const auto lock = std::lock_guard{m_Lock};
+    for( auto &[path, listing] : restored )
+        m_Dirs.try_emplace(std::move(path), std::move(listing)); // the listings fetched meanwhile are fresher
+    return true;
 }
 
 void Cache::CommitMkDir(const std::string &_at_path)
@@ -1,7 +1,8 @@
-// Copyright (C) 2017-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <chrono>
+#include <filesystem>
 #include <string>
 #include <unordered_map>
 #include <mutex>
@@ -29,6 +30,22 @@ public:
     std::optional<std::vector<PropFindResponse>> Listing(const std::string &_at_path) const;
     std::pair<std::optional<PropFindResponse>, E> Item(std::string_view _at_path) const;
 
+    // Tells whether there's an outdated listing that can be revalidated instead of being fetched again, i.e. the
+    // server had provided an ETag of the directory itself. Without an ETag only a restored listing can be revalidated,
+    // by the directory's modification date, while the listings fetched in this session are simply fetched again.
+    bool CanRevalidate(const std::string &_at_path) const;
+
+    // Makes an outdated listing fresh again if the directory's current ETag (or, for a restored listing, its
+    // modification date if the server doesn't provide ETags) is the same as when the listing was fetched.
+    // Returns false otherwise.
+    bool Revalidate(const std::string &_at_path, const PropFindResponse &_current_properties);
+
+    // Persists the clean listings into a file, which allows a subsequent connection to revalidate them.
+    bool Save(const std::filesystem::path &_path) const;
+
+    // Restores the listings saved by Save() as outdated ones. A missing or malformed file is ignored.
+    bool Load(const std::filesystem::path &_path);
+
     void CommitListing(const std::string &_at_path, std::vector<PropFindResponse> _items);
     void DiscardListing(const std::string &_at_path);
     void CommitMkDir(const std::string &_at_path);
@@ -43,7 +60,9 @@ public:
 private:
     struct Directory {
         std::chrono::nanoseconds fetch_time = std::chrono::nanoseconds{0};
+        time_t fetch_wall_time = 0;
         bool has_dirty_items = false;
+        bool restored = false; // loaded from a file and not yet revalidated
 
         std::vector<PropFindResponse> items; // sorted by .filename
         std::vector<bool> dirty_marks;
@@ -55,6 +74,7 @@ private:
 
     void Notify(const std::string &_changed_dir_path);
     static bool IsOutdated(const Directory &);
+    static const PropFindResponse *Self(const Directory &);
 
     std::unordered_map<std::string, Directory> m_Dirs;
     mutable std::mutex m_Lock;
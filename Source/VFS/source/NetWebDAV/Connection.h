@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2021 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <VFS/VFSError.h>
@@ -44,6 +44,9 @@ public:
     virtual ReadBuffer &ResponseBody() = 0;
     virtual std::string_view ResponseHeader() = 0;
 
+    // HTTP status of the response received so far, 0 if there's none yet. Usable during the "multi" queries as well.
+    virtual int ResponseCode() = 0;
+
     //==============================================================================================
     // "Multi" queries
 
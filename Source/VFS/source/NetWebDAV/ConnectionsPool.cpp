@@ -1,11 +1,33 @@
-// Copyright (C) 2017-2021 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "ConnectionsPool.h"
 #include "Internal.h"
 #include "CURLConnection.h"
+#include "Requests.h"
 
 namespace nc::vfs::webdav {
 
-ConnectionsPool::ConnectionsPool(const HostConfiguration &_config) : m_Config(_config)
+static ConnectionPool<Connection>::Options PoolOptions() noexcept
+{
+    ConnectionPool<Connection>::Options options;
+    options.max_connections = 16;
+    options.max_wait = std::chrono::seconds{10};
+    options.idle_timeout = std::chrono::minutes{5};
+    // servers close the keep-alive connections idle for too long, pinging postpones that
+    options.ping_interval = std::chrono::seconds{30};
+    return options;
+}
+
+ConnectionsPool::ConnectionsPool(const HostConfiguration &_config)
+    : m_Config(_config),
+      m_Pool(PoolOptions(),
+             {.spawn = [this] { return std::make_unique<CURLConnection>(m_Config); },
+              .recycle = [](Connection &_connection) { _connection.Clear(); },
+              .probe =
+                  [this](Connection &_connection) {
+                      const bool alive = RequestServerOptions(m_Config, _connection).first == VFSError::Ok;
+                      _connection.Clear();
+                      return alive;
+                  }})
 {
 }
 
@@ -13,21 +35,12 @@ ConnectionsPool::~ConnectionsPool() = default;
 
 ConnectionsPool::AR ConnectionsPool::Get()
 {
-    if( m_Connections.empty() ) {
-        return AR{std::make_unique<CURLConnection>(m_Config), *this};
-    }
-    else {
-        std::unique_ptr<Connection> c = std::move(m_Connections.back());
-        m_Connections.pop_back();
-        return AR{std::move(c), *this};
-    }
+    return m_Pool.Acquire();
 }
 
 std::unique_ptr<Connection> ConnectionsPool::GetRaw()
 {
-    auto ar = Get();
-    auto c = std::move(ar.connection);
-    return c;
+    return m_Pool.Acquire().Release();
 }
 
 void ConnectionsPool::Return(std::unique_ptr<Connection> _connection)
@@ -35,18 +48,18 @@ void ConnectionsPool::Return(std::unique_ptr<Connection> _connection)
     if( !_connection )
         throw std::invalid_argument("ConnectionsPool::Return accepts only valid connections");
 
-    _connection->Clear();
-    m_Connections.emplace_back(std::move(_connection));
+    m_Pool.Return(std::move(_connection));
 }
 
-ConnectionsPool::AR::AR(std::unique_ptr<Connection> _c, ConnectionsPool &_p) : connection(std::move(_c)), pool(_p)
+ConnectionPoolMetrics ConnectionsPool::Metrics() const
 {
+    return m_Pool.Metrics();
 }
 
-ConnectionsPool::AR::~AR()
+bool ConnectionsPool::IsStale(int _vfs_error) noexcept
 {
-    if( connection )
-        pool.Return(std::move(connection));
+    // CurlRCToVFSError() reports the connections reset or closed by the peer this way
+    return _vfs_error == VFSError::FromErrno(ECONNRESET);
 }
 
 } // namespace nc::vfs::webdav
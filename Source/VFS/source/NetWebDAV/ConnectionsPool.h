@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2021 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <functional>
@@ -7,37 +7,57 @@
 #include <string_view>
 #include <span>
 #include <limits>
+#include <mutex>
 #include <VFS/VFSError.h>
+#include "../ConnectionPool.h"
+#include "Internal.h"
 #include "ReadBuffer.h"
 #include "WriteBuffer.h"
 #include "Connection.h"
 
 namespace nc::vfs::webdav {
 
-class HostConfiguration;
-
+// Keeps the idle connections for reuse, pinging them in background so that the server doesn't close them.
+// Can be used from several threads at once.
 class ConnectionsPool
 {
 public:
+    using AR = ConnectionPool<Connection>::Lease;
+
     ConnectionsPool(const HostConfiguration &_config);
     ~ConnectionsPool();
 
-    struct AR;
     AR Get();
+
+    // Hands out a connection for a long transfer, it doesn't count toward the pool's limit until returned.
     std::unique_ptr<Connection> GetRaw();
     void Return(std::unique_ptr<Connection> _connection);
 
+    // Performs an idempotent request, once again over a fresh connection if the reused one turned out to be closed by
+    // the server. _request is called as int(Connection&) or as std::tuple<int, ...>(Connection&) returning a VFSError
+    // first.
+    template <typename Request>
+    std::invoke_result_t<Request &, Connection &> Run(Request &&_request);
+
+    ConnectionPoolMetrics Metrics() const;
+
 private:
-    std::vector<std::unique_ptr<Connection>> m_Connections;
-    const HostConfiguration &m_Config;
-};
+    static bool IsStale(int _vfs_error) noexcept;
 
-struct ConnectionsPool::AR {
-    AR(std::unique_ptr<Connection> _c, ConnectionsPool &_p);
-    AR(AR &&) = default;
-    ~AR();
-    std::unique_ptr<Connection> connection;
-    ConnectionsPool &pool;
+    const HostConfiguration m_Config; // a copy, since the pinging thread can outlive the host's configuration
+    ConnectionPool<Connection> m_Pool;
 };
 
+template <typename Request>
+std::invoke_result_t<Request &, Connection &> ConnectionsPool::Run(Request &&_request)
+{
+    using Result = std::invoke_result_t<Request &, Connection &>;
+    return m_Pool.Run(std::forward<Request>(_request), [](const Result &_result) {
+        if constexpr( std::is_same_v<Result, int> )
+            return IsStale(_result);
+        else
+            return IsStale(std::get<0>(_result));
+    });
+}
+
 } // namespace nc::vfs::webdav
@@ -4,9 +4,77 @@
 #include "Cache.h"
 #include "PathRoutines.h"
 #include "ConnectionsPool.h"
+#include <fmt/format.h>
 
 namespace nc::vfs::webdav {
 
+// Amount of data passed on at once by the ranged requests
+static constexpr size_t g_RangePortion = 256 * 1024;
+
+namespace {
+
+// Fetches ranges of a file with "Range" GET requests over a connection taken from the host's pool.
+// Fails with VFSError::NotSupported if the server responds with anything but the requested range.
+class RangeFetcher final : public SegmentedDownload::Fetcher
+{
+public:
+    RangeFetcher(ConnectionsPool &_pool, std::string _url);
+    ~RangeFetcher() override;
+    int Fetch(uint64_t _offset, uint64_t _length, const Sink &_sink) override;
+
+private:
+    ConnectionsPool &m_Pool;
+    std::unique_ptr<Connection> m_Conn;
+    std::string m_URL;
+    std::unique_ptr<std::byte[]> m_Buf;
+};
+
+} // namespace
+
+RangeFetcher::RangeFetcher(ConnectionsPool &_pool, std::string _url)
+    : m_Pool(_pool), m_Conn(_pool.GetRaw()), m_URL(std::move(_url)),
+      m_Buf(std::make_unique_for_overwrite<std::byte[]>(g_RangePortion))
+{
+}
+
+RangeFetcher::~RangeFetcher()
+{
+    m_Pool.Return(std::move(m_Conn));
+}
+
+int RangeFetcher::Fetch(uint64_t _offset, uint64_t _length, const Sink &_sink)
+{
+    const std::string range = fmt::format("Range: bytes={}-{}", _offset, _offset + _length - 1);
+    const std::string_view header[] = {range};
+    m_Conn->Clear();
+    m_Conn->SetURL(m_URL);
+    m_Conn->SetCustomRequest("GET");
+    m_Conn->SetHeader(header);
+    m_Conn->MakeNonBlocking();
+
+    // lets the server finish the response, abandoning whatever it might still be sending
+    const auto conclude = [this](int _rc) {
+        m_Conn->ReadBodyUpToSize(Connection::AbortBodyRead);
+        return _rc;
+    };
+
+    auto &body = m_Conn->ResponseBody();
+    uint64_t passed = 0;
+    while( passed < _length ) {
+        if( const int rc = m_Conn->ReadBodyUpToSize(g_RangePortion); rc != VFSError::Ok )
+            return conclude(rc);
+        if( body.Empty() )
+            return conclude(VFSError::UnexpectedEOF);
+        if( m_Conn->ResponseCode() != 206 ) // the server ignores ranges and responds with the whole file instead
+            return conclude(VFSError::NotSupported);
+        const size_t size = body.Read(m_Buf.get(), std::min<uint64_t>(g_RangePortion, _length - passed));
+        if( !_sink(m_Buf.get(), size) )
+            return conclude(VFSError::Cancelled);
+        passed += size;
+    }
+    return conclude(VFSError::Ok);
+}
+
 File::File(std::string_view _relative_path, const std::shared_ptr<WebDAVHost> &_host)
     : VFSFile(_relative_path, _host), m_Host(*_host)
 {
@@ -76,7 +144,27 @@ ssize_t File::Read(void *_buf, size_t _size)
     if( _size == 0 || Eof() )
         return 0;
 
-    SpawnDownloadConnectionIfNeeded();
+    if( const unsigned workers = SegmentedDownload::WorkersFor(m_Size); workers != 0 && !m_RangesUnsupported ) {
+        SpawnSegmentedDownloadIfNeeded(workers);
+        const ssize_t has_read = m_Download->Read(m_Pos, _buf, _size);
+        if( has_read == VFSError::NotSupported ) {
+            // the server ignores ranges, so read the rest of this file over a single stream
+            m_Download.reset();
+            m_RangesUnsupported = true;
+        }
+        else {
+            if( has_read < 0 )
+                return SetLastError(static_cast<int>(has_read));
+            m_Pos += has_read;
+            return has_read;
+        }
+    }
+
+    if( m_Conn == nullptr ) {
+        SpawnDownloadConnectionIfNeeded();
+        if( const int vfs_error = SkipDownloadTo(m_Pos); vfs_error != VFSError::Ok )
+            return SetLastError(vfs_error);
+    }
 
     const int vfs_error = m_Conn->ReadBodyUpToSize(_size);
     if( vfs_error != VFSError::Ok )
@@ -143,6 +231,31 @@ void File::SpawnDownloadConnectionIfNeeded()
     m_Conn->MakeNonBlocking();
 }
 
+int File::SkipDownloadTo(uint64_t _offset)
+{
+    // a single stream always starts at the beginning of the file
+    auto &body = m_Conn->ResponseBody();
+    while( _offset > 0 ) {
+        if( const int vfs_error = m_Conn->ReadBodyUpToSize(g_RangePortion); vfs_error != VFSError::Ok )
+            return vfs_error;
+        if( body.Empty() )
+            return VFSError::UnexpectedEOF;
+        _offset -= body.Discard(_offset);
+    }
+    return VFSError::Ok;
+}
+
+void File::SpawnSegmentedDownloadIfNeeded(unsigned _workers)
+{
+    if( m_Download )
+        return;
+
+    m_Download = std::make_unique<SegmentedDownload>(
+        m_Size, _workers, [pool = &m_Host.ConnectionsPool(), url = URIForPath(m_Host.Config(), Path())] {
+            return std::make_unique<RangeFetcher>(*pool, url);
+        });
+}
+
 bool File::IsOpened() const
 {
     return m_OpenFlags != 0;
@@ -156,6 +269,8 @@ int File::Close()
     int result = VFSError::Ok;
 
     if( m_OpenFlags & VFSFlags::OF_Read ) {
+        m_Download.reset();
+        m_RangesUnsupported = false;
         if( m_Conn ) {
             m_Conn->ReadBodyUpToSize(Connection::AbortBodyRead);
             m_Host.ConnectionsPool().Return(std::move(m_Conn));
@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include "WebDAVHost.h"
@@ -6,6 +6,7 @@
 #include "ReadBuffer.h"
 #include "WriteBuffer.h"
 #include "Connection.h"
+#include "../SegmentedDownload.h"
 
 namespace nc::vfs::webdav {
 
@@ -29,10 +30,14 @@ public:
 
 private:
     void SpawnDownloadConnectionIfNeeded();
+    int SkipDownloadTo(uint64_t _offset);
+    void SpawnSegmentedDownloadIfNeeded(unsigned _workers);
     void SpawnUploadConnectionIfNeeded();
 
     WebDAVHost &m_Host;
     std::unique_ptr<Connection> m_Conn;
+    std::unique_ptr<SegmentedDownload> m_Download; // used instead of m_Conn to read large files
+    bool m_RangesUnsupported = false;              // the server ignored ranges, m_Conn is used instead of m_Download
     unsigned long m_OpenFlags = 0;
     long m_Pos = 0;
     long m_Size = -1;
@@ -110,6 +110,10 @@ int CurlRCToVFSError(int _curl_rc) noexcept
             return VFSError::FromErrno(EAUTH);
         case CURLE_REMOTE_FILE_EXISTS:
             return VFSError::FromErrno(EEXIST);
+        case CURLE_SEND_ERROR:
+        case CURLE_RECV_ERROR:
+        case CURLE_GOT_NOTHING:
+            return VFSError::FromErrno(ECONNRESET);
         case CURLE_SSL_CACERT:
             return VFSError::FromCFNetwork(kCFURLErrorSecureConnectionFailed);
         default:
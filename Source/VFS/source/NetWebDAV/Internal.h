@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2021 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include <string>
@@ -60,6 +60,7 @@ struct PropFindResponse {
     time_t creation_date = -1;
     time_t modification_date = -1;
     bool is_directory = false;
+    std::string etag; // opaque, empty if the server didn't provide it
 };
 
 constexpr uint16_t DirectoryAccessMode = S_IRUSR | S_IWUSR | S_IFDIR | S_IXUSR;
@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Requests.h"
 #include "Connection.h"
 #include "DateTimeParser.h"
@@ -104,6 +104,7 @@ static std::optional<PropFindResponse> ParseResponseNode(pugi::xml_node _node)
     [[clang::no_destroy]] static const auto restype_query = xpath_query{"./*/*/*[local-name()='resourcetype']"};
     [[clang::no_destroy]] static const auto credate_query = xpath_query{"./*/*/*[local-name()='creationdate']"};
     [[clang::no_destroy]] static const auto moddate_query = xpath_query{"./*/*/*[local-name()='getlastmodified']"};
+    [[clang::no_destroy]] static const auto etag_query = xpath_query{"./*/*/*[local-name()='getetag']"};
 
     PropFindResponse response;
 
@@ -136,6 +137,11 @@ static std::optional<PropFindResponse> ParseResponseNode(pugi::xml_node _node)
                 if( const auto t = ParseModDate(v); t >= 0 )
                     response.modification_date = t;
 
+    if( const auto etag = _node.select_node(etag_query) )
+        if( const auto c = etag.node().first_child() )
+            if( const auto v = c.value() )
+                response.etag = v;
+
     return std::optional<PropFindResponse>{std::move(response)};
 }
 
@@ -200,16 +206,15 @@ static bool FilepathsHavePathPrefix(const std::vector<PropFindResponse> &_items,
     return server_uses_prefixes;
 }
 
-std::pair<int, std::vector<PropFindResponse>>
-RequestDAVListing(const HostConfiguration &_options, Connection &_connection, const std::string &_path)
+static std::pair<int, std::vector<PropFindResponse>> RequestDAVPropFind(const HostConfiguration &_options,
+                                                                        Connection &_connection,
+                                                                        const std::string &_path,
+                                                                        std::string_view _depth_header)
 {
-    if( _path.back() != '/' )
-        throw std::invalid_argument("FetchDAVListing: path must contain a trailing slash");
-
     _connection.SetCustomRequest("PROPFIND");
 
     _connection.SetHeader(std::initializer_list<std::string_view>{
-        "Depth: 1", "translate: f", "Content-Type: application/xml; charset=\"utf-8\""});
+        _depth_header, "translate: f", "Content-Type: application/xml; charset=\"utf-8\""});
 
     const auto url = URIForPath(_options, _path);
     _connection.SetURL(url);
@@ -221,6 +226,7 @@ RequestDAVListing(const HostConfiguration &_options, Connection &_connection, co
                                    "<a:getcontentlength/>"
                                    "<a:getlastmodified/>"
                                    "<a:creationdate/>"
+                                   "<a:getetag/>"
                                    "</a:prop>"
                                    "</a:propfind>";
     _connection.SetBody(
@@ -244,6 +250,32 @@ RequestDAVListing(const HostConfiguration &_options, Connection &_connection, co
     }
 }
 
+std::pair<int, std::vector<PropFindResponse>>
+RequestDAVListing(const HostConfiguration &_options, Connection &_connection, const std::string &_path)
+{
+    if( _path.back() != '/' )
+        throw std::invalid_argument("FetchDAVListing: path must contain a trailing slash");
+
+    return RequestDAVPropFind(_options, _connection, _path, "Depth: 1");
+}
+
+std::pair<int, PropFindResponse>
+RequestDAVDirectoryProperties(const HostConfiguration &_options, Connection &_connection, const std::string &_path)
+{
+    if( _path.back() != '/' )
+        throw std::invalid_argument("RequestDAVDirectoryProperties: path must contain a trailing slash");
+
+    auto [rc, items] = RequestDAVPropFind(_options, _connection, _path, "Depth: 0");
+    if( rc != VFSError::Ok )
+        return {rc, {}};
+
+    const auto self = std::ranges::find_if(items, [](const auto &_item) { return _item.filename == ".."; });
+    if( self == items.end() )
+        return {VFSError::FromErrno(EIO), {}};
+
+    return {VFSError::Ok, std::move(*self)};
+}
+
 // free space, used space
 static std::pair<long, long> ParseSpaceQouta(const std::string &_xml)
 {
@@ -1,4 +1,4 @@
-// Copyright (C) 2017-2018 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2017-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #pragma once
 
 #include "Internal.h"
@@ -13,6 +13,10 @@ std::tuple<int, long, long> RequestSpaceQuota(const HostConfiguration &_options,
 std::pair<int, std::vector<PropFindResponse>>
 RequestDAVListing(const HostConfiguration &_options, Connection &_connection, const std::string &_path);
 
+// Fetches only the properties of the directory itself, which are reported with ".." as the filename.
+std::pair<int, PropFindResponse>
+RequestDAVDirectoryProperties(const HostConfiguration &_options, Connection &_connection, const std::string &_path);
+
 int RequestMKCOL(const HostConfiguration &_options, Connection &_connection, const std::string &_path);
 
 int RequestDelete(const HostConfiguration &_options, Connection &_connection, std::string_view _path);
@@ -8,11 +8,13 @@
 #include "File.h"
 #include "PathRoutines.h"
 #include "Requests.h"
+#include <Base/Hash.h>
 #include <sys/dirent.h>
 #include <fmt/core.h>
 
 #include <algorithm>
 #include <memory>
+#include <mutex>
 
 namespace nc::vfs {
 
@@ -25,8 +27,27 @@ struct WebDAVHost::State {
 
     class ConnectionsPool m_Pool;
     class Cache m_Cache;
+    std::filesystem::path m_CachePath; // empty if the cache is not persisted
 };
 
+[[clang::no_destroy]] static std::mutex g_ListingCacheDirectoryLock;
+[[clang::no_destroy]] static std::filesystem::path g_ListingCacheDirectory;
+
+static std::filesystem::path ListingCachePath(const HostConfiguration &_config)
+{
+    std::filesystem::path directory;
+    {
+        const auto lock = std::lock_guard{g_ListingCacheDirectoryLock};
+        directory = g_ListingCacheDirectory;
+    }
+    if( directory.empty() )
+        return {};
+
+    const std::string key = _config.user + "@" + _config.full_url;
+    auto digest = base::Hash(base::Hash::XXH3_128).Feed(key.data(), key.size()).Final();
+    return directory / (base::Hash::Hex(digest) + ".ncdavcache");
+}
+
 static VFSConfiguration ComposeConfiguration(const std::string &_serv_url,
                                              const std::string &_user,
                                              const std::string &_passwd,
@@ -53,14 +74,24 @@ WebDAVHost::WebDAVHost(const VFSConfiguration &_config)
     Init();
 }
 
-WebDAVHost::~WebDAVHost() = default;
+WebDAVHost::~WebDAVHost()
+{
+    if( !I->m_CachePath.empty() )
+        I->m_Cache.Save(I->m_CachePath);
+}
+
+void WebDAVHost::SetListingCacheDirectory(const std::filesystem::path &_directory)
+{
+    const auto lock = std::lock_guard{g_ListingCacheDirectoryLock};
+    g_ListingCacheDirectory = _directory;
+}
 
 void WebDAVHost::Init()
 {
     I = std::make_unique<State>(Config());
 
-    auto ar = I->m_Pool.Get();
-    const auto [rc, requests] = RequestServerOptions(Config(), *ar.connection);
+    const auto [rc, requests] =
+        I->m_Pool.Run([&](Connection &_connection) { return RequestServerOptions(Config(), _connection); });
     if( rc != VFSError::Ok )
         throw ErrorException(VFSError::ToError(rc));
 
@@ -74,7 +105,12 @@ void WebDAVHost::Init()
     //        throw ErrorException( VFSError::ToError(VFSError::FromErrno(EPROTONOSUPPORT)) );
     //    }
 
-    AddFeatures(HostFeatures::NonEmptyRmDir);
+    I->m_CachePath = ListingCachePath(Config());
+    if( !I->m_CachePath.empty() )
+        I->m_Cache.Load(I->m_CachePath);
+
+    // every request takes its own connection from the pool, so the recursive walks can list directories in parallel
+    AddFeatures(HostFeatures::NonEmptyRmDir | HostFeatures::ConcurrentListing);
 }
 
 VFSConfiguration WebDAVHost::Configuration() const
@@ -241,8 +277,16 @@ int WebDAVHost::RefreshListingAtPath(const std::string &_path, [[maybe_unused]]
     if( _path.back() != '/' )
         throw std::invalid_argument("RefreshListingAtPath requires a path with a trailing slash");
 
-    auto ar = I->m_Pool.Get();
-    auto [rc, items] = RequestDAVListing(Config(), *ar.connection, _path);
+    if( I->m_Cache.CanRevalidate(_path) ) {
+        // a Depth:0 request is much cheaper than fetching a huge listing again when nothing has changed
+        const auto [rc, properties] = I->m_Pool.Run(
+            [&](Connection &_connection) { return RequestDAVDirectoryProperties(Config(), _connection, _path); });
+        if( rc == VFSError::Ok && I->m_Cache.Revalidate(_path, properties) )
+            return VFSError::Ok;
+    }
+
+    auto [rc, items] =
+        I->m_Pool.Run([&](Connection &_connection) { return RequestDAVListing(Config(), _connection, _path); });
     if( rc != VFSError::Ok )
         return rc;
 
@@ -254,8 +298,8 @@ int WebDAVHost::RefreshListingAtPath(const std::string &_path, [[maybe_unused]]
 std::expected<VFSStatFS, Error> WebDAVHost::StatFS([[maybe_unused]] std::string_view _path,
                                                    [[maybe_unused]] const VFSCancelChecker &_cancel_checker)
 {
-    const auto ar = I->m_Pool.Get();
-    const auto [rc, free, used] = RequestSpaceQuota(Config(), *ar.connection);
+    const auto [rc, free, used] =
+        I->m_Pool.Run([&](Connection &_connection) { return RequestSpaceQuota(Config(), _connection); });
     if( rc != VFSError::Ok )
         return std::unexpected(VFSError::ToError(rc));
 
@@ -283,7 +327,7 @@ std::expected<void, Error> WebDAVHost::CreateDirectory(std::string_view _path,
 
     const auto path = EnsureTrailingSlash(std::string(_path));
     const auto ar = I->m_Pool.Get();
-    const auto rc = RequestMKCOL(Config(), *ar.connection, path);
+    const auto rc = RequestMKCOL(Config(), *ar, path);
     if( rc != VFSError::Ok )
         return std::unexpected(VFSError::ToError(rc));
 
@@ -300,7 +344,7 @@ std::expected<void, Error> WebDAVHost::RemoveDirectory(std::string_view _path,
 
     const auto path = EnsureTrailingSlash(std::string(_path));
     const auto ar = I->m_Pool.Get();
-    const auto rc = RequestDelete(Config(), *ar.connection, path);
+    const auto rc = RequestDelete(Config(), *ar, path);
     if( rc != VFSError::Ok )
         return std::unexpected(VFSError::ToError(rc));
 
@@ -316,7 +360,7 @@ std::expected<void, Error> WebDAVHost::Unlink(std::string_view _path,
         return std::unexpected(nc::Error{nc::Error::POSIX, EINVAL});
 
     const auto ar = I->m_Pool.Get();
-    const auto rc = RequestDelete(Config(), *ar.connection, _path);
+    const auto rc = RequestDelete(Config(), *ar, _path);
     if( rc != VFSError::Ok )
         return std::unexpected(VFSError::ToError(rc));
 
@@ -339,6 +383,11 @@ webdav::ConnectionsPool &WebDAVHost::ConnectionsPool()
     return I->m_Pool;
 }
 
+ConnectionPoolMetrics WebDAVHost::ConnectionsMetrics() const
+{
+    return I->m_Pool.Metrics();
+}
+
 webdav::Cache &WebDAVHost::Cache()
 {
     return I->m_Cache;
@@ -364,7 +413,7 @@ std::expected<void, Error> WebDAVHost::Rename(std::string_view _old_path,
     }
 
     const auto ar = I->m_Pool.Get();
-    const auto move_rc = RequestMove(Config(), *ar.connection, old_path, new_path);
+    const auto move_rc = RequestMove(Config(), *ar, old_path, new_path);
     if( move_rc != VFSError::Ok )
         return std::unexpected(VFSError::ToError(move_rc));
 
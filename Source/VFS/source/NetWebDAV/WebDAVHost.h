@@ -2,6 +2,8 @@
 #pragma once
 
 #include "../../include/VFS/Host.h"
+#include "../ConnectionPool.h"
+#include <filesystem>
 
 namespace nc::vfs {
 
@@ -67,8 +69,14 @@ public:
     const std::string Username() const noexcept;
     int Port() const noexcept;
 
+    // Enables persisting the listings cache in _directory, one file per server and user, so that the listings of a
+    // subsequent connection are merely revalidated instead of being fetched again. An empty _directory disables it.
+    // Affects the hosts created afterwards.
+    static void SetListingCacheDirectory(const std::filesystem::path &_directory);
+
     const webdav::HostConfiguration &Config() const noexcept;
     class webdav::ConnectionsPool &ConnectionsPool();
+    ConnectionPoolMetrics ConnectionsMetrics() const;
     class webdav::Cache &Cache();
 
 private:
@@ -1,11 +1,20 @@
 // Copyright (C) 2014-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "SearchForFiles.h"
 #include <sys/stat.h>
+#include <Base/ParallelTreeWalker.h>
 #include <VFS/FileWindow.h>
 #include <VFS/SearchInFile.h>
 
 namespace nc::vfs {
 
+// A unit of work of the parallel search: either a directory to look into or a file to check by its content.
+struct SearchForFiles::Job {
+    VFSPath path;
+    std::string dir_path; // the directory of the file, content checks only
+    std::string filename; // the name of the file, content checks only
+    bool check_content = false;
+};
+
 static utility::Encoding EncodingFromXAttr(const VFSFilePtr &_f)
 {
     char buf[128];
@@ -16,7 +25,7 @@ static utility::Encoding EncodingFromXAttr(const VFSFilePtr &_f)
     return utility::FromComAppleTextEncodingXAttr(buf);
 }
 
-SearchForFiles::SearchForFiles()
+SearchForFiles::SearchForFiles() : m_MaxWorkers(base::ParallelTreeWalker<Job>::DefaultConcurrency())
 {
     m_Queue.SetOnDry([this] {
         m_Callback = nullptr;
@@ -59,6 +68,13 @@ void SearchForFiles::SetFilterSize(const FilterSize &_filter)
     m_FilterSize = _filter;
 }
 
+void SearchForFiles::SetMaxWorkers(int _workers)
+{
+    if( IsRunning() )
+        throw std::logic_error("Workers can't be changed during background search process");
+    m_MaxWorkers = std::max(_workers, 1);
+}
+
 void SearchForFiles::ClearFilters()
 {
     if( IsRunning() )
@@ -88,7 +104,10 @@ bool SearchForFiles::Go(const std::string &_from_path,
     m_SearchOptions = _options;
     m_DirsFIFO = {};
 
-    m_Queue.Run([=, this] { AsyncProc(_from_path.c_str(), *_in_host); });
+    if( (_options & Options::Parallel) && _in_host->CanServeConcurrently() && m_MaxWorkers > 1 )
+        m_Queue.Run([=, this] { AsyncProcParallel(_from_path.c_str(), *_in_host); });
+    else
+        m_Queue.Run([=, this] { AsyncProc(_from_path.c_str(), *_in_host); });
 
     return true;
 }
@@ -108,10 +127,12 @@ void SearchForFiles::Wait()
     m_Queue.Wait();
 }
 
-void SearchForFiles::NotifyLookingIn(const char *_path, VFSHost &_in_host) const
+void SearchForFiles::NotifyLookingIn(const char *_path, VFSHost &_in_host)
 {
-    if( m_LookingInCallback )
+    if( m_LookingInCallback ) {
+        const auto lock = std::lock_guard{m_CallbacksLock};
         m_LookingInCallback(_path, _in_host);
+    }
 }
 
 void SearchForFiles::AsyncProc(const char *_from_path, VFSHost &_in_host)
@@ -125,31 +146,58 @@ void SearchForFiles::AsyncProc(const char *_from_path, VFSHost &_in_host)
         auto path = std::move(m_DirsFIFO.front());
         m_DirsFIFO.pop();
 
-        NotifyLookingIn(path.Path().c_str(), *path.Host());
+        LookInDirectory(path, nullptr);
+    }
+}
 
-        auto callback = [&](const VFSDirEnt &_dirent) {
-            if( m_Queue.IsStopped() )
-                return false;
+// The workers pick up the directories and the content checks as they are discovered, stealing from each other once
+// they run out of their own jobs. Content checks are the expensive part, so they are separate jobs instead of being
+// done while a directory is listed.
+void SearchForFiles::AsyncProcParallel(const char *_from_path, VFSHost &_in_host)
+{
+    const auto visit = [this](Job _job, std::vector<Job> &_more_jobs) {
+        if( _job.check_content )
+            ProcessContentJob(_job);
+        else
+            LookInDirectory(_job.path, &_more_jobs);
+    };
+    base::ParallelTreeWalker<Job> walker(m_MaxWorkers, visit, [this] { return m_Queue.IsStopped(); });
 
-            std::string full_path = path.Path();
-            if( full_path.back() != '/' )
-                full_path += '/';
-            full_path += _dirent.name;
+    std::vector<Job> roots;
+    roots.push_back({.path = VFSPath(_in_host.SharedPtr(), _from_path)});
+    walker.Walk(std::move(roots));
+}
 
-            ProcessDirent(full_path.c_str(), path.Path().c_str(), _dirent, *path.Host());
+void SearchForFiles::LookInDirectory(const VFSPath &_path, std::vector<Job> *_jobs)
+{
+    NotifyLookingIn(_path.Path().c_str(), *_path.Host());
 
-            return true;
-        };
+    std::string full_path;
+    auto callback = [&](const VFSDirEnt &_dirent) {
+        if( m_Queue.IsStopped() )
+            return false;
 
-        // Deliberately ignoring the errors here
-        std::ignore = path.Host()->IterateDirectoryListing(path.Path(), callback);
-    }
+        full_path = _path.Path();
+        if( full_path.back() != '/' )
+            full_path += '/';
+        full_path += _dirent.name;
+
+        ProcessDirent(full_path.c_str(), _path.Path().c_str(), _dirent, *_path.Host(), _jobs);
+
+        return true;
+    };
+
+    // Deliberately ignoring the errors here
+    std::ignore = _path.Host()->IterateDirectoryListing(_path.Path(), callback);
 }
 
+// When _jobs is not null the content checks and the subdirectories are put there instead of being processed
+// straight away.
 void SearchForFiles::ProcessDirent(const char *_full_path,
                                    const char *_dir_path,
                                    const VFSDirEnt &_dirent,
-                                   VFSHost &_in_host)
+                                   VFSHost &_in_host,
+                                   std::vector<Job> *_jobs)
 {
     bool failed_filtering = false;
 
@@ -183,21 +231,75 @@ void SearchForFiles::ProcessDirent(const char *_full_path,
     // Filter by file content
     CFRange content_pos{-1, 0};
     if( !failed_filtering && m_FilterContent ) {
-        if( _dirent.type != VFSDirEnt::Reg || !FilterByContent(_full_path, _in_host, content_pos) )
+        if( _dirent.type != VFSDirEnt::Reg ) {
             failed_filtering = true;
+        }
+        else if( _jobs ) {
+            _jobs->push_back({.path = VFSPath(_in_host.SharedPtr(), _full_path),
+                              .dir_path = _dir_path,
+                              .filename = _dirent.name,
+                              .check_content = true});
+            failed_filtering = true; // will be reported by the job
+        }
+        else if( !FilterByContent(_full_path, _in_host, content_pos) ) {
+            failed_filtering = true;
+        }
     }
 
     if( !failed_filtering )
-        ProcessValidEntry(_full_path, _dir_path, _dirent, _in_host, content_pos);
+        ProcessValidEntry(_full_path, _dir_path, _dirent.name, _in_host, content_pos);
 
-    if( m_SearchOptions & Options::GoIntoSubDirs )
-        if( _dirent.type == VFSDirEnt::Dir )
+    if( m_SearchOptions & Options::GoIntoSubDirs && _dirent.type == VFSDirEnt::Dir ) {
+        if( _jobs )
+            _jobs->push_back({.path = VFSPath(_in_host.SharedPtr(), _full_path)});
+        else
             m_DirsFIFO.emplace(_in_host.SharedPtr(), _full_path);
+    }
 
     if( m_SearchOptions & Options::LookInArchives )
         if( _dirent.type == VFSDirEnt::Reg && m_SpawnArchiveCallback )
-            if( auto archive_host = m_SpawnArchiveCallback(_full_path, _in_host) )
-                m_DirsFIFO.emplace(archive_host, "/");
+            if( auto archive_host = SpawnArchive(_full_path, _in_host) ) {
+                if( !_jobs )
+                    m_DirsFIFO.emplace(archive_host, "/");
+                else if( archive_host->CanServeConcurrently() )
+                    _jobs->push_back({.path = VFSPath(archive_host, "/")});
+                else
+                    LookInArchiveSequentially(archive_host);
+            }
+}
+
+// An archive host which can't serve concurrent requests is walked entirely by the worker which has spawned it.
+void SearchForFiles::LookInArchiveSequentially(const VFSHostPtr &_archive_host)
+{
+    std::vector<Job> jobs;
+    jobs.push_back({.path = VFSPath(_archive_host, "/")});
+    while( !jobs.empty() ) {
+        if( m_Queue.IsStopped() )
+            break;
+
+        const Job job = std::move(jobs.back());
+        jobs.pop_back();
+
+        if( job.check_content )
+            ProcessContentJob(job);
+        else
+            LookInDirectory(job.path, &jobs);
+    }
+}
+
+void SearchForFiles::ProcessContentJob(const Job &_job)
+{
+    CFRange content_pos{-1, 0};
+    if( FilterByContent(_job.path.Path().c_str(), *_job.path.Host(), content_pos) )
+        ProcessValidEntry(
+            _job.path.Path().c_str(), _job.dir_path.c_str(), _job.filename.c_str(), *_job.path.Host(), content_pos);
+}
+
+// Opening an archive can take a while, so it's not serialized with the other callbacks - the client's callback has
+// to be thread-safe in the Parallel mode.
+VFSHostPtr SearchForFiles::SpawnArchive(const char *_for_path, VFSHost &_in_host)
+{
+    return m_SpawnArchiveCallback(_for_path, _in_host);
 }
 
 bool SearchForFiles::FilterByContent(const char *_full_path, VFSHost &_in_host, CFRange &_r)
@@ -256,12 +358,14 @@ bool SearchForFiles::FilterByFilename(const char *_filename) const
 
 void SearchForFiles::ProcessValidEntry([[maybe_unused]] const char *_full_path,
                                        const char *_dir_path,
-                                       const VFSDirEnt &_dirent,
+                                       const char *_filename,
                                        VFSHost &_in_host,
                                        CFRange _cont_range)
 {
-    if( m_Callback ) // change to assert
-        m_Callback(_dirent.name, _dir_path, _in_host, _cont_range);
+    if( m_Callback ) { // change to assert
+        const auto lock = std::lock_guard{m_CallbacksLock};
+        m_Callback(_filename, _dir_path, _in_host, _cont_range);
+    }
 }
 
 bool SearchForFiles::IsRunning() const noexcept
@@ -2,13 +2,29 @@
 #include "SearchInFile.h"
 #include <Utility/Encodings.h>
 #include <VFS/FileWindow.h>
+#include <re2/re2.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <exception>
+#include <iterator>
+#include <numeric>
 
 namespace nc::vfs {
 
-static const unsigned g_MaximumCodeUnit = 2;
+// Amount of bytes around a match which are kept in the window to check whether the match is a whole phrase.
+// That's enough for one character in any of the supported encodings.
+static constexpr size_t g_Surroundings = 4;
 
-static bool IsWholePhrase(CFStringRef _string, CFRange _range);
+static std::vector<char32_t> CodePoints(CFStringRef _string);
+static std::vector<char32_t> CaseVariants(char32_t _char);
+static std::vector<std::string>
+Encode(char32_t _char, utility::Encoding _encoding, const std::array<uint16_t, 256> &_single_bytes);
+static bool IsSingleByte(utility::Encoding _encoding) noexcept;
+static std::array<uint16_t, 256> SingleByteTable(utility::Encoding _encoding);
+static std::optional<char32_t> DecodeAt(std::span<const std::byte> _bytes, size_t _pos, utility::Encoding _encoding);
+static std::optional<char32_t>
+DecodeBefore(std::span<const std::byte> _bytes, size_t _pos, utility::Encoding _encoding);
 
 SearchInFile::SearchInFile(nc::vfs::FileWindow &_file)
     : m_File(_file), m_TextSearchEncoding(utility::Encoding::ENCODING_INVALID)
@@ -16,17 +32,9 @@ SearchInFile::SearchInFile(nc::vfs::FileWindow &_file)
     if( !m_File.FileOpened() )
         throw std::invalid_argument("SearchInFile: FileWindow should be opened");
     m_Position = _file.WindowPos();
-    m_DecodedBuffer = std::make_unique<uint16_t[]>(_file.WindowSize());
-    m_DecodedBufferIndx = std::make_unique<uint32_t[]>(_file.WindowSize());
 }
 
-SearchInFile::~SearchInFile()
-{
-    if( m_RequestedTextSearch != nullptr )
-        CFRelease(m_RequestedTextSearch);
-    if( m_DecodedBufferString != nullptr )
-        CFRelease(m_DecodedBufferString);
-}
+SearchInFile::~SearchInFile() = default;
 
 void SearchInFile::MoveCurrentPosition(uint64_t _pos)
 {
@@ -45,30 +53,69 @@ void SearchInFile::MoveCurrentPosition(uint64_t _pos)
 
 void SearchInFile::ToggleTextSearch(CFStringRef _string, utility::Encoding _encoding)
 {
-    if( m_RequestedTextSearch != nullptr )
-        CFRelease(m_RequestedTextSearch);
-    m_RequestedTextSearch = CFStringCreateCopy(nullptr, _string);
+    ToggleTextSearch(std::span<const CFStringRef>{&_string, 1}, _encoding);
+}
+
+void SearchInFile::ToggleTextSearch(std::span<const CFStringRef> _strings, utility::Encoding _encoding)
+{
+    m_RequestedTextSearch.clear();
+    for( const CFStringRef string : _strings )
+        m_RequestedTextSearch.push_back(base::CFPtr<CFStringRef>::adopt(CFStringCreateCopy(nullptr, string)));
     m_TextSearchEncoding = _encoding;
+    m_TextSearcher.reset();
 
     m_WorkMode = WorkMode::Text;
 }
 
+void SearchInFile::ToggleBytesSearch(std::span<const std::byte> _bytes)
+{
+    m_RequestedBytes.assign(_bytes.begin(), _bytes.end());
+    m_BytesSearcher.reset();
+    if( !m_RequestedBytes.empty() ) {
+        const std::string_view bytes{reinterpret_cast<const char *>(m_RequestedBytes.data()), m_RequestedBytes.size()};
+        const base::LiteralSearch::Needle needles[] = {base::LiteralSearch::Exact(bytes)};
+        m_BytesSearcher.emplace(needles);
+    }
+
+    m_WorkMode = WorkMode::Bytes;
+}
+
+std::span<const std::byte> SearchInFile::BytesSearch() const noexcept
+{
+    return m_RequestedBytes;
+}
+
+void SearchInFile::ToggleRegExSearch(std::string_view _pattern, utility::Encoding _encoding)
+{
+    m_RequestedRegEx = _pattern;
+    m_RegExEncoding = _encoding;
+    m_RegEx.reset();
+    m_RegExIsBuilt = false;
+
+    m_WorkMode = WorkMode::RegEx;
+}
+
+const std::string &SearchInFile::RegExSearch() const noexcept
+{
+    return m_RequestedRegEx;
+}
+
 SearchInFile::Result SearchInFile::Search(const CancelChecker &_checker)
 {
-    if( m_WorkMode == WorkMode::Text ) {
-        uint64_t offset = 0;
-        uint64_t bytes_len = 0;
-        Result result;
+    uint64_t offset = 0;
+    uint64_t bytes_len = 0;
+    Result result;
+    if( m_WorkMode == WorkMode::Text )
         result.response = SearchText(&offset, &bytes_len, _checker);
-        if( result.response == Response::Found )
-            result.location = {.offset = offset, .bytes_len = bytes_len};
-        return result;
-    }
-    else {
-        Result result;
+    else if( m_WorkMode == WorkMode::Bytes )
+        result.response = SearchBytes(&offset, &bytes_len, _checker);
+    else if( m_WorkMode == WorkMode::RegEx )
+        result.response = SearchRegEx(&offset, &bytes_len, _checker);
+    else
         result.response = Response::NotFound;
-        return result;
-    }
+    if( result.response == Response::Found )
+        result.location = {.offset = offset, .bytes_len = bytes_len};
+    return result;
 }
 
 bool SearchInFile::IsEOF() const
@@ -76,7 +123,83 @@ bool SearchInFile::IsEOF() const
     return m_Position >= m_File.FileSize();
 }
 
-SearchInFile::Response SearchInFile::SearchText(uint64_t *_offset, uint64_t *_bytes_len, CancelChecker _checker)
+template <class Find, class Accept>
+SearchInFile::Response SearchInFile::SearchInWindows(size_t _max_length,
+                                                     Find _find,
+                                                     Accept _accept,
+                                                     uint64_t *_offset,
+                                                     uint64_t *_bytes_len,
+                                                     const CancelChecker &_checker)
+{
+    if( m_File.WindowSize() < m_File.FileSize() && _max_length + 2 * g_Surroundings >= m_File.WindowSize() )
+        return Response::Invalid; // the window can't fit a match along with its surroundings
+
+    while( m_Position < m_File.FileSize() ) {
+        if( _checker && _checker() )
+            return Response::Canceled;
+
+        // move our load window inside a file, keeping a few bytes before the position to look at the surroundings
+        uint64_t window_pos = m_Position - std::min<uint64_t>(m_Position, g_Surroundings);
+        if( window_pos + m_File.WindowSize() > m_File.FileSize() )
+            window_pos = m_File.FileSize() - m_File.WindowSize();
+        if( !m_File.MoveWindow(window_pos) )
+            return Response::IOErr;
+        assert(m_Position >= m_File.WindowPos() &&
+               m_Position < m_File.WindowPos() + m_File.WindowSize()); // sanity check
+
+        const std::span<const std::byte> window{static_cast<const std::byte *>(m_File.Window()), m_File.WindowSize()};
+        const bool is_last_window = window_pos + window.size() >= m_File.FileSize();
+        bool moved_to_match = false;
+        size_t from = m_Position - window_pos;
+        while( const std::optional<Location> match = _find(window, from) ) {
+            const uint64_t offset = window_pos + match->offset;
+            if( !is_last_window && match->offset + match->bytes_len + g_Surroundings > window.size() &&
+                offset != m_Position ) {
+                // the match is too close to the end of the window, take another look at it from the next one
+                m_Position = offset;
+                moved_to_match = true;
+                break;
+            }
+
+            if( !_accept(window, window_pos, *match) ) {
+                // false alarm - just move position beyond the start of the found part and go on
+                from = match->offset + 1;
+                continue;
+            }
+
+            if( _offset != nullptr )
+                *_offset = offset;
+            if( _bytes_len != nullptr )
+                *_bytes_len = match->bytes_len;
+            m_Position = offset + match->bytes_len;
+            return Response::Found;
+        }
+
+        if( moved_to_match )
+            continue;
+
+        if( is_last_window ) {
+            m_Position = m_File.FileSize(); // this is the end (c)
+        }
+        else {
+            // left some space in the tail to exclude situations when searched text is cut between the windows
+            m_Position = window_pos + window.size() - _max_length - g_Surroundings;
+        }
+    }
+
+    return Response::NotFound;
+}
+
+static std::optional<SearchInFile::Location>
+FindLiteral(const base::LiteralSearch &_search, std::span<const std::byte> _window, size_t _from) noexcept
+{
+    if( const auto match = _search.Find(_window, _from) )
+        return SearchInFile::Location{.offset = match->offset, .bytes_len = match->length};
+    return std::nullopt;
+}
+
+SearchInFile::Response
+SearchInFile::SearchText(uint64_t *_offset, uint64_t *_bytes_len, const CancelChecker &_checker)
 {
     if( m_File.FileSize() == 0 )
         return Response::NotFound; // for singular case
@@ -87,92 +210,194 @@ SearchInFile::Response SearchInFile::SearchText(uint64_t *_offset, uint64_t *_by
     if( m_Position >= m_File.FileSize() )
         return Response::EndOfFile; // when finished searching
 
-    if( CFStringGetLength(m_RequestedTextSearch) <= 0 )
+    const auto is_empty = [](const base::CFPtr<CFStringRef> &_string) { return CFStringGetLength(_string.get()) <= 0; };
+    if( m_RequestedTextSearch.empty() || std::ranges::any_of(m_RequestedTextSearch, is_empty) )
         return Response::Invalid;
 
-    while( true ) {
-        if( m_Position >= m_File.FileSize() )
-            break; // when finished searching
+    if( !m_TextSearcher || m_TextSearcherIsCaseSensitive != m_SearchOptionsBits.case_sensitive )
+        BuildTextSearcher();
 
-        if( _checker && _checker() )
-            return Response::Canceled;
+    if( m_TextSearcher->NeedlesCount() == 0 ) {
+        // none of the strings can be represented in this encoding
+        m_Position = m_File.FileSize();
+        return Response::NotFound;
+    }
 
-        // move our load window inside a file
-        size_t window_pos = m_Position;
-        size_t left_window_gap = 0;
-        if( window_pos + m_File.WindowSize() > m_File.FileSize() ) {
-            window_pos = m_File.FileSize() - m_File.WindowSize();
-            left_window_gap = m_Position - window_pos;
+    const uint64_t alignment = utility::BytesForCodeUnit(m_TextSearchEncoding) == 2 ? 2 : 1;
+    const bool whole_phrase = m_SearchOptionsBits.find_whole_phrase;
+    const auto find = [&](std::span<const std::byte> _window, size_t _from) {
+        return FindLiteral(*m_TextSearcher, _window, _from);
+    };
+    const auto accept = [&](std::span<const std::byte> _window, uint64_t _window_pos, const Location &_match) {
+        return (_window_pos + _match.offset) % alignment == 0 &&
+               (!whole_phrase || IsWholePhrase(_window, _match.offset, _match.bytes_len));
+    };
+    return SearchInWindows(m_TextSearcher->MaxLength(), find, accept, _offset, _bytes_len, _checker);
+}
+
+SearchInFile::Response
+SearchInFile::SearchBytes(uint64_t *_offset, uint64_t *_bytes_len, const CancelChecker &_checker)
+{
+    if( !m_BytesSearcher )
+        return Response::Invalid;
+
+    if( m_File.FileSize() == 0 )
+        return Response::NotFound; // for singular case
+
+    if( m_Position >= m_File.FileSize() )
+        return Response::EndOfFile; // when finished searching
+
+    const auto find = [&](std::span<const std::byte> _window, size_t _from) {
+        return FindLiteral(*m_BytesSearcher, _window, _from);
+    };
+    const auto accept = [](std::span<const std::byte>, uint64_t, const Location &) { return true; };
+    return SearchInWindows(m_BytesSearcher->MaxLength(), find, accept, _offset, _bytes_len, _checker);
+}
+
+SearchInFile::Response
+SearchInFile::SearchRegEx(uint64_t *_offset, uint64_t *_bytes_len, const CancelChecker &_checker)
+{
+    if( !m_RegExIsBuilt || m_RegExIsCaseSensitive != m_SearchOptionsBits.case_sensitive )
+        BuildRegEx();
+
+    if( !m_RegEx )
+        return Response::Invalid;
+
+    if( m_File.FileSize() == 0 )
+        return Response::NotFound; // for singular case
+
+    if( m_Position >= m_File.FileSize() )
+        return Response::EndOfFile; // when finished searching
+
+    const re2::RE2 &regex = *m_RegEx;
+    const auto find = [&](std::span<const std::byte> _window, size_t _from) -> std::optional<Location> {
+        // the whole window is given to RE2 so that the bytes before _from serve as a context for '^' and '\b'
+        const std::string_view text{reinterpret_cast<const char *>(_window.data()), _window.size()};
+        std::string_view match;
+        while( _from <= text.size() ) {
+            if( !regex.Match(text, _from, text.size(), re2::RE2::UNANCHORED, &match, 1) )
+                return std::nullopt;
+            const size_t offset = static_cast<size_t>(match.data() - text.data());
+            if( !match.empty() )
+                return Location{.offset = offset, .bytes_len = match.size()};
+            _from = offset + 1; // empty matches are of no use
         }
-        if( !m_File.MoveWindow(window_pos) )
-            return Response::IOErr;
-        assert(m_Position >= m_File.WindowPos() &&
-               m_Position < m_File.WindowPos() + m_File.WindowSize()); // sanity check
+        return std::nullopt;
+    };
+    const auto accept = [](std::span<const std::byte>, uint64_t, const Location &) { return true; };
+
+    // a window has to fit the longest possible match along with the surroundings
+    const size_t max_length =
+        std::min(MaxRegExMatchLength, m_File.WindowSize() > 4 * g_Surroundings ? m_File.WindowSize() / 2 : 1);
+    return SearchInWindows(max_length, find, accept, _offset, _bytes_len, _checker);
+}
 
-        // get UniChars from this window using given encoding
-        assert(utility::BytesForCodeUnit(m_TextSearchEncoding) <= 2); // TODO: support for UTF-32 in the future
-        const bool isodd = (utility::BytesForCodeUnit(m_TextSearchEncoding) == 2) && ((m_File.WindowPos() & 1) == 1);
-        utility::InterpretAsUnichar(m_TextSearchEncoding,
-                                    static_cast<const unsigned char *>(m_File.Window()) + left_window_gap +
-                                        (isodd ? 1 : 0),
-                                    m_File.WindowSize() - left_window_gap - (isodd ? 1 : 0),
-                                    m_DecodedBuffer.get(),
-                                    m_DecodedBufferIndx.get(),
-                                    &m_DecodedBufferSize);
-
-        assert(m_DecodedBufferSize != 0);
-
-        // use this UniChars to produce a regular CFString
-        if( m_DecodedBufferString != nullptr )
-            CFRelease(m_DecodedBufferString);
-        m_DecodedBufferString =
-            CFStringCreateWithCharactersNoCopy(nullptr, m_DecodedBuffer.get(), m_DecodedBufferSize, kCFAllocatorNull);
-
-        const auto find_flags = m_SearchOptionsBits.case_sensitive ? 0 : kCFCompareCaseInsensitive;
-        const CFRange result = CFStringFind(m_DecodedBufferString, m_RequestedTextSearch, find_flags);
-
-        if( result.location == kCFNotFound ) {
-            // lets proceed further
-            if( m_File.WindowPos() + m_File.WindowSize() < m_File.FileSize() ) { // can move on
-                // left some space in the tail to exclude situations when searched text is cut
-                // between the windows
-                assert(left_window_gap == 0);
-                assert(size_t(CFStringGetLength(m_RequestedTextSearch) * g_MaximumCodeUnit) < m_File.WindowSize());
-                m_Position =
-                    m_Position + m_File.WindowSize() - CFStringGetLength(m_RequestedTextSearch) * g_MaximumCodeUnit;
-            }
-            else { // this is the end (c)
-                m_Position = m_File.FileSize();
+void SearchInFile::BuildTextSearcher()
+{
+    const bool case_sensitive = m_SearchOptionsBits.case_sensitive;
+    const auto single_bytes = SingleByteTable(m_TextSearchEncoding);
+
+    std::vector<base::LiteralSearch::Needle> needles;
+    for( const auto &string : m_RequestedTextSearch ) {
+        base::LiteralSearch::Needle needle;
+        for( const char32_t c : CodePoints(string.get()) ) {
+            base::LiteralSearch::Char forms;
+            for( const char32_t variant : case_sensitive ? std::vector<char32_t>{c} : CaseVariants(c) )
+                std::ranges::move(Encode(variant, m_TextSearchEncoding, single_bytes), std::back_inserter(forms));
+            if( forms.empty() ) {
+                // this character can't be represented in the encoding, thus the string can't be found at all
+                needle.clear();
+                break;
             }
+            needle.push_back(std::move(forms));
         }
-        else {
-            assert(size_t(result.location + result.length) <= m_DecodedBufferSize); // sanity check
-            // check for whole phrase is this option is set
-            if( m_SearchOptionsBits.find_whole_phrase && !IsWholePhrase(m_DecodedBufferString, result) ) {
-                // false alarm - just move position beyond found part ang go on
-                m_Position = m_Position + m_DecodedBufferIndx[result.location + result.length];
-                continue;
-            }
+        if( !needle.empty() )
+            needles.push_back(std::move(needle));
+    }
 
-            if( _offset != nullptr )
-                *_offset = m_Position + m_DecodedBufferIndx[result.location];
+    m_TextSearcher.emplace(needles);
+    m_TextSearcherIsCaseSensitive = case_sensitive;
+}
 
-            if( _offset != nullptr )
-                *_bytes_len = (size_t(result.location + result.length) < m_DecodedBufferSize
-                                   ? m_DecodedBufferIndx[result.location + result.length]
-                                   : m_File.WindowSize() - left_window_gap) -
-                              m_DecodedBufferIndx[result.location];
-            m_Position = m_Position + m_DecodedBufferIndx[result.location + result.length];
-            return Response::Found;
+void SearchInFile::BuildRegEx()
+{
+    m_RegEx.reset();
+    m_RegExIsBuilt = true;
+    m_RegExIsCaseSensitive = m_SearchOptionsBits.case_sensitive;
+
+    re2::RE2::Options options;
+    options.set_log_errors(false);
+    options.set_case_sensitive(m_RegExIsCaseSensitive);
+    std::string pattern;
+    if( m_RegExEncoding == utility::Encoding::ENCODING_UTF8 ) {
+        pattern = m_RequestedRegEx;
+        options.set_encoding(re2::RE2::Options::EncodingUTF8);
+    }
+    else if( IsSingleByte(m_RegExEncoding) ) {
+        // RE2 treats the bytes as Latin-1, so the non-ASCII characters of the pattern are converted into the bytes
+        // which represent them in this encoding
+        const auto single_bytes = SingleByteTable(m_RegExEncoding);
+        const auto cf_pattern = base::CFPtr<CFStringRef>::adopt(CFStringCreateWithBytes(
+            nullptr, reinterpret_cast<const UInt8 *>(m_RequestedRegEx.data()), m_RequestedRegEx.size(),
+            kCFStringEncodingUTF8, false));
+        if( !cf_pattern )
+            return;
+        for( const char32_t c : CodePoints(cf_pattern.get()) ) {
+            const auto forms = Encode(c, m_RegExEncoding, single_bytes);
+            if( forms.empty() )
+                return; // the pattern can't be represented in this encoding
+            pattern += forms.front();
         }
+        options.set_encoding(re2::RE2::Options::EncodingLatin1);
+    }
+    else {
+        return;
     }
 
-    return Response::NotFound;
+    auto regex = std::make_unique<re2::RE2>("(?m)" + pattern, options);
+    if( regex->ok() )
+        m_RegEx = std::move(regex);
+}
+
+std::optional<std::vector<std::byte>> SearchInFile::ParseHexBytes(std::string_view _hex)
+{
+    const auto digit = [](char _c) -> int {
+        if( _c >= '0' && _c <= '9' )
+            return _c - '0';
+        if( _c >= 'a' && _c <= 'f' )
+            return _c - 'a' + 10;
+        if( _c >= 'A' && _c <= 'F' )
+            return _c - 'A' + 10;
+        return -1;
+    };
+
+    std::vector<std::byte> bytes;
+    int high = -1; // the first digit of a pair which is being parsed
+    for( const char c : _hex ) {
+        if( c == ' ' || c == '\t' || c == '\n' || c == '\r' ) {
+            if( high >= 0 )
+                return std::nullopt; // a pair can't be split
+            continue;
+        }
+        const int value = digit(c);
+        if( value < 0 )
+            return std::nullopt;
+        if( high < 0 ) {
+            high = value;
+        }
+        else {
+            bytes.push_back(static_cast<std::byte>((high << 4) | value));
+            high = -1;
+        }
+    }
+    if( high >= 0 || bytes.empty() )
+        return std::nullopt;
+    return bytes;
 }
 
 CFStringRef SearchInFile::TextSearchString()
 {
-    return m_RequestedTextSearch;
+    return m_RequestedTextSearch.empty() ? nullptr : m_RequestedTextSearch.front().get();
 }
 
 utility::Encoding SearchInFile::TextSearchEncoding()
@@ -190,25 +415,207 @@ SearchInFile::Options SearchInFile::SearchOptions() const
     return m_SearchOptions;
 }
 
-static bool IsWholePhrase(CFStringRef _string, CFRange _range)
+bool SearchInFile::IsWholePhrase(std::span<const std::byte> _window, size_t _offset, size_t _length) const
 {
     static const auto alphanumeric = CFCharacterSetGetPredefined(kCFCharacterSetAlphaNumeric);
-    assert(_range.length > 0);
-    assert(_range.location >= 0);
+    assert(_length > 0);
+    const auto is_alphanumeric = [](std::optional<char32_t> _char) {
+        return _char && CFCharacterSetIsLongCharacterMember(alphanumeric, *_char);
+    };
+    return !is_alphanumeric(DecodeBefore(_window, _offset, m_TextSearchEncoding)) &&
+           !is_alphanumeric(DecodeAt(_window, _offset + _length, m_TextSearchEncoding));
+}
+
+static std::vector<char32_t> CodePoints(CFStringRef _string)
+{
+    const CFIndex length = CFStringGetLength(_string);
+    std::vector<UniChar> units(length);
+    CFStringGetCharacters(_string, CFRangeMake(0, length), units.data());
+
+    std::vector<char32_t> points;
+    points.reserve(units.size());
+    for( CFIndex i = 0; i < length; ++i ) {
+        if( i + 1 < length && CFStringIsSurrogateHighCharacter(units[i]) &&
+            CFStringIsSurrogateLowCharacter(units[i + 1]) ) {
+            points.push_back(CFStringGetLongCharacterForSurrogatePair(units[i], units[i + 1]));
+            ++i;
+        }
+        else {
+            points.push_back(units[i]);
+        }
+    }
+    return points;
+}
+
+// Returns the character with the changed case or nothing if it would become several characters, e.g. 'ß' -> "SS".
+static std::optional<char32_t> ChangeCase(char32_t _char, bool _to_upper)
+{
+    UniChar units[2];
+    const CFIndex units_count = CFStringGetSurrogatePairForLongCharacter(_char, units) ? 2 : 1;
+    const auto string = base::CFPtr<CFMutableStringRef>::adopt(CFStringCreateMutable(nullptr, 0));
+    CFStringAppendCharacters(string.get(), units, units_count);
+    if( _to_upper )
+        CFStringUppercase(string.get(), nullptr);
+    else
+        CFStringLowercase(string.get(), nullptr);
+    const auto points = CodePoints(string.get());
+    return points.size() == 1 ? std::optional<char32_t>{points.front()} : std::nullopt;
+}
+
+// Returns _char along with all the characters it can turn into by changing the case
+static std::vector<char32_t> CaseVariants(char32_t _char)
+{
+    std::vector<char32_t> variants{_char};
+    for( size_t i = 0; i < variants.size(); ++i )
+        for( const bool to_upper : {false, true} )
+            if( const auto changed = ChangeCase(variants[i], to_upper);
+                changed && std::ranges::find(variants, *changed) == variants.end() )
+                variants.push_back(*changed);
+    return variants;
+}
+
+static bool IsSingleByte(utility::Encoding _encoding) noexcept
+{
+    return _encoding >= utility::Encoding::ENCODING_SINGLE_BYTES_FIRST__ &&
+           _encoding <= utility::Encoding::ENCODING_SINGLE_BYTES_LAST__;
+}
+
+static std::array<uint16_t, 256> SingleByteTable(utility::Encoding _encoding)
+{
+    std::array<uint16_t, 256> table = {};
+    if( IsSingleByte(_encoding) ) {
+        std::array<unsigned char, 256> bytes;
+        std::iota(bytes.begin(), bytes.end(), 0);
+        utility::InterpretSingleByteBufferAsUniCharPreservingBufferSize(
+            bytes.data(), bytes.size(), table.data(), _encoding);
+    }
+    return table;
+}
+
+static std::string EncodeUTF8(char32_t _char)
+{
+    std::string bytes;
+    if( _char < 0x80 ) {
+        bytes += static_cast<char>(_char);
+    }
+    else if( _char < 0x800 ) {
+        bytes += static_cast<char>(0xC0 | (_char >> 6));
+        bytes += static_cast<char>(0x80 | (_char & 0x3F));
+    }
+    else if( _char < 0x10000 ) {
+        bytes += static_cast<char>(0xE0 | (_char >> 12));
+        bytes += static_cast<char>(0x80 | ((_char >> 6) & 0x3F));
+        bytes += static_cast<char>(0x80 | (_char & 0x3F));
+    }
+    else {
+        bytes += static_cast<char>(0xF0 | (_char >> 18));
+        bytes += static_cast<char>(0x80 | ((_char >> 12) & 0x3F));
+        bytes += static_cast<char>(0x80 | ((_char >> 6) & 0x3F));
+        bytes += static_cast<char>(0x80 | (_char & 0x3F));
+    }
+    return bytes;
+}
+
+static std::string EncodeUTF16(char32_t _char, bool _big_endian)
+{
+    UniChar units[2];
+    const size_t units_count = CFStringGetSurrogatePairForLongCharacter(_char, units) ? 2 : 1;
+    std::string bytes;
+    for( size_t i = 0; i < units_count; ++i ) {
+        const char low = static_cast<char>(units[i] & 0xFF);
+        const char high = static_cast<char>(units[i] >> 8);
+        bytes += _big_endian ? high : low;
+        bytes += _big_endian ? low : high;
+    }
+    return bytes;
+}
+
+// Returns all byte sequences representing _char in _encoding, none if it can't be represented
+static std::vector<std::string>
+Encode(char32_t _char, utility::Encoding _encoding, const std::array<uint16_t, 256> &_single_bytes)
+{
+    using utility::Encoding;
+    if( _encoding == Encoding::ENCODING_UTF8 )
+        return {EncodeUTF8(_char)};
+    if( _encoding == Encoding::ENCODING_UTF16LE )
+        return {EncodeUTF16(_char, false)};
+    if( _encoding == Encoding::ENCODING_UTF16BE )
+        return {EncodeUTF16(_char, true)};
+    std::vector<std::string> forms;
+    if( IsSingleByte(_encoding) )
+        for( size_t byte = 0; byte < _single_bytes.size(); ++byte )
+            if( _single_bytes[byte] == _char )
+                forms.emplace_back(1, static_cast<char>(byte));
+    return forms;
+}
+
+static uint8_t ByteAt(std::span<const std::byte> _bytes, size_t _pos) noexcept
+{
+    return static_cast<uint8_t>(_bytes[_pos]);
+}
+
+static std::optional<char32_t> DecodeAt(std::span<const std::byte> _bytes, size_t _pos, utility::Encoding _encoding)
+{
+    using utility::Encoding;
+    if( _pos >= _bytes.size() )
+        return std::nullopt;
+
+    if( _encoding == Encoding::ENCODING_UTF16LE || _encoding == Encoding::ENCODING_UTF16BE ) {
+        if( _pos + 2 > _bytes.size() )
+            return std::nullopt;
+        const bool big_endian = _encoding == Encoding::ENCODING_UTF16BE;
+        const uint8_t b0 = ByteAt(_bytes, _pos);
+        const uint8_t b1 = ByteAt(_bytes, _pos + 1);
+        return big_endian ? char32_t((b0 << 8) | b1) : char32_t((b1 << 8) | b0);
+    }
+
+    if( _encoding == Encoding::ENCODING_UTF8 ) {
+        const uint8_t lead = ByteAt(_bytes, _pos);
+        if( lead < 0x80 )
+            return lead;
+        if( lead < 0xC2 || lead > 0xF4 )
+            return std::nullopt;
+        const size_t length = lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : 2);
+        char32_t c = lead & (0x7F >> length);
+        if( _pos + length > _bytes.size() )
+            return std::nullopt;
+        for( size_t i = 1; i < length; ++i ) {
+            const uint8_t b = ByteAt(_bytes, _pos + i);
+            if( (b & 0xC0) != 0x80 )
+                return std::nullopt;
+            c = (c << 6) | (b & 0x3F);
+        }
+        return c;
+    }
 
-    if( _range.location > 0 ) {
-        const auto character = CFStringGetCharacterAtIndex(_string, _range.location - 1);
-        if( CFCharacterSetIsCharacterMember(alphanumeric, character) )
-            return false;
+    if( IsSingleByte(_encoding) ) {
+        const unsigned char byte = ByteAt(_bytes, _pos);
+        unsigned short c = 0;
+        utility::InterpretSingleByteBufferAsUniCharPreservingBufferSize(&byte, 1, &c, _encoding);
+        return c;
     }
 
-    if( _range.location + _range.length < CFStringGetLength(_string) ) {
-        const auto character = CFStringGetCharacterAtIndex(_string, _range.location + _range.length);
-        if( CFCharacterSetIsCharacterMember(alphanumeric, character) )
-            return false;
+    return std::nullopt;
+}
+
+static std::optional<char32_t> DecodeBefore(std::span<const std::byte> _bytes, size_t _pos, utility::Encoding _encoding)
+{
+    using utility::Encoding;
+    if( _pos == 0 || _pos > _bytes.size() )
+        return std::nullopt;
+
+    if( _encoding == Encoding::ENCODING_UTF16LE || _encoding == Encoding::ENCODING_UTF16BE )
+        return _pos >= 2 ? DecodeAt(_bytes, _pos - 2, _encoding) : std::nullopt;
+
+    if( _encoding == Encoding::ENCODING_UTF8 ) {
+        // step back over the continuation bytes to the lead one
+        size_t lead = _pos - 1;
+        while( lead > 0 && _pos - lead < 4 && (ByteAt(_bytes, lead) & 0xC0) == 0x80 )
+            --lead;
+        return DecodeAt(_bytes, lead, _encoding);
     }
 
-    return true;
+    return DecodeAt(_bytes, _pos - 1, _encoding);
 }
 
 } // namespace nc::vfs
@@ -0,0 +1,151 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "SegmentedDownload.h"
+#include <VFS/VFSError.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace nc::vfs {
+
+unsigned SegmentedDownload::WorkersFor(uint64_t _size) noexcept
+{
+    // below two chunks the handshakes of extra connections would cost more than they'd bring
+    if( _size < 2 * ChunkSize )
+        return 0;
+    return static_cast<unsigned>(std::min<uint64_t>(MaxWorkers, (_size + ChunkSize - 1) / ChunkSize));
+}
+
+SegmentedDownload::SegmentedDownload(uint64_t _size, unsigned _workers, FetcherFactory _factory)
+    : m_Size(_size), m_Window(2 * std::max(_workers, 1u)), m_Factory(std::move(_factory))
+{
+    const unsigned workers = std::max(_workers, 1u);
+    m_LiveWorkers = workers;
+    for( unsigned i = 0; i < workers; ++i )
+        m_Workers.emplace_back([this] { Work(); });
+}
+
+SegmentedDownload::~SegmentedDownload()
+{
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        m_Stop = true;
+        for( auto &chunk : m_Chunks )
+            chunk.second->abandoned = true;
+    }
+    m_Changed.notify_all();
+    for( auto &worker : m_Workers )
+        worker.join();
+}
+
+uint64_t SegmentedDownload::ChunksNumber() const noexcept
+{
+    return (m_Size + ChunkSize - 1) / ChunkSize;
+}
+
+uint64_t SegmentedDownload::WindowEnd() const noexcept
+{
+    return std::min(m_ReadChunk + m_Window, ChunksNumber());
+}
+
+std::optional<uint64_t> SegmentedDownload::ClaimableChunk() const noexcept
+{
+    for( uint64_t index = m_ReadChunk, end = WindowEnd(); index < end; ++index )
+        if( !m_Chunks.contains(index) )
+            return index;
+    return std::nullopt;
+}
+
+SegmentedDownload::Chunks::iterator SegmentedDownload::Abandon(Chunks::iterator _it)
+{
+    _it->second->abandoned = true; // the worker fetching it, if any, will stop upon the next portion of data
+    return m_Chunks.erase(_it);
+}
+
+void SegmentedDownload::Work()
+{
+    std::unique_ptr<Fetcher> fetcher = m_Factory();
+
+    auto lock = std::unique_lock{m_Lock};
+    while( fetcher ) {
+        m_Changed.wait(lock, [this] { return m_Stop || ClaimableChunk(); });
+        if( m_Stop )
+            break;
+
+        const uint64_t index = *ClaimableChunk();
+        auto chunk = std::make_shared<Chunk>();
+        chunk->length = std::min(ChunkSize, m_Size - (index * ChunkSize));
+        chunk->data = std::make_unique_for_overwrite<std::byte[]>(chunk->length);
+        m_Chunks.emplace(index, chunk);
+        lock.unlock();
+
+        // only this worker writes into the chunk, the readers never touch the bytes beyond chunk->filled
+        size_t received = 0;
+        const int rc = fetcher->Fetch(index * ChunkSize, chunk->length, [&](const void *_data, size_t _size) {
+            const size_t size = std::min(_size, chunk->length - received);
+            std::memcpy(chunk->data.get() + received, _data, size);
+            received += size;
+            const auto guard = std::lock_guard{m_Lock};
+            if( chunk->abandoned )
+                return false;
+            chunk->filled = received;
+            m_Changed.notify_all();
+            return true;
+        });
+
+        lock.lock();
+        if( rc == VFSError::FromErrno(ECONNREFUSED) && received == 0 && m_LiveWorkers > 1 ) {
+            // the server already has as many connections as it allows, the remaining workers will do with those
+            if( const auto it = m_Chunks.find(index); it != m_Chunks.end() && it->second == chunk )
+                m_Chunks.erase(it);
+            break;
+        }
+        if( !chunk->abandoned && received < chunk->length )
+            chunk->error = rc != VFSError::Ok ? rc : VFSError::UnexpectedEOF;
+        m_Changed.notify_all();
+    }
+
+    --m_LiveWorkers;
+    m_Changed.notify_all();
+    lock.unlock();
+    fetcher.reset(); // lets it return its connection without blocking the others
+}
+
+ssize_t SegmentedDownload::Read(uint64_t _offset, void *_buf, size_t _size)
+{
+    if( _offset >= m_Size || _size == 0 )
+        return 0;
+
+    const uint64_t index = _offset / ChunkSize;
+    const size_t in_chunk = _offset % ChunkSize;
+
+    auto lock = std::unique_lock{m_Lock};
+    if( index != m_ReadChunk ) {
+        m_ReadChunk = index;
+        for( auto it = m_Chunks.begin(); it != m_Chunks.end(); )
+            it = it->first < index || it->first >= WindowEnd() ? Abandon(it) : std::next(it);
+        m_Changed.notify_all();
+    }
+
+    while( true ) {
+        if( const auto it = m_Chunks.find(index); it != m_Chunks.end() ) {
+            const Chunk &chunk = *it->second;
+            if( chunk.filled > in_chunk ) {
+                const size_t size = std::min(_size, chunk.filled - in_chunk);
+                std::memcpy(_buf, chunk.data.get() + in_chunk, size);
+                return static_cast<ssize_t>(size);
+            }
+            if( chunk.error != VFSError::Ok ) {
+                const int error = chunk.error;
+                m_Chunks.erase(it); // will be claimed again
+                m_Changed.notify_all();
+                return error;
+            }
+        }
+        else if( m_LiveWorkers == 0 ) {
+            return VFSError::FromErrno(EIO);
+        }
+        m_Changed.wait(lock);
+    }
+}
+
+} // namespace nc::vfs
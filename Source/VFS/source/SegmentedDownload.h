@@ -0,0 +1,92 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sys/types.h>
+#include <thread>
+#include <vector>
+
+namespace nc::vfs {
+
+// Downloads a remote file of a known size as a sequence of chunks fetched in parallel by several workers, each one
+// over its own connection, and reassembles them in order. A read proceeds as soon as the data at its position arrives.
+// Only a window of chunks starting at the last read position is fetched and kept in memory, seeking elsewhere
+// abandons the chunks outside of the new window.
+class SegmentedDownload
+{
+public:
+    // Transfers ranges of the file over a single connection, owned by one worker for its whole lifetime.
+    class Fetcher
+    {
+    public:
+        using Sink = std::function<bool(const void *_data, size_t _size)>;
+        virtual ~Fetcher() = default;
+
+        // Fetches [_offset, _offset + _length) and passes the data to _sink in order as it arrives.
+        // Returns VFSError::Ok once all the data was passed, stops and returns VFSError::Cancelled once _sink returns
+        // false or some other VFSError upon a failure. Returns VFSError::FromErrno(ECONNREFUSED) if the server didn't
+        // let the connection in, then the worker leaves the chunk to the others and quits unless it's the last one.
+        virtual int Fetch(uint64_t _offset, uint64_t _length, const Sink &_sink) = 0;
+    };
+
+    // Called by each worker upon start, returning nullptr stops that worker.
+    using FetcherFactory = std::function<std::unique_ptr<Fetcher>()>;
+
+    static constexpr uint64_t ChunkSize = 4 * 1024 * 1024;
+    static constexpr unsigned MaxWorkers = 4;
+
+    // Returns the number of workers worth spawning for a file of the specified size, or 0 if the file is small
+    // enough for a single stream to do better.
+    static unsigned WorkersFor(uint64_t _size) noexcept;
+
+    // Starts fetching right away.
+    SegmentedDownload(uint64_t _size, unsigned _workers, FetcherFactory _factory);
+
+    // Abandons the pending transfers and waits for the workers to finish.
+    ~SegmentedDownload();
+
+    // Blocks until the data at _offset arrives and copies up to _size bytes of it.
+    // Returns the number of bytes copied, 0 at the end of file or a negative VFSError.
+    // A failed chunk is fetched again upon the next read.
+    ssize_t Read(uint64_t _offset, void *_buf, size_t _size);
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t length = 0;
+        size_t filled = 0;      // [0, filled) is readable, guarded by m_Lock
+        int error = 0;          // guarded by m_Lock
+        bool abandoned = false; // guarded by m_Lock
+    };
+
+    using Chunks = std::map<uint64_t, std::shared_ptr<Chunk>>; // claimed chunks, by index
+
+    SegmentedDownload(const SegmentedDownload &) = delete;
+    void operator=(const SegmentedDownload &) = delete;
+    void Work();
+    uint64_t ChunksNumber() const noexcept;
+    uint64_t WindowEnd() const noexcept;
+    std::optional<uint64_t> ClaimableChunk() const noexcept;
+    Chunks::iterator Abandon(Chunks::iterator _it);
+
+    const uint64_t m_Size;
+    const uint64_t m_Window; // number of chunks fetched ahead of the read position, including it
+    const FetcherFactory m_Factory;
+
+    std::mutex m_Lock;
+    std::condition_variable m_Changed;
+    Chunks m_Chunks;
+    uint64_t m_ReadChunk = 0;
+    unsigned m_LiveWorkers = 0;
+    bool m_Stop = false;
+    std::vector<std::thread> m_Workers;
+};
+
+} // namespace nc::vfs
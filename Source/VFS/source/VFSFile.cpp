@@ -170,6 +170,8 @@ std::expected<void, nc::Error> VFSFile::WriteFile(const void *_d, size_t _sz)
             return std::unexpected(VFSError::ToError(static_cast<int>(r)));
         }
     }
+    if( const int rc = Flush(); rc != VFSError::Ok )
+        return std::unexpected(VFSError::ToError(rc));
     return {};
 }
 
@@ -201,6 +203,11 @@ int VFSFile::SetUploadSize([[maybe_unused]] size_t _size)
     return 0;
 }
 
+int VFSFile::Flush()
+{
+    return VFSError::Ok;
+}
+
 int VFSFile::SetLastError(int _error) const
 {
     SetLastError(VFSError::ToError(_error));
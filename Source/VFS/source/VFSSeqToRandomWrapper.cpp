@@ -6,6 +6,7 @@
 #include <Utility/SystemInformation.h>
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <climits>
 #include <cstddef>
 #include <cstdio>
@@ -14,12 +15,114 @@
 #include <sys/param.h>
 #include <unistd.h>
 
+static constexpr size_t g_ChunkSize = 256ULL * 1024ULL;
+
 VFSSeqToRandomROWrapperFile::Backend::~Backend()
 {
+    if( m_Filler.joinable() ) {
+        m_Stop = true;
+        m_Filler.join();
+    }
     if( m_FD >= 0 )
         close(m_FD);
 }
 
+int VFSSeqToRandomROWrapperFile::Backend::Fill(VFSFile &_seq_file,
+                                               const VFSCancelChecker &_cancel_checker,
+                                               const ProgressCallback &_progress)
+{
+    const auto finish = [this](int _result) {
+        {
+            const std::lock_guard lock{m_Lock};
+            m_Done = true;
+            m_Result = _result;
+        }
+        m_Arrived.notify_all();
+        return _result;
+    };
+
+    std::unique_ptr<uint8_t[]> buf;
+    if( !m_DataBuf )
+        buf = std::make_unique<uint8_t[]>(g_ChunkSize);
+
+    uint64_t fetched = 0;
+    while( fetched < static_cast<uint64_t>(m_Size) ) {
+        if( m_Stop || (_cancel_checker && _cancel_checker()) )
+            return finish(VFSError::Cancelled);
+
+        // the memory buffer is filled in place, readers never touch the bytes beyond the frontier
+        uint8_t *const dst = m_DataBuf ? &m_DataBuf[fetched] : buf.get();
+        const ssize_t res = _seq_file.Read(dst, std::min<uint64_t>(g_ChunkSize, m_Size - fetched));
+        if( res < 0 )
+            return finish(static_cast<int>(res));
+        if( res == 0 )
+            return finish(VFSError::UnexpectedEOF);
+
+        for( ssize_t written = 0; !m_DataBuf && written < res; ) {
+            const ssize_t res_write = pwrite(m_FD, dst + written, res - written, fetched + written);
+            if( res_write < 0 )
+                return finish(VFSError::FromErrno(errno));
+            written += res_write;
+        }
+
+        fetched += res;
+        {
+            // taking the lock orders the update against a reader which is about to start waiting
+            const std::lock_guard lock{m_Lock};
+            m_Fetched.store(fetched, std::memory_order_release);
+        }
+        m_Arrived.notify_all();
+
+        if( _progress )
+            _progress(fetched, m_Size);
+    }
+
+    return finish(VFSError::Ok);
+}
+
+int VFSSeqToRandomROWrapperFile::WaitFor(uint64_t _bytes)
+{
+    Backend &b = *m_Backend;
+    if( b.m_Fetched.load(std::memory_order_acquire) >= _bytes )
+        return VFSError::Ok;
+
+    std::unique_lock lock{b.m_Lock};
+    while( b.m_Fetched.load(std::memory_order_acquire) < _bytes ) {
+        if( b.m_Done )
+            return b.m_Result != VFSError::Ok ? b.m_Result : VFSError::UnexpectedEOF;
+        if( m_NonBlocking )
+            return VFSError::FromErrno(EAGAIN);
+
+        lock.unlock();
+        if( IsCancelled() )
+            return VFSError::Cancelled; // only this reader gives up, the fetching goes on for the others
+        lock.lock();
+
+        // the cancellation checker is polled, hence the timeout
+        if( b.m_Fetched.load(std::memory_order_acquire) < _bytes && !b.m_Done )
+            b.m_Arrived.wait_for(lock, std::chrono::milliseconds(100));
+
+        const uint64_t fetched = b.m_Fetched.load(std::memory_order_acquire);
+        lock.unlock();
+        ReportProgress(fetched);
+        lock.lock();
+    }
+    return VFSError::Ok;
+}
+
+bool VFSSeqToRandomROWrapperFile::IsCancelled()
+{
+    const std::lock_guard lock{m_CallbacksLock};
+    return m_CancelChecker && m_CancelChecker();
+}
+
+void VFSSeqToRandomROWrapperFile::ReportProgress(uint64_t _fetched)
+{
+    const std::lock_guard lock{m_CallbacksLock};
+    if( m_Progress )
+        m_Progress(_fetched, m_Backend->m_Size);
+}
+
 VFSSeqToRandomROWrapperFile::VFSSeqToRandomROWrapperFile(const VFSFilePtr &_file_to_wrap)
     : VFSFile(_file_to_wrap->Path(), _file_to_wrap->Host()), m_SeqFile(_file_to_wrap)
 {
@@ -39,62 +142,79 @@ VFSSeqToRandomROWrapperFile::~VFSSeqToRandomROWrapperFile()
 
 int VFSSeqToRandomROWrapperFile::Open(unsigned long _flags,
                                       const VFSCancelChecker &_cancel_checker,
-                                      std::function<void(uint64_t _bytes_proc, uint64_t _bytes_total)> _progress)
+                                      ProgressCallback _progress)
 {
-    const int ret = OpenBackend(_flags, _cancel_checker, _progress);
-    return ret;
+    auto ggg = at_scope_end([this] { m_SeqFile.reset(); }); // ony any result wrapper won't hold any reference to
+                                                            // VFSFile after this function ends
+    std::expected<std::shared_ptr<Backend>, int> backend = OpenBackend(_flags);
+    if( !backend )
+        return backend.error();
+
+    if( const int res = (*backend)->Fill(*m_SeqFile, _cancel_checker, _progress); res != VFSError::Ok )
+        return res;
+
+    m_Backend = *backend;
+    m_Pos = 0;
+    return VFSError::Ok;
 }
 
-int VFSSeqToRandomROWrapperFile::OpenBackend(unsigned long _flags,
-                                             VFSCancelChecker _cancel_checker,
-                                             std::function<void(uint64_t _bytes_proc, uint64_t _bytes_total)> _progress)
+int VFSSeqToRandomROWrapperFile::OpenStreaming(unsigned long _flags,
+                                               const VFSCancelChecker &_cancel_checker,
+                                               ProgressCallback _progress)
+{
+    auto ggg = at_scope_end([this] { m_SeqFile.reset(); }); // the filler thread keeps its own reference
+    std::expected<std::shared_ptr<Backend>, int> backend = OpenBackend(_flags);
+    if( !backend )
+        return backend.error();
+
+    {
+        const std::lock_guard lock{m_CallbacksLock};
+        m_CancelChecker = _cancel_checker;
+        m_Progress = std::move(_progress);
+    }
+    // the backend joins the thread upon destruction, so the raw pointer outlives it
+    Backend &b = **backend;
+    b.m_Filler = std::thread([backend = &b, seq_file = m_SeqFile] { backend->Fill(*seq_file, nullptr, nullptr); });
+
+    m_Backend = *backend;
+    m_Pos = 0;
+    return VFSError::Ok;
+}
+
+void VFSSeqToRandomROWrapperFile::ResetCallbacks()
+{
+    const std::lock_guard lock{m_CallbacksLock};
+    m_CancelChecker = nullptr;
+    m_Progress = nullptr;
+}
+
+void VFSSeqToRandomROWrapperFile::SetNonBlocking(bool _non_blocking) noexcept
+{
+    m_NonBlocking = _non_blocking;
+}
+
+std::expected<std::shared_ptr<VFSSeqToRandomROWrapperFile::Backend>, int>
+VFSSeqToRandomROWrapperFile::OpenBackend(unsigned long _flags)
 {
-    auto ggg = at_scope_end([this] { m_SeqFile.reset(); }); // ony any result wrapper won't hold any reference to
-                                                            // VFSFile after this function ends
     if( !m_SeqFile )
-        return VFSError::InvalidCall;
+        return std::unexpected(VFSError::InvalidCall);
     if( m_SeqFile->GetReadParadigm() < VFSFile::ReadParadigm::Sequential )
-        return VFSError::InvalidCall;
+        return std::unexpected(VFSError::InvalidCall);
 
     if( !m_SeqFile->IsOpened() ) {
         const int res = m_SeqFile->Open(_flags);
         if( res < 0 )
-            return res;
+            return std::unexpected(res);
     }
     else if( m_SeqFile->Pos() > 0 )
-        return VFSError::InvalidCall;
+        return std::unexpected(VFSError::InvalidCall);
 
     auto backend = std::make_shared<Backend>();
-    m_Pos = 0;
+    backend->m_Size = m_SeqFile->Size();
 
-    if( m_SeqFile->Size() <= MaxCachedInMem ) {
+    if( backend->m_Size <= MaxCachedInMem ) {
         // we just read a whole file into a memory buffer
-
-        backend->m_Size = m_SeqFile->Size();
         backend->m_DataBuf = std::make_unique<uint8_t[]>(backend->m_Size);
-
-        const size_t max_io = 256ULL * 1024ULL;
-        uint8_t *d = &backend->m_DataBuf[0];
-        uint8_t *e = d + backend->m_Size;
-        ssize_t res = 0;
-        while( d < e && (res = m_SeqFile->Read(d, std::min(e - d, static_cast<long>(max_io)))) > 0 ) {
-            d += res;
-
-            if( _cancel_checker && _cancel_checker() )
-                return VFSError::Cancelled;
-
-            if( _progress )
-                _progress(d - &backend->m_DataBuf[0], backend->m_Size);
-        }
-
-        if( _cancel_checker && _cancel_checker() )
-            return VFSError::Cancelled;
-
-        if( res < 0 )
-            return static_cast<int>(res);
-
-        if( res == 0 && d != e )
-            return VFSError::UnexpectedEOF;
     }
     else {
         // we need to write it into a temp dir and delete it upon finish
@@ -104,49 +224,16 @@ int VFSSeqToRandomROWrapperFile::OpenBackend(unsigned long _flags,
         const int fd = mkstemp(pattern_buf.data());
 
         if( fd < 0 )
-            return VFSError::FromErrno(errno);
+            return std::unexpected(VFSError::FromErrno(errno));
 
         unlink(pattern_buf.c_str()); // preemtive unlink - OS will remove inode upon last descriptor closing
 
         fcntl(fd, F_NOCACHE, 1); // don't need to cache this temporaral stuff
 
         backend->m_FD = fd;
-        backend->m_Size = m_SeqFile->Size();
-
-        constexpr uint64_t bufsz = 256ULL * 1024ULL;
-        const std::unique_ptr<char[]> buf = std::make_unique<char[]>(bufsz);
-        const uint64_t left_read = backend->m_Size;
-        ssize_t res_read;
-        ssize_t total_wrote = 0;
-
-        while( (res_read = m_SeqFile->Read(buf.get(), std::min(bufsz, left_read))) > 0 ) {
-            if( _cancel_checker && _cancel_checker() )
-                return VFSError::Cancelled;
-
-            ssize_t res_write;
-            while( res_read > 0 ) {
-                res_write = write(backend->m_FD, buf.get(), res_read);
-                if( res_write >= 0 ) {
-                    res_read -= res_write;
-                    total_wrote += res_write;
-
-                    if( _progress )
-                        _progress(total_wrote, backend->m_Size);
-                }
-                else
-                    return VFSError::FromErrno(errno);
-            }
-        }
-
-        if( res_read < 0 )
-            return static_cast<int>(res_read);
-
-        if( res_read == 0 && total_wrote != backend->m_Size )
-            return VFSError::UnexpectedEOF;
     }
 
-    m_Backend = backend;
-    return VFSError::Ok;
+    return backend;
 }
 
 int VFSSeqToRandomROWrapperFile::Open(unsigned long _flags, const VFSCancelChecker &_cancel_checker)
@@ -157,13 +244,7 @@ int VFSSeqToRandomROWrapperFile::Open(unsigned long _flags, const VFSCancelCheck
 int VFSSeqToRandomROWrapperFile::Close()
 {
     m_SeqFile.reset();
-    m_Backend.reset();
-    //    m_DataBuf.reset();
-    //    if(m_FD >= 0) {
-    //        close(m_FD);
-    //        m_FD = -1;
-    //    }
-    //    m_Ready = false;
+    m_Backend.reset(); // the last instance stops the filler, if any
     return VFSError::Ok;
 }
 
@@ -201,9 +282,13 @@ bool VFSSeqToRandomROWrapperFile::IsOpened() const
 ssize_t VFSSeqToRandomROWrapperFile::Read(void *_buf, size_t _size)
 {
     const std::expected<size_t, nc::Error> result = ReadAt(m_Pos, _buf, _size);
-    if( result )
-        m_Pos += *result;
-    return /*result*/ -1; // TODO: return result
+    if( !result ) {
+        const nc::Error &err = result.error();
+        return SetLastError(err.Domain() == nc::Error::POSIX ? VFSError::FromErrno(static_cast<int>(err.Code()))
+                                                              : static_cast<int>(err.Code()));
+    }
+    m_Pos += *result;
+    return *result;
 }
 
 std::expected<size_t, nc::Error> VFSSeqToRandomROWrapperFile::ReadAt(off_t _pos, void *_buf, size_t _size)
@@ -214,19 +299,20 @@ std::expected<size_t, nc::Error> VFSSeqToRandomROWrapperFile::ReadAt(off_t _pos,
     if( _pos < 0 || _pos > m_Backend->m_Size )
         return std::unexpected(nc::Error{nc::Error::POSIX, EINVAL});
 
+    const ssize_t toread = std::min(m_Backend->m_Size - _pos, static_cast<off_t>(_size));
+    if( const int res = WaitFor(_pos + toread); res != VFSError::Ok )
+        return std::unexpected(VFSError::ToError(res));
+
     if( m_Backend->m_DataBuf ) {
-        const ssize_t toread = std::min(m_Backend->m_Size - _pos, static_cast<off_t>(_size));
         memcpy(_buf, &m_Backend->m_DataBuf[_pos], toread);
         return toread;
     }
     else if( m_Backend->m_FD >= 0 ) {
-        const ssize_t toread = std::min(m_Backend->m_Size - _pos, static_cast<off_t>(_size));
         const ssize_t res = pread(m_Backend->m_FD, _buf, toread, _pos);
         if( res >= 0 )
             return res;
         else
             return std::unexpected(nc::Error{nc::Error::POSIX, errno});
-        ;
     }
     assert(0);
     return std::unexpected(nc::Error{nc::Error::POSIX, EINVAL});
@@ -256,9 +342,18 @@ off_t VFSSeqToRandomROWrapperFile::Seek(off_t _off, int _basis)
     return m_Pos;
 }
 
-std::shared_ptr<VFSSeqToRandomROWrapperFile> VFSSeqToRandomROWrapperFile::Share()
+uint64_t VFSSeqToRandomROWrapperFile::Fetched() const noexcept
+{
+    return m_Backend ? m_Backend->m_Fetched.load(std::memory_order_acquire) : 0;
+}
+
+std::shared_ptr<VFSSeqToRandomROWrapperFile>
+VFSSeqToRandomROWrapperFile::Share(const VFSCancelChecker &_cancel_checker)
 {
     if( !IsOpened() )
         return nullptr;
-    return std::shared_ptr<VFSSeqToRandomROWrapperFile>(new VFSSeqToRandomROWrapperFile(Path(), Host(), m_Backend));
+    auto shared =
+        std::shared_ptr<VFSSeqToRandomROWrapperFile>(new VFSSeqToRandomROWrapperFile(Path(), Host(), m_Backend));
+    shared->m_CancelChecker = _cancel_checker;
+    return shared;
 }
@@ -0,0 +1,245 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "../source/ConnectionPool.h"
+#include <atomic>
+#include <future>
+#include <numeric>
+
+using namespace std::chrono_literals;
+
+#define PREFIX "nc::vfs::ConnectionPool "
+
+namespace {
+
+struct Server {
+    std::atomic_int spawned = 0;
+    std::atomic_int recycled = 0;
+    std::atomic_int probed = 0;
+    std::atomic_bool alive = true; // false makes all the existing connections dead
+};
+
+struct Connection {
+    int id = 0;
+    bool dirty = false;
+    std::shared_ptr<std::atomic_bool> alive;
+};
+
+using Pool = nc::vfs::ConnectionPool<Connection>;
+
+} // namespace
+
+static Pool::Traits TraitsFor(Server &_server)
+{
+    Pool::Traits traits;
+    traits.spawn = [&_server] {
+        auto c = std::make_unique<Connection>();
+        c->id = ++_server.spawned;
+        c->alive = std::make_shared<std::atomic_bool>(true);
+        return c;
+    };
+    traits.recycle = [&_server](Connection &_c) {
+        ++_server.recycled;
+        _c.dirty = false;
+    };
+    traits.probe = [&_server](Connection &_c) {
+        ++_server.probed;
+        return _server.alive && _c.alive->load();
+    };
+    return traits;
+}
+
+TEST_CASE(PREFIX "Returned connections are reused")
+{
+    Server server;
+    Pool pool({}, TraitsFor(server));
+    int id = 0;
+    {
+        auto lease = pool.Acquire();
+        CHECK(!lease.Reused());
+        id = lease->id;
+        lease->dirty = true;
+    }
+    CHECK(pool.IdleCount() == 1);
+    {
+        auto lease = pool.Acquire();
+        CHECK(lease.Reused());
+        CHECK(lease->id == id);
+        CHECK(!lease->dirty);
+    }
+    const auto metrics = pool.Metrics();
+    CHECK(metrics.acquires == 2);
+    CHECK(metrics.reuses == 1);
+    CHECK(metrics.connects == 1);
+    CHECK(server.recycled == 2);
+    CHECK(std::accumulate(metrics.acquire_latency.begin(), metrics.acquire_latency.end(), uint64_t{0}) == 2);
+}
+
+TEST_CASE(PREFIX "Preferred connections are picked first")
+{
+    Server server;
+    Pool pool({}, TraitsFor(server));
+    {
+        auto a = pool.Acquire();
+        auto b = pool.Acquire();
+    }
+    auto lease = pool.Acquire([](const Connection &_c) { return _c.id == 1; });
+    CHECK(lease->id == 1);
+    auto other = pool.Acquire([](const Connection &_c) { return _c.id == 1; });
+    CHECK(other->id == 2);
+}
+
+TEST_CASE(PREFIX "Acquisitions beyond the limit wait for a connection to return")
+{
+    Server server;
+    Pool::Options options;
+    options.max_connections = 2;
+    Pool pool(options, TraitsFor(server));
+    auto a = pool.Acquire();
+    auto b = pool.Acquire();
+    auto waiter = std::async(std::launch::async, [&] { return pool.Acquire()->id; });
+    CHECK(waiter.wait_for(50ms) == std::future_status::timeout);
+    const int id = a->id;
+    a = {};
+    CHECK(waiter.get() == id);
+    CHECK(server.spawned == 2);
+    CHECK(pool.Metrics().waits == 1);
+}
+
+TEST_CASE(PREFIX "Waiting for too long exceeds the limit")
+{
+    Server server;
+    Pool::Options options;
+    options.max_connections = 1;
+    options.max_wait = 20ms;
+    Pool pool(options, TraitsFor(server));
+    {
+        auto a = pool.Acquire();
+        auto b = pool.Acquire();
+        CHECK(a->id != b->id);
+    }
+    CHECK(pool.IdleCount() == 1); // the excess one is closed upon return
+    CHECK(pool.Metrics().evictions == 1);
+}
+
+TEST_CASE(PREFIX "Idle connections are closed after a timeout")
+{
+    Server server;
+    Pool::Options options;
+    options.idle_timeout = 20ms;
+    Pool pool(options, TraitsFor(server));
+    pool.Acquire();
+    std::this_thread::sleep_for(40ms);
+    auto lease = pool.Acquire();
+    CHECK(!lease.Reused());
+    CHECK(lease->id == 2);
+    CHECK(pool.Metrics().evictions == 1);
+}
+
+TEST_CASE(PREFIX "Idle connections are checked before reuse")
+{
+    Server server;
+    Pool::Options options;
+    options.check_after = 10ms;
+    Pool pool(options, TraitsFor(server));
+    pool.Acquire();
+
+    SECTION("Recent ones are not checked")
+    {
+        CHECK(pool.Acquire().Reused());
+        CHECK(server.probed == 0);
+    }
+    SECTION("Alive ones are reused")
+    {
+        std::this_thread::sleep_for(20ms);
+        CHECK(pool.Acquire().Reused());
+        CHECK(server.probed == 1);
+    }
+    SECTION("Dead ones are replaced")
+    {
+        std::this_thread::sleep_for(20ms);
+        server.alive = false;
+        auto lease = pool.Acquire();
+        CHECK(!lease.Reused());
+        CHECK(lease->id == 2);
+        const auto metrics = pool.Metrics();
+        CHECK(metrics.stale == 1);
+        CHECK(metrics.reconnects == 1);
+    }
+}
+
+TEST_CASE(PREFIX "Idle connections are pinged in background")
+{
+    Server server;
+    Pool::Options options;
+    options.ping_interval = 10ms;
+    Pool pool(options, TraitsFor(server));
+    std::shared_ptr<std::atomic_bool> first_alive;
+    {
+        auto a = pool.Acquire();
+        auto b = pool.Acquire();
+        first_alive = a->alive;
+    }
+    *first_alive = false;
+    for( int i = 0; i < 100 && pool.Metrics().stale == 0; ++i )
+        std::this_thread::sleep_for(10ms);
+    std::this_thread::sleep_for(30ms);
+
+    const auto metrics = pool.Metrics();
+    CHECK(metrics.pings >= 2);
+    CHECK(metrics.stale == 1);
+    CHECK(pool.IdleCount() == 1);
+    CHECK(pool.Acquire()->id == 2);
+}
+
+TEST_CASE(PREFIX "Requests failed over stale connections are retried once")
+{
+    Server server;
+    Pool pool({}, TraitsFor(server));
+    const auto is_stale = [](int _rc) { return _rc == -1; };
+    const auto request = [](Connection &_c) { return _c.alive->load() ? _c.id : -1; };
+
+    SECTION("Over a reused connection")
+    {
+        auto first = pool.Acquire();
+        first->alive->store(false);
+        first = {};
+        CHECK(pool.Run(request, is_stale) == 2);
+        const auto metrics = pool.Metrics();
+        CHECK(metrics.stale == 1);
+        CHECK(metrics.reconnects == 1);
+        CHECK(pool.IdleCount() == 1);
+    }
+    SECTION("Not over a fresh one")
+    {
+        int calls = 0;
+        CHECK(pool.Run(
+                  [&](Connection &) {
+                      ++calls;
+                      return -1;
+                  },
+                  is_stale) == -1);
+        CHECK(calls == 1);
+    }
+}
+
+TEST_CASE(PREFIX "Released connections don't count toward the limit")
+{
+    Server server;
+    Pool::Options options;
+    options.max_connections = 1;
+    Pool pool(options, TraitsFor(server));
+    auto released = pool.Acquire().Release();
+    {
+        auto lease = pool.Acquire();
+        CHECK(lease->id != released->id);
+        CHECK(pool.Metrics().waits == 0);
+        pool.Return(std::move(released)); // the pool is full meanwhile
+        CHECK(pool.Metrics().evictions == 1);
+    }
+    CHECK(pool.IdleCount() == 1);
+
+    released = pool.Acquire().Release();
+    pool.Return(std::move(released));
+    CHECK(pool.IdleCount() == 1);
+    CHECK(pool.Acquire().Reused());
+}
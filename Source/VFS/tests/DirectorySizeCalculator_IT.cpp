@@ -0,0 +1,150 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "TestEnv.h"
+#include "DirectorySizeCalculator.h"
+#include <VFS/Mem.h>
+#include <CoreFoundation/CoreFoundation.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+using nc::vfs::DirectorySizeCalculator;
+using namespace std::chrono_literals;
+
+#define PREFIX "[nc::vfs::DirectorySizeCalculator] "
+
+static void Save(const std::filesystem::path &_path, size_t _size)
+{
+    std::ofstream out(_path, std::ios::binary | std::ios::trunc);
+    out << std::string(_size, 'x');
+}
+
+// a: 100 + b/(200 + c/300 + a symlink) = 100 + 200 + 300 + strlen("../../target")
+static void BuildTree(const std::filesystem::path &_root)
+{
+    std::filesystem::create_directories(_root / "a" / "b" / "c");
+    Save(_root / "a" / "1.txt", 100);
+    Save(_root / "a" / "b" / "2.txt", 200);
+    Save(_root / "a" / "b" / "c" / "3.txt", 300);
+    std::filesystem::create_symlink("../../target", _root / "a" / "b" / "link");
+    std::filesystem::create_directories(_root / "d");
+    Save(_root / "d" / "4.txt", 400);
+}
+
+static bool RunMainLoopUntilExpectationOrTimeout(std::chrono::nanoseconds _timeout, std::function<bool()> _expectation)
+{
+    const auto start_tp = std::chrono::steady_clock::now();
+    const auto time_slice = 1. / 100.; // 10 ms;
+    while( true ) {
+        CFRunLoopRunInMode(kCFRunLoopDefaultMode, time_slice, false);
+        if( std::chrono::steady_clock::now() - start_tp > _timeout )
+            return false;
+        if( _expectation() )
+            return true;
+    }
+}
+
+static constexpr uint64_t g_SizeOfA = 100 + 200 + 300 + 12;
+static constexpr uint64_t g_SizeOfD = 400;
+
+TEST_CASE(PREFIX "Calculates the sizes of directories")
+{
+    const TestDir dir;
+    BuildTree(dir.directory);
+    auto &host = TestEnv().vfs_native;
+
+    for( const int workers : {1, 4} ) {
+        DirectorySizeCalculator calc;
+        calc.SetMaxWorkers(workers);
+        CHECK(calc.Calculate(host, (dir.directory / "a").native()) == g_SizeOfA);
+        CHECK(calc.Calculate(host, (dir.directory / "a/").native()) == g_SizeOfA);
+        CHECK(calc.Calculate(host, (dir.directory / "a" / "b" / "c").native()) == 300);
+        CHECK(calc.Calculate(host, dir.directory.native()) == g_SizeOfA + g_SizeOfD);
+    }
+}
+
+TEST_CASE(PREFIX "Reports each directory separately")
+{
+    const TestDir dir;
+    BuildTree(dir.directory);
+    auto &host = TestEnv().vfs_native;
+
+    const std::vector<std::string> paths = {(dir.directory / "a").native(),
+                                            "relative/path",
+                                            (dir.directory / "nonexistent").native(),
+                                            (dir.directory / "d").native(),
+                                            (dir.directory / "d" / "4.txt").native()};
+    std::mutex lock;
+    std::map<size_t, std::expected<uint64_t, nc::Error>> results;
+    DirectorySizeCalculator calc;
+    calc.Calculate(host, paths, [&](size_t _index, std::expected<uint64_t, nc::Error> _size) {
+        const auto guard = std::lock_guard{lock};
+        CHECK(!results.contains(_index));
+        results.emplace(_index, _size);
+    });
+
+    REQUIRE(results.size() == paths.size());
+    CHECK(results.at(0) == g_SizeOfA);
+    CHECK(results.at(1) == std::unexpected(nc::Error{nc::Error::POSIX, EINVAL}));
+    CHECK(results.at(2) == std::unexpected(nc::Error{nc::Error::POSIX, ENOENT}));
+    CHECK(results.at(3) == g_SizeOfD);
+    CHECK(results.at(4) == std::unexpected(nc::Error{nc::Error::POSIX, ENOTDIR}));
+}
+
+TEST_CASE(PREFIX "Reuses the unchanged directories and notices the changed ones")
+{
+    const TestDir dir;
+    BuildTree(dir.directory);
+    auto &host = TestEnv().vfs_native;
+    const auto a = (dir.directory / "a").native();
+
+    DirectorySizeCalculator calc;
+    REQUIRE(calc.Calculate(host, a) == g_SizeOfA);
+    CHECK(calc.CachedCount() == 3);
+    CHECK(calc.Calculate(host, (dir.directory / "a" / "b").native()) == g_SizeOfA - 100);
+    CHECK(calc.CachedCount() == 3);
+
+    // changing a file in place is noticed as well, the directories above and below are forgotten
+    Save(dir.directory / "a" / "b" / "2.txt", 1000);
+    REQUIRE(RunMainLoopUntilExpectationOrTimeout(5s, [&] { return calc.CachedCount() == 0; }));
+    CHECK(calc.Calculate(host, a) == g_SizeOfA + 800);
+    CHECK(calc.CachedCount() == 3);
+
+    Save(dir.directory / "a" / "b" / "c" / "5.txt", 500);
+    REQUIRE(RunMainLoopUntilExpectationOrTimeout(5s, [&] { return calc.CachedCount() == 0; }));
+    CHECK(calc.Calculate(host, a) == g_SizeOfA + 800 + 500);
+
+    calc.Invalidate(*host, (dir.directory / "a" / "b" / "c").native());
+    CHECK(calc.CachedCount() == 0);
+    CHECK(calc.Calculate(host, a) == g_SizeOfA + 800 + 500);
+
+    calc.Clear();
+    CHECK(calc.CachedCount() == 0);
+    CHECK(calc.Calculate(host, a) == g_SizeOfA + 800 + 500);
+}
+
+TEST_CASE(PREFIX "Doesn't remember anything on hosts which can't observe trees")
+{
+    const auto host = std::make_shared<nc::vfs::MemHost>();
+    REQUIRE(host->CreateDirectory("/a", 0755));
+    REQUIRE(host->WriteFile("/a/1.txt", std::string(100, 'x')));
+
+    DirectorySizeCalculator calc;
+    CHECK(calc.Calculate(host, "/a") == 100);
+    CHECK(calc.CachedCount() == 0);
+    REQUIRE(host->WriteFile("/a/1.txt", std::string(200, 'x')));
+    CHECK(calc.Calculate(host, "/a") == 200);
+}
+
+TEST_CASE(PREFIX "Can be cancelled")
+{
+    const TestDir dir;
+    BuildTree(dir.directory);
+    auto &host = TestEnv().vfs_native;
+
+    DirectorySizeCalculator calc;
+    CHECK(calc.Calculate(host, dir.directory.native(), [] { return true; }) ==
+          std::unexpected(nc::Error{nc::Error::POSIX, ECANCELED}));
+}
@@ -0,0 +1,61 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+// #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "Tests.h"
+#include "TestEnv.h"
+#include "DirectorySizeCalculator.h"
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+
+using nc::vfs::DirectorySizeCalculator;
+
+#define PREFIX "[nc::vfs::DirectorySizeCalculator] PT "
+
+// 200 directories * 100 files * 1KB = 20'000 files, 20MB.
+static constexpr int g_Dirs = 200;
+static constexpr int g_Files = 100;
+static constexpr size_t g_FileSize = 1024;
+
+static void BuildTree(const std::filesystem::path &_root)
+{
+    const std::string content(g_FileSize, 'x');
+    for( int d = 0; d < g_Dirs; ++d ) {
+        const auto dir = _root / fmt::format("module{}", d);
+        std::filesystem::create_directories(dir);
+        for( int f = 0; f < g_Files; ++f ) {
+            std::ofstream out(dir / fmt::format("source{}.cpp", f), std::ios::binary);
+            out << content;
+        }
+    }
+}
+
+TEST_CASE(PREFIX "recalculating an unchanged tree", "[!benchmark]")
+{
+    const TestDir dir;
+    BuildTree(dir.directory);
+    auto &host = TestEnv().vfs_native;
+    const std::string path = dir.directory.native();
+    constexpr uint64_t expected = uint64_t(g_Dirs) * g_Files * g_FileSize;
+
+    DirectorySizeCalculator calc;
+    const auto measure = [&] {
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(calc.Calculate(host, path) == expected);
+        return std::chrono::steady_clock::now() - start;
+    };
+    const auto cold = measure();
+    REQUIRE(calc.CachedCount() == g_Dirs + 1);
+    const auto hit = measure();
+    CHECK(hit * 10 < cold);
+
+    BENCHMARK("cold")
+    {
+        calc.Clear();
+        return calc.Calculate(host, path).value();
+    };
+    REQUIRE(calc.Calculate(host, path) == expected);
+    BENCHMARK("cached")
+    {
+        return calc.Calculate(host, path).value();
+    };
+}
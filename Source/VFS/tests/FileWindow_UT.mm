@@ -231,3 +231,38 @@ TEST_CASE(PREFIX "seek access")
         REQUIRE(cmp == 0);
     }
 }
+
+TEST_CASE(PREFIX "failed random access keeps the window")
+{
+    struct PartiallyReadableFile : TestGenericMemReadOnlyFile {
+        using TestGenericMemReadOnlyFile::TestGenericMemReadOnlyFile;
+        std::expected<size_t, nc::Error> ReadAt(off_t _pos, void *_buf, size_t _size) override
+        {
+            if( _pos + _size > readable )
+                return std::unexpected(Error{Error::POSIX, EAGAIN});
+            return TestGenericMemReadOnlyFile::ReadAt(_pos, _buf, _size);
+        }
+        size_t readable = 0;
+    };
+    const auto data_size = 1024 * 1024;
+    const std::unique_ptr<uint8_t[]> data(new uint8_t[data_size]);
+    for( int i = 0; i < data_size; ++i )
+        data[i] = static_cast<unsigned char>(rand() % 256);
+
+    auto vfs_file =
+        std::make_shared<PartiallyReadableFile>("", nullptr, data.get(), data_size, VFSFile::ReadParadigm::Random);
+    vfs_file->readable = data_size / 2;
+    vfs_file->Open(0, nullptr);
+
+    FileWindow fw;
+    REQUIRE(fw.Attach(vfs_file, 1000));
+    const size_t pos = vfs_file->readable - 1500;
+    REQUIRE(fw.MoveWindow(pos));
+    for( const size_t target : {pos + 700, size_t(data_size) - 1000} ) {
+        const std::expected<void, Error> rc = fw.MoveWindow(target);
+        REQUIRE(!rc);
+        CHECK(rc.error() == Error(Error::POSIX, EAGAIN));
+        CHECK(fw.WindowPos() == pos);
+        CHECK(memcmp(fw.Window(), &data[pos], fw.WindowSize()) == 0);
+    }
+}
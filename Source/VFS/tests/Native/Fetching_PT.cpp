@@ -0,0 +1,92 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+// #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "../Tests.h"
+#include "../TestEnv.h"
+#include "../../source/Native/Fetching.h"
+#include <VFS/VFSListingInput.h>
+#include <Base/algo.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace nc::vfs;
+using namespace nc::vfs::native;
+
+#define PREFIX "[nc::vfs::native::Fetching] PT "
+
+static constexpr int g_Entries = 1'000'000;
+
+static void PopulateDirectory(const std::filesystem::path &_dir)
+{
+    for( int i = 0; i < g_Entries; ++i ) {
+        const int fd = ::open((_dir / fmt::format("file_{:07}.txt", i)).c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        REQUIRE(fd >= 0);
+        close(fd);
+    }
+}
+
+static size_t FetchBulk(int _dir_fd)
+{
+    using nc::base::variable_container;
+    lseek(_dir_fd, 0, SEEK_SET);
+    ListingInput listing;
+    for( auto *column : {&listing.inodes, &listing.sizes} )
+        column->reset(variable_container<>::type::dense);
+    for( auto *column : {&listing.atimes, &listing.mtimes, &listing.ctimes, &listing.btimes} )
+        column->reset(variable_container<>::type::dense);
+    listing.unix_flags.reset(variable_container<>::type::dense);
+    listing.uids.reset(variable_container<>::type::dense);
+    listing.gids.reset(variable_container<>::type::dense);
+    Fetching::BulkExtras extras;
+    REQUIRE(Fetching::ReadDirAttributesBulk(_dir_fd, listing, extras) == 0);
+    return listing.filenames.size();
+}
+
+// The plain approach without any getattrlistbulk() - readdir() followed by lstat() of every entry
+static size_t FetchReadDirStat(int _dir_fd)
+{
+    DIR *dirp = fdopendir(dup(_dir_fd));
+    REQUIRE(dirp != nullptr);
+    auto close_dir = at_scope_end([dirp] { closedir(dirp); });
+    rewinddir(dirp);
+    std::vector<std::string> filenames;
+    std::vector<struct stat> stats;
+    while( auto entp = readdir(dirp) ) {
+        if( entp->d_name == std::string_view{"."} || entp->d_name == std::string_view{".."} )
+            continue;
+        struct stat st;
+        if( fstatat(_dir_fd, entp->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 ) {
+            filenames.emplace_back(entp->d_name, entp->d_namlen);
+            stats.emplace_back(st);
+        }
+    }
+    return filenames.size();
+}
+
+TEST_CASE(PREFIX "listing a huge directory", "[!benchmark]")
+{
+    const TestDir dir;
+    PopulateDirectory(dir.directory);
+
+    const int fd = ::open(dir.directory.c_str(), O_RDONLY | O_NONBLOCK | O_DIRECTORY | O_CLOEXEC);
+    REQUIRE(fd >= 0);
+    auto close_fd = at_scope_end([fd] { close(fd); });
+
+    REQUIRE(FetchBulk(fd) == g_Entries);
+    REQUIRE(FetchReadDirStat(fd) == g_Entries);
+
+    BENCHMARK("getattrlistbulk() into the listing columns")
+    {
+        return FetchBulk(fd);
+    };
+    BENCHMARK("readdir() + lstat()")
+    {
+        return FetchReadDirStat(fd);
+    };
+    BENCHMARK("NativeHost::FetchDirectoryListing()")
+    {
+        return TestEnv().vfs_native->FetchDirectoryListing(dir.directory.native(), VFSFlags::F_NoDotDot).value();
+    };
+}
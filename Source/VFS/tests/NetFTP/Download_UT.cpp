@@ -0,0 +1,56 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "../Tests.h"
+#include "StandInServer.h"
+#include "../../source/NetFTP/Host.h"
+#include "../../source/SegmentedDownload.h"
+#include <VFS/VFSFile.h>
+
+using namespace nc;
+using namespace nc::vfs;
+using ftp::test::StandInServer;
+
+#define PREFIX "FTP download "
+
+static VFSHostPtr Connect(const StandInServer &_server)
+{
+    return std::make_shared<FTPHost>("127.0.0.1", "user", "password", "/", _server.Port());
+}
+
+static std::string MakeData(size_t _size)
+{
+    std::string data(_size, '\0');
+    for( size_t i = 0; i < _size; ++i )
+        data[i] = static_cast<char>(i * 7 % 251);
+    return data;
+}
+
+static std::string Download(const VFSHostPtr &_host, const char *_path)
+{
+    const VFSFilePtr file = _host->CreateFile(_path).value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == VFSError::Ok);
+    const std::expected<std::vector<uint8_t>, Error> contents = file->ReadFile();
+    REQUIRE(contents);
+    return {contents->begin(), contents->end()};
+}
+
+TEST_CASE(PREFIX "Large files are downloaded in ranges over parallel connections")
+{
+    StandInServer server;
+    const std::string data = MakeData((SegmentedDownload::ChunkSize * 5) + 12'345);
+    server.AddFile("/file", data);
+    const auto host = Connect(server);
+    CHECK(Download(host, "/file") == data);
+    CHECK(server.Stats().retrievals == 1 + 6); // the probing one and one per chunk
+    CHECK(server.Stats().refused_connections == 0);
+}
+
+TEST_CASE(PREFIX "Servers capping the connections still yield the right contents")
+{
+    StandInServer server;
+    const std::string data = MakeData((SegmentedDownload::ChunkSize * 5) + 12'345);
+    server.AddFile("/file", data);
+    server.SetMaxConnections(2); // the host keeps one for the listings, which leaves a single one for the download
+    const auto host = Connect(server);
+    CHECK(Download(host, "/file") == data);
+    CHECK(server.Stats().refused_connections > 0);
+}
@@ -0,0 +1,181 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "../Tests.h"
+#include "StandInServer.h"
+#include "../../source/NetFTP/Host.h"
+#include "../../source/NetFTP/Cache.h"
+#include "../../source/NetFTP/MLSDParser.h"
+#include <Base/algo.h>
+#include <fmt/format.h>
+#include <atomic>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace nc;
+using namespace nc::vfs;
+using ftp::test::StandInServer;
+using namespace std::chrono_literals;
+
+#define PREFIX "FTP listing "
+
+static std::shared_ptr<FTPHost> Connect(const StandInServer &_server)
+{
+    return std::make_shared<FTPHost>("127.0.0.1", "user", "password", "/", _server.Port());
+}
+
+static std::vector<std::string> Filenames(const VFSListing &_listing)
+{
+    std::vector<std::string> filenames;
+    for( unsigned i = 0; i < _listing.Count(); ++i )
+        filenames.emplace_back(_listing.Filename(i));
+    std::ranges::sort(filenames);
+    return filenames;
+}
+
+TEST_CASE(PREFIX "MLSD responses are parsed")
+{
+    const auto dir = ftp::ParseMLSDListing("type=cdir;modify=20250101000000; /pub\r\n"
+                                           "type=pdir;modify=20250101000000; ..\r\n"
+                                           "Type=file;Size=1234;Modify=20250102030405.123;UNIX.mode=0600;"
+                                           " a file.txt\r\n"
+                                           "type=dir;modify=20241231235959; sub\r\n"
+                                           "type=OS.unix=slink:/etc;modify=20250101000000; link\r\n"
+                                           "size=0;type=file; name;with;semicolons\n");
+    REQUIRE(dir);
+    REQUIRE(dir->entries.size() == 4);
+    CHECK(dir->entries[0].name == "a file.txt");
+    CHECK(dir->entries[0].size == 1234);
+    CHECK(dir->entries[0].time == 1735787045);
+    CHECK(dir->entries[0].mode == (S_IFREG | 0600));
+    CHECK(dir->entries[1].name == "sub");
+    CHECK(dir->entries[1].time == 1735689599);
+    CHECK(dir->entries[1].mode == (S_IFDIR | 0755));
+    CHECK(dir->entries[2].name == "link");
+    CHECK(S_ISLNK(dir->entries[2].mode));
+    CHECK(dir->entries[3].name == "name;with;semicolons");
+    CHECK(dir->entries[3].mode == (S_IFREG | 0644));
+}
+
+TEST_CASE(PREFIX "LIST responses are not taken for MLSD ones")
+{
+    CHECK(ftp::ParseMLSDListing("-rw-r--r-- 1 owner group 5 Oct 17 04:49 file.txt\r\n") == nullptr);
+    CHECK(ftp::ParseMLSDListing("10-17-25  04:49AM       <DIR>          dir\r\n") == nullptr);
+    CHECK(ftp::ParseMLSDListing("size=5; file.txt\r\n") == nullptr);
+}
+
+TEST_CASE(PREFIX "Directories are listed via MLSD")
+{
+    StandInServer server;
+    server.AddDirectory("/dir");
+    server.AddFile("/dir/file.txt", "Hello");
+    server.AddDirectory("/dir/sub dir");
+
+    const auto host = Connect(server);
+    const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+    REQUIRE(listing);
+    CHECK(Filenames(**listing) == std::vector<std::string>{"file.txt", "sub dir"});
+
+    const std::expected<VFSStat, Error> st = host->Stat("/dir/file.txt", 0);
+    REQUIRE(st);
+    CHECK(st->size == 5);
+    CHECK(host->IsDirectory("/dir/sub dir", 0));
+    CHECK(server.Stats().mlsd_requests == 2);
+    CHECK(server.Stats().list_requests == 0);
+}
+
+TEST_CASE(PREFIX "Servers without MLSD are listed via LIST")
+{
+    StandInServer server;
+    server.SetMLSDSupport(false);
+    server.AddDirectory("/dir");
+    server.AddFile("/dir/file.txt", "Hello");
+
+    const auto host = Connect(server);
+    const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+    REQUIRE(listing);
+    CHECK(Filenames(**listing) == std::vector<std::string>{"file.txt"});
+    CHECK(host->Stat("/dir/file.txt", 0)->size == 5);
+    CHECK(server.Stats().mlsd_requests == 1); // only the starting directory has tried it
+    CHECK(server.Stats().list_requests == 2);
+}
+
+TEST_CASE(PREFIX "Persisted listings are shown right away and refreshed in background")
+{
+    const TestDir dir;
+    FTPHost::SetListingCacheDirectory(dir.directory / "cache");
+    const auto disable_cache = at_scope_end([] { FTPHost::SetListingCacheDirectory({}); });
+
+    StandInServer server;
+    server.AddDirectory("/dir");
+    for( int i = 0; i < 10; ++i )
+        server.AddFile(fmt::format("/dir/file{}.txt", i), "data");
+
+    std::vector<std::string> filenames;
+    {
+        const auto host = Connect(server);
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        filenames = Filenames(**listing);
+    }
+    REQUIRE(!std::filesystem::is_empty(dir.directory / "cache"));
+
+    SECTION("Changes are picked up by the refresh")
+    {
+        server.AddFile("/dir/new.txt", "new");
+        server.ResetStats();
+        const auto host = Connect(server);
+        std::atomic_int changes = 0;
+        const auto ticket = host->ObserveDirectoryChanges("/dir/", [&] { ++changes; });
+
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        CHECK(Filenames(**listing) == filenames);
+
+        for( int i = 0; i < 500 && changes == 0; ++i )
+            std::this_thread::sleep_for(10ms);
+        CHECK(changes == 1);
+        CHECK(server.Stats().mlsd_requests == 2); // the starting directory and the refresh
+
+        const auto refreshed = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(refreshed);
+        CHECK(std::ranges::count(Filenames(**refreshed), "new.txt") == 1);
+        CHECK(server.Stats().mlsd_requests == 2);
+    }
+    SECTION("Unchanged listings don't bother the observers")
+    {
+        server.ResetStats();
+        const auto host = Connect(server);
+        std::atomic_int changes = 0;
+        const auto ticket = host->ObserveDirectoryChanges("/dir/", [&] { ++changes; });
+
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        CHECK(Filenames(**listing) == filenames);
+
+        for( int i = 0; i < 500 && server.Stats().mlsd_requests < 2; ++i )
+            std::this_thread::sleep_for(10ms);
+        std::this_thread::sleep_for(50ms);
+        CHECK(server.Stats().mlsd_requests == 2);
+        CHECK(changes == 0);
+    }
+    SECTION("Stat doesn't trust the persisted listings")
+    {
+        server.AddFile("/dir/file7.txt", "changed data");
+        server.ResetStats();
+        const auto host = Connect(server);
+        const std::expected<VFSStat, Error> st = host->Stat("/dir/file7.txt", 0);
+        REQUIRE(st);
+        CHECK(st->size == 12);
+        CHECK(server.Stats().mlsd_requests == 2); // the starting directory and the synchronous fetch
+    }
+    SECTION("A malformed cache file is ignored")
+    {
+        for( const auto &entry : std::filesystem::directory_iterator(dir.directory / "cache") )
+            std::ofstream(entry.path(), std::ios::binary | std::ios::trunc) << "NCFTPLST garbage";
+        server.ResetStats();
+        const auto host = Connect(server);
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        CHECK(Filenames(**listing) == filenames);
+        CHECK(server.Stats().mlsd_requests == 2);
+    }
+}
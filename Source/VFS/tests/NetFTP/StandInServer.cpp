@@ -0,0 +1,433 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "StandInServer.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <stdexcept>
+#include <utility>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace nc::vfs::ftp::test {
+
+static constexpr int g_PollTimeoutMs = 50;
+static constexpr int g_DataConnectionTimeoutMs = 5000;
+
+static std::string Uppercase(std::string_view _string)
+{
+    std::string upper(_string);
+    std::ranges::transform(upper, upper.begin(), [](unsigned char _c) { return std::toupper(_c); });
+    return upper;
+}
+
+static std::string Parent(std::string_view _path)
+{
+    const auto slash = _path.find_last_of('/');
+    return slash == 0 ? "/" : std::string(_path.substr(0, slash));
+}
+
+static std::string Normalized(std::string_view _path)
+{
+    std::string path(_path);
+    while( path.size() > 1 && path.back() == '/' )
+        path.pop_back();
+    return path;
+}
+
+static void SendAll(int _socket, std::string_view _data)
+{
+    while( !_data.empty() ) {
+        const ssize_t sent = send(_socket, _data.data(), _data.size(), 0);
+        if( sent <= 0 )
+            return;
+        _data.remove_prefix(sent);
+    }
+}
+
+static void Reply(int _socket, int _code, std::string_view _text)
+{
+    SendAll(_socket, fmt::format("{} {}\r\n", _code, _text));
+}
+
+// Returns a listening socket on an ephemeral loopback port, or -1 on failure.
+static int ListenOnLoopback(int &_port)
+{
+    const int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if( sock < 0 )
+        return -1;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if( bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(sock, 64) != 0 ||
+        getsockname(sock, reinterpret_cast<sockaddr *>(&addr), &len) != 0 ) {
+        close(sock);
+        return -1;
+    }
+    _port = ntohs(addr.sin_port);
+    return sock;
+}
+
+StandInServer::StandInServer()
+{
+    m_Nodes["/"] = Node{.is_dir = true, .mtime = std::time(nullptr)};
+
+    m_Socket = ListenOnLoopback(m_Port);
+    if( m_Socket < 0 )
+        throw std::runtime_error("StandInServer: failed to listen");
+
+    m_Acceptor = std::thread([this] { AcceptConnections(); });
+}
+
+StandInServer::~StandInServer()
+{
+    m_Stop = true;
+    m_Acceptor.join();
+    for( auto &connection : m_Connections )
+        connection.join();
+    close(m_Socket);
+}
+
+int StandInServer::Port() const noexcept
+{
+    return m_Port;
+}
+
+void StandInServer::AddDirectory(std::string_view _path)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    const auto path = Normalized(_path);
+    m_Nodes[path] = Node{.is_dir = true, .mtime = std::time(nullptr)};
+    m_Nodes.at(Parent(path)).mtime = std::time(nullptr);
+}
+
+void StandInServer::AddFile(std::string_view _path, std::string_view _contents)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    const auto path = Normalized(_path);
+    m_Nodes[path] = Node{.is_dir = false, .contents = std::string(_contents), .mtime = std::time(nullptr)};
+    m_Nodes.at(Parent(path)).mtime = std::time(nullptr);
+}
+
+void StandInServer::SetLatency(std::chrono::milliseconds _latency)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_Latency = _latency;
+}
+
+void StandInServer::SetMLSDSupport(bool _supported)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_MLSDSupported = _supported;
+}
+
+void StandInServer::SetMaxConnections(size_t _max)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_MaxConnections = _max;
+}
+
+StandInServer::Statistics StandInServer::Stats() const
+{
+    const auto lock = std::lock_guard{m_Lock};
+    return m_Stats;
+}
+
+void StandInServer::ResetStats()
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_Stats = {};
+}
+
+void StandInServer::AcceptConnections()
+{
+    while( !m_Stop ) {
+        pollfd pfd{.fd = m_Socket, .events = POLLIN, .revents = 0};
+        if( poll(&pfd, 1, g_PollTimeoutMs) <= 0 )
+            continue;
+        const int connection = accept(m_Socket, nullptr, nullptr);
+        if( connection < 0 )
+            continue;
+        const int on = 1; // a client dropping the connection must not bring the whole process down
+        setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+        bool refused = false;
+        {
+            const auto lock = std::lock_guard{m_Lock};
+            refused = m_MaxConnections != 0 && m_OpenConnections >= m_MaxConnections;
+            ++(refused ? m_Stats.refused_connections : m_OpenConnections);
+        }
+        if( refused ) {
+            Reply(connection, 421, "Too many connections");
+            close(connection);
+            continue;
+        }
+        const auto lock = std::lock_guard{m_ConnectionsLock};
+        m_Connections.emplace_back([this, connection] { ServeConnection(connection); });
+    }
+}
+
+void StandInServer::ServeConnection(int _socket)
+{
+    Session session;
+    session.control = _socket;
+    Reply(_socket, 220, "StandInServer ready");
+
+    std::string input;
+    bool connected = true;
+    while( connected && !m_Stop ) {
+        size_t line_end;
+        while( (line_end = input.find("\r\n")) == std::string::npos && !m_Stop ) {
+            pollfd pfd{.fd = _socket, .events = POLLIN, .revents = 0};
+            if( poll(&pfd, 1, g_PollTimeoutMs) <= 0 )
+                continue;
+            char buf[4096];
+            const ssize_t got = recv(_socket, buf, sizeof(buf), 0);
+            if( got <= 0 ) {
+                connected = false;
+                break;
+            }
+            input.append(buf, got);
+        }
+        if( !connected || line_end == std::string::npos )
+            break;
+
+        const std::string line = input.substr(0, line_end);
+        input.erase(0, line_end + 2);
+        const size_t space = line.find(' ');
+        const std::string command = Uppercase(std::string_view(line).substr(0, space));
+        const std::string_view argument =
+            space == std::string::npos ? std::string_view{} : std::string_view(line).substr(space + 1);
+
+        std::chrono::milliseconds latency;
+        {
+            const auto lock = std::lock_guard{m_Lock};
+            latency = m_Latency;
+        }
+        std::this_thread::sleep_for(latency);
+
+        connected = Respond(session, command, argument);
+    }
+
+    if( session.passive >= 0 )
+        close(session.passive);
+    close(_socket);
+    const auto lock = std::lock_guard{m_Lock};
+    --m_OpenConnections;
+}
+
+bool StandInServer::Respond(Session &_session, std::string_view _command, std::string_view _argument)
+{
+    const int sock = _session.control;
+    if( _command == "USER" ) {
+        Reply(sock, 331, "Password required");
+    }
+    else if( _command == "PASS" ) {
+        const auto lock = std::lock_guard{m_Lock};
+        ++m_Stats.logins;
+        Reply(sock, 230, "Logged in");
+    }
+    else if( _command == "SYST" ) {
+        Reply(sock, 215, "UNIX Type: L8");
+    }
+    else if( _command == "PWD" ) {
+        Reply(sock, 257, fmt::format("\"{}\" is the current directory", _session.cwd));
+    }
+    else if( _command == "CWD" ) {
+        const auto path = Resolve(_session, _argument);
+        const auto lock = std::lock_guard{m_Lock};
+        const auto it = m_Nodes.find(path);
+        if( it != m_Nodes.end() && it->second.is_dir ) {
+            _session.cwd = path;
+            Reply(sock, 250, "Directory changed");
+        }
+        else
+            Reply(sock, 550, "No such directory");
+    }
+    else if( _command == "SIZE" ) {
+        const auto path = Resolve(_session, _argument);
+        const auto lock = std::lock_guard{m_Lock};
+        const auto it = m_Nodes.find(path);
+        if( it != m_Nodes.end() && !it->second.is_dir )
+            Reply(sock, 213, fmt::format("{}", it->second.contents.size()));
+        else
+            Reply(sock, 550, "No such file");
+    }
+    else if( _command == "REST" ) {
+        _session.rest = 0;
+        std::from_chars(_argument.data(), _argument.data() + _argument.size(), _session.rest);
+        Reply(sock, 350, fmt::format("Restarting at {}", _session.rest));
+    }
+    else if( _command == "RETR" ) {
+        RespondRetrieval(_session, _argument);
+    }
+    else if( _command == "TYPE" || _command == "NOOP" ) {
+        Reply(sock, 200, "OK");
+    }
+    else if( _command == "EPSV" || _command == "PASV" ) {
+        RespondPassive(_session, _command == "EPSV");
+    }
+    else if( _command == "LIST" ) {
+        RespondListing(_session, _argument, false);
+    }
+    else if( _command == "MLSD" ) {
+        bool supported;
+        {
+            const auto lock = std::lock_guard{m_Lock};
+            supported = m_MLSDSupported;
+        }
+        if( supported )
+            RespondListing(_session, _argument, true);
+        else
+            Reply(sock, 500, "Unknown command");
+    }
+    else if( _command == "FEAT" ) {
+        const auto lock = std::lock_guard{m_Lock};
+        SendAll(sock, m_MLSDSupported ? "211-Features:\r\n MLST type*;size*;modify*;UNIX.mode*;\r\n211 End\r\n"
+                                      : "211 No features\r\n");
+    }
+    else if( _command == "QUIT" ) {
+        Reply(sock, 221, "Bye");
+        return false;
+    }
+    else {
+        Reply(sock, 502, "Command not implemented");
+    }
+    return true;
+}
+
+void StandInServer::RespondPassive(Session &_session, bool _extended)
+{
+    if( _session.passive >= 0 )
+        close(_session.passive);
+    int port = 0;
+    _session.passive = ListenOnLoopback(port);
+    if( _session.passive < 0 )
+        Reply(_session.control, 425, "Can't open a data connection");
+    else if( _extended )
+        Reply(_session.control, 229, fmt::format("Entering Extended Passive Mode (|||{}|)", port));
+    else
+        Reply(_session.control, 227, fmt::format("Entering Passive Mode (127,0,0,1,{},{})", port >> 8, port & 0xFF));
+}
+
+void StandInServer::RespondListing(Session &_session, std::string_view _argument, bool _mlsd)
+{
+    // the options like "-a" of LIST are ignored
+    const std::string_view target = _argument.starts_with('-') ? std::string_view{} : _argument;
+    const auto path = Resolve(_session, target);
+
+    std::string listing;
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        ++(_mlsd ? m_Stats.mlsd_requests : m_Stats.list_requests);
+        const auto it = m_Nodes.find(path);
+        if( it == m_Nodes.end() || !it->second.is_dir ) {
+            Reply(_session.control, 550, "No such directory");
+            return;
+        }
+        const std::string prefix = path == "/" ? "/" : path + "/";
+        if( _mlsd )
+            listing += MLSDEntry(".", it->second);
+        for( auto child = m_Nodes.upper_bound(prefix); child != m_Nodes.end(); ++child ) {
+            if( !child->first.starts_with(prefix) )
+                break;
+            const std::string_view name = std::string_view(child->first).substr(prefix.size());
+            if( name.find('/') == std::string_view::npos )
+                listing += _mlsd ? MLSDEntry(name, child->second) : ListEntry(name, child->second);
+        }
+    }
+
+    if( _session.passive < 0 ) {
+        Reply(_session.control, 425, "Use PASV or EPSV first");
+        return;
+    }
+    Reply(_session.control, 150, "Here comes the directory listing");
+    if( SendOverDataConnection(_session, listing) )
+        Reply(_session.control, 226, "Directory send OK");
+}
+
+void StandInServer::RespondRetrieval(Session &_session, std::string_view _argument)
+{
+    const auto path = Resolve(_session, _argument);
+    const size_t offset = std::exchange(_session.rest, 0);
+
+    std::string contents;
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        const auto it = m_Nodes.find(path);
+        if( it == m_Nodes.end() || it->second.is_dir ) {
+            Reply(_session.control, 550, "No such file");
+            return;
+        }
+        ++m_Stats.retrievals;
+        contents = it->second.contents.substr(std::min(offset, it->second.contents.size()));
+    }
+
+    if( _session.passive < 0 ) {
+        Reply(_session.control, 425, "Use PASV or EPSV first");
+        return;
+    }
+    Reply(_session.control, 150, "Opening BINARY mode data connection");
+    // a client which needs only a part of the file closes the data connection early, that cuts the sending short
+    if( SendOverDataConnection(_session, contents) )
+        Reply(_session.control, 226, "Transfer complete");
+}
+
+bool StandInServer::SendOverDataConnection(Session &_session, std::string_view _data)
+{
+    pollfd pfd{.fd = _session.passive, .events = POLLIN, .revents = 0};
+    const int data = poll(&pfd, 1, g_DataConnectionTimeoutMs) > 0 ? accept(_session.passive, nullptr, nullptr) : -1;
+    close(_session.passive);
+    _session.passive = -1;
+    if( data < 0 ) {
+        Reply(_session.control, 425, "Failed to establish a data connection");
+        return false;
+    }
+    const int on = 1;
+    setsockopt(data, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    SendAll(data, _data);
+    close(data);
+    return true;
+}
+
+std::string StandInServer::Resolve(const Session &_session, std::string_view _path) const
+{
+    if( _path.empty() )
+        return _session.cwd;
+    if( _path.starts_with('/') )
+        return Normalized(_path);
+    return Normalized(_session.cwd == "/" ? fmt::format("/{}", _path) : fmt::format("{}/{}", _session.cwd, _path));
+}
+
+std::string StandInServer::ListEntry(std::string_view _name, const Node &_node)
+{
+    struct tm tm;
+    gmtime_r(&_node.mtime, &tm);
+    char date[32];
+    strftime(date, sizeof(date), "%b %d %H:%M", &tm);
+    return fmt::format("{} 1 owner group {:>10} {} {}\r\n",
+                       _node.is_dir ? "drwxr-xr-x" : "-rw-r--r--",
+                       _node.is_dir ? size_t{4096} : _node.contents.size(),
+                       date,
+                       _name);
+}
+
+std::string StandInServer::MLSDEntry(std::string_view _name, const Node &_node)
+{
+    struct tm tm;
+    gmtime_r(&_node.mtime, &tm);
+    char modify[32];
+    strftime(modify, sizeof(modify), "%Y%m%d%H%M%S", &tm);
+    const auto type = _name == "." ? "cdir" : _node.is_dir ? "dir" : "file";
+    if( _node.is_dir )
+        return fmt::format("type={};modify={};UNIX.mode=0755; {}\r\n", type, modify, _name);
+    return fmt::format(
+        "type={};size={};modify={};UNIX.mode=0644; {}\r\n", type, _node.contents.size(), modify, _name);
+}
+
+} // namespace nc::vfs::ftp::test
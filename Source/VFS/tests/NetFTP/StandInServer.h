@@ -0,0 +1,92 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace nc::vfs::ftp::test {
+
+// A minimal FTP server listening on the loopback interface, serves an in-memory tree of files.
+// Understands the commands required to log in, to change the directory, to list it via LIST or MLSD and to retrieve
+// files from REST offsets over a passive data connection, accepts any credentials.
+class StandInServer
+{
+public:
+    struct Statistics {
+        size_t logins = 0;
+        size_t list_requests = 0;
+        size_t mlsd_requests = 0;
+        size_t retrievals = 0;
+        size_t refused_connections = 0;
+    };
+
+    // Starts listening on an ephemeral port, throws std::runtime_error on failure.
+    StandInServer();
+    ~StandInServer();
+
+    int Port() const noexcept;
+
+    // Adds a directory or a file, the parent directory must exist. Adding an existing file replaces its contents.
+    void AddDirectory(std::string_view _path);
+    void AddFile(std::string_view _path, std::string_view _contents);
+
+    // Delays every reply, which makes the background work observable.
+    void SetLatency(std::chrono::milliseconds _latency);
+
+    // Makes MLSD be rejected as an unknown command, as the servers predating RFC 3659 do.
+    void SetMLSDSupport(bool _supported);
+
+    // Turns the connections beyond the limit away with a 421 greeting, as the servers capping the connections per
+    // client do. 0 means no limit.
+    void SetMaxConnections(size_t _max);
+
+    Statistics Stats() const;
+    void ResetStats();
+
+private:
+    struct Node {
+        bool is_dir = false;
+        std::string contents;
+        time_t mtime = 0;
+    };
+    struct Session {
+        int control = -1;
+        int passive = -1; // a listening socket for the next data connection, if any
+        std::string cwd = "/";
+        size_t rest = 0; // the offset of the next retrieval
+    };
+
+    void AcceptConnections();
+    void ServeConnection(int _socket);
+    bool Respond(Session &_session, std::string_view _command, std::string_view _argument); // false to disconnect
+    void RespondPassive(Session &_session, bool _extended);
+    void RespondListing(Session &_session, std::string_view _argument, bool _mlsd);
+    void RespondRetrieval(Session &_session, std::string_view _argument);
+    bool SendOverDataConnection(Session &_session, std::string_view _data);
+    std::string Resolve(const Session &_session, std::string_view _path) const;
+    static std::string ListEntry(std::string_view _name, const Node &_node);
+    static std::string MLSDEntry(std::string_view _name, const Node &_node);
+
+    int m_Socket = -1;
+    int m_Port = 0;
+    std::atomic_bool m_Stop = false;
+    std::thread m_Acceptor;
+    std::vector<std::thread> m_Connections;
+    std::mutex m_ConnectionsLock;
+
+    mutable std::mutex m_Lock;
+    std::map<std::string, Node> m_Nodes; // "/" for the root, no trailing slashes otherwise
+    std::chrono::milliseconds m_Latency{0};
+    bool m_MLSDSupported = true;
+    size_t m_MaxConnections = 0;
+    size_t m_OpenConnections = 0;
+    Statistics m_Stats;
+};
+
+} // namespace nc::vfs::ftp::test
@@ -0,0 +1,71 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "../Tests.h"
+#include "StandInServer.h"
+#include "../../source/NetWebDAV/WebDAVHost.h"
+#include "../../source/SegmentedDownload.h"
+#include <VFS/VFSFile.h>
+
+using namespace nc;
+using namespace nc::vfs;
+using webdav::test::StandInServer;
+
+#define PREFIX "WebDAV download "
+
+static VFSHostPtr Connect(const StandInServer &_server)
+{
+    return std::make_shared<WebDAVHost>("127.0.0.1", "user", "password", "", false, _server.Port());
+}
+
+static std::string MakeData(size_t _size)
+{
+    std::string data(_size, '\0');
+    for( size_t i = 0; i < _size; ++i )
+        data[i] = static_cast<char>(i * 7 % 251);
+    return data;
+}
+
+static std::string Download(const VFSHostPtr &_host, const char *_path)
+{
+    const VFSFilePtr file = _host->CreateFile(_path).value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == VFSError::Ok);
+    const std::expected<std::vector<uint8_t>, Error> contents = file->ReadFile();
+    REQUIRE(contents);
+    return {contents->begin(), contents->end()};
+}
+
+TEST_CASE(PREFIX "Small files are downloaded in a single request")
+{
+    StandInServer server;
+    const std::string data = MakeData(100'000);
+    server.AddFile("/file", data);
+    const auto host = Connect(server);
+    CHECK(Download(host, "/file") == data);
+    CHECK(server.Stats().gets == 1);
+    CHECK(server.Stats().ranged_gets == 0);
+}
+
+TEST_CASE(PREFIX "Large files are downloaded in ranges over parallel connections")
+{
+    StandInServer server;
+    const std::string data = MakeData((SegmentedDownload::ChunkSize * 5) + 12'345);
+    server.AddFile("/file", data);
+    server.SetLatency(std::chrono::milliseconds(20));
+    const auto host = Connect(server);
+    CHECK(Download(host, "/file") == data);
+    CHECK(server.Stats().ranged_gets == 6);
+    CHECK(server.Stats().max_concurrent_requests > 1);
+}
+
+TEST_CASE(PREFIX "Servers ignoring ranges still yield the right contents")
+{
+    StandInServer server;
+    const std::string data = MakeData((SegmentedDownload::ChunkSize * 4) + 1);
+    server.AddFile("/file", data);
+    server.SetRangesSupport(false);
+    const auto host = Connect(server);
+    CHECK(Download(host, "/file") == data);
+    CHECK(server.Stats().ranged_gets == 0);
+    // the ranged requests are abandoned right away and the file is transferred once by a single stream, while reading
+    // the whole file for each range would have sent several times as much
+    CHECK(server.Stats().bytes_sent < data.size() + (data.size() / 2));
+}
@@ -0,0 +1,159 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "../Tests.h"
+#include "StandInServer.h"
+#include "../../source/NetWebDAV/WebDAVHost.h"
+#include <VFS/DirectorySizeCalculator.h>
+#include <Base/algo.h>
+#include <fmt/format.h>
+#include <fstream>
+
+using namespace nc;
+using namespace nc::vfs;
+using webdav::test::StandInServer;
+
+#define PREFIX "WebDAV listing "
+
+static VFSHostPtr Connect(const StandInServer &_server)
+{
+    return std::make_shared<WebDAVHost>("127.0.0.1", "user", "password", "", false, _server.Port());
+}
+
+static std::vector<std::string> Filenames(const VFSListing &_listing)
+{
+    std::vector<std::string> filenames;
+    for( unsigned i = 0; i < _listing.Count(); ++i )
+        filenames.emplace_back(_listing.Filename(i));
+    std::ranges::sort(filenames);
+    return filenames;
+}
+
+TEST_CASE(PREFIX "Lists the directories of a stand-in server")
+{
+    StandInServer server;
+    server.AddDirectory("/dir");
+    server.AddFile("/dir/file.txt", "Hello");
+    server.AddDirectory("/dir/sub dir");
+
+    const auto host = Connect(server);
+    const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+    REQUIRE(listing);
+    CHECK(Filenames(**listing) == std::vector<std::string>{"file.txt", "sub dir"});
+
+    const std::expected<VFSStat, Error> st = host->Stat("/dir/file.txt", 0);
+    REQUIRE(st);
+    CHECK(st->size == 5);
+    CHECK(host->IsDirectory("/dir/sub dir", 0));
+}
+
+TEST_CASE(PREFIX "Recursive walks list directories concurrently")
+{
+    StandInServer server;
+    uint64_t expected_size = 0;
+    for( int i = 0; i < 4; ++i ) {
+        server.AddDirectory(fmt::format("/d{}", i));
+        for( int j = 0; j < 4; ++j ) {
+            server.AddDirectory(fmt::format("/d{}/d{}", i, j));
+            server.AddFile(fmt::format("/d{}/d{}/f", i, j), std::string(i * 4 + j, 'x'));
+            expected_size += i * 4 + j;
+        }
+    }
+    server.SetLatency(std::chrono::milliseconds(50));
+
+    const auto host = Connect(server);
+    CHECK(host->Features() & HostFeatures::ConcurrentListing);
+    DirectorySizeCalculator calc;
+    calc.SetMaxWorkers(4);
+    CHECK(calc.Calculate(host, "/") == expected_size);
+    CHECK(server.Stats().max_concurrent_requests > 1);
+}
+
+TEST_CASE(PREFIX "Persisted listings are revalidated upon a reconnect")
+{
+    const TestDir dir;
+    WebDAVHost::SetListingCacheDirectory(dir.directory / "cache");
+    const auto disable_cache = at_scope_end([] { WebDAVHost::SetListingCacheDirectory({}); });
+
+    StandInServer server;
+    server.AddDirectory("/dir");
+    for( int i = 0; i < 100; ++i )
+        server.AddFile(fmt::format("/dir/file{}.txt", i), "data");
+    server.AddDirectory("/other");
+
+    std::vector<std::string> filenames;
+    {
+        const auto host = Connect(server);
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        filenames = Filenames(**listing);
+        REQUIRE(host->FetchDirectoryListing("/other/", 0));
+    }
+    REQUIRE(!std::filesystem::is_empty(dir.directory / "cache"));
+
+    SECTION("Unchanged directories are not fetched again")
+    {
+        server.ResetStats();
+        const auto host = Connect(server);
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        CHECK(Filenames(**listing) == filenames);
+        CHECK(server.Stats().propfinds_depth0 == 1);
+        CHECK(server.Stats().propfinds_depth1 == 0);
+        CHECK(host->Stat("/dir/file7.txt", 0)->size == 4);
+        CHECK(server.Stats().propfinds_depth0 == 1);
+    }
+    SECTION("Changed directories are fetched again")
+    {
+        server.AddFile("/dir/new.txt", "new");
+        server.ResetStats();
+        const auto host = Connect(server);
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        CHECK(std::ranges::count(Filenames(**listing), "new.txt") == 1);
+        CHECK(server.Stats().propfinds_depth1 == 1);
+        REQUIRE(host->FetchDirectoryListing("/other/", 0)); // merely revalidated
+        CHECK(server.Stats().propfinds_depth1 == 1);
+    }
+    SECTION("A forced refresh doesn't revalidate")
+    {
+        server.ResetStats();
+        const auto host = Connect(server);
+        REQUIRE(host->FetchDirectoryListing("/dir/", VFSFlags::F_ForceRefresh));
+        CHECK(server.Stats().propfinds_depth0 == 0);
+        CHECK(server.Stats().propfinds_depth1 == 1);
+    }
+    SECTION("A malformed cache file is ignored")
+    {
+        for( const auto &entry : std::filesystem::directory_iterator(dir.directory / "cache") )
+            std::ofstream(entry.path(), std::ios::binary | std::ios::trunc) << "NCDAVLST garbage";
+        server.ResetStats();
+        const auto host = Connect(server);
+        const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+        REQUIRE(listing);
+        CHECK(Filenames(**listing) == filenames);
+        CHECK(server.Stats().propfinds_depth1 == 1);
+    }
+}
+
+TEST_CASE(PREFIX "Without directory ETags only the persisted listings are revalidated by modification dates")
+{
+    const TestDir dir;
+    WebDAVHost::SetListingCacheDirectory(dir.directory / "cache");
+    const auto disable_cache = at_scope_end([] { WebDAVHost::SetListingCacheDirectory({}); });
+
+    StandInServer server;
+    server.SetCollectionETags(false);
+    server.AddDirectory("/dir");
+    server.AddFile("/dir/file.txt", "data");
+    {
+        const auto host = Connect(server);
+        REQUIRE(host->FetchDirectoryListing("/dir/", 0));
+    }
+
+    server.ResetStats();
+    const auto host = Connect(server);
+    const auto listing = host->FetchDirectoryListing("/dir/", VFSFlags::F_NoDotDot);
+    REQUIRE(listing);
+    CHECK(Filenames(**listing) == std::vector<std::string>{"file.txt"});
+    CHECK(server.Stats().propfinds_depth0 == 1);
+    CHECK(server.Stats().propfinds_depth1 == 0);
+}
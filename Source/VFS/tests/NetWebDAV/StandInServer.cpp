@@ -0,0 +1,365 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "StandInServer.h"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cctype>
+#include <ctime>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace nc::vfs::webdav::test {
+
+static constexpr int g_PollTimeoutMs = 50;
+
+static std::string Lowercase(std::string _string)
+{
+    std::ranges::transform(_string, _string.begin(), [](unsigned char _c) { return std::tolower(_c); });
+    return _string;
+}
+
+static std::string URIUnescape(std::string_view _escaped)
+{
+    std::string unescaped;
+    for( size_t i = 0; i < _escaped.size(); ++i ) {
+        if( _escaped[i] == '%' && i + 2 < _escaped.size() ) {
+            unescaped += static_cast<char>(std::stoi(std::string(_escaped.substr(i + 1, 2)), nullptr, 16));
+            i += 2;
+        }
+        else
+            unescaped += _escaped[i];
+    }
+    return unescaped;
+}
+
+static std::string URIEscape(std::string_view _unescaped)
+{
+    std::string escaped;
+    for( const unsigned char c : _unescaped ) {
+        if( std::isalnum(c) || c == '/' || c == '.' || c == '-' || c == '_' )
+            escaped += static_cast<char>(c);
+        else
+            escaped += fmt::format("%{:02X}", c);
+    }
+    return escaped;
+}
+
+static std::string RFC1123(time_t _time)
+{
+    struct tm tm;
+    gmtime_r(&_time, &tm);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    return buf;
+}
+
+static std::string Parent(std::string_view _path)
+{
+    const auto slash = _path.find_last_of('/');
+    return slash == 0 ? "/" : std::string(_path.substr(0, slash));
+}
+
+static std::string Normalized(std::string_view _path)
+{
+    std::string path(_path);
+    while( path.size() > 1 && path.back() == '/' )
+        path.pop_back();
+    return path;
+}
+
+static std::string Response(int _code, std::string_view _reason, std::string_view _headers, std::string_view _body)
+{
+    return fmt::format(
+        "HTTP/1.1 {} {}\r\nContent-Length: {}\r\n{}\r\n{}", _code, _reason, _body.size(), _headers, _body);
+}
+
+StandInServer::StandInServer()
+{
+    m_Nodes["/"] = Node{.is_dir = true, .etag = ++m_LastETag, .mtime = std::time(nullptr)};
+
+    m_Socket = socket(AF_INET, SOCK_STREAM, 0);
+    if( m_Socket < 0 )
+        throw std::runtime_error("StandInServer: socket() failed");
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if( bind(m_Socket, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(m_Socket, 64) != 0 ||
+        getsockname(m_Socket, reinterpret_cast<sockaddr *>(&addr), &len) != 0 ) {
+        close(m_Socket);
+        throw std::runtime_error("StandInServer: failed to listen");
+    }
+    m_Port = ntohs(addr.sin_port);
+
+    m_Acceptor = std::thread([this] { AcceptConnections(); });
+}
+
+StandInServer::~StandInServer()
+{
+    m_Stop = true;
+    m_Acceptor.join();
+    for( auto &connection : m_Connections )
+        connection.join();
+    close(m_Socket);
+}
+
+int StandInServer::Port() const noexcept
+{
+    return m_Port;
+}
+
+void StandInServer::AddDirectory(std::string_view _path)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    const auto path = Normalized(_path);
+    m_Nodes[path] = Node{.is_dir = true, .etag = ++m_LastETag, .mtime = std::time(nullptr)};
+    Touch(Parent(path));
+}
+
+void StandInServer::AddFile(std::string_view _path, std::string_view _contents)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    const auto path = Normalized(_path);
+    m_Nodes[path] =
+        Node{.is_dir = false, .contents = std::string(_contents), .etag = ++m_LastETag, .mtime = std::time(nullptr)};
+    Touch(Parent(path));
+}
+
+void StandInServer::Touch(std::string_view _path)
+{
+    auto &node = m_Nodes.at(std::string(_path));
+    node.etag = ++m_LastETag;
+    if( _path != "/" )
+        Touch(Parent(_path));
+}
+
+void StandInServer::SetLatency(std::chrono::milliseconds _latency)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_Latency = _latency;
+}
+
+void StandInServer::SetRangesSupport(bool _supported)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_RangesSupported = _supported;
+}
+
+void StandInServer::SetCollectionETags(bool _provided)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_CollectionETags = _provided;
+}
+
+StandInServer::Statistics StandInServer::Stats() const
+{
+    const auto lock = std::lock_guard{m_Lock};
+    return m_Stats;
+}
+
+void StandInServer::ResetStats()
+{
+    const auto lock = std::lock_guard{m_Lock};
+    m_Stats = {};
+}
+
+void StandInServer::AcceptConnections()
+{
+    while( !m_Stop ) {
+        pollfd pfd{.fd = m_Socket, .events = POLLIN, .revents = 0};
+        if( poll(&pfd, 1, g_PollTimeoutMs) <= 0 )
+            continue;
+        const int connection = accept(m_Socket, nullptr, nullptr);
+        if( connection < 0 )
+            continue;
+        const int on = 1; // a client aborting a download must not bring the whole process down
+        setsockopt(connection, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+        const auto lock = std::lock_guard{m_ConnectionsLock};
+        m_Connections.emplace_back([this, connection] { ServeConnection(connection); });
+    }
+}
+
+void StandInServer::ServeConnection(int _socket)
+{
+    std::string input;
+    auto receive = [&]() -> bool {
+        while( !m_Stop ) {
+            pollfd pfd{.fd = _socket, .events = POLLIN, .revents = 0};
+            if( poll(&pfd, 1, g_PollTimeoutMs) <= 0 )
+                continue;
+            char buf[65536];
+            const ssize_t got = recv(_socket, buf, sizeof(buf), 0);
+            if( got <= 0 )
+                return false;
+            input.append(buf, got);
+            return true;
+        }
+        return false;
+    };
+    auto send_all = [&](std::string_view _data) {
+        while( !_data.empty() ) {
+            const ssize_t sent = send(_socket, _data.data(), _data.size(), 0);
+            if( sent <= 0 )
+                return;
+            _data.remove_prefix(sent);
+            const auto lock = std::lock_guard{m_Lock};
+            m_Stats.bytes_sent += sent;
+        }
+    };
+
+    while( true ) {
+        size_t header_end;
+        while( (header_end = input.find("\r\n\r\n")) == std::string::npos )
+            if( !receive() ) {
+                close(_socket);
+                return;
+            }
+
+        Request request;
+        const std::string_view head = std::string_view(input).substr(0, header_end);
+        size_t line_end = head.find("\r\n");
+        const std::string_view request_line = head.substr(0, line_end);
+        const size_t sp1 = request_line.find(' ');
+        const size_t sp2 = request_line.find(' ', sp1 + 1);
+        request.method = request_line.substr(0, sp1);
+        request.path = URIUnescape(request_line.substr(sp1 + 1, sp2 - sp1 - 1));
+        while( line_end != std::string_view::npos && line_end < head.size() ) {
+            const size_t next = head.find("\r\n", line_end + 2);
+            const std::string_view line = head.substr(line_end + 2, next - line_end - 2);
+            if( const size_t colon = line.find(':'); colon != std::string_view::npos ) {
+                std::string_view value = line.substr(colon + 1);
+                while( value.starts_with(' ') )
+                    value.remove_prefix(1);
+                request.headers[Lowercase(std::string(line.substr(0, colon)))] = value;
+            }
+            line_end = next;
+        }
+        input.erase(0, header_end + 4);
+
+        if( request.headers["expect"] == "100-continue" )
+            send_all("HTTP/1.1 100 Continue\r\n\r\n");
+
+        const size_t body_size =
+            request.headers.contains("content-length") ? std::stoul(request.headers["content-length"]) : 0;
+        while( input.size() < body_size )
+            if( !receive() ) {
+                close(_socket);
+                return;
+            }
+        request.body = input.substr(0, body_size);
+        input.erase(0, body_size);
+
+        send_all(Respond(request));
+    }
+}
+
+std::string StandInServer::Respond(const Request &_request)
+{
+    std::chrono::milliseconds latency;
+    {
+        const auto lock = std::lock_guard{m_Lock};
+        latency = m_Latency;
+        m_Stats.max_concurrent_requests = std::max(m_Stats.max_concurrent_requests, ++m_Concurrent);
+    }
+    std::this_thread::sleep_for(latency);
+
+    std::string response;
+    if( _request.method == "OPTIONS" )
+        response = Response(200, "OK", "Allow: OPTIONS, GET, HEAD, PROPFIND\r\nDAV: 1\r\n", "");
+    else if( _request.method == "PROPFIND" )
+        response = RespondPropFind(_request);
+    else if( _request.method == "GET" )
+        response = RespondGet(_request);
+    else
+        response = Response(405, "Method Not Allowed", "", "");
+
+    const auto lock = std::lock_guard{m_Lock};
+    --m_Concurrent;
+    return response;
+}
+
+std::string StandInServer::RespondPropFind(const Request &_request)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    const auto path = Normalized(_request.path);
+    const auto it = m_Nodes.find(path);
+    if( it == m_Nodes.end() )
+        return Response(404, "Not Found", "", "");
+
+    const auto depth = _request.headers.contains("depth") ? _request.headers.at("depth") : "1";
+    std::string body = "<?xml version=\"1.0\" encoding=\"utf-8\"?><D:multistatus xmlns:D=\"DAV:\">";
+    body += PropFindEntry(path, it->second);
+    if( depth == "0" ) {
+        ++m_Stats.propfinds_depth0;
+    }
+    else {
+        ++m_Stats.propfinds_depth1;
+        const std::string prefix = path == "/" ? "/" : path + "/";
+        for( auto child = m_Nodes.upper_bound(prefix); child != m_Nodes.end(); ++child ) {
+            if( !child->first.starts_with(prefix) )
+                break;
+            if( child->first.find('/', prefix.size()) == std::string::npos )
+                body += PropFindEntry(child->first, child->second);
+        }
+    }
+    body += "</D:multistatus>";
+
+    return Response(207, "Multi-Status", "Content-Type: application/xml; charset=\"utf-8\"\r\n", body);
+}
+
+std::string StandInServer::RespondGet(const Request &_request)
+{
+    const auto lock = std::lock_guard{m_Lock};
+    const auto it = m_Nodes.find(Normalized(_request.path));
+    if( it == m_Nodes.end() || it->second.is_dir )
+        return Response(404, "Not Found", "", "");
+
+    ++m_Stats.gets;
+    const std::string &contents = it->second.contents;
+    const auto range = _request.headers.find("range");
+    if( !m_RangesSupported || range == _request.headers.end() || !range->second.starts_with("bytes=") )
+        return Response(200, "OK", "", contents);
+
+    // "bytes=first-last" or "bytes=first-"
+    const std::string_view spec = std::string_view(range->second).substr(6);
+    const size_t dash = spec.find('-');
+    const size_t first = std::stoul(std::string(spec.substr(0, dash)));
+    size_t last = contents.size() - 1;
+    if( dash != std::string_view::npos && dash + 1 < spec.size() )
+        last = std::min(last, static_cast<size_t>(std::stoul(std::string(spec.substr(dash + 1)))));
+    if( first >= contents.size() || first > last )
+        return Response(
+            416, "Range Not Satisfiable", fmt::format("Content-Range: bytes */{}\r\n", contents.size()), "");
+
+    ++m_Stats.ranged_gets;
+    return Response(206,
+                    "Partial Content",
+                    fmt::format("Content-Range: bytes {}-{}/{}\r\n", first, last, contents.size()),
+                    std::string_view(contents).substr(first, last - first + 1));
+}
+
+std::string StandInServer::PropFindEntry(const std::string &_path, const Node &_node) const
+{
+    const auto href = URIEscape(_node.is_dir && _path != "/" ? _path + "/" : _path);
+    return fmt::format("<D:response><D:href>{}</D:href><D:propstat><D:prop>"
+                       "<D:resourcetype>{}</D:resourcetype>"
+                       "{}"
+                       "<D:getlastmodified>{}</D:getlastmodified>"
+                       "{}"
+                       "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>",
+                       href,
+                       _node.is_dir ? "<D:collection/>" : "",
+                       _node.is_dir ? "" : fmt::format("<D:getcontentlength>{}</D:getcontentlength>",
+                                                       _node.contents.size()),
+                       RFC1123(_node.mtime),
+                       _node.is_dir && !m_CollectionETags
+                           ? std::string{}
+                           : fmt::format("<D:getetag>\"{}\"</D:getetag>", _node.etag));
+}
+
+} // namespace nc::vfs::webdav::test
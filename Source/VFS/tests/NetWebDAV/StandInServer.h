@@ -0,0 +1,91 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace nc::vfs::webdav::test {
+
+// A minimal WebDAV server listening on the loopback interface, serves an in-memory tree of files.
+// Understands OPTIONS, PROPFIND with depths 0 and 1 and GET with a single byte range, ignores the authentication.
+// Mimics Nextcloud in bumping the ETags of all the parent directories upon any change inside them.
+class StandInServer
+{
+public:
+    struct Statistics {
+        size_t propfinds_depth0 = 0;
+        size_t propfinds_depth1 = 0;
+        size_t gets = 0;
+        size_t ranged_gets = 0;
+        size_t max_concurrent_requests = 0;
+        size_t bytes_sent = 0; // accepted by the sockets, including the headers
+    };
+
+    // Starts listening on an ephemeral port, throws std::runtime_error on failure.
+    StandInServer();
+    ~StandInServer();
+
+    int Port() const noexcept;
+
+    // Adds a directory or a file, the parent directory must exist. Adding an existing file replaces its contents.
+    void AddDirectory(std::string_view _path);
+    void AddFile(std::string_view _path, std::string_view _contents);
+
+    // Delays every response, which makes the concurrency of the requests observable.
+    void SetLatency(std::chrono::milliseconds _latency);
+
+    // Makes GET ignore the "Range" header and respond with the whole file, as some servers do.
+    void SetRangesSupport(bool _supported);
+
+    // Makes PROPFIND omit the ETags of the directories, leaving only their modification dates, as some servers do.
+    void SetCollectionETags(bool _provided);
+
+    Statistics Stats() const;
+    void ResetStats();
+
+private:
+    struct Node {
+        bool is_dir = false;
+        std::string contents;
+        uint64_t etag = 0;
+        time_t mtime = 0;
+    };
+    struct Request {
+        std::string method;
+        std::string path;
+        std::map<std::string, std::string> headers; // with lowercased names
+        std::string body;
+    };
+
+    void AcceptConnections();
+    void ServeConnection(int _socket);
+    std::string Respond(const Request &_request);
+    std::string RespondPropFind(const Request &_request);
+    std::string RespondGet(const Request &_request);
+    void Touch(std::string_view _path);
+    std::string PropFindEntry(const std::string &_path, const Node &_node) const;
+
+    int m_Socket = -1;
+    int m_Port = 0;
+    std::atomic_bool m_Stop = false;
+    std::thread m_Acceptor;
+    std::vector<std::thread> m_Connections;
+    std::mutex m_ConnectionsLock;
+
+    mutable std::mutex m_Lock;
+    std::map<std::string, Node> m_Nodes; // "/" for the root, no trailing slashes otherwise
+    uint64_t m_LastETag = 0;
+    std::chrono::milliseconds m_Latency{0};
+    bool m_RangesSupported = true;
+    bool m_CollectionETags = true;
+    Statistics m_Stats;
+    size_t m_Concurrent = 0;
+};
+
+} // namespace nc::vfs::webdav::test
@@ -1,9 +1,13 @@
-// Copyright (C) 2019-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2019-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Tests.h"
 #include "TestEnv.h"
 #include "SearchForFiles.h"
 #include <Utility/PathManip.h>
 #include <Native.h>
+#include <atomic>
+#include <chrono>
+#include <fmt/format.h>
+#include <mutex>
 #include <set>
 #include <fstream>
 #include <sys/stat.h>
@@ -224,6 +228,80 @@ TEST_CASE(PREFIX "Test content filter")
     }
 }
 
+TEST_CASE(PREFIX "Parallel mode finds the same entries")
+{
+    using Options = SearchForFiles::Options;
+    TestDir test_dir;
+    const std::string root = test_dir.directory;
+    for( int d = 0; d < 10; ++d ) {
+        MkDir(fmt::format("{}dir{}", root, d));
+        MkDir(fmt::format("{}dir{}/sub", root, d));
+        for( int f = 0; f < 20; ++f ) {
+            Save(fmt::format("{}dir{}/file{}.txt", root, d, f), f % 3 ? "nothing here" : "a needle in a haystack");
+            Save(fmt::format("{}dir{}/sub/file{}.txt", root, d, f), f % 4 ? "still nothing" : "one more needle");
+        }
+    }
+    auto &host = TestEnv().vfs_native;
+
+    const auto search = [&](int _flags, bool _by_content) {
+        std::set<std::string> found;
+        std::mutex found_lock;
+        SearchForFiles search;
+        if( _by_content )
+            search.SetFilterContent({.text = "needle"});
+        search.SetMaxWorkers(4);
+        search.Go(
+            root,
+            host,
+            _flags,
+            [&](const char *_filename, const char *_in_path, VFSHost &, CFRange _pos) {
+                const auto lock = std::lock_guard{found_lock};
+                found.emplace(fmt::format("{}/{}@{}", _in_path, _filename, _pos.location));
+            },
+            {});
+        search.Wait();
+        return found;
+    };
+
+    for( const bool by_content : {false, true} ) {
+        INFO(by_content);
+        const int flags = Options::GoIntoSubDirs | Options::SearchForFiles | Options::SearchForDirs;
+        const auto sequential = search(flags, by_content);
+        const auto parallel = search(flags | Options::Parallel, by_content);
+        CHECK(sequential.size() == (by_content ? 10 * (7 + 5) : 10 * (2 + 40)));
+        CHECK(parallel == sequential);
+    }
+}
+
+TEST_CASE(PREFIX "Parallel mode stops promptly")
+{
+    using Options = SearchForFiles::Options;
+    TestDir test_dir;
+    const std::string root = test_dir.directory;
+    for( int d = 0; d < 50; ++d ) {
+        MkDir(fmt::format("{}dir{}", root, d));
+        for( int f = 0; f < 50; ++f )
+            Save(fmt::format("{}dir{}/file{}.txt", root, d, f), "needle");
+    }
+    auto &host = TestEnv().vfs_native;
+
+    std::atomic_int found = 0;
+    SearchForFiles search;
+    search.SetFilterContent({.text = "needle"});
+    search.Go(
+        root,
+        host,
+        Options::GoIntoSubDirs | Options::SearchForFiles | Options::Parallel,
+        [&](const char *, const char *, VFSHost &, CFRange) {
+            if( ++found == 10 )
+                search.Stop();
+        },
+        {});
+    search.Wait();
+    CHECK(found >= 10);
+    CHECK(found < 2500);
+}
+
 static void BuildTestData(const std::string &_root_path)
 {
     Save(_root_path + "filename1.txt", "Hello, world!");
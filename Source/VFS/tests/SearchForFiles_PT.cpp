@@ -0,0 +1,77 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+// #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "Tests.h"
+#include "TestEnv.h"
+#include "SearchForFiles.h"
+#include <atomic>
+#include <fmt/format.h>
+#include <fstream>
+#include <thread>
+
+using nc::vfs::SearchForFiles;
+
+#define PREFIX "[nc::vfs::SearchForFiles] PT "
+
+// 200 directories * 100 files * 16KB = 20'000 files, 312MB.
+static constexpr int g_Dirs = 200;
+static constexpr int g_Files = 100;
+static constexpr size_t g_FileSize = 16 * 1024;
+
+static void BuildTree(const std::filesystem::path &_root)
+{
+    std::string content;
+    for( size_t i = 0; content.size() < g_FileSize; ++i )
+        content += fmt::format("int function_{}(int _arg) {{ return _arg * {}; }}\n", i, i);
+    content.resize(g_FileSize);
+    for( int d = 0; d < g_Dirs; ++d ) {
+        const auto dir = _root / fmt::format("module{}", d);
+        std::filesystem::create_directories(dir);
+        for( int f = 0; f < g_Files; ++f ) {
+            std::ofstream out(dir / fmt::format("source{}.cpp", f), std::ios::binary);
+            out << content;
+            if( f == d % g_Files )
+                out << "the needle";
+        }
+    }
+}
+
+TEST_CASE(PREFIX "content search scaling", "[!benchmark]")
+{
+    using Options = SearchForFiles::Options;
+    const TestDir dir;
+    BuildTree(dir.directory);
+    auto &host = TestEnv().vfs_native;
+
+    const auto search = [&](int _workers) {
+        SearchForFiles search;
+        search.SetFilterContent({.text = "needle", .case_sensitive = true});
+        search.SetMaxWorkers(_workers);
+        std::atomic_int found = 0;
+        search.Go(dir.directory,
+                  host,
+                  Options::GoIntoSubDirs | Options::SearchForFiles | Options::Parallel,
+                  [&](const char *, const char *, VFSHost &, CFRange) { ++found; },
+                  {});
+        search.Wait();
+        return found.load();
+    };
+
+    REQUIRE(search(1) == g_Dirs);
+    BENCHMARK("1 worker")
+    {
+        return search(1);
+    };
+    BENCHMARK("2 workers")
+    {
+        return search(2);
+    };
+    BENCHMARK("4 workers")
+    {
+        return search(4);
+    };
+    const int cores = static_cast<int>(std::thread::hardware_concurrency());
+    BENCHMARK(fmt::format("{} workers", cores))
+    {
+        return search(cores);
+    };
+}
@@ -0,0 +1,154 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+// #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "Tests.h"
+#include "SearchInFile.h"
+#include "VFSGenericMemReadOnlyFile.h"
+#include <Utility/Encodings.h>
+#include <Base/CFString.h>
+#include <Base/CFPtr.h>
+#include <fmt/format.h>
+
+using namespace nc::base;
+using nc::utility::Encoding;
+using nc::vfs::FileWindow;
+using nc::vfs::GenericMemReadOnlyFile;
+using nc::vfs::SearchInFile;
+
+#define PREFIX "[nc::vfs::SearchInFile] PT "
+
+// 64MB of source-like text without the needles, so that every search scans the whole file
+static const std::string &Haystack()
+{
+    static const std::string haystack = [] {
+        std::string text;
+        for( size_t i = 0; text.size() < 64 * 1024 * 1024; ++i )
+            text += fmt::format("int function_{}(int _arg) {{ return _arg * {}; }} // Привет, мир\n", i, i);
+        return text;
+    }();
+    return haystack;
+}
+
+static FileWindow MakeFileWindow(std::string_view _data)
+{
+    auto mem_file = std::make_shared<GenericMemReadOnlyFile>("", nullptr, _data);
+    mem_file->Open(VFSFlags::OF_Read);
+    return FileWindow{mem_file};
+}
+
+static SearchInFile::Response Search(std::span<const CFStringRef> _strings, SearchInFile::Options _options)
+{
+    auto fw = MakeFileWindow(Haystack());
+    SearchInFile search{fw};
+    search.SetSearchOptions(_options);
+    search.ToggleTextSearch(_strings, Encoding::ENCODING_UTF8);
+    return search.Search().response;
+}
+
+static SearchInFile::Response SearchRegEx(std::string_view _pattern, SearchInFile::Options _options)
+{
+    auto fw = MakeFileWindow(Haystack());
+    SearchInFile search{fw};
+    search.SetSearchOptions(_options);
+    search.ToggleRegExSearch(_pattern, Encoding::ENCODING_UTF8);
+    return search.Search().response;
+}
+
+static SearchInFile::Response SearchBytes(std::string_view _hex)
+{
+    auto fw = MakeFileWindow(Haystack());
+    SearchInFile search{fw};
+    search.ToggleBytesSearch(SearchInFile::ParseHexBytes(_hex).value());
+    return search.Search().response;
+}
+
+// The approach SearchInFile used before: each window was decoded into UTF-16 and searched via CFStringFind()
+static bool SearchViaCFString(CFStringRef _string, CFStringCompareFlags _flags)
+{
+    auto fw = MakeFileWindow(Haystack());
+    const size_t window_size = fw.WindowSize();
+    std::vector<uint16_t> decoded(window_size);
+    std::vector<uint32_t> indices(window_size);
+    const size_t step = window_size - CFStringGetLength(_string) * 2;
+    for( size_t pos = 0; pos < fw.FileSize(); pos += step ) {
+        const size_t window_pos = std::min(pos, fw.FileSize() - window_size);
+        std::ignore = fw.MoveWindow(window_pos);
+        size_t decoded_size = 0;
+        nc::utility::InterpretAsUnichar(Encoding::ENCODING_UTF8,
+                                        static_cast<const unsigned char *>(fw.Window()),
+                                        window_size,
+                                        decoded.data(),
+                                        indices.data(),
+                                        &decoded_size);
+        const auto window = CFPtr<CFStringRef>::adopt(
+            CFStringCreateWithCharactersNoCopy(nullptr, decoded.data(), decoded_size, kCFAllocatorNull));
+        if( CFStringFind(window.get(), _string, _flags).location != kCFNotFound )
+            return true;
+        if( window_pos + window_size >= fw.FileSize() )
+            break;
+    }
+    return false;
+}
+
+TEST_CASE(PREFIX "text search throughput", "[!benchmark]")
+{
+    using Options = SearchInFile::Options;
+    const CFStringRef ascii[] = {CFSTR("haystack_needle")};
+    const auto cyrillic_string = CFString(reinterpret_cast<const char *>(u8"Прощай, мир"));
+    const CFStringRef cyrillic[] = {*cyrillic_string};
+    const CFStringRef several[] = {CFSTR("haystack_needle"), CFSTR("another_needle"), CFSTR("third_needle")};
+
+    REQUIRE(Search(ascii, Options::None) == SearchInFile::Response::NotFound);
+
+    BENCHMARK("ASCII, case-sensitive")
+    {
+        return Search(ascii, Options::CaseSensitive);
+    };
+    BENCHMARK("ASCII, case-insensitive")
+    {
+        return Search(ascii, Options::None);
+    };
+    BENCHMARK("Cyrillic, case-insensitive")
+    {
+        return Search(cyrillic, Options::None);
+    };
+    BENCHMARK("Three strings, case-insensitive")
+    {
+        return Search(several, Options::None);
+    };
+    BENCHMARK("ASCII, case-sensitive, CFStringFind")
+    {
+        return SearchViaCFString(ascii[0], 0);
+    };
+    BENCHMARK("ASCII, case-insensitive, CFStringFind")
+    {
+        return SearchViaCFString(ascii[0], kCFCompareCaseInsensitive);
+    };
+    BENCHMARK("Cyrillic, case-insensitive, CFStringFind")
+    {
+        return SearchViaCFString(cyrillic[0], kCFCompareCaseInsensitive);
+    };
+}
+
+TEST_CASE(PREFIX "regex and bytes search throughput", "[!benchmark]")
+{
+    using Options = SearchInFile::Options;
+    REQUIRE(SearchRegEx(R"(function_\d+\(long)", Options::CaseSensitive) == SearchInFile::Response::NotFound);
+    REQUIRE(SearchBytes("DE AD BE EF") == SearchInFile::Response::NotFound);
+
+    BENCHMARK("RegEx with a literal prefix, case-sensitive")
+    {
+        return SearchRegEx(R"(function_\d+\(long)", Options::CaseSensitive);
+    };
+    BENCHMARK("RegEx with a literal prefix, case-insensitive")
+    {
+        return SearchRegEx(R"(function_\d+\(long)", Options::None);
+    };
+    BENCHMARK("RegEx with a character class")
+    {
+        return SearchRegEx(R"([xyz]{3}\d)", Options::CaseSensitive);
+    };
+    BENCHMARK("Bytes")
+    {
+        return SearchBytes("DE AD BE EF");
+    };
+}
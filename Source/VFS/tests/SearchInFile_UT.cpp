@@ -1,10 +1,11 @@
-// Copyright (C) 2019-2024 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2019-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Tests.h"
 #include "SearchInFile.h"
 #include "VFSGenericMemReadOnlyFile.h"
 #include <Utility/Encodings.h>
 #include <Utility/StringExtras.h>
 #include <Base/CFString.h>
+#include <vector>
 
 using namespace nc::base;
 using nc::utility::Encoding;
@@ -213,6 +214,206 @@ TEST_CASE(PREFIX "Handles case the whole phrase flag")
     }
 }
 
+TEST_CASE(PREFIX "Searches for several strings at once")
+{
+    auto fw = MakeFileWindow("the quick brown fox jumps over the lazy dog!");
+    auto search = SearchInFile{fw};
+    const CFStringRef strings[] = {CFSTR("dog"), CFSTR("fox"), CFSTR("cat")};
+    search.ToggleTextSearch(strings, Encoding::ENCODING_UTF8);
+    CHECK(CFStringCompare(search.TextSearchString(), CFSTR("dog"), 0) == kCFCompareEqualTo);
+
+    const auto result1 = search.Search();
+    REQUIRE(result1.response == SearchInFile::Response::Found);
+    CHECK(result1.location->offset == 16);
+    CHECK(result1.location->bytes_len == 3);
+
+    const auto result2 = search.Search();
+    REQUIRE(result2.response == SearchInFile::Response::Found);
+    CHECK(result2.location->offset == 40);
+    CHECK(result2.location->bytes_len == 3);
+
+    CHECK(search.Search().response == SearchInFile::Response::NotFound);
+}
+
+TEST_CASE(PREFIX "Can search in UTF-16")
+{
+    using namespace std::string_view_literals;
+    // "hi" at an odd offset is not a valid match, only the one at the even offset is
+    auto fw = MakeFileWindow("ah\0i\0\0h\0I\0"sv);
+    auto search = SearchInFile{fw};
+    search.ToggleTextSearch(CFSTR("hi"), Encoding::ENCODING_UTF16LE);
+    const auto result = search.Search();
+    REQUIRE(result.response == SearchInFile::Response::Found);
+    CHECK(result.location->offset == 6);
+    CHECK(result.location->bytes_len == 4);
+}
+
+TEST_CASE(PREFIX "Can search in single-byte encodings")
+{
+    // "0123ПРИВЕТ" in Windows-1251
+    auto fw = MakeFileWindow("0123\xCF\xD0\xC8\xC2\xC5\xD2");
+    auto search = SearchInFile{fw};
+    const auto cf_string = CFString(reinterpret_cast<const char *>(u8"привет"));
+    search.ToggleTextSearch(*cf_string, Encoding::ENCODING_WIN1251);
+    SECTION("case insensitive")
+    {
+        const auto result = search.Search();
+        REQUIRE(result.response == SearchInFile::Response::Found);
+        CHECK(result.location->offset == 4);
+        CHECK(result.location->bytes_len == 6);
+    }
+    SECTION("case sensitive")
+    {
+        search.SetSearchOptions(SearchInFile::Options::CaseSensitive);
+        CHECK(search.Search().response == SearchInFile::Response::NotFound);
+    }
+}
+
+TEST_CASE(PREFIX "Finds text cut between file windows")
+{
+    const auto window_size = FileWindow::DefaultWindowSize;
+    for( const auto offset : {window_size - 6, window_size - 3, window_size - 1} ) {
+        std::string memory(3 * window_size, '.');
+        memory.replace(offset, 5, "hello");
+        auto fw = MakeFileWindow(memory);
+        auto search = SearchInFile{fw};
+        search.ToggleTextSearch(CFSTR("hello"), Encoding::ENCODING_UTF8);
+        search.SetSearchOptions(SearchInFile::Options::FindWholePhrase);
+        const auto result = search.Search();
+        REQUIRE(result.response == SearchInFile::Response::Found);
+        CHECK(result.location->offset == static_cast<uint64_t>(offset));
+        CHECK(result.location->bytes_len == 5);
+    }
+}
+
+TEST_CASE(PREFIX "Checks the whole phrase across file windows")
+{
+    const auto window_size = FileWindow::DefaultWindowSize;
+    std::string memory(3 * window_size, '.');
+    memory.replace(window_size - 3, 6, "hellos");
+    memory.replace(2 * window_size, 5, "hello");
+    auto fw = MakeFileWindow(memory);
+    auto search = SearchInFile{fw};
+    search.ToggleTextSearch(CFSTR("hello"), Encoding::ENCODING_UTF8);
+    search.SetSearchOptions(SearchInFile::Options::FindWholePhrase);
+    const auto result = search.Search();
+    REQUIRE(result.response == SearchInFile::Response::Found);
+    CHECK(result.location->offset == static_cast<uint64_t>(2 * window_size));
+}
+
+TEST_CASE(PREFIX "Searches for exact bytes")
+{
+    using namespace std::string_view_literals;
+    auto fw = MakeFileWindow("\x00\x01\xDE\xAD\xBE\xEF\x02\xde\xad\xbe\xef"sv);
+    auto search = SearchInFile{fw};
+    const auto bytes = SearchInFile::ParseHexBytes("DE AD be ef");
+    REQUIRE(bytes);
+    search.ToggleBytesSearch(*bytes);
+    search.SetSearchOptions(SearchInFile::Options::FindWholePhrase); // ignored
+
+    const auto result1 = search.Search();
+    REQUIRE(result1.response == SearchInFile::Response::Found);
+    CHECK(result1.location->offset == 2);
+    CHECK(result1.location->bytes_len == 4);
+
+    const auto result2 = search.Search();
+    REQUIRE(result2.response == SearchInFile::Response::Found);
+    CHECK(result2.location->offset == 7);
+    CHECK(result2.location->bytes_len == 4);
+}
+
+TEST_CASE(PREFIX "Doesn't search for empty bytes")
+{
+    auto fw = MakeFileWindow("some data");
+    auto search = SearchInFile{fw};
+    search.ToggleBytesSearch({});
+    CHECK(search.Search().response == SearchInFile::Response::Invalid);
+}
+
+TEST_CASE(PREFIX "Parses hex bytes")
+{
+    using Bytes = std::vector<std::byte>;
+    const auto b = [](auto... _values) { return Bytes{static_cast<std::byte>(_values)...}; };
+    CHECK(SearchInFile::ParseHexBytes("00") == b(0x00));
+    CHECK(SearchInFile::ParseHexBytes("deadBEEF") == b(0xDE, 0xAD, 0xBE, 0xEF));
+    CHECK(SearchInFile::ParseHexBytes(" de ad\tbe\nef ") == b(0xDE, 0xAD, 0xBE, 0xEF));
+    CHECK(SearchInFile::ParseHexBytes("") == std::nullopt);
+    CHECK(SearchInFile::ParseHexBytes("   ") == std::nullopt);
+    CHECK(SearchInFile::ParseHexBytes("abc") == std::nullopt);
+    CHECK(SearchInFile::ParseHexBytes("a bc") == std::nullopt);
+    CHECK(SearchInFile::ParseHexBytes("0x12") == std::nullopt);
+    CHECK(SearchInFile::ParseHexBytes("zz") == std::nullopt);
+}
+
+TEST_CASE(PREFIX "Searches for regular expressions")
+{
+    auto fw = MakeFileWindow("2025-01-01 INFO started\n2025-01-02 ERROR disk full\n2025-01-03 error again\n");
+    auto search = SearchInFile{fw};
+    SECTION("case insensitive")
+    {
+        search.ToggleRegExSearch(R"(^\d{4}-\d\d-\d\d error\b.*$)", Encoding::ENCODING_UTF8);
+        const auto result1 = search.Search();
+        REQUIRE(result1.response == SearchInFile::Response::Found);
+        CHECK(result1.location->offset == 24);
+        CHECK(result1.location->bytes_len == 26);
+
+        const auto result2 = search.Search();
+        REQUIRE(result2.response == SearchInFile::Response::Found);
+        CHECK(result2.location->offset == 51);
+        CHECK(result2.location->bytes_len == 22);
+
+        CHECK(search.Search().response == SearchInFile::Response::NotFound);
+    }
+    SECTION("case sensitive")
+    {
+        search.SetSearchOptions(SearchInFile::Options::CaseSensitive);
+        search.ToggleRegExSearch("[a-z]+ again", Encoding::ENCODING_UTF8);
+        const auto result = search.Search();
+        REQUIRE(result.response == SearchInFile::Response::Found);
+        CHECK(result.location->offset == 62);
+        CHECK(result.location->bytes_len == 11);
+    }
+    SECTION("malformed")
+    {
+        search.ToggleRegExSearch("(unbalanced", Encoding::ENCODING_UTF8);
+        CHECK(search.Search().response == SearchInFile::Response::Invalid);
+    }
+    SECTION("unsupported encoding")
+    {
+        search.ToggleRegExSearch("error", Encoding::ENCODING_UTF16LE);
+        CHECK(search.Search().response == SearchInFile::Response::Invalid);
+    }
+}
+
+TEST_CASE(PREFIX "Searches for regular expressions in single-byte encodings")
+{
+    // "0123 ПРИВЕТ" in Windows-1251
+    auto fw = MakeFileWindow("0123 \xCF\xD0\xC8\xC2\xC5\xD2");
+    auto search = SearchInFile{fw};
+    search.SetSearchOptions(SearchInFile::Options::CaseSensitive);
+    search.ToggleRegExSearch(reinterpret_cast<const char *>(u8"\\d+ ПР.В"), Encoding::ENCODING_WIN1251);
+    const auto result = search.Search();
+    REQUIRE(result.response == SearchInFile::Response::Found);
+    CHECK(result.location->offset == 0);
+    CHECK(result.location->bytes_len == 9);
+}
+
+TEST_CASE(PREFIX "Regular expressions find matches cut between file windows")
+{
+    const auto window_size = FileWindow::DefaultWindowSize;
+    std::string memory(3 * window_size, '\n');
+    const std::string line = "id=" + std::string(1000, '7') + ";";
+    memory.replace(window_size - 500, line.size(), line);
+    auto fw = MakeFileWindow(memory);
+    auto search = SearchInFile{fw};
+    search.ToggleRegExSearch("^id=[0-9]+;$", Encoding::ENCODING_UTF8);
+    const auto result = search.Search();
+    REQUIRE(result.response == SearchInFile::Response::Found);
+    CHECK(result.location->offset == static_cast<uint64_t>(window_size - 500));
+    CHECK(result.location->bytes_len == line.size());
+    CHECK(search.Search().response == SearchInFile::Response::NotFound);
+}
+
 static FileWindow MakeFileWindow(std::string_view _data)
 {
     assert(_data.data() != nullptr);
@@ -0,0 +1,180 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "../source/SegmentedDownload.h"
+#include <VFS/VFSError.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <semaphore>
+#include <string>
+
+using nc::vfs::SegmentedDownload;
+
+#define PREFIX "nc::vfs::SegmentedDownload "
+
+namespace {
+
+// Serves ranges of a memory buffer in small portions, optionally waiting for a permission before each portion.
+struct Source {
+    explicit Source(size_t _size) : data(_size, '\0')
+    {
+        for( size_t i = 0; i < _size; ++i )
+            data[i] = static_cast<char>(i * 7 % 251);
+    }
+
+    std::string data;
+    std::atomic_int fetchers = 0;
+    std::atomic_int concurrent = 0;
+    std::atomic_int max_concurrent = 0;
+    std::atomic_int fetches = 0;
+    std::atomic_int failures_to_inject = 0;
+    std::atomic_int refusals_to_inject = 0;
+    bool gated = false;
+    std::counting_semaphore<> gate{0};
+};
+
+class MemFetcher : public SegmentedDownload::Fetcher
+{
+public:
+    explicit MemFetcher(Source &_source) : m_Source(_source) { ++m_Source.fetchers; }
+
+    int Fetch(uint64_t _offset, uint64_t _length, const Sink &_sink) override
+    {
+        ++m_Source.fetches;
+        const int concurrent = ++m_Source.concurrent;
+        int max = m_Source.max_concurrent;
+        while( max < concurrent && !m_Source.max_concurrent.compare_exchange_weak(max, concurrent) )
+            ;
+        const auto done = [this](int _rc) {
+            --m_Source.concurrent;
+            return _rc;
+        };
+
+        if( m_Source.refusals_to_inject > 0 ) {
+            --m_Source.refusals_to_inject;
+            return done(VFSError::FromErrno(ECONNREFUSED));
+        }
+
+        for( uint64_t pos = _offset; pos < _offset + _length; ) {
+            if( m_Source.gated )
+                m_Source.gate.acquire();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            if( m_Source.failures_to_inject > 0 && pos > _offset ) {
+                --m_Source.failures_to_inject;
+                return done(VFSError::FromErrno(EIO));
+            }
+            const uint64_t size = std::min<uint64_t>(64 * 1024, _offset + _length - pos);
+            if( !_sink(m_Source.data.data() + pos, size) )
+                return done(VFSError::Cancelled);
+            pos += size;
+        }
+        return done(VFSError::Ok);
+    }
+
+private:
+    Source &m_Source;
+};
+
+} // namespace
+
+static std::string ReadAll(SegmentedDownload &_download, uint64_t _offset, uint64_t _size)
+{
+    std::string result;
+    char buf[100'000];
+    while( result.size() < _size ) {
+        const ssize_t rc = _download.Read(_offset + result.size(), buf, std::min(sizeof(buf), _size - result.size()));
+        if( rc <= 0 )
+            break;
+        result.append(buf, rc);
+    }
+    return result;
+}
+
+TEST_CASE(PREFIX "The number of workers depends on the file size")
+{
+    CHECK(SegmentedDownload::WorkersFor(0) == 0);
+    CHECK(SegmentedDownload::WorkersFor(SegmentedDownload::ChunkSize) == 0);
+    CHECK(SegmentedDownload::WorkersFor(2 * SegmentedDownload::ChunkSize) == 2);
+    CHECK(SegmentedDownload::WorkersFor(3 * SegmentedDownload::ChunkSize - 1) == 3);
+    CHECK(SegmentedDownload::WorkersFor(1000 * SegmentedDownload::ChunkSize) == SegmentedDownload::MaxWorkers);
+}
+
+TEST_CASE(PREFIX "Chunks fetched in parallel are reassembled in order")
+{
+    Source source(SegmentedDownload::ChunkSize * 5 + 12'345);
+    {
+        const unsigned workers = SegmentedDownload::WorkersFor(source.data.size());
+        SegmentedDownload download(source.data.size(), workers, [&] { return std::make_unique<MemFetcher>(source); });
+        CHECK(ReadAll(download, 0, source.data.size()) == source.data);
+        char buf[10];
+        CHECK(download.Read(source.data.size(), buf, sizeof(buf)) == 0);
+    }
+    CHECK(source.fetchers == static_cast<int>(SegmentedDownload::MaxWorkers));
+    CHECK(source.fetches == 6);
+    CHECK(source.max_concurrent > 1);
+}
+
+TEST_CASE(PREFIX "Reads don't wait for the whole file to arrive")
+{
+    Source source(SegmentedDownload::ChunkSize * 4);
+    source.gated = true;
+    SegmentedDownload download(source.data.size(), 1, [&] { return std::make_unique<MemFetcher>(source); });
+    source.gate.release(1); // lets only the first portion through
+    char buf[1000];
+    REQUIRE(download.Read(0, buf, sizeof(buf)) > 0);
+    CHECK(std::string_view(buf, 10) == std::string_view(source.data).substr(0, 10));
+
+    // the download is abandoned while the rest of the portions are still pending
+    source.gate.release(1'000);
+}
+
+TEST_CASE(PREFIX "Seeking fetches the chunks at the new position")
+{
+    Source source(SegmentedDownload::ChunkSize * 20);
+    SegmentedDownload download(source.data.size(), 2, [&] { return std::make_unique<MemFetcher>(source); });
+    const uint64_t tail = source.data.size() - 5'000;
+    CHECK(ReadAll(download, tail, 5'000) == source.data.substr(tail));
+    CHECK(ReadAll(download, 1'000, 5'000) == source.data.substr(1'000, 5'000));
+    CHECK(source.fetches < 10);
+}
+
+TEST_CASE(PREFIX "A failed chunk is reported and fetched again")
+{
+    Source source(SegmentedDownload::ChunkSize * 2);
+    source.failures_to_inject = 1;
+    SegmentedDownload download(source.data.size(), 1, [&] { return std::make_unique<MemFetcher>(source); });
+    char buf[100];
+    ssize_t rc = download.Read(SegmentedDownload::ChunkSize - 100, buf, sizeof(buf));
+    CHECK(rc == VFSError::FromErrno(EIO));
+    rc = download.Read(SegmentedDownload::ChunkSize - 100, buf, sizeof(buf));
+    REQUIRE(rc == sizeof(buf));
+    CHECK(std::string_view(buf, rc) == std::string_view(source.data).substr(SegmentedDownload::ChunkSize - 100, 100));
+}
+
+TEST_CASE(PREFIX "Workers refused by the server leave their chunks to the others")
+{
+    Source source(SegmentedDownload::ChunkSize * 5 + 12'345);
+    source.refusals_to_inject = 3;
+    SegmentedDownload download(source.data.size(), 4, [&] { return std::make_unique<MemFetcher>(source); });
+    CHECK(ReadAll(download, 0, source.data.size()) == source.data);
+    CHECK(source.fetches == 6 + 3);
+}
+
+TEST_CASE(PREFIX "A refusal of the last worker is reported")
+{
+    Source source(SegmentedDownload::ChunkSize * 2);
+    source.refusals_to_inject = 1;
+    SegmentedDownload download(source.data.size(), 1, [&] { return std::make_unique<MemFetcher>(source); });
+    char buf[100];
+    CHECK(download.Read(0, buf, sizeof(buf)) == VFSError::FromErrno(ECONNREFUSED));
+    REQUIRE(download.Read(0, buf, sizeof(buf)) == sizeof(buf));
+    CHECK(std::string_view(buf, sizeof(buf)) == std::string_view(source.data).substr(0, sizeof(buf)));
+}
+
+TEST_CASE(PREFIX "Fails if no worker could connect")
+{
+    SegmentedDownload download(SegmentedDownload::ChunkSize * 2, 2, [] { return nullptr; });
+    char buf[100];
+    CHECK(download.Read(0, buf, sizeof(buf)) == VFSError::FromErrno(EIO));
+}
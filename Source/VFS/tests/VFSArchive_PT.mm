@@ -1,14 +1,56 @@
-// Copyright (C) 2022 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2022-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 // #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "Tests.h"
 #include "TestEnv.h"
 #include <VFS/VFS.h>
 #include <VFS/ArcLA.h>
+#include <libarchive/archive.h>
+#include <libarchive/archive_entry.h>
+#include <fmt/format.h>
+#include <malloc/malloc.h>
 
 #define PREFIX "VFSArchive PT "
 
 using namespace nc::vfs;
 
+// 1000 directories * 1000 files = 1'001'000 entries.
+static constexpr int g_Dirs = 1000;
+static constexpr int g_Files = 1000;
+
+static size_t HeapInUse()
+{
+    malloc_statistics_t stats;
+    malloc_zone_statistics(nullptr, &stats);
+    return stats.size_in_use;
+}
+
+static void WriteHugeArchive(const std::filesystem::path &_path)
+{
+    archive *const arc = archive_write_new();
+    REQUIRE(archive_write_set_format_zip(arc) == ARCHIVE_OK);
+    REQUIRE(archive_write_set_options(arc, "zip:compression=store") == ARCHIVE_OK);
+    REQUIRE(archive_write_open_filename(arc, _path.c_str()) == ARCHIVE_OK);
+    archive_entry *const entry = archive_entry_new();
+    for( int d = 0; d < g_Dirs; ++d ) {
+        archive_entry_clear(entry);
+        archive_entry_set_pathname(entry, fmt::format("directory{}/", d).c_str());
+        archive_entry_set_mode(entry, S_IFDIR | 0755);
+        archive_entry_set_mtime(entry, 1700000000, 0);
+        REQUIRE(archive_write_header(arc, entry) == ARCHIVE_OK);
+        for( int f = 0; f < g_Files; ++f ) {
+            archive_entry_clear(entry);
+            archive_entry_set_pathname(entry, fmt::format("directory{}/source_file_{:07}.cpp", d, f).c_str());
+            archive_entry_set_mode(entry, S_IFREG | 0644);
+            archive_entry_set_size(entry, 0);
+            archive_entry_set_mtime(entry, 1700000000, 0);
+            REQUIRE(archive_write_header(arc, entry) == ARCHIVE_OK);
+        }
+    }
+    archive_entry_free(entry);
+    REQUIRE(archive_write_close(arc) == ARCHIVE_OK);
+    archive_write_free(arc);
+}
+
 TEST_CASE(PREFIX "Open chromium-main.zip", "[!benchmark]")
 {
     std::shared_ptr<ArchiveHost> host;
@@ -18,3 +60,40 @@ TEST_CASE(PREFIX "Open chromium-main.zip", "[!benchmark]")
         REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path, TestEnv().vfs_native));
     };
 }
+
+TEST_CASE(PREFIX "Memory and listing time of a 1M-entry archive", "[!benchmark]")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "huge.zip";
+    WriteHugeArchive(path);
+
+    const size_t heap0 = HeapInUse();
+    std::shared_ptr<ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    const size_t heap1 = HeapInUse();
+    REQUIRE(host->StatTotalFiles() == g_Dirs * (g_Files + 1));
+
+    const double per_entry = double(heap1 - heap0) / host->StatTotalFiles();
+    fmt::println("ArchiveHost with {} entries: {:.1f} MB of heap, {:.1f} bytes per entry",
+                 host->StatTotalFiles(),
+                 double(heap1 - heap0) / 1024. / 1024.,
+                 per_entry);
+    // a full struct stat with a std::string per entry used to take well over 200 bytes
+    CHECK(per_entry < 160.);
+
+    BENCHMARK("Open")
+    {
+        return std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native);
+    };
+    BENCHMARK("Fetch a directory listing")
+    {
+        return host->FetchDirectoryListing("/directory500", VFSFlags::F_NoDotDot).value();
+    };
+    BENCHMARK("Stat every entry of a directory")
+    {
+        int64_t total = 0;
+        for( int f = 0; f < g_Files; ++f )
+            total += host->Stat(fmt::format("/directory500/source_file_{:07}.cpp", f), 0).value().size;
+        return total;
+    };
+}
@@ -4,9 +4,12 @@
 #include <VFS/VFS.h>
 #include <VFS/ArcLA.h>
 #include "../source/ArcLA/Internal.h" // FIXME!
+#include "../source/ArcLA/ListingIndex.h"
 #include <VFS/VFSGenericMemReadOnlyFile.h>
 #include <Base/WriteAtomically.h>
 #include <Base/algo.h>
+#include <fmt/format.h>
+#include <fstream>
 
 using namespace nc::vfs;
 
@@ -2102,3 +2105,307 @@ TEST_CASE(PREFIX "synthetic directories can be correctly resolved")
     REQUIRE(host->IsSymlink("/etc/rc0.d/K01cryptdisks", VFSFlags::F_NoFollow));
     REQUIRE(readsym("/etc/rc0.d/K01cryptdisks") == "../init.d/cryptdisks");
 }
+
+// d/ - dir, d/f - reg with _content, x/y/z - reg under synthetic directories, l -> d/f
+static void WriteListingIndexTestArchive(const std::filesystem::path &_path, std::string_view _content)
+{
+    archive *const arc = archive_write_new();
+    REQUIRE(archive_write_set_format_pax_restricted(arc) == ARCHIVE_OK);
+    REQUIRE(archive_write_open_filename(arc, _path.c_str()) == ARCHIVE_OK);
+    const auto add = [&](const char *_name, mode_t _mode, std::string_view _data, const char *_symlink) {
+        archive_entry *const entry = archive_entry_new();
+        archive_entry_set_pathname(entry, _name);
+        archive_entry_set_mode(entry, _mode);
+        archive_entry_set_size(entry, _data.size());
+        archive_entry_set_mtime(entry, 1700000000, 0);
+        if( _symlink )
+            archive_entry_set_symlink(entry, _symlink);
+        REQUIRE(archive_write_header(arc, entry) == ARCHIVE_OK);
+        if( !_data.empty() )
+            REQUIRE(archive_write_data(arc, _data.data(), _data.size()) == static_cast<ssize_t>(_data.size()));
+        archive_entry_free(entry);
+    };
+    add("d/", S_IFDIR | 0755, {}, nullptr);
+    add("d/f", S_IFREG | 0644, _content, nullptr);
+    add("x/y/z", S_IFREG | 0644, "z", nullptr);
+    add("l", S_IFLNK | 0755, {}, "d/f");
+    REQUIRE(archive_write_close(arc) == ARCHIVE_OK);
+    archive_write_free(arc);
+}
+
+TEST_CASE(PREFIX "Listing index is stored and used when re-opening the archive")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "arc.tar";
+    const auto index_dir = dir.directory / "indices";
+    WriteListingIndexTestArchive(path, "Hello");
+
+    ArchiveHost::SetListingIndexDirectory(index_dir, 0);
+    const auto disable_index = at_scope_end([] { ArchiveHost::SetListingIndexDirectory({}); });
+
+    std::shared_ptr<ArchiveHost> scanned;
+    REQUIRE_NOTHROW(scanned = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    REQUIRE(std::filesystem::exists(arc::ListingIndexStorage(index_dir).IndexPath(path.native())));
+
+    std::shared_ptr<ArchiveHost> indexed;
+    REQUIRE_NOTHROW(indexed = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    CHECK(indexed->StatTotalFiles() == scanned->StatTotalFiles());
+    CHECK(indexed->StatTotalDirs() == scanned->StatTotalDirs());
+    CHECK(indexed->StatTotalRegs() == scanned->StatTotalRegs());
+
+    for( const char *directory : {"/", "/d", "/x", "/x/y"} ) {
+        INFO(directory);
+        const auto lhs = scanned->FetchDirectoryListing(directory, VFSFlags::F_NoDotDot).value();
+        const auto rhs = indexed->FetchDirectoryListing(directory, VFSFlags::F_NoDotDot).value();
+        REQUIRE(lhs->Count() == rhs->Count());
+        for( unsigned i = 0; i < lhs->Count(); ++i ) {
+            CHECK(lhs->Filename(i) == rhs->Filename(i));
+            CHECK(lhs->UnixMode(i) == rhs->UnixMode(i));
+            CHECK(lhs->Size(i) == rhs->Size(i));
+            CHECK(lhs->MTime(i) == rhs->MTime(i));
+        }
+    }
+    CHECK(indexed->ReadSymlink("/l").value() == "d/f");
+    CHECK(indexed->Stat("/l", 0).value().size == 5);
+    CHECK(indexed->StatFS("/").value().total_bytes == scanned->StatFS("/").value().total_bytes);
+    CheckFileIs(*indexed, "/d/f", "Hello");
+    CheckFileIs(*indexed, "/x/y/z", "z");
+}
+
+TEST_CASE(PREFIX "Listing index is used only while the archive stays the same")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "arc.tar";
+    const auto index_dir = dir.directory / "indices";
+    WriteListingIndexTestArchive(path, "Hello");
+
+    ArchiveHost::SetListingIndexDirectory(index_dir, 0);
+    const auto disable_index = at_scope_end([] { ArchiveHost::SetListingIndexDirectory({}); });
+
+    // put a fabricated listing for the current state of the archive
+    struct stat st;
+    REQUIRE(::stat(path.c_str(), &st) == 0);
+    const arc::ListingIndexKey key{
+        .path = path.native(), .size = uint64_t(st.st_size), .mtime = st.st_mtimespec, .inode = st.st_ino};
+    arc::NamesPool names;
+    arc::Dir root;
+    root.full_path = "/";
+    arc::DirEntry &fake = root.entries.emplace_back();
+    REQUIRE(names.Add("fake", fake));
+    fake.mode = S_IFREG | 0644;
+    fake.size = 42;
+    fake.aruid = 1;
+    const arc::Dir *const directories[] = {&root};
+    const arc::ListingIndexSummary summary{.total_files = 1, .total_regs = 1, .last_item_uid = 0};
+    REQUIRE(arc::ListingIndexStorage(index_dir).Store(
+        key, arc::ComposeListingIndex(key, summary, directories, names, {})));
+
+    std::shared_ptr<ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    CHECK(host->StatTotalFiles() == 1);
+    CHECK(host->Stat("/fake", 0).value().size == 42);
+    CHECK(!host->Exists("/d/f"));
+
+    // changing the archive invalidates the index
+    const auto new_path = dir.directory / "arc.tar.new";
+    WriteListingIndexTestArchive(new_path, "Hello, World!");
+    std::filesystem::rename(new_path, path);
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    CHECK(host->StatTotalFiles() == 4);
+    CHECK(!host->Exists("/fake"));
+    CheckFileIs(*host, "/d/f", "Hello, World!");
+}
+
+TEST_CASE(PREFIX "Malformed listing index is ignored")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "arc.tar";
+    const auto index_dir = dir.directory / "indices";
+    WriteListingIndexTestArchive(path, "Hello");
+
+    ArchiveHost::SetListingIndexDirectory(index_dir, 0);
+    const auto disable_index = at_scope_end([] { ArchiveHost::SetListingIndexDirectory({}); });
+
+    std::shared_ptr<ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    const auto index_path = arc::ListingIndexStorage(index_dir).IndexPath(path.native());
+    REQUIRE(std::filesystem::exists(index_path));
+
+    // cut the index in half
+    std::filesystem::resize_file(index_path, std::filesystem::file_size(index_path) / 2);
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    CHECK(host->StatTotalFiles() == 4);
+    CheckFileIs(*host, "/d/f", "Hello");
+}
+
+static void WriteDirectAccessTestArchive(const std::filesystem::path &_path,
+                                         int _format,
+                                         int _filter,
+                                         const char *_options,
+                                         const std::vector<std::pair<std::string, std::string>> &_files)
+{
+    archive *const arc = archive_write_new();
+    REQUIRE(archive_write_set_format(arc, _format) == ARCHIVE_OK);
+    REQUIRE(archive_write_add_filter(arc, _filter) == ARCHIVE_OK);
+    if( _options )
+        REQUIRE(archive_write_set_options(arc, _options) == ARCHIVE_OK);
+    REQUIRE(archive_write_open_filename(arc, _path.c_str()) == ARCHIVE_OK);
+    for( const auto &[name, data] : _files ) {
+        archive_entry *const entry = archive_entry_new();
+        archive_entry_set_pathname(entry, name.c_str());
+        archive_entry_set_mode(entry, S_IFREG | 0644);
+        archive_entry_set_size(entry, data.size());
+        REQUIRE(archive_write_header(arc, entry) == ARCHIVE_OK);
+        REQUIRE(archive_write_data(arc, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+        archive_entry_free(entry);
+    }
+    REQUIRE(archive_write_close(arc) == ARCHIVE_OK);
+    archive_write_free(arc);
+}
+
+static std::vector<std::pair<std::string, std::string>> DirectAccessTestFiles()
+{
+    std::vector<std::pair<std::string, std::string>> files;
+    for( int i = 0; i < 100; ++i ) {
+        std::string data;
+        for( int j = 0; j <= i * 100; ++j )
+            data += std::to_string(i * j);
+        files.emplace_back(fmt::format("dir{}/file{}.txt", i % 7, i), std::move(data));
+    }
+    return files;
+}
+
+TEST_CASE(PREFIX "Entries of zip and tar archives are read directly")
+{
+    struct TC {
+        const char *name;
+        int format;
+        int filter;
+        const char *options;
+        VFSFile::ReadParadigm paradigm;
+    };
+    using RP = VFSFile::ReadParadigm;
+    const TC tcs[] = {
+        {"arc.zip", ARCHIVE_FORMAT_ZIP, ARCHIVE_FILTER_NONE, "zip:compression=store", RP::Seek},
+        {"arc.zip", ARCHIVE_FORMAT_ZIP, ARCHIVE_FILTER_NONE, "zip:compression=deflate", RP::Sequential},
+        {"arc.tar", ARCHIVE_FORMAT_TAR_PAX_RESTRICTED, ARCHIVE_FILTER_NONE, nullptr, RP::Seek},
+        {"arc.tar.gz", ARCHIVE_FORMAT_TAR_PAX_RESTRICTED, ARCHIVE_FILTER_GZIP, nullptr, RP::Sequential},
+    };
+    const auto files = DirectAccessTestFiles();
+    for( const auto &tc : tcs ) {
+        INFO(tc.name);
+        INFO((tc.options ? tc.options : ""));
+        const TestDir dir;
+        const auto path = dir.directory / tc.name;
+        WriteDirectAccessTestArchive(path, tc.format, tc.filter, tc.options, files);
+
+        std::shared_ptr<ArchiveHost> host;
+        REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+
+        // read the entries in the reverse order to never benefit from the sequential states
+        for( auto it = files.rbegin(); it != files.rend(); ++it )
+            CheckFileIs(*host, "/" + it->first, it->second);
+
+        const VFSFilePtr file = host->CreateFile("/" + files[42].first).value();
+        REQUIRE(file->Open(VFSFlags::OF_Read) == 0);
+        CHECK(file->GetReadParadigm() == tc.paradigm);
+        if( tc.paradigm == VFSFile::ReadParadigm::Seek ) {
+            const std::string &expected = files[42].second;
+            char buf[10];
+            REQUIRE(file->Seek(1000, VFSFile::Seek_Set) == 1000);
+            REQUIRE(file->Read(buf, sizeof(buf)) == sizeof(buf));
+            CHECK(std::string_view(buf, sizeof(buf)) == std::string_view(expected).substr(1000, sizeof(buf)));
+            REQUIRE(file->Seek(-5, VFSFile::Seek_End) == static_cast<off_t>(expected.size() - 5));
+            REQUIRE(file->Read(buf, sizeof(buf)) == 5);
+            CHECK(std::string_view(buf, 5) == std::string_view(expected).substr(expected.size() - 5));
+            CHECK(file->Eof());
+        }
+    }
+}
+
+TEST_CASE(PREFIX "Direct reading of zip entries verifies the checksums")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "arc.zip";
+    WriteDirectAccessTestArchive(path,
+                                 ARCHIVE_FORMAT_ZIP,
+                                 ARCHIVE_FILTER_NONE,
+                                 "zip:compression=store",
+                                 {{"a.txt", "Hello, World!"}, {"b.txt", "Goodbye, World!"}});
+
+    // damage the stored data of the second entry without touching any headers
+    std::string image;
+    {
+        std::ifstream in(path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const auto pos = image.find("Goodbye");
+    REQUIRE(pos != std::string::npos);
+    image[pos] = 'g';
+    REQUIRE(nc::base::WriteAtomically(path, {reinterpret_cast<const std::byte *>(image.data()), image.size()}));
+
+    std::shared_ptr<ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    CheckFileIs(*host, "/a.txt", "Hello, World!");
+    const VFSFilePtr file = host->CreateFile("/b.txt").value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == 0);
+    CHECK(!file->ReadFile());
+}
+
+TEST_CASE(PREFIX "Direct access locations are kept in the listing index")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "arc.tar";
+    const auto index_dir = dir.directory / "indices";
+    const auto files = DirectAccessTestFiles();
+    WriteDirectAccessTestArchive(path, ARCHIVE_FORMAT_TAR_PAX_RESTRICTED, ARCHIVE_FILTER_NONE, nullptr, files);
+
+    ArchiveHost::SetListingIndexDirectory(index_dir, 0);
+    const auto disable_index = at_scope_end([] { ArchiveHost::SetListingIndexDirectory({}); });
+
+    std::shared_ptr<ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    const VFSFilePtr file = host->CreateFile("/" + files.back().first).value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == 0);
+    CHECK(file->GetReadParadigm() == VFSFile::ReadParadigm::Seek);
+    CheckFileIs(*host, "/" + files.back().first, files.back().second);
+}
+
+TEST_CASE(PREFIX "Compact entries keep the times with nanoseconds")
+{
+    const TestDir dir;
+    const auto path = dir.directory / "arc.tar";
+    {
+        archive *const arc = archive_write_new();
+        REQUIRE(archive_write_set_format_pax(arc) == ARCHIVE_OK);
+        REQUIRE(archive_write_open_filename(arc, path.c_str()) == ARCHIVE_OK);
+        archive_entry *const entry = archive_entry_new();
+        archive_entry_set_pathname(entry, "f");
+        archive_entry_set_mode(entry, S_IFREG | 0644);
+        archive_entry_set_size(entry, 0);
+        archive_entry_set_mtime(entry, 1700000000, 123456789);
+        archive_entry_set_atime(entry, -1000, 0);
+        archive_entry_set_uid(entry, 501);
+        archive_entry_set_gid(entry, 20);
+        REQUIRE(archive_write_header(arc, entry) == ARCHIVE_OK);
+        archive_entry_free(entry);
+        REQUIRE(archive_write_close(arc) == ARCHIVE_OK);
+        archive_write_free(arc);
+    }
+
+    std::shared_ptr<ArchiveHost> host;
+    REQUIRE_NOTHROW(host = std::make_shared<ArchiveHost>(path.c_str(), TestEnv().vfs_native));
+    const VFSStat st = host->Stat("/f", 0).value();
+    CHECK(st.mtime.tv_sec == 1700000000);
+    CHECK(st.mtime.tv_nsec == 123456789);
+    CHECK(st.atime.tv_sec == -1000);
+    CHECK(st.atime.tv_nsec == 0);
+    CHECK(st.uid == 501);
+    CHECK(st.gid == 20);
+
+    const auto listing = host->FetchDirectoryListing("/", VFSFlags::F_NoDotDot).value();
+    REQUIRE(listing->Count() == 1);
+    CHECK(listing->MTime(0) == 1700000000);
+    CHECK(listing->ATime(0) == -1000);
+}
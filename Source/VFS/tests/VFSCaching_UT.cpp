@@ -0,0 +1,217 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "TestEnv.h"
+#include <VFS/Caching.h>
+#include <VFS/Mem.h>
+#include <thread>
+
+#define PREFIX "nc::vfs::CachingHost "
+
+using namespace nc;
+using namespace nc::vfs;
+using ::testing::_;
+using ::testing::Return;
+
+namespace {
+
+struct MockHost : Host {
+    MockHost() : Host("/junction", nullptr, "mock") {}
+    using EST = std::expected<VFSStat, Error>;
+    using EV = std::expected<void, Error>;
+    MOCK_METHOD(EST, Stat, (std::string_view, unsigned long, const VFSCancelChecker &), (override));
+    MOCK_METHOD(EV, Unlink, (std::string_view, const VFSCancelChecker &), (override));
+    MOCK_METHOD(EV, Rename, (std::string_view, std::string_view, const VFSCancelChecker &), (override));
+    MOCK_METHOD(EV,
+                SetTimes,
+                (std::string_view,
+                 std::optional<time_t>,
+                 std::optional<time_t>,
+                 std::optional<time_t>,
+                 std::optional<time_t>,
+                 const VFSCancelChecker &),
+                (override));
+};
+
+} // namespace
+
+static VFSStat RegStat(uint64_t _size)
+{
+    VFSStat st;
+    st.size = _size;
+    st.mode = S_IFREG | 0644;
+    st.mode_bits.reg = true;
+    return st;
+}
+
+TEST_CASE(PREFIX "Mimics the wrapped host")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock);
+    CHECK(host->Tag() == mock->Tag());
+    CHECK(host->JunctionPath() == "/junction");
+    CHECK(host->Wrapped() == mock);
+    CHECK(host->FullHashForPath("/a") == mock->FullHashForPath("/a"));
+}
+
+TEST_CASE(PREFIX "Repeated stats are served from the cache")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock);
+    EXPECT_CALL(*mock, Stat(std::string_view("/a/b.txt"), 0, _)).Times(1).WillOnce(Return(RegStat(42)));
+    for( int i = 0; i < 5; ++i ) {
+        const std::expected<VFSStat, Error> st = host->Stat("/a/b.txt", 0);
+        REQUIRE(st);
+        CHECK(st->size == 42);
+    }
+    CHECK(host->Exists("/a/b.txt"));
+    CHECK(!host->IsDirectory("/a/b.txt", 0));
+
+    const CachingHost::Statistics stats = host->CacheStatistics();
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 6);
+}
+
+TEST_CASE(PREFIX "Follow and no-follow stats are cached separately")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock);
+    EXPECT_CALL(*mock, Stat(_, 0, _)).Times(1).WillOnce(Return(RegStat(1)));
+    EXPECT_CALL(*mock, Stat(_, VFSFlags::F_NoFollow, _)).Times(1).WillOnce(Return(RegStat(2)));
+    CHECK(host->Stat("/link", 0)->size == 1);
+    CHECK(host->Stat("/link", VFSFlags::F_NoFollow)->size == 2);
+    CHECK(host->Stat("/link", 0)->size == 1);
+    CHECK(host->Stat("/link/", VFSFlags::F_NoFollow)->size == 2);
+}
+
+TEST_CASE(PREFIX "Negative lookups are cached, other errors are not")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock);
+    EXPECT_CALL(*mock, Stat(std::string_view("/none"), _, _))
+        .Times(1)
+        .WillOnce(Return(std::unexpected(Error{Error::POSIX, ENOENT})));
+    EXPECT_CALL(*mock, Stat(std::string_view("/broken"), _, _))
+        .Times(2)
+        .WillRepeatedly(Return(std::unexpected(Error{Error::POSIX, EIO})));
+    const Error enoent = Error{Error::POSIX, ENOENT};
+    CHECK(!host->Exists("/none"));
+    CHECK(host->Stat("/none", 0).error() == enoent);
+    CHECK(!host->Exists("/broken"));
+    CHECK(!host->Exists("/broken"));
+    CHECK(host->CacheStatistics().negative_hits == 1);
+}
+
+TEST_CASE(PREFIX "Mutating operations invalidate the affected entries")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock);
+    EXPECT_CALL(*mock, Unlink(_, _)).WillRepeatedly(Return(std::expected<void, Error>{}));
+    EXPECT_CALL(*mock, Rename(_, _, _)).WillRepeatedly(Return(std::expected<void, Error>{}));
+    EXPECT_CALL(*mock, SetTimes(_, _, _, _, _, _)).WillRepeatedly(Return(std::expected<void, Error>{}));
+
+    SECTION("Unlink")
+    {
+        EXPECT_CALL(*mock, Stat(std::string_view("/d/f"), _, _)).Times(2).WillRepeatedly(Return(RegStat(1)));
+        EXPECT_CALL(*mock, Stat(std::string_view("/d"), _, _)).Times(2).WillRepeatedly(Return(RegStat(1)));
+        std::ignore = host->Stat("/d/f", 0);
+        std::ignore = host->Stat("/d", 0);
+        REQUIRE(host->Unlink("/d/f"));
+        std::ignore = host->Stat("/d/f", 0);
+        std::ignore = host->Stat("/d", 0); // the parent's times have changed
+    }
+    SECTION("SetTimes")
+    {
+        EXPECT_CALL(*mock, Stat(std::string_view("/d/f"), _, _)).Times(2).WillRepeatedly(Return(RegStat(1)));
+        std::ignore = host->Stat("/d/f", 0);
+        REQUIRE(host->SetTimes("/d/f", std::nullopt, 10, std::nullopt, std::nullopt));
+        std::ignore = host->Stat("/d/f", 0);
+        std::ignore = host->Stat("/d/f", 0);
+    }
+    SECTION("Rename of a directory drops its contents")
+    {
+        EXPECT_CALL(*mock, Stat(std::string_view("/a/x/y"), _, _)).Times(2).WillRepeatedly(Return(RegStat(1)));
+        EXPECT_CALL(*mock, Stat(std::string_view("/a/xy"), _, _)).Times(1).WillRepeatedly(Return(RegStat(1)));
+        std::ignore = host->Stat("/a/x/y", 0);
+        std::ignore = host->Stat("/a/xy", 0);
+        REQUIRE(host->Rename("/a/x", "/b/x"));
+        std::ignore = host->Stat("/a/x/y", 0);
+        std::ignore = host->Stat("/a/xy", 0); // merely shares the prefix
+    }
+    SECTION("ForceRefresh")
+    {
+        EXPECT_CALL(*mock, Stat(std::string_view("/f"), _, _)).Times(2).WillRepeatedly(Return(RegStat(1)));
+        std::ignore = host->Stat("/f", 0);
+        std::ignore = host->Stat("/f", VFSFlags::F_ForceRefresh);
+        std::ignore = host->Stat("/f", 0);
+    }
+}
+
+TEST_CASE(PREFIX "Entries expire")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock, std::chrono::milliseconds(20));
+    EXPECT_CALL(*mock, Stat(_, _, _)).Times(2).WillRepeatedly(Return(RegStat(1)));
+    std::ignore = host->Stat("/f", 0);
+    std::ignore = host->Stat("/f", 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::ignore = host->Stat("/f", 0);
+}
+
+TEST_CASE(PREFIX "The cache is bounded")
+{
+    auto mock = std::make_shared<MockHost>();
+    auto host = std::make_shared<CachingHost>(mock);
+    EXPECT_CALL(*mock, Stat(_, _, _)).WillRepeatedly(Return(RegStat(1)));
+    const size_t capacity = caching::StatCache::ShardsNumber * caching::StatCache::ShardCapacity;
+    for( size_t i = 0; i < capacity * 2; ++i )
+        std::ignore = host->Stat("/" + std::to_string(i), 0);
+    CHECK(host->CacheStatistics().misses == capacity * 2);
+    for( size_t i = 0; i < capacity * 2; ++i )
+        std::ignore = host->Stat("/" + std::to_string(i), 0);
+    CHECK(host->CacheStatistics().hits <= capacity);
+}
+
+TEST_CASE(PREFIX "Works on top of a real host")
+{
+    auto host = std::make_shared<CachingHost>(std::make_shared<MemHost>());
+    REQUIRE(host->CreateDirectory("/dir", 0755));
+    CHECK(host->IsDirectory("/dir", 0));
+    CHECK(!host->Exists("/dir/file"));
+    REQUIRE(std::static_pointer_cast<MemHost>(host->Wrapped())->WriteFile("/dir/file", "hello"));
+    CHECK(!host->Exists("/dir/file")); // not seen until invalidated
+    REQUIRE(host->FetchDirectoryListing("/dir", VFSFlags::F_ForceRefresh));
+    CHECK(host->Exists("/dir/file"));
+    REQUIRE(host->Rename("/dir/file", "/dir/other"));
+    CHECK(!host->Exists("/dir/file"));
+    CHECK(host->Stat("/dir/other", 0)->size == 5);
+}
+
+TEST_CASE(PREFIX "Listings and files refer to the caching host")
+{
+    auto host = std::make_shared<CachingHost>(std::make_shared<MemHost>());
+    REQUIRE(host->CreateDirectory("/dir", 0755));
+    REQUIRE(std::static_pointer_cast<MemHost>(host->Wrapped())->WriteFile("/dir/file", "hello"));
+
+    const std::expected<VFSListingPtr, Error> listing = host->FetchDirectoryListing("/dir", VFSFlags::F_NoDotDot);
+    REQUIRE(listing);
+    REQUIRE((*listing)->Count() == 1);
+    CHECK((*listing)->HasCommonHost());
+    CHECK((*listing)->Host() == host);
+    CHECK((*listing)->Directory() == "/dir/");
+    CHECK((*listing)->Filename(0) == "file");
+    CHECK((*listing)->Size(0) == 5);
+
+    const std::expected<VFSListingPtr, Error> item = host->FetchSingleItemListing("/dir/file", 0);
+    REQUIRE(item);
+    CHECK((*item)->Host() == host);
+
+    CHECK(host->Stat("/dir/file", 0)->size == 5);
+    const std::expected<std::shared_ptr<VFSFile>, Error> file = host->CreateFile("/dir/file");
+    REQUIRE(file);
+    CHECK((*file)->Host() == host);
+    REQUIRE((*file)->Open(VFSFlags::OF_Write | VFSFlags::OF_Truncate) == VFSError::Ok);
+    const std::string_view data = "hello, world";
+    REQUIRE((*file)->WriteFile(data.data(), data.size()));
+    REQUIRE((*file)->Close() == VFSError::Ok);
+    CHECK(host->Stat("/dir/file", 0)->size == data.size()); // the write has dropped the cached entry
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+// #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "Tests.h"
+#include <VFS/Mem.h>
+#include "DirectorySizeCalculator.h"
+#include <fmt/format.h>
+
+using nc::vfs::DirectorySizeCalculator;
+using nc::vfs::MemHost;
+
+#define PREFIX "VFSMem PT "
+
+// 1M files of 4KB in 1000 directories, all sharing the same contents
+static std::shared_ptr<MemHost> MakeHost()
+{
+    auto host = std::make_shared<MemHost>();
+    const auto blob = std::make_shared<const std::string>(4096, 'x');
+    for( int d = 0; d < 1000; ++d ) {
+        const std::string dir = fmt::format("/dir_{}", d);
+        REQUIRE(host->CreateDirectory(dir, 0755));
+        for( int f = 0; f < 1000; ++f )
+            REQUIRE(host->WriteFile(fmt::format("{}/file_{}.txt", dir, f), blob));
+    }
+    return host;
+}
+
+TEST_CASE(PREFIX "operations on a million of entries", "[!benchmark]")
+{
+    BENCHMARK("Populating")
+    {
+        return MakeHost();
+    };
+
+    const auto host = MakeHost();
+    BENCHMARK("Stat")
+    {
+        uint64_t size = 0;
+        for( int d = 0; d < 1000; d += 7 )
+            for( int f = 0; f < 1000; f += 3 )
+                size += host->Stat(fmt::format("/dir_{}/file_{}.txt", d, f), 0)->size;
+        return size;
+    };
+    BENCHMARK("Listing")
+    {
+        size_t count = 0;
+        for( int d = 0; d < 1000; d += 10 )
+            count += host->FetchDirectoryListing(fmt::format("/dir_{}", d), 0).value()->Count();
+        return count;
+    };
+    BENCHMARK("Calculating the size")
+    {
+        DirectorySizeCalculator calc;
+        return calc.Calculate(host, "/").value();
+    };
+    BENCHMARK("Reading")
+    {
+        char buf[4096];
+        size_t total = 0;
+        for( int f = 0; f < 1000; ++f ) {
+            auto file = host->CreateFile(fmt::format("/dir_0/file_{}.txt", f)).value();
+            file->Open(VFSFlags::OF_Read);
+            total += file->Read(buf, sizeof(buf));
+        }
+        return total;
+    };
+    BENCHMARK_ADVANCED("Copying and deleting a directory")(Catch::Benchmark::Chronometer meter)
+    {
+        meter.measure([&] {
+            REQUIRE(host->CreateDirectory("/copy", 0755));
+            for( int f = 0; f < 1000; ++f ) {
+                auto src = host->CreateFile(fmt::format("/dir_1/file_{}.txt", f)).value();
+                auto dst = host->CreateFile(fmt::format("/copy/file_{}.txt", f)).value();
+                src->Open(VFSFlags::OF_Read);
+                dst->Open(VFSFlags::OF_Write | VFSFlags::OF_Create | 0644);
+                const auto data = src->ReadFile().value();
+                std::ignore = dst->WriteFile(data.data(), data.size());
+            }
+            for( int f = 0; f < 1000; ++f )
+                std::ignore = host->Unlink(fmt::format("/copy/file_{}.txt", f));
+            return host->RemoveDirectory("/copy").has_value();
+        });
+    };
+}
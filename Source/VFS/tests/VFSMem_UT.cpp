@@ -1,29 +1,325 @@
-// Copyright (C) 2020 Michael Kazakov. Subject to GNU General Public License version 3.
+// Copyright (C) 2020-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "Tests.h"
 #include "TestEnv.h"
 #include <VFS/Mem.h>
 #include <Base/algo.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <thread>
 
 using namespace nc::vfs;
-// using nc::vfs::MemHost;
+using nc::Error;
 #define PREFIX "VFSMem "
 
-// static VFSNativeHost& host()
-//{
-//     return *TestEnv().vfs_native;
-// }
-//
-// static bool ListingHas(const Listing& listing, const std::string& _filename){
-//     return std::any_of(listing.begin(), listing.end(), [&](auto &item){
-//         return item.Filename() == _filename;
-//     });
-// };
-//
-// static bool ListingHas(const VFSListingPtr& listing, const std::string& _filename){
-//     return ListingHas(*listing, _filename);
-// };
+static bool ListingHas(const VFSListingPtr &_listing, const std::string &_filename)
+{
+    return std::any_of(_listing->begin(), _listing->end(), [&](auto &item) { return item.Filename() == _filename; });
+}
+
+static std::string Read(MemHost &_host, std::string_view _path)
+{
+    auto file = _host.CreateFile(_path).value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == VFSError::Ok);
+    const auto bytes = file->ReadFile().value();
+    return {bytes.begin(), bytes.end()};
+}
+
+static void Write(MemHost &_host, std::string_view _path, std::string_view _contents, unsigned long _flags = 0)
+{
+    auto file = _host.CreateFile(_path).value();
+    REQUIRE(file->Open(VFSFlags::OF_Write | VFSFlags::OF_Create | _flags | S_IRUSR | S_IWUSR) == VFSError::Ok);
+    REQUIRE(file->WriteFile(_contents.data(), _contents.size()));
+    REQUIRE(file->Close() == VFSError::Ok);
+}
+
+static std::unexpected<Error> Errno(int _errno)
+{
+    return std::unexpected(Error{Error::POSIX, _errno});
+}
 
 TEST_CASE(PREFIX "constructible")
 {
     REQUIRE_NOTHROW(std::make_shared<MemHost>());
 }
+
+TEST_CASE(PREFIX "creates and lists directories")
+{
+    auto host = std::make_shared<MemHost>();
+    REQUIRE(host->CreateDirectory("/a", 0755));
+    REQUIRE(host->CreateDirectory("/a/b/", 0700));
+    CHECK(host->CreateDirectory("/a", 0755) == Errno(EEXIST));
+    CHECK(host->CreateDirectory("/x/y", 0755) == Errno(ENOENT));
+    CHECK(host->CreateDirectory("/", 0755) == Errno(EEXIST));
+
+    const auto st = host->Stat("/a/b", 0).value();
+    CHECK(st.mode == (S_IFDIR | 0700));
+    CHECK(st.inode != 0);
+    CHECK(host->IsDirectory("/a/./b/../b", 0));
+
+    const auto root = host->FetchDirectoryListing("/", 0).value();
+    CHECK(root->Count() == 1);
+    CHECK(ListingHas(root, "a"));
+
+    const auto a = host->FetchDirectoryListing("/a", 0).value();
+    CHECK(a->Count() == 2);
+    CHECK(ListingHas(a, ".."));
+    CHECK(ListingHas(a, "b"));
+    CHECK(a->Directory(0) == "/a/");
+    CHECK(host->FetchDirectoryListing("/a", VFSFlags::F_NoDotDot).value()->Count() == 1);
+    CHECK(host->FetchDirectoryListing("/nonexistent", 0) == Errno(ENOENT));
+
+    std::vector<std::string> names;
+    REQUIRE(host->IterateDirectoryListing("/a", [&](const VFSDirEnt &_dirent) {
+        names.emplace_back(_dirent.name);
+        CHECK(_dirent.type == VFSDirEnt::Dir);
+        return true;
+    }));
+    CHECK(names == std::vector<std::string>{"b"});
+}
+
+TEST_CASE(PREFIX "writes, reads and seeks files")
+{
+    auto host = std::make_shared<MemHost>();
+    Write(*host, "/f.txt", "Hello, World!");
+    CHECK(host->Stat("/f.txt", 0)->size == 13);
+    CHECK((host->Stat("/f.txt", 0)->mode & ~S_IFMT) == (S_IRUSR | S_IWUSR));
+    CHECK(Read(*host, "/f.txt") == "Hello, World!");
+
+    auto file = host->CreateFile("/f.txt").value();
+    REQUIRE(file->Open(VFSFlags::OF_Read) == VFSError::Ok);
+    CHECK(file->GetReadParadigm() == VFSFile::ReadParadigm::Random);
+    CHECK(file->Size() == 13);
+    CHECK(file->Seek(7, VFSFile::Seek_Set) == 7);
+    char buf[16] = {};
+    CHECK(file->Read(buf, 5) == 5);
+    CHECK(std::string_view(buf, 5) == "World");
+    CHECK(file->Seek(-1, VFSFile::Seek_End) == 12);
+    CHECK(file->Read(buf, 16) == 1);
+    CHECK(file->Eof());
+    CHECK(file->ReadAt(0, buf, 5) == 5);
+    CHECK(std::string_view(buf, 5) == "Hello");
+    CHECK(file->Write("x", 1) < 0);
+    file->Close();
+
+    Write(*host, "/f.txt", "!!", VFSFlags::OF_Append);
+    CHECK(Read(*host, "/f.txt") == "Hello, World!!!");
+
+    Write(*host, "/f.txt", "Bye", VFSFlags::OF_Truncate);
+    CHECK(Read(*host, "/f.txt") == "Bye");
+
+    REQUIRE(file->Open(VFSFlags::OF_Write) == VFSError::Ok);
+    CHECK(file->Seek(5, VFSFile::Seek_Set) == 5);
+    CHECK(file->Write("!", 1) == 1);
+    file->Close();
+    CHECK(Read(*host, "/f.txt") == std::string("Bye\0\0!", 6));
+
+    CHECK(file->Open(VFSFlags::OF_Write | VFSFlags::OF_Create | VFSFlags::OF_NoExist) == VFSError::FromErrno(EEXIST));
+    CHECK(host->CreateFile("/none").value()->Open(VFSFlags::OF_Read) == VFSError::FromErrno(ENOENT));
+    CHECK(host->CreateFile("/").value()->Open(VFSFlags::OF_Read) == VFSError::FromErrno(EISDIR));
+}
+
+TEST_CASE(PREFIX "readers keep the contents they opened")
+{
+    auto host = std::make_shared<MemHost>();
+    Write(*host, "/f", "old");
+
+    auto reader = host->CreateFile("/f").value();
+    REQUIRE(reader->Open(VFSFlags::OF_Read) == VFSError::Ok);
+
+    auto writer = host->CreateFile("/f").value();
+    REQUIRE(writer->Open(VFSFlags::OF_Write | VFSFlags::OF_Truncate) == VFSError::Ok);
+    REQUIRE(writer->WriteFile("new contents", 12));
+    CHECK(Read(*host, "/f") == ""); // not published until closed
+    writer->Close();
+
+    CHECK(Read(*host, "/f") == "new contents");
+    char buf[16];
+    CHECK(reader->Read(buf, sizeof(buf)) == 3);
+    CHECK(std::string_view(buf, 3) == "old");
+}
+
+TEST_CASE(PREFIX "shares the blobs between files")
+{
+    auto host = std::make_shared<MemHost>();
+    const auto blob = std::make_shared<const std::string>(1024 * 1024, 'x');
+    REQUIRE(host->CreateDirectory("/d", 0755));
+    for( int i = 0; i < 1000; ++i )
+        REQUIRE(host->WriteFile("/d/" + std::to_string(i), blob));
+    CHECK(blob.use_count() == 1001);
+    CHECK(host->Stat("/d/999", 0)->size == 1024 * 1024);
+
+    REQUIRE(host->WriteFile("/d/0", "replaced"));
+    CHECK(blob.use_count() == 1000);
+    CHECK(Read(*host, "/d/0") == "replaced");
+    CHECK(host->WriteFile("/d", "x") == Errno(EISDIR));
+}
+
+TEST_CASE(PREFIX "renames files and directories")
+{
+    auto host = std::make_shared<MemHost>();
+    REQUIRE(host->CreateDirectory("/a", 0755));
+    REQUIRE(host->CreateDirectory("/a/b", 0755));
+    REQUIRE(host->CreateDirectory("/c", 0755));
+    REQUIRE(host->WriteFile("/a/b/f", "data"));
+    const auto inode = host->Stat("/a/b/f", 0)->inode;
+
+    REQUIRE(host->Rename("/a/b/f", "/c/g"));
+    CHECK(!host->Exists("/a/b/f"));
+    CHECK(host->Stat("/c/g", 0)->inode == inode);
+
+    REQUIRE(host->Rename("/a/b", "/c/b"));
+    CHECK(host->IsDirectory("/c/b", 0));
+    CHECK(!host->Exists("/a/b"));
+
+    CHECK(host->Rename("/c", "/c/b/c") == Errno(EINVAL));
+    CHECK(host->Rename("/a/none", "/a/x") == Errno(ENOENT));
+    CHECK(host->Rename("/c/g", "/a") == Errno(EISDIR));
+    CHECK(host->Rename("/a", "/c/g") == Errno(ENOTDIR));
+    CHECK(host->Rename("/a", "/c") == Errno(ENOTEMPTY));
+    CHECK(host->Rename("/c/g", "/c/g"));
+
+    REQUIRE(host->WriteFile("/a/h", "other"));
+    REQUIRE(host->Rename("/a/h", "/c/g"));
+    CHECK(Read(*host, "/c/g") == "other");
+
+    REQUIRE(host->CreateDirectory("/e", 0755));
+    REQUIRE(host->Rename("/e", "/c/b"));
+    CHECK(!host->Exists("/e"));
+}
+
+TEST_CASE(PREFIX "deletes files and directories")
+{
+    auto host = std::make_shared<MemHost>();
+    REQUIRE(host->CreateDirectory("/d", 0755));
+    REQUIRE(host->WriteFile("/d/f", "data"));
+
+    CHECK(host->Unlink("/d") == Errno(EPERM));
+    CHECK(host->RemoveDirectory("/d") == Errno(ENOTEMPTY));
+    CHECK(host->RemoveDirectory("/d/f") == Errno(ENOTDIR));
+    CHECK(host->Unlink("/d/none") == Errno(ENOENT));
+    CHECK(host->RemoveDirectory("/") == Errno(EBUSY));
+
+    REQUIRE(host->Unlink("/d/f"));
+    REQUIRE(host->RemoveDirectory("/d"));
+    CHECK(host->FetchDirectoryListing("/", 0).value()->Count() == 0);
+}
+
+TEST_CASE(PREFIX "supports symlinks")
+{
+    auto host = std::make_shared<MemHost>();
+    REQUIRE(host->CreateDirectory("/d", 0755));
+    REQUIRE(host->WriteFile("/d/f", "data"));
+    REQUIRE(host->CreateSymlink("/l1", "d/f"));
+    REQUIRE(host->CreateSymlink("/d/l2", "/d"));
+    REQUIRE(host->CreateSymlink("/loop", "/loop"));
+    REQUIRE(host->CreateSymlink("/dangling", "/none"));
+
+    CHECK(host->ReadSymlink("/l1") == "d/f");
+    CHECK(host->ReadSymlink("/d/f") == Errno(EINVAL));
+    CHECK(host->IsSymlink("/l1", VFSFlags::F_NoFollow));
+    CHECK(host->Stat("/l1", VFSFlags::F_NoFollow)->size == 3);
+    CHECK(host->Stat("/l1", 0)->size == 4);
+    CHECK(Read(*host, "/d/l2/l2/f") == "data");
+    CHECK(host->Stat("/loop", 0) == Errno(ELOOP));
+    CHECK(host->Stat("/dangling", 0) == Errno(ENOENT));
+
+    const auto listing = host->FetchDirectoryListing("/", 0).value();
+    const auto it =
+        std::find_if(listing->begin(), listing->end(), [](auto &_item) { return _item.Filename() == "l1"; });
+    REQUIRE(it != listing->end());
+    CHECK((*it).IsSymlink());
+    CHECK((*it).Symlink() == "d/f");
+    CHECK((*it).IsReg());
+
+    REQUIRE(host->Unlink("/d/l2"));
+    CHECK(host->IsDirectory("/d", 0));
+}
+
+TEST_CASE(PREFIX "changes times, permissions, flags and ownership")
+{
+    auto host = std::make_shared<MemHost>();
+    REQUIRE(host->WriteFile("/f", "data"));
+    REQUIRE(host->CreateSymlink("/l", "/f"));
+    CHECK(host->Features() & HostFeatures::SetTimes);
+
+    REQUIRE(host->SetTimes("/l", 1000, 2000, 3000, 4000));
+    const auto st = host->Stat("/f", 0).value();
+    CHECK(st.btime.tv_sec == 1000);
+    CHECK(st.mtime.tv_sec == 2000);
+    CHECK(st.ctime.tv_sec == 3000);
+    CHECK(st.atime.tv_sec == 4000);
+
+    REQUIRE(host->SetPermissions("/f", 0600));
+    CHECK(host->Stat("/f", 0)->mode == (S_IFREG | 0600));
+
+    REQUIRE(host->SetFlags("/l", UF_HIDDEN, VFSFlags::F_NoFollow));
+    CHECK(host->Stat("/l", VFSFlags::F_NoFollow)->flags == UF_HIDDEN);
+    CHECK(host->Stat("/f", 0)->flags == 0);
+
+    REQUIRE(host->SetOwnership("/f", 501, 20));
+    CHECK(host->Stat("/f", 0)->uid == 501);
+    CHECK(host->Stat("/f", 0)->gid == 20);
+    CHECK(host->SetPermissions("/none", 0600) == Errno(ENOENT));
+}
+
+TEST_CASE(PREFIX "notifies about changes in observed directories")
+{
+    auto host = std::make_shared<MemHost>();
+    REQUIRE(host->CreateDirectory("/d", 0755));
+    CHECK(host->IsDirectoryChangeObservationAvailable("/d"));
+    CHECK(!host->IsDirectoryChangeObservationAvailable("/none"));
+
+    int changes = 0;
+    auto ticket = host->ObserveDirectoryChanges("/d", [&] { ++changes; });
+    REQUIRE(ticket);
+
+    REQUIRE(host->WriteFile("/d/f", "data"));
+    CHECK(changes == 1);
+    Write(*host, "/d/f", "more", VFSFlags::OF_Append);
+    CHECK(changes == 2);
+    REQUIRE(host->SetPermissions("/d/f", 0600));
+    CHECK(changes == 3);
+    REQUIRE(host->CreateDirectory("/other", 0755));
+    CHECK(changes == 3);
+
+    // the observation follows the directory
+    REQUIRE(host->Rename("/d", "/other/d"));
+    REQUIRE(host->Unlink("/other/d/f"));
+    CHECK(changes == 4);
+
+    ticket.reset();
+    REQUIRE(host->CreateDirectory("/other/d/x", 0755));
+    CHECK(changes == 4);
+}
+
+TEST_CASE(PREFIX "can be changed from several threads at once")
+{
+    auto host = std::make_shared<MemHost>();
+    constexpr int threads_count = 8;
+    constexpr int files_per_thread = 1000;
+    REQUIRE(host->CreateDirectory("/shared", 0755));
+
+    std::atomic_int failures = 0;
+    std::vector<std::thread> threads;
+    for( int t = 0; t < threads_count; ++t )
+        threads.emplace_back([&, t] {
+            const std::string own = "/" + std::to_string(t);
+            if( !host->CreateDirectory(own, 0755) )
+                ++failures;
+            for( int i = 0; i < files_per_thread; ++i ) {
+                const std::string name = std::to_string(t) + "_" + std::to_string(i);
+                if( !host->WriteFile(own + "/" + name, name) || !host->WriteFile("/shared/" + name, name) )
+                    ++failures;
+                if( i % 2 == 0 && !host->Rename(own + "/" + name, "/shared/" + name + "_moved") )
+                    ++failures;
+            }
+        });
+    for( auto &thread : threads )
+        thread.join();
+
+    CHECK(failures == 0);
+    CHECK(host->FetchDirectoryListing("/shared", VFSFlags::F_NoDotDot).value()->Count() ==
+          threads_count * files_per_thread * 3 / 2);
+    CHECK(host->FetchDirectoryListing("/0", VFSFlags::F_NoDotDot).value()->Count() == files_per_thread / 2);
+    CHECK(Read(*host, "/shared/7_998_moved") == "7_998");
+}
@@ -1,5 +1,6 @@
 // Copyright (C) 2020-2025 Michael Kazakov. Subject to GNU General Public License version 3.
 #include "../../source/Native/Fetching.h" // EVIL!
+#include <VFS/VFSListingInput.h>
 #include "TestEnv.h"
 #include "Tests.h"
 #include <Base/UnorderedUtil.h>
@@ -242,7 +243,38 @@ TEST_CASE(PREFIX "Fetching")
     }
     SECTION("ReadDirAttributesBulk")
     {
-        CHECK(Fetching::ReadDirAttributesBulk(fd, fetch, param) == 0);
+        using nc::base::variable_container;
+        ListingInput listing;
+        for( auto *column : {&listing.inodes, &listing.sizes} )
+            column->reset(variable_container<>::type::dense);
+        for( auto *column : {&listing.atimes, &listing.mtimes, &listing.ctimes, &listing.btimes} )
+            column->reset(variable_container<>::type::dense);
+        for( auto *column : {&listing.unix_flags, &listing.uids, &listing.gids} )
+            column->reset(variable_container<>::type::dense);
+        Fetching::BulkExtras extras;
+        CHECK(Fetching::ReadDirAttributesBulk(fd, listing, extras) == 0);
+        REQUIRE(extras.devs.size() == listing.filenames.size());
+        REQUIRE(extras.ext_flags.size() == listing.filenames.size());
+        fetch(listing.filenames.size());
+        for( size_t i = 0; i < listing.filenames.size(); ++i ) {
+            Fetching::CallbackParams p;
+            p.filename = listing.filenames[i].c_str();
+            p.crt_time = listing.btimes[i];
+            p.mod_time = listing.mtimes[i];
+            p.chg_time = listing.ctimes[i];
+            p.acc_time = listing.atimes[i];
+            p.add_time = listing.add_times.has(i) ? listing.add_times[i] : -1;
+            p.uid = listing.uids[i];
+            p.gid = listing.gids[i];
+            p.mode = listing.unix_modes[i];
+            p.dev = extras.devs[i];
+            p.inode = listing.inodes[i];
+            p.flags = listing.unix_flags[i];
+            p.ext_flags = extras.ext_flags[i];
+            p.size = static_cast<int64_t>(listing.sizes[i]);
+            CHECK(listing.unix_types[i] == IFTODT(p.mode));
+            param(p);
+        }
     }
 
     CHECK(fetched_notification == total_items_number);
@@ -494,6 +494,35 @@ TEST_CASE(PREFIX "basic read")
     REQUIRE(memcmp(contents->data(), expected.data(), expected.length()) == 0);
 }
 
+TEST_CASE(PREFIX "large files are written and read back intact")
+{
+    const VFSHostPtr host = hostForUbuntu2004_User1_Pwd();
+    const auto path = "/home/user1/large_file";
+    std::string data(10'000'000, '\0');
+    for( size_t i = 0; i < data.size(); ++i )
+        data[i] = static_cast<char>(i * 7 % 251);
+
+    const VFSFilePtr file = host->CreateFile(path).value();
+    REQUIRE(file->Open(VFSFlags::OF_Write | VFSFlags::OF_Create | VFSFlags::OF_Truncate | S_IRUSR | S_IWUSR) == 0);
+    for( size_t pos = 0; pos < data.size(); pos += 100'000 ) // small writes are coalesced to keep the window full
+        REQUIRE(file->Write(data.data() + pos, std::min<size_t>(100'000, data.size() - pos)) > 0);
+    REQUIRE(file->Close() == 0);
+
+    REQUIRE(file->Open(VFSFlags::OF_Read) == 0);
+    CHECK(file->Size() == static_cast<ssize_t>(data.size()));
+    const auto contents = file->ReadFile();
+    REQUIRE(contents);
+    CHECK(std::string_view(reinterpret_cast<const char *>(contents->data()), contents->size()) == data);
+
+    char buf[1000];
+    REQUIRE(file->Seek(5'000'000, VFSFile::Seek_Set) == 5'000'000);
+    REQUIRE(file->Read(buf, sizeof(buf)) > 0);
+    CHECK(std::string_view(buf, 10) == std::string_view(data).substr(5'000'000, 10));
+    file->Close();
+
+    CHECK(host->Unlink(path));
+}
+
 TEST_CASE(PREFIX "read link")
 {
     const VFSHostPtr host = hostForUbuntu2004_User1_Pwd();
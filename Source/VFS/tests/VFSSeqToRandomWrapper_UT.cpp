@@ -0,0 +1,228 @@
+// Copyright (C) 2025 Michael Kazakov. Subject to GNU General Public License version 3.
+#include "Tests.h"
+#include "VFSSeqToRandomWrapper.h"
+#include "VFSGenericMemReadOnlyFile.h"
+#include <VFS/VFSError.h>
+#include <atomic>
+#include <future>
+#include <semaphore>
+
+using nc::vfs::GenericMemReadOnlyFile;
+
+#define PREFIX "VFSSeqToRandomROWrapperFile "
+
+namespace {
+
+// Can be read only sequentially, every read has to be allowed explicitly when gated.
+class SequentialFile : public GenericMemReadOnlyFile
+{
+public:
+    SequentialFile(std::string_view _data, bool _gated)
+        : GenericMemReadOnlyFile("", nullptr, _data), m_Gated(_gated)
+    {
+    }
+
+    ReadParadigm GetReadParadigm() const override { return ReadParadigm::Sequential; }
+
+    ssize_t Read(void *_buf, size_t _size) override
+    {
+        if( m_Gated )
+            m_Gate.acquire();
+        return GenericMemReadOnlyFile::Read(_buf, std::min<size_t>(_size, 1000));
+    }
+
+    void Allow(ptrdiff_t _reads) { m_Gate.release(_reads); }
+
+private:
+    bool m_Gated;
+    std::counting_semaphore<> m_Gate{0};
+};
+
+} // namespace
+
+static std::string MakeData(size_t _size)
+{
+    std::string data(_size, '\0');
+    for( size_t i = 0; i < _size; ++i )
+        data[i] = static_cast<char>(i * 7 % 251);
+    return data;
+}
+
+TEST_CASE(PREFIX "Fetches everything upon a regular open")
+{
+    const std::string data = MakeData(100'000);
+    auto seq = std::make_shared<SequentialFile>(data, false);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    uint64_t last_progress = 0;
+    REQUIRE(file->Open(VFSFlags::OF_Read, {}, [&](uint64_t _done, uint64_t) { last_progress = _done; }) ==
+            VFSError::Ok);
+    CHECK(last_progress == data.size());
+    CHECK(file->Fetched() == data.size());
+    CHECK(file->Size() == static_cast<ssize_t>(data.size()));
+
+    std::string buf(100, '\0');
+    REQUIRE(file->ReadAt(50'000, buf.data(), buf.size()) == buf.size());
+    CHECK(buf == data.substr(50'000, 100));
+
+    REQUIRE(file->Seek(99'950, VFSFile::Seek_Set) == 99'950);
+    CHECK(file->Read(buf.data(), buf.size()) == 50);
+    CHECK(file->Eof());
+}
+
+TEST_CASE(PREFIX "Streaming serves the fetched ranges before the download completes")
+{
+    const std::string data = MakeData(100'000);
+    auto seq = std::make_shared<SequentialFile>(data, true);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(VFSFlags::OF_Read) == VFSError::Ok);
+    CHECK(file->Size() == static_cast<ssize_t>(data.size()));
+
+    seq->Allow(3);
+    std::string buf(500, '\0');
+    REQUIRE(file->ReadAt(2'000, buf.data(), buf.size()) == buf.size());
+    CHECK(buf == data.substr(2'000, 500));
+    CHECK(file->Fetched() < data.size());
+
+    // a read beyond the frontier waits until the data arrives
+    auto pending = std::async(std::launch::async, [&] {
+        std::string tail(500, '\0');
+        REQUIRE(file->ReadAt(99'000, tail.data(), tail.size()) == tail.size());
+        return tail;
+    });
+    CHECK(pending.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout);
+    seq->Allow(100);
+    CHECK(pending.get() == data.substr(99'000, 500));
+    CHECK(file->Fetched() == data.size());
+}
+
+TEST_CASE(PREFIX "Shared instances see the same growing backing")
+{
+    const std::string data = MakeData(10'000);
+    auto seq = std::make_shared<SequentialFile>(data, true);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(VFSFlags::OF_Read) == VFSError::Ok);
+    auto shared = file->Share();
+    REQUIRE(shared);
+    file.reset(); // the fetching goes on while any instance is alive
+
+    seq->Allow(10);
+    const std::expected<std::vector<uint8_t>, nc::Error> contents = shared->ReadFile();
+    REQUIRE(contents);
+    CHECK(std::string(contents->begin(), contents->end()) == data);
+}
+
+TEST_CASE(PREFIX "Waiting for the data can be cancelled")
+{
+    std::atomic_bool cancelled = false;
+    std::atomic_int progress_calls = 0;
+    const std::string data = MakeData(10'000);
+    auto seq = std::make_shared<SequentialFile>(data, true);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(
+                VFSFlags::OF_Read, [&] { return cancelled.load(); }, [&](uint64_t, uint64_t) { ++progress_calls; }) ==
+            VFSError::Ok);
+
+    auto pending = std::async(std::launch::async, [&] {
+        char buf[10];
+        return file->ReadAt(9'990, buf, sizeof(buf));
+    });
+    seq->Allow(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    cancelled = true;
+    const std::expected<size_t, nc::Error> result = pending.get();
+    seq->Allow(100); // lets the filler finish, the cancellation doesn't stop it
+    REQUIRE(!result);
+    CHECK(result.error() == VFSError::ToError(VFSError::Cancelled));
+    CHECK(progress_calls > 0);
+}
+
+TEST_CASE(PREFIX "Cancelling the wait of one instance doesn't stop the others")
+{
+    std::atomic_bool cancelled = false;
+    const std::string data = MakeData(10'000);
+    auto seq = std::make_shared<SequentialFile>(data, true);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(VFSFlags::OF_Read) == VFSError::Ok);
+    auto shared = file->Share([&] { return cancelled.load(); });
+    REQUIRE(shared);
+    cancelled = true;
+    char buf[10];
+    const std::expected<size_t, nc::Error> result = shared->ReadAt(9'990, buf, sizeof(buf));
+    REQUIRE(!result);
+    CHECK(result.error() == VFSError::ToError(VFSError::Cancelled));
+
+    seq->Allow(10);
+    const std::expected<std::vector<uint8_t>, nc::Error> contents = file->ReadFile();
+    REQUIRE(contents);
+    CHECK(std::string(contents->begin(), contents->end()) == data);
+}
+
+TEST_CASE(PREFIX "Non-blocking instances don't wait for the data")
+{
+    const std::string data = MakeData(10'000);
+    auto seq = std::make_shared<SequentialFile>(data, true);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(VFSFlags::OF_Read) == VFSError::Ok);
+    auto shared = file->Share();
+    REQUIRE(shared);
+    file->SetNonBlocking(true);
+    char buf[100];
+    const std::expected<size_t, nc::Error> result = file->ReadAt(9'900, buf, sizeof(buf));
+    REQUIRE(!result);
+    CHECK(result.error() == VFSError::ToError(VFSError::FromErrno(EAGAIN)));
+
+    seq->Allow(10);
+    REQUIRE(shared->ReadAt(9'900, buf, sizeof(buf)) == sizeof(buf)); // the blocking one waits for the data
+    REQUIRE(file->ReadAt(9'900, buf, sizeof(buf)) == sizeof(buf));   // and then it's there for everyone
+    CHECK(std::string_view(buf, sizeof(buf)) == std::string_view(data).substr(9'900));
+}
+
+TEST_CASE(PREFIX "The callbacks are not used after being reset")
+{
+    std::atomic_bool cancelled = false;
+    std::atomic_int progress_calls = 0;
+    const std::string data = MakeData(10'000);
+    auto seq = std::make_shared<SequentialFile>(data, true);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(
+                VFSFlags::OF_Read, [&] { return cancelled.load(); }, [&](uint64_t, uint64_t) { ++progress_calls; }) ==
+            VFSError::Ok);
+    file->ResetCallbacks();
+    cancelled = true;
+    seq->Allow(100);
+    const std::expected<std::vector<uint8_t>, nc::Error> contents = file->ReadFile();
+    REQUIRE(contents);
+    CHECK(std::string(contents->begin(), contents->end()) == data);
+    CHECK(progress_calls == 0);
+}
+
+TEST_CASE(PREFIX "Streaming reports a truncated source to the waiting readers")
+{
+    struct TruncatedFile : SequentialFile {
+        using SequentialFile::SequentialFile;
+        ssize_t Size() const override { return SequentialFile::Size() + 1'000; }
+    };
+    const std::string data = MakeData(5'000);
+    auto seq = std::make_shared<TruncatedFile>(data, false);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(VFSFlags::OF_Read) == VFSError::Ok);
+    char buf[100];
+    CHECK(file->ReadAt(4'900, buf, sizeof(buf)) == sizeof(buf));
+    const std::expected<size_t, nc::Error> result = file->ReadAt(5'500, buf, sizeof(buf));
+    REQUIRE(!result);
+    CHECK(result.error() == VFSError::ToError(VFSError::UnexpectedEOF));
+}
+
+TEST_CASE(PREFIX "Streaming through a temporary file")
+{
+    const std::string data = MakeData(VFSSeqToRandomROWrapperFile::MaxCachedInMem + 100'000);
+    auto seq = std::make_shared<SequentialFile>(data, false);
+    auto file = std::make_shared<VFSSeqToRandomROWrapperFile>(seq);
+    REQUIRE(file->OpenStreaming(VFSFlags::OF_Read) == VFSError::Ok);
+    auto shared = file->Share();
+    std::string buf(1'000, '\0');
+    REQUIRE(shared->ReadAt(data.size() - 500, buf.data(), buf.size()) == 500);
+    CHECK(buf.substr(0, 500) == data.substr(data.size() - 500));
+    REQUIRE(file->ReadAt(12'345, buf.data(), buf.size()) == buf.size());
+    CHECK(buf == data.substr(12'345, 1'000));
+}
@@ -13,6 +13,7 @@
 #include <Utility/ActionsShortcutsManager.h>
 #include "History.h"
 #include <Base/SerialQueue.h>
+#include <Base/algo.h>
 #include "Internal.h"
 
 using namespace std::literals;
@@ -60,8 +61,11 @@ static int InvertBitFlag(int _value, int _flag)
 namespace nc::viewer {
 
 struct BackgroundFileOpener {
-    std::expected<void, Error>
-    Open(VFSHostPtr _vfs, const std::string &_path, const nc::config::Config &_config, int _window_size);
+    std::expected<void, Error> Open(VFSHostPtr _vfs,
+                                    const std::string &_path,
+                                    const nc::config::Config &_config,
+                                    int _window_size,
+                                    const VFSCancelChecker &_search_cancel_checker);
 
     VFSFilePtr original_file;
     VFSSeqToRandomROWrapperFilePtr seq_wrapper;
@@ -182,7 +186,10 @@ struct BackgroundFileOpener {
     dispatch_assert_background_queue();
 
     BackgroundFileOpener opener;
-    const std::expected<void, Error> open_err = opener.Open(m_VFS, m_Path, *m_Config, self.fileWindowSize);
+    const std::expected<void, Error> open_err =
+        opener.Open(m_VFS, m_Path, *m_Config, self.fileWindowSize, [queue = &m_SearchInFileQueue] {
+            return queue->IsStopped();
+        });
     if( !open_err )
         return false;
     m_OriginalFile = std::move(opener.original_file);
@@ -573,7 +580,11 @@ struct BackgroundFileOpener {
 
         auto opener = std::make_unique<BackgroundFileOpener>();
         const std::expected<void, Error> open_rc =
-            opener->Open(strong_self->m_VFS, strong_self->m_Path, *strong_self->m_Config, strong_self.fileWindowSize);
+            opener->Open(strong_self->m_VFS,
+                         strong_self->m_Path,
+                         *strong_self->m_Config,
+                         strong_self.fileWindowSize,
+                         [queue = &strong_self->m_SearchInFileQueue] { return queue->IsStopped(); });
         if( !open_rc ) {
             Log::Warn("failed to open a path {}, vfs_error: {}", strong_self->m_Path, open_rc.error());
             return;
@@ -683,7 +694,8 @@ namespace nc::viewer {
 std::expected<void, Error> BackgroundFileOpener::Open(VFSHostPtr _vfs,
                                                       const std::string &_path,
                                                       const nc::config::Config &_config,
-                                                      int _window_size)
+                                                      int _window_size,
+                                                      const VFSCancelChecker &_search_cancel_checker)
 {
     dispatch_assert_background_queue();
     assert(_vfs);
@@ -692,18 +704,29 @@ std::expected<void, Error> BackgroundFileOpener::Open(VFSHostPtr _vfs,
     else
         return std::unexpected(exp.error());
 
+    // the process sheet stays until the first window is fetched, the rest of the file is fetched in background.
+    // afterwards the viewer reads on the main thread, so it never waits for the data - its window just doesn't move
+    // beyond the fetched range.
+    ProcessSheetController *proc = nil;
+    const auto close_sheet = at_scope_end([&] {
+        if( seq_wrapper ) {
+            seq_wrapper->ResetCallbacks();
+            seq_wrapper->SetNonBlocking(true);
+        }
+        [proc Close];
+    });
+
     if( original_file->GetReadParadigm() < VFSFile::ReadParadigm::Random ) {
         // we need to read a file into temporary mem/file storage to access it randomly
-        ProcessSheetController *const proc = [ProcessSheetController new];
+        proc = [ProcessSheetController new];
         proc.title = NSLocalizedString(@"Opening file...", "Title for process sheet when opening a vfs file");
         [proc Show];
 
         auto wrapper = std::make_shared<VFSSeqToRandomROWrapperFile>(original_file);
-        const int open_err = wrapper->Open(
+        const int open_err = wrapper->OpenStreaming(
             VFSFlags::OF_Read | VFSFlags::OF_ShLock,
             [=] { return proc.userCancelled; },
             [=](uint64_t _bytes, uint64_t _total) { proc.progress = double(_bytes) / double(_total); });
-        [proc Close];
         if( open_err != VFSError::Ok )
             return std::unexpected(VFSError::ToError(open_err));
 
@@ -719,8 +742,10 @@ std::expected<void, Error> BackgroundFileOpener::Open(VFSHostPtr _vfs,
     if( const std::expected<void, Error> res = viewer_file_window->Attach(work_file, _window_size); !res )
         return std::unexpected(res.error());
 
+    // the search runs in background and waits for the data on its own instance, until the search gets stopped
+    const VFSFilePtr search_file = seq_wrapper ? seq_wrapper->Share(_search_cancel_checker) : work_file;
     search_file_window = std::make_shared<nc::vfs::FileWindow>();
-    if( const std::expected<void, Error> res = search_file_window->Attach(work_file); !res )
+    if( const std::expected<void, Error> res = search_file_window->Attach(search_file); !res )
         return std::unexpected(res.error());
 
     using nc::vfs::SearchInFile;